@@ -4,6 +4,7 @@
 
 #include <QtCore/QPointF>
 #include <QtCore/QRectF>
+#include <QtGui/QPainterPath>
 
 #include <iostream>
 
@@ -33,6 +34,15 @@ public:
   std::pair<QPointF, QPointF>
   pointsC1C2() const;
 
+  /// The curve from source() to sink(), a straight line when they are
+  /// aligned along the layout. Built again only when an end point moves.
+  QPainterPath const&
+  path() const;
+
+  /// The area where the connection can be hovered or clicked
+  QPainterPath const&
+  strokePath() const;
+
   QPointF
   source() const { return _out; }
   QPointF
@@ -60,5 +70,13 @@ private:
   bool _hovered;
 
   PortLayout _ports_layout;
+
+  mutable QPainterPath _path;
+  mutable QPainterPath _strokePath;
+  mutable bool _pathValid;
+  mutable bool _strokePathValid;
+
+  void
+  invalidatePaths() { _pathValid = false; _strokePathValid = false; }
 };
 }
@@ -4,10 +4,13 @@
 #include <QtWidgets/QGraphicsScene>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <tuple>
 #include <functional>
+#include <vector>
 
 #include "QUuidStdHash.hpp"
+#include "SlotMap.hpp"
 #include "Export.hpp"
 #include "DataModelRegistry.hpp"
 #include "TypeConverter.hpp"
@@ -70,18 +73,72 @@ public:
 
   void iterateOverNodeData(std::function<void(NodeDataModel*)> const & visitor);
 
+  /// In the order of dependentOrder()
   void iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const & visitor);
 
+  /// The nodes ordered so that each one comes after the nodes connected to
+  /// its input ports. It is computed in O(nodes + connections) and kept
+  /// until a node or a connection is created or deleted: moving the nodes
+  /// does not change it. The nodes of a cycle, and those depending on them,
+  /// can not be ordered: they come last.
+  std::vector<Node*> const& dependentOrder() const;
+
   QPointF getNodePosition(const Node& node) const;
 
   void setNodePosition(Node& node, const QPointF& pos) const;
 
   QSizeF getNodeSize(const Node& node) const;
+
+  /// The topmost node containing scenePoint. It uses an index of the nodes
+  /// only, so its cost does not depend on the connections and the widgets
+  /// of the scene, nor on the total number of nodes.
+  Node* nodeAt(QPointF const& scenePoint);
+
+  /// The node moved or changed size: it is indexed again by the next nodeAt()
+  void invalidateNodeIndex(Node& node);
+
+  /// The nodes whose bounding rect intersects rect, in no particular order
+  std::vector<Node*> nodesIn(QRectF const& rect);
+
+  /// Number of the nodes with at least one port without connections. It is
+  /// kept as the connections change: only the nodes whose connections
+  /// changed since the previous call are checked again.
+  std::size_t danglingNodesCount();
+
+  /// The ports of the node changed (their number, or their connections
+  /// outside of the scene): it is checked again by danglingNodesCount()
+  /// and orderedChildren()
+  void invalidateNodePorts(Node const& node);
+
+  /// The nodes connected to the output ports of node, ordered by their
+  /// center along the layout (left to right, or top to bottom). The list
+  /// is kept: it is sorted again only after its connections changed or one
+  /// of the nodes moved.
+  std::vector<Node*> const& orderedChildren(Node const& node) const;
+
+  /// Changes whenever a node or a connection is created or deleted, a node
+  /// moves or is resized, its ports change or the layout is toggled: what
+  /// was computed from the scene at the same revision is still valid.
+  quint64 revision() const { return _revision; }
+
+  /// A virtualized scene attaches the embedded widgets only to the nodes
+  /// near the rect visible in the view: the others have no proxy widget
+  /// and are painted with less detail. See setVisibleRect().
+  void setVirtualized(bool virtualized);
+
+  bool virtualized() const { return _virtualized; }
+
+  /// Scenes created afterwards are virtualized
+  static void setVirtualizedByDefault(bool virtualized);
+
+  /// Called by FlowView when the part of the scene it shows changes.
+  /// The widgets are attached and detached later, out of the paint event.
+  void setVisibleRect(QRectF const& rect);
 public:
 
-  std::unordered_map<QUuid, std::unique_ptr<Node> > const &nodes() const;
+  SlotMap<std::unique_ptr<Node> > const &nodes() const;
 
-  std::unordered_map<QUuid, std::shared_ptr<Connection> > const &connections() const;
+  SlotMap<std::shared_ptr<Connection> > const &connections() const;
 
   std::vector<Node*>selectedNodes() const;
 
@@ -93,14 +150,57 @@ public:
 
   void load();
 
-  QByteArray saveToMemory() const;
+  /// Json (indented) is the format of the .flow files. Binary is a compact
+  /// QDataStream encoding of the same document, much faster to build and
+  /// to parse: use it for the copies kept in memory.
+  enum class SceneFormat { Json, CompactJson, Binary };
 
+  QByteArray saveToMemory(SceneFormat format = SceneFormat::Json) const;
+
+  /// Any of the SceneFormat
   void loadFromMemory(const QByteArray& data);
 
+  /// The document of saveToMemory(): "layout", "nodes" and "connections"
+  static QByteArray encodeScene(QJsonObject const& sceneJson, SceneFormat format);
+
+  /// Empty if data is not a scene
+  static QJsonObject decodeScene(const QByteArray& data);
+
+  /// Between beginBatch() and endBatch() the scene does not emit
+  /// nodeCreated() and connectionCreated(): the outermost endBatch() emits
+  /// a single structureChanged() with the nodes created in the meantime.
+  /// Batches can be nested.
+  void beginBatch();
+
+  void endBatch();
+
+  bool inBatch() const { return _batchDepth > 0; }
+
+  /// beginBatch() for the lifetime of the object
+  class ScopedBatch
+  {
+  public:
+    explicit ScopedBatch(FlowScene& scene) : _scene(scene) { _scene.beginBatch(); }
+    ~ScopedBatch() { _scene.endBatch(); }
+    ScopedBatch(ScopedBatch const&) = delete;
+    ScopedBatch& operator=(ScopedBatch const&) = delete;
+  private:
+    FlowScene& _scene;
+  };
+
   void setLayout( QtNodes::PortLayout layout);
 
   QtNodes::PortLayout layout() const;
 
+  /// A read-only scene shows its nodes but does not let them be selected,
+  /// moved, connected or edited. The items check the flag when an event
+  /// arrives, so that switching is O(1): nothing is changed in the items.
+  /// The widgets with the dynamic property "readOnlyInteractive" set to
+  /// true keep receiving the mouse.
+  void setReadOnly(bool readOnly);
+
+  bool readOnly() const { return _readOnly; }
+
 signals:
 
   void nodeCreated(Node &n);
@@ -109,6 +209,9 @@ signals:
 
   void connectionCreated(Connection &c);
 
+  /// end of a batch, see beginBatch()
+  void structureChanged(std::vector<Node*> const& createdNodes);
+
   void connectionDeleted(Connection &c);
 
   void connectionContextMenu(Connection& n, const QPointF& pos);
@@ -132,12 +235,51 @@ private:
   using SharedConnection = std::shared_ptr<Connection>;
   using UniqueNode       = std::unique_ptr<Node>;
 
-  std::unordered_map<QUuid, SharedConnection> _connections;
-  std::unordered_map<QUuid, UniqueNode>       _nodes;
+  SlotMap<SharedConnection> _connections;
+  SlotMap<UniqueNode>       _nodes;
   std::shared_ptr<DataModelRegistry>          _registry;
 
   QtNodes::PortLayout _layout;
 
+  // grid of the bounding rects of the nodes, in scene coordinates
+  std::unordered_map<quint64, std::vector<Node*>> _nodeIndexCells;
+  std::unordered_map<Node*, QRect>                _nodeIndexRanges; // cells of each node
+  std::unordered_set<QUuid>                       _nodeIndexDirty;
+
+  void updateNodeIndex();
+
+  void removeFromNodeIndex(Node* node);
+
+  std::unordered_set<QUuid> _danglingNodes;
+  std::unordered_set<QUuid> _portsDirty;
+
+  // by parent node, see orderedChildren()
+  mutable std::unordered_map<QUuid, std::vector<Node*>> _orderedChildren;
+
+  // see dependentOrder()
+  mutable std::vector<Node*> _dependentOrder;
+  mutable bool _dependentOrderDirty = true;
+
+  quint64 _revision = 0;
+
+  bool _readOnly = false;
+
+  bool _virtualized;
+  bool _virtualizationPending = false;
+  QRectF _visibleRect;
+  std::unordered_set<Node*> _attachedNodes; // with an embedded widget
+
+  void scheduleVirtualization();
+
+  void updateVirtualization();
+
+  int _batchDepth = 0;
+  std::vector<QUuid> _batchNodes;
+
+  void notifyNodeCreated(Node& node);
+
+  void notifyConnectionCreated(Connection& connection);
+
 };
 
 Node*
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
 #include <QtWidgets/QGraphicsView>
 
 #include "Export.hpp"
+#include "PaintProfiler.hpp"
+
+class QTimer;
 
 namespace QtNodes
 {
@@ -27,6 +32,20 @@ public:
 
   void setScene(FlowScene *scene);
 
+  /// Views created afterwards are drawn with OpenGL (QOpenGLWidget).
+  /// Returns false, and keeps the software renderer, if no OpenGL context
+  /// can be created.
+  static bool setOpenGLViewport(bool enabled);
+
+  static bool openGLViewport();
+
+  /// Draws, above the scene, the frame time and where it goes: the painting
+  /// of the nodes, connections and widgets, the status updates and the
+  /// layout (see PaintProfiler). Refreshed every second.
+  void setProfilerOverlay(bool enabled);
+
+  bool profilerOverlay() const;
+
 public slots:
 
   void scaleUp();
@@ -41,6 +60,10 @@ signals:
 
   void finishNodeDelete();
 
+  /// After each paint event. The times are microseconds of
+  /// std::chrono::steady_clock
+  void painted(qint64 startUsec, qint64 durationUsec);
+
 protected:
 
   void contextMenuEvent(QContextMenuEvent *event) override;
@@ -57,12 +80,20 @@ protected:
 
   void drawBackground(QPainter* painter, const QRectF& r) override;
 
+  void paintEvent(QPaintEvent *event) override;
+
   void showEvent(QShowEvent *event) override;
 
 protected:
 
   FlowScene * scene();
 
+private:
+
+  void drawProfilerOverlay();
+
+  void updateProfilerText();
+
 private:
 
   QAction* _clearSelectionAction;
@@ -72,5 +103,22 @@ private:
   QPointF _clickPos;
 
   FlowScene* _scene;
+
+  QTimer* _profilerTimer;
+
+  QElapsedTimer _profilerClock;
+
+  // since the last refresh of the text
+  int _profilerFrames;
+
+  qint64 _profilerFrameNsecs;
+
+  qint64 _profilerMaxFrameNsecs;
+
+  PaintProfiler::Totals _profilerTotals;
+
+  QStringList _profilerText;
+
+  QRect _profilerRect;
 };
 }
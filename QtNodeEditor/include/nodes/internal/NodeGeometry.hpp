@@ -5,6 +5,8 @@
 #include <QtGui/QTransform>
 #include <QtGui/QFontMetrics>
 
+#include <vector>
+
 #include "PortType.hpp"
 #include "Export.hpp"
 #include "memory.hpp"
@@ -85,10 +87,20 @@ public:
   void
   recalculateSize() const;
 
-  /// Updates size if the QFontMetrics is changed
+  /// Updates size if the font is changed or invalidateSize() was called.
+  /// Called by every paint: the text is measured only when it changes.
   void
   recalculateSize(QFont const &font) const;
 
+  /// The content (ports, embedded widget, layout) changed: the next
+  /// recalculateSize(font) measures it again
+  void
+  invalidateSize() { _sizeValid = false; }
+
+  /// Bounding rect of the name of the port, measured by recalculateSize()
+  QRect
+  portLabelRect(PortType portType, PortIndex index) const;
+
   // TODO removed default QTransform()
   QPointF
   portScenePosition(PortIndex index,
@@ -150,6 +162,12 @@ private:
   mutable QFontMetrics _fontMetrics;
   mutable QFontMetrics _boldFontMetrics;
 
+  mutable QFont _font;
+  mutable bool  _sizeValid;
+
+  mutable std::vector<QRect> _inLabelRects;
+  mutable std::vector<QRect> _outLabelRects;
+
   PortLayout _ports_layout;
 };
 }
@@ -15,6 +15,7 @@ namespace QtNodes
 
 class FlowScene;
 class FlowItemEntry;
+class NodeBoundaryItem;
 
 /// Class reacts on GUI events, mouse clicks and
 /// forwards painting operation.
@@ -41,6 +42,11 @@ public:
   void
   setGeometryChanged();
 
+  /// Repaint the boundary of the node only: its style, hovering or
+  /// selection changed. The cached body is kept.
+  void
+  updateBoundary();
+
   /// Visits all attached connections and corrects
   /// their corresponding end points.
   void
@@ -57,6 +63,18 @@ public:
   void
   updateEmbeddedQWidget();
 
+  /// A detached embedded widget has no proxy in the scene: the node is
+  /// painted as when zoomed out. Used by the virtualized scenes.
+  void
+  setEmbeddedWidgetAttached(bool attached);
+
+  bool
+  embeddedWidgetAttached() const { return _proxyWidget != nullptr; }
+
+  /// The user is editing the embedded widget
+  bool
+  embeddedWidgetHasFocus() const;
+
 protected:
   void
   paint(QPainter*                       painter,
@@ -66,6 +84,11 @@ protected:
   QVariant
   itemChange(GraphicsItemChange change, const QVariant &value) override;
 
+  /// In a read-only scene, blocks the clicks, keys and drops sent to the
+  /// embedded widget, see FlowScene::setReadOnly()
+  bool
+  sceneEventFilter(QGraphicsItem* watched, QEvent* event) override;
+
   void
   mousePressEvent(QGraphicsSceneMouseEvent* event) override;
 
@@ -102,6 +125,21 @@ private:
 
   // either nullptr or owned by parent QGraphicsItem
   QGraphicsProxyWidget * _proxyWidget;
+
+  // owned by _proxyWidget, or by this while detached
+  QWidget * _embeddedWidget;
+
+  // the embedded widget is not drawn when zoomed out
+  bool _proxyWidgetShown;
+
+  // child item painting the boundary, owned by this
+  NodeBoundaryItem * _boundaryItem;
+
+  void
+  showEmbeddedWidget(bool shown);
+
+  void
+  createProxyWidget();
   QPoint _press_pos;
 };
 }
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+/// Where the time of a frame goes. The hot paths measure themselves with a
+/// PaintProfiler::Scope; FlowView takes the totals at the end of each frame
+/// and shows them in its overlay.
+///
+/// Only the GUI thread paints and updates the scenes: nothing is locked.
+/// When disabled, a Scope costs a test of a boolean.
+class NODE_EDITOR_PUBLIC PaintProfiler
+{
+public:
+
+  enum Category
+  {
+    Nodes,
+    Connections,
+    Widgets,
+    StatusUpdate,
+    Layout,
+    Background,
+    CategoriesCount
+  };
+
+  struct Totals
+  {
+    Totals();
+
+    qint64 nsecs[CategoriesCount];
+    int    count[CategoriesCount];
+  };
+
+  static
+  void
+  setEnabled(bool enabled);
+
+  static
+  bool
+  enabled();
+
+  static
+  char const*
+  categoryName(Category category);
+
+  static
+  void
+  add(Category category, qint64 nsecs);
+
+  /// The totals since the previous call
+  static
+  Totals
+  take();
+
+  class NODE_EDITOR_PUBLIC Scope
+  {
+  public:
+
+    explicit
+    Scope(Category category)
+      : _category(category)
+      , _running(PaintProfiler::enabled())
+    {
+      if (_running)
+        _timer.start();
+    }
+
+    ~Scope()
+    {
+      if (_running)
+        PaintProfiler::add(_category, _timer.nsecsElapsed());
+    }
+
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+
+  private:
+
+    Category      _category;
+    bool          _running;
+    QElapsedTimer _timer;
+  };
+};
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QUuid>
+
+#include "QUuidStdHash.hpp"
+
+namespace QtNodes
+{
+
+/// Items by id, stored contiguously: iterating visits a dense vector of
+/// (id, item) pairs instead of the buckets of a hash table. The id is
+/// only used by find(), through a side index of the positions.
+///
+/// Removing an item moves the last one in its place: the order of the
+/// iteration is arbitrary, as in an unordered_map, and iterators are
+/// invalidated by insert() and erase().
+template<typename Item>
+class SlotMap
+{
+public:
+  using value_type     = std::pair<QUuid, Item>;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  const_iterator begin() const { return _slots.begin(); }
+  const_iterator end() const { return _slots.end(); }
+
+  std::size_t size() const { return _slots.size(); }
+  bool empty() const { return _slots.empty(); }
+
+  const_iterator
+  find(QUuid const& id) const
+  {
+    auto it = _index.find(id);
+    return (it == _index.end()) ? end() : begin() + it->second;
+  }
+
+  std::size_t count(QUuid const& id) const { return _index.count(id); }
+
+  /// Replaces the item with the same id, if any
+  void
+  insert(QUuid const& id, Item item)
+  {
+    auto it = _index.find(id);
+    if (it != _index.end())
+    {
+      _slots[it->second].second = std::move(item);
+      return;
+    }
+    _index.insert(std::make_pair(id, _slots.size()));
+    _slots.emplace_back(id, std::move(item));
+  }
+
+  void
+  erase(QUuid const& id)
+  {
+    auto it = _index.find(id);
+    if (it == _index.end())
+      return;
+
+    const std::size_t slot = it->second;
+    _index.erase(it);
+
+    // the container is consistent before the item is destroyed
+    Item removed = std::move(_slots[slot].second);
+    if (slot + 1 != _slots.size())
+    {
+      _slots[slot] = std::move(_slots.back());
+      _index[_slots[slot].first] = slot;
+    }
+    _slots.pop_back();
+  }
+
+  void
+  reserve(std::size_t count)
+  {
+    _slots.reserve(count);
+    _index.reserve(count);
+  }
+
+private:
+  std::vector<value_type>                   _slots;
+  std::unordered_map<QUuid, std::size_t>    _index;
+};
+
+}
@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+#include <QtGui/QPainterPathStroker>
+
 #include "StyleCollection.hpp"
 
 using QtNodes::ConnectionGeometry;
@@ -16,6 +18,8 @@ ConnectionGeometry()
   , _lineWidth(3.0)
   , _hovered(false)
   , _ports_layout( PortLayout::Horizontal )
+  , _pathValid(false)
+  , _strokePathValid(false)
 { }
 
 QPointF const&
@@ -47,6 +51,7 @@ setEndPoint(PortType portType, QPointF const& point)
     default:
       break;
   }
+  invalidatePaths();
 }
 
 
@@ -67,6 +72,7 @@ moveEndPoint(PortType portType, QPointF const &offset)
     default:
       break;
   }
+  invalidatePaths();
 }
 
 
@@ -139,4 +145,65 @@ pointsC1C2() const
 void ConnectionGeometry::setPortLayout(QtNodes::PortLayout layout)
 {
   _ports_layout = layout;
+  invalidatePaths();
+}
+
+
+QPainterPath const&
+ConnectionGeometry::
+path() const
+{
+  if (_pathValid)
+    return _path;
+
+  // the sink is after the source, on the same line: the curve is straight
+  bool const straight = ( _ports_layout == PortLayout::Horizontal ) ?
+        (_in.y() == _out.y() && _in.x() > _out.x()) :
+        (_in.x() == _out.x() && _in.y() > _out.y());
+
+  _path = QPainterPath(_out);
+  if (straight)
+  {
+    _path.lineTo(_in);
+  }
+  else
+  {
+    auto c1c2 = pointsC1C2();
+    _path.cubicTo(c1c2.first, c1c2.second, _in);
+  }
+  _pathValid = true;
+  return _path;
+}
+
+
+QPainterPath const&
+ConnectionGeometry::
+strokePath() const
+{
+  if (_strokePathValid)
+    return _strokePath;
+
+  QPainterPath const& curve = path();
+
+  // a polyline is stroked much faster than the curve itself
+  QPainterPath polyline(_out);
+  if (curve.elementCount() == 2)
+  {
+    polyline.lineTo(_in);
+  }
+  else
+  {
+    unsigned const segments = 20;
+    for (auto i = 0ul; i < segments; ++i)
+    {
+      double ratio = double(i + 1) / segments;
+      polyline.lineTo(curve.pointAtPercent(ratio));
+    }
+  }
+
+  QPainterPathStroker stroker; stroker.setWidth(10.0);
+
+  _strokePath = stroker.createStroke(polyline);
+  _strokePathValid = true;
+  return _strokePath;
 }
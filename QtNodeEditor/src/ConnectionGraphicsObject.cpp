@@ -13,6 +13,7 @@
 #include "ConnectionPainter.hpp"
 #include "ConnectionState.hpp"
 #include "ConnectionBlurEffect.hpp"
+#include "PaintProfiler.hpp"
 
 #include "NodeGraphicsObject.hpp"
 
@@ -141,6 +142,8 @@ paint(QPainter* painter,
       QStyleOptionGraphicsItem const* option,
       QWidget*)
 {
+  PaintProfiler::Scope profile(PaintProfiler::Connections);
+
     painter->setClipRect(option->exposedRect);
 
   ConnectionPainter::paint(painter,
@@ -148,10 +151,27 @@ paint(QPainter* painter,
 }
 
 
+QVariant
+ConnectionGraphicsObject::
+itemChange(GraphicsItemChange change, const QVariant &value)
+{
+  if (change == ItemSelectedChange && value.toBool() && _scene.readOnly())
+    return false;
+
+  return QGraphicsItem::itemChange(change, value);
+}
+
+
 void
 ConnectionGraphicsObject::
 mousePressEvent(QGraphicsSceneMouseEvent* event)
 {
+  // see FlowScene::setReadOnly()
+  if (_scene.readOnly())
+  {
+    event->ignore();
+    return;
+  }
   QGraphicsItem::mousePressEvent(event);
   //event->ignore();
 }
@@ -21,17 +21,8 @@ static
 QPainterPath
 cubicPath(ConnectionGeometry const& geom)
 {
-  QPointF const& source = geom.source();
-  QPointF const& sink   = geom.sink();
-
-  auto c1c2 = geom.pointsC1C2();
-
-  // cubic spline
-  QPainterPath cubic(source);
-
-  cubic.cubicTo(c1c2.first, c1c2.second, sink);
-
-  return cubic;
+  // cached by the geometry, until an end point moves
+  return geom.path();
 }
 
 
@@ -39,22 +30,7 @@ QPainterPath
 ConnectionPainter::
 getPainterStroke(ConnectionGeometry const& geom)
 {
-  auto cubic = cubicPath(geom);
-
-  QPointF const& source = geom.source();
-  QPainterPath result(source);
-
-  unsigned segments = 20;
-
-  for (auto i = 0ul; i < segments; ++i)
-  {
-    double ratio = double(i + 1) / segments;
-    result.lineTo(cubic.pointAtPercent(ratio));
-  }
-
-  QPainterPathStroker stroker; stroker.setWidth(10.0);
-
-  return stroker.createStroke(result);
+  return geom.strokePath();
 }
 
 
@@ -1,5 +1,7 @@
 #include "FlowScene.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <utility>
 
@@ -9,6 +11,7 @@
 #include <QtCore/QBuffer>
 #include <QtCore/QDataStream>
 #include <QtCore/QFile>
+#include <QtCore/QTimer>
 
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
@@ -33,16 +36,20 @@ using QtNodes::NodeGraphicsObject;
 using QtNodes::Connection;
 using QtNodes::DataModelRegistry;
 using QtNodes::NodeDataModel;
+using QtNodes::NodeState;
 using QtNodes::PortType;
 using QtNodes::PortIndex;
 using QtNodes::TypeConverter;
 
+static bool virtualizedByDefault = false;
+
 
 FlowScene::
 FlowScene(std::shared_ptr<DataModelRegistry> registry,
           QObject * parent)
   : QGraphicsScene(parent)
   , _registry(std::move(registry))
+  , _virtualized(virtualizedByDefault)
 {
   setItemIndexMethod(QGraphicsScene::NoIndex);
 }
@@ -70,6 +77,7 @@ createConnection(PortType connectedPort,
                  PortIndex portIndex)
 {
   auto connection = std::make_shared<Connection>(connectedPort, node, portIndex);
+  invalidateNodePorts(node);
 
   auto cgo = detail::make_unique<ConnectionGraphicsObject>(*this, *connection);
 
@@ -78,7 +86,7 @@ createConnection(PortType connectedPort,
 
   connection->connectionGeometry().setPortLayout( layout() );
 
-  _connections[connection->id()] = connection;
+  _connections.insert(connection->id(), connection);
 
   return connection;
 }
@@ -115,6 +123,8 @@ createConnection(Node& nodeIn,
 
   nodeIn.nodeState().setConnection(PortType::In, portIndexIn, *connection);
   nodeOut.nodeState().setConnection(PortType::Out, portIndexOut, *connection);
+  invalidateNodePorts(nodeIn);
+  invalidateNodePorts(nodeOut);
 
   // after this function connection points are set to node port
   connection->setGraphicsObject(std::move(cgo));
@@ -124,9 +134,9 @@ createConnection(Node& nodeIn,
   // trigger data propagation
   nodeOut.onDataUpdated(portIndexOut);
 
-  _connections[connection->id()] = connection;
+  _connections.insert(connection->id(), connection);
 
-  connectionCreated(*connection);
+  notifyConnectionCreated(*connection);
 
   return connection;
 }
@@ -142,8 +152,10 @@ restoreConnection(QJsonObject const &connectionJson)
   PortIndex portIndexIn  = connectionJson["in_index"].toInt();
   PortIndex portIndexOut = connectionJson["out_index"].toInt();
 
-  auto nodeIn  = _nodes[nodeInId].get();
-  auto nodeOut = _nodes[nodeOutId].get();
+  auto itIn  = _nodes.find(nodeInId);
+  auto itOut = _nodes.find(nodeOutId);
+  Node* nodeIn  = (itIn  != _nodes.end()) ? itIn->second.get()  : nullptr;
+  Node* nodeOut = (itOut != _nodes.end()) ? itOut->second.get() : nullptr;
 
   auto getConverter = [&]()
   {
@@ -182,7 +194,7 @@ restoreConnection(QJsonObject const &connectionJson)
                      *nodeOut, portIndexOut,
                      getConverter());
 
-  connectionCreated(*connection);
+  notifyConnectionCreated(*connection);
 
   connection->connectionGeometry().setPortLayout( layout() );
   return connection;
@@ -193,6 +205,11 @@ void
 FlowScene::
 deleteConnection(Connection& connection)
 {
+  for (auto portType : {PortType::In, PortType::Out})
+  {
+    if (Node* node = connection.getNode(portType))
+      invalidateNodePorts(*node);
+  }
   connection.removeFromNodes();
   _connections.erase(connection.id());
   connectionDeleted(connection);
@@ -211,9 +228,18 @@ createNode(std::unique_ptr<NodeDataModel> && dataModel)
   auto nodePtr = node.get();
   nodePtr->nodeGeometry().setPortLayout( layout() );
   auto id = node->id();
-  _nodes[id] = std::move(node);
+  _nodes.insert(id, std::move(node));
+  _nodeIndexDirty.insert(id);
+  _portsDirty.insert(id);
+  _dependentOrderDirty = true;
+  _revision++;
+  if (_virtualized)
+  {
+    _attachedNodes.insert(nodePtr);
+    scheduleVirtualization();
+  }
 
-  nodeCreated(*nodePtr);
+  notifyNodeCreated(*nodePtr);
   return *nodePtr;
 }
 
@@ -244,9 +270,18 @@ restoreNode(QJsonObject const& nodeJson)
   auto nodePtr = node.get();
   nodePtr->nodeGeometry().setPortLayout( layout() );
   auto id = node->id();
-  _nodes[ id ] = std::move(node);
+  _nodes.insert(id, std::move(node));
+  _nodeIndexDirty.insert(id);
+  _portsDirty.insert(id);
+  _dependentOrderDirty = true;
+  _revision++;
+  if (_virtualized)
+  {
+    _attachedNodes.insert(nodePtr);
+    scheduleVirtualization();
+  }
 
-  nodeCreated(*nodePtr);
+  notifyNodeCreated(*nodePtr);
   return *nodePtr;
 }
 
@@ -270,6 +305,13 @@ removeNode(Node& node)
     }
   }
 
+  removeFromNodeIndex(&node);
+  _attachedNodes.erase(&node);
+  _danglingNodes.erase(node.id());
+  _portsDirty.erase(node.id());
+  _orderedChildren.erase(node.id());
+  _dependentOrderDirty = true;
+  _revision++;
   _nodes.erase(node.id());
 }
 
@@ -316,91 +358,471 @@ void
 FlowScene::
 iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const & visitor)
 {
-  std::set<QUuid> visitedNodesSet;
+  // a copy: the visitor may change the connections
+  std::vector<Node*> const order = dependentOrder();
+  for (Node* node : order)
+  {
+    visitor(node->nodeDataModel());
+  }
+}
+
+
+std::vector<Node*> const&
+FlowScene::
+dependentOrder() const
+{
+  if (!_dependentOrderDirty)
+    return _dependentOrder;
+
+  // dense handles: the position of each node in _nodes
+  std::size_t const count = _nodes.size();
+  std::vector<Node*> nodes;
+  nodes.reserve(count);
+  std::unordered_map<Node const*, std::size_t> slots;
+  slots.reserve(count);
+  for (auto const& it : _nodes)
+  {
+    slots.emplace(it.second.get(), nodes.size());
+    nodes.push_back(it.second.get());
+  }
 
-  //A leaf node is a node with no input ports, or all possible input ports empty
-  auto isNodeLeaf =
-    [](Node const &node, NodeDataModel const &model)
+  // the connections from a node of this scene, a connection being drawn
+  // has a single node
+  auto forEachLinked = [&](Node const* node, PortType portType,
+                           std::function<void(std::size_t)> const& callback)
+  {
+    for (auto const& connections : node->nodeState().getEntries(portType))
     {
-      for (unsigned int i = 0; i < model.nPorts(PortType::In); ++i)
+      for (auto const& connection : connections)
       {
-        auto connections = node.nodeState().connections(PortType::In, i);
-        if (!connections.empty())
-        {
-          return false;
-        }
+        Node* other = connection.second->getNode(oppositePort(portType));
+        auto it = other ? slots.find(other) : slots.end();
+        if (it != slots.end())
+          callback(it->second);
       }
+    }
+  };
 
-      return true;
-    };
+  std::vector<std::size_t> inDegree(count, 0);
+  for (std::size_t slot = 0; slot < count; ++slot)
+  {
+    forEachLinked(nodes[slot], PortType::In,
+                  [&](std::size_t) { inDegree[slot]++; });
+  }
 
-  //Iterate over "leaf" nodes
-  for (auto const &_node : _nodes)
+  // Kahn's algorithm, _dependentOrder is the queue: every node and every
+  // connection is visited once
+  _dependentOrder.clear();
+  _dependentOrder.reserve(count);
+  for (std::size_t slot = 0; slot < count; ++slot)
   {
-    auto const &node = _node.second;
-    auto model       = node->nodeDataModel();
+    if (inDegree[slot] == 0)
+      _dependentOrder.push_back(nodes[slot]);
+  }
+  for (std::size_t next = 0; next < _dependentOrder.size(); ++next)
+  {
+    forEachLinked(_dependentOrder[next], PortType::Out,
+                  [&](std::size_t child)
+                  {
+                    if (--inDegree[child] == 0)
+                      _dependentOrder.push_back(nodes[child]);
+                  });
+  }
+
+  // the nodes of a cycle, and those after them, can not be ordered
+  for (std::size_t slot = 0; slot < count; ++slot)
+  {
+    if (inDegree[slot] > 0)
+      _dependentOrder.push_back(nodes[slot]);
+  }
 
-    if (isNodeLeaf(*node, *model))
+  _dependentOrderDirty = false;
+  return _dependentOrder;
+}
+
+
+QPointF
+FlowScene::
+getNodePosition(const Node& node) const
+{
+  return node.nodeGraphicsObject().pos();
+}
+
+
+void
+FlowScene::
+setNodePosition(Node& node, const QPointF& pos) const
+{
+  node.nodeGraphicsObject().setPos(pos);
+  node.nodeGraphicsObject().moveConnections();
+}
+
+
+namespace
+{
+
+// a node is usually smaller than a cell
+const int nodeIndexCellSize = 256;
+
+// the sizes of the nodes are recalculated also when painted: the cells of a
+// node cover a little more than its bounding rect
+const qreal nodeIndexMargin = 32;
+
+quint64
+nodeIndexKey(int x, int y)
+{
+  return (quint64(quint32(x)) << 32) | quint64(quint32(y));
+}
+
+int
+nodeIndexCell(qreal coordinate)
+{
+  return int(std::floor(coordinate / nodeIndexCellSize));
+}
+
+}
+
+
+void
+FlowScene::
+invalidateNodeIndex(Node& node)
+{
+  _nodeIndexDirty.insert(node.id());
+  _revision++;
+
+  // the order of the siblings may have changed
+  for (auto const& connections : node.nodeState().getEntries(PortType::In))
+  {
+    for (auto const& connection : connections)
     {
-      visitor(model);
-      visitedNodesSet.insert(node->id());
+      if (Node* parent = connection.second->getNode(PortType::Out))
+        _orderedChildren.erase(parent->id());
     }
   }
+  if (_virtualized)
+    scheduleVirtualization();
+}
 
-  auto areNodeInputsVisitedBefore =
-    [&](Node const &node, NodeDataModel const &model)
+
+std::size_t
+FlowScene::
+danglingNodesCount()
+{
+  std::unordered_set<QUuid> dirty;
+  std::swap(dirty, _portsDirty);
+
+  for (QUuid const& id : dirty)
+  {
+    auto it = _nodes.find(id);
+    if (it == _nodes.end())
+      continue;
+
+    NodeState const& state = it->second->nodeState();
+    bool dangling = false;
+    for (auto portType : {PortType::In, PortType::Out})
     {
-      for (size_t i = 0; i < model.nPorts(PortType::In); ++i)
-      {
-        auto connections = node.nodeState().connections(PortType::In, i);
-
-        for (auto& conn : connections)
-        {
-          if (visitedNodesSet.find(conn.second->getNode(PortType::Out)->id()) == visitedNodesSet.end())
-          {
-            return false;
-          }
-        }
-      }
+      for (auto const& connections : state.getEntries(portType))
+        dangling = dangling || connections.empty();
+    }
+
+    if (dangling)
+      _danglingNodes.insert(id);
+    else
+      _danglingNodes.erase(id);
+  }
+  return _danglingNodes.size();
+}
+
+
+void
+FlowScene::
+invalidateNodePorts(Node const& node)
+{
+  _portsDirty.insert(node.id());
+  _orderedChildren.erase(node.id());
+  _dependentOrderDirty = true;
+  _revision++;
+}
 
-      return true;
+
+std::vector<Node*> const&
+FlowScene::
+orderedChildren(Node const& node) const
+{
+  auto it = _orderedChildren.find(node.id());
+  if (it != _orderedChildren.end())
+    return it->second;
+
+  std::vector<Node*> children;
+  for (auto const& connections : node.nodeState().getEntries(PortType::Out))
+  {
+    for (auto const& connection : connections)
+    {
+      if (Node* child = connection.second->getNode(PortType::In))
+        children.push_back(child);
+    }
+  }
+
+  if (children.size() > 1)
+  {
+    bool const vertical = (_layout == PortLayout::Vertical);
+    auto center = [&](Node const* child)
+    {
+      QPointF const pos = getNodePosition(*child);
+      QSizeF const size = getNodeSize(*child);
+      return vertical ? pos.x() + size.width() * 0.5 : pos.y() + size.height() * 0.5;
     };
+    std::sort(children.begin(), children.end(),
+              [&](Node const* a, Node const* b) { return center(a) < center(b); });
+  }
+
+  return _orderedChildren.emplace(node.id(), std::move(children)).first->second;
+}
+
+
+void
+FlowScene::
+removeFromNodeIndex(Node* node)
+{
+  _nodeIndexDirty.erase(node->id());
+
+  auto it = _nodeIndexRanges.find(node);
+  if (it == _nodeIndexRanges.end())
+    return;
 
-  //Iterate over dependent nodes
-  while (_nodes.size() != visitedNodesSet.size())
+  QRect const range = it->second;
+  for (int x = range.left(); x <= range.right(); ++x)
   {
-    for (auto const &_node : _nodes)
+    for (int y = range.top(); y <= range.bottom(); ++y)
     {
-      auto const &node = _node.second;
-      if (visitedNodesSet.find(node->id()) != visitedNodesSet.end())
+      auto cell = _nodeIndexCells.find(nodeIndexKey(x, y));
+      if (cell == _nodeIndexCells.end())
         continue;
 
-      auto model = node->nodeDataModel();
+      auto& cellNodes = cell->second;
+      cellNodes.erase(std::remove(cellNodes.begin(), cellNodes.end(), node),
+                      cellNodes.end());
+      if (cellNodes.empty())
+        _nodeIndexCells.erase(cell);
+    }
+  }
+  _nodeIndexRanges.erase(it);
+}
+
+
+void
+FlowScene::
+updateNodeIndex()
+{
+  std::unordered_set<QUuid> dirty;
+  std::swap(dirty, _nodeIndexDirty);
+
+  for (QUuid const& id : dirty)
+  {
+    auto it = _nodes.find(id);
+    if (it == _nodes.end())
+      continue;
+
+    Node* node = it->second.get();
+    removeFromNodeIndex(node);
 
-      if (areNodeInputsVisitedBefore(*node, *model))
+    QRectF const rect =
+      node->nodeGraphicsObject().sceneBoundingRect().adjusted(-nodeIndexMargin, -nodeIndexMargin,
+                                                              nodeIndexMargin, nodeIndexMargin);
+    QRect const range(QPoint(nodeIndexCell(rect.left()), nodeIndexCell(rect.top())),
+                      QPoint(nodeIndexCell(rect.right()), nodeIndexCell(rect.bottom())));
+
+    for (int x = range.left(); x <= range.right(); ++x)
+    {
+      for (int y = range.top(); y <= range.bottom(); ++y)
       {
-        visitor(model);
-        visitedNodesSet.insert(node->id());
+        _nodeIndexCells[nodeIndexKey(x, y)].push_back(node);
       }
     }
+    _nodeIndexRanges[node] = range;
   }
 }
 
 
-QPointF
+std::vector<Node*>
 FlowScene::
-getNodePosition(const Node& node) const
+nodesIn(QRectF const& rect)
 {
-  return node.nodeGraphicsObject().pos();
+  updateNodeIndex();
+
+  std::vector<Node*> result;
+  std::unordered_set<Node*> visited;
+
+  auto visitCell = [&](std::vector<Node*> const& cellNodes)
+  {
+    for (Node* node : cellNodes)
+    {
+      if (visited.insert(node).second &&
+          node->nodeGraphicsObject().sceneBoundingRect().intersects(rect))
+      {
+        result.push_back(node);
+      }
+    }
+  };
+
+  QRect const range(QPoint(nodeIndexCell(rect.left()), nodeIndexCell(rect.top())),
+                    QPoint(nodeIndexCell(rect.right()), nodeIndexCell(rect.bottom())));
+
+  // zoomed out, the rect may cover many more cells than are occupied
+  if (qint64(range.width()) * range.height() > qint64(_nodeIndexCells.size()))
+  {
+    for (auto const& cell : _nodeIndexCells)
+    {
+      int const x = int(quint32(cell.first >> 32));
+      int const y = int(quint32(cell.first));
+      if (range.contains(x, y))
+        visitCell(cell.second);
+    }
+  }
+  else
+  {
+    for (int x = range.left(); x <= range.right(); ++x)
+    {
+      for (int y = range.top(); y <= range.bottom(); ++y)
+      {
+        auto cell = _nodeIndexCells.find(nodeIndexKey(x, y));
+        if (cell != _nodeIndexCells.end())
+          visitCell(cell->second);
+      }
+    }
+  }
+  return result;
 }
 
 
 void
 FlowScene::
-setNodePosition(Node& node, const QPointF& pos) const
+setVirtualized(bool virtualized)
 {
-  node.nodeGraphicsObject().setPos(pos);
-  node.nodeGraphicsObject().moveConnections();
+  if (virtualized == _virtualized)
+    return;
+
+  _virtualized = virtualized;
+  _attachedNodes.clear();
+
+  for (auto const& it : _nodes)
+  {
+    NodeGraphicsObject& ngo = it.second->nodeGraphicsObject();
+    if (!virtualized)
+      ngo.setEmbeddedWidgetAttached(true);
+    else if (ngo.embeddedWidgetAttached())
+      _attachedNodes.insert(it.second.get());
+  }
+
+  if (virtualized)
+    scheduleVirtualization();
+}
+
+
+void
+FlowScene::
+setVirtualizedByDefault(bool virtualized)
+{
+  virtualizedByDefault = virtualized;
+}
+
+
+void
+FlowScene::
+setVisibleRect(QRectF const& rect)
+{
+  if (rect == _visibleRect)
+    return;
+
+  _visibleRect = rect;
+  if (_virtualized)
+    scheduleVirtualization();
+}
+
+
+void
+FlowScene::
+scheduleVirtualization()
+{
+  if (_virtualizationPending)
+    return;
+
+  _virtualizationPending = true;
+
+  // the items of the scene must not change while it is painted
+  QTimer::singleShot(0, this, [this]()
+  {
+    _virtualizationPending = false;
+    updateVirtualization();
+  });
+}
+
+
+void
+FlowScene::
+updateVirtualization()
+{
+  if (!_virtualized || _visibleRect.isEmpty())
+    return;
+
+  // half a view around the visible rect: scrolling does not show
+  // the nodes before their widgets are attached
+  QRectF const nearRect =
+    _visibleRect.adjusted(-_visibleRect.width() / 2, -_visibleRect.height() / 2,
+                          _visibleRect.width() / 2, _visibleRect.height() / 2);
+
+  std::vector<Node*> const nearNodes = nodesIn(nearRect);
+  std::unordered_set<Node*> const nearSet(nearNodes.begin(), nearNodes.end());
+
+  for (auto it = _attachedNodes.begin(); it != _attachedNodes.end(); )
+  {
+    NodeGraphicsObject& ngo = (*it)->nodeGraphicsObject();
+    if (nearSet.count(*it) == 0 && !ngo.embeddedWidgetHasFocus())
+    {
+      ngo.setEmbeddedWidgetAttached(false);
+      it = _attachedNodes.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  for (Node* node : nearNodes)
+  {
+    if (_attachedNodes.insert(node).second)
+      node->nodeGraphicsObject().setEmbeddedWidgetAttached(true);
+  }
+}
+
+
+Node*
+FlowScene::
+nodeAt(QPointF const& scenePoint)
+{
+  updateNodeIndex();
+
+  auto cell = _nodeIndexCells.find(nodeIndexKey(nodeIndexCell(scenePoint.x()),
+                                                nodeIndexCell(scenePoint.y())));
+  if (cell == _nodeIndexCells.end())
+    return nullptr;
+
+  Node* resultNode = nullptr;
+  for (Node* node : cell->second)
+  {
+    NodeGraphicsObject const& ngo = node->nodeGraphicsObject();
+    if (!ngo.isVisible() ||
+        !ngo.contains(ngo.mapFromScene(scenePoint)))
+      continue;
+
+    // as QGraphicsScene::items(), the topmost one
+    if (!resultNode ||
+        ngo.zValue() > resultNode->nodeGraphicsObject().zValue())
+    {
+      resultNode = node;
+    }
+  }
+  return resultNode;
 }
 
 
@@ -413,7 +835,7 @@ getNodeSize(const Node& node) const
 }
 
 
-std::unordered_map<QUuid, std::unique_ptr<Node> > const &
+SlotMap<std::unique_ptr<Node> > const &
 FlowScene::
 nodes() const
 {
@@ -421,7 +843,7 @@ nodes() const
 }
 
 
-std::unordered_map<QUuid, std::shared_ptr<Connection> > const &
+SlotMap<std::shared_ptr<Connection> > const &
 FlowScene::
 connections() const
 {
@@ -527,7 +949,7 @@ load()
 
 QByteArray
 FlowScene::
-saveToMemory() const
+saveToMemory(SceneFormat format) const
 {
   QJsonObject sceneJson;
 
@@ -562,9 +984,180 @@ saveToMemory() const
 
   sceneJson["connections"] = connectionJsonArray;
 
-  QJsonDocument document(sceneJson);
+  return encodeScene(sceneJson, format);
+}
 
-  return document.toJson();
+
+namespace
+{
+
+// header of the Binary format; a Json document starts with '{' or a space
+const char binarySceneMagic[4] = { 'Q', 'N', 'S', 'B' };
+const quint32 binarySceneVersion = 1;
+
+enum BinaryTag : quint8
+{
+  TagNull, TagFalse, TagTrue, TagDouble, TagString, TagArray, TagObject
+};
+
+void
+writeBinaryValue(QDataStream& stream, QJsonValue const& value)
+{
+  switch (value.type())
+  {
+    case QJsonValue::Bool:
+      stream << quint8(value.toBool() ? TagTrue : TagFalse);
+      break;
+
+    case QJsonValue::Double:
+      stream << quint8(TagDouble) << value.toDouble();
+      break;
+
+    case QJsonValue::String:
+      stream << quint8(TagString) << value.toString();
+      break;
+
+    case QJsonValue::Array:
+    {
+      QJsonArray const array = value.toArray();
+      stream << quint8(TagArray) << quint32(array.size());
+      for (QJsonValue const& item : array)
+      {
+        writeBinaryValue(stream, item);
+      }
+      break;
+    }
+
+    case QJsonValue::Object:
+    {
+      QJsonObject const object = value.toObject();
+      stream << quint8(TagObject) << quint32(object.size());
+      for (auto it = object.begin(); it != object.end(); ++it)
+      {
+        stream << it.key();
+        writeBinaryValue(stream, it.value());
+      }
+      break;
+    }
+
+    default:
+      stream << quint8(TagNull);
+  }
+}
+
+
+QJsonValue
+readBinaryValue(QDataStream& stream)
+{
+  quint8 tag = TagNull;
+  stream >> tag;
+
+  switch (tag)
+  {
+    case TagFalse:
+      return QJsonValue(false);
+
+    case TagTrue:
+      return QJsonValue(true);
+
+    case TagDouble:
+    {
+      double number = 0;
+      stream >> number;
+      return QJsonValue(number);
+    }
+
+    case TagString:
+    {
+      QString string;
+      stream >> string;
+      return QJsonValue(string);
+    }
+
+    case TagArray:
+    {
+      quint32 size = 0;
+      stream >> size;
+      QJsonArray array;
+      for (quint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i)
+      {
+        array.append(readBinaryValue(stream));
+      }
+      return QJsonValue(array);
+    }
+
+    case TagObject:
+    {
+      quint32 size = 0;
+      stream >> size;
+      QJsonObject object;
+      for (quint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i)
+      {
+        QString key;
+        stream >> key;
+        object.insert(key, readBinaryValue(stream));
+      }
+      return QJsonValue(object);
+    }
+
+    default:
+      return QJsonValue();
+  }
+}
+
+}
+
+
+QByteArray
+FlowScene::
+encodeScene(QJsonObject const& sceneJson, SceneFormat format)
+{
+  if (format != SceneFormat::Binary)
+  {
+    return QJsonDocument(sceneJson).toJson( format == SceneFormat::Json ?
+                                              QJsonDocument::Indented :
+                                              QJsonDocument::Compact );
+  }
+
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  stream.writeRawData(binarySceneMagic, sizeof(binarySceneMagic));
+  stream << binarySceneVersion;
+  writeBinaryValue(stream, sceneJson);
+
+  return data;
+}
+
+
+QJsonObject
+FlowScene::
+decodeScene(const QByteArray& data)
+{
+  if (!data.startsWith(QByteArray::fromRawData(binarySceneMagic,
+                                               sizeof(binarySceneMagic))))
+  {
+    return QJsonDocument::fromJson(data).object();
+  }
+
+  QDataStream stream(data);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream.skipRawData(sizeof(binarySceneMagic));
+
+  quint32 version = 0;
+  stream >> version;
+  if (version != binarySceneVersion)
+  {
+    return QJsonObject();
+  }
+
+  QJsonValue const value = readBinaryValue(stream);
+  if (stream.status() != QDataStream::Ok)
+  {
+    return QJsonObject();
+  }
+  return value.toObject();
 }
 
 
@@ -572,12 +1165,15 @@ void
 FlowScene::
 loadFromMemory(const QByteArray& data)
 {
-  QJsonObject const jsonDocument = QJsonDocument::fromJson(data).object();
+  QJsonObject const jsonDocument = decodeScene(data);
+
+  ScopedBatch batch(*this);
 
   QString layout = jsonDocument["layout"].toString();
   setLayout( (layout == "Horizontal") ? PortLayout::Horizontal : PortLayout::Vertical );
 
   QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+  _nodes.reserve(_nodes.size() + nodesJsonArray.size());
 
   for (QJsonValueRef node : nodesJsonArray)
   {
@@ -585,6 +1181,7 @@ loadFromMemory(const QByteArray& data)
   }
 
   QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+  _connections.reserve(_connections.size() + connectionJsonArray.size());
 
   for (QJsonValueRef connection : connectionJsonArray)
   {
@@ -593,9 +1190,64 @@ loadFromMemory(const QByteArray& data)
 }
 
 
+void
+FlowScene::
+beginBatch()
+{
+  _batchDepth++;
+}
+
+
+void
+FlowScene::
+endBatch()
+{
+  if (_batchDepth == 0 || --_batchDepth > 0)
+    return;
+
+  std::vector<Node*> createdNodes;
+  createdNodes.reserve(_batchNodes.size());
+
+  // some may have been removed in the meantime
+  for (QUuid const& id : _batchNodes)
+  {
+    auto it = _nodes.find(id);
+    if (it != _nodes.end())
+    {
+      createdNodes.push_back(it->second.get());
+    }
+  }
+  _batchNodes.clear();
+
+  structureChanged(createdNodes);
+}
+
+
+void
+FlowScene::
+notifyNodeCreated(Node& node)
+{
+  if (inBatch())
+    _batchNodes.push_back(node.id());
+  else
+    nodeCreated(node);
+}
+
+
+void
+FlowScene::
+notifyConnectionCreated(Connection& connection)
+{
+  if (!inBatch())
+    connectionCreated(connection);
+}
+
+
 void FlowScene::setLayout( QtNodes::PortLayout layout)
 {
   _layout = layout;
+  _orderedChildren.clear();
+  _revision++;
   for(auto& node: nodes() )
   {
     node.second->nodeGeometry().setPortLayout(layout);
@@ -611,6 +1263,23 @@ QtNodes::PortLayout FlowScene::layout() const
   return _layout;
 }
 
+
+void
+FlowScene::
+setReadOnly(bool readOnly)
+{
+  if (readOnly == _readOnly)
+    return;
+
+  _readOnly = readOnly;
+  if (_readOnly)
+  {
+    // nothing selected can be deleted, nothing focused can be edited
+    clearSelection();
+    clearFocus();
+  }
+}
+
 //------------------------------------------------------------------------------
 namespace QtNodes
 {
@@ -619,34 +1288,9 @@ Node*
 locateNodeAt(QPointF scenePoint, FlowScene &scene,
              QTransform const & viewTransform)
 {
-  // items under cursor
-  QList<QGraphicsItem*> items =
-    scene.items(scenePoint,
-                Qt::IntersectsItemShape,
-                Qt::DescendingOrder,
-                viewTransform);
+  // the nodes do not ignore the transformations of the view
+  Q_UNUSED(viewTransform);
 
-  //// items convertable to NodeGraphicsObject
-  std::vector<QGraphicsItem*> filteredItems;
-
-  std::copy_if(items.begin(),
-               items.end(),
-               std::back_inserter(filteredItems),
-               [] (QGraphicsItem * item)
-    {
-      return (dynamic_cast<NodeGraphicsObject*>(item) != nullptr);
-    });
-
-  Node* resultNode = nullptr;
-
-  if (!filteredItems.empty())
-  {
-    QGraphicsItem* graphicsItem = filteredItems.front();
-    auto ngo = dynamic_cast<NodeGraphicsObject*>(graphicsItem);
-
-    resultNode = &ngo->node();
-  }
-
-  return resultNode;
+  return scene.nodeAt(scenePoint);
 }
 }
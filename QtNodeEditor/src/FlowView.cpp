@@ -10,8 +10,13 @@
 #include <QtCore/QPointF>
 
 #include <QtWidgets>
+#include <QtWidgets/QOpenGLWidget>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QSurfaceFormat>
 
 #include <QDebug>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cmath>
 
@@ -25,12 +30,44 @@
 using QtNodes::FlowView;
 using QtNodes::FlowScene;
 
+static bool openGLViewportEnabled = false;
+
+bool
+FlowView::
+setOpenGLViewport(bool enabled)
+{
+  if (enabled)
+  {
+    QOpenGLContext context;
+    if (!context.create())
+    {
+      openGLViewportEnabled = false;
+      return false;
+    }
+  }
+  openGLViewportEnabled = enabled;
+  return true;
+}
+
+
+bool
+FlowView::
+openGLViewport()
+{
+  return openGLViewportEnabled;
+}
+
+
 FlowView::
 FlowView(QWidget *parent)
   : QGraphicsView(parent)
   , _clearSelectionAction(Q_NULLPTR)
   , _deleteSelectionAction(Q_NULLPTR)
   , _scene(Q_NULLPTR)
+  , _profilerTimer(Q_NULLPTR)
+  , _profilerFrames(0)
+  , _profilerFrameNsecs(0)
+  , _profilerMaxFrameNsecs(0)
 {
   setDragMode(QGraphicsView::ScrollHandDrag);
   setRenderHint(QPainter::Antialiasing);
@@ -39,17 +76,36 @@ FlowView(QWidget *parent)
 
   setBackgroundBrush(flowViewStyle.BackgroundColor);
 
-  setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
-  //setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+  if (openGLViewportEnabled)
+  {
+    QSurfaceFormat format;
+    format.setSamples(4);
+
+    auto glWidget = new QOpenGLWidget();
+    glWidget->setFormat(format);
+    setViewport(glWidget);
+
+    // the frame buffer of QOpenGLWidget is drawn again as a whole anyway
+    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+  }
+  else
+  {
+    // repaint only the regions of the items that changed (or their bounding
+    // rect, if there are many), instead of the whole viewport
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+  }
 
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 
   setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
 
-  setCacheMode(QGraphicsView::CacheBackground);
-
-  //setViewport(new QGLWidget(QGLFormat(QGL::SampleBuffers)));
+  // The background is a fill and two lines, drawn for the exposed region
+  // only: cheaper than a cached pixmap, that QGraphicsView drops whenever the
+  // scene rect moves (each step of a pan, see mouseMoveEvent) or the zoom
+  // changes, and that would be uploaded as a texture at each repaint of an
+  // OpenGL viewport
+  setCacheMode(QGraphicsView::CacheNone);
 }
 
 
@@ -251,6 +307,9 @@ void
 FlowView::
 deleteSelectedNodes()
 {
+  if (_scene->readOnly())
+    return;
+
   // Delete the selected connections first, ensuring that they won't be
   // automatically deleted when selected nodes are deleted (deleting a node
   // deletes some connections as well)
@@ -283,7 +342,9 @@ keyPressEvent(QKeyEvent *event)
   switch (event->key())
   {
     case Qt::Key_Shift:
-      setDragMode(QGraphicsView::RubberBandDrag);
+      // nothing can be selected in a read-only scene
+      if (!_scene->readOnly())
+        setDragMode(QGraphicsView::RubberBandDrag);
       break;
 
     default:
@@ -342,56 +403,183 @@ mouseMoveEvent(QMouseEvent *event)
 
 void
 FlowView::
-drawBackground(QPainter* painter, const QRectF& r)
+setProfilerOverlay(bool enabled)
 {
-  QGraphicsView::drawBackground(painter, r);
+  if (enabled == profilerOverlay())
+    return;
+
+  PaintProfiler::setEnabled(enabled);
+
+  if (enabled)
+  {
+    _profilerTimer = new QTimer(this);
+    connect(_profilerTimer, &QTimer::timeout, this, &FlowView::updateProfilerText);
+    _profilerTimer->start(1000);
+
+    _profilerClock.start();
+    _profilerFrames = 0;
+    _profilerFrameNsecs = 0;
+    _profilerMaxFrameNsecs = 0;
+    _profilerTotals = PaintProfiler::Totals();
+    _profilerText = QStringList() << QStringLiteral("measuring...");
+  }
+  else
+  {
+    delete _profilerTimer;
+    _profilerTimer = Q_NULLPTR;
+    _profilerText.clear();
+  }
+  viewport()->update();
+}
+
+
+bool
+FlowView::
+profilerOverlay() const
+{
+  return _profilerTimer != Q_NULLPTR;
+}
+
+
+void
+FlowView::
+updateProfilerText()
+{
+  double const seconds = _profilerClock.restart() / 1000.0;
+  int const frames = std::max(_profilerFrames, 1);
+  auto ms = [](qint64 nsecs) { return QString::number(nsecs / 1e6, 'f', 2); };
+
+  _profilerText.clear();
+  _profilerText << QStringLiteral("frame: %1 ms avg, %2 ms max, %3 fps")
+                   .arg(ms(_profilerFrameNsecs / frames))
+                   .arg(ms(_profilerMaxFrameNsecs))
+                   .arg(QString::number(_profilerFrames / std::max(seconds, 0.001), 'f', 1));
+
+  for (int i = 0; i < PaintProfiler::CategoriesCount; ++i)
+  {
+    auto const category = PaintProfiler::Category(i);
+    bool const painted = (category == PaintProfiler::Nodes ||
+                          category == PaintProfiler::Connections ||
+                          category == PaintProfiler::Widgets);
+    _profilerText << QStringLiteral("%1: %2 ms, %3 %4")
+                     .arg(QLatin1String(PaintProfiler::categoryName(category)))
+                     .arg(ms(_profilerTotals.nsecs[i] / frames))
+                     .arg(_profilerTotals.count[i] / frames)
+                     .arg(painted ? QStringLiteral("painted") : QStringLiteral("calls"));
+  }
+  _profilerText << QStringLiteral("(per frame)");
 
-  auto drawGrid =
-    [&](double gridStep)
+  _profilerFrames = 0;
+  _profilerFrameNsecs = 0;
+  _profilerMaxFrameNsecs = 0;
+  _profilerTotals = PaintProfiler::Totals();
+
+  viewport()->update(_profilerRect);
+}
+
+
+void
+FlowView::
+drawProfilerOverlay()
+{
+  QPainter painter(viewport());
+
+  QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+  painter.setFont(font);
+  QFontMetrics const metrics(font);
+
+  int width = 0;
+  for (auto const& line : _profilerText)
+    width = std::max(width, metrics.width(line));
+
+  int const margin = 6;
+  _profilerRect = QRect(10, 10,
+                        width + 2 * margin,
+                        _profilerText.size() * metrics.height() + 2 * margin);
+
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(QColor(0, 0, 0, 180));
+  painter.drawRect(_profilerRect);
+
+  painter.setPen(Qt::white);
+  int y = _profilerRect.top() + margin + metrics.ascent();
+  for (auto const& line : _profilerText)
+  {
+    painter.drawText(_profilerRect.left() + margin, y, line);
+    y += metrics.height();
+  }
+}
+
+
+void
+FlowView::
+paintEvent(QPaintEvent *event)
+{
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+  auto const start = steady_clock::now();
+
+  if (profilerOverlay())
+  {
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    QGraphicsView::paintEvent(event);
+
+    // the refresh of the overlay alone is not a frame of the scene
+    PaintProfiler::Totals const totals = PaintProfiler::take();
+    for (int i = 0; i < PaintProfiler::CategoriesCount; ++i)
     {
-      gridStep = 1;
-      QRect   windowRect = rect();
-      QPointF tl = mapToScene(windowRect.topLeft());
-      QPointF br = mapToScene(windowRect.bottomRight());
-
-      double left   = std::floor(tl.x() / gridStep - 0.5);
-      double right  = std::floor(br.x() / gridStep + 1.0);
-      double bottom = std::floor(tl.y() / gridStep - 0.5);
-      double top    = std::floor (br.y() / gridStep + 1.0);
-
-      // vertical lines
-   //   for (int xi = int(left); xi <= int(right); ++xi)
-      {
-        int xi = 0;
-        QLineF line(xi * gridStep, bottom  * gridStep,
-                    xi * gridStep, top  * gridStep);
+      _profilerTotals.nsecs[i] += totals.nsecs[i];
+      _profilerTotals.count[i] += totals.count[i];
+    }
+    if (!_profilerRect.contains(event->rect()))
+    {
+      qint64 const frameNsecs = frameTimer.nsecsElapsed();
+      _profilerFrames++;
+      _profilerFrameNsecs += frameNsecs;
+      _profilerMaxFrameNsecs = std::max(_profilerMaxFrameNsecs, frameNsecs);
+    }
 
-        painter->drawLine(line);
-      }
+    drawProfilerOverlay();
+  }
+  else
+  {
+    QGraphicsView::paintEvent(event);
+  }
 
-      // horizontal lines
-      //for (int yi = int(bottom); yi <= int(top); ++yi)
-      {
-        int yi = 0;
-        QLineF line(left  * gridStep, yi * gridStep,
-                    right * gridStep, yi * gridStep );
-        painter->drawLine(line);
-      }
-    };
+  if (_scene && _scene->virtualized())
+  {
+    _scene->setVisibleRect(mapToScene(viewport()->rect()).boundingRect());
+  }
 
-  auto const &flowViewStyle = StyleCollection::flowViewStyle();
+  auto const end = steady_clock::now();
+  emit painted(std::chrono::duration_cast<microseconds>(start.time_since_epoch()).count(),
+               std::chrono::duration_cast<microseconds>(end - start).count());
+}
 
-  QBrush bBrush = backgroundBrush();
 
-  QPen pfine(flowViewStyle.FineGridColor, 1.0);
+void
+FlowView::
+drawBackground(QPainter* painter, const QRectF& r)
+{
+  PaintProfiler::Scope profile(PaintProfiler::Background);
 
-  painter->setPen(pfine);
-  drawGrid(20);
+  QGraphicsView::drawBackground(painter, r);
 
-  QPen p(Qt::white, 2.0);
+  // The axes, only where they cross the exposed rect: nothing depends on the
+  // part of the scene the view shows, so that any region can be drawn alone
+  auto const &flowViewStyle = StyleCollection::flowViewStyle();
+  painter->setPen(QPen(flowViewStyle.FineGridColor, 1.0));
 
-  painter->setPen(p);
-  //drawGrid(150);
+  if (r.left() <= 0.0 && r.right() >= 0.0)
+  {
+    painter->drawLine(QLineF(0.0, r.top(), 0.0, r.bottom()));
+  }
+  if (r.top() <= 0.0 && r.bottom() >= 0.0)
+  {
+    painter->drawLine(QLineF(r.left(), 0.0, r.right(), 0.0));
+  }
 }
 
 
@@ -223,6 +223,7 @@ onNodeSizeUpdated()
     {
         nodeDataModel()->embeddedWidget()->adjustSize();
     }
+    _nodeGraphicsObject->setGeometryChanged();
     nodeGeometry().recalculateSize();
     int new_width = nodeGeometry().width();
 
@@ -118,6 +118,7 @@ tryConnect() const
   // 3) Assign Connection to empty port in NodeState
   // The port is not longer required after this function
   _connection->setNodeToPort(*_node, requiredPort, portIndex);
+  _scene->invalidateNodePorts(*_node);
 
   // 4) Adjust Connection geometry
 
@@ -150,6 +151,7 @@ disconnect(PortType portToDisconnect) const
 
   // clear pointer to Connection in the NodeState
   state.getEntries(portToDisconnect)[portIndex].clear();
+  _scene->invalidateNodePorts(*_node);
 
   // 4) Propagate invalid data to IN node
   _connection->propagateEmptyData();
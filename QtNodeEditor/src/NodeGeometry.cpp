@@ -32,6 +32,7 @@ NodeGeometry(std::unique_ptr<NodeDataModel> const &dataModel)
   , _dataModel(dataModel)
   , _fontMetrics(QFont())
   , _boldFontMetrics(QFont())
+  , _sizeValid(false)
   , _ports_layout(PortLayout::Vertical  )
 {
   QFont f;
@@ -98,6 +99,7 @@ recalculateSize() const
 
   _inputPortWidth  = portWidth(PortType::In);
   _outputPortWidth = portWidth(PortType::Out);
+  _sizeValid = true;
 
   _width = _inputPortWidth +
            _outputPortWidth +
@@ -120,18 +122,20 @@ void
 NodeGeometry::
 recalculateSize(QFont const & font) const
 {
-  QFontMetrics fontMetrics(font);
-  QFont boldFont = font;
-  boldFont.setPointSize(12);
+  if (_sizeValid && font == _font)
+    return;
 
-  QFontMetrics boldFontMetrics(boldFont);
-
-  if (_boldFontMetrics != boldFontMetrics)
+  if (font != _font)
   {
-    _fontMetrics     = fontMetrics;
-    _boldFontMetrics = boldFontMetrics;
-    recalculateSize();
+    _font = font;
+
+    QFont boldFont = font;
+    boldFont.setPointSize(12);
+
+    _fontMetrics     = QFontMetrics(font);
+    _boldFontMetrics = QFontMetrics(boldFont);
   }
+  recalculateSize();
 }
 
 
@@ -222,11 +226,11 @@ widgetPosition() const
   {
     if (_dataModel->validationState() != NodeValidationState::Valid)
     {
-      return QPointF(_spacing + portWidth(PortType::In),
+      return QPointF(_spacing + _inputPortWidth,
                      ( _height - validationHeight() - _spacing - w->height()) / 2.0);
     }
 
-    return QPointF(_spacing + portWidth(PortType::In),
+    return QPointF(_spacing + _inputPortWidth,
                    ( _height - w->height()) / 2.0);
   }
 
@@ -271,6 +275,21 @@ calculateNodePositionBetweenNodePorts(PortIndex targetPortIndex, PortType target
 void NodeGeometry::setPortLayout(QtNodes::PortLayout layout)
 {
     _ports_layout = layout;
+    invalidateSize();
+}
+
+
+QRect
+NodeGeometry::
+portLabelRect(PortType portType, PortIndex index) const
+{
+  auto const & rects = (portType == PortType::In) ? _inLabelRects : _outLabelRects;
+
+  if (index >= 0 && static_cast<size_t>(index) < rects.size())
+    return rects[index];
+
+  // the ports changed after the last recalculateSize()
+  return _fontMetrics.boundingRect(_dataModel->dataType(portType, index).name);
 }
 
 
@@ -280,10 +299,14 @@ portWidth(PortType portType) const
 {
   unsigned width = 0;
 
+  auto & rects = (portType == PortType::In) ? _inLabelRects : _outLabelRects;
+  rects.clear();
+
   for (auto i = 0ul; i < _dataModel->nPorts(portType); ++i)
   {
     QString name = _dataModel->dataType(portType, i).name;
-    width = std::max(unsigned(_fontMetrics.width(name)), width);
+    rects.push_back(name.isEmpty() ? QRect() : _fontMetrics.boundingRect(name));
+    width = std::max(unsigned(name.isEmpty() ? 0 : _fontMetrics.width(name)), width);
   }
 
   return width;
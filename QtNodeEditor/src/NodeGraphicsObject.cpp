@@ -10,7 +10,9 @@
 #include "ConnectionState.hpp"
 
 #include "FlowScene.hpp"
+#include "FlowView.hpp"
 #include "NodePainter.hpp"
+#include "PaintProfiler.hpp"
 
 #include "Node.hpp"
 #include "NodeDataModel.hpp"
@@ -22,6 +24,76 @@ using QtNodes::NodeGraphicsObject;
 using QtNodes::Node;
 using QtNodes::FlowScene;
 
+namespace QtNodes
+{
+
+// The boundary of a node, above its body. The body is in the device
+// coordinate cache of the node, the boundary is not cached: changing the
+// style of the boundary does not repaint the body.
+class NodeBoundaryItem : public QGraphicsItem
+{
+public:
+  NodeBoundaryItem(NodeGraphicsObject& parent)
+    : QGraphicsItem(&parent)
+    , _parent(parent)
+  {
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+  }
+
+  QRectF
+  boundingRect() const override
+  {
+    return _parent.boundingRect();
+  }
+
+  void
+  setGeometryChanged()
+  {
+    prepareGeometryChange();
+  }
+
+  void
+  paint(QPainter* painter,
+        QStyleOptionGraphicsItem const* option,
+        QWidget*) override
+  {
+    auto const detail =
+      NodePainter::detailFor(option->levelOfDetailFromTransform(painter->worldTransform()));
+    if (detail == NodePainter::Detail::Flat)
+      return;
+
+    PaintProfiler::Scope profile(PaintProfiler::Nodes);
+
+    Node const& node = _parent.node();
+    NodePainter::drawNodeBoundary(painter, node.nodeGeometry(), node.nodeDataModel(), _parent);
+  }
+
+private:
+  NodeGraphicsObject& _parent;
+};
+
+// The embedded widget of a node, its painting measured
+class NodeProxyWidget : public QGraphicsProxyWidget
+{
+public:
+  NodeProxyWidget(QGraphicsItem* parent)
+    : QGraphicsProxyWidget(parent)
+  {}
+
+  void
+  paint(QPainter* painter,
+        QStyleOptionGraphicsItem const* option,
+        QWidget* widget) override
+  {
+    PaintProfiler::Scope profile(PaintProfiler::Widgets);
+    QGraphicsProxyWidget::paint(painter, option, widget);
+  }
+};
+
+}
+
+
 NodeGraphicsObject::
 NodeGraphicsObject(FlowScene &scene,
                    Node& node)
@@ -30,6 +102,9 @@ NodeGraphicsObject(FlowScene &scene,
   , _locked(false)
   , _double_clicked(false)
   , _proxyWidget(nullptr)
+  , _embeddedWidget(nullptr)
+  , _proxyWidgetShown(true)
+  , _boundaryItem(nullptr)
 {
   _scene.addItem(this);
 
@@ -39,10 +114,16 @@ NodeGraphicsObject(FlowScene &scene,
   setFlag(QGraphicsItem::ItemIsSelectable, true);
   setFlag(QGraphicsItem::ItemSendsScenePositionChanges, true);
 
+  // the events of the embedded widget go through sceneEventFilter()
+  setFiltersChildEvents(true);
+
   setCacheMode( QGraphicsItem::DeviceCoordinateCache );
 
   auto const &nodeStyle = node.nodeDataModel()->nodeStyle();
 
+  // an effect is rendered in an offscreen pixmap at each frame, which
+  // defeats the OpenGL viewport
+  if (!FlowView::openGLViewport())
   {
     auto effect = new QGraphicsDropShadowEffect;
     effect->setOffset(2, 2);
@@ -54,6 +135,10 @@ NodeGraphicsObject(FlowScene &scene,
 
   setOpacity(nodeStyle.Opacity);
 
+  // the opacity of this item is not propagated to its children
+  _boundaryItem = new NodeBoundaryItem(*this);
+  _boundaryItem->setOpacity(nodeStyle.Opacity);
+
   setAcceptHoverEvents(true);
 
   setZValue(0);
@@ -66,6 +151,9 @@ NodeGraphicsObject(FlowScene &scene,
 NodeGraphicsObject::
 ~NodeGraphicsObject()
 {
+  if (!_proxyWidget)
+    delete _embeddedWidget;
+
   _scene.removeItem(this);
 }
 
@@ -97,23 +185,69 @@ updateEmbeddedQWidget()
     _proxyWidget->deleteLater();
   }
 
-  if (auto w = _node.nodeDataModel()->embeddedWidget())
-  {
-    _proxyWidget = new QGraphicsProxyWidget(this);
-
-    _proxyWidget->setWidget(w);
+  _proxyWidget = nullptr;
+  _embeddedWidget = _node.nodeDataModel()->embeddedWidget();
 
-    _proxyWidget->setPreferredWidth(5);
+  if (_embeddedWidget)
+  {
+    createProxyWidget();
 
     geom.recalculateSize();
 
     _proxyWidget->setPos(geom.widgetPosition());
 
     update();
+  }
+}
+
+
+void
+NodeGraphicsObject::
+createProxyWidget()
+{
+  _proxyWidget = new NodeProxyWidget(this);
+  _proxyWidgetShown = true;
+
+  _proxyWidget->setWidget(_embeddedWidget);
+
+  _proxyWidget->setPreferredWidth(5);
+
+  _proxyWidget->setOpacity(1.0);
+  _proxyWidget->setFlag(QGraphicsItem::ItemIgnoresParentOpacity);
+}
+
+
+void
+NodeGraphicsObject::
+setEmbeddedWidgetAttached(bool attached)
+{
+  if (!_embeddedWidget || attached == embeddedWidgetAttached())
+    return;
+
+  if (attached)
+  {
+    createProxyWidget();
+    _proxyWidget->setPos(_node.nodeGeometry().widgetPosition());
+  }
+  else
+  {
+    // the widget is given back, not deleted with the proxy
+    _proxyWidget->setWidget(nullptr);
+    _embeddedWidget->hide();
 
-    _proxyWidget->setOpacity(1.0);
-    _proxyWidget->setFlag(QGraphicsItem::ItemIgnoresParentOpacity);
+    delete _proxyWidget;
+    _proxyWidget = nullptr;
   }
+  update();
+}
+
+
+bool
+NodeGraphicsObject::
+embeddedWidgetHasFocus() const
+{
+  return _proxyWidget && _embeddedWidget &&
+         (_proxyWidget->hasFocus() || _embeddedWidget->isAncestorOf(QApplication::focusWidget()));
 }
 
 
@@ -130,6 +264,20 @@ NodeGraphicsObject::
 setGeometryChanged()
 {
   prepareGeometryChange();
+  if (_boundaryItem)
+    _boundaryItem->setGeometryChanged();
+  _scene.invalidateNodeIndex(_node);
+}
+
+
+void
+NodeGraphicsObject::
+updateBoundary()
+{
+  if (_boundaryItem)
+    _boundaryItem->update();
+  else
+    update();
 }
 
 
@@ -167,9 +315,42 @@ paint(QPainter * painter,
       QStyleOptionGraphicsItem const* option,
       QWidget* )
 {
+  PaintProfiler::Scope profile(PaintProfiler::Nodes);
+
   painter->setClipRect(option->exposedRect);
 
-  NodePainter::paint(painter, _node, _scene);
+  auto const detail =
+    NodePainter::detailFor(option->levelOfDetailFromTransform(painter->worldTransform()));
+
+  showEmbeddedWidget(detail == NodePainter::Detail::Full);
+
+  // off-screen in a virtualized scene: there is no widget to show
+  if (detail == NodePainter::Detail::Full && _embeddedWidget && !_proxyWidget)
+  {
+    NodePainter::paint(painter, _node, _scene, NodePainter::Detail::Caption);
+    return;
+  }
+
+  NodePainter::paint(painter, _node, _scene, detail);
+}
+
+
+void
+NodeGraphicsObject::
+showEmbeddedWidget(bool shown)
+{
+  if (!_proxyWidget || shown == _proxyWidgetShown)
+    return;
+
+  _proxyWidgetShown = shown;
+
+  // the items of the scene must not change while it is painted
+  QPointer<QGraphicsProxyWidget> proxy = _proxyWidget;
+  QTimer::singleShot(0, this, [proxy, this]()
+  {
+    if (proxy && proxy == _proxyWidget)
+      proxy->setVisible(_proxyWidgetShown);
+  });
 }
 
 
@@ -177,21 +358,94 @@ QVariant
 NodeGraphicsObject::
 itemChange(GraphicsItemChange change, const QVariant &value)
 {
-  if (change == ItemPositionChange && scene())
+  if (change == ItemSelectedChange && value.toBool() && _scene.readOnly())
+  {
+    return false;
+  }
+  else if (change == ItemPositionChange && scene())
   {
     moveConnections();
   }
+  else if (change == ItemScenePositionHasChanged && scene())
+  {
+    _scene.invalidateNodeIndex(_node);
+  }
+  else if (change == ItemSelectedHasChanged)
+  {
+    updateBoundary();
+  }
 
   return QGraphicsItem::itemChange(change, value);
 }
 
 
+bool
+NodeGraphicsObject::
+sceneEventFilter(QGraphicsItem* watched, QEvent* event)
+{
+  if (watched != _proxyWidget || !_scene.readOnly())
+    return false;
+
+  QWidget* target = nullptr;
+  switch (event->type())
+  {
+    // the release goes where the press was accepted
+    case QEvent::GraphicsSceneMousePress:
+    case QEvent::GraphicsSceneMouseDoubleClick:
+      target = _embeddedWidget->childAt(
+        static_cast<QGraphicsSceneMouseEvent*>(event)->pos().toPoint());
+      break;
+
+    case QEvent::GraphicsSceneContextMenu:
+      target = _embeddedWidget->childAt(
+        static_cast<QGraphicsSceneContextMenuEvent*>(event)->pos().toPoint());
+      break;
+
+    case QEvent::GraphicsSceneDragEnter:
+    case QEvent::GraphicsSceneDragMove:
+    case QEvent::GraphicsSceneDrop:
+      target = _embeddedWidget->childAt(
+        static_cast<QGraphicsSceneDragDropEvent*>(event)->pos().toPoint());
+      break;
+
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+      target = QApplication::focusWidget();
+      break;
+
+    default:
+      return false;
+  }
+
+  for (QWidget* widget = target ? target : _embeddedWidget; widget;
+       widget = widget->parentWidget())
+  {
+    if (widget->property("readOnlyInteractive").toBool())
+      return false;
+
+    if (widget == _embeddedWidget)
+      break;
+  }
+
+  // the node, or the view, receives it instead
+  event->ignore();
+  return true;
+}
+
+
 void
 NodeGraphicsObject::
 mousePressEvent(QGraphicsSceneMouseEvent * event)
 {
   if(_locked) return;
 
+  // nothing to edit: the view drags the scene
+  if (_scene.readOnly())
+  {
+    event->ignore();
+    return;
+  }
+
   // deselect all other items after this one is selected
   if (!isSelected() && event->modifiers() != Qt::ControlModifier)
   {
@@ -267,6 +521,9 @@ void
 NodeGraphicsObject::
 mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 {
+  if (_scene.readOnly())
+    return;
+
   auto & geom  = _node.nodeGeometry();
   auto & state = _node.nodeState();
 
@@ -276,7 +533,7 @@ mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 
     if (auto w = _node.nodeDataModel()->embeddedWidget())
     {
-      prepareGeometryChange();
+      setGeometryChanged();
 
       auto oldSize = w->size();
 
@@ -284,9 +541,12 @@ mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 
       w->setFixedSize(oldSize);
 
-      _proxyWidget->setMinimumSize(oldSize);
-      _proxyWidget->setMaximumSize(oldSize);
-      _proxyWidget->setPos(geom.widgetPosition());
+      if (_proxyWidget)
+      {
+        _proxyWidget->setMinimumSize(oldSize);
+        _proxyWidget->setMaximumSize(oldSize);
+        _proxyWidget->setPos(geom.widgetPosition());
+      }
 
       geom.recalculateSize();
       update();
@@ -318,6 +578,12 @@ void
 NodeGraphicsObject::
 mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
 {
+  if (_scene.readOnly())
+  {
+    _double_clicked = false;
+    return;
+  }
+
   if( _double_clicked )
   {
     event->setModifiers(event->modifiers() | Qt::ControlModifier);
@@ -368,7 +634,7 @@ hoverEnterEvent(QGraphicsSceneHoverEvent * event)
   setZValue(1.0);
 
   _node.nodeGeometry().setHovered(true);
-  update();
+  updateBoundary();
   _scene.nodeHovered(node(), event->screenPos());
   event->accept();
 }
@@ -379,7 +645,7 @@ NodeGraphicsObject::
 hoverLeaveEvent(QGraphicsSceneHoverEvent * event)
 {
   _node.nodeGeometry().setHovered(false);
-  update();
+  updateBoundary();
   _scene.nodeHoverLeft(node());
   event->accept();
 }
@@ -412,7 +678,7 @@ NodeGraphicsObject::
 mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event)
 {
   QGraphicsItem::mouseDoubleClickEvent(event);
-  _double_clicked = true;
+  _double_clicked = !_scene.readOnly();
   emit _scene.nodeDoubleClicked(node());
 }
 
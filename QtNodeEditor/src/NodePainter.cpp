@@ -22,11 +22,26 @@ using QtNodes::NodeState;
 using QtNodes::NodeDataModel;
 using QtNodes::FlowScene;
 
+NodePainter::Detail
+NodePainter::
+detailFor(qreal levelOfDetail)
+{
+  if (levelOfDetail < 0.25)
+    return Detail::Flat;
+
+  if (levelOfDetail < 0.6)
+    return Detail::Caption;
+
+  return Detail::Full;
+}
+
+
 void
 NodePainter::
 paint(QPainter* painter,
       Node & node,
-      FlowScene const& scene)
+      FlowScene const& scene,
+      Detail detail)
 {
   NodeGeometry const& geom = node.nodeGeometry();
 
@@ -34,10 +49,23 @@ paint(QPainter* painter,
 
   NodeGraphicsObject const & graphicsObject = node.nodeGraphicsObject();
 
+  NodeDataModel const * model = node.nodeDataModel();
+
+  // the size computed when the node was painted in full detail is kept
+  if (detail != Detail::Full)
+  {
+    drawFlatRect(painter, geom, model, graphicsObject);
+
+    if (detail == Detail::Caption)
+    {
+      drawCaption(painter, geom, model);
+    }
+    return;
+  }
+
   geom.recalculateSize(painter->font());
 
   //--------------------------------------------
-  NodeDataModel const * model = node.nodeDataModel();
 
   drawNodeRect(painter, geom, model, graphicsObject);
 
@@ -59,12 +87,51 @@ paint(QPainter* painter,
 }
 
 
+static
+QRectF
+nodeBoundary(QtNodes::NodeGeometry const& geom, QtNodes::NodeStyle const& nodeStyle)
+{
+  float diam = nodeStyle.ConnectionPointDiameter;
+
+  return QRectF( -diam, -diam, 2.0 * diam + geom.width(), 2.0 * diam + geom.height());
+}
+
+static double const nodeBoundaryRadius = 3.0;
+
+
 void
 NodePainter::
 drawNodeRect(QPainter* painter,
              NodeGeometry const& geom,
              NodeDataModel const* model,
              NodeGraphicsObject const & graphicsObject)
+{
+  Q_UNUSED(graphicsObject);
+
+  NodeStyle const& nodeStyle = model->nodeStyle();
+
+  painter->setPen(Qt::NoPen);
+
+  QLinearGradient gradient(QPointF(0.0, 0.0),
+                           QPointF(2.0, geom.height()));
+
+  gradient.setColorAt(0.0, nodeStyle.GradientColor0);
+  gradient.setColorAt(0.03, nodeStyle.GradientColor1);
+  gradient.setColorAt(0.97, nodeStyle.GradientColor2);
+  gradient.setColorAt(1.0, nodeStyle.GradientColor3);
+
+  painter->setBrush(gradient);
+
+  painter->drawRoundedRect(nodeBoundary(geom, nodeStyle), nodeBoundaryRadius, nodeBoundaryRadius);
+}
+
+
+void
+NodePainter::
+drawNodeBoundary(QPainter* painter,
+                 NodeGeometry const& geom,
+                 NodeDataModel const* model,
+                 NodeGraphicsObject const & graphicsObject)
 {
   NodeStyle const& nodeStyle = model->nodeStyle();
 
@@ -82,24 +149,50 @@ drawNodeRect(QPainter* painter,
     QPen p(color, nodeStyle.PenWidth);
     painter->setPen(p);
   }
+  painter->setBrush(Qt::NoBrush);
 
-  QLinearGradient gradient(QPointF(0.0, 0.0),
-                           QPointF(2.0, geom.height()));
+  painter->drawRoundedRect(nodeBoundary(geom, nodeStyle), nodeBoundaryRadius, nodeBoundaryRadius);
+}
 
-  gradient.setColorAt(0.0, nodeStyle.GradientColor0);
-  gradient.setColorAt(0.03, nodeStyle.GradientColor1);
-  gradient.setColorAt(0.97, nodeStyle.GradientColor2);
-  gradient.setColorAt(1.0, nodeStyle.GradientColor3);
 
-  painter->setBrush(gradient);
+void
+NodePainter::
+drawFlatRect(QPainter* painter,
+             NodeGeometry const& geom,
+             NodeDataModel const* model,
+             NodeGraphicsObject const & graphicsObject)
+{
+  NodeStyle const& nodeStyle = model->nodeStyle();
 
-  float diam = nodeStyle.ConnectionPointDiameter;
+  painter->setPen(Qt::NoPen);
+  painter->setBrush(graphicsObject.isSelected() ? nodeStyle.SelectedBoundaryColor
+                                                : nodeStyle.GradientColor1);
 
-  QRectF boundary( -diam, -diam, 2.0 * diam + geom.width(), 2.0 * diam + geom.height());
+  painter->drawRect(QRectF(0, 0, geom.width(), geom.height()));
+}
 
-  double const radius = 3.0;
 
-  painter->drawRoundedRect(boundary, radius, radius);
+void
+NodePainter::
+drawCaption(QPainter* painter,
+            NodeGeometry const& geom,
+            NodeDataModel const* model)
+{
+  NodeStyle const& nodeStyle = model->nodeStyle();
+
+  QFont font = painter->font();
+  font.setBold(true);
+  // readable when zoomed out, the caption is larger than the labels
+  if (font.pointSizeF() > 0)
+    font.setPointSizeF(font.pointSizeF() * 2.0);
+  else
+    font.setPixelSize(font.pixelSize() * 2);
+  painter->setFont(font);
+  painter->setPen(nodeStyle.FontColor);
+
+  painter->drawText(QRectF(0, 0, geom.width(), geom.height()),
+                    Qt::AlignCenter | Qt::TextDontClip,
+                    model->name());
 }
 
 
@@ -237,9 +330,6 @@ drawEntryLabels(QPainter * painter,
                 NodeState const & state,
                 NodeDataModel const * model)
 {
-  QFontMetrics const & metrics =
-    painter->fontMetrics();
-
   for(PortType portType: {PortType::Out, PortType::In})
   {
     auto const &nodeStyle = model->nodeStyle();
@@ -258,8 +348,11 @@ drawEntryLabels(QPainter * painter,
         painter->setPen(nodeStyle.FontColor);
 
       QString s = model->dataType(portType, i).name;
+      if (s.isEmpty())
+        continue;
 
-      auto rect = metrics.boundingRect(s);
+      // measured by NodeGeometry::recalculateSize()
+      QRect rect = geom.portLabelRect(portType, i);
 
       p.setY(p.y() + rect.height() / 4.0);
 
@@ -21,12 +21,36 @@ public:
 
 public:
 
+  /// How much of a node is painted, depending on the zoom: a flat rect when
+  /// it is a few pixels wide, its name at mid zoom, everything when close.
+  enum class Detail { Flat, Caption, Full };
+
+  /// levelOfDetail as QStyleOptionGraphicsItem::levelOfDetailFromTransform()
+  static
+  Detail
+  detailFor(qreal levelOfDetail);
+
   static
   void
   paint(QPainter* painter,
         Node& node,
-        FlowScene const& scene);
+        FlowScene const& scene,
+        Detail detail = Detail::Full);
 
+  static
+  void
+  drawFlatRect(QPainter* painter,
+               NodeGeometry const& geom,
+               NodeDataModel const* model,
+               NodeGraphicsObject const & graphicsObject);
+
+  static
+  void
+  drawCaption(QPainter* painter,
+              NodeGeometry const& geom,
+              NodeDataModel const* model);
+
+  /// The body of the node, without its boundary
   static
   void
   drawNodeRect(QPainter* painter,
@@ -34,6 +58,15 @@ public:
                NodeDataModel const* model,
                NodeGraphicsObject const & graphicsObject);
 
+  /// The boundary depends on the style, the selection and the hovering: it
+  /// is painted by a child item, so that the cached body is not repainted
+  static
+  void
+  drawNodeBoundary(QPainter* painter,
+                   NodeGeometry const& geom,
+                   NodeDataModel const* model,
+                   NodeGraphicsObject const & graphicsObject);
+
   static
   void
   drawEntryLabels(QPainter* painter,
@@ -0,0 +1,71 @@
+#include "PaintProfiler.hpp"
+
+using QtNodes::PaintProfiler;
+
+static bool profilerEnabled = false;
+
+static PaintProfiler::Totals profilerTotals;
+
+
+PaintProfiler::Totals::
+Totals()
+{
+  for (int i = 0; i < CategoriesCount; ++i)
+  {
+    nsecs[i] = 0;
+    count[i] = 0;
+  }
+}
+
+
+void
+PaintProfiler::
+setEnabled(bool enabled)
+{
+  profilerEnabled = enabled;
+  profilerTotals = Totals();
+}
+
+
+bool
+PaintProfiler::
+enabled()
+{
+  return profilerEnabled;
+}
+
+
+char const*
+PaintProfiler::
+categoryName(Category category)
+{
+  switch (category)
+  {
+    case Nodes:        return "nodes";
+    case Connections:  return "connections";
+    case Widgets:      return "widgets";
+    case StatusUpdate: return "status update";
+    case Layout:       return "layout";
+    case Background:   return "background";
+    default:           return "";
+  }
+}
+
+
+void
+PaintProfiler::
+add(Category category, qint64 nsecs)
+{
+  profilerTotals.nsecs[category] += nsecs;
+  profilerTotals.count[category]++;
+}
+
+
+PaintProfiler::Totals
+PaintProfiler::
+take()
+{
+  Totals totals = profilerTotals;
+  profilerTotals = Totals();
+  return totals;
+}
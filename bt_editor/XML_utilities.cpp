@@ -2,11 +2,15 @@
 #include "utils.h"
 
 #include "models/SubtreeNodeModel.hpp"
+#include "trace_recorder.h"
 #include <behaviortree_cpp_v3/basic_types.h>
 #include <behaviortree_cpp_v3/xml_parsing.h>
 #include <QMessageBox>
 #include <QtDebug>
 #include <QLineEdit>
+#include <QXmlStreamReader>
+#include <QSaveFile>
+#include <QMap>
 #include <unordered_map>
 
 using namespace QtNodes;
@@ -21,6 +25,7 @@ NodeModel buildTreeNodeModelFromXML(const QDomElement& node)
     {
         ID = QString(node.attribute("ID"));
     }
+    ID = InternString( ID );
 
     const auto node_type = BT::convertFromString<BT::NodeType>(tag_name.toStdString());
 
@@ -40,7 +45,7 @@ NodeModel buildTreeNodeModelFromXML(const QDomElement& node)
         {
             PortModel port_model;
             port_model.direction = PortDirection::INOUT;
-            ports_list.insert( { attr_name, std::move(port_model)} );
+            ports_list.insert( { InternString( attr_name ), std::move(port_model)} );
         }
     }
     // this is used for ports inside the <TreeNodesModel> tag
@@ -61,7 +66,7 @@ NodeModel buildTreeNodeModelFromXML(const QDomElement& node)
 
             if( port_element.hasAttribute("type") )
             {
-                port_model.type_name = port_element.attribute("type");
+                port_model.type_name = InternString( port_element.attribute("type") );
             }
             if( port_element.hasAttribute("default") )
             {
@@ -70,7 +75,7 @@ NodeModel buildTreeNodeModelFromXML(const QDomElement& node)
 
             if( port_element.hasAttribute("name") )
             {
-                auto attr_name = port_element.attribute("name");
+                auto attr_name = InternString( port_element.attribute("name") );
                 ports_list.insert( { attr_name, std::move(port_model)} );
             }
         }
@@ -188,9 +193,17 @@ bool VerifyXML(QDomDocument &doc,
                const std::vector<QString>& registered_ID,
                std::vector<QString>& error_messages)
 {
+    return VerifyXML( doc.toString(), registered_ID, error_messages );
+}
+
+bool VerifyXML(const QString& xml_string,
+               const std::vector<QString>& registered_ID,
+               std::vector<QString>& error_messages)
+{
+    TraceScope trace( "xml", "VerifyXML" );
     error_messages.clear();
     try {
-        std::string xml_text = doc.toString().toStdString();
+        std::string xml_text = xml_string.toStdString();
         std::unordered_map<std::string, BT::NodeType> registered_nodes;
         
         BT::NodeType node_type; 
@@ -243,3 +256,408 @@ QDomElement writePortModel(const QString& port_name, const PortModel& port, QDom
   }
   return port_element;
 }
+
+//------------------------------------------------------------------
+
+static void WriteAttributes(QXmlStreamWriter& stream, const QMap<QString, QString>& attributes)
+{
+    for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+    {
+        stream.writeAttribute( it.key(), it.value() );
+    }
+}
+
+void WriteTreeXml(QXmlStreamWriter& stream,
+                  const AbsBehaviorTree& tree,
+                  const AbstractTreeNode* node)
+{
+    const QString& registration_name = node->model.registration_ID;
+    QMap<QString, QString> attributes;
+    QString tag_name;
+
+    if( BuiltinNodeModels().count(registration_name) != 0)
+    {
+        tag_name = registration_name;
+    }
+    else{
+        tag_name = QString::fromStdString( toStr(node->model.type) );
+        attributes.insert( "ID", registration_name );
+    }
+
+    if( node->instance_name != registration_name )
+    {
+        attributes.insert( "name", node->instance_name );
+    }
+
+    // as the widgets of BehaviorTreeDataModel: one value for each port of the
+    // model, the default one if the tree has none
+    for (const auto& port_it: node->model.ports)
+    {
+        auto mapping_it = node->ports_mapping.find( port_it.first );
+        attributes.insert( port_it.first, (mapping_it != node->ports_mapping.end()) ?
+                               mapping_it->second : port_it.second.default_value );
+    }
+
+    stream.writeStartElement( tag_name );
+    WriteAttributes( stream, attributes );
+
+    // the children of an expanded subtree are not part of this tree
+    if( node->model.type != NodeType::SUBTREE )
+    {
+        for (int child_index: node->children_index)
+        {
+            WriteTreeXml( stream, tree, tree.node(child_index) );
+        }
+    }
+    stream.writeEndElement();
+}
+
+void WritePortModel(QXmlStreamWriter& stream,
+                    const QString& port_name,
+                    const PortModel& port)
+{
+    switch (port.direction)
+    {
+    case PortDirection::INPUT:
+        stream.writeStartElement("input_port");
+        break;
+    case PortDirection::OUTPUT:
+        stream.writeStartElement("output_port");
+        break;
+    case PortDirection::INOUT:
+        stream.writeStartElement("inout_port");
+        break;
+    }
+
+    QMap<QString, QString> attributes;
+    attributes.insert( "name", port_name );
+    if (port.type_name.isEmpty() == false)
+    {
+        attributes.insert( "type", port.type_name );
+    }
+    if (port.default_value.isEmpty() == false)
+    {
+        attributes.insert( "default", port.default_value );
+    }
+    WriteAttributes( stream, attributes );
+
+    if (!port.description.isEmpty())
+    {
+        stream.writeCharacters( port.description );
+    }
+    stream.writeEndElement();
+}
+
+QString WriteProjectToXML(const XMLProject &project)
+{
+    const char* COMMENT_SEPARATOR = " ////////// ";
+
+    QString output_string;
+    QXmlStreamWriter stream(&output_string);
+
+    stream.setAutoFormatting(true);
+    stream.setAutoFormattingIndent(4);
+
+    stream.writeStartDocument();
+    stream.writeStartElement("root");
+
+    if( project.main_tree.isEmpty() == false)
+    {
+        stream.writeAttribute("main_tree_to_execute", project.main_tree);
+    }
+
+    for (const auto& it: project.trees)
+    {
+        const AbsBehaviorTree& abs_tree = it.second;
+
+        stream.writeComment(COMMENT_SEPARATOR);
+        stream.writeStartElement("BehaviorTree");
+        stream.writeAttribute("ID", it.first);
+
+        if( abs_tree.nodesCount() > 0 )
+        {
+            auto abs_root = abs_tree.rootNode();
+            if( abs_root->children_index.size() == 1 &&
+                abs_root->model.registration_ID == "Root"  )
+            {
+                // mofe to the child of ROOT
+                abs_root = abs_tree.node( abs_root->children_index.front() );
+            }
+            WriteTreeXml( stream, abs_tree, abs_root );
+        }
+        stream.writeEndElement();
+    }
+    stream.writeComment(COMMENT_SEPARATOR);
+
+    stream.writeStartElement("TreeNodesModel");
+
+    for(const auto& tree_it: project.custom_models)
+    {
+        const auto& ID    = tree_it.first;
+        const auto& model = tree_it.second;
+
+        if( BuiltinNodeModels().count(ID) != 0 )
+        {
+            continue;
+        }
+
+        stream.writeStartElement( QString::fromStdString(toStr(model.type)) );
+        stream.writeAttribute("ID", ID);
+
+        for(const auto& port_it: model.ports)
+        {
+            WritePortModel( stream, port_it.first, port_it.second );
+        }
+        stream.writeEndElement();
+    }
+    stream.writeEndElement();
+    stream.writeComment(COMMENT_SEPARATOR);
+
+    stream.writeEndElement();
+    stream.writeEndDocument();
+
+    return output_string;
+}
+
+// The file is replaced only once completely written, so a crash never
+// leaves it half saved.
+QString WriteProjectFile(const XMLProject& project, const QString& filename)
+{
+    const QByteArray data = WriteProjectToXML( project ).toUtf8();
+
+    QSaveFile file(filename);
+    if( !file.open(QIODevice::WriteOnly) )
+    {
+        return file.errorString();
+    }
+    if( file.write(data) != data.size() )
+    {
+        const QString error = file.errorString();
+        file.cancelWriting();
+        return error;
+    }
+    if( !file.commit() )
+    {
+        return file.errorString();
+    }
+    return QString();
+}
+
+//------------------------------------------------------------------
+
+// as buildTreeNodeModelFromXML(), the reader being on the start element
+static NodeModel ReadNodeModel(QXmlStreamReader& reader, bool read_port_elements)
+{
+    const QString tag_name = reader.name().toString();
+    const QXmlStreamAttributes attributes = reader.attributes();
+
+    PortModels ports_list;
+    QString ID = tag_name;
+    if( attributes.hasAttribute("ID") )
+    {
+        ID = attributes.value("ID").toString();
+    }
+    ID = InternString( ID );
+
+    const auto node_type = BT::convertFromString<BT::NodeType>(tag_name.toStdString());
+
+    // this make sense for ports inside the <BehaviorTree> tag
+    for (const auto& attr: attributes)
+    {
+        if( attr.name() != "ID" && attr.name() != "name" )
+        {
+            PortModel port_model;
+            port_model.direction = PortDirection::INOUT;
+            ports_list.insert( { InternString( attr.name().toString() ), std::move(port_model)} );
+        }
+    }
+
+    // this is used for ports inside the <TreeNodesModel> tag
+    while( read_port_elements && reader.readNextStartElement() )
+    {
+        PortModel port_model;
+        if( reader.name() == "input_port" ){
+            port_model.direction = PortDirection::INPUT;
+        }
+        else if( reader.name() == "output_port" ){
+            port_model.direction = PortDirection::OUTPUT;
+        }
+        else if( reader.name() == "inout_port" ){
+            port_model.direction = PortDirection::INOUT;
+        }
+        else{
+            reader.skipCurrentElement();
+            continue;
+        }
+        const QXmlStreamAttributes port_attributes = reader.attributes();
+        if( port_attributes.hasAttribute("type") )
+        {
+            port_model.type_name = InternString( port_attributes.value("type").toString() );
+        }
+        if( port_attributes.hasAttribute("default") )
+        {
+            port_model.default_value = port_attributes.value("default").toString();
+        }
+        port_model.description = reader.readElementText( QXmlStreamReader::IncludeChildElements );
+
+        if( port_attributes.hasAttribute("name") )
+        {
+            ports_list.insert( { InternString( port_attributes.value("name").toString() ), std::move(port_model)} );
+        }
+    }
+
+    if( node_type == BT::NodeType::UNDEFINED )
+    {
+        return {};
+    }
+    return { node_type, ID, ports_list };
+}
+
+static void ReadTreeNode(QXmlStreamReader& reader,
+                         AbsBehaviorTree& tree,
+                         AbstractTreeNode* parent,
+                         NodeModels& tree_models)
+{
+    const QXmlStreamAttributes attributes = reader.attributes();
+
+    AbstractTreeNode tree_node;
+    tree_node.model.registration_ID = InternString( attributes.hasAttribute("ID") ?
+                attributes.value("ID").toString() : reader.name().toString() );
+
+    if( attributes.hasAttribute("name") )
+    {
+        tree_node.instance_name = InternString( attributes.value("name").toString() );
+    }
+    else{
+        tree_node.instance_name = tree_node.model.registration_ID;
+    }
+
+    for (const auto& attr: attributes)
+    {
+        if( attr.name() != "ID" && attr.name() != "name" )
+        {
+            tree_node.ports_mapping.insert( { InternString( attr.name().toString() ), attr.value().toString() } );
+        }
+    }
+
+    auto model = ReadNodeModel( reader, false );
+    if( model.type != NodeType::UNDEFINED &&
+        model.registration_ID.isEmpty() == false &&
+        tree_models.count(model.registration_ID) == 0)
+    {
+        tree_models.insert( {model.registration_ID, model} );
+    }
+
+    auto added_node = tree.addNode( parent, std::move(tree_node) );
+
+    while( reader.readNextStartElement() )
+    {
+        ReadTreeNode( reader, tree, added_node, tree_models );
+    }
+}
+
+XMLProject ReadProjectFromXML(const QString &xml_text)
+{
+    TraceScope trace( "xml", "ReadProjectFromXML" );
+    trace.setArgument( "characters", xml_text.size() );
+
+    XMLProject project;
+    project.root_node_found = false;
+
+    // models found inside the trees; those of <TreeNodesModel> have priority
+    NodeModels tree_models;
+
+    QXmlStreamReader reader( xml_text );
+
+    if( reader.readNextStartElement() )
+    {
+        if( reader.attributes().hasAttribute("main_tree_to_execute") )
+        {
+            project.main_tree = reader.attributes().value("main_tree_to_execute").toString();
+        }
+
+        while( reader.readNextStartElement() )
+        {
+            if( reader.name() == "TreeNodesModel" )
+            {
+                while( reader.readNextStartElement() )
+                {
+                    auto model = ReadNodeModel( reader, true );
+                    project.custom_models.insert( {model.registration_ID, model} );
+                }
+            }
+            else if( reader.name() == "BehaviorTree" )
+            {
+                QString tree_name("BehaviorTree");
+                if( reader.attributes().hasAttribute("ID") )
+                {
+                    tree_name = reader.attributes().value("ID").toString();
+                    if( project.main_tree.isEmpty() )  // valid when there is only one
+                    {
+                        project.main_tree = tree_name;
+                    }
+                }
+                AbsBehaviorTree tree;
+
+                // as in BuildTreeFromXML, only the first child is the tree
+                if( reader.readNextStartElement() )
+                {
+                    if( reader.name() == "Root" )
+                    {
+                        project.root_node_found = true;
+                        if( reader.readNextStartElement() )
+                        {
+                            ReadTreeNode( reader, tree, nullptr, tree_models );
+                        }
+                        while( reader.readNextStartElement() )
+                        {
+                            reader.skipCurrentElement();
+                        }
+                    }
+                    else{
+                        ReadTreeNode( reader, tree, nullptr, tree_models );
+                    }
+                    while( reader.readNextStartElement() )
+                    {
+                        reader.skipCurrentElement();
+                    }
+                }
+                project.trees.push_back( { tree_name, std::move(tree) } );
+            }
+            else{
+                reader.skipCurrentElement();
+            }
+        }
+    }
+
+    if( reader.hasError() )
+    {
+        throw std::runtime_error( QString("Error parsing XML (line %1): %2")
+                                  .arg( reader.lineNumber() )
+                                  .arg( reader.errorString() ).toStdString() );
+    }
+
+    for (const auto& it: tree_models)
+    {
+        project.custom_models.insert( it );
+    }
+    return project;
+}
+
+void ResolveTreeModels(AbsBehaviorTree &tree, const NodeModels &models)
+{
+    if( tree.nodesCount() == 0 )
+    {
+        throw std::runtime_error( "Found an empty <BehaviorTree>" );
+    }
+    for (auto& node: tree.nodes())
+    {
+        auto model_it = models.find( node.model.registration_ID );
+        if( model_it ==  models.end() )
+        {
+            throw std::runtime_error( (QString("This model has not been registered: ") +
+                                       node.model.registration_ID).toStdString() );
+        }
+        node.model = model_it->second;
+    }
+}
@@ -2,6 +2,7 @@
 #define XMLPARSERS_HPP
 
 #include <QDomDocument>
+#include <QXmlStreamWriter>
 #include "bt_editor_base.h"
 
 #include <nodes/Node>
@@ -21,9 +22,54 @@ bool VerifyXML(QDomDocument& doc,
                const std::vector<QString> &registered_ID,
                std::vector<QString> &error_messages);
 
+bool VerifyXML(const QString& xml_text,
+               const std::vector<QString> &registered_ID,
+               std::vector<QString> &error_messages);
+
+// Content of a project file, read in a single pass with QXmlStreamReader
+// instead of building a QDomDocument.
+struct XMLProject
+{
+    // main_tree_to_execute or, if missing, the first tree with an ID
+    QString main_tree;
+    // same as ReadTreeNodesModel()
+    NodeModels custom_models;
+    // in the order of the file. The model of each node has only its
+    // registration_ID: see ResolveTreeModels()
+    std::vector<std::pair<QString, AbsBehaviorTree>> trees;
+    // the deprecated <Root> was found inside a <BehaviorTree>
+    bool root_node_found;
+};
+
+// throws std::runtime_error if the XML is not well formed
+XMLProject ReadProjectFromXML(const QString& xml_text);
+
+// The whole file, as saved by Groot. It uses only its arguments, so it may be
+// called from any thread. The builtin models are not written.
+QString WriteProjectToXML(const XMLProject& project);
+
+// WriteProjectToXML() into the file, without leaving it half written if
+// interrupted. Returns the error, or an empty string. Any thread.
+QString WriteProjectFile(const XMLProject& project, const QString& filename);
+
+// the models of the nodes of a tree read by ReadProjectFromXML(), once the
+// custom models are registered. Throws if a model is missing.
+void ResolveTreeModels(AbsBehaviorTree& tree, const NodeModels& models);
+
 NodeModel buildTreeNodeModelFromXML(const QDomElement &node);
 
 QDomElement writePortModel(const QString &port_name, const PortModel &port, QDomDocument &doc);
 
+// Same content as RecursivelyCreateXml() and writePortModel(), written
+// directly to the stream with the attributes sorted by name: the canonical
+// form of the files saved by Groot.
+void WriteTreeXml(QXmlStreamWriter& stream,
+                  const AbsBehaviorTree& tree,
+                  const AbstractTreeNode* node);
+
+void WritePortModel(QXmlStreamWriter& stream,
+                    const QString& port_name,
+                    const PortModel& port);
+
 
 #endif // XMLPARSERS_HPP
@@ -0,0 +1,417 @@
+#include "batch_mode.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+#include "XML_utilities.hpp"
+#include "project_validator.h"
+#include "replay_log_analyzer.h"
+
+namespace {
+
+enum class BatchCommand { VALIDATE, NORMALIZE, STATS };
+
+struct BatchOptions
+{
+    BatchCommand command;
+    QString output_dir;
+    bool check;
+};
+
+struct BatchJob
+{
+    BatchJob(): failed(false), trees(0), nodes(0) {}
+
+    void error(const QString& message)
+    {
+        messages.push_back( QString("%1: error: %2").arg( filename, message ) );
+        failed = true;
+    }
+
+    void warning(const QString& message)
+    {
+        messages.push_back( QString("%1: warning: %2").arg( filename, message ) );
+    }
+
+    QString filename;
+    QStringList messages;
+    bool failed;
+    // for the total of the stats
+    size_t trees;
+    size_t nodes;
+};
+
+// the same steps as MainWindow::loadFromXML(), without building the scenes
+bool ReadProject(BatchJob& job, QByteArray& xml_data, XMLProject& project, NodeModels& models)
+{
+    QFile file( job.filename );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        job.error( file.errorString() );
+        return false;
+    }
+    xml_data = file.readAll();
+    const QString xml_text = QString::fromUtf8( xml_data );
+
+    models = BuiltinNodeModels();
+    std::vector<QString> registered_ID;
+    for (const auto& it: models)
+    {
+        registered_ID.push_back( it.first );
+    }
+
+    try{
+        project = ReadProjectFromXML( xml_text );
+
+        std::vector<QString> error_messages;
+        if( !VerifyXML( xml_text, registered_ID, error_messages ) )
+        {
+            for (const auto& err: error_messages)
+            {
+                job.error( err );
+            }
+            return false;
+        }
+
+        for (const auto& it: project.custom_models)
+        {
+            models[it.first] = it.second;
+        }
+        for (auto& it: project.trees)
+        {
+            ResolveTreeModels( it.second, models );
+        }
+    }
+    catch( std::runtime_error& err)
+    {
+        job.error( err.what() );
+        return false;
+    }
+
+    if( project.root_node_found )
+    {
+        job.warning( "Please remove the node <Root> from your <BehaviorTree>" );
+    }
+    return true;
+}
+
+void Validate(BatchJob& job, const XMLProject& project, const NodeModels& models)
+{
+    std::vector<TabSnapshot> tabs;
+    for (const auto& it: project.trees)
+    {
+        TabSnapshot tab;
+        tab.tab_name = it.first;
+        tab.tree = std::make_shared<const AbsBehaviorTree>( it.second );
+        tabs.push_back( std::move(tab) );
+    }
+
+    const ProjectValidator validator = ProjectValidator::validate( tabs, models, ProjectValidator() );
+    for (const auto& problem: validator.problems())
+    {
+        QString message = QString("[%1] ").arg( problem.node.tab_name );
+        if( !problem.node.registration_ID.isEmpty() )
+        {
+            message += QString("%1 (%2): ").arg( problem.node.instance_name,
+                                                 problem.node.registration_ID );
+        }
+        message += problem.message;
+
+        if( problem.severity == ProjectValidator::Problem::ERROR )
+        {
+            job.error( message );
+        }
+        else{
+            job.warning( message );
+        }
+    }
+}
+
+void Normalize(BatchJob& job, const QByteArray& xml_data,
+               XMLProject& project, const BatchOptions& options)
+{
+    // as saved from the tabs, by name
+    std::stable_sort( project.trees.begin(), project.trees.end(),
+                      [](const std::pair<QString, AbsBehaviorTree>& a,
+                         const std::pair<QString, AbsBehaviorTree>& b)
+    {
+        return a.first < b.first;
+    });
+    const bool normalized = ( WriteProjectToXML( project ).toUtf8() == xml_data );
+
+    if( options.check )
+    {
+        if( !normalized )
+        {
+            job.error( "The file is not normalized" );
+        }
+        return;
+    }
+
+    QString output_filename = job.filename;
+    if( !options.output_dir.isEmpty() )
+    {
+        output_filename = QDir( options.output_dir ).filePath( QFileInfo(job.filename).fileName() );
+    }
+    else if( normalized )
+    {
+        return;
+    }
+    const QString error = WriteProjectFile( project, output_filename );
+    if( !error.isEmpty() )
+    {
+        job.error( QString("Can not write %1: %2").arg( output_filename, error ) );
+    }
+}
+
+void Stats(BatchJob& job, const XMLProject& project)
+{
+    std::map<NodeType, size_t> types;
+    size_t depth = 0;
+    for (const auto& it: project.trees)
+    {
+        const AbsBehaviorTree& tree = it.second;
+        job.nodes += tree.nodesCount();
+        for (const auto& node: tree.constNodes())
+        {
+            types[node.model.type]++;
+        }
+
+        std::vector<std::pair<const AbstractTreeNode*, size_t>> stack;
+        if( tree.nodesCount() > 0 )
+        {
+            stack.push_back( { tree.rootNode(), 1 } );
+        }
+        while( !stack.empty() )
+        {
+            const auto top = stack.back();
+            stack.pop_back();
+            depth = std::max( depth, top.second );
+            for (int child: top.first->children_index)
+            {
+                stack.push_back( { tree.node(child), top.second + 1 } );
+            }
+        }
+    }
+    job.trees = project.trees.size();
+
+    QStringList type_counts;
+    for (const auto& it: types)
+    {
+        type_counts.push_back( QString("%1 %2").arg( QString::fromStdString( BT::toStr(it.first) ) )
+                                               .arg( it.second ) );
+    }
+    size_t custom_models = 0;
+    for (const auto& it: project.custom_models)
+    {
+        custom_models += BuiltinNodeModels().count( it.first ) == 0 ? 1 : 0;
+    }
+
+    job.messages.push_back( QString("%1: %2 trees, %3 nodes (%4), depth %5, %6 custom models")
+                            .arg( job.filename )
+                            .arg( job.trees )
+                            .arg( job.nodes )
+                            .arg( type_counts.join(", ") )
+                            .arg( depth )
+                            .arg( custom_models ) );
+}
+
+void RunJob(BatchJob& job, const BatchOptions& options)
+{
+    QByteArray xml_data;
+    XMLProject project;
+    NodeModels models;
+    if( !ReadProject( job, xml_data, project, models ) )
+    {
+        return;
+    }
+
+    switch( options.command )
+    {
+    case BatchCommand::VALIDATE:
+        Validate( job, project, models );
+        break;
+    case BatchCommand::NORMALIZE:
+        Normalize( job, xml_data, project, options );
+        break;
+    case BatchCommand::STATS:
+        Stats( job, project );
+        break;
+    }
+}
+
+}
+
+int RunBatchMode(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Groot in batch mode: the files are processed without any window");
+    parser.addHelpOption();
+
+    QCommandLineOption batch_option(QStringList() << "batch",
+                                    "Run one of these commands: [validate,normalize,stats]",
+                                    "command");
+    parser.addOption(batch_option);
+    QCommandLineOption output_option(QStringList() << "output",
+                                     "normalize: write the files into this directory instead of in place",
+                                     "directory");
+    parser.addOption(output_option);
+    QCommandLineOption check_option(QStringList() << "check",
+                                    "normalize: do not write the files, fail if they are not normalized");
+    parser.addOption(check_option);
+    parser.addPositionalArgument("files", "The BehaviorTree files (*.xml)", "files...");
+
+    parser.process( app );
+
+    BatchOptions options;
+    const QString command = parser.value(batch_option);
+    if( command == "validate" )
+    {
+        options.command = BatchCommand::VALIDATE;
+    }
+    else if( command == "normalize" )
+    {
+        options.command = BatchCommand::NORMALIZE;
+    }
+    else if( command == "stats" )
+    {
+        options.command = BatchCommand::STATS;
+    }
+    else{
+        std::cerr << "wrong command passed to --batch. Use one of these: validate / normalize / stats"
+                  << std::endl;
+        return 1;
+    }
+    options.output_dir = parser.value(output_option);
+    options.check = parser.isSet(check_option);
+
+    const QStringList filenames = parser.positionalArguments();
+    if( filenames.isEmpty() )
+    {
+        std::cerr << "no file passed to --batch " << command.toStdString() << std::endl;
+        return 1;
+    }
+    if( !options.output_dir.isEmpty() && !QDir().mkpath( options.output_dir ) )
+    {
+        std::cerr << "can not create the directory " << options.output_dir.toStdString() << std::endl;
+        return 1;
+    }
+
+    std::vector<BatchJob> jobs( size_t(filenames.size()) );
+    for (int i = 0; i < filenames.size(); i++)
+    {
+        jobs[i].filename = filenames[i];
+    }
+    // initialized once, before the threads read it
+    BuiltinNodeModels();
+    QtConcurrent::blockingMap( jobs, [&options](BatchJob& job)
+    {
+        RunJob( job, options );
+    });
+
+    size_t failed = 0;
+    size_t trees = 0;
+    size_t nodes = 0;
+    for (const auto& job: jobs)
+    {
+        for (const auto& message: job.messages)
+        {
+            std::cout << message.toStdString() << std::endl;
+        }
+        failed += job.failed ? 1 : 0;
+        trees += job.trees;
+        nodes += job.nodes;
+    }
+    if( options.command == BatchCommand::STATS )
+    {
+        std::cout << "total: " << jobs.size() << " files, " << trees << " trees, "
+                  << nodes << " nodes" << std::endl;
+    }
+    if( failed > 0 )
+    {
+        std::cerr << failed << " of " << jobs.size() << " files failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int RunLogAnalyzer(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Groot log analyzer: the statistics of the nodes of replay logs");
+    parser.addHelpOption();
+
+    QCommandLineOption analyze_option(QStringList() << "analyze-log",
+                                      "Analyze the logs passed as arguments");
+    parser.addOption(analyze_option);
+    QCommandLineOption format_option(QStringList() << "format",
+                                     "One of these formats: [csv,json] (defaults to csv)",
+                                     "format", "csv");
+    parser.addOption(format_option);
+    QCommandLineOption output_option(QStringList() << "output",
+                                     "Write into this file instead of the standard output",
+                                     "file");
+    parser.addOption(output_option);
+    parser.addPositionalArgument("logs", "The log files (*.fbl *.fblz)", "logs...");
+
+    parser.process( app );
+
+    const QString format = parser.value(format_option);
+    if( format != "csv" && format != "json" )
+    {
+        std::cerr << "wrong format passed to --format. Use one of these: csv / json" << std::endl;
+        return 1;
+    }
+    const QStringList filenames = parser.positionalArguments();
+    if( filenames.isEmpty() )
+    {
+        std::cerr << "no log passed to --analyze-log" << std::endl;
+        return 1;
+    }
+
+    std::vector<ReplayLogAnalysis> logs( size_t(filenames.size()) );
+    for (int i = 0; i < filenames.size(); i++)
+    {
+        logs[i].filename = filenames[i];
+    }
+    QtConcurrent::blockingMap( logs, [](ReplayLogAnalysis& log)
+    {
+        log = AnalyzeReplayLog( log.filename );
+    });
+
+    size_t failed = 0;
+    for (const auto& log: logs)
+    {
+        if( !log.error.isEmpty() )
+        {
+            std::cerr << log.filename.toStdString() << ": error: "
+                      << log.error.toStdString() << std::endl;
+            failed++;
+        }
+    }
+
+    const QByteArray output = ( format == "json" ) ? ReplayLogAnalysisToJson( logs ) :
+                                                     ReplayLogAnalysisToCsv( logs );
+    if( parser.isSet(output_option) )
+    {
+        QFile file( parser.value(output_option) );
+        if( !file.open(QIODevice::WriteOnly) || file.write( output ) != output.size() )
+        {
+            std::cerr << "can not write " << parser.value(output_option).toStdString()
+                      << ": " << file.errorString().toStdString() << std::endl;
+            return 1;
+        }
+    }
+    else{
+        std::cout.write( output.constData(), output.size() );
+        std::cout.flush();
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+#ifndef BATCH_MODE_H
+#define BATCH_MODE_H
+
+#include <QCoreApplication>
+
+// groot --batch <command> [--output <dir>] [--check] files...
+//
+//  validate   the same checks as when the file is loaded, then those of
+//             the Problems panel
+//  normalize  write the file as Groot saves it: in place, into --output,
+//             or with --check without writing, failing if it would change
+//  stats      the trees, the nodes by type and the depth of each file
+//
+// Nothing is shown: it runs with a QCoreApplication, the files in parallel
+// on the thread pool, and prints one line per message in the order of the
+// files. Returns the exit code: 1 if a file failed.
+int RunBatchMode(QCoreApplication& app);
+
+// groot --analyze-log [--format csv|json] [--output <file>] logs...
+//
+// The statistics of each log (.fbl or .fblz), see AnalyzeReplayLog(): the
+// logs are read in parallel on the thread pool, streamed without keeping
+// their transitions. Returns 1 if a log could not be read.
+int RunLogAnalyzer(QCoreApplication& app);
+
+#endif // BATCH_MODE_H
@@ -1,75 +1,148 @@
 #include "bt_editor_base.h"
 #include <behaviortree_cpp_v3/decorators/subtree_node.h>
 #include <QDebug>
+#include <QDataStream>
+#include <QMutex>
+#include <QSet>
+#include <cstring>
+
+QString InternString(const QString &str)
+{
+    static QMutex mutex;
+    static QSet<QString> table;
+
+    QMutexLocker lock( &mutex );
+    auto it = table.find( str );
+    if( it == table.end() )
+    {
+        it = table.insert( str );
+    }
+    return *it;
+}
+
+AbsBehaviorTree::AbsBehaviorTree():
+    _d( new Data )
+{
+}
 
 void AbsBehaviorTree::clear()
 {
-    _nodes.resize(0);
+    if( _d->ref.load() == 1 )
+    {
+        _d->nodes.resize(0);
+    }
+    else{
+        // the copies keep the nodes
+        _d = new Data;
+    }
+    _index = SearchIndex();
+    _hashes.clear();
 }
 
 
 AbsBehaviorTree::~AbsBehaviorTree()
 {
-    clear();
 }
 
 AbstractTreeNode *AbsBehaviorTree::rootNode()
 {
-    if( _nodes.empty() ) return nullptr;
-    return &_nodes.front();
+    if( constNodes().empty() ) return nullptr;
+    invalidate();
+    return &_d->nodes.front();
 }
 
 const AbstractTreeNode *AbsBehaviorTree::rootNode() const
 {
-    if( _nodes.empty() ) return nullptr;
-    return &_nodes.front();
+    if( _d->nodes.empty() ) return nullptr;
+    return &_d->nodes.front();
 }
 
-
-std::vector<const AbstractTreeNode*> AbsBehaviorTree::findNodes(const QString &instance_name)
+void AbsBehaviorTree::indexNode(const AbstractTreeNode &node)
 {
-    std::vector<const AbstractTreeNode*> out;
-    out.reserve( 4 );
-
-    for( const auto& node: _nodes)
+    _index.by_name[ node.instance_name ].push_back( node.index );
+    _index.by_model[ node.model.registration_ID ].push_back( node.index );
+    for (const auto& port_it: node.ports_mapping)
     {
-        if( node.instance_name == instance_name)
+        auto& indices = _index.by_port_value[ port_it.second ];
+        // two ports of the node may share the same value
+        if( indices.empty() || indices.back() != node.index )
         {
-            out.push_back( &node );
+            indices.push_back( node.index );
         }
     }
-    return out;
 }
 
-const AbstractTreeNode* AbsBehaviorTree::findFirstNode(const QString &instance_name)
+std::vector<const AbstractTreeNode*> AbsBehaviorTree::findIndexed(
+        const QHash<QString, std::vector<int>> SearchIndex::* table, const QString &key)
 {
-    for( const auto& node: _nodes)
+    if( !_index.valid )
     {
-        if( node.instance_name == instance_name)
+        _index = SearchIndex();
+        for( const auto& node: constNodes())
         {
-            return ( &node );
+            indexNode( node );
         }
+        _index.valid = true;
     }
-    return nullptr;
+
+    std::vector<const AbstractTreeNode*> out;
+    auto it = (_index.*table).find( key );
+    if( it != (_index.*table).end() )
+    {
+        out.reserve( it->size() );
+        for (int index: *it)
+        {
+            out.push_back( &constNodes()[index] );
+        }
+    }
+    return out;
 }
 
+std::vector<const AbstractTreeNode*> AbsBehaviorTree::findNodes(const QString &instance_name)
+{
+    return findIndexed( &SearchIndex::by_name, instance_name );
+}
+
+const AbstractTreeNode* AbsBehaviorTree::findFirstNode(const QString &instance_name)
+{
+    auto nodes = findNodes( instance_name );
+    return nodes.empty() ? nullptr : nodes.front();
+}
+
+std::vector<const AbstractTreeNode*> AbsBehaviorTree::findNodesByModel(const QString &registration_ID)
+{
+    return findIndexed( &SearchIndex::by_model, registration_ID );
+}
+
+std::vector<const AbstractTreeNode*> AbsBehaviorTree::findNodesByPortValue(const QString &value)
+{
+    return findIndexed( &SearchIndex::by_port_value, value );
+}
 
 
 AbstractTreeNode* AbsBehaviorTree::addNode(AbstractTreeNode* parent,
                                            AbstractTreeNode && new_node )
 {
-    int index = _nodes.size();
+    int index = constNodes().size();
     new_node.index = index;
     if( parent )
     {
-        _nodes.push_back( std::move(new_node) );
-        parent->children_index.push_back( index );
+        // parent may be in the nodes shared with a copy: found again by
+        // index, once detached
+        const int parent_index = parent->index;
+        _d->nodes.push_back( std::move(new_node) );
+        _d->nodes[parent_index].children_index.push_back( index );
     }
     else{
-        _nodes.clear();
-        _nodes.push_back(new_node);
+        clear();
+        _d->nodes.push_back(new_node);
     }
-    return &_nodes.back();
+    _hashes.clear();
+    if( _index.valid )
+    {
+        indexNode( _d->nodes.back() );
+    }
+    return &_d->nodes.back();
 }
 
 void AbsBehaviorTree::debugPrint() const
@@ -92,7 +165,7 @@ void AbsBehaviorTree::debugPrint() const
 
         for(int index: node->children_index)
         {
-            auto child_node = &_nodes[index];
+            auto child_node = &constNodes()[index];
             recursiveStep( child_node, indent+1);
         }
     };
@@ -101,13 +174,101 @@ void AbsBehaviorTree::debugPrint() const
 
 }
 
+// FNV-1a and the combination of boost::hash_combine, on 64 bits
+static quint64 HashCombine(quint64 seed, quint64 value)
+{
+    return seed ^ ( value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2) );
+}
+
+static quint64 HashString(const QString& str)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    const ushort* data = str.utf16();
+    for (int i = 0; i < str.size(); i++)
+    {
+        hash = ( hash ^ data[i] ) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static quint64 HashReal(qreal value)
+{
+    double d = value + 0.0; // the same hash for 0.0 and -0.0
+    quint64 bits;
+    memcpy( &bits, &d, sizeof(bits) );
+    return bits;
+}
+
+quint64 AbsBehaviorTree::hash() const
+{
+    const NodesVector& nodes = constNodes();
+    if( nodes.empty() )
+    {
+        return 0;
+    }
+    if( _hashes.size() == nodes.size() )
+    {
+        return _hashes.front();
+    }
+    _hashes.assign( nodes.size(), 0 );
+
+    // post-order: the children before their parent. The indices are checked,
+    // the trees being editable from outside
+    std::vector<char> visited( nodes.size(), 0 );
+    std::vector<std::pair<int, size_t>> stack( 1, { 0, 0 } );
+    visited[0] = 1;
+    while( !stack.empty() )
+    {
+        const AbstractTreeNode& node = nodes[ stack.back().first ];
+        size_t& next_child = stack.back().second;
+        if( next_child < node.children_index.size() )
+        {
+            const int child = node.children_index[ next_child++ ];
+            if( child >= 0 && size_t(child) < nodes.size() && !visited[child] )
+            {
+                visited[child] = 1;
+                stack.push_back( { child, 0 } );
+            }
+            continue;
+        }
+
+        quint64 hash = HashString( node.model.registration_ID );
+        hash = HashCombine( hash, HashString( node.instance_name ) );
+        hash = HashCombine( hash, quint64( node.status ) );
+        hash = HashCombine( hash, HashReal( node.size.width() ) );
+        hash = HashCombine( hash, HashReal( node.size.height() ) );
+        for (const auto& port_it: node.ports_mapping)
+        {
+            hash = HashCombine( hash, HashString( port_it.first ) );
+            hash = HashCombine( hash, HashString( port_it.second ) );
+        }
+        hash = HashCombine( hash, node.children_index.size() );
+        for (int child: node.children_index)
+        {
+            const bool valid = child >= 0 && size_t(child) < nodes.size();
+            hash = HashCombine( hash, valid ? _hashes[child] : quint64(child) );
+        }
+        _hashes[ stack.back().first ] = hash;
+        stack.pop_back();
+    }
+    return _hashes.front();
+}
+
 bool AbsBehaviorTree::operator ==(const AbsBehaviorTree &other) const
 {
-    if( _nodes.size() != other._nodes.size() ) return false;
+    if( _d == other._d ) return true;
+
+    if( constNodes().size() != other.constNodes().size() ) return false;
 
-    for (size_t index = 0; index < _nodes.size(); index++)
+    if( hash() != other.hash() ) return false;
+
+    for (size_t index = 0; index < constNodes().size(); index++)
     {
-        if( _nodes[index] != other._nodes[index]) return false;
+        if( constNodes()[index] != other.constNodes()[index] ||
+            constNodes()[index].children_index != other.constNodes()[index].children_index )
+        {
+            return false;
+        }
     }
     return true;
 }
@@ -139,7 +300,8 @@ bool AbstractTreeNode::operator ==(const AbstractTreeNode &other) const
             status == other.status &&
             size == other.size &&
           // temporary removed  pos == other.pos &&
-            instance_name == other.instance_name;
+            instance_name == other.instance_name &&
+            ports_mapping == other.ports_mapping;
 }
 
 bool NodeModel::operator ==(const NodeModel &other) const
@@ -172,14 +334,14 @@ bool NodeModel::operator ==(const NodeModel &other) const
 NodeModel &NodeModel::operator =(const BT::TreeNodeManifest &src)
 {
     this->type = src.type;
-    this->registration_ID = QString::fromStdString(src.registration_ID);
+    this->registration_ID = InternString( QString::fromStdString(src.registration_ID) );
     for (const auto& port_it: src.ports)
     {
         const auto& port_name = port_it.first;
         const auto& bt_port = port_it.second;
         PortModel port_model;
         port_model = bt_port;
-        this->ports.insert( { QString::fromStdString(port_name), std::move(port_model) } );
+        this->ports.insert( { InternString( QString::fromStdString(port_name) ), std::move(port_model) } );
     }
     return *this;
 }
@@ -217,7 +379,97 @@ PortModel &PortModel::operator =(const BT::PortInfo &src)
 {
     this->direction = src.direction();
     this->description = QString::fromStdString(src.description());
-    this->type_name = QString::fromStdString(BT::demangle(src.type()));
+    this->type_name = InternString( QString::fromStdString(BT::demangle(src.type())) );
     this->default_value = QString::fromStdString( src.defaultValue());
     return *this;
 }
+
+//--------------------------------
+void WriteModelToStream(QDataStream& stream, const NodeModel& model)
+{
+    stream << qint32(model.type) << model.registration_ID << quint32(model.ports.size());
+    for (const auto& it: model.ports)
+    {
+        const PortModel& port = it.second;
+        stream << it.first << port.type_name << qint32(port.direction)
+               << port.description << port.default_value;
+    }
+}
+
+NodeModel ReadModelFromStream(QDataStream& stream)
+{
+    NodeModel model;
+    qint32 type;
+    quint32 ports_count;
+    stream >> type >> model.registration_ID >> ports_count;
+    model.type = NodeType(type);
+    model.registration_ID = InternString( model.registration_ID );
+
+    for (quint32 i = 0; i < ports_count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString name;
+        PortModel port;
+        qint32 direction;
+        stream >> name >> port.type_name >> direction >> port.description >> port.default_value;
+        port.direction = PortDirection(direction);
+        port.type_name = InternString( port.type_name );
+        model.ports.insert( { InternString( name ), port } );
+    }
+    return model;
+}
+
+void WriteTreeToStream(QDataStream& stream, const AbsBehaviorTree& tree)
+{
+    stream << quint32(tree.nodesCount());
+    for (const auto& node: tree.nodes())
+    {
+        WriteModelToStream( stream, node.model );
+        stream << quint32(node.ports_mapping.size());
+        for (const auto& it: node.ports_mapping)
+        {
+            stream << it.first << it.second;
+        }
+        stream << qint32(node.index) << node.instance_name << node.size << node.pos;
+        stream << quint32(node.children_index.size());
+        for (int child: node.children_index)
+        {
+            stream << qint32(child);
+        }
+    }
+}
+
+AbsBehaviorTree ReadTreeFromStream(QDataStream& stream)
+{
+    AbsBehaviorTree tree;
+    quint32 nodes_count;
+    stream >> nodes_count;
+
+    for (quint32 n = 0; n < nodes_count && stream.status() == QDataStream::Ok; n++)
+    {
+        AbstractTreeNode node;
+        node.model = ReadModelFromStream( stream );
+
+        quint32 mapping_count;
+        stream >> mapping_count;
+        for (quint32 i = 0; i < mapping_count && stream.status() == QDataStream::Ok; i++)
+        {
+            QString name, value;
+            stream >> name >> value;
+            node.ports_mapping.insert( { InternString( name ), value } );
+        }
+
+        qint32 index;
+        quint32 children_count;
+        stream >> index >> node.instance_name >> node.size >> node.pos >> children_count;
+        node.index = index;
+        node.instance_name = InternString( node.instance_name );
+        for (quint32 i = 0; i < children_count && stream.status() == QDataStream::Ok; i++)
+        {
+            qint32 child;
+            stream >> child;
+            node.children_index.push_back( child );
+        }
+        tree.nodes().push_back( std::move(node) );
+    }
+    return tree;
+}
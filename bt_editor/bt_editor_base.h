@@ -4,6 +4,9 @@
 #include <QString>
 #include <QPointF>
 #include <QSizeF>
+#include <QDataStream>
+#include <QHash>
+#include <QSharedData>
 #include <map>
 #include <unordered_map>
 #include <nodes/Node>
@@ -16,6 +19,13 @@ using BT::PortDirection;
 
 typedef std::map<QString, QString> PortsMapping;
 
+// Registration IDs, instance names, port names and types repeat a lot in a
+// large project. The strings returned by InternString() come from a global
+// table, so that the equal strings share their data: the copies take no
+// memory and comparing two of them doesn't look at the characters (QString
+// compares the pointers first). Thread safe.
+QString InternString(const QString& str);
+
 // alternative type, similar to BT::PortInfo
 struct PortModel
 {
@@ -86,36 +96,55 @@ struct AbstractTreeNode
     }
 };
 
+// The nodes are implicitly shared, as the Qt containers: copying a tree is
+// free, and the copy detaches on the first non-const access. As with the Qt
+// containers, a pointer to a node is not valid anymore once a copy of its
+// tree is made or destroyed.
 class AbsBehaviorTree
 {
 public:
 
     typedef std::deque<AbstractTreeNode> NodesVector;
 
-    AbsBehaviorTree() {}
+    AbsBehaviorTree();
 
     ~AbsBehaviorTree();
 
     size_t nodesCount() const {
-        return _nodes.size();
+        return _d->nodes.size();
     }
 
-    const NodesVector& nodes() const { return _nodes; }
+    const NodesVector& nodes() const { return _d->nodes; }
 
-    NodesVector& nodes() { return _nodes; }
+    // the nodes may be edited through the non-const accessors: they detach
+    // the nodes and drop the search index and the hashes
+    NodesVector& nodes() { invalidate(); return _d->nodes; }
 
-    const AbstractTreeNode* node(size_t index) const { return &_nodes.at(index); }
+    const AbstractTreeNode* node(size_t index) const { return &_d->nodes.at(index); }
 
-    AbstractTreeNode* node(size_t index) { return &_nodes.at(index); }
+    AbstractTreeNode* node(size_t index) { invalidate(); return &_d->nodes.at(index); }
 
     AbstractTreeNode* rootNode();
 
     const AbstractTreeNode* rootNode() const;
 
+    // The searches use an index of the nodes, built by the first one and
+    // kept up to date by addNode(). The nodes are in the order of the tree.
     std::vector<const AbstractTreeNode*> findNodes(const QString& instance_name);
 
     const AbstractTreeNode* findFirstNode(const QString& instance_name);
 
+    std::vector<const AbstractTreeNode*> findNodesByModel(const QString& registration_ID);
+
+    // the nodes with a port remapped to this value (usually a blackboard entry)
+    std::vector<const AbstractTreeNode*> findNodesByPortValue(const QString& value);
+
+    // Merkle hash: each node hashes the fields compared by operator== and
+    // the hashes of its children. Computed when first needed and kept until
+    // the nodes are edited; two different trees rarely have the same hash,
+    // so operator== compares them first.
+    quint64 hash() const;
+
     AbstractTreeNode* addNode(AbstractTreeNode* parent, AbstractTreeNode &&new_node );
 
     void debugPrint() const;
@@ -129,9 +158,82 @@ public:
     void clear();
 
 private:
-    NodesVector _nodes;
+    struct Data: public QSharedData
+    {
+        NodesVector nodes;
+    };
+    QSharedDataPointer<Data> _d;
+
+    // without detaching
+    const NodesVector& constNodes() const { return _d->nodes; }
+
+    // not shared: built again by each copy
+    struct SearchIndex
+    {
+        SearchIndex(): valid(false) {}
+        bool valid;
+        QHash<QString, std::vector<int>> by_name;
+        QHash<QString, std::vector<int>> by_model;
+        QHash<QString, std::vector<int>> by_port_value;
+    };
+    SearchIndex _index;
+
+    // of the subtree of each node, empty if not computed
+    mutable std::vector<quint64> _hashes;
+
+    void invalidate()
+    {
+        _index.valid = false;
+        _hashes.clear();
+    }
+
+    void indexNode(const AbstractTreeNode& node);
+
+    std::vector<const AbstractTreeNode*> findIndexed(const QHash<QString, std::vector<int>> SearchIndex::* table,
+                                                     const QString& key);
+};
+
+// Index of the nodes of a tree by UID. UIDs are uint16_t: a flat array, as
+// large as the highest UID, replaces a hash map in the decoding loops.
+class UidLookupTable
+{
+public:
+    static const int INVALID_INDEX = -1;
+
+    void insert(uint16_t uid, int index)
+    {
+        if( uid >= _table.size() )
+        {
+            _table.resize( size_t(uid) + 1, int32_t(INVALID_INDEX) );
+        }
+        _table[uid] = index;
+    }
+
+    // INVALID_INDEX if the uid is unknown
+    int find(uint16_t uid) const
+    {
+        return uid < _table.size() ? int(_table[uid]) : int(INVALID_INDEX);
+    }
+
+    // highest UID + 1
+    size_t tableSize() const { return _table.size(); }
+
+    void clear() { _table.clear(); }
+
+private:
+    std::vector<int32_t> _table;
 };
 
+// QDataStream encoding of the models and of the trees, used by the project
+// cache and by the collapsed branches of the scenes
+void WriteModelToStream(QDataStream& stream, const NodeModel& model);
+
+NodeModel ReadModelFromStream(QDataStream& stream);
+
+void WriteTreeToStream(QDataStream& stream, const AbsBehaviorTree& tree);
+
+AbsBehaviorTree ReadTreeFromStream(QDataStream& stream);
+
 static int GetUID()
 {
     static int uid = 1000;
@@ -0,0 +1,296 @@
+#include "compact_tree.h"
+
+CompactTree::CompactTree(const AbsBehaviorTree &tree)
+{
+    auto data = std::make_shared<Data>();
+    const size_t nodes_count = tree.nodesCount();
+
+    data->model_index.reserve( nodes_count );
+    data->names.reserve( nodes_count );
+    data->status.reserve( nodes_count );
+    data->sizes.reserve( nodes_count );
+    data->positions.reserve( nodes_count );
+    data->children_offset.reserve( nodes_count + 1 );
+    data->children.reserve( nodes_count > 0 ? nodes_count - 1 : 0 );
+    data->ports_offset.reserve( nodes_count + 1 );
+
+    // the models already stored, by registration ID
+    std::map<QString, std::vector<quint32>> models_by_ID;
+
+    data->children_offset.push_back( 0 );
+    data->ports_offset.push_back( 0 );
+    for (const auto& node: tree.nodes())
+    {
+        auto& candidates = models_by_ID[ node.model.registration_ID ];
+        quint32 model_index = quint32( data->models.size() );
+        for (quint32 candidate: candidates)
+        {
+            if( data->models[candidate] == node.model )
+            {
+                model_index = candidate;
+                break;
+            }
+        }
+        if( model_index == data->models.size() )
+        {
+            data->models.push_back( node.model );
+            candidates.push_back( model_index );
+        }
+
+        data->model_index.push_back( model_index );
+        data->names.push_back( node.instance_name );
+        data->status.push_back( node.status );
+        data->sizes.push_back( node.size );
+        data->positions.push_back( node.pos );
+
+        data->children.insert( data->children.end(),
+                               node.children_index.begin(), node.children_index.end() );
+        data->children_offset.push_back( qint32(data->children.size()) );
+
+        for (const auto& it: node.ports_mapping)
+        {
+            data->port_names.push_back( it.first );
+            data->port_values.push_back( it.second );
+        }
+        data->ports_offset.push_back( qint32(data->port_names.size()) );
+    }
+    _data = std::move(data);
+}
+
+AbstractTreeNode CompactTree::node(size_t index) const
+{
+    AbstractTreeNode node;
+    node.model = model(index);
+    node.index = int(index);
+    node.instance_name = instanceName(index);
+    node.status = status(index);
+    node.size = size(index);
+    node.pos = pos(index);
+
+    const size_t children_count = childrenCount(index);
+    node.children_index.reserve( children_count );
+    for (size_t i = 0; i < children_count; i++)
+    {
+        node.children_index.push_back( child(index, i) );
+    }
+
+    const size_t ports_count = portsCount(index);
+    for (size_t i = 0; i < ports_count; i++)
+    {
+        // already sorted
+        node.ports_mapping.insert( node.ports_mapping.end(), { portName(index, i), portValue(index, i) } );
+    }
+    return node;
+}
+
+AbsBehaviorTree CompactTree::toAbsTree() const
+{
+    AbsBehaviorTree tree;
+    for (size_t index = 0; index < nodesCount(); index++)
+    {
+        tree.nodes().push_back( node(index) );
+    }
+    return tree;
+}
+
+static size_t StringsMemory(const std::vector<QString>& strings)
+{
+    // the QString and its shared, null terminated, array of UTF-16
+    size_t bytes = strings.capacity() * sizeof(QString);
+    for (const auto& str: strings)
+    {
+        bytes += sizeof(QArrayData) + size_t(str.capacity() + 1) * sizeof(QChar);
+    }
+    return bytes;
+}
+
+size_t CompactTree::memoryUsage() const
+{
+    if( !_data )
+    {
+        return 0;
+    }
+    const Data& data = *_data;
+    size_t bytes = sizeof(Data);
+    for (const auto& model: data.models)
+    {
+        // a node of std::map for each port
+        bytes += sizeof(NodeModel) + size_t(model.registration_ID.capacity()) * sizeof(QChar) +
+                 model.ports.size() * ( sizeof(PortModels::value_type) + 64 );
+    }
+    bytes += data.model_index.capacity()     * sizeof(quint32) +
+             data.status.capacity()          * sizeof(NodeStatus) +
+             data.sizes.capacity()           * sizeof(QSizeF) +
+             data.positions.capacity()       * sizeof(QPointF) +
+             data.children_offset.capacity() * sizeof(qint32) +
+             data.children.capacity()        * sizeof(qint32) +
+             data.ports_offset.capacity()    * sizeof(qint32);
+    bytes += StringsMemory( data.names ) + StringsMemory( data.port_names ) +
+             StringsMemory( data.port_values );
+    return bytes;
+}
+
+bool CompactTree::operator ==(const CompactTree &other) const
+{
+    if( _data == other._data )
+    {
+        return true;
+    }
+    if( nodesCount() != other.nodesCount() )
+    {
+        return false;
+    }
+    if( empty() )
+    {
+        return true;
+    }
+    const Data& a = *_data;
+    const Data& b = *other._data;
+    if( a.names != b.names || a.children_offset != b.children_offset ||
+        a.children != b.children || a.ports_offset != b.ports_offset ||
+        a.port_names != b.port_names || a.port_values != b.port_values ||
+        a.status != b.status || a.sizes != b.sizes || a.positions != b.positions )
+    {
+        return false;
+    }
+    // the models may be stored in another order
+    for (size_t index = 0; index < a.names.size(); index++)
+    {
+        if( a.models[ a.model_index[index] ] != b.models[ b.model_index[index] ] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------
+void WriteCompactTreeToStream(QDataStream& stream, const CompactTree& tree)
+{
+    const size_t nodes_count = tree.nodesCount();
+    stream << quint32(nodes_count);
+    if( nodes_count == 0 )
+    {
+        return;
+    }
+    const CompactTree::Data& data = *tree._data;
+
+    stream << quint32(data.models.size());
+    for (const auto& model: data.models)
+    {
+        WriteModelToStream( stream, model );
+    }
+    for (size_t index = 0; index < nodes_count; index++)
+    {
+        stream << data.model_index[index] << data.names[index]
+               << data.sizes[index] << data.positions[index];
+    }
+    stream << quint32(data.children.size());
+    for (qint32 offset: data.children_offset)
+    {
+        stream << offset;
+    }
+    for (qint32 child: data.children)
+    {
+        stream << child;
+    }
+    stream << quint32(data.port_names.size());
+    for (qint32 offset: data.ports_offset)
+    {
+        stream << offset;
+    }
+    for (size_t i = 0; i < data.port_names.size(); i++)
+    {
+        stream << data.port_names[i] << data.port_values[i];
+    }
+}
+
+CompactTree ReadCompactTreeFromStream(QDataStream& stream)
+{
+    CompactTree tree;
+    quint32 nodes_count = 0;
+    stream >> nodes_count;
+    if( nodes_count == 0 || stream.status() != QDataStream::Ok )
+    {
+        return tree;
+    }
+    auto data = std::make_shared<CompactTree::Data>();
+
+    quint32 models_count = 0;
+    stream >> models_count;
+    for (quint32 i = 0; i < models_count && stream.status() == QDataStream::Ok; i++)
+    {
+        data->models.push_back( ReadModelFromStream( stream ) );
+    }
+    for (quint32 index = 0; index < nodes_count && stream.status() == QDataStream::Ok; index++)
+    {
+        quint32 model_index;
+        QString name;
+        QSizeF size;
+        QPointF pos;
+        stream >> model_index >> name >> size >> pos;
+        data->model_index.push_back( model_index );
+        data->names.push_back( InternString( name ) );
+        data->status.push_back( NodeStatus::IDLE );
+        data->sizes.push_back( size );
+        data->positions.push_back( pos );
+    }
+
+    auto readOffsets = [&](std::vector<qint32>& offsets)
+    {
+        for (quint32 i = 0; i <= nodes_count && stream.status() == QDataStream::Ok; i++)
+        {
+            qint32 offset;
+            stream >> offset;
+            offsets.push_back( offset );
+        }
+    };
+
+    quint32 children_count = 0;
+    stream >> children_count;
+    readOffsets( data->children_offset );
+    for (quint32 i = 0; i < children_count && stream.status() == QDataStream::Ok; i++)
+    {
+        qint32 child;
+        stream >> child;
+        data->children.push_back( child );
+    }
+
+    quint32 ports_count = 0;
+    stream >> ports_count;
+    readOffsets( data->ports_offset );
+    for (quint32 i = 0; i < ports_count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString name, value;
+        stream >> name >> value;
+        data->port_names.push_back( InternString( name ) );
+        data->port_values.push_back( value );
+    }
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        return tree;
+    }
+    // a corrupted stream must not index out of the arrays
+    bool valid = data->names.size() == nodes_count &&
+                 data->children_offset.size() == nodes_count + 1 &&
+                 data->ports_offset.size() == nodes_count + 1 &&
+                 data->children_offset.front() == 0 && data->ports_offset.front() == 0 &&
+                 data->children_offset.back() == qint32(data->children.size()) &&
+                 data->ports_offset.back() == qint32(data->port_names.size());
+    for (quint32 index = 0; valid && index < nodes_count; index++)
+    {
+        valid = data->model_index[index] < data->models.size() &&
+                data->children_offset[index] <= data->children_offset[index+1] &&
+                data->ports_offset[index] <= data->ports_offset[index+1];
+    }
+    for (size_t i = 0; valid && i < data->children.size(); i++)
+    {
+        valid = data->children[i] > 0 && quint32(data->children[i]) < nodes_count;
+    }
+    if( valid )
+    {
+        tree._data = std::move(data);
+    }
+    return tree;
+}
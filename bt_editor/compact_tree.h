@@ -0,0 +1,108 @@
+#ifndef COMPACT_TREE_H
+#define COMPACT_TREE_H
+
+#include <memory>
+#include <vector>
+#include <QDataStream>
+#include "bt_editor_base.h"
+
+// Immutable copy of an AbsBehaviorTree in a few contiguous arrays, for the
+// trees that are kept or copied around rather than edited:
+//
+//  - the models are stored once per registration ID, the nodes refer to
+//    them by index;
+//  - the children of all the nodes are in one array, the children of node
+//    i being children[ children_offset[i] .. children_offset[i+1] ), the
+//    same for the ports mapping;
+//  - the copies share the same data: copying is free, comparing two copies
+//    of the same tree too.
+//
+// The indices of the nodes are the ones of the AbsBehaviorTree, the graphic
+// nodes are not kept.
+class CompactTree
+{
+public:
+    CompactTree() {}
+
+    explicit CompactTree(const AbsBehaviorTree& tree);
+
+    size_t nodesCount() const { return _data ? _data->names.size() : 0; }
+
+    bool empty() const { return nodesCount() == 0; }
+
+    const NodeModel& model(size_t index) const { return _data->models[ _data->model_index[index] ]; }
+
+    const QString& instanceName(size_t index) const { return _data->names[index]; }
+
+    NodeStatus status(size_t index) const { return _data->status[index]; }
+
+    QSizeF size(size_t index) const { return _data->sizes[index]; }
+
+    QPointF pos(size_t index) const { return _data->positions[index]; }
+
+    size_t childrenCount(size_t index) const
+    {
+        return size_t( _data->children_offset[index+1] - _data->children_offset[index] );
+    }
+
+    // i-th child of the node
+    int child(size_t index, size_t i) const
+    {
+        return _data->children[ size_t(_data->children_offset[index]) + i ];
+    }
+
+    size_t portsCount(size_t index) const
+    {
+        return size_t( _data->ports_offset[index+1] - _data->ports_offset[index] );
+    }
+
+    const QString& portName(size_t index, size_t i) const
+    {
+        return _data->port_names[ size_t(_data->ports_offset[index]) + i ];
+    }
+
+    const QString& portValue(size_t index, size_t i) const
+    {
+        return _data->port_values[ size_t(_data->ports_offset[index]) + i ];
+    }
+
+    // without graphic node
+    AbstractTreeNode node(size_t index) const;
+
+    AbsBehaviorTree toAbsTree() const;
+
+    bool operator ==(const CompactTree& other) const;
+
+    bool operator !=(const CompactTree& other) const { return !( *this == other ); }
+
+    // estimate of the shared data, in bytes
+    size_t memoryUsage() const;
+
+private:
+    friend void WriteCompactTreeToStream(QDataStream& stream, const CompactTree& tree);
+    friend CompactTree ReadCompactTreeFromStream(QDataStream& stream);
+
+    struct Data
+    {
+        std::vector<NodeModel> models;
+        // by node
+        std::vector<quint32> model_index;
+        std::vector<QString> names;
+        std::vector<NodeStatus> status;
+        std::vector<QSizeF> sizes;
+        std::vector<QPointF> positions;
+        std::vector<qint32> children_offset; // nodes + 1
+        std::vector<qint32> children;
+        std::vector<qint32> ports_offset;    // nodes + 1
+        std::vector<QString> port_names;
+        std::vector<QString> port_values;
+    };
+    std::shared_ptr<const Data> _data;
+};
+
+// Same role as WriteTreeToStream(), the models written once
+void WriteCompactTreeToStream(QDataStream& stream, const CompactTree& tree);
+
+CompactTree ReadCompactTreeFromStream(QDataStream& stream);
+
+#endif // COMPACT_TREE_H
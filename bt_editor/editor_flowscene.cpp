@@ -3,18 +3,13 @@
 #include <QStandardItemModel>
 #include <QVariant>
 #include <QGraphicsSceneDragDropEvent>
-#include <QKeyEvent>
-#include <QCursor>
-#include <QApplication>
 #include "models/BehaviorTreeNodeModel.hpp"
-#include <QGraphicsView>
 
 #include <nodes/Node>
 
 EditorFlowScene::EditorFlowScene(std::shared_ptr<QtNodes::DataModelRegistry> registry,
                                  QObject * parent):
-    FlowScene(registry,parent),
-    _editor_locked(false)
+    FlowScene(registry,parent)
 {
 
 }
@@ -56,63 +51,9 @@ void EditorFlowScene::dragMoveEvent(QGraphicsSceneDragDropEvent* event)
     event->acceptProposedAction();
 }
 
-void EditorFlowScene::keyPressEvent(QKeyEvent *event)
-{
-
-    for( const auto& it: nodes())
-    {
-        const auto& node = it.second;
-        auto line_edits = node->nodeDataModel()->embeddedWidget()->findChildren<QLineEdit*>();
-        for(auto line_edit: line_edits )
-        {
-            if( line_edit->hasFocus() )
-            {
-                // Do not swallow the keyPressEvent, you are editing a QLineEdit
-                QGraphicsScene::keyPressEvent(event);
-                return;
-            }
-        }
-    }
-
-    const QString& registration_ID = _clipboard_node.model.registration_ID;
-
-    auto selected_items = selectedItems();
-    if( selected_items.size() == 1 &&
-        event->key() == Qt::Key_C &&
-        event->modifiers() == Qt::ControlModifier)
-    {
-        auto node_item = dynamic_cast<QtNodes::NodeGraphicsObject*>( selected_items.front() );
-        if( !node_item ) return;
-
-        QtNodes::Node& selected_node = node_item->node();
-        auto node_model = dynamic_cast<BehaviorTreeDataModel*>( selected_node.nodeDataModel() );
-        if( !node_model ) return;
-
-        _clipboard_node.model = node_model->model();
-        _clipboard_node.instance_name  = node_model->instanceName();
-    }
-    else if( event->key() == Qt::Key_V &&
-             event->modifiers() == Qt::ControlModifier &&
-             registry().isRegistered( registration_ID  ) )
-    {
-        auto views_ = views();
-        QGraphicsView* view = views_.front();
-        auto mouse_pos = view->viewport()->mapFromGlobal( QCursor::pos() );
-        auto scene_pos = view->mapToScene( mouse_pos );
-
-        createNodeAtPos( registration_ID,
-                        _clipboard_node.instance_name,
-                        scene_pos );
-    }
-    else{
-        QGraphicsScene::keyPressEvent(event);
-    }
-}
-
-
 void EditorFlowScene::dropEvent(QGraphicsSceneDragDropEvent *event)
 {
-    if(!_editor_locked && event->mimeData()->hasFormat("application/x-qabstractitemmodeldatalist")  )
+    if(!readOnly() && event->mimeData()->hasFormat("application/x-qabstractitemmodeldatalist")  )
     {
         QByteArray encoded = event->mimeData()->data("application/x-qabstractitemmodeldatalist");
         QDataStream stream(&encoded, QIODevice::ReadOnly);
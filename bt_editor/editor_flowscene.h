@@ -11,9 +11,6 @@ public:
     EditorFlowScene(std::shared_ptr<QtNodes::DataModelRegistry> registry,
                     QObject * parent = Q_NULLPTR);
 
-    bool isLocked() const { return _editor_locked; }
-    void lock(bool lock_editor) { _editor_locked = lock_editor; }
-
     QtNodes::Node& createNodeAtPos(const QString& ID, const QString& instance_name, QPointF scene_pos);
 
 private:
@@ -23,10 +20,6 @@ private:
     void dropEvent(QGraphicsSceneDragDropEvent *event) override;
     void dragMoveEvent(QGraphicsSceneDragDropEvent* event) override;
 
-    void keyPressEvent( QKeyEvent * event ) override;
-
-    bool _editor_locked;
-    AbstractTreeNode _clipboard_node;
 };
 
 #endif // EDITOR_FLOWSCENE_H
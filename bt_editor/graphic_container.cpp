@@ -1,11 +1,17 @@
 #include "graphic_container.h"
 #include "utils.h"
 #include "mainwindow.h"
+#include "trace_recorder.h"
 
 #include "models/SubtreeNodeModel.hpp"
 #include "models/RootNodeModel.hpp"
 
 #include <QSignalBlocker>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <QMenu>
 #include <QDebug>
 #include <QMessageBox>
@@ -18,10 +24,19 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
                                    QWidget *parent) :
     QObject(parent),
     _model_registry( std::move(model_registry) ),
-    _signal_was_blocked(true)
+    _signal_was_blocked(true),
+    _nodes_by_index_revision(0),
+    _tree_revision(0),
+    _scene_changed(true),
+    _materialized(true),
+    _lazy_layout(QtNodes::PortLayout::Vertical),
+    _editing_locked(false),
+    _model_usage_revision(0),
+    _model_usage_valid(false)
 {
     _scene = new EditorFlowScene( _model_registry, parent );
     _view  = new QtNodes::FlowView( _scene, parent );
+    _last_used.start();
 
     connect( _scene, &QtNodes::FlowScene::nodeDoubleClicked,
              this, &GraphicContainer::onNodeDoubleClicked);
@@ -29,6 +44,9 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
     connect( _scene, &QtNodes::FlowScene::nodeCreated,
              this,   &GraphicContainer::onNodeCreated  );
 
+    connect( _scene, &QtNodes::FlowScene::structureChanged,
+             this,   &GraphicContainer::onStructureChanged  );
+
     connect( _scene, &QtNodes::FlowScene::nodeContextMenu,
              this, &GraphicContainer::onNodeContextMenu );
 
@@ -67,52 +85,316 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
         }
     });
 
+    auto scene_changed = [this]() { _scene_changed = true; };
+    connect( _scene, &QtNodes::FlowScene::nodeCreated, this, scene_changed );
+    connect( _scene, &QtNodes::FlowScene::nodeDeleted, this, scene_changed );
+    connect( _scene, &QtNodes::FlowScene::nodeMoved, this, scene_changed );
+    connect( _scene, &QtNodes::FlowScene::connectionCreated, this, scene_changed );
+    connect( _scene, &QtNodes::FlowScene::connectionDeleted, this, scene_changed );
+
 }
 
-void GraphicContainer::lockEditing(bool locked)
+std::shared_ptr<const AbsBehaviorTree> GraphicContainer::tree()
 {
-    std::vector<QtNodes::Node*> subtrees_expanded;
-    for (auto& nodes_it: _scene->nodes() )
+    materialize();
+    if( !_tree || _tree_revision != _scene->revision() )
     {
+        _tree = std::make_shared<AbsBehaviorTree>( BuildTreeFromScene( _scene, nullptr, true ) );
+        _tree_revision = _scene->revision();
+        _tree_index.clear();
+        for (const auto& abs_node: _tree->nodes())
+        {
+            if( abs_node.graphic_node )
+            {
+                _tree_index.insert( { abs_node.graphic_node, abs_node.index } );
+            }
+        }
+    }
+    return _tree;
+}
 
-        QtNodes::Node* node = nodes_it.second.get();
-        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node->nodeDataModel() );
+void GraphicContainer::updateTreeNode(const Node &node)
+{
+    // otherwise it is built again anyway
+    if( !_tree || _tree_revision != _scene->revision() )
+    {
+        return;
+    }
+    auto it = _tree_index.find( &node );
+    auto bt_model = dynamic_cast<const BehaviorTreeDataModel*>( node.nodeDataModel() );
+    if( it == _tree_index.end() || !bt_model )
+    {
+        return;
+    }
+    // the snapshots already taken are left as they are
+    if( _tree.use_count() > 1 )
+    {
+        _tree = std::make_shared<AbsBehaviorTree>( *_tree );
+    }
+    AbstractTreeNode* abs_node = _tree->node( size_t(it->second) );
+    abs_node->instance_name = bt_model->instanceName();
+    abs_node->ports_mapping = bt_model->getCurrentPortMapping();
+}
 
-        if(bt_model->registrationName() == "Root")
+const std::vector<Node*>& GraphicContainer::nodesByIndex()
+{
+    materialize();
+    if( !_tree || _nodes_by_index_revision != _scene->revision() )
+    {
+        const std::shared_ptr<const AbsBehaviorTree> tree_ptr = tree();
+        const AbsBehaviorTree& tree = *tree_ptr;
+        _nodes_by_index.clear();
+        _nodes_by_index.reserve( tree.nodesCount() );
+        _collapsed_owner.assign( tree.nodesCount(), -1 );
+        _collapsed_status.assign( tree.nodesCount(), NodeStatus::IDLE );
+        _collapsed_counts.assign( tree.nodesCount(), {{0, 0, 0, 0}} );
+        for(const auto& abs_node: tree.nodes())
         {
-            bt_model->lock( locked );
-            node->nodeGraphicsObject().setFlag(QGraphicsItem::ItemIsMovable,  false);
-            node->nodeGraphicsObject().setFlag(QGraphicsItem::ItemIsFocusable, true);
-            node->nodeGraphicsObject().setFlag(QGraphicsItem::ItemIsSelectable, false);
-            continue;
+            _nodes_by_index.push_back( abs_node.graphic_node );
+
+            // the parents come first: the owner of a child is known already
+            for (int child: abs_node.children_index)
+            {
+                if( tree.node(child)->graphic_node == nullptr )
+                {
+                    const int owner = abs_node.graphic_node ? abs_node.index :
+                                                              _collapsed_owner[abs_node.index];
+                    _collapsed_owner[child] = owner;
+                    _collapsed_counts[owner][int(NodeStatus::IDLE)]++;
+                }
+            }
         }
+        _displayed_styles.assign( _nodes_by_index.size(), UNKNOWN_STYLE );
+        _nodes_by_index_revision = _tree_revision;
+    }
+    return _nodes_by_index;
+}
+
+void GraphicContainer::applyStyle(Node *node, const NodeStyle &node_style,
+                                  const ConnectionStyle &conn_style)
+{
+    node->nodeDataModel()->setNodeStyle( node_style );
+    // only the boundary is repainted, the body stays in the cache of the item
+    node->nodeGraphicsObject().updateBoundary();
+
+    const auto& conn_in = node->nodeState().connections(PortType::In, 0 );
+    if(conn_in.size() == 1)
+    {
+        auto conn = conn_in.begin()->second;
+        conn->setStyle( conn_style );
+        conn->connectionGraphicsObject().update();
+    }
+}
+
+void GraphicContainer::setNodeStatusStyle(int index, NodeStatus status, NodeStatus prev_status)
+{
+    const auto& nodes = nodesByIndex();
+    Node* node = nodes.at( size_t(index) );
+
+    if( !node )
+    {
+        setCollapsedNodeStatus( index, status );
+        return;
+    }
+
+    // the previous status matters only for the faded style of the IDLE nodes
+    if( status != NodeStatus::IDLE )
+    {
+        prev_status = NodeStatus::IDLE;
+    }
+    const int style = int(status) * 4 + int(prev_status);
+    if( _displayed_styles[index] == style )
+    {
+        return;
+    }
+    _displayed_styles[index] = style;
+
+    const auto& status_style = getStyleFromStatus( status, prev_status );
+    applyStyle( node, status_style.first, status_style.second );
+}
+
+void GraphicContainer::setCollapsedNodeStatus(int index, NodeStatus status)
+{
+    const int owner = _collapsed_owner[index];
+    const int prev_status = int(_collapsed_status[index]);
+    if( owner < 0 || prev_status == int(status) || int(status) < 0 || int(status) >= 4 )
+    {
+        return;
+    }
+    auto& counts = _collapsed_counts[owner];
+    const NodeStatus prev_aggregated = aggregatedStatus( counts );
+
+    counts[prev_status]--;
+    counts[int(status)]++;
+    _collapsed_status[index] = status;
+
+    const NodeStatus aggregated = aggregatedStatus( counts );
+    if( aggregated != prev_aggregated )
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( _nodes_by_index[owner]->nodeDataModel() );
+        bt_model->setCollapsedStatus( aggregated );
+    }
+}
 
-        bt_model->lock(locked);
-        node->nodeGraphicsObject().lock(locked);
+NodeStatus GraphicContainer::aggregatedStatus(const std::array<int, 4> &counts)
+{
+    if( counts[int(NodeStatus::RUNNING)] > 0 ) return NodeStatus::RUNNING;
+    if( counts[int(NodeStatus::FAILURE)] > 0 ) return NodeStatus::FAILURE;
+    if( counts[int(NodeStatus::SUCCESS)] > 0 ) return NodeStatus::SUCCESS;
+    return NodeStatus::IDLE;
+}
 
-        if( auto subtree = dynamic_cast<SubtreeNodeModel*>( node->nodeDataModel() ) )
+void GraphicContainer::resetNodeStatusStyles()
+{
+    const auto& nodes = nodesByIndex();
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        if( !nodes[index] )
+        {
+            setCollapsedNodeStatus( int(index), NodeStatus::IDLE );
+            continue;
+        }
+        if( _displayed_styles[index] != DEFAULT_STYLE )
         {
-            if( subtree->expanded()) subtrees_expanded.push_back(node);
+            _displayed_styles[index] = DEFAULT_STYLE;
+            applyStyle( nodes[index], DefaultNodeStyle(), DefaultConnectionStyle() );
         }
+    }
+}
+
+namespace {
+
+// see GraphicContainer::setNodeTimingBadge. A child of the NodeGraphicsObject,
+// found again by its type
+class NodeTimingBadge : public QGraphicsItem
+{
+public:
+    enum { Type = QGraphicsItem::UserType + 1 };
+
+    explicit NodeTimingBadge(QGraphicsItem* parent): QGraphicsItem(parent)
+    {
+        setAcceptedMouseButtons( Qt::NoButton );
+        // the text changes at most once per frame, the node moves more often
+        setCacheMode( QGraphicsItem::DeviceCoordinateCache );
+    }
+
+    int type() const override { return Type; }
+
+    const QString& text() const { return _text; }
+
+    // at the top right corner of the node
+    void setText(const QString& text, qreal node_width)
+    {
+        prepareGeometryChange();
+        _text = text;
+        const QFontMetrics metrics( badgeFont() );
+        _rect = QRectF( 0, 0, metrics.boundingRect( text ).width() + 8, metrics.height() + 2 );
+        setPos( node_width - _rect.width(), -_rect.height() - 3 );
+        update();
+    }
+
+    QRectF boundingRect() const override { return _rect; }
 
-        if( !locked )
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*) override
+    {
+        painter->setPen( Qt::NoPen );
+        painter->setBrush( QColor( 30, 30, 30, 210 ) );
+        painter->drawRoundedRect( _rect, 3, 3 );
+        painter->setFont( badgeFont() );
+        painter->setPen( QColor( 230, 230, 230 ) );
+        painter->drawText( _rect, Qt::AlignCenter, _text );
+    }
+
+private:
+    static QFont badgeFont()
+    {
+        QFont font;
+        font.setPointSize( 8 );
+        return font;
+    }
+
+    QString _text;
+    QRectF _rect;
+};
+
+NodeTimingBadge* FindTimingBadge(Node* node)
+{
+    for (QGraphicsItem* child: node->nodeGraphicsObject().childItems())
+    {
+        if( child->type() == NodeTimingBadge::Type )
         {
-            node->nodeGraphicsObject().setGeometryChanged();
-            QtNodes::NodeStyle style;
-            node->nodeDataModel()->setNodeStyle( style );
-            node->nodeGraphicsObject().update();
+            return static_cast<NodeTimingBadge*>( child );
         }
     }
+    return nullptr;
+}
+
+}
+
+void GraphicContainer::setNodeTimingBadge(int index, const QString &text)
+{
+    const auto& nodes = nodesByIndex();
+    if( index < 0 || size_t(index) >= nodes.size() || !nodes[index] )
+    {
+        return;
+    }
+    Node* node = nodes[index];
+    NodeTimingBadge* badge = FindTimingBadge( node );
+    if( text.isEmpty() )
+    {
+        delete badge;
+        return;
+    }
+    if( !badge )
+    {
+        badge = new NodeTimingBadge( &node->nodeGraphicsObject() );
+    }
+    if( badge->text() != text )
+    {
+        badge->setText( text, node->nodeGeometry().width() );
+    }
+}
+
+void GraphicContainer::clearNodeTimingBadges()
+{
+    if( !_materialized )
+    {
+        return;
+    }
+    for (const auto& it: _scene->nodes())
+    {
+        delete FindTimingBadge( it.second.get() );
+    }
+}
 
-    for (auto& subtree: subtrees_expanded )
+void GraphicContainer::lockEditing(bool locked)
+{
+    if( locked == _editing_locked )
     {
-        lockSubtreeEditing(*subtree, true, !locked);
+        return;
+    }
+    _editing_locked = locked;
+    if( !_materialized )
+    {
+        return; // done by materialize()
     }
+    // the nodes and the connections check the mode of the scene
+    _scene->setReadOnly( locked );
 
-    for (auto& conn_it: _scene->connections() )
+    if( !locked )
     {
-        QtNodes::Connection* conn = conn_it.second.get();
-        conn->connectionGraphicsObject().lock( locked );
+        // remove the colors of the statuses, and restore those of the
+        // expanded subtrees
+        resetNodeStatusStyles();
+        for (auto& nodes_it: _scene->nodes() )
+        {
+            QtNodes::Node* node = nodes_it.second.get();
+            auto subtree = dynamic_cast<SubtreeNodeModel*>( node->nodeDataModel() );
+            if( subtree && subtree->expanded() )
+            {
+                lockSubtreeEditing( *node, true, true );
+            }
+        }
     }
 }
 
@@ -139,6 +421,7 @@ void GraphicContainer::lockSubtreeEditing(Node &root_node, bool locked, bool cha
         //--------------------------------
         if( locked && change_style )
         {
+            std::fill( _displayed_styles.begin(), _displayed_styles.end(), int(UNKNOWN_STYLE) );
             QtNodes::NodeStyle style;
             style.GradientColor0.setBlue(120);
             style.GradientColor1.setBlue(100);
@@ -153,10 +436,11 @@ void GraphicContainer::lockSubtreeEditing(Node &root_node, bool locked, bool cha
 
 void GraphicContainer::nodeReorder()
 {
+    materialize();
     {
         const QSignalBlocker blocker(this);
         auto abstract_tree = BuildTreeFromScene( _scene );
-        NodeReorder( *_scene, abstract_tree );
+        NodeReorder( *_scene, abstract_tree, &_tree_layout );
         zoomHomeView();
     }
     emit undoableChange();
@@ -164,6 +448,7 @@ void GraphicContainer::nodeReorder()
 
 void GraphicContainer::zoomHomeView()
 {
+    materialize();
     QRectF rect = _scene->itemsBoundingRect();
     rect.setBottom( rect.top() + rect.height()* 1.2 );
 
@@ -178,55 +463,27 @@ void GraphicContainer::zoomHomeView()
     _view->scale(0.9, 0.9);
 }
 
-bool GraphicContainer::containsValidTree() const
+void GraphicContainer::focusNode(Node &node)
 {
-    if( _scene->nodes().empty())
-    {
-        return false;
-    }
-
-    auto connections =  _scene->connections();
-
-    std::set<const QtNodes::Node*> nodes_with_input;
-    std::set<const QtNodes::Node*> nodes_with_output;
-
-    for (const auto& it: _scene->connections())
-    {
-        const QtNodes::Connection* connection = it.second.get();
-        auto node = connection->getNode( QtNodes::PortType::In);
-        if( node ){
-            nodes_with_input.insert( node );
-        }
-        node = connection->getNode( QtNodes::PortType::Out);
-        if( node ){
-            nodes_with_output.insert( node );
-        }
-    }
+    _scene->clearSelection();
+    node.nodeGraphicsObject().setSelected(true);
+    _view->centerOn( &node.nodeGraphicsObject() );
+}
 
-    for (const auto& it: _scene->nodes())
-    {
-        const QtNodes::Node* node = it.second.get();
-        if( node->nodeDataModel()->nPorts(QtNodes::PortType::In) == 1 )
-        {
-            if( nodes_with_input.find(node) == nodes_with_input.end() )
-            {
-                return false;
-            }
-        }
-        if( node->nodeDataModel()->nPorts(QtNodes::PortType::Out) == 1 )
-        {
-            if( nodes_with_output.find(node) == nodes_with_output.end() )
-            {
-                return false;
-            }
-        }
-    }
-    return true;
+bool GraphicContainer::containsValidTree() const
+{
+    materializedScene();
+    // every node has its parent and, if it has an output port, its children
+    return !_scene->nodes().empty() && _scene->danglingNodesCount() == 0;
 }
 
 void GraphicContainer::clearScene()
 {
     const QSignalBlocker blocker( this );
+    _materialized = true;
+    _lazy_state = SceneState();
+    _evicted_state.reset();
+    _model_usage_valid = false;
     _scene->clearScene();
 }
 
@@ -277,6 +534,9 @@ void GraphicContainer::createSubtree(Node &root_node, QString subtree_name )
         return;
     }
 
+    // the tree of the new subtree is built from the scene
+    expandCollapsedBranches( root_node );
+
     addNewModel( { NodeType::SUBTREE, subtree_name, {}} );
     QApplication::processEvents();
 
@@ -307,17 +567,32 @@ void GraphicContainer::onNodeDoubleClicked(Node &root_node)
     }
 }
 
-void GraphicContainer::onPortValueDoubleClicked(QLineEdit *edit_value)
+void GraphicContainer::onPortValueDoubleClicked(QString value)
 {
     for (const auto& it: _scene->nodes())
     {
         auto node_model = dynamic_cast<BehaviorTreeDataModel*>( it.second->nodeDataModel() );
-        QString val = edit_value ?  edit_value->text() : QString();
-        node_model->onHighlightPortValue( val );
+        node_model->onHighlightPortValue( value );
     }
 }
 
 void GraphicContainer::onNodeCreated(Node &node)
+{
+    setupNode( node );
+    undoableChange();
+}
+
+void GraphicContainer::onStructureChanged(const std::vector<Node*>& created_nodes)
+{
+    for (Node* node: created_nodes)
+    {
+        setupNode( *node );
+    }
+    _scene_changed = true;
+    undoableChange();
+}
+
+void GraphicContainer::setupNode(Node &node)
 {
     if( auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() ) )
     {
@@ -330,6 +605,21 @@ void GraphicContainer::onNodeCreated(Node &node)
         connect( bt_node, &BehaviorTreeDataModel::instanceNameChanged,
                 this, &GraphicContainer::undoableChange );
 
+        auto node_changed = [this, &node]()
+        {
+            _scene_changed = true;
+            updateTreeNode( node );
+        };
+        connect( bt_node, &BehaviorTreeDataModel::parameterUpdated, this, node_changed );
+        connect( bt_node, &BehaviorTreeDataModel::instanceNameChanged, this, node_changed );
+
+        // the root is never moved nor selected
+        if( bt_node->registrationName() == "Root" )
+        {
+            node.nodeGraphicsObject().setFlag(QGraphicsItem::ItemIsMovable,  false);
+            node.nodeGraphicsObject().setFlag(QGraphicsItem::ItemIsSelectable, false);
+        }
+
         if( auto subtree_node = dynamic_cast<SubtreeNodeModel*>( bt_node ) )
         {
             auto main_win = dynamic_cast<MainWindow*>( parent() );
@@ -346,15 +636,39 @@ void GraphicContainer::onNodeCreated(Node &node)
 
         bt_node->initWidget();
     }
-    undoableChange();
 }
 
 void GraphicContainer::onNodeContextMenu(Node &node, const QPointF &)
 {
-    // only allow context menu in editor mode
+    auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
     auto main_win = dynamic_cast<MainWindow*>( parent() );
+
+    // a collapsed node is edited once expanded
+    if( bt_model && bt_model->collapsed() )
+    {
+        QMenu* node_menu = new QMenu(_view);
+        auto expand = node_menu->addAction("Expand branch");
+        connect( expand, &QAction::triggered, this, [this, &node]()
+        {
+            expandBranch( node );
+        });
+        node_menu->exec( QCursor::pos() );
+        return;
+    }
+
+    // only collapse in the other modes
     if( main_win->getGraphicMode() != GraphicMode::EDITOR )
     {
+        if( canCollapseBranch(node) )
+        {
+            QMenu* node_menu = new QMenu(_view);
+            auto collapse = node_menu->addAction("Collapse branch");
+            connect( collapse, &QAction::triggered, this, [this, &node]()
+            {
+                collapseBranch( node );
+            });
+            node_menu->exec( QCursor::pos() );
+        }
         return;
     }
 
@@ -362,6 +676,12 @@ void GraphicContainer::onNodeContextMenu(Node &node, const QPointF &)
     //--------------------------------
     createMorphSubMenu(node, node_menu);
     //--------------------------------
+    auto copy_branch = node_menu->addAction("Copy branch");
+    connect( copy_branch, &QAction::triggered, this, [this, &node]()
+    {
+        WriteClipboardNodes( copyNodes( { &node }, true ) );
+    });
+    //--------------------------------
     auto remove = node_menu->addAction("Remove");
 
     connect( remove, &QAction::triggered,
@@ -388,6 +708,13 @@ void GraphicContainer::onNodeContextMenu(Node &node, const QPointF &)
         });
     }
     //--------------------------------
+    auto collapse = node_menu->addAction("Collapse branch");
+    collapse->setEnabled( canCollapseBranch(node) );
+    connect( collapse, &QAction::triggered, this, [this, &node]()
+    {
+        collapseBranch( node );
+    });
+    //--------------------------------
     node_menu->exec( QCursor::pos() );
 }
 
@@ -465,88 +792,472 @@ void GraphicContainer::deleteSubTreeRecursively(Node &root_node)
 }
 
 
-void GraphicContainer::createMorphSubMenu(QtNodes::Node &node, QMenu* nodeMenu)
+bool GraphicContainer::canCollapseBranch(Node &node) const
 {
-    auto bt_model =  dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
-    const QString category ( QString::fromStdString( toStr( bt_model->nodeType()) ));
-
-    auto names_in_category = _model_registry->registeredModelsByCategory( category );
-    names_in_category.erase( node.nodeDataModel()->name() );
-
-    QMenu* morph_submenu = nodeMenu->addMenu("Morph into...");
-
-    if( names_in_category.size() == 0)
-    {
-        morph_submenu->setEnabled(false);
-    }
-    else
+    auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
+    if( !bt_model || bt_model->collapsed() || bt_model->registrationName() == "Root" ||
+        dynamic_cast<SubtreeNodeModel*>( bt_model ) )
     {
-        for(auto& name: names_in_category)
-        {
-            auto action = new QAction(name, morph_submenu);
-            morph_submenu->addAction(action);
-
-            connect( action, &QAction::triggered, this, [this, &node, name]
-            {
-                substituteNode( &node, name);
-                undoableChange();
-            });
-        }
+        return false;
     }
+    const auto type = bt_model->nodeType();
+    return (type == NodeType::CONTROL || type == NodeType::DECORATOR) &&
+            !getChildren( *_scene, node, false ).empty();
 }
 
-void GraphicContainer::createSmartRemoveAction(QtNodes::Node &node, QMenu* node_menu)
+void GraphicContainer::collapseBranch(Node &node)
 {
-    auto *smart_remove = new QAction("Smart Remove ", node_menu);
-    node_menu->addAction(smart_remove);
-
-    NodeState::ConnectionPtrSet conn_in  = node.nodeState().connections(PortType::In, 0);
-    NodeState::ConnectionPtrSet conn_out = node.nodeState().connections(PortType::Out, 0);
-
-    if( conn_in.size() != 1 || conn_out.size() == 0 )
+    if( !canCollapseBranch(node) )
     {
-        smart_remove->setEnabled(false);
         return;
     }
+    auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
+    {
+        const QSignalBlocker blocker( this );
 
-    auto parent_node = conn_in.begin()->second->getNode(PortType::Out);
-    auto policy = parent_node->nodeDataModel()->portOutConnectionPolicy(0);
+        // the collapsed branches below are part of this one
+        const CompactTree branch( BuildTreeFromScene( _scene, &node, true ) );
 
-    if( policy == NodeDataModel::ConnectionPolicy::One && conn_out.size() > 1)
-    {
-        smart_remove->setEnabled(false);
-        return;
+        for (auto child: getChildren( *_scene, node, false ))
+        {
+            deleteSubTreeRecursively( *child );
+        }
+        bt_model->setCollapsedBranch( branch );
+        node.nodeState().getEntries(PortType::Out).resize(0);
+        _scene->invalidateNodePorts( node );
     }
-
-    QtNodes::Node* node_ptr = &node;
-    connect( smart_remove, &QAction::triggered,
-             this, [this, node_ptr]()
-    {
-        onSmartRemove(node_ptr);
-    });
+    nodeReorder();
 }
 
-void GraphicContainer::onSmartRemove(QtNodes::Node* node)
+void GraphicContainer::expandBranch(Node &node)
 {
-    auto parent_node = GetParentNode( node );
-    NodeState::ConnectionPtrSet conn_out = node->nodeState().connections(PortType::Out, 0);
-
-    if( !parent_node || conn_out.size() == 0 )
+    auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
+    if( !bt_model || !bt_model->collapsed() )
     {
         return;
     }
-
     {
-        const QSignalBlocker blocker(this);
-        for( auto& it: conn_out)
+        const QSignalBlocker blocker( this );
+        AbsBehaviorTree branch = bt_model->collapsedBranch().toAbsTree();
+        bt_model->setCollapsedBranch( CompactTree() );
+        node.nodeState().getEntries(PortType::Out).resize(1);
+        _scene->invalidateNodePorts( node );
+
+        QtNodes::FlowScene::ScopedBatch batch( *_scene );
+        QPointF cursor = _scene->getNodePosition(node) + QPointF(100,100);
+        const std::vector<int> children = branch.rootNode()->children_index;
+        for (int child: children)
         {
-            auto child_node = it.second->getNode(PortType::In);
-            _scene->createConnection( *child_node, 0, *parent_node, 0 );
+            recursiveLoadStep( cursor, branch, branch.node(child), &node, 1 );
         }
-        _scene->removeNode( *node );
-        nodeReorder();
     }
-    undoableChange();
+    if( _editing_locked )
+    {
+        lockSubtreeEditing( node, true, false );
+    }
+    nodeReorder();
+}
+
+void GraphicContainer::expandCollapsedBranches(Node &root_node)
+{
+    std::vector<Node*> collapsed_nodes;
+    for (auto node: getSubtreeNodesRecursively( root_node ))
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node->nodeDataModel() );
+        if( bt_model && bt_model->collapsed() )
+        {
+            collapsed_nodes.push_back( node );
+        }
+    }
+    for (auto node: collapsed_nodes)
+    {
+        expandBranch( *node );
+    }
+}
+
+ClipboardNodes GraphicContainer::copyNodes(const std::vector<Node*>& nodes, bool with_descendants)
+{
+    ClipboardNodes copy;
+    const std::set<Node*> copied( nodes.begin(), nodes.end() );
+
+    auto parentOf = [](Node* node) -> Node*
+    {
+        if( node->nodeDataModel()->nPorts( PortType::In ) == 0 )
+        {
+            return nullptr;
+        }
+        const auto& conn_in = node->nodeState().connections( PortType::In, 0 );
+        return conn_in.empty() ? nullptr : conn_in.begin()->second->getNode( PortType::Out );
+    };
+
+    // the roots of the forest, from left to right
+    std::vector<Node*> roots;
+    for (Node* node: nodes)
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node->nodeDataModel() );
+        if( bt_model && bt_model->registrationName() != "Root" && !copied.count( parentOf(node) ) )
+        {
+            roots.push_back( node );
+        }
+    }
+    std::sort( roots.begin(), roots.end(), [this](Node* a, Node* b)
+    {
+        const QPointF pos_a = _scene->getNodePosition(*a);
+        const QPointF pos_b = _scene->getNodePosition(*b);
+        return std::make_pair( pos_a.x(), pos_a.y() ) < std::make_pair( pos_b.x(), pos_b.y() );
+    });
+
+    auto& forest = copy.forest.nodes();
+    auto addNode = [&forest](AbstractTreeNode&& abs_node, int parent) -> int
+    {
+        abs_node.index = int(forest.size());
+        abs_node.children_index.clear();
+        abs_node.graphic_node = nullptr;
+        if( parent >= 0 )
+        {
+            forest[size_t(parent)].children_index.push_back( abs_node.index );
+        }
+        forest.push_back( std::move(abs_node) );
+        return forest.back().index;
+    };
+
+    std::function<void(const CompactTree&, size_t, int)> pushBranch;
+    pushBranch = [&](const CompactTree& branch, size_t index, int parent)
+    {
+        const int added = addNode( branch.node(index), parent );
+        for (size_t i = 0; i < branch.childrenCount(index); i++)
+        {
+            pushBranch( branch, size_t( branch.child(index, i) ), added );
+        }
+    };
+
+    QPointF top_left( std::numeric_limits<qreal>::max(), std::numeric_limits<qreal>::max() );
+    std::function<void(Node*, int)> pushNode;
+    pushNode = [&](Node* node, int parent)
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node->nodeDataModel() );
+        AbstractTreeNode abs_node;
+        abs_node.model = bt_model->model();
+        abs_node.instance_name = bt_model->instanceName();
+        abs_node.ports_mapping = bt_model->getCurrentPortMapping();
+        abs_node.pos  = _scene->getNodePosition( *node );
+        abs_node.size = _scene->getNodeSize( *node );
+        top_left.setX( std::min( top_left.x(), abs_node.pos.x() ) );
+        top_left.setY( std::min( top_left.y(), abs_node.pos.y() ) );
+        const int added = addNode( std::move(abs_node), parent );
+
+        if( bt_model->collapsed() )
+        {
+            // the root of the branch is this node
+            const CompactTree& branch = bt_model->collapsedBranch();
+            copy.collapsed.push_back( added );
+            for (size_t i = 0; i < branch.childrenCount(0); i++)
+            {
+                pushBranch( branch, size_t( branch.child(0, i) ), added );
+            }
+        }
+        else if( bt_model->nodeType() != NodeType::SUBTREE )
+        {
+            for (Node* child: getChildren( *_scene, *node, true ))
+            {
+                if( with_descendants || copied.count( child ) )
+                {
+                    pushNode( child, added );
+                }
+            }
+        }
+    };
+
+    for (Node* root: roots)
+    {
+        pushNode( root, -1 );
+    }
+    for (auto& abs_node: forest)
+    {
+        abs_node.pos -= top_left;
+    }
+    return copy;
+}
+
+std::vector<Node*> GraphicContainer::pasteNodes(const ClipboardNodes& nodes, QPointF scene_pos)
+{
+    std::vector<Node*> pasted;
+    materialize();
+    if( nodes.empty() || _scene->readOnly() )
+    {
+        return pasted;
+    }
+    // the models of nodes copied from another window
+    for (const auto& abs_node: nodes.forest.nodes())
+    {
+        if( !_model_registry->isRegistered( abs_node.model.registration_ID ) )
+        {
+            emit addNewModel( abs_node.model );
+            if( !_model_registry->isRegistered( abs_node.model.registration_ID ) )
+            {
+                return pasted;
+            }
+        }
+    }
+
+    {
+        const QSignalBlocker blocker( this );
+        // the nodes are set up once, at the end of the batch
+        QtNodes::FlowScene::ScopedBatch batch( *_scene );
+        _scene->clearSelection();
+
+        std::function<void(int, Node*)> pasteBranch;
+        pasteBranch = [&](int index, Node* parent)
+        {
+            const AbstractTreeNode& abs_node = *nodes.forest.node( size_t(index) );
+            Node& node = createNodeFromAbs( abs_node, scene_pos + abs_node.pos );
+            if( parent )
+            {
+                _scene->createConnection( node, 0, *parent, 0 );
+            }
+            node.nodeGraphicsObject().setSelected( true );
+            pasted.push_back( &node );
+
+            if( nodes.isCollapsed(index) )
+            {
+                auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
+                bt_model->setCollapsedBranch( CompactTree( nodes.branch(index) ) );
+                node.nodeState().getEntries(PortType::Out).resize(0);
+                _scene->invalidateNodePorts( node );
+                return;
+            }
+            for (int child: abs_node.children_index)
+            {
+                pasteBranch( child, &node );
+            }
+        };
+
+        for (int root: nodes.roots())
+        {
+            pasteBranch( root, nullptr );
+        }
+    }
+    emit undoableChange();
+    return pasted;
+}
+
+namespace {
+
+// the nodes of a collapsed branch, but the collapsed node itself (index 0)
+void CountBranchModels(const CompactTree& branch, std::unordered_map<QString, int>& usage)
+{
+    for (size_t index = 1; index < branch.nodesCount(); index++)
+    {
+        usage[ branch.model(index).registration_ID ]++;
+    }
+}
+
+}
+
+const std::unordered_map<QString, int>& GraphicContainer::modelUsage()
+{
+    if( _model_usage_valid && ( !_materialized || _model_usage_revision == _scene->revision() ) )
+    {
+        return _model_usage;
+    }
+    _model_usage.clear();
+
+    if( !_materialized && _lazy_state.lazy_tree )
+    {
+        for (const auto& abs_node: _lazy_state.lazy_tree->nodes())
+        {
+            _model_usage[ abs_node.model.registration_ID ]++;
+        }
+    }
+    else if( !_materialized )
+    {
+        // the evicted scene, as saved by Node::save()
+        for (const auto& it: _lazy_state.nodes)
+        {
+            const QJsonObject model_json = it.second["model"].toObject();
+            _model_usage[ model_json["name"].toString() ]++;
+            if( model_json.contains("collapsed_branch") )
+            {
+                QByteArray data = QByteArray::fromBase64( model_json["collapsed_branch"].toString().toLatin1() );
+                QDataStream stream( data );
+                stream.setVersion( QDataStream::Qt_5_0 );
+                CountBranchModels( ReadCompactTreeFromStream( stream ), _model_usage );
+            }
+        }
+    }
+    else{
+        for (const auto& it: _scene->nodes())
+        {
+            auto bt_model = dynamic_cast<const BehaviorTreeDataModel*>( it.second->nodeDataModel() );
+            if( bt_model )
+            {
+                _model_usage[ bt_model->model().registration_ID ]++;
+                CountBranchModels( bt_model->collapsedBranch(), _model_usage );
+            }
+        }
+        _model_usage_revision = _scene->revision();
+    }
+    _model_usage_valid = true;
+    return _model_usage;
+}
+
+int GraphicContainer::modelUsage(const QString &ID)
+{
+    const auto& usage = modelUsage();
+    auto it = usage.find( ID );
+    return ( it != usage.end() ) ? it->second : 0;
+}
+
+std::vector<Node*> GraphicContainer::nodesUsingModel(const QString &ID)
+{
+    std::vector<Node*> nodes;
+    if( modelUsage( ID ) == 0 )
+    {
+        return nodes;
+    }
+    for (const auto& it: scene()->nodes())
+    {
+        auto bt_model = dynamic_cast<const BehaviorTreeDataModel*>( it.second->nodeDataModel() );
+        if( bt_model && bt_model->model().registration_ID == ID )
+        {
+            nodes.push_back( it.second.get() );
+        }
+    }
+    return nodes;
+}
+
+void GraphicContainer::substituteCollapsedModel(const QString &prev_ID, const NodeModel &new_model)
+{
+    if( modelUsage( prev_ID ) == 0 )
+    {
+        return;
+    }
+    for (const auto& it: scene()->nodes())
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>( it.second->nodeDataModel() );
+        if( !bt_model || !bt_model->collapsed() )
+        {
+            continue;
+        }
+        const CompactTree& branch = bt_model->collapsedBranch();
+        bool found = false;
+        for (size_t index = 1; index < branch.nodesCount() && !found; index++)
+        {
+            found = ( branch.model(index).registration_ID == prev_ID );
+        }
+        if( !found )
+        {
+            continue;
+        }
+
+        AbsBehaviorTree tree = branch.toAbsTree();
+        for (auto& abs_node: tree.nodes())
+        {
+            if( abs_node.index == 0 || abs_node.model.registration_ID != prev_ID )
+            {
+                continue;
+            }
+            if( abs_node.instance_name == prev_ID || new_model.type == NodeType::SUBTREE )
+            {
+                abs_node.instance_name = new_model.registration_ID;
+            }
+            PortsMapping ports_mapping;
+            for (const auto& port_it: new_model.ports)
+            {
+                auto old_it = abs_node.ports_mapping.find( port_it.first );
+                const bool edited = ( old_it != abs_node.ports_mapping.end() && !old_it->second.isEmpty() );
+                ports_mapping[ port_it.first ] = edited ? old_it->second : port_it.second.default_value;
+            }
+            abs_node.model = new_model;
+            abs_node.ports_mapping = std::move(ports_mapping);
+        }
+        bt_model->setCollapsedBranch( CompactTree( tree ) );
+    }
+    _model_usage_valid = false;
+}
+
+void GraphicContainer::createMorphSubMenu(QtNodes::Node &node, QMenu* nodeMenu)
+{
+    auto bt_model =  dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() );
+    const QString category ( QString::fromStdString( toStr( bt_model->nodeType()) ));
+
+    auto names_in_category = _model_registry->registeredModelsByCategory( category );
+    names_in_category.erase( node.nodeDataModel()->name() );
+
+    QMenu* morph_submenu = nodeMenu->addMenu("Morph into...");
+
+    if( names_in_category.size() == 0)
+    {
+        morph_submenu->setEnabled(false);
+    }
+    else
+    {
+        for(auto& name: names_in_category)
+        {
+            auto action = new QAction(name, morph_submenu);
+            morph_submenu->addAction(action);
+
+            connect( action, &QAction::triggered, this, [this, &node, name]
+            {
+                substituteNode( &node, name);
+                undoableChange();
+            });
+        }
+    }
+}
+
+void GraphicContainer::createSmartRemoveAction(QtNodes::Node &node, QMenu* node_menu)
+{
+    auto *smart_remove = new QAction("Smart Remove ", node_menu);
+    node_menu->addAction(smart_remove);
+
+    NodeState::ConnectionPtrSet conn_in  = node.nodeState().connections(PortType::In, 0);
+    NodeState::ConnectionPtrSet conn_out = node.nodeState().connections(PortType::Out, 0);
+
+    if( conn_in.size() != 1 || conn_out.size() == 0 )
+    {
+        smart_remove->setEnabled(false);
+        return;
+    }
+
+    auto parent_node = conn_in.begin()->second->getNode(PortType::Out);
+    auto policy = parent_node->nodeDataModel()->portOutConnectionPolicy(0);
+
+    if( policy == NodeDataModel::ConnectionPolicy::One && conn_out.size() > 1)
+    {
+        smart_remove->setEnabled(false);
+        return;
+    }
+
+    QtNodes::Node* node_ptr = &node;
+    connect( smart_remove, &QAction::triggered,
+             this, [this, node_ptr]()
+    {
+        onSmartRemove(node_ptr);
+    });
+}
+
+void GraphicContainer::onSmartRemove(QtNodes::Node* node)
+{
+    auto parent_node = GetParentNode( node );
+    NodeState::ConnectionPtrSet conn_out = node->nodeState().connections(PortType::Out, 0);
+
+    if( !parent_node || conn_out.size() == 0 )
+    {
+        return;
+    }
+
+    {
+        const QSignalBlocker blocker(this);
+        for( auto& it: conn_out)
+        {
+            auto child_node = it.second->getNode(PortType::In);
+            _scene->createConnection( *child_node, 0, *parent_node, 0 );
+        }
+        _scene->removeNode( *node );
+        nodeReorder();
+    }
+    undoableChange();
 }
 
 void GraphicContainer::insertNodeInConnection(Connection &connection, QString node_name)
@@ -609,23 +1320,30 @@ void GraphicContainer::onConnectionContextMenu(QtNodes::Connection &connection,
     conn_menu->exec( QCursor::pos() );
 }
 
-void GraphicContainer::recursiveLoadStep(QPointF& cursor,
-                                         AbsBehaviorTree& tree,
-                                         AbstractTreeNode* abs_node,
-                                         Node* parent_node, int nest_level)
+QtNodes::Node& GraphicContainer::createNodeFromAbs(const AbstractTreeNode& abs_node, QPointF pos)
 {
-    Node& new_node = _scene->createNodeAtPos( abs_node->model.registration_ID,
-                                              abs_node->instance_name,
-                                              cursor);
+    Node& new_node = _scene->createNodeAtPos( abs_node.model.registration_ID,
+                                              abs_node.instance_name,
+                                              pos );
     BehaviorTreeDataModel* bt_node = dynamic_cast<BehaviorTreeDataModel*>( new_node.nodeDataModel() );
 
-    for (auto& port_it: abs_node->ports_mapping)
+    for (auto& port_it: abs_node.ports_mapping)
     {
         bt_node->setPortMapping( port_it.first, port_it.second );
     }
     bt_node->initWidget();
 
     new_node.nodeGeometry().recalculateSize();
+    return new_node;
+}
+
+void GraphicContainer::recursiveLoadStep(QPointF& cursor,
+                                         AbsBehaviorTree& tree,
+                                         AbstractTreeNode* abs_node,
+                                         Node* parent_node, int nest_level)
+{
+    Node& new_node = createNodeFromAbs( *abs_node, cursor );
+    BehaviorTreeDataModel* bt_node = dynamic_cast<BehaviorTreeDataModel*>( new_node.nodeDataModel() );
 
     abs_node->pos = cursor;
     abs_node->size = _scene->getNodeSize( new_node );
@@ -639,6 +1357,7 @@ void GraphicContainer::recursiveLoadStep(QPointF& cursor,
         {
             subtree_node->setExpanded(true);
             new_node.nodeState().getEntries(PortType::Out).resize(1);
+            _scene->invalidateNodePorts( new_node );
             subtree_node->expandButton()->setHidden( true );
             emit subtree_node->updateNodeSize();
         }
@@ -660,8 +1379,13 @@ void GraphicContainer::recursiveLoadStep(QPointF& cursor,
 void GraphicContainer::loadSceneFromTree(const AbsBehaviorTree &tree)
 {
     AbsBehaviorTree abs_tree = tree;
+    _materialized = true;
+    _lazy_state = SceneState();
     _scene->clearScene();
 
+    // the nodes are set up once, when the whole tree is loaded
+    QtNodes::FlowScene::ScopedBatch batch( *_scene );
+
     auto& first_qt_node = _scene->createNodeAtPos( "Root", "Root", QPointF(0,0) );
 
     QPointF cursor( - first_qt_node.nodeGeometry().width()*0.5,
@@ -679,7 +1403,7 @@ void GraphicContainer::loadSceneFromTree(const AbsBehaviorTree &tree)
     }
 
     recursiveLoadStep(cursor, abs_tree, root_node, &first_qt_node, 1 );
-    NodeReorder( *_scene, abs_tree );
+    NodeReorder( *_scene, abs_tree, &_tree_layout );
 }
 
 void GraphicContainer::appendTreeToNode(Node &node, AbsBehaviorTree& subtree)
@@ -691,6 +1415,8 @@ void GraphicContainer::appendTreeToNode(Node &node, AbsBehaviorTree& subtree)
         abs_node.graphic_node = nullptr;
     }
 
+    QtNodes::FlowScene::ScopedBatch batch( *_scene );
+
     //--------------------------------------
     QPointF cursor = _scene->getNodePosition(node) + QPointF(100,100);
 
@@ -721,4 +1447,290 @@ void GraphicContainer::loadFromJson(const QByteArray &data)
     scene()->loadFromMemory( data );
 }
 
+void GraphicContainer::loadFromState(const SceneState &state, QtNodes::PortLayout layout)
+{
+    const QSignalBlocker blocker( this );
+    clearScene();
+    _scene->setLayout( layout );
+
+    // as FlowScene::loadFromMemory(), without decoding the document again
+    QtNodes::FlowScene::ScopedBatch batch( *_scene );
+    for (const auto& it: state.nodes)
+    {
+        _scene->restoreNode( it.second );
+    }
+    for (const auto& it: state.connections)
+    {
+        _scene->restoreConnection( it.second );
+    }
+}
+
+SceneState GraphicContainer::sceneState() const
+{
+    if( !_materialized )
+    {
+        return _lazy_state;
+    }
+    SceneState state;
+    for (const auto& it: _scene->nodes())
+    {
+        state.nodes.insert( { it.first, it.second->save() } );
+    }
+    for (const auto& it: _scene->connections())
+    {
+        QJsonObject connection = it.second->save();
+        if( !connection.isEmpty() )
+        {
+            state.connections.insert( { SceneState::connectionKey(connection), connection } );
+        }
+    }
+    return state;
+}
+
+void GraphicContainer::applyCommand(const SceneCommand &command, bool undo)
+{
+    materialize();
+    const QSignalBlocker blocker( this );
+
+    const auto& remove_connections = undo ? command.added_connections : command.removed_connections;
+    const auto& add_connections    = undo ? command.removed_connections : command.added_connections;
+
+    if( !remove_connections.empty() )
+    {
+        std::map<QString, QtNodes::Connection*> connections;
+        for (const auto& it: _scene->connections())
+        {
+            connections[ SceneState::connectionKey( it.second->save() ) ] = it.second.get();
+        }
+        for (const auto& connection_json: remove_connections)
+        {
+            auto it = connections.find( SceneState::connectionKey( connection_json ) );
+            if( it != connections.end() )
+            {
+                _scene->deleteConnection( *it->second );
+            }
+        }
+    }
+
+    for (const auto& edit: command.nodes)
+    {
+        const QJsonObject& target = undo ? edit.before : edit.after;
+        auto node_it = _scene->nodes().find( edit.id );
+        QtNodes::Node* node = (node_it != _scene->nodes().end()) ? node_it->second.get() : nullptr;
+
+        if( node && (target.isEmpty() ||
+                     target["model"].toObject()["name"].toString() != node->nodeDataModel()->name()) )
+        {
+            _scene->removeNode( *node );
+            node = nullptr;
+        }
+        if( target.isEmpty() )
+        {
+            continue;
+        }
+        if( node )
+        {
+            // moved or edited: same id and same model
+            node->restore( target );
+            node->nodeGraphicsObject().setGeometryChanged();
+            node->nodeGraphicsObject().update();
+        }
+        else{
+            _scene->restoreNode( target );
+        }
+    }
+
+    for (const auto& connection_json: add_connections)
+    {
+        _scene->restoreConnection( connection_json );
+    }
+}
+
+void GraphicContainer::setLazyTree(std::shared_ptr<const AbsBehaviorTree> tree)
+{
+    clearScene();
+    _lazy_state.lazy_tree = std::move(tree);
+    _materialized = false;
+    _materialized_state.reset();
+}
+
+void GraphicContainer::setLazyScene(const QByteArray &scene_json)
+{
+    clearScene();
+    QString layout;
+    _lazy_state = SceneState::fromMemory( scene_json, &layout );
+    _lazy_layout = ( layout == "Horizontal" ) ? QtNodes::PortLayout::Horizontal :
+                                                QtNodes::PortLayout::Vertical;
+    _materialized = false;
+    _materialized_state.reset();
+}
+
+EditorFlowScene* GraphicContainer::materializedScene() const
+{
+    // building the scene does not change what the container shows
+    const_cast<GraphicContainer*>(this)->materialize();
+    return _scene;
+}
+
+std::shared_ptr<const SceneState> GraphicContainer::evictedState()
+{
+    if( _materialized || _lazy_state.lazy_tree )
+    {
+        return nullptr;
+    }
+    if( !_evicted_state )
+    {
+        _evicted_state = std::make_shared<const SceneState>( _lazy_state );
+    }
+    return _evicted_state;
+}
+
+void GraphicContainer::materialize()
+{
+    if( _materialized )
+    {
+        return;
+    }
+    _materialized = true;
+    _last_used.start();
+
+    TraceScope trace( "scene", "materialize" );
+
+    const QSignalBlocker blocker( this );
+    SceneState lazy_state;
+    std::swap( lazy_state, _lazy_state );
+    _evicted_state.reset();
+    _model_usage_valid = false;
+
+    if( lazy_state.lazy_tree )
+    {
+        loadSceneFromTree( *lazy_state.lazy_tree );
+        auto abstract_tree = BuildTreeFromScene( _scene );
+        NodeReorder( *_scene, abstract_tree, &_tree_layout );
+    }
+    else{
+        const QtNodes::PortLayout layout = _scene->layout();
+        loadFromState( lazy_state, _lazy_layout );
+        if( layout != _lazy_layout )
+        {
+            auto abstract_tree = BuildTreeFromScene( _scene );
+            _scene->setLayout( layout );
+            NodeReorder( *_scene, abstract_tree, &_tree_layout );
+        }
+    }
+
+    _scene->setReadOnly( _editing_locked );
+    _materialized_state.reset( new SceneState( sceneState() ) );
+    trace.setArgument( "nodes", _scene->nodes().size() );
+}
+
+MemoryUsage GraphicContainer::memoryUsage() const
+{
+    // rough costs of the objects of a scene: Node, NodeGraphicsObject, its
+    // model, geometry, boundary item and effect; the embedded QWidget and its
+    // proxy; a Connection with its graphics object
+    const size_t NODE_BYTES = 6 * 1024;
+    const size_t WIDGET_BYTES = 16 * 1024;
+    const size_t CONNECTION_BYTES = 1024;
+
+    MemoryUsage usage;
+    usage.category = tr("Tabs");
+
+    if( !_materialized )
+    {
+        if( _lazy_state.lazy_tree )
+        {
+            const size_t nodes = _lazy_state.lazy_tree->nodesCount();
+            usage.bytes = nodes * sizeof(AbstractTreeNode);
+            usage.details = tr("not built: a tree of %1 nodes").arg( nodes );
+        }
+        else{
+            usage.bytes = _lazy_state.memoryUsage();
+            // the copy given to the undo history
+            if( _evicted_state )
+            {
+                usage.bytes += usage.bytes;
+            }
+            usage.details = tr("unloaded: %1 saved nodes").arg( _lazy_state.nodes.size() );
+        }
+        return usage;
+    }
+
+    size_t widgets = 0;
+    for (const auto& it: _scene->nodes())
+    {
+        const QtNodes::Node* node = it.second.get();
+        const auto& geometry = node->nodeGeometry();
+        // the pixmap of QGraphicsItem::DeviceCoordinateCache, at zoom 1
+        usage.bytes += NODE_BYTES + size_t( geometry.width() * geometry.height() ) * 4;
+        if( node->nodeDataModel()->embeddedWidget() )
+        {
+            widgets++;
+            usage.bytes += WIDGET_BYTES;
+        }
+    }
+    const size_t connections = _scene->connections().size();
+    usage.bytes += connections * CONNECTION_BYTES;
+    if( _tree )
+    {
+        usage.bytes += _tree->nodesCount() * sizeof(AbstractTreeNode);
+    }
+    if( _materialized_state )
+    {
+        usage.bytes += _materialized_state->memoryUsage();
+    }
+    usage.details = tr("%1 nodes, %2 widgets, %3 connections")
+            .arg( _scene->nodes().size() ).arg( widgets ).arg( connections );
+    return usage;
+}
+
+bool GraphicContainer::evict()
+{
+    if( !_materialized )
+    {
+        return false;
+    }
+    for (const auto& it: _scene->nodes())
+    {
+        auto subtree = dynamic_cast<SubtreeNodeModel*>( it.second->nodeDataModel() );
+        if( subtree && subtree->expanded() )
+        {
+            return false;
+        }
+    }
+    SceneState state = sceneState();
+    _lazy_layout = _scene->layout();
+    clearScene();
+    _tree_layout.clear();
+    _lazy_state = std::move(state);
+    _materialized = false;
+    return true;
+}
+
+void GraphicContainer::setLazyLayout(QtNodes::PortLayout layout)
+{
+    if( !_materialized )
+    {
+        _scene->setLayout( layout );
+    }
+}
+
+bool GraphicContainer::takeMaterializedState(SceneState *state)
+{
+    if( !_materialized_state )
+    {
+        return false;
+    }
+    *state = std::move( *_materialized_state );
+    _materialized_state.reset();
+    return true;
+}
+
+bool GraphicContainer::takeSceneChanged()
+{
+    bool changed = _scene_changed;
+    _scene_changed = false;
+    return changed;
+}
+
 
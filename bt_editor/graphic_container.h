@@ -4,15 +4,24 @@
 #include <QObject>
 #include <QWidget>
 #include <QLineEdit>
+#include <QElapsedTimer>
+#include <array>
+#include <unordered_map>
 
 #include "bt_editor_base.h"
 #include "editor_flowscene.h"
+#include "undo_history.h"
+#include "tree_layout.h"
+#include "memory_report.h"
+#include "tree_clipboard.h"
 
 #include <nodes/Node>
 #include <nodes/NodeData>
 #include <nodes/FlowScene>
 #include <nodes/DataModelRegistry>
 #include <nodes/FlowView>
+#include <nodes/NodeStyle>
+#include <nodes/ConnectionStyle>
 
 class GraphicContainer : public QObject
 {
@@ -21,12 +30,65 @@ public:
     explicit GraphicContainer(std::shared_ptr<QtNodes::DataModelRegistry> registry,
                               QWidget *parent = nullptr);
 
-    EditorFlowScene* scene() { return _scene; }
+    // the scene is built, if it was not yet, before it is returned
+    EditorFlowScene* scene() { materialize(); return _scene; }
     QtNodes::FlowView*  view() { return _view; }
 
-    const EditorFlowScene* scene()  const{ return _scene; }
+    const EditorFlowScene* scene()  const{ return materializedScene(); }
     const QtNodes::FlowView* view() const { return _view; }
 
+    // The scene of the tab is built only when it is first needed (shown,
+    // expanded as a subtree, saved...). Until then the tab keeps only the
+    // tree it has to show.
+    void setLazyTree(std::shared_ptr<const AbsBehaviorTree> tree);
+
+    void setLazyTree(const AbsBehaviorTree& tree)
+    {
+        setLazyTree( std::make_shared<const AbsBehaviorTree>(tree) );
+    }
+
+    // As an evicted tab: the scene saved by FlowScene::saveToMemory() is
+    // restored, with its positions, when it is needed.
+    void setLazyScene(const QByteArray& scene_json);
+
+    bool isMaterialized() const { return _materialized; }
+
+    // the tree of a tab whose scene was never built, nullptr otherwise
+    std::shared_ptr<const AbsBehaviorTree> lazyTree() const
+    {
+        return _materialized ? nullptr : _lazy_state.lazy_tree;
+    }
+
+    // the saved state of an evicted tab (or one loaded as such), nullptr if
+    // its scene is built or it has a lazy tree. The same until it is built
+    std::shared_ptr<const SceneState> evictedState();
+
+    void materialize();
+
+    // Destroy the nodes of the scene, keeping their saved state: they are
+    // restored, with the same ids, when the scene is needed again. Returns
+    // false if the scene can not be evicted (expanded subtrees are not
+    // saved in the state of a node).
+    bool evict();
+
+    void setLazyLayout(QtNodes::PortLayout layout);
+
+    // the shapes of a layout of the scene computed elsewhere (see TreeLayout)
+    void setTreeLayout(TreeLayout&& tree_layout) { _tree_layout = std::move(tree_layout); }
+
+    // milliseconds since the tab was built or markUsed() was called
+    qint64 msecsSinceUsed() const { return _last_used.elapsed(); }
+
+    void markUsed() { _last_used.restart(); }
+
+    // the scene (or its saved state) and the copies of it kept here. The
+    // name and the release action are set by the owner of the tab
+    MemoryUsage memoryUsage() const;
+
+    // the state of the scene right after it was built, if it was built since
+    // the previous call. The undo history takes it as it is, not as a change
+    bool takeMaterializedState(SceneState* state);
+
     void lockEditing(bool locked);
 
     void lockSubtreeEditing(QtNodes::Node& node, bool locked, bool change_style);
@@ -35,18 +97,57 @@ public:
 
     void zoomHomeView();
 
+    // select the node, alone, and center the view on it
+    void focusNode(QtNodes::Node& node);
+
     bool containsValidTree() const;
 
     void clearScene();
 
     AbsBehaviorTree loadedTree() const;
 
+    // The tree of the scene, with the collapsed branches. It is kept up to
+    // date: built again only after the structure or the layout of the scene
+    // changed, edited in place when a port or a name is. The snapshot
+    // returned is never modified: it can be kept, or read by another thread.
+    std::shared_ptr<const AbsBehaviorTree> tree();
+
+    // The nodes of the scene, indexed as in BuildTreeFromScene() with the
+    // collapsed branches: their nodes are null. Cached: it is built again
+    // only when the structure of the scene changes.
+    const std::vector<QtNodes::Node*>& nodesByIndex();
+
+    // Style of a node (and of the connection with its parent) given its status,
+    // see getStyleFromStatus. Nothing is repainted if the node shows it already.
+    void setNodeStatusStyle(int index, NodeStatus status, NodeStatus prev_status);
+
+    // the default style, for all the nodes
+    void resetNodeStatusStyles();
+
+    // A small label above the node, moved and destroyed with it. An empty
+    // text removes it. Ignored for the nodes of the collapsed branches.
+    void setNodeTimingBadge(int index, const QString& text);
+
+    void clearNodeTimingBadges();
+
     void loadSceneFromTree(const AbsBehaviorTree &tree);
 
     void appendTreeToNode(QtNodes::Node& node, AbsBehaviorTree &subtree);
 
+    // any format of FlowScene::saveToMemory()
     void loadFromJson(const QByteArray& data);
 
+    void loadFromState(const SceneState& state, QtNodes::PortLayout layout);
+
+    SceneState sceneState() const;
+
+    // apply a command of the undo history, in one direction or the other
+    void applyCommand(const SceneCommand& command, bool undo);
+
+    // true if the scene was edited since the previous call, even with the
+    // signals of this object blocked
+    bool takeSceneChanged();
+
     QtNodes::Node* substituteNode(QtNodes::Node* old_node, const QString& new_node_ID);
 
     void deleteSubTreeRecursively(QtNodes::Node& node);
@@ -55,14 +156,52 @@ public:
 
     void createSubtree(QtNodes::Node& root_node, QString subtree_name = QString());
 
+    // A collapsed node keeps its descendants in its model, out of the scene:
+    // see BehaviorTreeDataModel::collapsedBranch()
+    bool canCollapseBranch(QtNodes::Node& node) const;
+
+    void collapseBranch(QtNodes::Node& node);
+
+    void expandBranch(QtNodes::Node& node);
+
+    // the collapsed nodes under root_node, root_node included
+    void expandCollapsedBranches(QtNodes::Node& root_node);
+
+    // The nodes, and the connections between them; with all their
+    // descendants if with_descendants. The content of the expanded subtrees
+    // is not copied, it is the one of their tab.
+    ClipboardNodes copyNodes(const std::vector<QtNodes::Node*>& nodes, bool with_descendants);
+
+    // Create the nodes in a single batch of the scene, and a single undo step.
+    // They are placed relative to scene_pos and selected.
+    std::vector<QtNodes::Node*> pasteNodes(const ClipboardNodes& nodes, QPointF scene_pos);
+
+    // How many nodes of the tab use each model, by registration ID, the
+    // nodes of the collapsed branches included. The scene is not built to
+    // count them: a tab not materialized counts its saved tree. Cached, it is
+    // counted again only after the scene changed.
+    const std::unordered_map<QString, int>& modelUsage();
+
+    int modelUsage(const QString& ID);
+
+    // the nodes of the scene using the model. The scene is built only if the
+    // tab uses it; the nodes of the collapsed branches are not included
+    std::vector<QtNodes::Node*> nodesUsingModel(const QString& ID);
+
+    // Replace the model prev_ID by new_model in the collapsed branches, keeping
+    // the edited instance names and ports, as substituteNode() does
+    void substituteCollapsedModel(const QString& prev_ID, const NodeModel& new_model);
+
 public slots:
 
     void onNodeDoubleClicked(QtNodes::Node& root_node);
 
-    void onPortValueDoubleClicked(QLineEdit* edit_value);
+    void onPortValueDoubleClicked(QString value);
 
     void onNodeCreated(QtNodes::Node &node);
 
+    void onStructureChanged(const std::vector<QtNodes::Node*>& created_nodes);
+
     void onNodeContextMenu(QtNodes::Node& node, const QPointF& pos);
 
     void onConnectionContextMenu(QtNodes::Connection &connection, const QPointF&);
@@ -90,6 +229,12 @@ private:
 
    void insertNodeInConnection(QtNodes::Connection &connection, QString node_name);
 
+   // connect the signals of the model of a new node
+   void setupNode(QtNodes::Node& node);
+
+   // a node of the scene with the name and the ports of abs_node
+   QtNodes::Node& createNodeFromAbs(const AbstractTreeNode& abs_node, QPointF pos);
+
    void recursiveLoadStep(QPointF &cursor, AbsBehaviorTree &tree,
                           AbstractTreeNode *abs_node,
                           QtNodes::Node* parent_node, int nest_level);
@@ -98,6 +243,54 @@ private:
 
    bool _signal_was_blocked;
 
+   void applyStyle(QtNodes::Node* node, const QtNodes::NodeStyle& node_style,
+                   const QtNodes::ConnectionStyle& conn_style);
+
+   // status of a node of a collapsed branch
+   void setCollapsedNodeStatus(int index, NodeStatus status);
+
+   static NodeStatus aggregatedStatus(const std::array<int,4>& counts);
+
+   std::vector<QtNodes::Node*> _nodes_by_index;
+   // style displayed by each node of _nodes_by_index
+   enum { UNKNOWN_STYLE = -1, DEFAULT_STYLE = -2 };
+   std::vector<int> _displayed_styles;
+   // for the nodes of a collapsed branch: the index of the collapsed node,
+   // whose badge shows the status of the branch. -1 for the others
+   std::vector<int> _collapsed_owner;
+   std::vector<NodeStatus> _collapsed_status;
+   // by index of collapsed node: how many of its hidden nodes have each status
+   std::vector<std::array<int,4>> _collapsed_counts;
+   // revision of the scene they were built at: some changes are done with
+   // the signals of the scene blocked
+   quint64 _nodes_by_index_revision;
+
+   std::shared_ptr<AbsBehaviorTree> _tree;
+   quint64 _tree_revision;
+   std::unordered_map<const QtNodes::Node*, int> _tree_index;
+   void updateTreeNode(const QtNodes::Node& node);
+
+   bool _scene_changed;
+
+   bool _materialized;
+   // what is shown once materialized: a tree or the state of the evicted scene
+   SceneState _lazy_state;
+   std::shared_ptr<const SceneState> _evicted_state;
+   QtNodes::PortLayout _lazy_layout;
+   std::unique_ptr<SceneState> _materialized_state;
+   bool _editing_locked;
+   QElapsedTimer _last_used;
+   // the shapes of the last layout of the scene, see nodeReorder()
+   TreeLayout _tree_layout;
+
+   std::unordered_map<QString, int> _model_usage;
+   // the scene revision it was counted at; not valid after the scene was
+   // replaced, or a collapsed branch edited
+   quint64 _model_usage_revision;
+   bool _model_usage_valid;
+
+   EditorFlowScene* materializedScene() const;
+
 };
 
 #endif // GRAPHIC_CONTAINER_H
@@ -0,0 +1,113 @@
+#include "log_recorder.h"
+
+#include <chrono>
+#include <QDebug>
+#include <QtEndian>
+
+LogRecorder::LogRecorder():
+    _stop(false),
+    _bytes_written(0),
+    _failed(false)
+{
+}
+
+LogRecorder::~LogRecorder()
+{
+    close();
+}
+
+bool LogRecorder::open(const QString &filename, const QByteArray &tree_buffer)
+{
+    close();
+
+    _file.reset( new QFile(filename) );
+    if( !_file->open(QIODevice::WriteOnly) )
+    {
+        qDebug() << "Can't record to" << filename << ":" << _file->errorString();
+        _file.reset();
+        return false;
+    }
+    _filename = filename;
+    _bytes_written = 0;
+    _failed = false;
+
+    // same header of the .fbl files of BT::FileLogger
+    QByteArray header( 4, '\0' );
+    qToLittleEndian<quint32>( quint32(tree_buffer.size()), reinterpret_cast<uchar*>(header.data()) );
+    header.append( tree_buffer );
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending = header;
+        _stop = false;
+    }
+    _thread = std::thread( &LogRecorder::loop, this );
+    return true;
+}
+
+void LogRecorder::append(const QByteArray &records)
+{
+    if( !isOpen() )
+    {
+        return;
+    }
+    bool wake_up = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.append( records );
+        wake_up = _pending.size() >= FLUSH_SIZE;
+    }
+    if( wake_up )
+    {
+        _condition.notify_one();
+    }
+}
+
+void LogRecorder::close()
+{
+    if( !_thread.joinable() )
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_one();
+    _thread.join();
+    _file.reset();
+}
+
+void LogRecorder::loop()
+{
+    QByteArray chunk;
+    bool stop = false;
+
+    while( !stop )
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait_for( lock, std::chrono::milliseconds( int(FLUSH_PERIOD_MS) ),
+                                 [this]() { return _stop || _pending.size() >= FLUSH_SIZE; } );
+            chunk.swap( _pending );
+            stop = _stop;
+        }
+
+        if( chunk.isEmpty() || _failed )
+        {
+            chunk.clear();
+            continue;
+        }
+        // flush to the OS at every chunk: a crash of Groot loses nothing
+        if( _file->write( chunk ) != chunk.size() || !_file->flush() )
+        {
+            qDebug() << "Recording to" << _filename << "failed:" << _file->errorString();
+            _failed = true;
+        }
+        else{
+            _bytes_written += size_t( chunk.size() );
+        }
+        chunk.clear();
+    }
+    _file->close();
+}
@@ -0,0 +1,63 @@
+#ifndef LOG_RECORDER_H
+#define LOG_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Writes a .fbl log (the format read by SidepanelReplay) in a background
+// thread: the caller only appends to a buffer and never waits for the disk.
+// The buffer is written in large chunks and flushed periodically.
+class LogRecorder
+{
+public:
+    /// Period of the writes to the file, in milliseconds.
+    static constexpr int FLUSH_PERIOD_MS = 200;
+    /// Pending bytes that wake up the writer before FLUSH_PERIOD_MS.
+    static constexpr int FLUSH_SIZE = 1 << 20;
+
+    LogRecorder();
+
+    // close the file, after writing what is pending
+    ~LogRecorder();
+
+    // create the file, the header is the flatbuffers BehaviorTree
+    bool open(const QString& filename, const QByteArray& tree_buffer);
+
+    // records in the .fbl layout, see ReplayLogFormat::appendRecord
+    void append(const QByteArray& records);
+
+    void close();
+
+    bool isOpen() const { return _thread.joinable(); }
+
+    const QString& filename() const { return _filename; }
+
+    size_t bytesWritten() const { return _bytes_written; }
+
+    // true if a write failed, for instance because the disk is full
+    bool failed() const { return _failed; }
+
+private:
+    void loop();
+
+    // used only by the thread while it is running
+    std::unique_ptr<QFile> _file;
+    QString _filename;
+    std::thread _thread;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    QByteArray _pending;    // guarded by _mutex
+    bool _stop;             // guarded by _mutex
+
+    std::atomic<size_t> _bytes_written;
+    std::atomic<bool> _failed;
+};
+
+#endif // LOG_RECORDER_H
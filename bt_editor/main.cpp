@@ -1,16 +1,26 @@
 #include <QCommandLineParser>
 #include <QApplication>
+#include <QCoreApplication>
 #include <QDialog>
 #include <nodes/NodeStyle>
 #include <nodes/FlowViewStyle>
 #include <nodes/ConnectionStyle>
 #include <nodes/DataModelRegistry>
+#include <nodes/FlowView>
+#include <nodes/FlowScene>
 
 #include "mainwindow.h"
 #include "XML_utilities.hpp"
 #include "startup_dialog.h"
+#include "batch_mode.h"
+#include "replay_frame_export.h"
+#include "trace_recorder.h"
+#include "startup_timing.h"
 #include "models/RootNodeModel.hpp"
 
+#include <cstring>
+#include <QTimer>
+
 using QtNodes::DataModelRegistry;
 using QtNodes::FlowViewStyle;
 using QtNodes::NodeStyle;
@@ -19,7 +29,46 @@ using QtNodes::ConnectionStyle;
 int
 main(int argc, char *argv[])
 {
+    StartupTiming::start();
+
+    // the batch modes need no display: they are chosen before the QApplication
+    for (int i = 1; i < argc; i++)
+    {
+        const bool batch = ( std::strcmp( argv[i], "--batch" ) == 0 );
+        if( batch || std::strcmp( argv[i], "--analyze-log" ) == 0 )
+        {
+            QCoreApplication batch_app(argc, argv);
+            batch_app.setApplicationName("Groot");
+            batch_app.setOrganizationName("EurecatRobotics");
+            batch_app.setOrganizationDomain("eurecat.org");
+            return batch ? RunBatchMode( batch_app ) : RunLogAnalyzer( batch_app );
+        }
+    }
+
+    // the export draws the tree offscreen: it needs widgets, not a display
+    for (int i = 1; i < argc; i++)
+    {
+        if( std::strcmp( argv[i], "--export-replay" ) == 0 )
+        {
+            if( qEnvironmentVariableIsEmpty( "QT_QPA_PLATFORM" ) )
+            {
+                qputenv( "QT_QPA_PLATFORM", "offscreen" );
+            }
+            QApplication export_app(argc, argv);
+            export_app.setApplicationName("Groot");
+            export_app.setOrganizationName("EurecatRobotics");
+            export_app.setOrganizationDomain("eurecat.org");
+            qRegisterMetaType<AbsBehaviorTree>();
+
+            QFile styleFile( ":/stylesheet.qss" );
+            styleFile.open( QFile::ReadOnly );
+            export_app.setStyleSheet( QString::fromUtf8( styleFile.readAll() ) );
+            return RunReplayExport( export_app );
+        }
+    }
+
     QApplication app(argc, argv);
+    StartupTiming::mark( "application" );
     app.setApplicationName("Groot");
     app.setWindowIcon(QPixmap(":/icons/BT.png"));
     app.setOrganizationName("EurecatRobotics");
@@ -52,16 +101,76 @@ main(int argc, char *argv[])
                                        "Server port number (defaults to 1667)",
                                        "server_port");
     parser.addOption(srv_port_option);
+    QCommandLineOption transport_option(QStringList() << "transport",
+                                        "Transport of the monitor: [tcp,ipc,shm] (defaults to tcp). "
+                                        "ipc and shm are only for a publisher on the same host",
+                                        "transport");
+    parser.addOption(transport_option);
     QCommandLineOption autoconnect_option(QStringList() << "autoconnect",
                                           "Autoconnect to monitor");
     parser.addOption(autoconnect_option);
+    QCommandLineOption opengl_option(QStringList() << "opengl",
+                                     "Draw the trees with OpenGL");
+    parser.addOption(opengl_option);
+    QCommandLineOption virtualize_option(QStringList() << "virtualize",
+                                         "Attach the widgets only to the visible nodes (for huge trees)");
+    parser.addOption(virtualize_option);
+    QCommandLineOption batch_option(QStringList() << "batch",
+                                    "Process files without any window: [validate,normalize,stats] files...",
+                                    "command");
+    parser.addOption(batch_option);
+    QCommandLineOption analyze_option(QStringList() << "analyze-log",
+                                      "Print the statistics of replay logs, without any window: "
+                                      "[--format csv|json] logs...");
+    parser.addOption(analyze_option);
+    QCommandLineOption export_option(QStringList() << "export-replay",
+                                     "Write the frames of a log as a video or PNG files, without any window: "
+                                     "[--fps n] [--speed n] [--scale n] log output");
+    parser.addOption(export_option);
+    QCommandLineOption trace_option(QStringList() << "trace",
+                                    "Record the internal operations, written as Chrome trace JSON at exit",
+                                    "file");
+    parser.addOption(trace_option);
+    QCommandLineOption startup_timing_option(QStringList() << "startup-timing",
+                                             "Print the time taken by the steps of the startup");
+    parser.addOption(startup_timing_option);
 
     parser.process( app );
 
+    StartupTiming::setPrintEnabled( parser.isSet(startup_timing_option) );
+
+    const QString trace_filename = parser.value(trace_option);
+    if( !trace_filename.isEmpty() )
+    {
+        TraceRecorder::setEnabled( true );
+    }
+    auto exec = [&app, &trace_filename]()
+    {
+        const int result = app.exec();
+        if( !trace_filename.isEmpty() )
+        {
+            const QString error = TraceRecorder::writeChromeTrace( trace_filename );
+            if( !error.isEmpty() )
+            {
+                std::cout << "can not write the trace " << trace_filename.toStdString()
+                          << ": " << error.toStdString() << std::endl;
+            }
+        }
+        return result;
+    };
+
+    QtNodes::FlowScene::setVirtualizedByDefault( parser.isSet(virtualize_option) );
+
+    if( parser.isSet(opengl_option) && !QtNodes::FlowView::setOpenGLViewport(true) )
+    {
+        std::cout << "OpenGL is not available: the trees are drawn without it" << std::endl;
+    }
+
+    // before any widget: setting it later polishes all of them again
     QFile styleFile( ":/stylesheet.qss" );
     styleFile.open( QFile::ReadOnly );
-    QString style( styleFile.readAll() );
-    app.setStyleSheet( style );
+    app.setStyleSheet( QString::fromUtf8( styleFile.readAll() ) );
+    StartupTiming::mark( "style" );
 
     if( parser.isSet(test_option) )
     {
@@ -69,7 +178,7 @@ main(int argc, char *argv[])
         win.setWindowTitle("Groot");
         win.show();
         win.loadFromXML( ":/crossdoor_with_subtree.xml" );
-        return app.exec();
+        return exec();
     }
     else{
         auto mode = GraphicMode::EDITOR;
@@ -103,10 +212,29 @@ main(int argc, char *argv[])
                 return 0;
             }
             mode = dialog.getGraphicMode();
+            StartupTiming::mark( "startup dialog" );
         }
 
         // Get the monitor options.
-        const QString monitor_address = parser.value(address_option);
+        QString monitor_address = parser.value(address_option);
+        const QString transport = parser.value(transport_option).toLower();
+        if( !transport.isEmpty() && transport != "tcp" && !monitor_address.contains("://") )
+        {
+            // ipc:///tmp/groot:1666 or the shared memory segment "/groot"
+            if( transport == "ipc" )
+            {
+                monitor_address = "ipc://" + ( monitor_address.isEmpty() ? QString("/tmp/groot") : monitor_address );
+            }
+            else if( transport == "shm" )
+            {
+                monitor_address = "shm://" + ( monitor_address.isEmpty() ? QString("groot") : monitor_address );
+            }
+            else {
+                std::cout << "wrong transport passed to --transport. Use one of these: tcp / ipc / shm"
+                          << std::endl;
+                return 0;
+            }
+        }
         const QString monitor_pub_port = parser.value(pub_port_option);
         const QString monitor_srv_port = parser.value(srv_port_option);
         const bool monitor_autoconnect = parser.isSet(autoconnect_option);
@@ -114,7 +242,22 @@ main(int argc, char *argv[])
         // Start the main application.
         MainWindow win( mode, monitor_address, monitor_pub_port,
                         monitor_srv_port, monitor_autoconnect );
+        StartupTiming::mark( "main window" );
         win.show();
-        return app.exec();
+        win.recoverAutosave();
+
+        // a monitored tree is shown once its status arrives, see MainWindow
+        const bool wait_status = ( mode == GraphicMode::MONITOR && monitor_autoconnect );
+        QTimer::singleShot( 0, [wait_status]()
+        {
+            if( wait_status )
+            {
+                StartupTiming::mark( "event loop" );
+            }
+            else{
+                StartupTiming::finish( "event loop" );
+            }
+        });
+        return exec();
     }
 }
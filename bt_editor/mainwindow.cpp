@@ -14,19 +14,38 @@
 #include <QTreeWidgetItem>
 #include <QSvgWidget>
 #include <QShortcut>
+#include <QCursor>
 #include <QTabBar>
 #include <QXmlStreamWriter>
 #include <QDesktopServices>
 #include <QInputDialog>
+#include <QStandardPaths>
+#include <QDockWidget>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QFormLayout>
+#include <QProgressDialog>
+#include <QDateTime>
+#include <QLockFile>
+#include <QRegExp>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtConcurrent/QtConcurrentMap>
 #include <nodes/Node>
 #include <nodes/NodeData>
 #include <nodes/NodeStyle>
 #include <nodes/FlowView>
+#include <nodes/PaintProfiler>
 #include <thread>
+#include <algorithm>
 
 #include "editor_flowscene.h"
 #include "utils.h"
 #include "XML_utilities.hpp"
+#include "trace_recorder.h"
+#include "memory_report.h"
+#include "startup_timing.h"
+#include "model_database.h"
 
 #include "models/RootNodeModel.hpp"
 #include "models/SubtreeNodeModel.hpp"
@@ -41,6 +60,78 @@ using QtNodes::FlowScene;
 using QtNodes::NodeGraphicsObject;
 using QtNodes::NodeState;
 
+// by the windows of the process, see autosaveFilename()
+static std::set<int> UsedWindowNumbers;
+
+// The windows of a process autosave to "autosave_<session>_<window>.xml",
+// where the session is unique to the process. "autosave_<session>.lock" is
+// held while the process runs: the files of a session whose lock is not held
+// were left by a process that did not exit cleanly.
+static QString AutosaveDirectory()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::AppDataLocation );
+}
+
+static QString AutosaveSession()
+{
+    static QString session;
+    static std::unique_ptr<QLockFile> lock;
+    if( session.isEmpty() )
+    {
+        // the pid alone may be the one of a session that crashed
+        session = QString("%1-%2").arg( QCoreApplication::applicationPid() )
+                                  .arg( QDateTime::currentMSecsSinceEpoch() );
+        QDir().mkpath( AutosaveDirectory() );
+        lock.reset( new QLockFile( AutosaveDirectory() + "/autosave_" + session + ".lock" ) );
+        lock->setStaleLockTime( 0 );
+        lock->tryLock( 0 );
+    }
+    return session;
+}
+
+// the autosaved files of the other sessions, if they are not running
+static QStringList OrphanAutosaveFiles()
+{
+    const QString own_prefix = "autosave_" + AutosaveSession() + "_";
+    const QDir directory( AutosaveDirectory() );
+    QRegExp session_name( "autosave_(\\d+-\\d+)_\\d+\\.xml" );
+    std::map<QString, bool> running;
+    QStringList orphans;
+
+    for (const QString& name: directory.entryList( QStringList() << "autosave*.xml", QDir::Files, QDir::Name ))
+    {
+        if( name.startsWith( own_prefix ) )
+        {
+            continue;
+        }
+        // the files of the previous versions have no session
+        if( session_name.exactMatch( name ) )
+        {
+            const QString session = session_name.cap( 1 );
+            auto it = running.find( session );
+            if( it == running.end() )
+            {
+                // taken only if its process is gone, and released at once
+                QLockFile lock( directory.filePath( "autosave_" + session + ".lock" ) );
+                lock.setStaleLockTime( 0 );
+                it = running.insert( { session, !lock.tryLock( 0 ) } ).first;
+            }
+            if( it->second )
+            {
+                continue;
+            }
+        }
+        orphans.push_back( directory.filePath( name ) );
+    }
+    return orphans;
+}
+
+static QString layoutName(QtNodes::PortLayout layout)
+{
+    return (layout == QtNodes::PortLayout::Horizontal) ?
+                QStringLiteral("Horizontal") : QStringLiteral("Vertical");
+}
+
 MainWindow::MainWindow(GraphicMode initial_mode,
                        const QString& monitor_address,
                        const QString& monitor_pub_port,
@@ -54,85 +145,121 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     _monitor_address(monitor_address),
     _monitor_publisher_port(monitor_pub_port),
     _monitor_server_port(monitor_srv_port),
-    _monitor_autoconnect(monitor_autoconnect)
+    _monitor_autoconnect(monitor_autoconnect),
+    _undo_memory(0),
+    _autosave_pending(false),
+    _autosave_deferred(false),
+    _project_modified(false),
+    _profiler_overlay(false)
 {
     ui->setupUi(this);
 
+    _window_number = 0;
+    while( UsedWindowNumbers.count( _window_number ) > 0 )
+    {
+        _window_number++;
+    }
+    UsedWindowNumbers.insert( _window_number );
+
     QSettings settings;
     restoreGeometry(settings.value("MainWindow/geometry").toByteArray());
     restoreState(settings.value("MainWindow/windowState").toByteArray());
 
-    const QString layout = settings.value("MainWindow/layout").toString();
-    if( layout == "HORIZONTAL")
+    const int undo_budget_MB = std::max( 1, settings.value("MainWindow/undoMemoryBudgetMB", 256).toInt() );
+    _undo_memory_budget = size_t(undo_budget_MB) * 1024 * 1024;
+
+    // 0 means that the scenes of the tabs are never evicted
+    _tab_eviction_minutes = std::max( 0, settings.value("MainWindow/tabEvictionMinutes", 0).toInt() );
+    if( _tab_eviction_minutes > 0 )
     {
-        _current_layout = QtNodes::PortLayout::Horizontal;
-    }
-    else{
-        _current_layout = QtNodes::PortLayout::Vertical;
+        auto eviction_timer = new QTimer(this);
+        connect( eviction_timer, &QTimer::timeout, this, &MainWindow::evictUnusedTabs );
+        eviction_timer->start( 60 * 1000 );
     }
 
-    _model_registry = std::make_shared<QtNodes::DataModelRegistry>();
-
-    //------------------------------------------------------
+    // 0 disables the autosave
+    _autosave_seconds = std::max( 0, settings.value("MainWindow/autosaveSeconds", 60).toInt() );
+    if( _autosave_seconds > 0 )
+    {
+        auto autosave_timer = new QTimer(this);
+        connect( autosave_timer, &QTimer::timeout, this, &MainWindow::onAutosave );
+        autosave_timer->start( _autosave_seconds * 1000 );
+    }
 
-    auto registerModel = [this](const QString& ID, const NodeModel& model)
+    connect( &_save_watcher, &QFutureWatcher<QString>::finished, this, [this]()
     {
-        QString category = QString::fromStdString( BT::toStr(model.type) );
-        if( ID == "Root")
+        const QString error = _save_watcher.result();
+        if( !error.isEmpty() )
         {
-            category = "Root";
+            QMessageBox::warning(this, tr("Oops!"),
+                                 tr("File can not be saved: %1").arg(error),
+                                 QMessageBox::Cancel);
+            return;
         }
-        QtNodes::DataModelRegistry::RegistryItemCreator creator;
-        creator = [model]() -> QtNodes::DataModelRegistry::RegistryItemPtr
+        QFile file( _save_filename );
+        if( file.open(QIODevice::ReadOnly) )
         {
-            auto ptr = new BehaviorTreeDataModel( model );
-            return std::unique_ptr<BehaviorTreeDataModel>(ptr);
-        };
-        _model_registry->registerModel( category, creator, ID );
-    };
+            _project_hash = ProjectCache::hashOf( file.readAll() );
+        }
+    });
 
-    for(const auto& model: BuiltinNodeModels())
+    connect( &_layout_watcher, &QFutureWatcher<void>::finished, this, [this]()
     {
-        registerModel( model.first, model.second );
-        _treenode_models.insert( { model.first, model.second } );
-        qDebug() << "adding model: " << model.first;
+        if( !_layout_watcher.isCanceled() )
+        {
+            applyLayoutJobs();
+        }
+    });
+
+    const QString layout = settings.value("MainWindow/layout").toString();
+    if( layout == "HORIZONTAL")
+    {
+        _current_layout = QtNodes::PortLayout::Horizontal;
+    }
+    else{
+        _current_layout = QtNodes::PortLayout::Vertical;
     }
-    //------------------------------------------------------
 
-    _editor_widget = new SidepanelEditor(_model_registry.get(), _treenode_models, this);
-    _replay_widget = new SidepanelReplay(this);
+    _model_registry = std::make_shared<QtNodes::DataModelRegistry>();
+
+    // shared with the other windows; the editor starts with the palettes
+    // imported in the previous session too
+    const ModelDatabase::Ptr model_database = ( _current_mode == GraphicMode::EDITOR ) ?
+                ModelDatabase::withPalettes() : ModelDatabase::builtin();
+    model_database->registerModels( *_model_registry );
+    _treenode_models = model_database->models();
 
+    // the panels of Replay and Monitor mode are created when the mode is
+    // used, see replayWidget() and monitorWidget()
+    _editor_widget = new SidepanelEditor(_model_registry.get(), _treenode_models, this);
     ui->leftFrame->layout()->addWidget( _editor_widget );
-    ui->leftFrame->layout()->addWidget( _replay_widget );
+    _editor_widget->setModelUsageFunction( [this](const QString& ID)
+    {
+        return modelUsage( ID );
+    });
+    _replay_widget = nullptr;
 
 #ifdef ZMQ_FOUND
-    _monitor_widget = new SidepanelMonitor(
-        this, _monitor_address, _monitor_publisher_port, _monitor_server_port);
-    ui->leftFrame->layout()->addWidget( _monitor_widget );
-
-    connect( ui->toolButtonConnect, &QToolButton::clicked,
-            _monitor_widget, &SidepanelMonitor::on_Connect );
+    _monitor_widget = nullptr;
+#else
+    ui->actionMonitor_mode->setVisible(false);
+#endif
 
-    connect( _monitor_widget, &SidepanelMonitor::connectionUpdate,
-            this, &MainWindow::onConnectionUpdate );
+    updateCurrentMode();
 
-    if ( monitor_autoconnect )
+#ifdef ZMQ_FOUND
+    if ( monitor_autoconnect && _current_mode == GraphicMode::MONITOR )
     {
         // If autoconnecting, increase the timeout to get the behavior tree to a
         // larger value. This only lasts for one "connect" before returning to
         // its default value.
-        _monitor_widget->set_load_tree_timeout_ms(
-            _monitor_widget->_load_tree_autoconnect_timeout_ms);
-        ui->toolButtonConnect->animateClick();
+        monitorWidget()->set_load_tree_timeout_ms(
+            SidepanelMonitor::_load_tree_autoconnect_timeout_ms);
+        // the tree is downloaded while the window is shown
+        monitorWidget()->on_Connect();
     }
-#else
-    ui->actionMonitor_mode->setVisible(false);
 #endif
 
-    updateCurrentMode();
-
-    dynamic_cast<QVBoxLayout*>(ui->leftFrame->layout())->setStretch(1,1);
-
     auto arrange_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_A), this);
 
     connect( arrange_shortcut, &QShortcut::activated,
@@ -147,6 +274,18 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     QShortcut* redo_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_Z), this);
     connect( redo_shortcut, &QShortcut::activated, this, &MainWindow::onRedoInvoked );
 
+    QShortcut* copy_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_C), this);
+    connect( copy_shortcut, &QShortcut::activated, this, [this]() { onCopyNodes(false); } );
+
+    QShortcut* copy_branches_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_C), this);
+    connect( copy_branches_shortcut, &QShortcut::activated, this, [this]() { onCopyNodes(true); } );
+
+    QShortcut* cut_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_X), this);
+    connect( cut_shortcut, &QShortcut::activated, this, &MainWindow::onCutNodes );
+
+    QShortcut* paste_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_V), this);
+    connect( paste_shortcut, &QShortcut::activated, this, &MainWindow::onPasteNodes );
+
     QShortcut* save_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_S), this);
 
     connect( _editor_widget, &SidepanelEditor::nodeModelEdited,
@@ -155,6 +294,9 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     connect( _editor_widget, &SidepanelEditor::addNewModel,
             this, &MainWindow::onAddToModelRegistry);
 
+    connect( _editor_widget, &SidepanelEditor::addNewModels,
+            this, &MainWindow::onAddModelsToRegistry);
+
     connect( _editor_widget, &SidepanelEditor::destroySubtree,
             this, &MainWindow::onDestroySubTree);
 
@@ -188,36 +330,133 @@ MainWindow::MainWindow(GraphicMode initial_mode,
         }
     });
 
-    auto createSingleTabBehaviorTree = [this](const AbsBehaviorTree &tree, const QString &bt_name)
+    connect( ui->toolButtonSaveFile, &QToolButton::clicked,
+            this, &MainWindow::on_actionSave_triggered );
+
+    connect( save_shortcut, &QShortcut::activated, this, &MainWindow::on_actionSave_triggered );
+
+    _search_widget = new ProjectSearchPanel(this);
+    auto search_dock = new QDockWidget( tr("Search in project"), this );
+    search_dock->setObjectName( "ProjectSearchDock" );
+    search_dock->setWidget( _search_widget );
+    addDockWidget( Qt::RightDockWidgetArea, search_dock );
+    if( !restoreDockWidget( search_dock ) )
     {
-      onCreateAbsBehaviorTree(tree, bt_name, false);
-    };
+        search_dock->hide();
+    }
 
-    connect( _replay_widget, &SidepanelReplay::loadBehaviorTree,
-            this, createSingleTabBehaviorTree);
+    _problems_widget = new ProblemsPanel(this);
+    auto problems_dock = new QDockWidget( tr("Problems"), this );
+    problems_dock->setObjectName( "ProblemsDock" );
+    problems_dock->setWidget( _problems_widget );
+    addDockWidget( Qt::BottomDockWidgetArea, problems_dock );
+    if( !restoreDockWidget( problems_dock ) )
+    {
+        problems_dock->hide();
+    }
 
-    connect( _replay_widget, &SidepanelReplay::addNewModel,
-            this, &MainWindow::onAddToModelRegistry);
+    _diff_widget = new TreeDiffPanel(this);
+    _diff_dock = new QDockWidget( tr("Differences"), this );
+    _diff_dock->setObjectName( "TreeDiffDock" );
+    _diff_dock->setWidget( _diff_widget );
+    addDockWidget( Qt::BottomDockWidgetArea, _diff_dock );
+    if( !restoreDockWidget( _diff_dock ) )
+    {
+        tabifyDockWidget( problems_dock, _diff_dock );
+        _diff_dock->hide();
+    }
 
-    connect( ui->toolButtonSaveFile, &QToolButton::clicked,
-            this, &MainWindow::on_actionSave_triggered );
+    _minimap = new SceneMinimap(this);
+    auto minimap_dock = new QDockWidget( tr("Overview"), this );
+    minimap_dock->setObjectName( "MinimapDock" );
+    minimap_dock->setWidget( _minimap );
+    addDockWidget( Qt::RightDockWidgetArea, minimap_dock );
+    if( !restoreDockWidget( minimap_dock ) )
+    {
+        minimap_dock->hide();
+    }
 
-    connect( save_shortcut, &QShortcut::activated, this, &MainWindow::on_actionSave_triggered );
+    ui->menuMode->addSeparator();
+    ui->menuMode->addAction( minimap_dock->toggleViewAction() );
+    ui->menuMode->addAction( search_dock->toggleViewAction() );
+    ui->menuMode->addAction( problems_dock->toggleViewAction() );
+    ui->menuMode->addAction( _diff_dock->toggleViewAction() );
 
-    connect( _replay_widget, &SidepanelReplay::changeNodeStyle,
-            this, &MainWindow::onChangeNodesStatus);
+    ui->menuMode->addSeparator();
+    QAction* profiler_action = ui->menuMode->addAction( tr("Profiler Overlay") );
+    profiler_action->setCheckable( true );
+    profiler_action->setShortcut( QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_P) );
+    connect( profiler_action, &QAction::toggled, this, [this](bool checked)
+    {
+        _profiler_overlay = checked;
+        for (auto& it: _tab_info)
+        {
+            it.second->view()->setProfilerOverlay( checked );
+        }
+    });
 
-#ifdef ZMQ_FOUND
+    QAction* trace_action = ui->menuMode->addAction( tr("Record Trace") );
+    trace_action->setCheckable( true );
+    trace_action->setChecked( TraceRecorder::enabled() );
+    connect( trace_action, &QAction::toggled, this, [](bool checked)
+    {
+        TraceRecorder::setEnabled( checked );
+    });
+    QAction* save_trace_action = ui->menuMode->addAction( tr("Save Trace...") );
+    connect( save_trace_action, &QAction::triggered, this, &MainWindow::onSaveTrace );
 
-    connect( _monitor_widget, &SidepanelMonitor::addNewModel,
-            this, &MainWindow::onAddToModelRegistry);
+    QAction* memory_action = ui->menuMode->addAction( tr("Memory Report...") );
+    connect( memory_action, &QAction::triggered, this, &MainWindow::onMemoryReport );
 
-    connect( _monitor_widget, &SidepanelMonitor::changeNodeStyle,
-            this, &MainWindow::onChangeNodesStatus);
+    QAction* frames_action = ui->menuMode->addAction( tr("Export Replay Frames...") );
+    connect( frames_action, &QAction::triggered, this, &MainWindow::onExportReplayFrames );
 
-    connect( _monitor_widget, &SidepanelMonitor::loadBehaviorTree,
-            this, createSingleTabBehaviorTree );
-#endif
+    QShortcut* search_shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_F), this);
+    connect( search_shortcut, &QShortcut::activated, this, [this, search_dock]()
+    {
+        search_dock->show();
+        search_dock->raise();
+        _search_widget->focusFilter();
+        _search_widget->refresh();
+    });
+
+    connect( _search_widget, &ProjectSearchPanel::tabsRequested, this, [this]()
+    {
+        _search_widget->setTabs( tabSnapshots() );
+    });
+
+    connect( _search_widget, &ProjectSearchPanel::matchActivated,
+             this, [this](const ProjectSearchIndex::Match& match)
+    {
+        showNodeLocation( match.node );
+    });
+
+    // the edits are validated once they pause
+    _validation_timer.setSingleShot(true);
+    _validation_timer.setInterval(500);
+    connect( &_validation_timer, &QTimer::timeout, this, [this]()
+    {
+        _problems_widget->validate( tabSnapshots(), _treenode_models );
+    });
+
+    connect( _problems_widget, &ProblemsPanel::problemActivated,
+             this, &MainWindow::showNodeLocation );
+
+    connect( _diff_widget, &TreeDiffPanel::tabsRequested, this, [this]()
+    {
+        _diff_widget->compare( tabSnapshots() );
+    });
+
+    connect( _diff_widget, &TreeDiffPanel::changeActivated,
+             this, &MainWindow::showNodeLocation );
+
+    connect( _problems_widget, &ProblemsPanel::problemsCountChanged,
+             this, [problems_dock](int errors, int warnings)
+    {
+        problems_dock->setWindowTitle( (errors + warnings) > 0 ?
+                                           tr("Problems (%1)").arg( errors + warnings ) :
+                                           tr("Problems") );
+    });
 
     ui->tabWidget->tabBar()->setContextMenuPolicy(Qt::CustomContextMenu);
     connect( ui->tabWidget->tabBar(), &QTabBar::customContextMenuRequested,
@@ -226,7 +465,7 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     createTab("BehaviorTree");
     onTabSetMainTree(0);
     onSceneChanged();
-    _current_state = saveCurrentState();
+    resetUndoScenes();
 }
 
 
@@ -246,6 +485,20 @@ void MainWindow::closeEvent(QCloseEvent *event)
     }
 
     settings.setValue("StartupDialog.Mode", toStr( _current_mode ) );
+    settings.setValue("MainWindow/undoMemoryBudgetMB", int( _undo_memory_budget / (1024 * 1024) ) );
+    settings.setValue("MainWindow/tabEvictionMinutes", _tab_eviction_minutes );
+    settings.setValue("MainWindow/autosaveSeconds", _autosave_seconds );
+
+    // the files must be complete before leaving; a clean exit has nothing to recover
+    _save_watcher.waitForFinished();
+    _autosave_watcher.waitForFinished();
+    _layout_watcher.waitForFinished();
+    applyLayoutJobs();
+    if( !_autosave_deferred )
+    {
+        QFile::remove( autosaveFilename() );
+    }
+    writeProjectCache();
 
     QMainWindow::closeEvent(event);
 }
@@ -263,6 +516,20 @@ GraphicContainer* MainWindow::createTab(const QString &name)
     ti->scene()->setLayout( _current_layout );
 
     ui->tabWidget->addTab( ti->view(), name );
+    ti->view()->setProfilerOverlay( _profiler_overlay );
+    connect( ti->view(), &QtNodes::FlowView::painted, this, [](qint64 start_usec, qint64 duration_usec)
+    {
+        if( TraceRecorder::enabled() )
+        {
+            TraceRecorder::Event event;
+            event.category = "paint";
+            event.name = "FlowView::paintEvent";
+            event.start_usec = start_usec;
+            event.duration_usec = duration_usec;
+            event.thread_id = TraceRecorder::currentThreadId();
+            TraceRecorder::record( std::move(event) );
+        }
+    });
 
     ti->scene()->createNodeAtPos( "Root", "Root", QPointF(-30,-30) );
     ti->zoomHomeView();
@@ -292,27 +559,37 @@ GraphicContainer* MainWindow::createTab(const QString &name)
 
 MainWindow::~MainWindow()
 {
+    _layout_watcher.waitForFinished();
+    UsedWindowNumbers.erase( _window_number );
     delete ui;
 }
 
-void MainWindow::loadFromXML(const QString& xml_text)
+bool MainWindow::loadFromXML(const QString& xml_text)
 {
-    QDomDocument document;
+    TraceScope trace( "xml", "loadFromXML" );
+    _project_hash.clear();
+
+    std::vector<QString> registered_ID;
+    for (const auto& it: _treenode_models)
+    {
+        registered_ID.push_back( it.first );
+    }
+    // the validation is a separate pass over the whole text: it is done in
+    // a thread of the pool while this one reads the project
+    auto verify_future = QtConcurrent::run( [xml_text, registered_ID]()
+    {
+        std::vector<QString> error_messages;
+        bool done = VerifyXML(xml_text, registered_ID, error_messages );
+        return std::make_pair( done, error_messages );
+    });
+
+    XMLProject project;
     try{
-        QString errorMsg;
-        int errorLine;
-        if( ! document.setContent(xml_text, &errorMsg, &errorLine ) )
-        {
-            throw std::runtime_error( tr("Error parsing XML (line %1): %2").arg(errorLine).arg(errorMsg).toStdString() );
-        }
+        project = ReadProjectFromXML( xml_text );
         //---------------
-        std::vector<QString> registered_ID;
-        for (const auto& it: _treenode_models)
-        {
-            registered_ID.push_back( it.first );
-        }
-        std::vector<QString> error_messages;
-        bool done = VerifyXML(document, registered_ID, error_messages );
+        const auto verify_result = verify_future.result();
+        bool done = verify_result.first;
+        const std::vector<QString>& error_messages = verify_result.second;
 
         if( !done )
         {
@@ -329,67 +606,62 @@ void MainWindow::loadFromXML(const QString& xml_text)
         QMessageBox messageBox;
         messageBox.critical(this,"Error parsing the XML", err.what() );
         messageBox.show();
-        return;
+        return false;
     }
 
     //---------------
     bool error = false;
     QString err_message;
-    auto saved_state = _current_state;
+    auto saved_state = saveCurrentState();
     auto prev_tree_model = _treenode_models;
 
     try {
-        auto document_root = document.documentElement();
-
-        if( document_root.hasAttribute("main_tree_to_execute"))
+        if( !project.main_tree.isEmpty() )
         {
-            _main_tree = document_root.attribute("main_tree_to_execute");
+            _main_tree = project.main_tree;
         }
 
-        auto custom_models = ReadTreeNodesModel( document_root );
+        onAddModelsToRegistry( project.custom_models );
 
-        for( const auto& model: custom_models)
+        for (auto& it: project.trees)
         {
-            onAddToModelRegistry( model.second );
+            ResolveTreeModels( it.second, _treenode_models );
+        }
+        if( project.root_node_found )
+        {
+            QMessageBox::question(nullptr,
+                                  "Fix your file!",
+                                  "Please remove the node <Root> from your <BehaviorTree>",
+                                  QMessageBox::Ok );
         }
-
-        _editor_widget->updateTreeView();
 
         onActionClearTriggered(false);
 
         const QSignalBlocker blocker( currentTabInfo() );
 
-        for (auto bt_root = document_root.firstChildElement("BehaviorTree");
-             !bt_root.isNull();
-             bt_root = bt_root.nextSiblingElement("BehaviorTree"))
+        // the scenes are built only when the tabs are shown or needed
+        for (const auto& it: project.trees)
         {
-            auto tree = BuildTreeFromXML( bt_root, _treenode_models );
-            QString tree_name("BehaviorTree");
-
-            if( bt_root.hasAttribute("ID") )
+            auto container = getTabByName( it.first );
+            if( !container )
             {
-                tree_name = bt_root.attribute("ID");
-                if( _main_tree.isEmpty() )  // valid when there is only one
-                {
-                    _main_tree = tree_name;
-                }
+                container = createTab( it.first );
             }
-            onCreateAbsBehaviorTree(tree, tree_name);
+            container->setLazyTree( it.second );
         }
-
-        if( !_main_tree.isEmpty() )
+        for (const auto& it: project.trees)
         {
-            for (int i=0; i< ui->tabWidget->count(); i++)
+            for(const auto& node: it.second.nodes())
             {
-                if( ui->tabWidget->tabText( i ) == _main_tree)
+                if( node.model.type == NodeType::SUBTREE &&
+                    getTabByName(node.model.registration_ID) == nullptr)
                 {
-                    ui->tabWidget->tabBar()->moveTab(i, 0);
-                    ui->tabWidget->setCurrentIndex(0);
-                    ui->tabWidget->tabBar()->setTabIcon(0, QIcon(":/icons/svg/star.svg"));
-                    break;
+                    createTab(node.model.registration_ID);
                 }
             }
         }
+        clearUndoStacks();
+        moveMainTreeTabFirst();
 
         if( currentTabInfo() == nullptr)
         {
@@ -419,10 +691,112 @@ void MainWindow::loadFromXML(const QString& xml_text)
         QMessageBox::warning(this, tr("Exception!"),
                              tr("It was not possible to parse the file. Error:\n\n%1"). arg( err_message ),
                              QMessageBox::Ok);
+        return false;
     }
-    else{
-        onSceneChanged();
-        onPushUndo();
+    onSceneChanged();
+    onPushUndo();
+    return true;
+}
+
+bool MainWindow::loadFromCache(const CachedProject &cached)
+{
+    _project_hash.clear();
+
+    auto saved_state = saveCurrentState();
+    auto prev_tree_model = _treenode_models;
+
+    try {
+        if( !cached.main_tree.isEmpty() )
+        {
+            _main_tree = cached.main_tree;
+        }
+        onAddModelsToRegistry( cached.custom_models );
+
+        onActionClearTriggered(false);
+
+        const QSignalBlocker blocker( currentTabInfo() );
+
+        for (const auto& tab: cached.tabs)
+        {
+            auto container = getTabByName( tab.name );
+            if( !container )
+            {
+                container = createTab( tab.name );
+            }
+            if( tab.tree )
+            {
+                container->setLazyTree( tab.tree );
+            }
+            else{
+                container->setLazyScene( tab.scene_json );
+            }
+        }
+        clearUndoStacks();
+        moveMainTreeTabFirst();
+
+        auto models_to_remove = GetModelsToRemove(this, _treenode_models, cached.custom_models);
+
+        for( QString model_name: models_to_remove )
+        {
+            onModelRemoveRequested(model_name);
+        }
+    }
+    catch (std::exception& err) {
+        // the file is parsed instead
+        qDebug() << "The cache of the project can not be used: " << err.what();
+        _treenode_models = prev_tree_model;
+        loadSavedStateFromJson( saved_state );
+        return false;
+    }
+    onSceneChanged();
+    onPushUndo();
+    return true;
+}
+
+void MainWindow::writeProjectCache()
+{
+    if( _project_hash.isEmpty() || _project_modified )
+    {
+        return;
+    }
+    const SavedState state = saveCurrentState();
+
+    CachedProject cached;
+    cached.main_tree = _main_tree;
+    cached.custom_models = _treenode_models;
+    for (int i=0; i< ui->tabWidget->count(); i++)
+    {
+        CachedProject::Tab tab;
+        tab.name = ui->tabWidget->tabText(i);
+
+        auto lazy_it = state.lazy_trees.find( tab.name );
+        if( lazy_it != state.lazy_trees.end() )
+        {
+            tab.tree = lazy_it->second;
+        }
+        else{
+            tab.scene_json = state.json_states.at( tab.name );
+        }
+        cached.tabs.push_back( std::move(tab) );
+    }
+    ProjectCache::write( _project_hash, cached );
+}
+
+void MainWindow::moveMainTreeTabFirst()
+{
+    if( _main_tree.isEmpty() )
+    {
+        return;
+    }
+    for (int i=0; i< ui->tabWidget->count(); i++)
+    {
+        if( ui->tabWidget->tabText( i ) == _main_tree)
+        {
+            ui->tabWidget->tabBar()->moveTab(i, 0);
+            ui->tabWidget->setCurrentIndex(0);
+            ui->tabWidget->tabBar()->setTabIcon(0, QIcon(":/icons/svg/star.svg"));
+            break;
+        }
     }
 }
 
@@ -450,187 +824,136 @@ void MainWindow::on_actionLoad_triggered()
     settings.setValue("MainWindow.lastLoadDirectory", directory_path);
     settings.sync();
 
-    QString xml_text;
-
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        xml_text += in.readLine();
-    }
-
-    loadFromXML(xml_text);
-}
-
-QString MainWindow::saveToXML() const
-{
-    QDomDocument doc;
-
-    const char* COMMENT_SEPARATOR = " ////////// ";
-
-    QDomElement root = doc.createElement( "root" );
-    doc.appendChild( root );
+    const QByteArray xml_data = file.readAll();
+    const QByteArray xml_hash = ProjectCache::hashOf( xml_data );
 
-    if( _main_tree.isEmpty() == false)
+    // a project opened before is shown as it was left, without parsing it
+    // nor computing the layout of its trees
+    CachedProject cached;
+    bool loaded = ProjectCache::read( xml_hash, &cached ) && loadFromCache( cached );
+    if( !loaded )
     {
-        root.setAttribute("main_tree_to_execute", _main_tree.toStdString().c_str());
-    }
-
-    for (auto& it: _tab_info)
-    {
-        auto& container = it.second;
-        auto  scene = container->scene();
+        QString xml_text;
 
-        auto abs_tree = BuildTreeFromScene(container->scene());
-        auto abs_root = abs_tree.rootNode();
-        if( abs_root->children_index.size() == 1 &&
-            abs_root->model.registration_ID == "Root"  )
-        {
-            // mofe to the child of ROOT
-            abs_root = abs_tree.node( abs_root->children_index.front() );
+        QTextStream in(xml_data);
+        while (!in.atEnd()) {
+            xml_text += in.readLine();
         }
-
-        QtNodes::Node* root_node = abs_root->graphic_node;
-
-        root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
-        QDomElement root_element = doc.createElement("BehaviorTree");
-
-        root_element.setAttribute("ID", it.first.toStdString().c_str());
-        root.appendChild(root_element);
-
-        RecursivelyCreateXml(*scene, doc, root_element, root_node );
+        loaded = loadFromXML(xml_text);
+    }
+    if( loaded )
+    {
+        _project_hash = xml_hash;
+        _project_modified = false;
     }
-    root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
+}
 
-    QDomElement root_models = doc.createElement("TreeNodesModel");
+XMLProject MainWindow::snapshotProject() const
+{
+    XMLProject project;
+    project.main_tree = _main_tree;
+    project.custom_models = _treenode_models;
+    project.root_node_found = false;
 
-    for(const auto& tree_it: _treenode_models)
+    for (auto& it: _tab_info)
     {
-        const auto& ID    = tree_it.first;
-        const auto& model = tree_it.second;
+        GraphicContainer* container = it.second;
 
-        if( BuiltinNodeModels().count(ID) != 0 )
+        // a tab never shown is saved from its tree, without building the scene
+        if( auto lazy_tree = container->lazyTree() )
         {
-            continue;
+            project.trees.push_back( { it.first, *lazy_tree } );
         }
-
-        QDomElement node = doc.createElement( QString::fromStdString(toStr(model.type)) );
-
-        if( !node.isNull() )
-        {
-            node.setAttribute("ID", ID);
-
-            for(const auto& port_it: model.ports)
-            {
-                const auto& port_name = port_it.first;
-                const auto& port = port_it.second;
-
-                QDomElement port_element = writePortModel(port_name, port, doc);
-                node.appendChild( port_element );
-            }
+        else{
+            project.trees.push_back( { it.first, *container->tree() } );
         }
-        root_models.appendChild(node);
     }
-    root.appendChild(root_models);
-    root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
-
-    return xmlDocumentToString(doc);
+    return project;
 }
 
-QString MainWindow::xmlDocumentToString(const QDomDocument &document) const
+QString MainWindow::saveToXML() const
 {
-  QString output_string;
-
-  QXmlStreamWriter stream(&output_string);
-
-  stream.setAutoFormatting(true);
-  stream.setAutoFormattingIndent(4);
-
-  stream.writeStartDocument();
-
-  auto root_element = document.documentElement();
-
-  stream.writeStartElement(root_element.tagName());
-
-  streamElementAttributes(stream, root_element);
-
-  auto next_node = root_element.firstChild();
-
-  while ( !next_node.isNull() )
-  {
-    recursivelySaveNodeCanonically(stream, next_node);
-
-    if ( stream.hasError() )
-    {
-        break;
-    }
-    next_node = next_node.nextSibling();
-  }
-
-  stream.writeEndElement();
-  stream.writeEndDocument();
+    return WriteProjectToXML( snapshotProject() );
+}
 
-  return output_string;
+QString MainWindow::autosaveFilename() const
+{
+    return AutosaveDirectory() + QString("/autosave_%1_%2.xml").arg( AutosaveSession() ).arg( _window_number );
 }
 
-void MainWindow::streamElementAttributes(QXmlStreamWriter &stream, const QDomElement &element) const
+void MainWindow::onAutosave()
 {
-    if (element.hasAttributes())
+    if( _current_mode != GraphicMode::EDITOR ||
+        !_autosave_pending || _autosave_watcher.isRunning() )
     {
-        QMap<QString, QString> attributes;
-        const QDomNamedNodeMap attributes_map = element.attributes();
-
-        for (int i = 0; i < attributes_map.count(); ++i)
-        {
-           auto attribute = attributes_map.item(i);
-            attributes.insert(attribute.nodeName(), attribute.nodeValue());
-        }
-
-        auto i = attributes.constBegin();
-        while (i != attributes.constEnd())
+        return;
+    }
+    // a tree that can not be saved is not autosaved either
+    for (auto& it: _tab_info)
+    {
+        if( !it.second->lazyTree() && !it.second->containsValidTree() )
         {
-            stream.writeAttribute(i.key(), i.value());
-            ++i;
+            return;
         }
     }
-}
+    _autosave_pending = false;
 
-void MainWindow::recursivelySaveNodeCanonically(QXmlStreamWriter &stream, const QDomNode &parent_node) const
-{
-  if ( stream.hasError() )
-  {
-    return;
-  }
+    const QString filename = autosaveFilename();
+    QDir().mkpath( QFileInfo(filename).absolutePath() );
 
-  if ( parent_node.isElement() )
-  {
-    const QDomElement parent_element = parent_node.toElement();
+    XMLProject project = snapshotProject();
+    _autosave_watcher.setFuture( QtConcurrent::run( [project, filename]()
+    {
+        return WriteProjectFile( project, filename );
+    }) );
+}
 
-    if ( !parent_element.isNull() )
+void MainWindow::recoverAutosave()
+{
+    _autosave_deferred = false;
+    const QStringList files = OrphanAutosaveFiles();
+    if( files.empty() )
+    {
+        return;
+    }
+    // don't stop Monitor and Replay mode with a question about the editor:
+    // the files are kept until the editor is used
+    if( _current_mode != GraphicMode::EDITOR )
     {
-        stream.writeStartElement(parent_element.tagName());
+        _autosave_deferred = true;
+        return;
+    }
 
-        streamElementAttributes(stream, parent_element);
+    QString question = tr("Groot was not closed properly.\n"
+                          "Do you want to recover the autosaved trees?");
+    if( files.size() > 1 )
+    {
+        question += "\n" + tr("Each of the %1 autosaved windows is opened again.").arg( files.size() );
+    }
+    auto ret = QMessageBox::question(this, tr("Recover"), question,
+                                     QMessageBox::Yes | QMessageBox::No);
 
-        if (parent_element.hasChildNodes())
+    for (int i = 0; i < files.size(); i++)
+    {
+        QFile file( files[i] );
+        if( ret == QMessageBox::Yes && file.open(QIODevice::ReadOnly) )
         {
-            auto child = parent_element.firstChild();
-            while ( !child.isNull() )
+            const QString xml_text = QString::fromUtf8( file.readAll() );
+            file.close();
+            // the first one in this window
+            MainWindow* window = ( i == 0 ) ? this : newEditorWindow( i );
+            window->loadFromXML( xml_text );
+            // kept until the trees are autosaved by this session
+            window->_autosave_pending = true;
+            window->onAutosave();
+            window->_autosave_watcher.waitForFinished();
+            if( !QFile::exists( window->autosaveFilename() ) )
             {
-                recursivelySaveNodeCanonically(stream, child);
-                child = child.nextSibling();
+                continue;
             }
         }
-
-        stream.writeEndElement();
+        QFile::remove( files[i] );
     }
-  }
-  else if (parent_node.isComment())
-  {
-    stream.writeComment(parent_node.nodeValue());
-  }
-  else if (parent_node.isText())
-  {
-    stream.writeCharacters(parent_node.nodeValue());
-  }
 }
 
 void MainWindow::on_actionSave_triggered()
@@ -638,7 +961,7 @@ void MainWindow::on_actionSave_triggered()
     for (auto& it: _tab_info)
     {
         auto& container = it.second;
-        if( !container->containsValidTree() )
+        if( !container->lazyTree() && !container->containsValidTree() )
         {
             QMessageBox::warning(this, tr("Oops!"),
                                  tr("Malformed behavior tree. File can not be saved"),
@@ -666,13 +989,16 @@ void MainWindow::on_actionSave_triggered()
         fileName += ".xml";
     }
 
-    QString xml_text = saveToXML();
-
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly)) {
-        QTextStream stream(&file);
-        stream << xml_text;
-    }
+    // only the copy of the trees is done here, the rest in a thread of the pool
+    _save_watcher.waitForFinished();
+    _save_filename = fileName;
+    _project_hash.clear();
+    _project_modified = false;
+    XMLProject project = snapshotProject();
+    _save_watcher.setFuture( QtConcurrent::run( [project, fileName]()
+    {
+        return WriteProjectFile( project, fileName );
+    }) );
 
     directory_path = QFileInfo(fileName).absolutePath();
     settings.setValue("MainWindow.lastSaveDirectory", directory_path);
@@ -706,7 +1032,9 @@ void MainWindow::onSceneChanged()
     ui->labelSemaphore->setPixmap(pix);
     ui->labelSemaphore->setScaledContents(true);
 
+    // the new tabs get the mode of the others; the rest is unchanged
     lockEditing( _current_mode != GraphicMode::EDITOR );
+    scheduleValidation();
 }
 
 
@@ -740,69 +1068,234 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
         qDebug() << "A " << event->type();
         return false;
     }
-    else
+    else
+    {
+        qDebug() << "B " << event->type();
+        return QMainWindow::eventFilter(obj,event);
+    }
+}
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    if (!event->spontaneous()) {
+        currentTabInfo()->zoomHomeView();
+        ui->centralwidget->setFocus();
+    }
+}
+
+void MainWindow::resizeEvent(QResizeEvent *)
+{
+    on_splitter_splitterMoved();
+}
+
+
+void MainWindow::on_splitter_splitterMoved(int , int )
+{
+    this->update();
+    QList<int> sizes = ui->splitter->sizes();
+    const int maxLeftWidth = ui->leftFrame->maximumWidth();
+    int totalWidth = sizes[0] + sizes[1];
+
+    if( sizes[0] > maxLeftWidth)
+    {
+        sizes[0] = maxLeftWidth;
+        sizes[1] = totalWidth - maxLeftWidth;
+        ui->splitter->setSizes(sizes);
+    }
+}
+
+MainWindow::SavedState MainWindow::saveCurrentState()
+{
+    SavedState saved;
+    int index = ui->tabWidget->currentIndex();
+    saved.main_tree = _main_tree;
+    saved.current_tab_name = ui->tabWidget->tabText(index);
+    auto current_view = getTabByName( saved.current_tab_name )->view();
+    saved.view_transform = current_view->transform();
+    saved.view_area = current_view->sceneRect();
+
+    for (auto& it: _tab_info)
+    {
+        GraphicContainer* container = it.second;
+        if( container->isMaterialized() )
+        {
+            saved.json_states[it.first] =
+                    container->scene()->saveToMemory( QtNodes::FlowScene::SceneFormat::Binary );
+        }
+        else{
+            SceneState state = container->sceneState();
+            if( state.lazy_tree )
+            {
+                saved.lazy_trees[it.first] = state.lazy_tree;
+            }
+            else{
+                saved.json_states[it.first] = state.toMemory( layoutName( _current_layout ) );
+            }
+        }
+    }
+    return saved;
+}
+
+MainWindow::SavedState MainWindow::savedStateFromUndoScenes(size_t* new_bytes)
+{
+    SavedState saved;
+    saved.main_tree = _undo_main_tree;
+    saved.current_tab_name = ui->tabWidget->tabText( ui->tabWidget->currentIndex() );
+    if( auto current_tab = getTabByName( saved.current_tab_name ) )
+    {
+        saved.view_transform = current_tab->view()->transform();
+        saved.view_area = current_tab->view()->sceneRect();
+    }
+    const QString layout = layoutName( _current_layout );
+
+    for (const auto& it: _undo_scenes)
+    {
+        if( it.second.lazy_tree )
+        {
+            saved.lazy_trees[it.first] = it.second.lazy_tree;
+            continue;
+        }
+        auto compressed = _undo_compressed.find( it.first );
+        if( compressed == _undo_compressed.end() )
+        {
+            QByteArray data = qCompress( it.second.toMemory( layout ) );
+            *new_bytes += data.size();
+            compressed = _undo_compressed.insert( { it.first, data } ).first;
+        }
+        saved.json_states[it.first] = compressed->second;
+    }
+    return saved;
+}
+
+void MainWindow::resetUndoScenes()
+{
+    std::map<QString, SceneState> previous_scenes;
+    std::swap( previous_scenes, _undo_scenes );
+
+    for (auto& it: _tab_info)
+    {
+        SceneState materialized_state;
+        it.second->takeMaterializedState( &materialized_state );
+        it.second->takeSceneChanged();
+        SceneState state = it.second->sceneState();
+        auto previous = previous_scenes.find( it.first );
+        if( previous == previous_scenes.end() || previous->second != state )
+        {
+            _undo_compressed.erase( it.first );
+        }
+        _undo_scenes[it.first] = std::move(state);
+    }
+    for (auto it = _undo_compressed.begin(); it != _undo_compressed.end(); )
     {
-        qDebug() << "B " << event->type();
-        return QMainWindow::eventFilter(obj,event);
+        if( _undo_scenes.count( it->first ) == 0 )
+        {
+            it = _undo_compressed.erase( it );
+        }
+        else{
+            it++;
+        }
     }
+    _undo_main_tree = _main_tree;
 }
 
-void MainWindow::showEvent(QShowEvent *event)
+void MainWindow::evictUnusedTabs()
 {
-    if (!event->spontaneous()) {
-        currentTabInfo()->zoomHomeView();
-        ui->centralwidget->setFocus();
+    // the trees shown in Monitor and Replay mode are not edited, nor evicted
+    if( _current_mode != GraphicMode::EDITOR )
+    {
+        return;
     }
-}
+    const qint64 max_unused_msecs = qint64(_tab_eviction_minutes) * 60 * 1000;
+    auto current_tab = currentTabInfo();
 
-void MainWindow::resizeEvent(QResizeEvent *)
-{
-    on_splitter_splitterMoved();
+    for (auto& it: _tab_info)
+    {
+        GraphicContainer* container = it.second;
+        if( container != current_tab && container->isMaterialized() &&
+            container->msecsSinceUsed() > max_unused_msecs )
+        {
+            container->evict();
+        }
+    }
 }
 
-
-void MainWindow::on_splitter_splitterMoved(int , int )
+void MainWindow::trimUndoHistory()
 {
-    this->update();
-    QList<int> sizes = ui->splitter->sizes();
-    const int maxLeftWidth = ui->leftFrame->maximumWidth();
-    int totalWidth = sizes[0] + sizes[1];
-
-    if( sizes[0] > maxLeftWidth)
+    // the most recent entry is always kept
+    while( _undo_memory > _undo_memory_budget &&
+           _undo_stack.size() + _redo_stack.size() > 1 )
     {
-        sizes[0] = maxLeftWidth;
-        sizes[1] = totalWidth - maxLeftWidth;
-        ui->splitter->setSizes(sizes);
+        auto& oldest = _undo_stack.empty() ? _redo_stack : _undo_stack;
+        _undo_memory -= std::min( _undo_memory, oldest.front().memory );
+        oldest.pop_front();
     }
 }
 
-MainWindow::SavedState MainWindow::saveCurrentState()
+void MainWindow::onPushUndo()
 {
-    SavedState saved;
-    int index = ui->tabWidget->currentIndex();
-    saved.main_tree = _main_tree;
-    saved.current_tab_name = ui->tabWidget->tabText(index);
-    auto current_view = getTabByName( saved.current_tab_name )->view();
-    saved.view_transform = current_view->transform();
-    saved.view_area = current_view->sceneRect();
+    TraceScope trace( "undo", "onPushUndo" );
+    // the tab that emitted undoableChange, if any. When called directly, all
+    // the tabs are compared with the history
+    auto sender_tab = qobject_cast<GraphicContainer*>( sender() );
 
-    for (auto& it: _tab_info)
+    bool structural = ( _main_tree != _undo_main_tree ||
+                        _tab_info.size() != _undo_scenes.size() );
+    for (const auto& it: _tab_info)
     {
-        saved.json_states[it.first] = it.second->scene()->saveToMemory();
+        structural = structural || ( _undo_scenes.count( it.first ) == 0 );
     }
-    return saved;
-}
 
-void MainWindow::onPushUndo()
-{
-    SavedState saved = saveCurrentState();
+    trace.setArgument( "structural", structural );
 
-    if( _undo_stack.empty() || ( saved != _current_state &&  _undo_stack.back() != _current_state) )
+    UndoEntry entry;
+    if( structural )
+    {
+        entry.snapshot_before = std::make_shared<SavedState>( savedStateFromUndoScenes( &entry.memory ) );
+        resetUndoScenes();
+        entry.snapshot_after  = std::make_shared<SavedState>( savedStateFromUndoScenes( &entry.memory ) );
+    }
+    else{
+        for (auto& it: _tab_info)
+        {
+            GraphicContainer* container = it.second;
+            SceneState materialized_state;
+            if( container->takeMaterializedState( &materialized_state ) )
+            {
+                // building a scene is not an edit
+                _undo_scenes[it.first] = std::move(materialized_state);
+                _undo_compressed.erase( it.first );
+            }
+            bool changed = container->takeSceneChanged();
+            if( sender_tab && container != sender_tab && !changed )
+            {
+                continue;
+            }
+            SceneState state = container->sceneState();
+            SceneState& previous = _undo_scenes[it.first];
+            SceneCommand command = SceneCommand::difference( it.first, previous, state );
+            if( !command.empty() )
+            {
+                entry.memory += command.memoryUsage();
+                entry.commands.push_back( std::move(command) );
+                previous = std::move(state);
+                _undo_compressed.erase( it.first );
+            }
+        }
+        if( entry.commands.empty() )
+        {
+            return;
+        }
+    }
+    _autosave_pending = true;
+    _project_modified = true;
+    for (const auto& redo: _redo_stack)
     {
-        _undo_stack.push_back( std::move(_current_state) );
-        _redo_stack.clear();
+        _undo_memory -= std::min( _undo_memory, redo.memory );
     }
-    _current_state = saved;
+    _redo_stack.clear();
+    _undo_memory += entry.memory;
+    _undo_stack.push_back( std::move(entry) );
+    trimUndoHistory();
 
     //qDebug() << "P: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
 }
@@ -813,11 +1306,13 @@ void MainWindow::onUndoInvoked()
 
     if( _undo_stack.size() > 0)
     {
-        _redo_stack.push_back( std::move(_current_state) );
-        _current_state = _undo_stack.back();
+        UndoEntry entry = std::move( _undo_stack.back() );
         _undo_stack.pop_back();
 
-        loadSavedStateFromJson(_current_state);
+        applyUndoEntry( entry, true );
+        _autosave_pending = true;
+        _project_modified = true;
+        _redo_stack.push_back( std::move(entry) );
 
         // qDebug() << "U: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
     }
@@ -829,42 +1324,169 @@ void MainWindow::onRedoInvoked()
 
     if( _redo_stack.size() > 0)
     {
-        _undo_stack.push_back( _current_state );
-        _current_state = std::move( _redo_stack.back() );
+        UndoEntry entry = std::move( _redo_stack.back() );
         _redo_stack.pop_back();
 
-        loadSavedStateFromJson(_current_state);
+        applyUndoEntry( entry, false );
+        _autosave_pending = true;
+        _project_modified = true;
+        _undo_stack.push_back( std::move(entry) );
 
         // qDebug() << "R: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
     }
 }
 
+void MainWindow::onCopyNodes(bool with_descendants)
+{
+    auto container = currentTabInfo();
+    if( !container || !container->isMaterialized() ) return;
+
+    const ClipboardNodes copy = container->copyNodes( container->scene()->selectedNodes(),
+                                                      with_descendants );
+    if( !copy.empty() )
+    {
+        WriteClipboardNodes( copy );
+    }
+}
+
+void MainWindow::onCutNodes()
+{
+    if ( _current_mode != GraphicMode::EDITOR ) return; //locked
+
+    auto container = currentTabInfo();
+    if( !container || !container->isMaterialized() ) return;
+
+    const ClipboardNodes copy = container->copyNodes( container->scene()->selectedNodes(), false );
+    if( copy.empty() ) return;
+
+    WriteClipboardNodes( copy );
+    // a single undo step
+    container->view()->deleteSelectedNodes();
+}
+
+void MainWindow::onPasteNodes()
+{
+    if ( _current_mode != GraphicMode::EDITOR ) return; //locked
+
+    auto container = currentTabInfo();
+    if( !container ) return;
+
+    const ClipboardNodes nodes = ReadClipboardNodes();
+    if( nodes.empty() ) return;
+
+    auto view = container->view();
+    QPoint mouse_pos = view->viewport()->mapFromGlobal( QCursor::pos() );
+    if( !view->viewport()->rect().contains( mouse_pos ) )
+    {
+        mouse_pos = view->viewport()->rect().center();
+    }
+    container->pasteNodes( nodes, view->mapToScene( mouse_pos ) );
+}
+
+void MainWindow::applyUndoEntry(const UndoEntry &entry, bool undo)
+{
+    if( entry.snapshot_before )
+    {
+        SavedState state = undo ? *entry.snapshot_before : *entry.snapshot_after;
+        for (auto& it: state.json_states)
+        {
+            it.second = qUncompress( it.second );
+        }
+        loadSavedStateFromJson( state );
+        resetUndoScenes();
+        return;
+    }
+
+    // show the tab that is edited; switching tab reorders its nodes, so it
+    // is done before applying the commands
+    const auto& shown = undo ? entry.commands.front() : entry.commands.back();
+    for (int i=0; i< ui->tabWidget->count(); i++)
+    {
+        if( ui->tabWidget->tabText( i ) == shown.tab_name &&
+            ui->tabWidget->currentIndex() != i )
+        {
+            ui->tabWidget->setCurrentIndex(i);
+        }
+    }
+
+    // edits of a tab are applied to that tab only
+    for (size_t i = 0; i < entry.commands.size(); i++)
+    {
+        const auto& command = entry.commands[ undo ? entry.commands.size() - 1 - i : i ];
+        auto container = getTabByName( command.tab_name );
+        if( !container )
+        {
+            continue;
+        }
+        container->applyCommand( command, undo );
+        SceneState materialized_state;
+        container->takeMaterializedState( &materialized_state );
+        container->takeSceneChanged();
+        _undo_scenes[command.tab_name] = container->sceneState();
+        _undo_compressed.erase( command.tab_name );
+    }
+    onSceneChanged();
+}
+
 void MainWindow::loadSavedStateFromJson(SavedState saved_state)
 {
     // TODO crash if the name of the container (tab) changed
-    for (auto& it: _tab_info)
+
+    // the tabs that are not in the saved state are closed, the others are
+    // reused and loaded again only if their content is different
+    for (auto it = _tab_info.begin(); it != _tab_info.end(); )
     {
-        it.second->clearScene();
-        it.second->deleteLater();
+        if( saved_state.json_states.count( it->first ) == 0 &&
+            saved_state.lazy_trees.count( it->first ) == 0 )
+        {
+            int index = ui->tabWidget->indexOf( it->second->view() );
+            it->second->clearScene();
+            it->second->deleteLater();
+            if( index >= 0 )
+            {
+                ui->tabWidget->removeTab( index );
+            }
+            it = _tab_info.erase( it );
+        }
+        else{
+            it++;
+        }
     }
-    _tab_info.clear();
-    ui->tabWidget->clear();
 
     _main_tree = saved_state.main_tree;
 
-    for(const auto& it: saved_state.json_states)
-    {
-        QString tab_name = it.first;
-        _tab_info.insert( {tab_name, createTab(tab_name)} );
-    }
     for(const auto& it: saved_state.json_states)
     {
         QString name = it.first;
+        QString layout;
+        const SceneState state = SceneState::fromMemory( it.second, &layout );
         auto container = getTabByName(name);
-        container->loadFromJson( it.second );
+        if( !container )
+        {
+            container = createTab(name);
+        }
+        else if( container->sceneState() == state )
+        {
+            continue;
+        }
+        container->loadFromState( state, ( layout == "Horizontal" ) ?
+                                      QtNodes::PortLayout::Horizontal :
+                                      QtNodes::PortLayout::Vertical );
         container->view()->setTransform( saved_state.view_transform );
         container->view()->setSceneRect( saved_state.view_area );
     }
+    for(const auto& it: saved_state.lazy_trees)
+    {
+        auto container = getTabByName(it.first);
+        if( !container )
+        {
+            container = createTab(it.first);
+        }
+        if( container->sceneState().lazy_tree != it.second )
+        {
+            container->setLazyTree( it.second );
+        }
+    }
 
     for (int i=0; i< ui->tabWidget->count(); i++)
     {
@@ -925,22 +1547,24 @@ void MainWindow::onRequestSubTreeExpand(GraphicContainer& container,
 
 void MainWindow::onAddToModelRegistry(const NodeModel &model)
 {
-    namespace util = QtNodes::detail;
     const auto& ID = model.registration_ID;
 
-    DataModelRegistry::RegistryItemCreator node_creator = [model]() -> DataModelRegistry::RegistryItemPtr
-    {
-        if( model.type == NodeType::SUBTREE)
-        {
-            return util::make_unique<SubtreeNodeModel>(model);
-        }
-        return util::make_unique<BehaviorTreeDataModel>(model);
-    };
-
-    _model_registry->registerModel( QString::fromStdString( toStr(model.type)), node_creator, ID);
+    _model_registry->registerModel( QString::fromStdString( toStr(model.type)),
+                                    ModelDatabase::creator( model ), ID);
 
     _treenode_models.insert( {ID, model } );
     _editor_widget->updateTreeView();
+    scheduleValidation();
+}
+
+void MainWindow::onAddModelsToRegistry(const NodeModels &models)
+{
+    const SidepanelEditor::ScopedUpdate update( *_editor_widget );
+    for( const auto& model: models)
+    {
+        onAddToModelRegistry( model.second );
+    }
+    _editor_widget->updateTreeView();
 }
 
 void MainWindow::onDestroySubTree(const QString &ID)
@@ -998,68 +1622,45 @@ void MainWindow::onDestroySubTree(const QString &ID)
 
 void MainWindow::onModelRemoveRequested(QString ID)
 {
-    BehaviorTreeDataModel* node_found = nullptr;
-    QString tab_containing_node;
-
-    for (auto& it: _tab_info)
-    {
-        auto container = it.second;
-        for(const auto& node_it: container->scene()->nodes() )
-        {
-            QtNodes::Node* graphic_node = node_it.second.get();
-            auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( graphic_node->nodeDataModel() );
-
-            if( bt_node->model().registration_ID == ID )
-            {
-                node_found = bt_node;
-                tab_containing_node = it.first;
-                break;
-            }
-        }
-        if( node_found != nullptr )
-        {
-            break;
-        }
-    }
+    // the tabs are not built to know where the model is used
+    const std::map<QString, int> users = modelUsers( ID );
 
-    if( !node_found )
+    if( users.empty() )
     {
         _editor_widget->onRemoveModel(ID);
+        scheduleValidation();
         return;
     }
+    QStringList tabs_containing_node;
+    for (const auto& it: users)
+    {
+        tabs_containing_node.push_back( it.first );
+    }
 
     NodeType node_type = _treenode_models.at(ID).type;
 
-    if( node_found && node_type != NodeType::SUBTREE )
+    if( node_type != NodeType::SUBTREE )
     {
         QMessageBox::warning(this, "Can't remove this Model",
                              QString( "You are using this model in the Tree called [%1].\n"
                                      "You can't delete this model unless you "
-                                     "remove all the instances of [%2].").arg(tab_containing_node, ID ),
+                                     "remove all the instances of [%2].")
+                             .arg(tabs_containing_node.join("], ["), ID ),
                              QMessageBox::Ok );
     }
     else
     {
-        int ret = QMessageBox::Cancel;
-        if( node_found->model().type != NodeType::SUBTREE )
-        {
-            ret = QMessageBox::warning(this,"Delete TreeNode Model?",
-                                       "Are you sure? This action can't be undone.",
-                                       QMessageBox::Cancel | QMessageBox::Yes,
-                                       QMessageBox::Cancel);
-        }
-        else{
-            ret = QMessageBox::warning(this,"Delete Subtree?",
+        int ret = QMessageBox::warning(this,"Delete Subtree?",
                                        "The Model of the Subtrees will be removed."
                                        "An expanded version will be added to parent trees.\n"
                                        "Are you sure? This action can't be undone.",
                                        QMessageBox::Cancel | QMessageBox::Yes,
                                        QMessageBox::Cancel);
-        }
 
         if(ret == QMessageBox::Yes )
         {
             _editor_widget->onRemoveModel(ID);
+            scheduleValidation();
             clearUndoStacks();
         }
     }
@@ -1093,10 +1694,13 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
             return &node;
         }
 
-        auto abs_subtree = BuildTreeFromScene( subtree_container->scene() );
+        const auto subtree_ptr = subtree_container->tree();
+        AbsBehaviorTree abs_subtree = *subtree_ptr;
 
         subtree_model->setExpanded(true);
+        subtree_model->setExpandedTree( subtree_ptr );
         node.nodeState().getEntries(PortType::Out).resize(1);
+        container.scene()->invalidateNodePorts( node );
         container.appendTreeToNode( node, abs_subtree );
         container.lockSubtreeEditing( node, true, is_editor_mode );
 
@@ -1129,6 +1733,7 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
 
         subtree_model->setExpanded(false);
         node.nodeState().getEntries(PortType::Out).resize(0);
+        container.scene()->invalidateNodePorts( node );
         container.lockSubtreeEditing( node, false, is_editor_mode );
         if( need_reorder )
         {
@@ -1149,7 +1754,14 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
         QtNodes::Node* child_node = conn_out.begin()->second->getNode( PortType::In );
 
         auto subtree_container = getTabByName(subtree_name);
-        auto subtree = BuildTreeFromScene( subtree_container->scene() );
+        // the snapshot of the tab is the same until its scene changes
+        const auto subtree_ptr = subtree_container->tree();
+        if( subtree_model->expandedTree() == subtree_ptr )
+        {
+            return &node;
+        }
+        AbsBehaviorTree subtree = *subtree_ptr;
+        subtree_model->setExpandedTree( subtree_ptr );
 
         container.deleteSubTreeRecursively( *child_node );
         container.appendTreeToNode( node, subtree );
@@ -1176,8 +1788,259 @@ void MainWindow::clearUndoStacks()
 {
     _undo_stack.clear();
     _redo_stack.clear();
+    _undo_memory = 0;
     onSceneChanged();
-    onPushUndo();
+    resetUndoScenes();
+}
+
+std::vector<MemoryUsage> MainWindow::memoryReport()
+{
+    std::vector<MemoryUsage> usages;
+    auto current_tab = currentTabInfo();
+
+    for (auto& it: _tab_info)
+    {
+        GraphicContainer* container = it.second;
+        MemoryUsage usage = container->memoryUsage();
+        usage.name = it.first;
+        if( container == current_tab )
+        {
+            usage.details += tr(", shown");
+        }
+        // as evictUnusedTabs, but now
+        else if( _current_mode == GraphicMode::EDITOR && container->isMaterialized() )
+        {
+            usage.release_label = tr("Unload the tab");
+            usage.release = [this, container]()
+            {
+                if( !container->evict() )
+                {
+                    QMessageBox::information( this, tr("Memory Report"),
+                                              tr("A tab with expanded subtrees can not be unloaded.") );
+                }
+            };
+        }
+        usages.push_back( usage );
+    }
+
+    size_t undo_bytes = 0;
+    for (const auto& entry: _undo_stack)
+    {
+        undo_bytes += entry.memory;
+    }
+    size_t redo_bytes = 0;
+    for (const auto& entry: _redo_stack)
+    {
+        redo_bytes += entry.memory;
+    }
+
+    MemoryUsage undo;
+    undo.category = tr("Undo history");
+    undo.name = tr("Undo");
+    undo.bytes = undo_bytes;
+    undo.details = tr("%1 changes, budget %2").arg( _undo_stack.size() )
+                                               .arg( FormatBytes( _undo_memory_budget ) );
+    if( !_undo_stack.empty() || !_redo_stack.empty() )
+    {
+        undo.release_label = tr("Clear the history");
+        undo.release = [this]() { clearUndoStacks(); };
+    }
+    usages.push_back( undo );
+
+    MemoryUsage redo;
+    redo.category = tr("Undo history");
+    redo.name = tr("Redo");
+    redo.bytes = redo_bytes;
+    redo.details = tr("%1 changes").arg( _redo_stack.size() );
+    if( !_redo_stack.empty() )
+    {
+        redo.release_label = tr("Clear the redo");
+        redo.release = [this, redo_bytes]()
+        {
+            _redo_stack.clear();
+            _undo_memory -= std::min( _undo_memory, redo_bytes );
+        };
+    }
+    usages.push_back( redo );
+
+    // the state the next change is compared with, not released
+    MemoryUsage baseline;
+    baseline.category = tr("Undo history");
+    baseline.name = tr("Current state");
+    for (const auto& it: _undo_compressed)
+    {
+        baseline.bytes += size_t( it.second.capacity() );
+    }
+    for (const auto& it: _undo_scenes)
+    {
+        baseline.bytes += it.second.memoryUsage();
+    }
+    baseline.details = tr("%1 tabs, %2 compressed").arg( _undo_scenes.size() )
+                                                   .arg( _undo_compressed.size() );
+    usages.push_back( baseline );
+
+    if( _replay_widget )
+    {
+        for (auto& usage: _replay_widget->memoryUsage())
+        {
+            usages.push_back( std::move(usage) );
+        }
+    }
+#ifdef ZMQ_FOUND
+    if( _monitor_widget )
+    {
+        for (auto& usage: _monitor_widget->memoryUsage())
+        {
+            usages.push_back( std::move(usage) );
+        }
+    }
+#endif
+    return usages;
+}
+
+void MainWindow::onMemoryReport()
+{
+    MemoryReportDialog dialog( [this]() { return memoryReport(); }, this );
+    dialog.exec();
+}
+
+bool MainWindow::loadReplayLog(const QString &filename)
+{
+    SidepanelReplay* replay = replayWidget();
+    if( !replay->loadLogFile( filename ) )
+    {
+        return false;
+    }
+    while( replay->isParsing() )
+    {
+        QApplication::processEvents( QEventLoop::AllEvents, 50 );
+    }
+    return replay->transitionsCount() > 0;
+}
+
+QString MainWindow::exportReplayFrames(const FrameExportOptions &options,
+                                       const std::function<bool (int, int)> &progress)
+{
+    auto container = getTabByName("BehaviorTree");
+    if( !_replay_widget || !container || _replay_widget->transitionsCount() == 0 )
+    {
+        return tr("There is no log loaded in Replay mode");
+    }
+    const SceneSnapshot snapshot = SceneSnapshot::capture( *container, options.scale );
+    const QString error = ExportReplayFrames( snapshot, _replay_widget->transitions(),
+                                              options, progress );
+    // the capture reset the status shown by the tab
+    _replay_widget->refreshNodeStyles();
+    return error;
+}
+
+void MainWindow::onExportReplayFrames()
+{
+    if( !_replay_widget || _replay_widget->transitionsCount() == 0 )
+    {
+        QMessageBox::warning( this, tr("Export Replay Frames"),
+                              tr("Load a log in Replay mode first") );
+        return;
+    }
+    const ReplayTransitions& transitions = _replay_widget->transitions();
+    const double duration = transitions.back().timestamp - transitions.timestamp(0);
+
+    QDialog dialog( this );
+    dialog.setWindowTitle( tr("Export Replay Frames") );
+    QFormLayout* form = new QFormLayout( &dialog );
+
+    QComboBox* combo_output = new QComboBox( &dialog );
+    combo_output->addItem( tr("Video (ffmpeg)") );
+    combo_output->addItem( tr("PNG files") );
+
+    QDoubleSpinBox* spin_fps = new QDoubleSpinBox( &dialog );
+    spin_fps->setRange( 1, 120 );
+    spin_fps->setValue( 10 );
+    QDoubleSpinBox* spin_speed = new QDoubleSpinBox( &dialog );
+    spin_speed->setRange( 0.01, 1000 );
+    spin_speed->setValue( 1 );
+    spin_speed->setSuffix( " x" );
+    QDoubleSpinBox* spin_scale = new QDoubleSpinBox( &dialog );
+    spin_scale->setRange( 0.1, 4 );
+    spin_scale->setSingleStep( 0.25 );
+    spin_scale->setValue( 1 );
+
+    QDoubleSpinBox* spin_from = new QDoubleSpinBox( &dialog );
+    QDoubleSpinBox* spin_to   = new QDoubleSpinBox( &dialog );
+    for (QDoubleSpinBox* spin: {spin_from, spin_to} )
+    {
+        spin->setRange( 0, duration );
+        spin->setDecimals( 3 );
+        spin->setSuffix( " s" );
+    }
+    spin_to->setValue( duration );
+
+    QDialogButtonBox* buttons = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                                      Qt::Horizontal, &dialog );
+    connect( buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept );
+    connect( buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject );
+
+    form->addRow( tr("Output:"), combo_output );
+    form->addRow( tr("Frames per second:"), spin_fps );
+    form->addRow( tr("Speed:"), spin_speed );
+    form->addRow( tr("Scale:"), spin_scale );
+    form->addRow( tr("From:"), spin_from );
+    form->addRow( tr("To:"), spin_to );
+    form->addRow( buttons );
+
+    if( dialog.exec() != QDialog::Accepted )
+    {
+        return;
+    }
+
+    QSettings settings;
+    QString directory_path  = settings.value("MainWindow.lastFramesDirectory",
+                                             QDir::homePath() ).toString();
+    const bool video = ( combo_output->currentIndex() == 0 );
+    QString output;
+    if( video )
+    {
+        output = QFileDialog::getSaveFileName( this, tr("Export Replay Frames"), directory_path,
+                                               tr("Video (*.mp4 *.webm *.mkv *.gif)") );
+        if( !output.isEmpty() && !FrameExportOptions::isVideo( output ) )
+        {
+            output += ".mp4";
+        }
+    }
+    else{
+        output = QFileDialog::getExistingDirectory( this, tr("Export Replay Frames"), directory_path );
+    }
+    if( output.isEmpty() )
+    {
+        return;
+    }
+    directory_path = video ? QFileInfo(output).absolutePath() : output;
+    settings.setValue("MainWindow.lastFramesDirectory", directory_path);
+    settings.sync();
+
+    FrameExportOptions options;
+    options.output = output;
+    options.fps    = spin_fps->value();
+    options.speed  = spin_speed->value();
+    options.scale  = spin_scale->value();
+    options.begin  = spin_from->value();
+    options.end    = spin_to->value();
+
+    QProgressDialog progress_dialog( tr("Exporting the frames..."), tr("Cancel"), 0, 1, this );
+    progress_dialog.setWindowModality( Qt::WindowModal );
+    progress_dialog.setMinimumDuration( 500 );
+    const QString error = exportReplayFrames( options, [&progress_dialog](int done, int total)
+    {
+        progress_dialog.setMaximum( total );
+        progress_dialog.setValue( done );
+        return !progress_dialog.wasCanceled();
+    });
+    progress_dialog.reset();
+
+    if( !error.isEmpty() )
+    {
+        QMessageBox::warning( this, tr("Export Replay Frames"), error );
+    }
 }
 
 void MainWindow::onCreateAbsBehaviorTree(const AbsBehaviorTree &tree,
@@ -1192,6 +2055,10 @@ void MainWindow::onCreateAbsBehaviorTree(const AbsBehaviorTree &tree,
     const QSignalBlocker blocker( container );
     container->loadSceneFromTree( tree );
     container->nodeReorder();
+    if( StartupTiming::active() )
+    {
+        StartupTiming::mark( "first tree" );
+    }
 
     if( secondary_tabs ){
       for(const auto& node: tree.nodes())
@@ -1213,29 +2080,47 @@ void MainWindow::on_actionClear_triggered()
     clearUndoStacks();
 }
 
+std::map<QString, int> MainWindow::modelUsers(const QString &ID)
+{
+    std::map<QString, int> users;
+    for (auto& it: _tab_info)
+    {
+        const int count = it.second->modelUsage( ID );
+        if( count > 0 )
+        {
+            users.insert( { it.first, count } );
+        }
+    }
+    return users;
+}
+
+int MainWindow::modelUsage(const QString &ID)
+{
+    int count = 0;
+    for (auto& it: _tab_info)
+    {
+        count += it.second->modelUsage( ID );
+    }
+    return count;
+}
+
 void MainWindow::onTreeNodeEdited(QString prev_ID, QString new_ID)
 {
+    auto new_model = _treenode_models.find( new_ID );
+
     for (auto& it: _tab_info)
     {
         auto container = it.second;
-        std::vector<QtNodes::Node*> nodes_to_rename;
-
-        for(const auto& node_it: container->scene()->nodes() )
+        // only the tabs using the model are built
+        if( container->modelUsage( prev_ID ) == 0 )
         {
-            QtNodes::Node* graphic_node = node_it.second.get();
-            if( !graphic_node )  {
-                continue;
-            }
-            auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( graphic_node->nodeDataModel() );
-            if( !bt_node ) {
-                continue;
-            }
-
-            if( bt_node->model().registration_ID == prev_ID )
-            {
-                nodes_to_rename.push_back( graphic_node );
-            }
+            continue;
         }
+        if( new_model != _treenode_models.end() )
+        {
+            container->substituteCollapsedModel( prev_ID, new_model->second );
+        }
+        const std::vector<QtNodes::Node*> nodes_to_rename = container->nodesUsingModel( prev_ID );
 
         for(auto& graphic_node: nodes_to_rename )
         {
@@ -1279,22 +2164,94 @@ void MainWindow::onActionClearTriggered(bool create_new)
     }
 
     _editor_widget->clear();
-    _replay_widget->clear();
+    if( _replay_widget )
+    {
+        _replay_widget->clear();
+    }
 #ifdef ZMQ_FOUND
-    _monitor_widget->clear();
+    if( _monitor_widget )
+    {
+        _monitor_widget->clear();
+    }
 #endif
 
 }
 
 
+SidepanelReplay *MainWindow::replayWidget()
+{
+    if( !_replay_widget )
+    {
+        TraceScope trace( "startup", "createReplayPanel" );
+        _replay_widget = new SidepanelReplay(this);
+        // it takes all the height of leftFrame
+        static_cast<QVBoxLayout*>( ui->leftFrame->layout() )->addWidget( _replay_widget, 1 );
+
+        connect( _replay_widget, &SidepanelReplay::loadBehaviorTree, this,
+                 [this](const AbsBehaviorTree &tree, const QString &bt_name)
+        {
+            onCreateAbsBehaviorTree(tree, bt_name, false);
+        });
+        connect( _replay_widget, &SidepanelReplay::addNewModels,
+                this, &MainWindow::onAddModelsToRegistry);
+        connect( _replay_widget, &SidepanelReplay::changeNodeStyle,
+                this, &MainWindow::onChangeNodesStatus);
+    }
+    return _replay_widget;
+}
+
+#ifdef ZMQ_FOUND
+SidepanelMonitor *MainWindow::monitorWidget()
+{
+    if( !_monitor_widget )
+    {
+        TraceScope trace( "startup", "createMonitorPanel" );
+        _monitor_widget = new SidepanelMonitor(
+            this, _monitor_address, _monitor_publisher_port, _monitor_server_port);
+        ui->leftFrame->layout()->addWidget( _monitor_widget );
+
+        connect( ui->toolButtonConnect, &QToolButton::clicked,
+                _monitor_widget, &SidepanelMonitor::on_Connect );
+        connect( _monitor_widget, &SidepanelMonitor::connectionUpdate,
+                this, &MainWindow::onConnectionUpdate );
+        connect( _monitor_widget, &SidepanelMonitor::addNewModels,
+                this, &MainWindow::onAddModelsToRegistry);
+        connect( _monitor_widget, &SidepanelMonitor::changeNodeStyle,
+                this, &MainWindow::onChangeNodesStatus);
+        connect( _monitor_widget, &SidepanelMonitor::changeNodeTimings,
+                this, &MainWindow::onChangeNodesTimings);
+        connect( _monitor_widget, &SidepanelMonitor::loadBehaviorTree, this,
+                 [this](const AbsBehaviorTree &tree, const QString &bt_name)
+        {
+            onCreateAbsBehaviorTree(tree, bt_name, false);
+        });
+    }
+    return _monitor_widget;
+}
+#endif
+
 void MainWindow::updateCurrentMode()
 {
     const bool NOT_EDITOR = _current_mode != GraphicMode::EDITOR;
 
     _editor_widget->setHidden( NOT_EDITOR );
-    _replay_widget->setHidden( _current_mode != GraphicMode::REPLAY );
+    if( _current_mode == GraphicMode::REPLAY )
+    {
+        replayWidget();
+    }
+    if( _replay_widget )
+    {
+        _replay_widget->setHidden( _current_mode != GraphicMode::REPLAY );
+    }
 #ifdef ZMQ_FOUND
-    _monitor_widget->setHidden( _current_mode != GraphicMode::MONITOR );
+    if( _current_mode == GraphicMode::MONITOR )
+    {
+        monitorWidget();
+    }
+    if( _monitor_widget )
+    {
+        _monitor_widget->setHidden( _current_mode != GraphicMode::MONITOR );
+    }
 #endif
 
     ui->toolButtonLoadFile->setHidden( _current_mode == GraphicMode::MONITOR );
@@ -1318,8 +2275,11 @@ void MainWindow::updateCurrentMode()
     {
         connect( ui->toolButtonLoadFile, &QToolButton::clicked,
                 this, &MainWindow::on_actionLoad_triggered );
-        disconnect( ui->toolButtonLoadFile, &QToolButton::clicked,
-                   _replay_widget, &SidepanelReplay::on_LoadLog );
+        if( _replay_widget )
+        {
+            disconnect( ui->toolButtonLoadFile, &QToolButton::clicked,
+                       _replay_widget, &SidepanelReplay::on_LoadLog );
+        }
     }
     else if( _current_mode == GraphicMode::REPLAY )
     {
@@ -1355,27 +2315,208 @@ void MainWindow::refreshNodesLayout(QtNodes::PortLayout new_layout)
         ui->toolButtonLayout->update();
     }
 
-    bool refreshed = false;
+    // the layouts of the previous toggle are computed again
+    _layout_watcher.cancel();
+    _layout_watcher.waitForFinished();
+    _layout_jobs.clear();
+
     {
         const QSignalBlocker blocker( currentTabInfo() );
         for(auto& tab: _tab_info)
         {
+            if( !tab.second->isMaterialized() )
+            {
+                tab.second->setLazyLayout( new_layout );
+                continue;
+            }
             auto scene = tab.second->scene();
             if( scene->layout() != new_layout )
             {
-                auto abstract_tree = BuildTreeFromScene( scene );
+                LayoutJob job;
+                job.tab_name = tab.first;
+                job.tree = BuildTreeFromScene( scene );
+                job.node_ids.reserve( job.tree.nodesCount() );
+                for (const auto& abs_node: job.tree.nodes())
+                {
+                    job.node_ids.push_back( abs_node.graphic_node->id() );
+                }
+                job.port_layout = new_layout;
                 scene->setLayout( new_layout );
-                NodeReorder( *scene, abstract_tree );
-                refreshed = true;
+                _layout_jobs.push_back( std::move(job) );
             }
         }
-        on_toolButtonCenterView_pressed();
     }
     _current_layout = new_layout;
-    if(refreshed)
+
+    if( _layout_jobs.empty() )
+    {
+        on_toolButtonCenterView_pressed();
+        return;
+    }
+    // only the sizes and the children are read: the trees of all the tabs
+    // are laid out in the thread pool, the UI is not blocked
+    _layout_watcher.setFuture( QtConcurrent::map( _layout_jobs, [](LayoutJob& job)
+    {
+        job.tree_layout.layout( job.tree, job.port_layout );
+    }) );
+}
+
+void MainWindow::applyLayoutJobs()
+{
+    if( _layout_jobs.empty() )
+    {
+        return;
+    }
+    std::vector<LayoutJob> jobs;
+    std::swap( jobs, _layout_jobs );
+
+    {
+        const QSignalBlocker blocker( currentTabInfo() );
+        for (auto& job: jobs)
+        {
+            auto tab_it = _tab_info.find( job.tab_name );
+            if( tab_it == _tab_info.end() || !tab_it->second->isMaterialized() )
+            {
+                continue;
+            }
+            GraphicContainer* container = tab_it->second;
+            auto scene = container->scene();
+
+            // the scene may have been edited in the meantime
+            const auto& scene_nodes = scene->nodes();
+            bool unchanged = scene_nodes.size() == job.node_ids.size() &&
+                             scene->layout() == job.port_layout;
+            for (size_t i = 0; unchanged && i < job.node_ids.size(); i++)
+            {
+                unchanged = scene_nodes.count( job.node_ids[i] ) > 0;
+            }
+            if( !unchanged )
+            {
+                container->nodeReorder();
+                continue;
+            }
+
+            for (size_t i = 0; i < job.node_ids.size(); i++)
+            {
+                QtNodes::Node& node = *scene_nodes.find( job.node_ids[i] )->second;
+                const QPointF& pos = job.tree.node(i)->pos;
+                if( scene->getNodePosition( node ) != pos )
+                {
+                    scene->setNodePosition( node, pos );
+                }
+            }
+            container->setTreeLayout( std::move(job.tree_layout) );
+        }
+        on_toolButtonCenterView_pressed();
+    }
+    onPushUndo();
+}
+
+std::vector<TabSnapshot> MainWindow::tabSnapshots()
+{
+    std::vector<TabSnapshot> tabs;
+    tabs.reserve( _tab_info.size() );
+    for (const auto& it: _tab_info)
+    {
+        GraphicContainer* container = it.second;
+        TabSnapshot tab;
+        tab.tab_name = it.first;
+
+        // what the tab keeps: no scene is built
+        if( container->isMaterialized() )
+        {
+            tab.tree = container->tree();
+            size_t tree_nodes = 0;
+            for (auto node: container->nodesByIndex())
+            {
+                tab.node_ids.push_back( node ? node->id() : QUuid() );
+                tree_nodes += node ? 1 : 0;
+            }
+            tab.disconnected_nodes = container->scene()->nodes().size() - tree_nodes;
+        }
+        else if( auto lazy_tree = container->lazyTree() )
+        {
+            tab.tree = lazy_tree;
+        }
+        else{
+            tab.scene_state = container->evictedState();
+        }
+        tabs.push_back( std::move(tab) );
+    }
+    return tabs;
+}
+
+void MainWindow::scheduleValidation()
+{
+    _validation_timer.start();
+}
+
+void MainWindow::showNodeLocation(const NodeLocation &location)
+{
+    auto container = getTabByName( location.tab_name );
+    if( !container )
+    {
+        return;
+    }
+    for (int index = 0; index < ui->tabWidget->count(); index++)
     {
-        onPushUndo();
+        if( ui->tabWidget->tabText(index) == location.tab_name )
+        {
+            ui->tabWidget->setCurrentIndex( index );
+            break;
+        }
+    }
+    // a problem of the whole tree
+    if( location.registration_ID.isEmpty() )
+    {
+        return;
+    }
+
+    QtNodes::Node* node = nullptr;
+    auto scene = container->scene();
+    if( !location.node_id.isNull() )
+    {
+        auto it = scene->nodes().find( location.node_id );
+        if( it != scene->nodes().end() )
+        {
+            node = it->second.get();
+        }
+    }
+    else{
+        // a tab never shown: its scene was built from the tree, the node is
+        // found by its model and name if the indices differ
+        auto sameNode = [&location](QtNodes::Node* candidate) -> bool
+        {
+            auto bt_model = candidate ? dynamic_cast<BehaviorTreeDataModel*>( candidate->nodeDataModel() ) : nullptr;
+            return bt_model && bt_model->registrationName() == location.registration_ID &&
+                   bt_model->instanceName() == location.instance_name;
+        };
+        const auto& nodes = container->nodesByIndex();
+        if( location.node_index >= 0 && location.node_index < int(nodes.size()) &&
+            sameNode( nodes[location.node_index] ) )
+        {
+            node = nodes[location.node_index];
+        }
+        int occurrence = 0;
+        for (size_t index = 0; !node && index < nodes.size(); index++)
+        {
+            if( sameNode( nodes[index] ) && occurrence++ == location.occurrence )
+            {
+                node = nodes[index];
+            }
+        }
+    }
+
+    if( !node )
+    {
+        QMessageBox::warning(this, tr("Oops!"),
+                             tr("The node is not in the tree anymore."),
+                             QMessageBox::Cancel);
+        _search_widget->refresh();
+        scheduleValidation();
+        return;
     }
+    container->focusNode( *node );
 }
 
 void MainWindow::refreshExpandedSubtrees()
@@ -1444,10 +2585,25 @@ void MainWindow::on_actionEditor_mode_triggered()
     updateCurrentMode();
 
 #ifdef ZMQ_FOUND
-    _monitor_widget->clear();
+    if( _monitor_widget )
+    {
+        _monitor_widget->clear();
+    }
+    // the monitored trees stay, without their timings
+    for (auto& it: _tab_info)
+    {
+        it.second->clearNodeTimingBadges();
+    }
 #endif
-
-    _replay_widget->clear();
+    if( _replay_widget )
+    {
+        _replay_widget->clear();
+    }
+    // it was not offered in the other modes
+    if( _autosave_deferred )
+    {
+        recoverAutosave();
+    }
 }
 
 void MainWindow::on_actionMonitor_mode_triggered()
@@ -1465,7 +2621,7 @@ void MainWindow::on_actionMonitor_mode_triggered()
     if( res == QMessageBox::Ok)
     {
         currentTabInfo()->clearScene();
-        _monitor_widget->clear();
+        monitorWidget()->clear();
         _current_mode = GraphicMode::MONITOR;
         updateCurrentMode();
     }
@@ -1486,7 +2642,7 @@ void MainWindow::on_actionReplay_mode_triggered()
     if( res == QMessageBox::Ok)
     {
         onActionClearTriggered(true);
-        _replay_widget->clear();
+        replayWidget()->clear();
         _current_mode = GraphicMode::REPLAY;
         updateCurrentMode();
     }
@@ -1503,25 +2659,39 @@ void MainWindow::on_tabWidget_currentChanged(int index)
     if( tab )
     {
         const QSignalBlocker blocker( tab );
-        tab->nodeReorder();
-        _current_state.current_tab_name = ui->tabWidget->tabText( index );
+        tab->markUsed();
+        if( tab->isMaterialized() )
+        {
+            tab->nodeReorder();
+        }
+        else{
+            // a tree is laid out once built; a restored scene keeps its positions
+            tab->materialize();
+        }
         refreshExpandedSubtrees();
         tab->zoomHomeView();
+        _minimap->setView( tab->view() );
     }
 }
 
 bool MainWindow::SavedState::operator ==(const MainWindow::SavedState &other) const
 {
     if( current_tab_name != other.current_tab_name ||
-        json_states.size() != other.json_states.size())
+        json_states.size() != other.json_states.size() ||
+        lazy_trees != other.lazy_trees )
     {
         return false;
     }
     for(auto& it: json_states  )
     {
         auto other_it = other.json_states.find(it.first);
-        if( other_it == other.json_states.end() ||
-            it.second != other_it->second)
+        if( other_it == other.json_states.end() )
+        {
+            return false;
+        }
+        // the tabs that did not change share the same data
+        if( it.second.constData() != other_it->second.constData() &&
+            it.second != other_it->second )
         {
             return false;
         }
@@ -1534,61 +2704,61 @@ bool MainWindow::SavedState::operator ==(const MainWindow::SavedState &other) co
     return true;
 }
 
-void MainWindow::resetTreeStyle(AbsBehaviorTree &tree){
-    //printf("resetTreeStyle\n");
-    QtNodes::NodeStyle  node_style;
-    QtNodes::ConnectionStyle conn_style;
-
-    for(auto abs_node: tree.nodes()){
-        auto gui_node = abs_node.graphic_node;
-
-        gui_node->nodeDataModel()->setNodeStyle( node_style );
-        gui_node->nodeGraphicsObject().update();
-
-        const auto& conn_in = gui_node->nodeState().connections(PortType::In, 0 );
-        if(conn_in.size() == 1)
-        {
-            auto conn = conn_in.begin()->second;
-            conn->setStyle( conn_style );
-            conn->connectionGraphicsObject().update();
-        }
-    }
-}
-
 void MainWindow::onChangeNodesStatus(const QString& bt_name,
                                      const std::vector<std::pair<int, NodeStatus> > &node_status)
 {
-    auto tree = BuildTreeFromScene( getTabByName(bt_name)->scene() );
+    auto container = getTabByName(bt_name);
+    if( !container )
+    {
+        // the tab of a monitored tree was closed
+        return;
+    }
+    if( StartupTiming::active() )
+    {
+        StartupTiming::finish( "first status" );
+    }
+    QtNodes::PaintProfiler::Scope profile( QtNodes::PaintProfiler::StatusUpdate );
+    TraceScope trace( "scene", "onChangeNodesStatus" );
+    trace.setArgument( "nodes", node_status.size() );
 
-    std::vector<NodeStatus> vec_last_status(tree.nodesCount());
+    // a direct lookup, the scene is walked only when its structure changed
+    const size_t nodes_count = container->nodesByIndex().size();
 
-    // printf("---\n");
+    std::vector<NodeStatus> vec_last_status(nodes_count);
 
     for (auto& it: node_status)
     {
         const int index = it.first;
         const NodeStatus status = it.second;
-        auto& abs_node = tree.nodes().at(index);
-
-        // printf("%3d: %d, %s\n", index, (int)it.second, abs_node.instance_name.toStdString().c_str());
+        if( index < 0 || size_t(index) >= nodes_count )
+        {
+            continue;
+        }
 
         if(index == 1 && it.second == NodeStatus::RUNNING)
-            resetTreeStyle(tree);
+            container->resetNodeStatusStyles();
 
-        auto gui_node = abs_node.graphic_node;
-        auto style = getStyleFromStatus( status, vec_last_status[index] );
-        gui_node->nodeDataModel()->setNodeStyle( style.first );
-        gui_node->nodeGraphicsObject().update();
+        // only the nodes whose appearance changes are repainted
+        container->setNodeStatusStyle( index, status, vec_last_status[index] );
 
         vec_last_status[index] = status;
+    }
+    _minimap->statusChanged();
+}
 
-        const auto& conn_in = gui_node->nodeState().connections(PortType::In, 0 );
-        if(conn_in.size() == 1)
-        {
-            auto conn = conn_in.begin()->second;
-            conn->setStyle( style.second );
-            conn->connectionGraphicsObject().update();
-        }
+void MainWindow::onChangeNodesTimings(const QString &bt_name,
+                                      const std::vector<std::pair<int, QString> > &labels)
+{
+    auto container = getTabByName(bt_name);
+    if( !container )
+    {
+        return;
+    }
+    TraceScope trace( "scene", "onChangeNodesTimings" );
+    trace.setArgument( "nodes", labels.size() );
+    for (const auto& it: labels)
+    {
+        container->setNodeTimingBadge( it.first, it.second );
     }
 }
 
@@ -1738,6 +2908,100 @@ void MainWindow::on_actionReportIssue_triggered()
     QDesktopServices::openUrl(QUrl(url));
 }
 
+void MainWindow::on_actionNewWindow_triggered()
+{
+    TraceScope trace( "startup", "newWindow" );
+    newEditorWindow( 1 );
+}
+
+MainWindow* MainWindow::newEditorWindow(int offset)
+{
+    auto window = new MainWindow( GraphicMode::EDITOR );
+    window->setAttribute( Qt::WA_DeleteOnClose );
+    window->setWindowTitle( windowTitle() );
+    // not exactly above this one, restored from the same settings
+    window->move( pos() + offset * QPoint( 40, 40 ) );
+    window->show();
+    return window;
+}
+
+void MainWindow::on_actionCompare_triggered()
+{
+    QSettings settings;
+    QString directory_path  = settings.value("MainWindow.lastLoadDirectory",
+                                            QDir::homePath() ).toString();
+
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Compare with BehaviorTree file"), directory_path,
+                                                    tr("BehaviorTree files (*.xml)"));
+    QFile file(fileName);
+    if (!QFileInfo::exists(fileName) || !file.open(QIODevice::ReadOnly)){
+        return;
+    }
+
+    QString xml_text;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        xml_text += in.readLine();
+    }
+
+    // the trees of the file are only read: the models of the file are not
+    // registered
+    std::vector<TabSnapshot> tabs;
+    try{
+        XMLProject project = ReadProjectFromXML( xml_text );
+        NodeModels models = _treenode_models;
+        models.insert( project.custom_models.begin(), project.custom_models.end() );
+        for (auto& it: project.trees)
+        {
+            ResolveTreeModels( it.second, models );
+            TabSnapshot tab;
+            tab.tab_name = it.first;
+            tab.tree = std::make_shared<const AbsBehaviorTree>( std::move(it.second) );
+            tabs.push_back( std::move(tab) );
+        }
+    }
+    catch( std::runtime_error& err)
+    {
+        QMessageBox::critical(this, "Error parsing the XML", err.what() );
+        return;
+    }
+
+    _diff_widget->setBefore( std::move(tabs), QFileInfo(fileName).fileName() );
+    _diff_widget->compare( tabSnapshots() );
+    _diff_dock->show();
+    _diff_dock->raise();
+}
+
+void MainWindow::onSaveTrace()
+{
+    if( TraceRecorder::eventsCount() == 0 )
+    {
+        QMessageBox::information( this, tr("Save Trace"),
+                                  tr("Nothing was recorded: enable \"Record Trace\" first.") );
+        return;
+    }
+    QSettings settings;
+    QString directory_path  = settings.value("MainWindow.lastSaveDirectory",
+                                            QDir::currentPath() ).toString();
+
+    auto fileName = QFileDialog::getSaveFileName(this, "Save the trace to file",
+                                                 directory_path, "Chrome trace files (*.json)");
+    if (fileName.isEmpty()){
+        return;
+    }
+    if (!fileName.endsWith(".json"))
+    {
+        fileName += ".json";
+    }
+    const QString error = TraceRecorder::writeChromeTrace( fileName );
+    if( !error.isEmpty() )
+    {
+        QMessageBox::warning( this, tr("Save Trace"),
+                              tr("Can not write %1:\n\n%2").arg( fileName, error ) );
+    }
+}
+
 // returns the current graphic mode
 GraphicMode MainWindow::getGraphicMode(void) const
 {
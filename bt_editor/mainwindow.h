@@ -8,15 +8,24 @@
 #include <QShortcut>
 #include <QShowEvent>
 #include <QTimer>
+#include <QFutureWatcher>
 #include <deque>
+#include <set>
 #include <thread>
 #include <mutex>
 #include <nodes/DataModelRegistry>
 
 #include "graphic_container.h"
+#include "tree_layout.h"
 #include "XML_utilities.hpp"
+#include "project_cache.h"
 #include "sidepanel_editor.h"
 #include "sidepanel_replay.h"
+#include "replay_frame_export.h"
+#include "project_search_panel.h"
+#include "problems_panel.h"
+#include "scene_minimap.h"
+#include "tree_diff_panel.h"
 #include "models/SubtreeNodeModel.hpp"
 
 #ifdef ZMQ_FOUND
@@ -51,22 +60,43 @@ public:
                         QWidget *parent = nullptr);
     ~MainWindow() override;
 
-    void loadFromXML(const QString &xml_text);
+    bool loadFromXML(const QString &xml_text);
 
     QString saveToXML() const ;
 
+    // copy of the trees and models, to be serialized outside of the GUI thread
+    XMLProject snapshotProject() const;
+
+    // ask whether to load the files autosaved by the sessions that did not
+    // exit cleanly, each one in a window
+    void recoverAutosave();
+
     GraphicContainer* currentTabInfo();
 
     GraphicContainer *getTabByName(const QString& name);
 
     void clearTreeModels();
 
-    const NodeModels &registeredModels() const;
+    // the tabs using the model, with how many of their nodes do, collapsed
+    // branches included. See GraphicContainer::modelUsage()
+    std::map<QString, int> modelUsers(const QString& ID);
 
-    void resetTreeStyle(AbsBehaviorTree &tree);
+    // in all the tabs
+    int modelUsage(const QString& ID);
+
+    const NodeModels &registeredModels() const;
 
     GraphicMode getGraphicMode(void) const;
 
+    // load a log in Replay mode and wait until it is parsed. False if it has
+    // no transition
+    bool loadReplayLog(const QString& filename);
+
+    // the frames of the log loaded in Replay mode, drawn from the tab of its
+    // tree, see ExportReplayFrames(). Returns the error, empty if it succeeded
+    QString exportReplayFrames(const FrameExportOptions& options,
+                               const std::function<bool(int, int)>& progress);
+
 public slots:
 
     void onAutoArrange();
@@ -75,10 +105,20 @@ public slots:
 
     void onPushUndo();
 
+    void onAutosave();
+
     void onUndoInvoked();
 
     void onRedoInvoked();
 
+    // the selected nodes of the current tab, to the system clipboard
+    void onCopyNodes(bool with_descendants);
+
+    void onCutNodes();
+
+    // under the mouse, or at the center of the view
+    void onPasteNodes();
+
     void onConnectionUpdate(bool connected);
 
     void onRequestSubTreeExpand(GraphicContainer& container,
@@ -86,6 +126,9 @@ public slots:
 
     void onAddToModelRegistry(const NodeModel& model);
 
+    // with a single update of the palette
+    void onAddModelsToRegistry(const NodeModels& models);
+
     void onDestroySubTree(const QString &ID);
 
     void onModelRemoveRequested(QString ID);
@@ -110,6 +153,9 @@ public slots:
 
     void onChangeNodesStatus(const QString& bt_name, const std::vector<std::pair<int, NodeStatus>>& node_status);
 
+    // the badges of the monitor, see SidepanelMonitor::changeNodeTimings
+    void onChangeNodesTimings(const QString& bt_name, const std::vector<std::pair<int, QString>>& labels);
+
     void on_toolButtonLayout_clicked();
 
     void on_actionEditor_mode_triggered();
@@ -132,6 +178,9 @@ public slots:
 
     void onTabSetMainTree(int tab_index);
 
+    // switch to the tab and select the node, if it is still there
+    void showNodeLocation(const NodeLocation& location);
+
 signals:
     void updateGraphic();
 
@@ -140,6 +189,18 @@ private slots:
 
     void on_actionReportIssue_triggered();
 
+    void on_actionCompare_triggered();
+
+    // another project in the same process, sharing the models of ModelDatabase
+    void on_actionNewWindow_triggered();
+
+    // the events of TraceRecorder, as Chrome trace JSON
+    void onSaveTrace();
+
+    void onMemoryReport();
+
+    void onExportReplayFrames();
+
 public:
 
     void lockEditing(const bool locked);
@@ -148,6 +209,12 @@ private:
 
     void updateCurrentMode();
 
+    // the panels of Replay and Monitor mode, created at the first call
+    SidepanelReplay* replayWidget();
+#ifdef ZMQ_FOUND
+    SidepanelMonitor* monitorWidget();
+#endif
+
     bool eventFilter(QObject *obj, QEvent *event) override;
 
     void showEvent(QShowEvent *event) override;
@@ -160,11 +227,12 @@ private:
 
     void refreshExpandedSubtrees();
 
-    void streamElementAttributes(QXmlStreamWriter &stream, const QDomElement &element) const;
+    // the tabs, as searched and validated in the thread pool
+    std::vector<TabSnapshot> tabSnapshots();
 
-    QString xmlDocumentToString(const QDomDocument &document) const;
-
-    void recursivelySaveNodeCanonically(QXmlStreamWriter &stream, const QDomNode &parent_node) const;
+    // the project is validated again once the edits pause
+    void scheduleValidation();
+    QTimer _validation_timer;
 
     struct SavedState
     {
@@ -173,12 +241,30 @@ private:
         QTransform view_transform;
         QRectF view_area;
         std::map<QString, QByteArray> json_states;
+        // the tabs whose scene is not built yet
+        std::map<QString, std::shared_ptr<const AbsBehaviorTree>> lazy_trees;
         bool operator ==( const SavedState& other) const;
         bool operator !=( const SavedState& other) const { return !( *this == other); }
     };
 
     void loadSavedStateFromJson(SavedState state);
 
+    // An entry of the undo history: the commands of the tabs edited by a
+    // single change. Changes of the tabs themselves (created, closed,
+    // renamed or a different main tree) are stored as full snapshots, with
+    // json_states compressed. The tabs that did not change share the same
+    // compressed data with the previous snapshots.
+    struct UndoEntry
+    {
+        std::vector<SceneCommand> commands;
+        std::shared_ptr<SavedState> snapshot_before;
+        std::shared_ptr<SavedState> snapshot_after;
+        // memory not shared with the older entries
+        size_t memory = 0;
+    };
+
+    void applyUndoEntry(const UndoEntry& entry, bool undo);
+
     QtNodes::Node *subTreeExpand(GraphicContainer& container,
                        QtNodes::Node &node,
                        SubtreeExpandOption option);
@@ -193,17 +279,63 @@ private:
 
     std::mutex _mutex;
 
-    std::deque<SavedState> _undo_stack;
-    std::deque<SavedState> _redo_stack;
-    SavedState _current_state;
+    std::deque<UndoEntry> _undo_stack;
+    std::deque<UndoEntry> _redo_stack;
+    // state of the tabs at the top of the undo history
+    std::map<QString, SceneState> _undo_scenes;
+    QString _undo_main_tree;
+    // compressed json of the tabs in _undo_scenes, shared by the snapshots
+    std::map<QString, QByteArray> _undo_compressed;
+    size_t _undo_memory;
+    size_t _undo_memory_budget;
+
+    int _tab_eviction_minutes;
+
+    int _autosave_seconds;
+    // an edit happened since the last autosave
+    bool _autosave_pending;
+    // the autosave is recovered when the editor is used, see recoverAutosave()
+    bool _autosave_deferred;
+    QFutureWatcher<QString> _save_watcher;
+    QFutureWatcher<QString> _autosave_watcher;
+    QString _save_filename;
+    // the lowest number not used by another window; each window autosaves
+    // to its own file
+    int _window_number;
+    QString autosaveFilename() const;
+
+    // an empty editor, moved by offset steps from this window
+    MainWindow* newEditorWindow(int offset);
+
     QtNodes::PortLayout _current_layout;
 
+    // layout of a tab computed in the thread pool: the tree and the ids of
+    // its nodes are taken from the scene, the positions applied once done
+    struct LayoutJob
+    {
+        QString tab_name;
+        AbsBehaviorTree tree;
+        std::vector<QUuid> node_ids;
+        QtNodes::PortLayout port_layout;
+        TreeLayout tree_layout;
+    };
+    std::vector<LayoutJob> _layout_jobs;
+    QFutureWatcher<void> _layout_watcher;
+    void applyLayoutJobs();
+
     NodeModels _treenode_models;
 
     QString _main_tree;
 
     SidepanelEditor* _editor_widget;
+    // created by replayWidget() and monitorWidget() when the mode is used
     SidepanelReplay* _replay_widget;
+    ProjectSearchPanel* _search_widget;
+    ProblemsPanel* _problems_widget;
+    // overview of the scene of the current tab
+    SceneMinimap* _minimap;
+    TreeDiffPanel* _diff_widget;
+    QDockWidget* _diff_dock;
 #ifdef ZMQ_FOUND
     SidepanelMonitor* _monitor_widget;
 #endif
@@ -214,7 +346,28 @@ private:
     bool _monitor_autoconnect;
 
     MainWindow::SavedState saveCurrentState();
+    MainWindow::SavedState savedStateFromUndoScenes(size_t* new_bytes);
+    void resetUndoScenes();
+    // the scenes of the tabs not shown for _tab_eviction_minutes are destroyed
+    void evictUnusedTabs();
+    // forget the oldest entries until the history fits _undo_memory_budget
+    void trimUndoHistory();
     void clearUndoStacks();
+
+    // tabs, undo history, replay and monitor, see MemoryReportDialog
+    std::vector<MemoryUsage> memoryReport();
+
+    // the tab of the main tree becomes the first one
+    void moveMainTreeTabFirst();
+
+    // hash of the file of the project, empty if it has none
+    QByteArray _project_hash;
+    // the project is different from its file
+    bool _project_modified;
+    // shown by the views of all the tabs
+    bool _profiler_overlay;
+    bool loadFromCache(const CachedProject& cached);
+    void writeProjectCache();
 };
 
 
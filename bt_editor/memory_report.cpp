@@ -0,0 +1,137 @@
+#include "memory_report.h"
+
+#include <map>
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+QString FormatBytes(size_t bytes)
+{
+    if( bytes < 1024 )
+    {
+        return QString("%1 B").arg( bytes );
+    }
+    const char* units[] = { "KB", "MB", "GB" };
+    double value = double(bytes) / 1024.0;
+    int unit = 0;
+    while( value >= 1024.0 && unit < 2 )
+    {
+        value /= 1024.0;
+        unit++;
+    }
+    return QString("%1 %2").arg( value, 0, 'f', 1 ).arg( units[unit] );
+}
+
+MemoryReportDialog::MemoryReportDialog(std::function<std::vector<MemoryUsage>()> report,
+                                       QWidget *parent) :
+    QDialog(parent),
+    _report( std::move(report) )
+{
+    setWindowTitle( tr("Memory Report") );
+    resize( 700, 450 );
+
+    _tree = new QTreeWidget( this );
+    _tree->setColumnCount( 3 );
+    _tree->setHeaderLabels( { tr("Memory"), tr("Size"), tr("Details") } );
+    _tree->setUniformRowHeights( true );
+    _tree->header()->setSectionResizeMode( 0, QHeaderView::Interactive );
+    _tree->header()->setSectionResizeMode( 1, QHeaderView::ResizeToContents );
+    _tree->header()->setStretchLastSection( true );
+    _tree->setColumnWidth( 0, 250 );
+
+    _total_label = new QLabel( this );
+    _release_button = new QPushButton( tr("Release"), this );
+    _release_button->setEnabled( false );
+    auto refresh_button = new QPushButton( tr("Refresh"), this );
+    auto buttons = new QDialogButtonBox( QDialogButtonBox::Close, this );
+
+    auto bottom_layout = new QHBoxLayout();
+    bottom_layout->addWidget( _total_label, 1 );
+    bottom_layout->addWidget( _release_button );
+    bottom_layout->addWidget( refresh_button );
+    bottom_layout->addWidget( buttons );
+
+    auto layout = new QVBoxLayout( this );
+    layout->addWidget( _tree, 1 );
+    layout->addLayout( bottom_layout );
+
+    connect( _tree, &QTreeWidget::itemSelectionChanged,
+             this, &MemoryReportDialog::onSelectionChanged );
+    connect( _release_button, &QPushButton::clicked, this, &MemoryReportDialog::onRelease );
+    connect( refresh_button, &QPushButton::clicked, this, &MemoryReportDialog::refresh );
+    connect( buttons, &QDialogButtonBox::rejected, this, &QDialog::reject );
+
+    refresh();
+}
+
+void MemoryReportDialog::refresh()
+{
+    _usages = _report();
+    _tree->clear();
+
+    // the categories in the order of their first usage
+    std::map<QString, QTreeWidgetItem*> categories;
+    std::map<QString, size_t> category_bytes;
+    size_t total = 0;
+    for (size_t i = 0; i < _usages.size(); i++)
+    {
+        const MemoryUsage& usage = _usages[i];
+        QTreeWidgetItem*& category = categories[usage.category];
+        if( !category )
+        {
+            category = new QTreeWidgetItem( _tree );
+            category->setText( 0, usage.category );
+            category->setExpanded( true );
+        }
+        auto item = new QTreeWidgetItem( category );
+        item->setText( 0, usage.name );
+        item->setText( 1, FormatBytes( usage.bytes ) );
+        item->setData( 1, Qt::TextAlignmentRole, int(Qt::AlignRight | Qt::AlignVCenter) );
+        item->setText( 2, usage.details );
+        item->setData( 0, Qt::UserRole, int(i) );
+        if( usage.release )
+        {
+            item->setToolTip( 0, usage.release_label );
+        }
+        category_bytes[usage.category] += usage.bytes;
+        total += usage.bytes;
+    }
+    for (const auto& it: categories)
+    {
+        it.second->setText( 1, FormatBytes( category_bytes[it.first] ) );
+        it.second->setData( 1, Qt::TextAlignmentRole, int(Qt::AlignRight | Qt::AlignVCenter) );
+        it.second->setData( 0, Qt::UserRole, -1 );
+    }
+    _total_label->setText( tr("Total (estimated): %1").arg( FormatBytes( total ) ) );
+    onSelectionChanged();
+}
+
+void MemoryReportDialog::onSelectionChanged()
+{
+    const auto selected = _tree->selectedItems();
+    const int index = selected.isEmpty() ? -1 : selected.front()->data( 0, Qt::UserRole ).toInt();
+    if( index < 0 || !_usages[index].release )
+    {
+        _release_button->setEnabled( false );
+        _release_button->setText( tr("Release") );
+        return;
+    }
+    _release_button->setEnabled( true );
+    _release_button->setText( _usages[index].release_label );
+}
+
+void MemoryReportDialog::onRelease()
+{
+    const auto selected = _tree->selectedItems();
+    const int index = selected.isEmpty() ? -1 : selected.front()->data( 0, Qt::UserRole ).toInt();
+    if( index < 0 || !_usages[index].release )
+    {
+        return;
+    }
+    _usages[index].release();
+    refresh();
+}
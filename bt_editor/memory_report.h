@@ -0,0 +1,59 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <functional>
+#include <vector>
+#include <QDialog>
+#include <QString>
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+// The memory held by a part of Groot: a tab, the undo history, the replay
+// log... The bytes are an estimate, computed on demand.
+struct MemoryUsage
+{
+    // "Tabs", "Undo history", "Replay", "Monitor"
+    QString category;
+    QString name;
+    // the counts the estimate comes from, e.g. "120 nodes, 40 widgets"
+    QString details;
+    size_t bytes = 0;
+
+    // what release() does, e.g. "Unload the tab". Empty if it can't be released
+    QString release_label;
+    std::function<void()> release;
+};
+
+// "1.5 MB"
+QString FormatBytes(size_t bytes);
+
+// The usages returned by report, grouped by category. A selected usage can be
+// released, then the report is computed again.
+class MemoryReportDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    MemoryReportDialog(std::function<std::vector<MemoryUsage>()> report,
+                       QWidget* parent = nullptr);
+
+public slots:
+    void refresh();
+
+private slots:
+    void onSelectionChanged();
+
+    void onRelease();
+
+private:
+    std::function<std::vector<MemoryUsage>()> _report;
+    std::vector<MemoryUsage> _usages;
+
+    QTreeWidget* _tree;
+    QLabel* _total_label;
+    QPushButton* _release_button;
+};
+
+#endif // MEMORY_REPORT_H
@@ -0,0 +1,93 @@
+#include "model_database.h"
+#include "palette_import.h"
+#include "trace_recorder.h"
+#include "models/SubtreeNodeModel.hpp"
+#include <QDateTime>
+#include <QFileInfo>
+
+using QtNodes::DataModelRegistry;
+
+namespace {
+
+DataModelRegistry::RegistryItemCreator makeCreator(const NodeModel& model, bool builtin)
+{
+    namespace util = QtNodes::detail;
+    // copying the creator, into each registry, only copies the pointer
+    const auto shared_model = std::make_shared<const NodeModel>( model );
+    return [shared_model, builtin]() -> DataModelRegistry::RegistryItemPtr
+    {
+        if( !builtin && shared_model->type == NodeType::SUBTREE )
+        {
+            return util::make_unique<SubtreeNodeModel>( *shared_model );
+        }
+        return util::make_unique<BehaviorTreeDataModel>( *shared_model );
+    };
+}
+
+}
+
+ModelDatabase::ModelDatabase(const NodeModels &builtin_models, const NodeModels &palette_models)
+{
+    for (const auto& it: builtin_models)
+    {
+        const QString category = ( it.first == "Root" ) ?
+                    QString("Root") : QString::fromStdString( BT::toStr(it.second.type) );
+        _entries.insert( { it.first, { category, makeCreator( it.second, true ) } } );
+        _models.insert( it );
+    }
+    for (const auto& it: palette_models)
+    {
+        if( _models.count( it.first ) == 0 )
+        {
+            _entries.insert( { it.first, { QString::fromStdString( BT::toStr(it.second.type) ),
+                                           creator( it.second ) } } );
+            _models.insert( it );
+        }
+    }
+}
+
+ModelDatabase::Ptr ModelDatabase::builtin()
+{
+    static const Ptr database = std::make_shared<const ModelDatabase>( BuiltinNodeModels(), NodeModels() );
+    return database;
+}
+
+ModelDatabase::Ptr ModelDatabase::withPalettes()
+{
+    static Ptr database;
+    static QDateTime cache_modified;
+
+    // null if there is no cache
+    auto modifiedTime = [](const QString& filename)
+    {
+        const QFileInfo info( filename );
+        return info.exists() ? info.lastModified() : QDateTime();
+    };
+    const QString cache_file = PaletteImport::cacheFilename();
+    if( database && modifiedTime( cache_file ) == cache_modified )
+    {
+        return database;
+    }
+
+    TraceScope trace( "startup", "restorePalettes" );
+    const ImportedPalettes palettes = PaletteImport::restore( cache_file );
+    database = palettes.models.empty() ? builtin() :
+                                         std::make_shared<const ModelDatabase>( BuiltinNodeModels(), palettes.models );
+    // restore() writes the cache again if a palette changed
+    cache_modified = modifiedTime( cache_file );
+    trace.setArgument( "models", palettes.models.size() );
+    return database;
+}
+
+void ModelDatabase::registerModels(DataModelRegistry &registry) const
+{
+    for (const auto& it: _entries)
+    {
+        registry.registerModel( it.second.category, it.second.creator, it.first );
+    }
+}
+
+DataModelRegistry::RegistryItemCreator ModelDatabase::creator(const NodeModel &model)
+{
+    return makeCreator( model, false );
+}
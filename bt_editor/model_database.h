@@ -0,0 +1,53 @@
+#ifndef MODEL_DATABASE_H
+#define MODEL_DATABASE_H
+
+#include <map>
+#include <memory>
+#include <nodes/DataModelRegistry>
+#include "bt_editor_base.h"
+
+// The models that every window starts from: the builtin ones and, in the
+// editor, those of the palettes imported in the previous session (see
+// PaletteImport). They are read once per process and never change: all the
+// windows share the same database, and the creators they register share
+// its models instead of copying them.
+//
+// A window that registers, edits or removes a model changes only its own
+// registry and its own NodeModels; the database stays as it is, alive as
+// long as a registry uses one of its creators.
+class ModelDatabase
+{
+public:
+    typedef std::shared_ptr<const ModelDatabase> Ptr;
+
+    // the builtin models
+    static Ptr builtin();
+
+    // the builtin models and the palettes of PaletteImport::cacheFilename().
+    // Read again only if the cache was written since the previous call.
+    // GUI thread
+    static Ptr withPalettes();
+
+    ModelDatabase(const NodeModels& builtin_models, const NodeModels& palette_models);
+
+    const NodeModels& models() const { return _models; }
+
+    // every model, with the creators of the database
+    void registerModels(QtNodes::DataModelRegistry& registry) const;
+
+    // the creator of a model that is not builtin, for the registry of a
+    // window. The model is shared by the copies of the creator
+    static QtNodes::DataModelRegistry::RegistryItemCreator creator(const NodeModel& model);
+
+private:
+    struct Entry
+    {
+        QString category;
+        QtNodes::DataModelRegistry::RegistryItemCreator creator;
+    };
+
+    NodeModels _models;
+    std::map<QString, Entry> _entries;
+};
+
+#endif // MODEL_DATABASE_H
@@ -1,14 +1,21 @@
 #include "BehaviorTreeNodeModel.hpp"
+#include "IconCache.hpp"
 #include <QBoxLayout>
 #include <QFormLayout>
 #include <QSizePolicy>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
 #include <QLineEdit>
-#include <QComboBox>
 #include <QDebug>
 #include <QFile>
 #include <QFont>
 #include <QApplication>
 #include <QJsonDocument>
+#include <QDataStream>
+#include <QGraphicsProxyWidget>
+#include <nodes/FlowScene>
 
 const int MARGIN = 10;
 const int DEFAULT_LINE_WIDTH  = 100;
@@ -18,15 +25,16 @@ const int DEFAULT_LABEL_WIDTH = 50;
 BehaviorTreeDataModel::BehaviorTreeDataModel(const NodeModel &model):
     _params_widget(nullptr),
     _uid( GetUID() ),
-    _model(model),
-    _icon_renderer(nullptr),
-    _style_caption_color( QtNodes::NodeStyle().FontColor ),
-    _style_caption_alias( model.registration_ID )
+    _model(model)
 {
-    readStyle();
+    _prototype = prototype( model );
+    _style_icon = _prototype->icon;
+    _style_caption_color = _prototype->caption_color;
+    _style_caption_alias = _prototype->caption_alias;
+
     _main_widget = new QFrame();
     _line_edit_name = new QLineEdit(_main_widget);
-    _params_widget = new QFrame();
+    _params_widget = new PortFieldsWidget();
 
     _main_layout = new QVBoxLayout(_main_widget);
     _main_widget->setLayout( _main_layout );
@@ -68,103 +76,28 @@ BehaviorTreeDataModel::BehaviorTreeDataModel(const NodeModel &model):
                                    "border: 0px;");
 
     //--------------------------------------
-    _form_layout = new QFormLayout( _params_widget );
-    _form_layout->setFieldGrowthPolicy(QFormLayout::ExpandingFieldsGrow);
-
     _main_layout->addWidget(_params_widget);
-    _params_widget->setStyleSheet("color: white;");
 
-    _form_layout->setHorizontalSpacing(4);
-    _form_layout->setVerticalSpacing(2);
-    _form_layout->setContentsMargins(0, 0, 0, 0);
+    _collapsed_label = new QLabel(_main_widget);
+    _collapsed_label->setAlignment( Qt::AlignCenter );
+    _collapsed_label->setHidden( true );
+    _main_layout->addWidget(_collapsed_label);
 
-    PortDirection preferred_port_types[3] = { PortDirection::INPUT,
-                                              PortDirection::OUTPUT,
-                                              PortDirection::INOUT};
+    _params_widget->setFields( _prototype->fields, _prototype->labels_width );
+    _prototype->labels_width = _params_widget->labelsWidth();
 
-    for(int pref_index=0; pref_index < 3; pref_index++)
+    connect( _params_widget, &PortFieldsWidget::fieldEdited,
+             this, [this](QString port_name, QString value)
     {
-        for(const auto& port_it: model.ports )
-        {
-            auto preferred_direction = preferred_port_types[pref_index];
-            if( port_it.second.direction != preferred_direction )
-            {
-                continue;
-            }
-
-            QString description = port_it.second.description;
-            QString label = port_it.first;
-            if( preferred_direction == PortDirection::INPUT)
-            {
-                label.prepend("[IN] ");
-                if( description.isEmpty())
-                {
-                    description="[INPUT]";
-                }
-                else{
-                    description.prepend("[INPUT]: ");
-                }
-            }
-            else if( preferred_direction == PortDirection::OUTPUT){
-                label.prepend("[OUT] ");
-                if( description.isEmpty())
-                {
-                    description="[OUTPUT]";
-                }
-                else{
-                    description.prepend("[OUTPUT]: ");
-                }
-            }
-
-            GrootLineEdit* form_field = new GrootLineEdit();
-            form_field->setAlignment( Qt::AlignHCenter);
-            form_field->setMaximumWidth(140);
-            form_field->setText( port_it.second.default_value );
-
-            connect(form_field, &GrootLineEdit::doubleClicked,
-                    this, [this,form_field]()
-                    { emit this->portValueDoubleChicked(form_field); });
-
-            connect(form_field, &GrootLineEdit::lostFocus,
-                    this, [this]()
-                    { emit this->portValueDoubleChicked(nullptr); });
-
-            QLabel* form_label  =  new QLabel( label, _params_widget );
-            form_label->setStyleSheet("QToolTip {color: black;}");
-            form_label->setToolTip( description );
-
-            form_field->setMinimumWidth(DEFAULT_FIELD_WIDTH);
-
-            _ports_widgets.insert( std::make_pair( port_it.first, form_field) );
-
-            form_field->setStyleSheet("color: rgb(30,30,30); "
-                                      "background-color: rgb(200,200,200); "
-                                      "border: 0px; ");
-
-            _form_layout->addRow( form_label, form_field );
+        updateNodeSize();
+        emit parameterUpdated(port_name, value);
+    });
 
-            auto paramUpdated = [this,label,form_field]()
-            {
-                this->parameterUpdated(label,form_field);
-            };
-
-            if(auto lineedit = dynamic_cast<QLineEdit*>( form_field ) )
-            {
-                connect( lineedit, &QLineEdit::editingFinished, this, paramUpdated );
-                connect( lineedit, &QLineEdit::editingFinished,
-                         this, &BehaviorTreeDataModel::updateNodeSize);
-            }
-            else if( auto combo = dynamic_cast<QComboBox*>( form_field ) )
-            {
-                connect( combo, &QComboBox::currentTextChanged, this, paramUpdated);
-            }
-        }
-    }
-    _params_widget->adjustSize();
+    connect( _params_widget, &PortFieldsWidget::valueDoubleClicked,
+             this, &BehaviorTreeDataModel::portValueDoubleChicked );
 
     capt_layout->setSizeConstraint(QLayout::SizeConstraint::SetMaximumSize);
     _main_layout->setSizeConstraint(QLayout::SizeConstraint::SetMaximumSize);
-    _form_layout->setSizeConstraint(QLayout::SizeConstraint::SetMaximumSize);
     //--------------------------------------
     connect( _line_edit_name, &QLineEdit::editingFinished,
              this, [this]()
@@ -189,19 +122,6 @@ void BehaviorTreeDataModel::initWidget()
     {
         _caption_logo_left->setFixedWidth( 20 );
         _caption_logo_right->setFixedWidth( 1 );
-
-        QFile file(_style_icon);
-        if(!file.open(QIODevice::ReadOnly))
-        {
-            qDebug()<<"file not opened: "<< _style_icon;
-            file.close();
-        }
-        else {
-            QByteArray ba = file.readAll();
-            QByteArray new_color_fill = QString("fill:%1;").arg( _style_caption_color.name() ).toUtf8();
-            ba.replace("fill:#ffffff;", new_color_fill);
-            _icon_renderer =  new QSvgRenderer(ba, this);
-        }
     }
 
     _caption_label->setText( _style_caption_alias );
@@ -213,7 +133,14 @@ void BehaviorTreeDataModel::initWidget()
 
     _caption_logo_left->adjustSize();
     _caption_logo_right->adjustSize();
-    _caption_label->adjustSize();
+    if( _prototype->caption_size.isValid() )
+    {
+        _caption_label->resize( _prototype->caption_size );
+    }
+    else{
+        _caption_label->adjustSize();
+        _prototype->caption_size = _caption_label->size();
+    }
 
     updateNodeSize();
 }
@@ -222,7 +149,7 @@ unsigned int BehaviorTreeDataModel::nPorts(QtNodes::PortType portType) const
 {
     if( portType == QtNodes::PortType::Out)
     {
-        if( nodeType() == NodeType::ACTION || nodeType() == NodeType::CONDITION )
+        if( nodeType() == NodeType::ACTION || nodeType() == NodeType::CONDITION || collapsed() )
         {
             return 0;
         }
@@ -257,40 +184,10 @@ void BehaviorTreeDataModel::updateNodeSize()
     }
 
     //----------------------------
-    int field_colum_width = DEFAULT_LABEL_WIDTH;
-    int label_colum_width = 0;
-
-    for(int row = 0; row< _form_layout->rowCount(); row++)
-    {
-        auto label_widget = _form_layout->itemAt(row, QFormLayout::LabelRole)->widget();
-        auto field_widget = _form_layout->itemAt(row, QFormLayout::FieldRole)->widget();
-        if(auto field_line_edit = dynamic_cast<QLineEdit*>(field_widget))
-        {
-            QFontMetrics fontMetrics = field_line_edit->fontMetrics();
-            QString text = field_line_edit->text();
-            int text_width = fontMetrics.boundingRect(text).width();
-            field_colum_width = std::max( field_colum_width, text_width + MARGIN);
-        }
-        label_colum_width = std::max(label_colum_width, label_widget->width());
-    }
-
-    field_colum_width = std::max( field_colum_width,
-                                  line_edit_width - label_colum_width - _form_layout->spacing());
-
-    for(int row = 0; row< _form_layout->rowCount(); row++)
-    {
-        auto field_widget = _form_layout->itemAt(row, QFormLayout::FieldRole)->widget();
-        if(auto field_line_edit = dynamic_cast<QLineEdit*>(field_widget))
-        {
-            field_line_edit->setFixedWidth( field_colum_width );
-        }
-    }
-    line_edit_width = std::max( line_edit_width, label_colum_width + field_colum_width );
+    int fields_width = _params_widget->layoutFields( line_edit_width );
+    line_edit_width = std::max( line_edit_width, fields_width );
     _line_edit_name->setFixedWidth( line_edit_width);
 
-    _params_widget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Preferred);
-    _params_widget->adjustSize();
-
     _main_widget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Preferred);
     _main_widget->adjustSize();
 
@@ -309,57 +206,156 @@ std::shared_ptr<QtNodes::NodeData> BehaviorTreeDataModel::outData(QtNodes::PortI
     return nullptr;
 }
 
-void BehaviorTreeDataModel::readStyle()
+// NodesStyle.json, read once
+static const QJsonObject& NodesStyle()
 {
-    QFile style_file(":/NodesStyle.json");
-
-    if (!style_file.open(QIODevice::ReadOnly))
+    static const QJsonObject style = []() -> QJsonObject
     {
-        qWarning("Couldn't open NodesStyle.json");
-        return;
-    }
+        QFile style_file(":/NodesStyle.json");
 
-    QByteArray bytearray =  style_file.readAll();
-    style_file.close();
-    QJsonParseError error;
-    QJsonDocument json_doc( QJsonDocument::fromJson( bytearray, &error ));
+        if (!style_file.open(QIODevice::ReadOnly))
+        {
+            qWarning("Couldn't open NodesStyle.json");
+            return QJsonObject();
+        }
 
-    if(json_doc.isNull()){
-        qDebug()<<"Failed to create JSON doc: " << error.errorString();
-        return;
+        QByteArray bytearray =  style_file.readAll();
+        style_file.close();
+        QJsonParseError error;
+        QJsonDocument json_doc( QJsonDocument::fromJson( bytearray, &error ));
+
+        if(json_doc.isNull()){
+            qDebug()<<"Failed to create JSON doc: " << error.errorString();
+            return QJsonObject();
+        }
+        if(!json_doc.isObject()){
+            qDebug()<<"JSON is not an object.";
+            return QJsonObject();
+        }
+        if(json_doc.object().isEmpty()){
+            qDebug()<<"JSON object is empty.";
+        }
+        return json_doc.object();
+    }();
+    return style;
+}
+
+struct BehaviorTreeDataModel::Prototype
+{
+    NodeModel model;
+    QString icon;
+    QColor caption_color;
+    QString caption_alias;
+    std::vector<PortFieldsWidget::Field> fields;
+    // measured by the first instance, negative before
+    int labels_width;
+    QSize caption_size;
+};
+
+// NodeModel::operator== ignores what is only shown
+static bool SameAppearance(const NodeModel& a, const NodeModel& b)
+{
+    if( a != b )
+    {
+        return false;
     }
-    if(!json_doc.isObject()){
-        qDebug()<<"JSON is not an object.";
-        return;
+    auto b_it = b.ports.begin();
+    for (const auto& a_it: a.ports)
+    {
+        if( a_it.second.description   != b_it->second.description ||
+            a_it.second.default_value != b_it->second.default_value )
+        {
+            return false;
+        }
+        b_it++;
     }
+    return true;
+}
 
-    QJsonObject toplevel_object = json_doc.object();
+std::shared_ptr<BehaviorTreeDataModel::Prototype> BehaviorTreeDataModel::prototype(const NodeModel &model)
+{
+    // GUI thread only, as the widgets
+    static std::map<QString, std::shared_ptr<Prototype>> prototypes;
 
-    if(toplevel_object.isEmpty()){
-        qDebug()<<"JSON object is empty.";
-        return;
+    auto& proto = prototypes[ model.registration_ID ];
+    if( proto && SameAppearance( proto->model, model ) )
+    {
+        return proto;
     }
-    QString model_type_name( QString::fromStdString(toStr(_model.type)) );
-
-    for (const auto& model_name: { model_type_name, _model.registration_ID} )
+    // a new model, or a model edited: the instances already created keep
+    // the previous one
+    proto = std::make_shared<Prototype>();
+    proto->model = model;
+    proto->caption_color = QtNodes::NodeStyle().FontColor;
+    proto->caption_alias = model.registration_ID;
+    proto->labels_width = -1;
+
+    const QJsonObject& toplevel_object = NodesStyle();
+    QString model_type_name( QString::fromStdString(toStr(model.type)) );
+
+    for (const auto& model_name: { model_type_name, model.registration_ID} )
     {
         if( toplevel_object.contains(model_name) )
         {
             auto category_style = toplevel_object[ model_name ].toObject() ;
             if( category_style.contains("icon"))
             {
-                _style_icon = category_style["icon"].toString();
+                proto->icon = category_style["icon"].toString();
             }
             if( category_style.contains("caption_color"))
             {
-                _style_caption_color = category_style["caption_color"].toString();
+                proto->caption_color = category_style["caption_color"].toString();
             }
             if( category_style.contains("caption_alias"))
             {
-                _style_caption_alias = category_style["caption_alias"].toString();
+                proto->caption_alias = category_style["caption_alias"].toString();
             }
         }
     }
+
+    PortDirection preferred_port_types[3] = { PortDirection::INPUT,
+                                              PortDirection::OUTPUT,
+                                              PortDirection::INOUT};
+
+    for(int pref_index=0; pref_index < 3; pref_index++)
+    {
+        for(const auto& port_it: model.ports )
+        {
+            auto preferred_direction = preferred_port_types[pref_index];
+            if( port_it.second.direction != preferred_direction )
+            {
+                continue;
+            }
+
+            QString description = port_it.second.description;
+            QString label = port_it.first;
+            if( preferred_direction == PortDirection::INPUT)
+            {
+                label.prepend("[IN] ");
+                if( description.isEmpty())
+                {
+                    description="[INPUT]";
+                }
+                else{
+                    description.prepend("[INPUT]: ");
+                }
+            }
+            else if( preferred_direction == PortDirection::OUTPUT){
+                label.prepend("[OUT] ");
+                if( description.isEmpty())
+                {
+                    description="[OUTPUT]";
+                }
+                else{
+                    description.prepend("[OUTPUT]: ");
+                }
+            }
+
+            proto->fields.push_back( { port_it.first, label, description,
+                                       port_it.second.default_value } );
+        }
+    }
+    return proto;
 }
 
 const QString& BehaviorTreeDataModel::registrationName() const
@@ -374,23 +370,7 @@ const QString &BehaviorTreeDataModel::instanceName() const
 
 PortsMapping BehaviorTreeDataModel::getCurrentPortMapping() const
 {
-    PortsMapping out;
-
-    for(const auto& it: _ports_widgets)
-    {
-        const auto& label = it.first;
-        const auto& value = it.second;
-
-        if(auto linedit = dynamic_cast<QLineEdit*>( value ) )
-        {
-            out.insert( std::make_pair( label, linedit->text() ) );
-        }
-        else if( auto combo = dynamic_cast<QComboBox*>( value ) )
-        {
-            out.insert( std::make_pair( label, combo->currentText() ) );
-        }
-    }
-    return out;
+    return _params_widget->values();
 }
 
 QJsonObject BehaviorTreeDataModel::save() const
@@ -399,14 +379,18 @@ QJsonObject BehaviorTreeDataModel::save() const
     modelJson["name"]  = registrationName();
     modelJson["alias"] = instanceName();
 
-    for (const auto& it: _ports_widgets)
+    for (const auto& it: _params_widget->values())
     {
-        if( auto linedit = dynamic_cast<QLineEdit*>(it.second)){
-            modelJson[it.first] = linedit->text();
-        }
-        else if( auto combo = dynamic_cast<QComboBox*>(it.second)){
-            modelJson[it.first] = combo->currentText();
-        }
+        modelJson[it.first] = it.second;
+    }
+
+    if( collapsed() )
+    {
+        QByteArray data;
+        QDataStream stream( &data, QIODevice::WriteOnly );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        WriteCompactTreeToStream( stream, _collapsed_branch );
+        modelJson["collapsed_branch"] = QString::fromLatin1( data.toBase64() );
     }
 
     return modelJson;
@@ -423,52 +407,35 @@ void BehaviorTreeDataModel::restore(const QJsonObject &modelJson)
 
     for(auto it = modelJson.begin(); it != modelJson.end(); it++ )
     {
-        if( it.key() != "alias" && it.key() != "name")
+        if( it.key() != "alias" && it.key() != "name" && it.key() != "collapsed_branch")
         {
             setPortMapping( it.key(), it.value().toString() );
         }
     }
 
+    CompactTree branch;
+    if( modelJson.contains("collapsed_branch") )
+    {
+        QByteArray data = QByteArray::fromBase64( modelJson["collapsed_branch"].toString().toLatin1() );
+        QDataStream stream( data );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        branch = ReadCompactTreeFromStream( stream );
+    }
+    setCollapsedBranch( branch );
+
 }
 
 void BehaviorTreeDataModel::lock(bool locked)
 {
     _line_edit_name->setEnabled( !locked );
-
-    for(const auto& it: _ports_widgets)
-    {
-        const auto& field_widget = it.second;
-
-        if(auto lineedit = dynamic_cast<QLineEdit*>( field_widget  ))
-        {
-            lineedit->setReadOnly( locked );
-        }
-        else if(auto combo = dynamic_cast<QComboBox*>( field_widget ))
-        {
-            combo->setEnabled( !locked );
-        }
-    }
+    _params_widget->setLocked( locked );
 }
 
 void BehaviorTreeDataModel::setPortMapping(const QString &port_name, const QString &value)
 {
-    auto it = _ports_widgets.find(port_name);
-    if( it != _ports_widgets.end() )
+    if( _params_widget->hasField(port_name) )
     {
-        if( auto lineedit = dynamic_cast<QLineEdit*>(it->second) )
-        {
-            lineedit->setText(value);
-        }
-        else if( auto combo = dynamic_cast<QComboBox*>(it->second) )
-        {
-            int index = combo->findText(value);
-            if( index == -1 ){
-                qDebug() << "error, combo value "<< value << " not found";
-            }
-            else{
-                combo->setCurrentIndex(index);
-            }
-        }
+        _params_widget->setValue(port_name, value);
     }
     else{
         qDebug() << "error, label "<< port_name << " not found in the model";
@@ -477,10 +444,16 @@ void BehaviorTreeDataModel::setPortMapping(const QString &port_name, const QStri
 
 bool BehaviorTreeDataModel::eventFilter(QObject *obj, QEvent *event)
 {
-    if (event->type() == QEvent::Paint && obj == _caption_logo_left && _icon_renderer)
+    if (event->type() == QEvent::Paint && obj == _caption_logo_left && !_style_icon.isEmpty())
     {
-        QPainter paint(_caption_logo_left);
-        _icon_renderer->render(&paint);
+        QPixmap icon = IconCache::pixmap( _style_icon, _style_caption_color,
+                                          _caption_logo_left->size(),
+                                          _caption_logo_left->devicePixelRatio() );
+        if( !icon.isNull() )
+        {
+            QPainter paint(_caption_logo_left);
+            paint.drawPixmap(0, 0, icon);
+        }
     }
     return NodeDataModel::eventFilter(obj, event);
 }
@@ -496,26 +469,39 @@ void BehaviorTreeDataModel::setInstanceName(const QString &name)
 }
 
 
-void BehaviorTreeDataModel::onHighlightPortValue(QString value)
+void BehaviorTreeDataModel::setCollapsedBranch(const CompactTree& branch)
 {
-    for( const auto& it:  _ports_widgets)
+    if( branch == _collapsed_branch )
     {
-        if( auto line_edit = dynamic_cast<QLineEdit*>(it.second) )
-        {
-            QString line_str = line_edit->text();
-            if( !value.isEmpty() && line_str == value )
-            {
-                line_edit->setStyleSheet("color: rgb(30,30,30); "
-                                         "background-color: #ffef0b; "
-                                         "border: 0px; ");
-            }
-            else{
-                line_edit->setStyleSheet("color: rgb(30,30,30); "
-                                         "background-color: rgb(200,200,200); "
-                                         "border: 0px; ");
-            }
-        }
+        return;
+    }
+    _collapsed_branch = branch;
+    if( collapsed() )
+    {
+        _collapsed_label->setText( tr("+ %1 nodes").arg( _collapsed_branch.nodesCount() - 1 ) );
     }
+    _collapsed_label->setHidden( !collapsed() );
+    setCollapsedStatus( NodeStatus::IDLE );
+    updateNodeSize();
+}
+
+void BehaviorTreeDataModel::setCollapsedStatus(NodeStatus status)
+{
+    const char* color = "rgb(90,90,90)";
+    switch( status )
+    {
+    case NodeStatus::RUNNING: color = "rgb(220,140,20)"; break;
+    case NodeStatus::SUCCESS: color = "rgb(51,200,51)"; break;
+    case NodeStatus::FAILURE: color = "rgb(250,50,50)"; break;
+    default: break;
+    }
+    _collapsed_label->setStyleSheet( QString("color: white; background-color: %1; "
+                                             "border-radius: 3px; padding: 1px;").arg(color) );
+}
+
+void BehaviorTreeDataModel::onHighlightPortValue(QString value)
+{
+    _params_widget->setHighlight( value );
 }
 
 void GrootLineEdit::mouseDoubleClickEvent(QMouseEvent *ev)
@@ -529,3 +515,305 @@ void GrootLineEdit::focusOutEvent(QFocusEvent *ev)
     QLineEdit::focusOutEvent(ev);
     emit lostFocus();
 }
+
+//------------------------------------------------------------------
+
+const int FIELD_SPACING = 4;
+const int ROW_SPACING = 2;
+const QColor FIELD_COLOR( 200, 200, 200 );
+const QColor FIELD_HIGHLIGHT_COLOR( "#ffef0b" );
+const QColor FIELD_TEXT_COLOR( 30, 30, 30 );
+const char FIELD_STYLE[] = "color: rgb(30,30,30); "
+                          "background-color: rgb(200,200,200); "
+                          "border: 0px; ";
+
+PortFieldsWidget::PortFieldsWidget(QWidget *parent):
+    QWidget(parent),
+    _label_width(0),
+    _field_width(DEFAULT_FIELD_WIDTH),
+    _locked(false),
+    _editor(nullptr),
+    _edited_row(-1)
+{
+    setAttribute(Qt::WA_NoSystemBackground);
+    // the values can be selected and highlighted in a read-only scene
+    setProperty("readOnlyInteractive", true);
+}
+
+void PortFieldsWidget::addField(const QString &port_name, const QString &label,
+                                const QString &description, const QString &value)
+{
+    _fields.push_back( { port_name, label, description, value } );
+    _label_width = std::max( _label_width, fontMetrics().boundingRect( label ).width() );
+    layoutFields( 0 );
+}
+
+void PortFieldsWidget::setFields(const std::vector<Field> &fields, int labels_width)
+{
+    _fields = fields;
+    _label_width = labels_width;
+    if( _label_width < 0 )
+    {
+        QFontMetrics fm = fontMetrics();
+        _label_width = 0;
+        for (const auto& field: _fields)
+        {
+            _label_width = std::max( _label_width, fm.boundingRect( field.label ).width() );
+        }
+    }
+    layoutFields( 0 );
+}
+
+bool PortFieldsWidget::hasField(const QString &port_name) const
+{
+    for (const auto& field: _fields)
+    {
+        if( field.port_name == port_name ) return true;
+    }
+    return false;
+}
+
+QString PortFieldsWidget::value(const QString &port_name) const
+{
+    for (const auto& field: _fields)
+    {
+        if( field.port_name == port_name ) return field.value;
+    }
+    return QString();
+}
+
+void PortFieldsWidget::setValue(const QString &port_name, const QString &value)
+{
+    for (size_t row = 0; row < _fields.size(); row++)
+    {
+        auto& field = _fields[row];
+        if( field.port_name == port_name )
+        {
+            field.value = value;
+            if( _editor && _edited_row == int(row) )
+            {
+                _editor->setText( value );
+            }
+            update();
+            return;
+        }
+    }
+}
+
+PortsMapping PortFieldsWidget::values() const
+{
+    PortsMapping out;
+    for (const auto& field: _fields)
+    {
+        out.insert( std::make_pair( field.port_name, field.value ) );
+    }
+    return out;
+}
+
+void PortFieldsWidget::setLocked(bool locked)
+{
+    _locked = locked;
+    if( _editor )
+    {
+        _editor->setReadOnly( locked );
+    }
+}
+
+void PortFieldsWidget::setHighlight(const QString &value)
+{
+    if( value != _highlight )
+    {
+        _highlight = value;
+        update();
+    }
+}
+
+int PortFieldsWidget::rowHeight() const
+{
+    return fontMetrics().height() + 4;
+}
+
+int PortFieldsWidget::layoutFields(int min_width)
+{
+    // the width of the labels is measured when they are set
+    QFontMetrics fm = fontMetrics();
+    _field_width = DEFAULT_LABEL_WIDTH;
+
+    for (const auto& field: _fields)
+    {
+        _field_width = std::max( _field_width, fm.boundingRect( field.value ).width() + MARGIN );
+    }
+    _field_width = std::max( _field_width, min_width - _label_width - FIELD_SPACING );
+
+    if( _editor )
+    {
+        _editor->setGeometry( valueRect(_edited_row) );
+    }
+    const QSize size = sizeHint();
+    setFixedSize( size );
+    update();
+    return size.width();
+}
+
+QSize PortFieldsWidget::sizeHint() const
+{
+    if( _fields.empty() )
+    {
+        return QSize(0,0);
+    }
+    const int rows = int(_fields.size());
+    return QSize( _label_width + FIELD_SPACING + _field_width,
+                  rows * rowHeight() + (rows-1) * ROW_SPACING );
+}
+
+QRect PortFieldsWidget::labelRect(int row) const
+{
+    return QRect( 0, row * (rowHeight() + ROW_SPACING), _label_width, rowHeight() );
+}
+
+QRect PortFieldsWidget::valueRect(int row) const
+{
+    return QRect( _label_width + FIELD_SPACING, row * (rowHeight() + ROW_SPACING),
+                  _field_width, rowHeight() );
+}
+
+int PortFieldsWidget::rowAt(const QPoint &pos) const
+{
+    for (int row = 0; row < int(_fields.size()); row++)
+    {
+        if( labelRect(row).contains(pos) || valueRect(row).contains(pos) )
+        {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void PortFieldsWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.setFont( font() );
+
+    for (int row = 0; row < int(_fields.size()); row++)
+    {
+        const auto& field = _fields[row];
+
+        painter.setPen( Qt::white );
+        painter.drawText( labelRect(row), Qt::AlignLeft | Qt::AlignVCenter, field.label );
+
+        if( _editor && _edited_row == row )
+        {
+            continue;
+        }
+        const QRect value_rect = valueRect(row);
+        const bool highlight = !_highlight.isEmpty() && field.value == _highlight;
+        painter.fillRect( value_rect, highlight ? FIELD_HIGHLIGHT_COLOR : FIELD_COLOR );
+        painter.setPen( FIELD_TEXT_COLOR );
+        painter.drawText( value_rect, Qt::AlignCenter, field.value );
+    }
+}
+
+void PortFieldsWidget::mousePressEvent(QMouseEvent *event)
+{
+    const int row = rowAt( event->pos() );
+    if( event->button() != Qt::LeftButton || row < 0 ||
+        !valueRect(row).contains( event->pos() ) )
+    {
+        // let the node be selected and moved
+        event->ignore();
+        return;
+    }
+    startEditing( row );
+    event->accept();
+}
+
+bool PortFieldsWidget::event(QEvent *event)
+{
+    if( event->type() == QEvent::ToolTip )
+    {
+        auto help_event = static_cast<QHelpEvent*>(event);
+        const int row = rowAt( help_event->pos() );
+        if( row >= 0 && labelRect(row).contains( help_event->pos() ) )
+        {
+            QToolTip::showText( help_event->globalPos(), _fields[row].description, this );
+        }
+        else{
+            QToolTip::hideText();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+bool PortFieldsWidget::sceneReadOnly() const
+{
+    auto proxy = window()->graphicsProxyWidget();
+    auto scene = proxy ? qobject_cast<QtNodes::FlowScene*>( proxy->scene() ) : nullptr;
+    return scene && scene->readOnly();
+}
+
+void PortFieldsWidget::startEditing(int row)
+{
+    if( _editor && _edited_row == row )
+    {
+        return;
+    }
+    finishEditing();
+
+    auto editor = new GrootLineEdit(this);
+    editor->setAlignment( Qt::AlignHCenter );
+    editor->setStyleSheet( FIELD_STYLE );
+    editor->setText( _fields[row].value );
+    editor->setReadOnly( _locked || sceneReadOnly() );
+    editor->setGeometry( valueRect(row) );
+    _editor = editor;
+    _edited_row = row;
+
+    connect( editor, &QLineEdit::editingFinished, this, [this, editor]()
+    {
+        if( _editor == editor )
+        {
+            commitEditing();
+        }
+    });
+
+    connect( editor, &GrootLineEdit::doubleClicked, this, [this, editor]()
+    {
+        emit valueDoubleClicked( editor->text() );
+    });
+
+    connect( editor, &GrootLineEdit::lostFocus, this, [this, editor]()
+    {
+        if( _editor == editor )
+        {
+            finishEditing();
+        }
+        emit valueDoubleClicked( QString() );
+    });
+
+    editor->show();
+    editor->setFocus( Qt::MouseFocusReason );
+    update();
+}
+
+void PortFieldsWidget::commitEditing()
+{
+    auto& field = _fields[_edited_row];
+    if( field.value != _editor->text() )
+    {
+        field.value = _editor->text();
+        emit fieldEdited( field.port_name, field.value );
+    }
+}
+
+void PortFieldsWidget::finishEditing()
+{
+    if( !_editor ) return;
+
+    commitEditing();
+    // it may be the sender of the signal being handled
+    _editor->deleteLater();
+    _editor = nullptr;
+    _edited_row = -1;
+    update();
+}
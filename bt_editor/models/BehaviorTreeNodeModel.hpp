@@ -12,8 +12,8 @@
 #include <vector>
 #include <map>
 #include <functional>
-#include <QSvgRenderer>
 #include "bt_editor/bt_editor_base.h"
+#include "bt_editor/compact_tree.h"
 #include "bt_editor/utils.h"
 
 using QtNodes::PortType;
@@ -22,6 +22,8 @@ using QtNodes::NodeData;
 using QtNodes::NodeDataType;
 using QtNodes::NodeDataModel;
 
+class PortFieldsWidget;
+
 class BehaviorTreeDataModel : public NodeDataModel
 {
     Q_OBJECT
@@ -75,6 +77,17 @@ public:
 
     int UID() const { return _uid; }
 
+    // The descendants of a collapsed node are not in the scene: they are kept
+    // here, as a tree whose root is this node. Empty if not collapsed.
+    const CompactTree& collapsedBranch() const { return _collapsed_branch; }
+
+    void setCollapsedBranch(const CompactTree& branch);
+
+    bool collapsed() const { return !_collapsed_branch.empty(); }
+
+    // aggregated status of the collapsed descendants (monitor and replay)
+    void setCollapsedStatus(NodeStatus status);
+
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 
@@ -87,37 +100,115 @@ public slots:
 protected:
 
     QFrame*  _main_widget;
-    QFrame*  _params_widget;
+    PortFieldsWidget* _params_widget;
 
     QLineEdit* _line_edit_name;
 
-    std::map<QString, QWidget*> _ports_widgets;
     int16_t _uid;
 
-    QFormLayout* _form_layout;
     QVBoxLayout* _main_layout;
     QLabel* _caption_label;
     QFrame* _caption_logo_left;
     QFrame* _caption_logo_right;
+    QLabel* _collapsed_label;
 
 private:
     const NodeModel _model;
     QString _instance_name;
-    QSvgRenderer* _icon_renderer;
 
-    void readStyle();
+    // The state that depends only on the model (style, fields, sizes of the
+    // labels), computed by the first instance and shared by the others
+    struct Prototype;
+    static std::shared_ptr<Prototype> prototype(const NodeModel& model);
+    std::shared_ptr<Prototype> _prototype;
+
     QString _style_icon;
     QColor  _style_caption_color;
     QString  _style_caption_alias;
 
+    CompactTree _collapsed_branch;
+
 signals:
 
-    void parameterUpdated(QString, QWidget*);
+    void parameterUpdated(QString port_name, QString value);
 
     void instanceNameChanged();
 
-    void portValueDoubleChicked(QLineEdit* value_port);
+    // empty value when the edit of the port is finished
+    void portValueDoubleChicked(QString value);
+
+};
+
+// The values of the ports, painted as a form of "label value" rows.
+// A line edit is created only while a value is edited.
+class PortFieldsWidget: public QWidget
+{
+    Q_OBJECT
+public:
+    PortFieldsWidget(QWidget* parent = nullptr);
+
+    struct Field
+    {
+        QString port_name;
+        QString label;
+        QString description;
+        QString value;
+    };
+
+    void addField(const QString& port_name, const QString& label,
+                  const QString& description, const QString& value);
+
+    // all the fields at once. labels_width is the one returned by
+    // labelsWidth() for the same labels, measured again if negative
+    void setFields(const std::vector<Field>& fields, int labels_width);
 
+    int labelsWidth() const { return _label_width; }
+
+    bool hasField(const QString& port_name) const;
+
+    QString value(const QString& port_name) const;
+
+    void setValue(const QString& port_name, const QString& value);
+
+    PortsMapping values() const;
+
+    void setLocked(bool locked);
+
+    void setHighlight(const QString& value);
+
+    // lays out the rows, at least min_width large. Returns the width.
+    int layoutFields(int min_width);
+
+    QSize sizeHint() const override;
+
+signals:
+    void fieldEdited(QString port_name, QString value);
+
+    void valueDoubleClicked(QString value);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    bool event(QEvent* event) override;
+
+private:
+    std::vector<Field> _fields;
+    int _label_width;
+    int _field_width;
+    bool _locked;
+    QString _highlight;
+    QLineEdit* _editor;
+    int _edited_row;
+
+    int rowHeight() const;
+    int rowAt(const QPoint& pos) const;
+    QRect labelRect(int row) const;
+    QRect valueRect(int row) const;
+    // the values can't be edited in a read-only scene, see FlowScene::setReadOnly()
+    bool sceneReadOnly() const;
+    void startEditing(int row);
+    void commitEditing();
+    void finishEditing();
 };
 
 
@@ -0,0 +1,74 @@
+#include "IconCache.hpp"
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <memory>
+
+namespace
+{
+// key: resource and color. nullptr if the resource can not be read
+QHash<QString, std::shared_ptr<QSvgRenderer>> renderers;
+
+// key: resource, color, size and pixel ratio
+QHash<QString, QPixmap> pixmaps;
+
+std::shared_ptr<QSvgRenderer> renderer(const QString& resource, const QColor& color)
+{
+    const QString key = resource + '|' + color.name();
+    auto it = renderers.find(key);
+    if( it != renderers.end() )
+    {
+        return it.value();
+    }
+
+    std::shared_ptr<QSvgRenderer> svg;
+    QFile file(resource);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qDebug()<<"file not opened: "<< resource;
+    }
+    else {
+        QByteArray ba = file.readAll();
+        QByteArray new_color_fill = QString("fill:%1;").arg( color.name() ).toUtf8();
+        ba.replace("fill:#ffffff;", new_color_fill);
+        svg = std::make_shared<QSvgRenderer>(ba);
+    }
+    renderers.insert(key, svg);
+    return svg;
+}
+}
+
+QPixmap IconCache::pixmap(const QString &resource, const QColor &color,
+                          const QSize &size, qreal device_pixel_ratio)
+{
+    const QString key = QString("%1|%2|%3x%4|%5")
+                            .arg(resource).arg(color.name())
+                            .arg(size.width()).arg(size.height())
+                            .arg(device_pixel_ratio);
+    auto it = pixmaps.find(key);
+    if( it != pixmaps.end() )
+    {
+        return it.value();
+    }
+
+    QPixmap icon;
+    auto svg = renderer(resource, color);
+    if( svg && !size.isEmpty() )
+    {
+        icon = QPixmap( size * device_pixel_ratio );
+        icon.setDevicePixelRatio( device_pixel_ratio );
+        icon.fill( Qt::transparent );
+        QPainter painter( &icon );
+        svg->render( &painter, QRectF( QPointF(0,0), QSizeF(size) ) );
+    }
+    pixmaps.insert(key, icon);
+    return icon;
+}
+
+void IconCache::clear()
+{
+    pixmaps.clear();
+    renderers.clear();
+}
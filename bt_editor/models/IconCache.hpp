@@ -0,0 +1,20 @@
+#ifndef ICON_CACHE_HPP
+#define ICON_CACHE_HPP
+
+#include <QColor>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+// Rendered SVG icons, shared by all the nodes of the process.
+// The white fill of the icon is replaced by "color". To be used in the GUI thread.
+namespace IconCache
+{
+    // null if the resource can not be read
+    QPixmap pixmap(const QString& resource, const QColor& color,
+                   const QSize& size, qreal device_pixel_ratio);
+
+    void clear();
+}
+
+#endif // ICON_CACHE_HPP
@@ -22,6 +22,8 @@ SubtreeNodeModel::SubtreeNodeModel(const NodeModel &model):
                 "QPushButton:disabled { color: #303030; background-color: #a0a0a0; }");
     _expand_button->setFlat(false);
     _expand_button->setFocusPolicy(Qt::NoFocus);
+    // a subtree can be expanded in the monitor and in the replay too
+    _expand_button->setProperty("readOnlyInteractive", true);
     _expand_button->adjustSize();
 
     connect( _expand_button, &QPushButton::clicked,
@@ -36,6 +38,10 @@ SubtreeNodeModel::SubtreeNodeModel(const NodeModel &model):
 void SubtreeNodeModel::setExpanded(bool expand)
 {
     _expanded = expand;
+    if( !_expanded )
+    {
+        _expanded_tree.reset();
+    }
     _expand_button->setText( _expanded ? "Collapse" : "Expand");
     _expand_button->adjustSize();
     _main_widget->adjustSize();
@@ -17,6 +17,12 @@ public:
 
     bool expanded() const { return _expanded; }
 
+    // tree of the SubTree tab that the expanded nodes were built from. While
+    // the tab returns the same one, they are up to date.
+    const std::shared_ptr<const AbsBehaviorTree>& expandedTree() const { return _expanded_tree; }
+
+    void setExpandedTree(std::shared_ptr<const AbsBehaviorTree> tree) { _expanded_tree = std::move(tree); }
+
     unsigned int  nPorts(PortType portType) const override
     {
         int out_port = _expanded ? 1 : 0;
@@ -41,6 +47,7 @@ signals:
 private:
     QPushButton* _expand_button;
     bool _expanded;
+    std::shared_ptr<const AbsBehaviorTree> _expanded_tree;
 
 };
 
@@ -0,0 +1,120 @@
+#include "monitor_metrics.h"
+#include <algorithm>
+
+MonitorMetrics::MonitorMetrics()
+{
+    reset();
+}
+
+void MonitorMetrics::reset()
+{
+    _values = Values();
+    clearWindow( -1 );
+}
+
+void MonitorMetrics::clearWindow(double now)
+{
+    _window_start = now;
+    _window_messages = 0;
+    _window_bytes = 0;
+    _window_transitions = 0;
+    _window_transport_count = 0;
+    _window_transport_sum = 0;
+    _window_transport_max = 0;
+    _window_paint_count = 0;
+    _window_paint_sum = 0;
+    _window_paint_max = 0;
+}
+
+void MonitorMetrics::addMessage(size_t bytes, size_t transitions, double transport_latency)
+{
+    _values.total_messages++;
+    _values.total_bytes += bytes;
+    _values.total_transitions += transitions;
+
+    _window_messages++;
+    _window_bytes += bytes;
+    _window_transitions += transitions;
+    if( transitions > 0 )
+    {
+        _window_transport_count++;
+        _window_transport_sum += transport_latency;
+        _window_transport_max = std::max( _window_transport_max, transport_latency );
+    }
+}
+
+void MonitorMetrics::addPaintLatency(double latency)
+{
+    _window_paint_count++;
+    _window_paint_sum += latency;
+    _window_paint_max = std::max( _window_paint_max, latency );
+}
+
+bool MonitorMetrics::update(double now)
+{
+    if( _window_start < 0 )
+    {
+        _window_start = now;
+        return false;
+    }
+    const double elapsed = now - _window_start;
+    if( elapsed < WINDOW_SECONDS )
+    {
+        return false;
+    }
+
+    _values.messages_per_second = _window_messages / elapsed;
+    _values.bytes_per_second = _window_bytes / elapsed;
+    _values.transitions_per_message = (_window_messages > 0) ?
+                double(_window_transitions) / _window_messages : 0.0;
+
+    if( _window_transport_count > 0 )
+    {
+        _values.transport_latency_ms     = 1000.0 * _window_transport_sum / _window_transport_count;
+        _values.transport_latency_max_ms = 1000.0 * _window_transport_max;
+    }
+    if( _window_paint_count > 0 )
+    {
+        _values.paint_latency_ms     = 1000.0 * _window_paint_sum / _window_paint_count;
+        _values.paint_latency_max_ms = 1000.0 * _window_paint_max;
+    }
+    clearWindow( now );
+    return true;
+}
+
+QJsonObject MonitorMetrics::toJson() const
+{
+    QJsonObject json;
+    json["backpressure"]             = _policy;
+    json["messages_per_second"]      = _values.messages_per_second;
+    json["bytes_per_second"]         = _values.bytes_per_second;
+    json["transitions_per_message"]  = _values.transitions_per_message;
+    json["transport_latency_ms"]     = _values.transport_latency_ms;
+    json["transport_latency_max_ms"] = _values.transport_latency_max_ms;
+    json["paint_latency_ms"]         = _values.paint_latency_ms;
+    json["paint_latency_max_ms"]     = _values.paint_latency_max_ms;
+    json["total_messages"]           = double(_values.total_messages);
+    json["total_bytes"]              = double(_values.total_bytes);
+    json["total_transitions"]        = double(_values.total_transitions);
+    json["skipped_messages"]         = double(_values.skipped_messages);
+    json["merged_messages"]          = double(_values.merged_messages);
+    json["dropped_messages"]         = double(_values.dropped_messages);
+    return json;
+}
+
+QString MonitorMetrics::toText() const
+{
+    return QString("%1 msg/s, %2 kB/s, %3 transitions/msg\n"
+                   "skipped: %4, merged: %5, dropped: %6 (%10)\n"
+                   "latency: transport %7 ms, decode to paint %8 ms (max %9)")
+            .arg( _values.messages_per_second, 0, 'f', 1 )
+            .arg( _values.bytes_per_second / 1024.0, 0, 'f', 1 )
+            .arg( _values.transitions_per_message, 0, 'f', 1 )
+            .arg( _values.skipped_messages )
+            .arg( _values.merged_messages )
+            .arg( _values.dropped_messages )
+            .arg( _values.transport_latency_ms, 0, 'f', 1 )
+            .arg( _values.paint_latency_ms, 0, 'f', 1 )
+            .arg( _values.paint_latency_max_ms, 0, 'f', 1 )
+            .arg( _policy );
+}
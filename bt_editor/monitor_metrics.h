@@ -0,0 +1,87 @@
+#ifndef MONITOR_METRICS_H
+#define MONITOR_METRICS_H
+
+#include <cstddef>
+#include <QJsonObject>
+#include <QString>
+
+// Health of the link of a monitor session. The rates and the latencies are
+// computed over windows of WINDOW_SECONDS, the counters since reset.
+//
+// Two latencies are measured:
+//  - transport: from the timestamp of the last transition of a message (robot
+//    clock) to its reception. Meaningful only if the clocks are synchronized.
+//  - decode to paint: from the decoding in the receiver thread to the update
+//    of the scene, i.e. the time spent in the queue and in Groot.
+class MonitorMetrics
+{
+public:
+    static constexpr double WINDOW_SECONDS = 1.0;
+
+    struct Values
+    {
+        double messages_per_second = 0;
+        double bytes_per_second = 0;
+        double transitions_per_message = 0;
+        double transport_latency_ms = 0;
+        double transport_latency_max_ms = 0;
+        double paint_latency_ms = 0;
+        double paint_latency_max_ms = 0;
+
+        size_t total_messages = 0;
+        size_t total_bytes = 0;
+        size_t total_transitions = 0;
+        // received while the tree was not available
+        size_t skipped_messages = 0;
+        // displayed together with a previous message, in the same frame
+        size_t merged_messages = 0;
+        // dropped before reaching Groot, because of the backpressure policy
+        size_t dropped_messages = 0;
+    };
+
+    MonitorMetrics();
+
+    void reset();
+
+    // name of the backpressure policy of the subscriber, reported with the values
+    void setPolicy(const QString& policy) { _policy = policy; }
+
+    const QString& policy() const { return _policy; }
+
+    // latencies in seconds
+    void addMessage(size_t bytes, size_t transitions, double transport_latency);
+    void addSkipped() { _values.skipped_messages++; }
+    void addMerged(size_t count) { _values.merged_messages += count; }
+    void addDropped(size_t count) { _values.dropped_messages += count; }
+    void addPaintLatency(double latency);
+
+    // Close the current window, if it is older than WINDOW_SECONDS.
+    // now is MonitorReceiver::steadyTime(). True if the values changed
+    bool update(double now);
+
+    const Values& values() const { return _values; }
+
+    QJsonObject toJson() const;
+
+    // for the panel, a few lines
+    QString toText() const;
+
+private:
+    Values _values;
+    QString _policy;
+
+    double _window_start;
+    size_t _window_messages;
+    size_t _window_bytes;
+    size_t _window_transitions;
+    size_t _window_transport_count;
+    double _window_transport_sum;
+    double _window_transport_max;
+    size_t _window_paint_count;
+    double _window_paint_sum;
+    double _window_paint_max;
+
+    void clearWindow(double now);
+};
+
+#endif // MONITOR_METRICS_H
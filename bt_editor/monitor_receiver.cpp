@@ -0,0 +1,585 @@
+#include "monitor_receiver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <QDebug>
+#include "utils.h"
+#include "trace_recorder.h"
+
+MonitorReceiver::MonitorReceiver(zmq::context_t &context):
+    _context(context),
+    _stop(false),
+    _invalid_messages(0),
+    _queue(QUEUE_CAPACITY)
+{
+}
+
+MonitorReceiver::~MonitorReceiver()
+{
+    stop();
+}
+
+const char *MonitorReceiver::toStr(Backpressure policy)
+{
+    switch( policy )
+    {
+    case Backpressure::LOSSLESS:    return "lossless";
+    case Backpressure::DROP_OLDEST: return "drop_oldest";
+    case Backpressure::CONFLATE:    return "conflate";
+    }
+    return "";
+}
+
+void MonitorReceiver::addSubscriber(int subscriber_id, const std::string &address,
+                                    Backpressure policy)
+{
+    // the socket is created here, to report connection errors to the caller.
+    // From now on it is used only by the thread.
+    std::unique_ptr<Subscriber> subscriber( new Subscriber );
+    subscriber->id = subscriber_id;
+    subscriber->policy = policy;
+    subscriber->queued = 0;
+
+    const std::string segment = SharedMemoryRing::segmentName( address );
+    if( !segment.empty() )
+    {
+        subscriber->ring.reset( new SharedMemoryRing );
+        const std::string error = subscriber->ring->open( segment );
+        if( !error.empty() )
+        {
+            throw std::runtime_error( "Can't open the shared memory " + segment + ": " + error );
+        }
+    }
+    else{
+        subscriber->socket.reset( new zmq::socket_t( _context, ZMQ_SUB ) );
+        subscriber->socket->setsockopt(ZMQ_SUBSCRIBE, "", 0);
+        if( policy == Backpressure::LOSSLESS )
+        {
+            // the limit is LOSSLESS_MEMORY_CAP, ZMQ must not drop silently before it
+            int high_water_mark = 0;
+            subscriber->socket->setsockopt(ZMQ_RCVHWM, &high_water_mark, sizeof(int) );
+        }
+        subscriber->socket->connect( address.c_str() );
+    }
+
+    pause();
+    eraseSubscriber( subscriber_id );
+    _subscribers.push_back( std::move(subscriber) );
+    resume();
+}
+
+void MonitorReceiver::removeSubscriber(int subscriber_id)
+{
+    pause();
+    eraseSubscriber( subscriber_id );
+    resume();
+}
+
+void MonitorReceiver::eraseSubscriber(int subscriber_id)
+{
+    for (auto it = _subscribers.begin(); it != _subscribers.end(); it++)
+    {
+        if( (*it)->id == subscriber_id )
+        {
+            _subscribers.erase( it );
+            break;
+        }
+    }
+}
+
+bool MonitorReceiver::pop(Batch &batch)
+{
+    if( !_queue.pop(batch) )
+    {
+        return false;
+    }
+    // the subscribers change only in this thread, while the receiver is stopped
+    for (const auto& subscriber: _subscribers)
+    {
+        if( subscriber->id == batch.subscriber_id )
+        {
+            // forward() counted the batch before pushing it
+            subscriber->queued--;
+            break;
+        }
+    }
+    return true;
+}
+
+void MonitorReceiver::pause()
+{
+    _stop = true;
+    if( _thread.joinable() )
+    {
+        _thread.join();
+    }
+}
+
+void MonitorReceiver::resume()
+{
+    if( !_subscribers.empty() && !_thread.joinable() )
+    {
+        _stop = false;
+        _thread = std::thread( &MonitorReceiver::loop, this );
+    }
+}
+
+void MonitorReceiver::stop()
+{
+    pause();
+    _subscribers.clear();
+
+    Batch batch;
+    while( _queue.pop(batch) ) {}
+}
+
+bool MonitorReceiver::decode(const char *buffer, size_t size, Batch &batch)
+{
+    TraceScope trace( "monitor", "decode" );
+    batch.nodes_status.clear();
+    batch.transitions.clear();
+    batch.bytes = size;
+    batch.compact = false;
+
+    if( size < 8 )
+    {
+        return false;
+    }
+    const size_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
+    if( header_size % 3 != 0 || 8 + header_size > size )
+    {
+        return false;
+    }
+    const size_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
+    if( 8 + header_size + 12 * num_transitions > size )
+    {
+        return false;
+    }
+
+    batch.nodes_status.reserve( header_size / 3 );
+    for(size_t offset = 4; offset < header_size +4; offset +=3 )
+    {
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
+        const NodeStatus status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
+        batch.nodes_status.push_back( {uid, status} );
+    }
+
+    batch.transitions.reserve( num_transitions );
+    for(size_t t=0; t < num_transitions; t++)
+    {
+        const size_t offset = 8 + header_size + 12*t;
+        Transition transition;
+        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
+        const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
+        transition.timestamp = t_sec + t_usec* 0.000001;
+        transition.uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
+        transition.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+10] ));
+        transition.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
+        batch.transitions.push_back( transition );
+    }
+    return true;
+}
+
+const char MonitorReceiver::COMPACT_REQUEST[] = "groot:compact_protocol=1";
+const char MonitorReceiver::COMPACT_MAGIC[] = "GCP1";
+
+namespace {
+
+// unsigned LEB128
+bool ReadVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7)
+    {
+        const uint8_t byte = *data++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if( (byte & 0x80) == 0 )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WriteVarint(std::string& output, uint64_t value)
+{
+    while( value >= 0x80 )
+    {
+        output.push_back( char( (value & 0x7f) | 0x80 ) );
+        value >>= 7;
+    }
+    output.push_back( char(value) );
+}
+
+int64_t Unzigzag(uint64_t value)
+{
+    return int64_t( value >> 1 ) ^ -int64_t( value & 1 );
+}
+
+uint64_t Zigzag(int64_t value)
+{
+    return ( uint64_t(value) << 1 ) ^ uint64_t( value >> 63 );
+}
+
+NodeStatus ReadStatus(uint8_t value)
+{
+    return convert( Serialization::NodeStatus( value ) );
+}
+
+typedef std::pair<uint16_t, NodeStatus> UidStatus;
+
+bool LessUid(const UidStatus& a, const UidStatus& b)
+{
+    return a.first < b.first;
+}
+
+void SetStatus(std::vector<UidStatus>& nodes_status, uint16_t uid, NodeStatus status)
+{
+    const UidStatus value( uid, status );
+    auto it = std::lower_bound( nodes_status.begin(), nodes_status.end(), value, LessUid );
+    if( it != nodes_status.end() && it->first == uid )
+    {
+        it->second = status;
+    }
+    else{
+        nodes_status.insert( it, value );
+    }
+}
+
+}
+
+bool MonitorReceiver::isCompact(const char *buffer, size_t size)
+{
+    return size >= 4 && std::memcmp( buffer, COMPACT_MAGIC, 4 ) == 0;
+}
+
+bool MonitorReceiver::decodeCompact(const char *buffer, size_t size,
+                                    CompactState &state, Batch &batch)
+{
+    TraceScope trace( "monitor", "decodeCompact" );
+    batch.nodes_status.clear();
+    batch.transitions.clear();
+    batch.bytes = size;
+    batch.compact = true;
+
+    if( size < 5 || !isCompact( buffer, size ) )
+    {
+        return false;
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>( buffer ) + 4;
+    const uint8_t* end = reinterpret_cast<const uint8_t*>( buffer ) + size;
+    const bool keyframe = ( *data++ & 1 ) != 0;
+
+    uint64_t sequence = 0;
+    uint64_t status_count = 0;
+    if( !ReadVarint( data, end, sequence ) || !ReadVarint( data, end, status_count ) ||
+        status_count > size_t(end - data) / 2 )
+    {
+        return false;
+    }
+    if( !keyframe && ( !state.synchronized || uint32_t(sequence) != uint32_t(state.sequence + 1) ) )
+    {
+        // a message was lost: wait for the next keyframe
+        state.synchronized = false;
+        return false;
+    }
+
+    std::vector<UidStatus> nodes_status;
+    if( !keyframe )
+    {
+        nodes_status.swap( state.nodes_status );
+    }
+    uint64_t uid = 0;
+    for (uint64_t i = 0; i < status_count; i++)
+    {
+        uint64_t uid_delta = 0;
+        if( !ReadVarint( data, end, uid_delta ) || data >= end )
+        {
+            state.synchronized = false;
+            return false;
+        }
+        uid += uid_delta;
+        const NodeStatus status = ReadStatus( *data++ );
+        if( keyframe )
+        {
+            // ascending uids
+            nodes_status.push_back( { uint16_t(uid), status } );
+        }
+        else{
+            SetStatus( nodes_status, uint16_t(uid), status );
+        }
+    }
+
+    uint64_t transitions_count = 0;
+    if( !ReadVarint( data, end, transitions_count ) || transitions_count > size_t(end - data) / 3 )
+    {
+        state.synchronized = false;
+        return false;
+    }
+    batch.transitions.reserve( transitions_count );
+    if( transitions_count > 0 )
+    {
+        uint64_t usec = 0;
+        if( !ReadVarint( data, end, usec ) )
+        {
+            state.synchronized = false;
+            return false;
+        }
+        int64_t transition_uid = 0;
+        for (uint64_t t = 0; t < transitions_count; t++)
+        {
+            uint64_t usec_delta = 0;
+            uint64_t uid_delta = 0;
+            if( !ReadVarint( data, end, usec_delta ) || !ReadVarint( data, end, uid_delta ) || data >= end )
+            {
+                state.synchronized = false;
+                return false;
+            }
+            usec += uint64_t( Unzigzag( usec_delta ) );
+            transition_uid += Unzigzag( uid_delta );
+            const uint8_t statuses = *data++;
+
+            Transition transition;
+            transition.timestamp = double(usec) * 0.000001;
+            transition.uid = uint16_t( transition_uid );
+            transition.prev_status = ReadStatus( statuses >> 4 );
+            transition.status = ReadStatus( statuses & 0x0f );
+            batch.transitions.push_back( transition );
+        }
+    }
+
+    // the header of the batch is the status before the transitions, the
+    // state the one after them
+    batch.nodes_status = nodes_status;
+    for (const auto& transition: batch.transitions)
+    {
+        SetStatus( nodes_status, transition.uid, transition.status );
+    }
+    state.nodes_status.swap( nodes_status );
+    state.sequence = uint32_t(sequence);
+    state.synchronized = true;
+    return true;
+}
+
+std::string MonitorReceiver::encodeCompact(uint32_t sequence, bool keyframe,
+                                           std::vector<std::pair<uint16_t, NodeStatus>> nodes_status,
+                                           const std::vector<Transition>& transitions)
+{
+    std::sort( nodes_status.begin(), nodes_status.end(), LessUid );
+
+    std::string output( COMPACT_MAGIC, 4 );
+    output.reserve( 16 + nodes_status.size() * 2 + transitions.size() * 4 );
+    output.push_back( char( keyframe ? 1 : 0 ) );
+    WriteVarint( output, sequence );
+
+    WriteVarint( output, nodes_status.size() );
+    uint16_t uid = 0;
+    for (const auto& it: nodes_status)
+    {
+        WriteVarint( output, uint16_t( it.first - uid ) );
+        uid = it.first;
+        output.push_back( char( uint8_t(it.second) ) );
+    }
+
+    WriteVarint( output, transitions.size() );
+    if( !transitions.empty() )
+    {
+        int64_t usec = int64_t( std::llround( transitions.front().timestamp * 1e6 ) );
+        WriteVarint( output, uint64_t(usec) );
+        int64_t transition_uid = 0;
+        for (const auto& transition: transitions)
+        {
+            const int64_t transition_usec = int64_t( std::llround( transition.timestamp * 1e6 ) );
+            WriteVarint( output, Zigzag( transition_usec - usec ) );
+            WriteVarint( output, Zigzag( int64_t(transition.uid) - transition_uid ) );
+            usec = transition_usec;
+            transition_uid = transition.uid;
+            output.push_back( char( ( uint8_t(transition.prev_status) << 4 ) | uint8_t(transition.status) ) );
+        }
+    }
+    return output;
+}
+
+double MonitorReceiver::steadyTime()
+{
+    using namespace std::chrono;
+    return duration<double>( steady_clock::now().time_since_epoch() ).count();
+}
+
+double MonitorReceiver::systemTime()
+{
+    using namespace std::chrono;
+    return duration<double>( system_clock::now().time_since_epoch() ).count();
+}
+
+void MonitorReceiver::enqueue(Subscriber &subscriber, Batch &&batch)
+{
+    switch( subscriber.policy )
+    {
+    case Backpressure::LOSSLESS:
+        if( subscriber.pending_bytes + batch.bytes > LOSSLESS_MEMORY_CAP )
+        {
+            subscriber.dropped++;
+            return;
+        }
+        break;
+    case Backpressure::DROP_OLDEST:
+        while( subscriber.pending.size() >= BOUNDED_QUEUE_SIZE )
+        {
+            subscriber.pending_bytes -= subscriber.pending.front().bytes;
+            subscriber.pending.pop_front();
+            subscriber.dropped++;
+        }
+        break;
+    case Backpressure::CONFLATE:
+        subscriber.dropped += subscriber.pending.size();
+        subscriber.pending.clear();
+        subscriber.pending_bytes = 0;
+        break;
+    }
+
+    subscriber.pending_bytes += batch.bytes;
+    subscriber.pending.push_back( std::move(batch) );
+    forward( subscriber );
+}
+
+bool MonitorReceiver::forward(Subscriber &subscriber)
+{
+    // batches that the GUI did not take yet
+    size_t max_queued = QUEUE_CAPACITY;
+    if( subscriber.policy == Backpressure::DROP_OLDEST )
+    {
+        max_queued = BOUNDED_QUEUE_SIZE;
+    }
+    else if( subscriber.policy == Backpressure::CONFLATE )
+    {
+        max_queued = 1;
+    }
+
+    while( !subscriber.pending.empty() && subscriber.queued < max_queued )
+    {
+        Batch& batch = subscriber.pending.front();
+        const size_t bytes = batch.bytes;
+        batch.dropped_before = subscriber.dropped;
+        // counted before the push: pop() may take the batch at once
+        subscriber.queued++;
+        if( !_queue.push( std::move(batch) ) )
+        {
+            subscriber.queued--;
+            break;
+        }
+        subscriber.dropped = 0;
+        subscriber.pending_bytes -= bytes;
+        subscriber.pending.pop_front();
+    }
+    return subscriber.pending.empty();
+}
+
+void MonitorReceiver::receive(Subscriber &subscriber, const char *data, size_t size, Batch &batch)
+{
+    TraceScope trace( "monitor", "receive" );
+    trace.setArgument( "bytes", size );
+    const double receive_time = systemTime();
+    const bool decoded = isCompact( data, size ) ?
+        decodeCompact( data, size, subscriber.compact, batch ) :
+        decode( data, size, batch );
+    if( !decoded )
+    {
+        _invalid_messages++;
+        return;
+    }
+    batch.subscriber_id = subscriber.id;
+    batch.receive_time = receive_time;
+    batch.decode_time = steadyTime();
+
+    // never blocks: the other subscribers are not delayed
+    enqueue( subscriber, std::move(batch) );
+    batch = Batch();
+}
+
+void MonitorReceiver::loop()
+{
+    // the sockets are polled, the rings are checked at each iteration
+    std::vector<zmq_pollitem_t> items;
+    std::vector<Subscriber*> polled;
+    std::vector<Subscriber*> rings;
+    for (const auto& subscriber: _subscribers)
+    {
+        if( subscriber->ring )
+        {
+            rings.push_back( subscriber.get() );
+        }
+        else{
+            items.push_back( { static_cast<void*>( *subscriber->socket ), 0, ZMQ_POLLIN, 0 } );
+            polled.push_back( subscriber.get() );
+        }
+    }
+
+    zmq::message_t msg;
+    std::vector<char> message;
+    Batch batch;
+
+    while( !_stop )
+    {
+        bool all_forwarded = true;
+        for (const auto& subscriber: _subscribers)
+        {
+            all_forwarded = forward( *subscriber ) && all_forwarded;
+        }
+
+        for (Subscriber* subscriber: rings)
+        {
+            size_t overruns = 0;
+            while( !_stop && subscriber->ring->read( message, overruns ) )
+            {
+                receive( *subscriber, message.data(), message.size(), batch );
+            }
+            // the overwritten messages are dropped as those of the policies
+            subscriber->dropped += overruns;
+        }
+
+        // short timeout, to check _stop periodically and to forward
+        // the pending batches as soon as the GUI takes the previous ones.
+        // A ring has no notification: it is checked every millisecond
+        const int timeout = ( all_forwarded && rings.empty() ) ? 100 : 1;
+        if( items.empty() )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( timeout ) );
+            continue;
+        }
+        if( zmq_poll( items.data(), int(items.size()), timeout ) <= 0 )
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < items.size() && !_stop; i++)
+        {
+            if( !(items[i].revents & ZMQ_POLLIN) )
+            {
+                continue;
+            }
+            Subscriber& subscriber = *polled[i];
+
+            // drain the socket: only the sockets with messages cost CPU
+            while( !_stop )
+            {
+                try{
+                    auto received = subscriber.socket->recv( msg, zmq::recv_flags::dontwait );
+                    if( !received )
+                    {
+                        break;
+                    }
+                }
+                catch( zmq::error_t& err)
+                {
+                    qDebug() << "ZMQ receive failed: " << err.what();
+                    break;
+                }
+                receive( subscriber, reinterpret_cast<const char*>( msg.data() ), msg.size(), batch );
+            }
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef MONITOR_RECEIVER_H
+#define MONITOR_RECEIVER_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+#include "bt_editor_base.h"
+#include "shared_memory_ring.h"
+#include "spsc_queue.h"
+
+// Receives the messages of the ZMQ publishers of BT::PublisherZMQ in a
+// dedicated thread and decodes them off the GUI thread. A single thread
+// polls all the subscribers (zmq_poll), one for each monitored robot. The decoded
+// messages are handed to the GUI through a lock-free queue.
+//
+// A publisher on the same host can be read from a SharedMemoryRing instead
+// of a socket: its address is "shm://<name>".
+//
+// When the GUI falls behind, the messages of each subscriber wait in its own
+// pending list, handled according to its Backpressure policy. The dropped
+// messages are never silent: they are counted in the next Batch.
+class MonitorReceiver
+{
+public:
+    struct Transition
+    {
+        uint16_t uid;
+        NodeStatus prev_status;
+        NodeStatus status;
+        double timestamp;
+    };
+
+    // the content of a single message
+    struct Batch
+    {
+        int subscriber_id = -1;
+        // status of all the nodes, before the transitions
+        std::vector<std::pair<uint16_t, NodeStatus>> nodes_status;
+        std::vector<Transition> transitions;
+        size_t bytes = 0;
+        // decoded with the compact protocol
+        bool compact = false;
+        // steadyTime() after decoding
+        double decode_time = 0;
+        // system clock, in the same unit of the timestamps of the transitions
+        double receive_time = 0;
+        // messages of the same subscriber dropped after the previous batch
+        size_t dropped_before = 0;
+    };
+
+    enum class Backpressure
+    {
+        // nothing is dropped until the pending messages reach LOSSLESS_MEMORY_CAP
+        LOSSLESS,
+        // at most BOUNDED_QUEUE_SIZE messages wait, the oldest are dropped
+        DROP_OLDEST,
+        // only the latest message waits. Its header has the status of all
+        // the nodes: the tree is synchronized again, without the transitions
+        // of the dropped messages
+        CONFLATE
+    };
+
+    static const char* toStr(Backpressure policy);
+
+    static const size_t QUEUE_CAPACITY = 4096;
+    static const size_t LOSSLESS_MEMORY_CAP = 64 * 1024 * 1024;
+    static const size_t BOUNDED_QUEUE_SIZE = 64;
+
+    explicit MonitorReceiver(zmq::context_t& context);
+
+    ~MonitorReceiver();
+
+    // Connect a subscriber to a publisher, replacing the previous one with
+    // the same id. Its messages have this subscriber_id: don't reuse the id
+    // of a subscriber whose batches may still be queued. Throws zmq::error_t,
+    // or std::runtime_error if the shared memory "shm://<name>" can't be opened
+    void addSubscriber(int subscriber_id, const std::string& address,
+                       Backpressure policy = Backpressure::LOSSLESS);
+
+    // the messages of this subscriber still in the queue are not removed
+    void removeSubscriber(int subscriber_id);
+
+    // remove all the subscribers and clear the queue
+    void stop();
+
+    bool isRunning() const { return _thread.joinable(); }
+
+    // GUI thread only
+    bool pop(Batch& batch);
+
+    size_t queueSize() const { return _queue.size(); }
+
+    // messages that could not be decoded
+    size_t invalidMessages() const { return _invalid_messages; }
+
+    // decode a message. False if it is truncated or invalid
+    static bool decode(const char* buffer, size_t size, Batch& batch);
+
+    // The compact protocol. Groot asks for it with COMPACT_REQUEST, sent to
+    // the server when the tree is downloaded, that BT::PublisherZMQ ignores.
+    // The messages of each publisher are decoded by their first bytes:
+    // COMPACT_MAGIC is never a header of the legacy format. Read as the size
+    // of that header, "GCP1" is 827343687 bytes, while a legacy header has at
+    // most 3 bytes per uid (uint16): 196608.
+    //
+    //   "GCP1"
+    //   uint8   flags                bit 0: keyframe
+    //   varint  sequence             previous + 1, modulo 2^32
+    //   varint  status count, then for each node, by ascending uid:
+    //       varint  uid - previous uid (the first from 0)
+    //       uint8   status
+    //   varint  transitions count, then if it is not 0:
+    //   varint  timestamp of the first transition, usec since epoch
+    //       and for each transition:
+    //       varint  zigzag( usec - previous usec )  (the first is 0)
+    //       varint  zigzag( uid - previous uid )    (the first from 0)
+    //       uint8   prev_status << 4 | status
+    //
+    // All the integers are unsigned LEB128 and the statuses the values of
+    // Serialization::NodeStatus. A keyframe has the status of all the nodes.
+    // A delta has only those that changed since the end of the previous
+    // message, after its transitions: usually none. The state is kept by
+    // the receiver, the batches always have the status of all the nodes.
+    // After a lost message the deltas are invalid until the next keyframe,
+    // that the server is expected to send periodically.
+    static const char COMPACT_REQUEST[];
+    static const char COMPACT_MAGIC[];
+
+    struct CompactState
+    {
+        // sorted by uid
+        std::vector<std::pair<uint16_t, NodeStatus>> nodes_status;
+        bool synchronized = false;
+        uint32_t sequence = 0;
+    };
+
+    static bool isCompact(const char* buffer, size_t size);
+
+    // False if it is invalid, or a delta that doesn't follow the state
+    static bool decodeCompact(const char* buffer, size_t size, CompactState& state, Batch& batch);
+
+    // a message of the compact protocol, as a server sends it. nodes_status
+    // are all the nodes in a keyframe, in any order
+    static std::string encodeCompact(uint32_t sequence, bool keyframe,
+                                     std::vector<std::pair<uint16_t, NodeStatus>> nodes_status,
+                                     const std::vector<Transition>& transitions);
+
+    // monotonic clock, in seconds
+    static double steadyTime();
+
+    // time since epoch, in seconds
+    static double systemTime();
+
+private:
+    struct Subscriber
+    {
+        int id;
+        // one of the two
+        std::unique_ptr<zmq::socket_t> socket;
+        std::unique_ptr<SharedMemoryRing> ring;
+        Backpressure policy;
+        // used only by the thread
+        CompactState compact;
+        std::deque<Batch> pending;
+        size_t pending_bytes = 0;
+        size_t dropped = 0;
+        // batches in _queue, decremented by pop()
+        std::atomic<size_t> queued;
+    };
+
+    void loop();
+
+    // decode a message of the subscriber and enqueue it
+    void receive(Subscriber& subscriber, const char* data, size_t size, Batch& batch);
+
+    // apply the policy of the subscriber, then try to forward
+    void enqueue(Subscriber& subscriber, Batch&& batch);
+    // move the pending batches to _queue. False if some are still pending
+    bool forward(Subscriber& subscriber);
+
+    // the subscribers can be changed only while the thread is stopped
+    void pause();
+    void resume();
+    void eraseSubscriber(int subscriber_id);
+
+    zmq::context_t& _context;
+    std::vector<std::unique_ptr<Subscriber>> _subscribers;
+    std::thread _thread;
+    std::atomic<bool> _stop;
+    std::atomic<size_t> _invalid_messages;
+    SpscQueue<Batch> _queue;
+};
+
+#endif // MONITOR_RECEIVER_H
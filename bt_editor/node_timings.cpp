@@ -0,0 +1,184 @@
+#include "node_timings.h"
+#include <QStringList>
+#include <algorithm>
+
+void NodeTimings::reset(size_t nodes_count)
+{
+    _nodes.assign( nodes_count, Node() );
+    _completions.assign( nodes_count * HISTORY, Completion{ 0, false } );
+    _changed.clear();
+    _active.clear();
+    _now = 0;
+}
+
+void NodeTimings::add(int node_index, NodeStatus prev_status, NodeStatus status, double timestamp)
+{
+    if( node_index < 0 || size_t(node_index) >= _nodes.size() )
+    {
+        return;
+    }
+    _now = timestamp;
+    Node& node = _nodes[node_index];
+
+    if( status == NodeStatus::RUNNING )
+    {
+        if( prev_status != NodeStatus::RUNNING )
+        {
+            node.running_start = timestamp;
+        }
+        return;
+    }
+
+    // halted (IDLE) or completed: the RUNNING period is over
+    bool changed = false;
+    if( prev_status == NodeStatus::RUNNING && node.running_start >= 0 )
+    {
+        node.running_ms = 1000.0 * ( timestamp - node.running_start );
+        node.running_start = -1;
+        changed = true;
+    }
+    if( status == NodeStatus::SUCCESS || status == NodeStatus::FAILURE )
+    {
+        // the oldest completion is overwritten once the ring is full
+        const int position = ( node.head + node.count ) % HISTORY;
+        _completions[ size_t(node_index) * HISTORY + position ] =
+                Completion{ timestamp, status == NodeStatus::FAILURE };
+        if( node.count < HISTORY )
+        {
+            node.count++;
+        }
+        else{
+            node.head = ( node.head + 1 ) % HISTORY;
+        }
+        if( !node.active )
+        {
+            node.active = true;
+            node.expiry = timestamp + WINDOW_SECONDS;
+            _active.push_back( node_index );
+        }
+        changed = true;
+    }
+    if( changed )
+    {
+        markChanged( node_index );
+    }
+}
+
+void NodeTimings::setTime(double now)
+{
+    _now = std::max( _now, now );
+}
+
+void NodeTimings::markChanged(int node_index)
+{
+    Node& node = _nodes[node_index];
+    if( !node.changed )
+    {
+        node.changed = true;
+        _changed.push_back( node_index );
+    }
+}
+
+std::vector<int> NodeTimings::takeChanged()
+{
+    // the badges of the nodes whose oldest completions left the window change too
+    const double window_start = _now - WINDOW_SECONDS;
+    for (size_t i = 0; i < _active.size(); )
+    {
+        const int index = _active[i];
+        Node& node = _nodes[index];
+        if( node.expiry >= _now )
+        {
+            i++;
+            continue;
+        }
+        markChanged( index );
+        node.active = false;
+        const Completion* ring = &_completions[ size_t(index) * HISTORY ];
+        for (int c = 0; c < node.count; c++)
+        {
+            const Completion& completion = ring[ ( node.head + c ) % HISTORY ];
+            if( completion.timestamp >= window_start )
+            {
+                node.active = true;
+                node.expiry = completion.timestamp + WINDOW_SECONDS;
+                break;
+            }
+        }
+        if( node.active )
+        {
+            i++;
+        }
+        else{
+            _active[i] = _active.back();
+            _active.pop_back();
+        }
+    }
+
+    std::vector<int> changed;
+    changed.swap( _changed );
+    for (int index: changed)
+    {
+        _nodes[index].changed = false;
+    }
+    return changed;
+}
+
+NodeTimings::Values NodeTimings::values(int node_index) const
+{
+    Values values;
+    if( node_index < 0 || size_t(node_index) >= _nodes.size() )
+    {
+        return values;
+    }
+    const Node& node = _nodes[node_index];
+    values.running_ms = node.running_ms;
+
+    const Completion* ring = &_completions[ size_t(node_index) * HISTORY ];
+    const double window_start = _now - WINDOW_SECONDS;
+    double first = 0;
+    double last = 0;
+    int failures = 0;
+    for (int i = 0; i < node.count; i++)
+    {
+        const Completion& completion = ring[ ( node.head + i ) % HISTORY ];
+        if( completion.timestamp < window_start )
+        {
+            continue;
+        }
+        if( values.completions == 0 )
+        {
+            first = completion.timestamp;
+        }
+        last = completion.timestamp;
+        values.completions++;
+        failures += completion.failed ? 1 : 0;
+    }
+    if( values.completions > 0 )
+    {
+        values.failure_rate = double(failures) / values.completions;
+    }
+    if( values.completions > 1 && last > first )
+    {
+        values.ticks_per_second = ( values.completions - 1 ) / ( last - first );
+    }
+    return values;
+}
+
+QString NodeTimings::toText(const Values &values)
+{
+    QStringList parts;
+    if( values.running_ms >= 0 )
+    {
+        parts.push_back( QString("%1 ms").arg( values.running_ms, 0, 'f', 1 ) );
+    }
+    if( values.ticks_per_second > 0 )
+    {
+        parts.push_back( QString("%1/s").arg( values.ticks_per_second, 0, 'f', 1 ) );
+    }
+    if( values.completions > 0 )
+    {
+        parts.push_back( QString("%1% fail").arg( qRound( 100.0 * values.failure_rate ) ) );
+    }
+    return parts.join( " | " );
+}
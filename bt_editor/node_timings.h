@@ -0,0 +1,89 @@
+#ifndef NODE_TIMINGS_H
+#define NODE_TIMINGS_H
+
+#include <vector>
+#include <QString>
+#include "bt_editor_base.h"
+
+// Rolling statistics of the nodes of a monitored tree, computed from the
+// timestamps of the transitions (robot clock):
+//  - the duration of the last RUNNING period of each node;
+//  - how often each node completes (a SUCCESS or a FAILURE), and how many of
+//    these completions are failures, over the last WINDOW_SECONDS.
+//
+// Each node keeps its last HISTORY completions in a fixed ring: adding a
+// transition never allocates.
+//
+// The window follows the current time: the time of the last transition, or
+// that of setTime() if the clock went on without transitions.
+class NodeTimings
+{
+public:
+    static constexpr double WINDOW_SECONDS = 5.0;
+    static const int HISTORY = 32;
+
+    struct Values
+    {
+        // -1 if the node was never RUNNING
+        double running_ms = -1;
+        // 0 with less than two completions in the window
+        double ticks_per_second = 0;
+        // 0 to 1
+        double failure_rate = 0;
+        // in the window
+        int completions = 0;
+    };
+
+    // forget everything: a different tree
+    void reset(size_t nodes_count);
+
+    // transitions must be added in chronological order
+    void add(int node_index, NodeStatus prev_status, NodeStatus status, double timestamp);
+
+    // the current time, if later than the last transition
+    void setTime(double now);
+
+    // the nodes with a new RUNNING duration or completion since the last
+    // call, and those whose oldest completions left the window since then
+    std::vector<int> takeChanged();
+
+    // at the current time
+    Values values(int node_index) const;
+
+    // for the badge of a node, e.g. "12.5 ms | 8.0/s | 25% fail". Empty if
+    // there is nothing to show
+    static QString toText(const Values& values);
+
+private:
+    struct Completion
+    {
+        double timestamp;
+        bool failed;
+    };
+
+    struct Node
+    {
+        double running_start = -1;
+        double running_ms = -1;
+        // of the ring in _completions
+        int head = 0;
+        int count = 0;
+        bool changed = false;
+        // with completions in the window, until expiry: the time when the
+        // oldest of them leaves it
+        bool active = false;
+        double expiry = 0;
+    };
+
+    void markChanged(int node_index);
+
+    std::vector<Node> _nodes;
+    // HISTORY entries per node
+    std::vector<Completion> _completions;
+    std::vector<int> _changed;
+    // nodes with active set
+    std::vector<int> _active;
+    double _now = 0;
+};
+
+#endif // NODE_TIMINGS_H
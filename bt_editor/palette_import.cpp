@@ -0,0 +1,231 @@
+#include "palette_import.h"
+#include "XML_utilities.hpp"
+#include "trace_recorder.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
+
+namespace PaletteImport
+{
+
+static const char MAGIC[8] = { 'G','R','O','O','T','P','A','L' };
+static const quint32 VERSION = 1;
+
+namespace {
+
+struct PaletteJob
+{
+    QString filename;
+    ImportedPalettes::File file;
+    NodeModels models;
+    QString error;
+};
+
+void parsePalette(PaletteJob& job)
+{
+    const QFileInfo info( job.filename );
+    job.file.filename = info.absoluteFilePath();
+    job.file.size = info.size();
+    job.file.last_modified = info.lastModified().toMSecsSinceEpoch();
+
+    QFile file( job.filename );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        job.error = QObject::tr("%1: can not be opened").arg( job.filename );
+        return;
+    }
+    try {
+        XMLProject project = ReadProjectFromXML( QString::fromUtf8( file.readAll() ) );
+        for (auto& it: project.custom_models)
+        {
+            if( BuiltinNodeModels().count( it.first ) == 0 )
+            {
+                job.models.insert( std::move(it) );
+            }
+        }
+    }
+    catch (std::exception& err) {
+        job.error = QObject::tr("%1: %2").arg( job.filename, err.what() );
+        return;
+    }
+    if( job.models.empty() )
+    {
+        job.error = QObject::tr("%1: no model found in <TreeNodesModel>").arg( job.filename );
+    }
+}
+
+}
+
+ImportedPalettes importFiles(const QStringList &filenames)
+{
+    TraceScope trace( "xml", "importPalettes" );
+    trace.setArgument( "files", filenames.size() );
+
+    std::vector<PaletteJob> jobs( size_t(filenames.size()) );
+    for (int i = 0; i < filenames.size(); i++)
+    {
+        jobs[size_t(i)].filename = filenames[i];
+    }
+    QtConcurrent::blockingMap( jobs, parsePalette );
+
+    ImportedPalettes palettes;
+    // the file of each model kept
+    std::map<QString, QString> model_files;
+    for (PaletteJob& job: jobs)
+    {
+        if( !job.error.isEmpty() )
+        {
+            palettes.errors.push_back( job.error );
+            continue;
+        }
+        palettes.files.push_back( job.file );
+        for (auto& it: job.models)
+        {
+            auto prev = palettes.models.find( it.first );
+            if( prev == palettes.models.end() )
+            {
+                model_files.insert( { it.first, job.file.filename } );
+                palettes.models.insert( std::move(it) );
+            }
+            else if( prev->second != it.second )
+            {
+                palettes.conflicts.push_back( { it.first, model_files[it.first],
+                                                job.file.filename } );
+            }
+        }
+    }
+    return palettes;
+}
+
+QString cacheFilename()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+            "/palettes.cache";
+}
+
+bool readCache(const QString &cache_file, ImportedPalettes *palettes)
+{
+    QFile file( cache_file );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    char magic[sizeof(MAGIC)];
+    quint32 version = 0;
+    if( stream.readRawData( magic, sizeof(MAGIC) ) != sizeof(MAGIC) ||
+        memcmp( magic, MAGIC, sizeof(MAGIC) ) != 0 )
+    {
+        return false;
+    }
+    stream >> version;
+    if( version != VERSION )
+    {
+        return false;
+    }
+
+    ImportedPalettes cached;
+    quint32 files_count;
+    stream >> files_count;
+    for (quint32 i = 0; i < files_count && stream.status() == QDataStream::Ok; i++)
+    {
+        ImportedPalettes::File palette_file;
+        stream >> palette_file.filename >> palette_file.size >> palette_file.last_modified;
+        cached.files.push_back( palette_file );
+    }
+
+    quint32 models_count;
+    stream >> models_count;
+    for (quint32 i = 0; i < models_count && stream.status() == QDataStream::Ok; i++)
+    {
+        NodeModel model = ReadModelFromStream( stream );
+        cached.models.insert( { model.registration_ID, model } );
+    }
+
+    if( stream.status() != QDataStream::Ok || cached.files.empty() )
+    {
+        return false;
+    }
+    *palettes = std::move(cached);
+    return true;
+}
+
+bool upToDate(const ImportedPalettes &palettes)
+{
+    for (const auto& palette_file: palettes.files)
+    {
+        const QFileInfo info( palette_file.filename );
+        if( !info.exists() || info.size() != palette_file.size ||
+            info.lastModified().toMSecsSinceEpoch() != palette_file.last_modified )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeCache(const QString &cache_file, const ImportedPalettes &palettes)
+{
+    QDir().mkpath( QFileInfo(cache_file).absolutePath() );
+
+    QSaveFile file( cache_file );
+    if( !file.open(QIODevice::WriteOnly) )
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    stream.writeRawData( MAGIC, sizeof(MAGIC) );
+    stream << VERSION;
+
+    stream << quint32(palettes.files.size());
+    for (const auto& palette_file: palettes.files)
+    {
+        stream << palette_file.filename << palette_file.size << palette_file.last_modified;
+    }
+
+    stream << quint32(palettes.models.size());
+    for (const auto& it: palettes.models)
+    {
+        WriteModelToStream( stream, it.second );
+    }
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+ImportedPalettes restore(const QString &cache_file)
+{
+    ImportedPalettes palettes;
+    if( !readCache( cache_file, &palettes ) || upToDate( palettes ) )
+    {
+        return palettes;
+    }
+    QStringList filenames;
+    for (const auto& palette_file: palettes.files)
+    {
+        filenames.push_back( palette_file.filename );
+    }
+    palettes = importFiles( filenames );
+    if( !palettes.files.empty() )
+    {
+        writeCache( cache_file, palettes );
+    }
+    return palettes;
+}
+
+}
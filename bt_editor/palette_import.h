@@ -0,0 +1,71 @@
+#ifndef PALETTE_IMPORT_H
+#define PALETTE_IMPORT_H
+
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include "bt_editor_base.h"
+
+// The models of many palette files (XML files with a <TreeNodesModel>),
+// merged into a single set.
+struct ImportedPalettes
+{
+    struct File
+    {
+        QString filename;
+        qint64 size;
+        qint64 last_modified; // msecs since epoch
+    };
+
+    // a model defined differently by two files: the first one is kept
+    struct Conflict
+    {
+        QString ID;
+        QString kept_file;
+        QString ignored_file;
+    };
+
+    // the files read, in the order of the import
+    std::vector<File> files;
+    // the builtin models excluded
+    NodeModels models;
+    // the files that could not be read, and why
+    QStringList errors;
+    std::vector<Conflict> conflicts;
+};
+
+// The last set of palettes imported is cached, one file in the cache
+// directory of the application, to be registered again when the next
+// session starts.
+//
+//   char[8]            "GROOTPAL"
+//   uint32             version
+//   [palettes]         QDataStream (Qt_5_0) of the files (name, size, date)
+//                      and of the merged models
+//
+// The cache is valid only while none of the files changed (same size and
+// date); otherwise they are imported again.
+namespace PaletteImport
+{
+
+// Parse the files in parallel, then merge their models in the order of the
+// files. Any thread.
+ImportedPalettes importFiles(const QStringList& filenames);
+
+QString cacheFilename();
+
+// Return false if there is no cache, or it can not be read
+bool readCache(const QString& cache_file, ImportedPalettes* palettes);
+
+// none of the files changed since they were imported
+bool upToDate(const ImportedPalettes& palettes);
+
+bool writeCache(const QString& cache_file, const ImportedPalettes& palettes);
+
+// the palettes of the cache, imported again if a file changed since it was
+// written. Empty if there is no cache
+ImportedPalettes restore(const QString& cache_file);
+
+}
+
+#endif // PALETTE_IMPORT_H
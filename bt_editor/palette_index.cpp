@@ -0,0 +1,189 @@
+#include "palette_index.h"
+#include <algorithm>
+
+quint64 PaletteIndex::trigram(const QChar *chars)
+{
+    return ( quint64(chars[0].unicode()) << 32 ) |
+           ( quint64(chars[1].unicode()) << 16 ) |
+             quint64(chars[2].unicode());
+}
+
+void PaletteIndex::addTrigrams(const QString &lower_text, int entry_index)
+{
+    for (int i = 0; i + 3 <= lower_text.size(); i++)
+    {
+        auto& entries = _trigrams[ trigram( lower_text.constData() + i ) ];
+        if( entries.empty() || entries.back() != entry_index )
+        {
+            entries.push_back( entry_index );
+        }
+    }
+}
+
+void PaletteIndex::build(const NodeModels &models)
+{
+    _entries.clear();
+    _trigrams.clear();
+    _entries.reserve( models.size() );
+
+    for (const auto& it: models)
+    {
+        const NodeModel& model = it.second;
+        if( model.registration_ID == "Root" )
+        {
+            continue;
+        }
+        Entry entry;
+        entry.ID = it.first;
+        entry.lower_ID = it.first.toLower();
+
+        // a word starts with a capital letter or after a separator
+        for (int i = 0; i < it.first.size(); i++)
+        {
+            const QChar c = it.first[i];
+            const bool word_start = ( i == 0 && c.isLetterOrNumber() ) ||
+                                    c.isUpper() ||
+                                    ( i > 0 && c.isLetterOrNumber() && !it.first[i-1].isLetterOrNumber() );
+            if( word_start )
+            {
+                entry.initials.append( c.toLower() );
+            }
+        }
+
+        const int entry_index = int( _entries.size() );
+        addTrigrams( entry.lower_ID, entry_index );
+        for (const auto& port_it: model.ports)
+        {
+            entry.lower_ports.push_back( port_it.first.toLower() );
+            addTrigrams( entry.lower_ports.back(), entry_index );
+        }
+        _entries.push_back( std::move(entry) );
+    }
+}
+
+std::vector<int> PaletteIndex::candidates(const QString &query) const
+{
+    std::vector<const std::vector<int>*> lists;
+    for (int i = 0; i + 3 <= query.size(); i++)
+    {
+        auto it = _trigrams.find( trigram( query.constData() + i ) );
+        if( it == _trigrams.end() )
+        {
+            return {};
+        }
+        lists.push_back( &(*it) );
+    }
+    std::sort( lists.begin(), lists.end(),
+               [](const std::vector<int>* a, const std::vector<int>* b)
+    {
+        return a->size() < b->size();
+    });
+
+    // the shortest list, filtered by the others
+    std::vector<int> out;
+    for (int entry_index: *lists.front())
+    {
+        bool in_all = true;
+        for (size_t l = 1; in_all && l < lists.size(); l++)
+        {
+            in_all = std::binary_search( lists[l]->begin(), lists[l]->end(), entry_index );
+        }
+        if( in_all )
+        {
+            out.push_back( entry_index );
+        }
+    }
+    return out;
+}
+
+// characters of query found in order in text: the fewer characters skipped
+// between the first and the last, the higher. 0 if not all found
+static int SubsequenceScore(const QString& text, const QString& query)
+{
+    int first = -1;
+    int pos = 0;
+    for (const QChar c: query)
+    {
+        pos = text.indexOf( c, pos );
+        if( pos < 0 )
+        {
+            return 0;
+        }
+        if( first < 0 )
+        {
+            first = pos;
+        }
+        pos++;
+    }
+    const int skipped = ( pos - first ) - query.size();
+    return std::max( 1, 100 - skipped );
+}
+
+std::vector<PaletteIndex::Match> PaletteIndex::search(const QString &text) const
+{
+    std::vector<Match> matches;
+    const QString query = text.trimmed().toLower();
+    if( query.isEmpty() )
+    {
+        return matches;
+    }
+
+    // shorter queries have no trigram: all the entries are candidates
+    const bool indexed = ( query.size() >= 3 );
+    const std::vector<int> substring_candidates = indexed ? candidates( query ) : std::vector<int>();
+    auto next_candidate = substring_candidates.begin();
+
+    for (int entry_index = 0; entry_index < int(_entries.size()); entry_index++)
+    {
+        const Entry& entry = _entries[entry_index];
+        bool candidate = !indexed;
+        if( indexed && next_candidate != substring_candidates.end() && *next_candidate == entry_index )
+        {
+            candidate = true;
+            next_candidate++;
+        }
+
+        int score = 0;
+        if( candidate )
+        {
+            const int pos = entry.lower_ID.indexOf( query );
+            if( entry.lower_ID == query )
+            {
+                score = 1000;
+            }
+            else if( pos == 0 )
+            {
+                score = 900 - std::min( 99, entry.lower_ID.size() - query.size() );
+            }
+            else if( pos > 0 )
+            {
+                score = 700 - std::min( 99, pos );
+            }
+        }
+        if( score == 0 && entry.initials.startsWith( query ) )
+        {
+            score = 500;
+        }
+        for (size_t p = 0; candidate && score == 0 && p < entry.lower_ports.size(); p++)
+        {
+            if( entry.lower_ports[p].contains( query ) )
+            {
+                score = 300;
+            }
+        }
+        if( score == 0 )
+        {
+            score = SubsequenceScore( entry.lower_ID, query );
+        }
+        if( score > 0 )
+        {
+            matches.push_back( { entry.ID, score } );
+        }
+    }
+
+    std::sort( matches.begin(), matches.end(), [](const Match& a, const Match& b)
+    {
+        return a.score != b.score ? a.score > b.score : a.ID < b.ID;
+    });
+    return matches;
+}
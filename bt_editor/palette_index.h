@@ -0,0 +1,59 @@
+#ifndef PALETTE_INDEX_H
+#define PALETTE_INDEX_H
+
+#include <vector>
+#include <QHash>
+#include <QString>
+#include "bt_editor_base.h"
+
+// Search of the models of the palette by registration ID and port name.
+//
+// The IDs and the port names are indexed by trigram: for a query of three
+// characters or more, only the models that contain all its trigrams are
+// checked for a substring. The matches are ranked, best first:
+//
+//  - the exact ID, then the IDs starting with the query, then those
+//    containing it (the earlier, the better);
+//  - the initials of the words of the ID ("ss" for SequenceStar);
+//  - a port name containing the query;
+//  - the IDs containing the characters of the query in order (the fewer
+//    characters between them, the better). This last pass goes through all
+//    the IDs, not the ports.
+//
+// The search is not case sensitive.
+class PaletteIndex
+{
+public:
+    struct Match
+    {
+        QString ID;
+        int score;
+    };
+
+    void build(const NodeModels& models);
+
+    // best first; the models not matching are not returned
+    std::vector<Match> search(const QString& text) const;
+
+private:
+    struct Entry
+    {
+        QString ID;
+        QString lower_ID;
+        QString initials;
+        std::vector<QString> lower_ports;
+    };
+
+    static quint64 trigram(const QChar* chars);
+
+    void addTrigrams(const QString& lower_text, int entry_index);
+
+    // the entries that contain all the trigrams of query, sorted
+    std::vector<int> candidates(const QString& query) const;
+
+    std::vector<Entry> _entries;
+    // entry indices, sorted and unique
+    QHash<quint64, std::vector<int>> _trigrams;
+};
+
+#endif // PALETTE_INDEX_H
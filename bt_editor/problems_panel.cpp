@@ -0,0 +1,122 @@
+#include "problems_panel.h"
+
+#include <QHeaderView>
+#include <QStyle>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
+
+ProblemsPanel::ProblemsPanel(QWidget *parent) :
+    QFrame(parent),
+    _tabs_pending(false)
+{
+    _problems_tree = new QTreeWidget( this );
+    _problems_tree->setColumnCount( 3 );
+    _problems_tree->setHeaderLabels( { tr("Tree"), tr("Node"), tr("Problem") } );
+    _problems_tree->setRootIsDecorated( false );
+    _problems_tree->setUniformRowHeights( true );
+    _problems_tree->header()->setSectionResizeMode( 0, QHeaderView::ResizeToContents );
+    _problems_tree->header()->setSectionResizeMode( 1, QHeaderView::Interactive );
+    _problems_tree->header()->setStretchLastSection( true );
+
+    _label_status = new QLabel( this );
+
+    auto layout = new QVBoxLayout( this );
+    layout->setContentsMargins( 2, 2, 2, 2 );
+    layout->addWidget( _problems_tree, 1 );
+    layout->addWidget( _label_status );
+
+    connect( _problems_tree, &QTreeWidget::itemActivated,
+             this, &ProblemsPanel::onItemActivated );
+
+    connect( &_validation_watcher, &QFutureWatcher<ProjectValidator>::finished,
+             this, &ProblemsPanel::onValidated );
+}
+
+ProblemsPanel::~ProblemsPanel()
+{
+    _validation_watcher.waitForFinished();
+}
+
+void ProblemsPanel::validate(std::vector<TabSnapshot> tabs, const NodeModels &models)
+{
+    _pending_tabs = std::move(tabs);
+    _pending_models = models;
+    _tabs_pending = true;
+    if( !_validation_watcher.isRunning() )
+    {
+        startValidation();
+    }
+}
+
+void ProblemsPanel::startValidation()
+{
+    _tabs_pending = false;
+    std::vector<TabSnapshot> tabs;
+    std::swap( tabs, _pending_tabs );
+    NodeModels models;
+    std::swap( models, _pending_models );
+
+    const ProjectValidator previous = _validator;
+    _validation_watcher.setFuture( QtConcurrent::run( [tabs, models, previous]()
+    {
+        return ProjectValidator::validate( tabs, models, previous );
+    }));
+}
+
+void ProblemsPanel::onValidated()
+{
+    _validator = _validation_watcher.result();
+    if( _tabs_pending )
+    {
+        startValidation();
+        return;
+    }
+    showProblems();
+}
+
+void ProblemsPanel::showProblems()
+{
+    _problems = _validator.problems();
+    const auto& problems = _problems;
+    const QIcon error_icon   = style()->standardIcon( QStyle::SP_MessageBoxCritical );
+    const QIcon warning_icon = style()->standardIcon( QStyle::SP_MessageBoxWarning );
+
+    _problems_tree->setUpdatesEnabled( false );
+    _problems_tree->clear();
+
+    int errors = 0;
+    QList<QTreeWidgetItem*> items;
+    items.reserve( int(problems.size()) );
+    for (size_t row = 0; row < problems.size(); row++)
+    {
+        const auto& problem = problems[row];
+        QString node_text = problem.node.instance_name;
+        if( problem.node.instance_name != problem.node.registration_ID )
+        {
+            node_text += QString(" (%1)").arg( problem.node.registration_ID );
+        }
+        auto item = new QTreeWidgetItem( { problem.node.tab_name, node_text, problem.message } );
+        const bool error = ( problem.severity == ProjectValidator::Problem::ERROR );
+        item->setIcon( 0, error ? error_icon : warning_icon );
+        item->setData( 0, Qt::UserRole, int(row) );
+        items.push_back( item );
+        errors += error ? 1 : 0;
+    }
+    _problems_tree->addTopLevelItems( items );
+    _problems_tree->setUpdatesEnabled( true );
+
+    const int warnings = int(problems.size()) - errors;
+    _label_status->setText( tr("%1 errors, %2 warnings").arg( errors ).arg( warnings ) );
+    emit problemsCountChanged( errors, warnings );
+}
+
+void ProblemsPanel::onItemActivated(QTreeWidgetItem *item, int)
+{
+    const int row = item->data( 0, Qt::UserRole ).toInt();
+    if( row >= 0 && row < int(_problems.size()) )
+    {
+        // the problems may be shown again while the node is
+        const NodeLocation node = _problems[row].node;
+        emit problemActivated( node );
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef PROBLEMS_PANEL_H
+#define PROBLEMS_PANEL_H
+
+#include <QFrame>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QTreeWidget>
+#include "project_validator.h"
+
+// The problems of the trees of the project, see ProjectValidator.
+//
+// The validation runs in the thread pool: the tabs given while it runs are
+// validated once it is done, only the latest ones. Activating a problem
+// emits problemActivated, with the tab and, if any, the node.
+class ProblemsPanel : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit ProblemsPanel(QWidget *parent = nullptr);
+
+    ~ProblemsPanel() override;
+
+    void validate(std::vector<TabSnapshot> tabs, const NodeModels& models);
+
+signals:
+
+    void problemActivated(const NodeLocation& node);
+
+    void problemsCountChanged(int errors, int warnings);
+
+private slots:
+
+    void onItemActivated(QTreeWidgetItem* item, int column);
+
+private:
+
+    void startValidation();
+
+    void onValidated();
+
+    void showProblems();
+
+    QTreeWidget* _problems_tree;
+    QLabel* _label_status;
+
+    ProjectValidator _validator;
+    QFutureWatcher<ProjectValidator> _validation_watcher;
+    // received while the validation ran
+    std::vector<TabSnapshot> _pending_tabs;
+    NodeModels _pending_models;
+    bool _tabs_pending;
+
+    std::vector<ProjectValidator::Problem> _problems;
+};
+
+#endif // PROBLEMS_PANEL_H
@@ -0,0 +1,134 @@
+#include "project_cache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace ProjectCache
+{
+
+static const char MAGIC[8] = { 'G','R','O','O','T','P','R','J' };
+static const quint32 VERSION = 2;
+
+QByteArray hashOf(const QByteArray &xml_data)
+{
+    return QCryptographicHash::hash( xml_data, QCryptographicHash::Sha1 );
+}
+
+QString filename(const QByteArray &xml_hash)
+{
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+            "/projects/" + QString::fromLatin1( xml_hash.toHex() ) + ".cache";
+}
+
+bool read(const QByteArray &xml_hash, CachedProject *project)
+{
+    QFile file( filename(xml_hash) );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    char magic[sizeof(MAGIC)];
+    quint32 version = 0;
+    if( stream.readRawData( magic, sizeof(MAGIC) ) != sizeof(MAGIC) ||
+        memcmp( magic, MAGIC, sizeof(MAGIC) ) != 0 )
+    {
+        return false;
+    }
+    stream >> version;
+    if( version != VERSION )
+    {
+        return false;
+    }
+
+    CachedProject cached;
+    quint32 models_count;
+    stream >> cached.main_tree >> models_count;
+    for (quint32 i = 0; i < models_count && stream.status() == QDataStream::Ok; i++)
+    {
+        NodeModel model = ReadModelFromStream( stream );
+        cached.custom_models.insert( { model.registration_ID, model } );
+    }
+
+    quint32 tabs_count;
+    stream >> tabs_count;
+    for (quint32 i = 0; i < tabs_count && stream.status() == QDataStream::Ok; i++)
+    {
+        CachedProject::Tab tab;
+        bool has_tree;
+        stream >> tab.name >> has_tree;
+        if( has_tree )
+        {
+            tab.tree = std::make_shared<const AbsBehaviorTree>( ReadTreeFromStream( stream ) );
+        }
+        else{
+            QByteArray compressed;
+            stream >> compressed;
+            tab.scene_json = qUncompress( compressed );
+            if( tab.scene_json.isEmpty() )
+            {
+                return false;
+            }
+        }
+        cached.tabs.push_back( std::move(tab) );
+    }
+
+    if( stream.status() != QDataStream::Ok || cached.tabs.empty() )
+    {
+        return false;
+    }
+    *project = std::move(cached);
+    return true;
+}
+
+bool write(const QByteArray &xml_hash, const CachedProject &project)
+{
+    const QString path = filename(xml_hash);
+    QDir().mkpath( QFileInfo(path).absolutePath() );
+
+    QSaveFile file( path );
+    if( !file.open(QIODevice::WriteOnly) )
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    stream.writeRawData( MAGIC, sizeof(MAGIC) );
+    stream << VERSION;
+
+    stream << project.main_tree << quint32(project.custom_models.size());
+    for (const auto& it: project.custom_models)
+    {
+        WriteModelToStream( stream, it.second );
+    }
+
+    stream << quint32(project.tabs.size());
+    for (const auto& tab: project.tabs)
+    {
+        stream << tab.name << bool(tab.tree);
+        if( tab.tree )
+        {
+            WriteTreeToStream( stream, *tab.tree );
+        }
+        else{
+            stream << qCompress( tab.scene_json );
+        }
+    }
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+}
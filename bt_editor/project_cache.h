@@ -0,0 +1,53 @@
+#ifndef PROJECT_CACHE_H
+#define PROJECT_CACHE_H
+
+#include <memory>
+#include <vector>
+#include <QByteArray>
+#include <QString>
+#include "bt_editor_base.h"
+
+// What is needed to show a project again without parsing its XML: the
+// models, and for each tab either the tree of a tab never shown or the saved
+// state of its scene, with the positions of the nodes and the expanded
+// subtrees (same format as QtNodes::FlowScene::saveToMemory()).
+struct CachedProject
+{
+    struct Tab
+    {
+        QString name;
+        std::shared_ptr<const AbsBehaviorTree> tree;
+        QByteArray scene_json;
+    };
+
+    QString main_tree;
+    NodeModels custom_models;
+    // in the order of the tab bar
+    std::vector<Tab> tabs;
+};
+
+// Cache of the projects that were opened, one file per project in the cache
+// directory of the application, named after the hash of the XML file.
+//
+//   char[8]            "GROOTPRJ"
+//   uint32             version
+//   [project]          QDataStream (Qt_5_0) of main_tree, custom_models and
+//                      tabs. The scenes are compressed (qCompress)
+//
+// The cache of a file is valid only while the file is unchanged: a file
+// edited elsewhere has a different hash, and is parsed again.
+namespace ProjectCache
+{
+
+QByteArray hashOf(const QByteArray& xml_data);
+
+QString filename(const QByteArray& xml_hash);
+
+// Return false if there is no cache, or it can not be read
+bool read(const QByteArray& xml_hash, CachedProject* project);
+
+bool write(const QByteArray& xml_hash, const CachedProject& project);
+
+}
+
+#endif // PROJECT_CACHE_H
@@ -0,0 +1,125 @@
+#include "project_search.h"
+#include <QHash>
+
+std::shared_ptr<const ProjectSearchIndex::TabIndex> ProjectSearchIndex::buildTab(const TabSnapshot &tab)
+{
+    auto tab_index = std::make_shared<TabIndex>();
+    tab_index->snapshot = tab;
+    tab_index->snapshot.node_ids.clear();
+
+    QHash<QString, int> text_index;
+    auto addText = [&](int node, Field field, const QString& port_name, const QString& text)
+    {
+        if( text.isEmpty() )
+        {
+            return;
+        }
+        const QString lower_text = text.toLower();
+        auto it = text_index.find( lower_text );
+        if( it == text_index.end() )
+        {
+            it = text_index.insert( lower_text, int( tab_index->lower_texts.size() ) );
+            tab_index->lower_texts.push_back( lower_text );
+            tab_index->postings.push_back( {} );
+        }
+        tab_index->postings[ *it ].push_back( { node, field, port_name, text } );
+    };
+
+    for (auto& snapshot_node: SnapshotNodes( tab ))
+    {
+        const NodeLocation& location = snapshot_node.location;
+        if( location.registration_ID == "Root" )
+        {
+            continue;
+        }
+        const int node = int( tab_index->nodes.size() );
+        addText( node, REGISTRATION_ID, QString(), location.registration_ID );
+        if( location.instance_name != location.registration_ID )
+        {
+            addText( node, INSTANCE_NAME, QString(), location.instance_name );
+        }
+        for (const auto& it: snapshot_node.ports_mapping)
+        {
+            addText( node, PORT_VALUE, it.first, it.second );
+        }
+        tab_index->nodes.push_back( std::move(snapshot_node.location) );
+    }
+    return tab_index;
+}
+
+ProjectSearchIndex ProjectSearchIndex::build(const std::vector<TabSnapshot> &tabs,
+                                             const ProjectSearchIndex &previous)
+{
+    ProjectSearchIndex index;
+    for (const auto& tab: tabs)
+    {
+        auto it = previous._tabs.find( tab.tab_name );
+        if( it != previous._tabs.end() && previous.indexed( tab ) )
+        {
+            index._tabs.insert( *it );
+        }
+        else{
+            index._tabs.insert( { tab.tab_name, buildTab( tab ) } );
+        }
+    }
+    return index;
+}
+
+bool ProjectSearchIndex::indexed(const TabSnapshot &tab) const
+{
+    auto it = _tabs.find( tab.tab_name );
+    return it != _tabs.end() && it->second->snapshot.sameContent( tab );
+}
+
+std::vector<ProjectSearchIndex::Match> ProjectSearchIndex::search(const QString &text,
+                                                                  size_t max_matches,
+                                                                  bool *truncated) const
+{
+    std::vector<Match> exact_matches;
+    std::vector<Match> matches;
+    size_t matches_count = 0;
+    if( truncated )
+    {
+        *truncated = false;
+    }
+    const QString query = text.trimmed().toLower();
+    if( query.isEmpty() )
+    {
+        return matches;
+    }
+
+    for (const auto& tab_it: _tabs)
+    {
+        const TabIndex& tab = *tab_it.second;
+        for (size_t i = 0; i < tab.lower_texts.size(); i++)
+        {
+            const bool exact = ( tab.lower_texts[i] == query );
+            if( !exact && !tab.lower_texts[i].contains( query ) )
+            {
+                continue;
+            }
+            std::vector<Match>& found = exact ? exact_matches : matches;
+            for (const Posting& posting: tab.postings[i])
+            {
+                matches_count++;
+                if( !exact && matches.size() >= max_matches )
+                {
+                    continue;
+                }
+                found.push_back( { tab.nodes[ posting.node ], posting.field,
+                                   posting.port_name, posting.text } );
+            }
+        }
+    }
+
+    exact_matches.insert( exact_matches.end(), matches.begin(), matches.end() );
+    if( exact_matches.size() > max_matches )
+    {
+        exact_matches.resize( max_matches );
+    }
+    if( truncated )
+    {
+        *truncated = ( matches_count > exact_matches.size() );
+    }
+    return exact_matches;
+}
@@ -0,0 +1,70 @@
+#ifndef PROJECT_SEARCH_H
+#define PROJECT_SEARCH_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <QString>
+#include "tab_snapshot.h"
+
+// Search of the nodes of all the tabs of a project, by instance name,
+// registration ID (a SubTree node is found by the name of its tree) and
+// value of a port (a blackboard key is found in every tree using it).
+//
+// A tab is indexed from its TabSnapshot, without building its scene. Each
+// distinct text of a tab is stored once, with the nodes that have it.
+//
+// The index is built again from the snapshots, the tabs whose snapshot did
+// not change keep their previous index. The build only reads the
+// snapshots: it can run in another thread.
+class ProjectSearchIndex
+{
+public:
+    enum Field { INSTANCE_NAME, REGISTRATION_ID, PORT_VALUE };
+
+    struct Match
+    {
+        NodeLocation node;
+        Field field;
+        QString port_name;
+        QString text;
+    };
+
+    static ProjectSearchIndex build(const std::vector<TabSnapshot>& tabs,
+                                    const ProjectSearchIndex& previous);
+
+    // true if the tab would not be indexed again by build()
+    bool indexed(const TabSnapshot& tab) const;
+
+    // The nodes whose texts contain text, not case sensitive: the exact
+    // matches first, then the tabs in order. At most max_matches,
+    // truncated is set if there are more
+    std::vector<Match> search(const QString& text, size_t max_matches,
+                              bool* truncated = nullptr) const;
+
+    bool empty() const { return _tabs.empty(); }
+
+private:
+    struct Posting
+    {
+        int node;
+        Field field;
+        QString port_name;
+        QString text;
+    };
+
+    struct TabIndex
+    {
+        TabSnapshot snapshot;
+        std::vector<NodeLocation> nodes;
+        // by distinct text, lower case
+        std::vector<QString> lower_texts;
+        std::vector<std::vector<Posting>> postings;
+    };
+
+    static std::shared_ptr<const TabIndex> buildTab(const TabSnapshot& tab);
+
+    std::map<QString, std::shared_ptr<const TabIndex>> _tabs;
+};
+
+#endif // PROJECT_SEARCH_H
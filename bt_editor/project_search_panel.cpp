@@ -0,0 +1,164 @@
+#include "project_search_panel.h"
+
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
+
+const size_t ProjectSearchPanel::MAX_MATCHES = 500;
+
+ProjectSearchPanel::ProjectSearchPanel(QWidget *parent) :
+    QFrame(parent),
+    _tabs_pending(false)
+{
+    _line_edit_filter = new QLineEdit( this );
+    _line_edit_filter->setPlaceholderText( tr("Node, model or port value") );
+    _line_edit_filter->setClearButtonEnabled( true );
+
+    _results_tree = new QTreeWidget( this );
+    _results_tree->setColumnCount( 3 );
+    _results_tree->setHeaderLabels( { tr("Tree"), tr("Node"), tr("Match") } );
+    _results_tree->setRootIsDecorated( false );
+    _results_tree->setUniformRowHeights( true );
+    _results_tree->header()->setSectionResizeMode( 0, QHeaderView::ResizeToContents );
+    _results_tree->header()->setSectionResizeMode( 1, QHeaderView::Interactive );
+    _results_tree->header()->setStretchLastSection( true );
+
+    _label_status = new QLabel( this );
+
+    auto layout = new QVBoxLayout( this );
+    layout->setContentsMargins( 2, 2, 2, 2 );
+    layout->addWidget( _line_edit_filter );
+    layout->addWidget( _results_tree, 1 );
+    layout->addWidget( _label_status );
+
+    _filter_timer.setSingleShot(true);
+    _filter_timer.setInterval(200);
+    connect( &_filter_timer, &QTimer::timeout, this, &ProjectSearchPanel::tabsRequested );
+
+    connect( _line_edit_filter, &QLineEdit::textChanged, this, [this]()
+    {
+        _filter_timer.start();
+    });
+
+    connect( _results_tree, &QTreeWidget::itemActivated,
+             this, &ProjectSearchPanel::onItemActivated );
+
+    connect( &_index_watcher, &QFutureWatcher<ProjectSearchIndex>::finished,
+             this, &ProjectSearchPanel::onIndexBuilt );
+}
+
+ProjectSearchPanel::~ProjectSearchPanel()
+{
+    _index_watcher.waitForFinished();
+}
+
+void ProjectSearchPanel::setTabs(std::vector<TabSnapshot> tabs)
+{
+    if( _index_watcher.isRunning() )
+    {
+        _pending_tabs = std::move(tabs);
+        _tabs_pending = true;
+        return;
+    }
+    startBuild( std::move(tabs) );
+}
+
+void ProjectSearchPanel::refresh()
+{
+    _filter_timer.start();
+}
+
+void ProjectSearchPanel::focusFilter()
+{
+    _line_edit_filter->setFocus();
+    _line_edit_filter->selectAll();
+}
+
+void ProjectSearchPanel::startBuild(std::vector<TabSnapshot> tabs)
+{
+    bool changed = false;
+    for (const auto& tab: tabs)
+    {
+        changed = changed || !_index.indexed( tab );
+    }
+    if( !changed && !_index.empty() )
+    {
+        showMatches();
+        return;
+    }
+    _label_status->setText( tr("Indexing...") );
+
+    const ProjectSearchIndex previous = _index;
+    _index_watcher.setFuture( QtConcurrent::run( [tabs, previous]()
+    {
+        return ProjectSearchIndex::build( tabs, previous );
+    }));
+}
+
+void ProjectSearchPanel::onIndexBuilt()
+{
+    _index = _index_watcher.result();
+    if( _tabs_pending )
+    {
+        _tabs_pending = false;
+        std::vector<TabSnapshot> tabs;
+        std::swap( tabs, _pending_tabs );
+        startBuild( std::move(tabs) );
+        return;
+    }
+    showMatches();
+}
+
+void ProjectSearchPanel::showMatches()
+{
+    bool truncated = false;
+    _matches = _index.search( _line_edit_filter->text(), MAX_MATCHES, &truncated );
+
+    _results_tree->setUpdatesEnabled( false );
+    _results_tree->clear();
+
+    QList<QTreeWidgetItem*> items;
+    items.reserve( int(_matches.size()) );
+    for (size_t row = 0; row < _matches.size(); row++)
+    {
+        const auto& match = _matches[row];
+        QString node_text = match.node.instance_name;
+        if( match.node.instance_name != match.node.registration_ID )
+        {
+            node_text += QString(" (%1)").arg( match.node.registration_ID );
+        }
+        QString match_text = match.text;
+        if( match.field == ProjectSearchIndex::PORT_VALUE )
+        {
+            match_text = QString("%1 = %2").arg( match.port_name, match.text );
+        }
+        auto item = new QTreeWidgetItem( { match.node.tab_name, node_text, match_text } );
+        item->setData( 0, Qt::UserRole, int(row) );
+        items.push_back( item );
+    }
+    _results_tree->addTopLevelItems( items );
+    _results_tree->setUpdatesEnabled( true );
+
+    if( _line_edit_filter->text().trimmed().isEmpty() )
+    {
+        _label_status->clear();
+    }
+    else if( truncated )
+    {
+        _label_status->setText( tr("First %1 matches").arg( _matches.size() ) );
+    }
+    else{
+        _label_status->setText( tr("%1 matches").arg( _matches.size() ) );
+    }
+}
+
+void ProjectSearchPanel::onItemActivated(QTreeWidgetItem *item, int)
+{
+    const int row = item->data( 0, Qt::UserRole ).toInt();
+    if( row >= 0 && row < int(_matches.size()) )
+    {
+        // the results may be refreshed while the node is shown
+        const ProjectSearchIndex::Match match = _matches[row];
+        emit matchActivated( match );
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef PROJECT_SEARCH_PANEL_H
+#define PROJECT_SEARCH_PANEL_H
+
+#include <QFrame>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QTreeWidget>
+#include "project_search.h"
+
+// Search of the nodes of all the tabs of the project, see ProjectSearchIndex.
+//
+// Before a search the panel asks for the tabs (tabsRequested), indexed
+// again in the thread pool if they changed. Activating a result emits
+// matchActivated: the tabs of the other results are left as they are.
+class ProjectSearchPanel : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectSearchPanel(QWidget *parent = nullptr);
+
+    ~ProjectSearchPanel() override;
+
+    // the tabs of the project, as they are now
+    void setTabs(std::vector<TabSnapshot> tabs);
+
+    // search again, the tabs may have changed
+    void refresh();
+
+    void focusFilter();
+
+signals:
+
+    // setTabs() is expected in response
+    void tabsRequested();
+
+    void matchActivated(const ProjectSearchIndex::Match& match);
+
+private slots:
+
+    void onItemActivated(QTreeWidgetItem* item, int column);
+
+private:
+
+    static const size_t MAX_MATCHES;
+
+    void startBuild(std::vector<TabSnapshot> tabs);
+
+    void onIndexBuilt();
+
+    void showMatches();
+
+    QLineEdit* _line_edit_filter;
+    QTreeWidget* _results_tree;
+    QLabel* _label_status;
+    QTimer _filter_timer;
+
+    ProjectSearchIndex _index;
+    QFutureWatcher<ProjectSearchIndex> _index_watcher;
+    // received while the index was built
+    std::vector<TabSnapshot> _pending_tabs;
+    bool _tabs_pending;
+
+    std::vector<ProjectSearchIndex::Match> _matches;
+};
+
+#endif // PROJECT_SEARCH_PANEL_H
@@ -0,0 +1,186 @@
+#include "project_validator.h"
+#include <algorithm>
+#include <functional>
+
+std::shared_ptr<const ProjectValidator::TabResult> ProjectValidator::checkTab(const TabSnapshot &tab,
+                                                                              const NodeModels &models)
+{
+    auto result = std::make_shared<TabResult>();
+    result->snapshot = tab;
+    result->snapshot.node_ids.clear();
+
+    auto addProblem = [&result](Problem::Severity severity, const NodeLocation& node,
+                                const QString& message)
+    {
+        result->problems.push_back( { severity, node, message } );
+    };
+    NodeLocation tree_location;
+    tree_location.tab_name = tab.tab_name;
+
+    const std::vector<SnapshotNode> nodes = SnapshotNodes( tab );
+    if( nodes.empty() )
+    {
+        // the tree of a scene is built from its single root
+        addProblem( Problem::ERROR, tree_location,
+                    tab.disconnected_nodes > 0 ? "The tree has no single root" : "The tree is empty" );
+        return result;
+    }
+    if( tab.disconnected_nodes > 0 )
+    {
+        addProblem( Problem::ERROR, tree_location,
+                    QString("%1 nodes are not connected to the root").arg( tab.disconnected_nodes ) );
+    }
+
+    // the tree of a tab never shown has no Root node: its first node is the
+    // root. Otherwise every other node needs a parent
+    bool parentless_found = std::any_of( nodes.begin(), nodes.end(), [](const SnapshotNode& node)
+    {
+        return node.location.registration_ID == "Root";
+    });
+    for (const auto& node: nodes)
+    {
+        const NodeLocation& location = node.location;
+        if( location.registration_ID == "Root" )
+        {
+            if( node.children.empty() )
+            {
+                addProblem( Problem::ERROR, location, "The root has no child" );
+            }
+            continue;
+        }
+        if( node.parent < 0 )
+        {
+            if( parentless_found )
+            {
+                addProblem( Problem::ERROR, location, "The node has no parent" );
+            }
+            parentless_found = true;
+        }
+
+        auto model_it = models.find( location.registration_ID );
+        if( model_it == models.end() )
+        {
+            addProblem( Problem::ERROR, location,
+                        QString("Unknown model %1").arg( location.registration_ID ) );
+            continue;
+        }
+        const NodeModel& model = model_it->second;
+
+        switch( model.type )
+        {
+        case NodeType::SUBTREE:
+            result->subtrees.push_back( location );
+            break;
+        case NodeType::CONTROL:
+            if( node.children.empty() )
+            {
+                addProblem( Problem::ERROR, location, "A control node needs at least one child" );
+            }
+            break;
+        case NodeType::DECORATOR:
+            if( node.children.size() != 1 )
+            {
+                addProblem( Problem::ERROR, location, "A decorator needs exactly one child" );
+            }
+            break;
+        default:
+            break;
+        }
+
+        for (const auto& port_it: model.ports)
+        {
+            const PortModel& port = port_it.second;
+            if( port.direction == PortDirection::OUTPUT || !port.default_value.isEmpty() )
+            {
+                continue;
+            }
+            auto mapping_it = node.ports_mapping.find( port_it.first );
+            if( mapping_it == node.ports_mapping.end() || mapping_it->second.isEmpty() )
+            {
+                addProblem( Problem::WARNING, location,
+                            QString("The input port %1 has no value").arg( port_it.first ) );
+            }
+        }
+    }
+
+    return result;
+}
+
+void ProjectValidator::checkSubtrees()
+{
+    for (const auto& it: _tabs)
+    {
+        for (const auto& subtree: it.second->subtrees)
+        {
+            if( _tabs.count( subtree.registration_ID ) == 0 )
+            {
+                _problems.push_back( { Problem::ERROR, subtree,
+                                       QString("The SubTree %1 has no tree").arg( subtree.registration_ID ) } );
+            }
+        }
+    }
+
+    // a SubTree that leads back to a tree being visited closes a cycle
+    enum { NOT_VISITED, VISITING, VISITED };
+    std::map<QString, int> visits;
+    std::function<void(const QString&)> visit;
+    visit = [&](const QString& tab_name)
+    {
+        visits[tab_name] = VISITING;
+        for (const auto& subtree: _tabs.at(tab_name)->subtrees)
+        {
+            if( _tabs.count( subtree.registration_ID ) == 0 )
+            {
+                continue;
+            }
+            const int state = visits[ subtree.registration_ID ];
+            if( state == VISITING )
+            {
+                _problems.push_back( { Problem::ERROR, subtree,
+                                       QString("The SubTree %1 includes %2 recursively")
+                                       .arg( subtree.registration_ID, tab_name ) } );
+            }
+            else if( state == NOT_VISITED )
+            {
+                visit( subtree.registration_ID );
+            }
+        }
+        visits[tab_name] = VISITED;
+    };
+    for (const auto& it: _tabs)
+    {
+        if( visits[it.first] == NOT_VISITED )
+        {
+            visit( it.first );
+        }
+    }
+}
+
+ProjectValidator ProjectValidator::validate(const std::vector<TabSnapshot> &tabs,
+                                            const NodeModels &models,
+                                            const ProjectValidator &previous)
+{
+    ProjectValidator validator;
+    validator._models = models;
+    const bool same_models = ( models == previous._models );
+
+    for (const auto& tab: tabs)
+    {
+        auto it = previous._tabs.find( tab.tab_name );
+        if( same_models && it != previous._tabs.end() && it->second->snapshot.sameContent( tab ) )
+        {
+            validator._tabs.insert( *it );
+        }
+        else{
+            validator._tabs.insert( { tab.tab_name, checkTab( tab, models ) } );
+        }
+    }
+
+    for (const auto& it: validator._tabs)
+    {
+        const auto& problems = it.second->problems;
+        validator._problems.insert( validator._problems.end(), problems.begin(), problems.end() );
+    }
+    validator.checkSubtrees();
+    return validator;
+}
@@ -0,0 +1,63 @@
+#ifndef PROJECT_VALIDATOR_H
+#define PROJECT_VALIDATOR_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <QString>
+#include "tab_snapshot.h"
+
+// The problems of the trees of all the tabs of a project:
+//
+//  - a tree must have a single root, all its nodes connected;
+//  - the model of every node must be known, a control node needs children
+//    and a decorator exactly one;
+//  - an input port without value nor default is reported (a warning);
+//  - a SubTree must have its tab, and a tree must not include itself
+//    through its SubTrees.
+//
+// The tabs are checked from their TabSnapshot, without building their
+// scenes. Those whose snapshot did not change, with the same models, keep
+// the problems of the previous validation; the SubTrees are checked again
+// for the whole project. The validation only reads the snapshots: it can
+// run in another thread.
+class ProjectValidator
+{
+public:
+    struct Problem
+    {
+        enum Severity { WARNING, ERROR };
+
+        Severity severity;
+        // the tab, and the node if the problem is not the whole tree
+        NodeLocation node;
+        QString message;
+    };
+
+    static ProjectValidator validate(const std::vector<TabSnapshot>& tabs,
+                                     const NodeModels& models,
+                                     const ProjectValidator& previous);
+
+    // by tab, the problems of the SubTrees last
+    const std::vector<Problem>& problems() const { return _problems; }
+
+private:
+    struct TabResult
+    {
+        TabSnapshot snapshot;
+        std::vector<Problem> problems;
+        // the SubTree nodes: their registration ID is the name of the tab
+        std::vector<NodeLocation> subtrees;
+    };
+
+    static std::shared_ptr<const TabResult> checkTab(const TabSnapshot& tab,
+                                                     const NodeModels& models);
+
+    void checkSubtrees();
+
+    NodeModels _models;
+    std::map<QString, std::shared_ptr<const TabResult>> _tabs;
+    std::vector<Problem> _problems;
+};
+
+#endif // PROJECT_VALIDATOR_H
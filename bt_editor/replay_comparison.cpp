@@ -0,0 +1,184 @@
+#include "replay_comparison.h"
+
+#include <algorithm>
+#include <cmath>
+#include "replay_log_reader.h"
+
+bool DecodeReplayLog(const char *buffer, size_t size,
+                     AbsBehaviorTree &tree, ReplayTransitions &transitions,
+                     QString &error_message)
+{
+    transitions.clear();
+    ReplayLogReader reader;
+    if( !reader.open( buffer, size, error_message ) )
+    {
+        return false;
+    }
+    tree = reader.tree();
+    transitions.reserve( reader.transitionsCount() );
+    return reader.read( [&transitions](const ReplayTransition& transition)
+    {
+        transitions.push_back( transition );
+    }, error_message );
+}
+
+bool SameTreeStructure(const AbsBehaviorTree &a, const AbsBehaviorTree &b)
+{
+    if( a.nodesCount() != b.nodesCount() )
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.nodesCount(); i++)
+    {
+        const AbstractTreeNode& node_a = a.nodes()[i];
+        const AbstractTreeNode& node_b = b.nodes()[i];
+        if( node_a.model.registration_ID != node_b.model.registration_ID ||
+            node_a.instance_name != node_b.instance_name ||
+            node_a.children_index != node_b.children_index )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ReplayComparison::Tick> ReplayComparison::ticks(const ReplayTransitions &transitions)
+{
+    std::vector<Tick> result;
+    const std::vector<int>& restarts = transitions.restarts();
+    if( transitions.empty() )
+    {
+        return result;
+    }
+    if( restarts.empty() )
+    {
+        result.push_back( {0, transitions.size()} );
+        return result;
+    }
+    // the transitions before the first restart are not a complete tick
+    result.reserve( restarts.size() );
+    for (size_t i = 0; i < restarts.size(); i++)
+    {
+        const size_t last = (i + 1 < restarts.size()) ? size_t(restarts[i+1]) : transitions.size();
+        result.push_back( {size_t(restarts[i]), last} );
+    }
+    return result;
+}
+
+void ReplayComparison::summarize(const ReplayTransitions &transitions, const Tick &tick,
+                                 std::vector<NodeTick> &nodes, std::vector<int> &touched)
+{
+    for (int index: touched)
+    {
+        nodes[index] = NodeTick();
+    }
+    touched.clear();
+
+    for (size_t row = tick.first_row; row < tick.last_row; row++)
+    {
+        const int index = transitions.index(row);
+        const NodeStatus status = transitions.status(row);
+        const double timestamp = transitions.timestamp(row);
+        NodeTick& node = nodes[index];
+        if( !node.active )
+        {
+            node.active = true;
+            touched.push_back( index );
+        }
+        if( status == NodeStatus::SUCCESS || status == NodeStatus::FAILURE )
+        {
+            node.result = status;
+        }
+        if( transitions.prevStatus(row) == NodeStatus::RUNNING && node.running_since >= 0 )
+        {
+            node.running_time += timestamp - node.running_since;
+        }
+        node.running_since = (status == NodeStatus::RUNNING) ? timestamp : -1;
+    }
+}
+
+double ReplayComparison::duration(const ReplayTransitions &transitions, const Tick &tick)
+{
+    if( tick.last_row <= tick.first_row )
+    {
+        return 0;
+    }
+    return transitions.timestamp(tick.last_row - 1) - transitions.timestamp(tick.first_row);
+}
+
+void ReplayComparison::compare(const ReplayTransitions &a, const ReplayTransitions &b,
+                               size_t nodes_count, double time_tolerance)
+{
+    _nodes.assign( nodes_count, NodeComparison() );
+    _ticks_a = ticks( a );
+    _ticks_b = ticks( b );
+    _mean_tick_a = 0;
+    _mean_tick_b = 0;
+
+    std::vector<NodeTick> nodes_a( nodes_count );
+    std::vector<NodeTick> nodes_b( nodes_count );
+    std::vector<int> touched_a;
+    std::vector<int> touched_b;
+    std::vector<double> sum_delta( nodes_count, 0.0 );
+    std::vector<int> visited( nodes_count, -1 );
+
+    const size_t aligned = alignedTicks();
+    for (size_t tick = 0; tick < aligned; tick++)
+    {
+        summarize( a, _ticks_a[tick], nodes_a, touched_a );
+        summarize( b, _ticks_b[tick], nodes_b, touched_b );
+        _mean_tick_a += duration( a, _ticks_a[tick] );
+        _mean_tick_b += duration( b, _ticks_b[tick] );
+
+        // the nodes active in at least one of the two ticks
+        for (const std::vector<int>* touched: {&touched_a, &touched_b} )
+        {
+            for (int index: *touched)
+            {
+                if( visited[index] == int(tick) )
+                {
+                    continue;
+                }
+                visited[index] = int(tick);
+
+                const NodeTick& node_a = nodes_a[index];
+                const NodeTick& node_b = nodes_b[index];
+                NodeComparison& result = _nodes[index];
+                const double delta = node_b.running_time - node_a.running_time;
+
+                result.ticks++;
+                sum_delta[index] += delta;
+                result.max_delta = std::max( result.max_delta, std::abs(delta) );
+
+                bool divergent = false;
+                if( node_a.result != node_b.result )
+                {
+                    result.outcome_mismatches++;
+                    divergent = true;
+                }
+                if( std::abs(delta) > time_tolerance )
+                {
+                    result.timing_mismatches++;
+                    divergent = true;
+                }
+                if( divergent && result.first_divergent_tick < 0 )
+                {
+                    result.first_divergent_tick = int(tick);
+                }
+            }
+        }
+    }
+
+    for (size_t index = 0; index < nodes_count; index++)
+    {
+        if( _nodes[index].ticks > 0 )
+        {
+            _nodes[index].mean_delta = sum_delta[index] / _nodes[index].ticks;
+        }
+    }
+    if( aligned > 0 )
+    {
+        _mean_tick_a /= aligned;
+        _mean_tick_b /= aligned;
+    }
+}
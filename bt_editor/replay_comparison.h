@@ -0,0 +1,85 @@
+#ifndef REPLAY_COMPARISON_H
+#define REPLAY_COMPARISON_H
+
+#include <vector>
+#include <algorithm>
+#include <QString>
+#include "bt_editor_base.h"
+#include "replay_transitions.h"
+
+// Decode a whole log (.fbl or .fblz) in memory, in the calling thread.
+// The restarts of the tree are detected with the rule of SidepanelReplay.
+// Return false and set error_message if the log is not valid.
+bool DecodeReplayLog(const char* buffer, size_t size,
+                     AbsBehaviorTree& tree, ReplayTransitions& transitions,
+                     QString& error_message);
+
+// true if the two trees have the same nodes, in the same order
+bool SameTreeStructure(const AbsBehaviorTree& a, const AbsBehaviorTree& b);
+
+struct NodeComparison
+{
+    int ticks = 0;                // ticks in which the node was active in A or B
+    int outcome_mismatches = 0;   // ticks with a different result (SUCCESS/FAILURE)
+    int timing_mismatches = 0;    // ticks with |RUNNING time of B - A| > tolerance
+    double mean_delta = 0;        // mean of (RUNNING time of B - A), seconds
+    double max_delta = 0;         // largest |RUNNING time of B - A|
+    int first_divergent_tick = -1;
+
+    bool diverges() const { return outcome_mismatches > 0 || timing_mismatches > 0; }
+};
+
+// Compare two logs of the same tree, aligned per tick: the transitions
+// between two restarts of the tree. Tick N of A is compared with tick N of B.
+// The RUNNING time of a node is measured like in NodeTimingAccumulator.
+class ReplayComparison
+{
+public:
+    // the rows [first_row, last_row) of a tick
+    struct Tick
+    {
+        size_t first_row;
+        size_t last_row;
+    };
+
+    static std::vector<Tick> ticks(const ReplayTransitions& transitions);
+
+    void compare(const ReplayTransitions& a, const ReplayTransitions& b,
+                 size_t nodes_count, double time_tolerance);
+
+    const std::vector<NodeComparison>& nodes() const { return _nodes; }
+
+    const std::vector<Tick>& ticksA() const { return _ticks_a; }
+    const std::vector<Tick>& ticksB() const { return _ticks_b; }
+
+    size_t alignedTicks() const { return std::min( _ticks_a.size(), _ticks_b.size() ); }
+
+    // mean duration of the aligned ticks, seconds
+    double meanTickDurationA() const { return _mean_tick_a; }
+    double meanTickDurationB() const { return _mean_tick_b; }
+
+private:
+
+    // what a node did in a single tick
+    struct NodeTick
+    {
+        bool active = false;
+        NodeStatus result = NodeStatus::IDLE;
+        double running_time = 0;
+        double running_since = -1;
+    };
+
+    // nodes is cleared only at the entries listed in touched
+    static void summarize(const ReplayTransitions& transitions, const Tick& tick,
+                          std::vector<NodeTick>& nodes, std::vector<int>& touched);
+
+    static double duration(const ReplayTransitions& transitions, const Tick& tick);
+
+    std::vector<NodeComparison> _nodes;
+    std::vector<Tick> _ticks_a;
+    std::vector<Tick> _ticks_b;
+    double _mean_tick_a = 0;
+    double _mean_tick_b = 0;
+};
+
+#endif // REPLAY_COMPARISON_H
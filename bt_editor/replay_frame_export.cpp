@@ -0,0 +1,394 @@
+#include "replay_frame_export.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QPainter>
+#include <QProcess>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <nodes/Node>
+#include <nodes/NodeDataModel>
+#include <nodes/NodeStyle>
+
+#include "graphic_container.h"
+#include "mainwindow.h"
+#include "replay_log_analyzer.h"
+#include "trace_recorder.h"
+#include "utils.h"
+
+bool FrameExportOptions::isVideo(const QString &output)
+{
+    const QString suffix = QFileInfo( output ).suffix().toLower();
+    return suffix == "mp4" || suffix == "mkv" || suffix == "webm" ||
+           suffix == "mov" || suffix == "avi" || suffix == "gif";
+}
+
+SceneSnapshot SceneSnapshot::capture(GraphicContainer &container, double scale)
+{
+    TraceScope trace( "replay", "captureScene" );
+    SceneSnapshot snapshot;
+    QtNodes::FlowScene* scene = container.scene();
+
+    container.resetNodeStatusStyles();
+    scene->clearSelection();
+    // the widgets of all the nodes are drawn, not only those of the view
+    const bool virtualized = scene->virtualized();
+    scene->setVirtualized( false );
+
+    const QRectF source = scene->itemsBoundingRect().adjusted( -20, -20, 20, 20 );
+    // even sizes, as most of the video encoders require
+    const int width  = ( int( std::ceil( source.width()  * scale ) ) + 1 ) & ~1;
+    const int height = ( int( std::ceil( source.height() * scale ) ) + 1 ) & ~1;
+
+    snapshot._base = QImage( width, height, QImage::Format_RGB32 );
+    snapshot._base.fill( container.view()->backgroundBrush().color() );
+    {
+        QPainter painter( &snapshot._base );
+        painter.setRenderHint( QPainter::Antialiasing );
+        painter.setRenderHint( QPainter::TextAntialiasing );
+        scene->render( &painter, QRectF( 0, 0, width, height ), source, Qt::IgnoreAspectRatio );
+    }
+    scene->setVirtualized( virtualized );
+
+    // the boundary of a node as NodePainter draws it
+    const auto& nodes = container.nodesByIndex();
+    snapshot._boundaries.resize( nodes.size() );
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        const QtNodes::Node* node = nodes[index];
+        if( !node )
+        {
+            continue;
+        }
+        const QtNodes::NodeGeometry& geometry = node->nodeGeometry();
+        const double diameter = node->nodeDataModel()->nodeStyle().ConnectionPointDiameter;
+        const QPointF position = node->nodeGraphicsObject().pos();
+        const QRectF boundary( position.x() - diameter, position.y() - diameter,
+                               geometry.width() + 2 * diameter, geometry.height() + 2 * diameter );
+        snapshot._boundaries[index] = QRectF( ( boundary.topLeft() - source.topLeft() ) * scale,
+                                              boundary.size() * scale );
+    }
+
+    // the pens are made here: the styles can't be built in other threads
+    for (int status = 0; status < 4; status++)
+    {
+        const auto& style = getStyleFromStatus( static_cast<NodeStatus>(status), NodeStatus::IDLE ).first;
+        snapshot._pens[status] = QPen( style.NormalBoundaryColor, style.PenWidth * scale );
+    }
+    snapshot._radius = 3.0 * scale;
+    return snapshot;
+}
+
+QImage SceneSnapshot::render(const std::vector<NodeStatus> &status) const
+{
+    QImage image = _base.copy();
+    QPainter painter( &image );
+    painter.setRenderHint( QPainter::Antialiasing );
+    painter.setBrush( Qt::NoBrush );
+
+    const size_t count = std::min( status.size(), _boundaries.size() );
+    for (size_t index = 0; index < count; index++)
+    {
+        const int value = int( status[index] );
+        if( value <= 0 || value >= 4 || _boundaries[index].isNull() )
+        {
+            continue;
+        }
+        painter.setPen( _pens[value] );
+        painter.drawRoundedRect( _boundaries[index], _radius, _radius );
+    }
+    return image;
+}
+
+namespace
+{
+
+// The status of the tree at increasing times, as SidepanelReplay computes it
+class StatusCursor
+{
+public:
+    StatusCursor(const ReplayTransitions& transitions, size_t nodes_count):
+        _transitions(transitions),
+        _status( nodes_count, NodeStatus::IDLE ),
+        _next_row(0),
+        _next_restart(0)
+    {}
+
+    const std::vector<NodeStatus>& advance(double timestamp)
+    {
+        const auto& restarts = _transitions.restarts();
+        while( _next_row < _transitions.size() && _transitions.timestamp(_next_row) <= timestamp )
+        {
+            while( _next_restart < restarts.size() && size_t(restarts[_next_restart]) < _next_row )
+            {
+                _next_restart++;
+            }
+            if( _next_restart < restarts.size() && size_t(restarts[_next_restart]) == _next_row )
+            {
+                std::fill( _status.begin(), _status.end(), NodeStatus::IDLE );
+            }
+            const size_t index = size_t( _transitions.index(_next_row) );
+            if( index < _status.size() )
+            {
+                _status[index] = _transitions.status(_next_row);
+            }
+            _next_row++;
+        }
+        return _status;
+    }
+
+private:
+    const ReplayTransitions& _transitions;
+    std::vector<NodeStatus> _status;
+    size_t _next_row;
+    size_t _next_restart;
+};
+
+// the raw pixels for ffmpeg, or a PNG file
+QByteArray EncodeFrame(const QImage& image, bool raw)
+{
+    if( raw )
+    {
+        return QByteArray( reinterpret_cast<const char*>( image.constBits() ),
+                           image.bytesPerLine() * image.height() );
+    }
+    QByteArray png;
+    QBuffer buffer( &png );
+    buffer.open( QIODevice::WriteOnly );
+    image.save( &buffer, "PNG" );
+    return png;
+}
+
+} // end namespace
+
+QString ExportReplayFrames(const SceneSnapshot &snapshot,
+                           const ReplayTransitions &transitions,
+                           const FrameExportOptions &options,
+                           const std::function<bool (int, int)> &progress)
+{
+    if( snapshot.isNull() || transitions.empty() )
+    {
+        return "There is no tree or no transition to export";
+    }
+    if( options.fps <= 0 || options.speed <= 0 )
+    {
+        return "The frame rate and the speed must be positive";
+    }
+    TraceScope trace( "replay", "exportFrames" );
+
+    const double first_timestamp = transitions.timestamp(0);
+    const double duration = transitions.timestamp( transitions.size() - 1 ) - first_timestamp;
+    const double begin = std::max( 0.0, options.begin );
+    const double end = ( options.end > begin ) ? std::min( options.end, duration ) : duration;
+    if( begin > end )
+    {
+        return "The range of the export is after the end of the log";
+    }
+    const double frame_step = options.speed / options.fps;
+    const int total = int( std::floor( ( end - begin ) / frame_step ) ) + 1;
+    trace.setArgument( "frames", total );
+
+    const bool video = FrameExportOptions::isVideo( options.output );
+    QProcess encoder;
+    if( video )
+    {
+        QStringList arguments;
+        arguments << "-y" << "-loglevel" << "error"
+                  << "-f" << "rawvideo"
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+                  << "-pix_fmt" << "bgra"
+#else
+                  << "-pix_fmt" << "argb"
+#endif
+                  << "-s" << QString("%1x%2").arg( snapshot.size().width() ).arg( snapshot.size().height() )
+                  << "-framerate" << QString::number( options.fps )
+                  << "-i" << "-";
+        if( !options.output.endsWith( ".gif", Qt::CaseInsensitive ) )
+        {
+            arguments << "-pix_fmt" << "yuv420p";
+        }
+        arguments << options.output;
+        encoder.start( options.ffmpeg, arguments );
+        if( !encoder.waitForStarted() )
+        {
+            return QString("Can not start %1: %2. Export the frames to a directory instead")
+                    .arg( options.ffmpeg, encoder.errorString() );
+        }
+    }
+    else if( !QDir().mkpath( options.output ) )
+    {
+        return QString("Can not create the directory %1").arg( options.output );
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount( options.threads > 0 ? options.threads : QThread::idealThreadCount() );
+    // the frames painted and encoded ahead of the one written
+    const int window = pool.maxThreadCount() * 2;
+
+    StatusCursor cursor( transitions, snapshot.nodesCount() );
+    std::deque<QFuture<QByteArray>> pending;
+    int next_frame = 0;
+    int written = 0;
+    QString error;
+
+    while( written < total && error.isEmpty() )
+    {
+        while( next_frame < total && int(pending.size()) < window )
+        {
+            const std::vector<NodeStatus> status =
+                    cursor.advance( first_timestamp + begin + next_frame * frame_step );
+            const SceneSnapshot* source = &snapshot;
+            pending.push_back( QtConcurrent::run( &pool, [source, status, video]()
+            {
+                return EncodeFrame( source->render( status ), video );
+            }) );
+            next_frame++;
+        }
+
+        const QByteArray frame = pending.front().result();
+        pending.pop_front();
+
+        if( video )
+        {
+            encoder.write( frame );
+            while( encoder.bytesToWrite() > 0 && encoder.state() == QProcess::Running )
+            {
+                encoder.waitForBytesWritten( 1000 );
+            }
+            if( encoder.state() != QProcess::Running )
+            {
+                error = QString("%1 stopped: %2").arg( options.ffmpeg,
+                                                       QString::fromLocal8Bit( encoder.readAllStandardError() ) );
+            }
+        }
+        else{
+            QFile file( QDir( options.output ).filePath( QString("frame_%1.png").arg( written, 6, 10, QChar('0') ) ) );
+            if( !file.open( QIODevice::WriteOnly ) || file.write( frame ) != frame.size() )
+            {
+                error = QString("Can not write %1: %2").arg( file.fileName(), file.errorString() );
+            }
+        }
+        written++;
+
+        if( error.isEmpty() && progress && !progress( written, total ) )
+        {
+            break;
+        }
+    }
+
+    for (auto& future: pending)
+    {
+        future.waitForFinished();
+    }
+    if( video )
+    {
+        encoder.closeWriteChannel();
+        encoder.waitForFinished( -1 );
+        if( error.isEmpty() && ( encoder.exitStatus() != QProcess::NormalExit || encoder.exitCode() != 0 ) )
+        {
+            error = QString("%1 failed: %2").arg( options.ffmpeg,
+                                                  QString::fromLocal8Bit( encoder.readAllStandardError() ) );
+        }
+    }
+    return error;
+}
+
+int RunReplayExport(QApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Groot replay export: the frames of a log, without any window");
+    parser.addHelpOption();
+
+    QCommandLineOption export_option(QStringList() << "export-replay",
+                                     "Export the log passed as argument");
+    parser.addOption(export_option);
+    QCommandLineOption fps_option(QStringList() << "fps",
+                                  "Frames per second (defaults to 10)", "fps", "10");
+    parser.addOption(fps_option);
+    QCommandLineOption speed_option(QStringList() << "speed",
+                                    "Seconds of the log in a second of the output (defaults to 1)",
+                                    "speed", "1");
+    parser.addOption(speed_option);
+    QCommandLineOption scale_option(QStringList() << "scale",
+                                    "Size of the tree in the images (defaults to 1)", "scale", "1");
+    parser.addOption(scale_option);
+    QCommandLineOption from_option(QStringList() << "from",
+                                   "First second of the log (defaults to 0)", "seconds", "0");
+    parser.addOption(from_option);
+    QCommandLineOption to_option(QStringList() << "to",
+                                 "Last second of the log (defaults to the end)", "seconds", "0");
+    parser.addOption(to_option);
+    QCommandLineOption threads_option(QStringList() << "threads",
+                                      "Threads drawing the frames (defaults to the cores)", "threads", "0");
+    parser.addOption(threads_option);
+    parser.addPositionalArgument("log", "The log file (*.fbl *.fblz)");
+    parser.addPositionalArgument("output", "A video file (*.mp4 *.webm *.gif...) encoded by ffmpeg, "
+                                           "or a directory of PNG files");
+
+    parser.process( app );
+
+    const QStringList arguments = parser.positionalArguments();
+    if( arguments.size() != 2 )
+    {
+        std::cerr << "--export-replay needs a log and an output" << std::endl;
+        return 1;
+    }
+
+    FrameExportOptions options;
+    options.output  = arguments[1];
+    options.fps     = parser.value(fps_option).toDouble();
+    options.speed   = parser.value(speed_option).toDouble();
+    options.scale   = parser.value(scale_option).toDouble();
+    options.begin   = parser.value(from_option).toDouble();
+    options.end     = parser.value(to_option).toDouble();
+    options.threads = parser.value(threads_option).toInt();
+    if( options.fps <= 0 || options.speed <= 0 || options.scale <= 0 )
+    {
+        std::cerr << "--fps, --speed and --scale must be positive" << std::endl;
+        return 1;
+    }
+
+    // checked first: the replay panel reports a corrupt log with a dialog
+    const ReplayLogAnalysis analysis = AnalyzeReplayLog( arguments[0] );
+    if( !analysis.error.isEmpty() )
+    {
+        std::cerr << arguments[0].toStdString() << ": error: "
+                  << analysis.error.toStdString() << std::endl;
+        return 1;
+    }
+
+    MainWindow win( GraphicMode::REPLAY );
+    if( !win.loadReplayLog( arguments[0] ) )
+    {
+        std::cerr << arguments[0].toStdString() << ": error: no transition to export" << std::endl;
+        return 1;
+    }
+
+    int last_percent = -1;
+    const QString error = win.exportReplayFrames( options, [&last_percent](int done, int total)
+    {
+        const int percent = ( 100 * done ) / total;
+        if( percent != last_percent )
+        {
+            std::cout << "\r" << done << "/" << total << " frames" << std::flush;
+            last_percent = percent;
+        }
+        return true;
+    });
+    std::cout << std::endl;
+    if( !error.isEmpty() )
+    {
+        std::cerr << "error: " << error.toStdString() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef REPLAY_FRAME_EXPORT_H
+#define REPLAY_FRAME_EXPORT_H
+
+#include <array>
+#include <functional>
+#include <vector>
+#include <QApplication>
+#include <QImage>
+#include <QPen>
+#include <QString>
+#include "bt_editor_base.h"
+#include "replay_transitions.h"
+
+class GraphicContainer;
+
+// The options of ExportReplayFrames()
+struct FrameExportOptions
+{
+    // a directory of PNG files, or a video file encoded by ffmpeg (see isVideo)
+    QString output;
+    // frames per second of the output
+    double fps = 10.0;
+    // seconds of the log in a second of the output: 10 is ten times faster
+    double speed = 1.0;
+    // pixels per unit of the scene
+    double scale = 1.0;
+    // seconds since the first transition. The whole log if end <= begin
+    double begin = 0.0;
+    double end = 0.0;
+    // 0: QThread::idealThreadCount()
+    int threads = 0;
+    QString ffmpeg = "ffmpeg";
+
+    // .mp4, .mkv, .webm, .mov, .avi or .gif
+    static bool isVideo(const QString& output);
+};
+
+// A tree drawn once, to paint the status of many frames on copies of it in
+// any thread: the scene itself (and its widgets) can be used only by the GUI
+// thread. A frame shows the boundaries of the nodes that are not IDLE, as the
+// scene does.
+class SceneSnapshot
+{
+public:
+    // The scene of the container with the default style of all its nodes
+    // (their status is reset). GUI thread only
+    static SceneSnapshot capture(GraphicContainer& container, double scale);
+
+    bool isNull() const { return _base.isNull(); }
+
+    QSize size() const { return _base.size(); }
+
+    // by index of the tree, as in the changeNodeStyle signals
+    size_t nodesCount() const { return _boundaries.size(); }
+
+    // any thread
+    QImage render(const std::vector<NodeStatus>& status) const;
+
+private:
+    QImage _base;
+    // in pixels, by index. Null for the nodes of the collapsed branches
+    std::vector<QRectF> _boundaries;
+    // by status
+    std::array<QPen, 4> _pens;
+    double _radius = 0;
+};
+
+// The frames of a replay: one every options.speed / options.fps seconds of
+// the log, with the status of the tree after the transitions before it.
+//
+// The status of each frame is computed here, in order, while a pool of
+// options.threads paints and encodes the following ones. The frames are
+// written in order: "frame_000000.png"... into the directory, or piped as
+// raw images to ffmpeg. progress( done, total ) is called after each frame,
+// the export stops if it returns false (the frames written are kept).
+// Returns the error, empty if it succeeded
+QString ExportReplayFrames(const SceneSnapshot& snapshot,
+                           const ReplayTransitions& transitions,
+                           const FrameExportOptions& options,
+                           const std::function<bool(int, int)>& progress);
+
+// groot --export-replay [--fps <n>] [--speed <n>] [--scale <n>] [--from <s>]
+//                       [--to <s>] [--threads <n>] log output
+//
+// The frames of the log, see ExportReplayFrames(), without any window: the
+// tree is drawn offscreen. Returns 1 if the log can not be read or the
+// frames written.
+int RunReplayExport(QApplication& app);
+
+#endif // REPLAY_FRAME_EXPORT_H
@@ -0,0 +1,177 @@
+#include "replay_log_analyzer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include "replay_log_reader.h"
+
+ReplayLogAnalysis AnalyzeReplayLog(const QString &filename)
+{
+    ReplayLogAnalysis analysis;
+    analysis.filename = filename;
+
+    QFile file( filename );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        analysis.error = file.errorString();
+        return analysis;
+    }
+    // as SidepanelReplay::loadLogFile(): mapped, or read if it can't be
+    QByteArray content;
+    const char* buffer = nullptr;
+    const qint64 file_size = file.size();
+    uchar* mapped = file_size > 0 ? file.map( 0, file_size ) : nullptr;
+    if( mapped )
+    {
+        buffer = reinterpret_cast<const char*>( mapped );
+    }
+    else{
+        content = file.readAll();
+        buffer = content.constData();
+    }
+    const size_t size = mapped ? size_t(file_size) : size_t(content.size());
+
+    ReplayLogReader reader;
+    if( reader.open( buffer, size, analysis.error ) )
+    {
+        analysis.tree = reader.tree();
+
+        NodeTimingAccumulator accumulator;
+        accumulator.reset( analysis.tree.nodesCount() );
+        double first_timestamp = 0;
+        double last_timestamp = 0;
+        reader.read( [&](const ReplayTransition& transition)
+        {
+            if( analysis.transitions == 0 )
+            {
+                first_timestamp = transition.timestamp;
+            }
+            last_timestamp = transition.timestamp;
+            analysis.transitions++;
+            analysis.ticks += transition.is_tree_restart ? 1 : 0;
+            accumulator.add( transition.index, transition.prev_status,
+                             transition.status, transition.timestamp );
+        }, analysis.error );
+
+        analysis.nodes = accumulator.statistics();
+        analysis.duration = last_timestamp - first_timestamp;
+    }
+
+    if( mapped )
+    {
+        file.unmap( mapped );
+    }
+    return analysis;
+}
+
+static QString CsvField(const QString& text)
+{
+    if( !text.contains(',') && !text.contains('"') && !text.contains('\n') )
+    {
+        return text;
+    }
+    QString quoted = text;
+    quoted.replace( "\"", "\"\"" );
+    return "\"" + quoted + "\"";
+}
+
+static QString Number(double value)
+{
+    return QString::number( value, 'g', 9 );
+}
+
+QByteArray ReplayLogAnalysisToCsv(const std::vector<ReplayLogAnalysis> &logs)
+{
+    QStringList lines;
+    lines.push_back( "file,transitions,ticks,duration,tick_rate,"
+                     "node_index,node_name,node_ID,executions,success,failure,"
+                     "running_count,running_min,running_mean,running_p50,running_p90,"
+                     "running_p99,running_max" );
+
+    for (const auto& log: logs)
+    {
+        if( !log.error.isEmpty() )
+        {
+            continue;
+        }
+        const QString log_fields = QString("%1,%2,%3,%4,%5")
+                .arg( CsvField( log.filename ) )
+                .arg( log.transitions )
+                .arg( log.ticks )
+                .arg( Number( log.duration ) )
+                .arg( Number( log.tickRate() ) );
+
+        for (size_t index = 0; index < log.nodes.size() && index < log.tree.nodesCount(); index++)
+        {
+            const NodeTimingStatistics& stats = log.nodes[index];
+            const AbstractTreeNode* node = log.tree.node(index);
+            QStringList fields;
+            fields << log_fields
+                   << QString::number( index )
+                   << CsvField( node->instance_name )
+                   << CsvField( node->model.registration_ID )
+                   << QString::number( stats.executions )
+                   << QString::number( stats.success )
+                   << QString::number( stats.failure )
+                   << QString::number( stats.running_count )
+                   << Number( stats.running_min )
+                   << Number( stats.running_mean )
+                   << Number( stats.running_p50 )
+                   << Number( stats.running_p90 )
+                   << Number( stats.running_p99 )
+                   << Number( stats.running_max );
+            lines.push_back( fields.join(",") );
+        }
+    }
+    return ( lines.join("\n") + "\n" ).toUtf8();
+}
+
+QByteArray ReplayLogAnalysisToJson(const std::vector<ReplayLogAnalysis> &logs)
+{
+    QJsonArray logs_array;
+    for (const auto& log: logs)
+    {
+        QJsonObject log_object;
+        log_object["file"] = log.filename;
+        if( !log.error.isEmpty() )
+        {
+            log_object["error"] = log.error;
+            logs_array.append( log_object );
+            continue;
+        }
+        log_object["transitions"] = double( log.transitions );
+        log_object["ticks"] = double( log.ticks );
+        log_object["duration"] = log.duration;
+        log_object["tick_rate"] = log.tickRate();
+
+        QJsonArray nodes_array;
+        for (size_t index = 0; index < log.nodes.size() && index < log.tree.nodesCount(); index++)
+        {
+            const NodeTimingStatistics& stats = log.nodes[index];
+            const AbstractTreeNode* node = log.tree.node(index);
+            QJsonObject node_object;
+            node_object["index"] = int(index);
+            node_object["name"] = node->instance_name;
+            node_object["ID"] = node->model.registration_ID;
+            node_object["executions"] = stats.executions;
+            node_object["success"] = stats.success;
+            node_object["failure"] = stats.failure;
+            node_object["running_count"] = stats.running_count;
+            node_object["running_min"] = stats.running_min;
+            node_object["running_mean"] = stats.running_mean;
+            node_object["running_p50"] = stats.running_p50;
+            node_object["running_p90"] = stats.running_p90;
+            node_object["running_p99"] = stats.running_p99;
+            node_object["running_max"] = stats.running_max;
+            nodes_array.append( node_object );
+        }
+        log_object["nodes"] = nodes_array;
+        logs_array.append( log_object );
+    }
+
+    QJsonObject root;
+    root["logs"] = logs_array;
+    return QJsonDocument( root ).toJson( QJsonDocument::Indented );
+}
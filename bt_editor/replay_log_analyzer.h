@@ -0,0 +1,41 @@
+#ifndef REPLAY_LOG_ANALYZER_H
+#define REPLAY_LOG_ANALYZER_H
+
+#include <vector>
+#include <QByteArray>
+#include <QString>
+#include "bt_editor_base.h"
+#include "replay_statistics.h"
+
+// The statistics of a whole log file, computed in a single pass while its
+// transitions are read (see ReplayLogReader), without keeping them.
+struct ReplayLogAnalysis
+{
+    ReplayLogAnalysis(): transitions(0), ticks(0), duration(0) {}
+
+    QString filename;
+    // empty if the log was read
+    QString error;
+    AbsBehaviorTree tree;
+    // by index of the node in the tree
+    std::vector<NodeTimingStatistics> nodes;
+    size_t transitions;
+    // the restarts of the tree
+    size_t ticks;
+    // seconds between the first and the last transition
+    double duration;
+
+    double tickRate() const { return duration > 0 ? ticks / duration : 0; }
+};
+
+// The file is memory-mapped if possible. Any thread.
+ReplayLogAnalysis AnalyzeReplayLog(const QString& filename);
+
+// one line per node of each log read, with the columns of the log repeated
+QByteArray ReplayLogAnalysisToCsv(const std::vector<ReplayLogAnalysis>& logs);
+
+// { "logs": [ { "file", "error" or "transitions", "ticks", "duration",
+//               "tick_rate", "nodes": [...] } ] }
+QByteArray ReplayLogAnalysisToJson(const std::vector<ReplayLogAnalysis>& logs);
+
+#endif // REPLAY_LOG_ANALYZER_H
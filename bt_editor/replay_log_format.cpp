@@ -0,0 +1,154 @@
+#include "replay_log_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <behaviortree_cpp_v3/flatbuffers/flatbuffers.h>
+
+namespace ReplayLogFormat
+{
+
+static const char BLOCKS_MAGIC[8] = {'G','R','B','L','O','C','K','S'};
+static const uint32_t BLOCKS_VERSION = 1;
+static const size_t PREFIX_SIZE = 8 + 4 + 4;
+static const size_t INDEX_ENTRY_SIZE = 8 + 4 + 4 + 4 + 4;
+
+template <typename T> static void append(QByteArray& data, T value)
+{
+    T little_endian = flatbuffers::EndianScalar(value);
+    data.append( reinterpret_cast<const char*>(&little_endian), sizeof(T) );
+}
+
+bool isCompressed(const char *buffer, size_t size, size_t transitions_offset)
+{
+    // the magic can't be a valid record: "OCKS" is not a valid amount of microseconds
+    return size >= transitions_offset + PREFIX_SIZE &&
+           std::memcmp( buffer + transitions_offset, BLOCKS_MAGIC, 8 ) == 0;
+}
+
+bool readBlockIndex(const char *buffer, size_t size, size_t transitions_offset,
+                    std::vector<BlockInfo> &blocks)
+{
+    blocks.clear();
+    if( !isCompressed(buffer, size, transitions_offset) )
+    {
+        return false;
+    }
+    const char* ptr = buffer + transitions_offset + 8;
+    const uint32_t version      = flatbuffers::ReadScalar<uint32_t>( ptr );
+    const uint32_t blocks_count = flatbuffers::ReadScalar<uint32_t>( ptr + 4 );
+    ptr += 8;
+
+    const size_t index_end = transitions_offset + PREFIX_SIZE + size_t(blocks_count) * INDEX_ENTRY_SIZE;
+    if( version != BLOCKS_VERSION || index_end > size )
+    {
+        return false;
+    }
+
+    blocks.reserve( blocks_count );
+    for (uint32_t i = 0; i < blocks_count; i++, ptr += INDEX_ENTRY_SIZE)
+    {
+        BlockInfo block;
+        block.offset          = flatbuffers::ReadScalar<uint64_t>( ptr );
+        block.compressed_size = flatbuffers::ReadScalar<uint32_t>( ptr + 8 );
+        block.records_count   = flatbuffers::ReadScalar<uint32_t>( ptr + 12 );
+        const double t_sec    = flatbuffers::ReadScalar<uint32_t>( ptr + 16 );
+        const double t_usec   = flatbuffers::ReadScalar<uint32_t>( ptr + 20 );
+        block.first_timestamp = t_sec + t_usec* 0.000001;
+
+        if( block.offset < index_end || block.offset + block.compressed_size > size )
+        {
+            blocks.clear();
+            return false;
+        }
+        blocks.push_back( block );
+    }
+    return true;
+}
+
+QByteArray decompressBlock(const char *buffer, size_t size, const BlockInfo &block)
+{
+    if( block.offset + block.compressed_size > size )
+    {
+        return QByteArray();
+    }
+    QByteArray data = qUncompress( reinterpret_cast<const uchar*>(buffer + block.offset),
+                                   int(block.compressed_size) );
+    if( size_t(data.size()) != size_t(block.records_count) * RECORD_SIZE )
+    {
+        return QByteArray();
+    }
+    if( block.records_count > 0 )
+    {
+        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( data.constData() );
+        const double t_usec = flatbuffers::ReadScalar<uint32_t>( data.constData() + 4 );
+        if( t_sec + t_usec* 0.000001 != block.first_timestamp )
+        {
+            return QByteArray();
+        }
+    }
+    return data;
+}
+
+void appendRecord(QByteArray &data, int64_t timestamp_usec, uint16_t uid,
+                  uint8_t prev_status, uint8_t status)
+{
+    append<uint32_t>( data, uint32_t( timestamp_usec / 1000000 ) );
+    append<uint32_t>( data, uint32_t( timestamp_usec % 1000000 ) );
+    append<uint16_t>( data, uid );
+    data.append( char(prev_status) );
+    data.append( char(status) );
+}
+
+QByteArray compressLog(const char *buffer, size_t size,
+                       size_t records_per_block, int compression_level)
+{
+    if( size < 4 )
+    {
+        return QByteArray();
+    }
+    const size_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
+    const size_t transitions_offset = 4 + header_size;
+    if( transitions_offset > size || isCompressed(buffer, size, transitions_offset) )
+    {
+        return QByteArray();
+    }
+    records_per_block = std::max<size_t>( 1, records_per_block );
+
+    const size_t records_count = (size - transitions_offset) / RECORD_SIZE;
+    const size_t blocks_count  = (records_count + records_per_block - 1) / records_per_block;
+
+    std::vector<QByteArray> compressed_blocks;
+    compressed_blocks.reserve( blocks_count );
+    for (size_t b = 0; b < blocks_count; b++)
+    {
+        const size_t first = b * records_per_block;
+        const size_t count = std::min( records_per_block, records_count - first );
+        compressed_blocks.push_back(
+                    qCompress( reinterpret_cast<const uchar*>(buffer + transitions_offset + first * RECORD_SIZE),
+                               int(count * RECORD_SIZE), compression_level ) );
+    }
+
+    QByteArray output( buffer, int(transitions_offset) );
+    output.append( BLOCKS_MAGIC, 8 );
+    append<uint32_t>( output, BLOCKS_VERSION );
+    append<uint32_t>( output, uint32_t(blocks_count) );
+
+    uint64_t offset = transitions_offset + PREFIX_SIZE + blocks_count * INDEX_ENTRY_SIZE;
+    for (size_t b = 0; b < blocks_count; b++)
+    {
+        const char* first_record = buffer + transitions_offset + b * records_per_block * RECORD_SIZE;
+        append<uint64_t>( output, offset );
+        append<uint32_t>( output, uint32_t(compressed_blocks[b].size()) );
+        append<uint32_t>( output, uint32_t(std::min( records_per_block, records_count - b * records_per_block )) );
+        append<uint32_t>( output, flatbuffers::ReadScalar<uint32_t>( first_record ) );
+        append<uint32_t>( output, flatbuffers::ReadScalar<uint32_t>( first_record + 4 ) );
+        offset += compressed_blocks[b].size();
+    }
+    for (const auto& block: compressed_blocks)
+    {
+        output.append( block );
+    }
+    return output;
+}
+
+}
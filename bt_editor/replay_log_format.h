@@ -0,0 +1,62 @@
+#ifndef REPLAY_LOG_FORMAT_H
+#define REPLAY_LOG_FORMAT_H
+
+#include <cstdint>
+#include <vector>
+#include <QByteArray>
+
+// Block-compressed variant of the .fbl format (.fblz).
+//
+//   uint32             size of the flatbuffers header (as in .fbl)
+//   [header]           flatbuffers BehaviorTree (as in .fbl)
+//   char[8]            "GRBLOCKS"
+//   uint32             version
+//   uint32             number of blocks
+//   [block index]      for each block: uint64 offset, uint32 compressed size,
+//                      uint32 number of records, uint32 t_sec and uint32 t_usec
+//                      of its first record
+//   [blocks]           12-byte records, compressed independently (qCompress)
+//
+// All the integers are little endian, like the rest of the .fbl file.
+//
+// The blocks can be decompressed independently, but the replay reads them
+// all when the log is loaded (one at the time): the timeline, the statistics
+// and the checkpoints need every transition. The format saves disk space, not
+// loading time.
+namespace ReplayLogFormat
+{
+
+struct BlockInfo
+{
+    uint64_t offset;
+    uint32_t compressed_size;
+    uint32_t records_count;
+    // of the first record, checked when the block is decompressed
+    double first_timestamp;
+};
+
+// size of a transition record, both in .fbl and .fblz
+const size_t RECORD_SIZE = 12;
+
+// true if the data following the header (transitions_offset) is block-compressed
+bool isCompressed(const char* buffer, size_t size, size_t transitions_offset);
+
+// read the block index. Return false if the index is corrupted
+bool readBlockIndex(const char* buffer, size_t size, size_t transitions_offset,
+                    std::vector<BlockInfo>& blocks);
+
+// decompress a single block. Empty if it fails, or if its first record
+// doesn't match the index
+QByteArray decompressBlock(const char* buffer, size_t size, const BlockInfo& block);
+
+// append a single record to data, in the .fbl layout
+void appendRecord(QByteArray& data, int64_t timestamp_usec, uint16_t uid,
+                  uint8_t prev_status, uint8_t status);
+
+// convert the content of a .fbl file (header + raw records) to .fblz
+QByteArray compressLog(const char* buffer, size_t size,
+                       size_t records_per_block = 65536, int compression_level = 3);
+
+}
+
+#endif // REPLAY_LOG_FORMAT_H
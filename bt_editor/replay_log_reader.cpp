@@ -0,0 +1,139 @@
+#include "replay_log_reader.h"
+#include "utils.h"
+
+ReplayLogReader::ReplayLogReader():
+    _buffer(nullptr),
+    _size(0),
+    _transitions_offset(0),
+    _compressed(false)
+{}
+
+bool ReplayLogReader::open(const char *buffer, size_t size, QString &error_message)
+{
+    _buffer = buffer;
+    _size = size;
+    _blocks.clear();
+    _compressed = false;
+
+    if( size < 4 )
+    {
+        error_message = "This Log file is empty";
+        return false;
+    }
+    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(buffer);
+    if( (bt_header_size == 0) || (bt_header_size > size - 4) )
+    {
+        error_message = "This Log file corrupted or truncated";
+        return false;
+    }
+
+    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(buffer+4), bt_header_size );
+    if( !Serialization::VerifyBehaviorTreeBuffer(verifier) )
+    {
+        error_message = "Its format is not compatible with the current one";
+        return false;
+    }
+
+    auto res_pair = BuildTreeFromFlatbuffers( Serialization::GetBehaviorTree( &buffer[4] ) );
+    _tree = res_pair.first;
+    _uid_to_index = res_pair.second;
+    _transitions_offset = 4 + bt_header_size;
+
+    _compressed = ReplayLogFormat::isCompressed( buffer, size, _transitions_offset );
+    if( _compressed && !ReplayLogFormat::readBlockIndex( buffer, size, _transitions_offset, _blocks ) )
+    {
+        error_message = "The index of the compressed blocks is corrupted or truncated";
+        return false;
+    }
+    return true;
+}
+
+size_t ReplayLogReader::transitionsCount() const
+{
+    if( !_compressed )
+    {
+        return (_size - _transitions_offset) / ReplayLogFormat::RECORD_SIZE;
+    }
+    size_t count = 0;
+    for (const auto& block: _blocks)
+    {
+        count += block.records_count;
+    }
+    return count;
+}
+
+bool ReplayLogReader::readRecords(const char *records, size_t begin, size_t end, ReadState &state,
+                                  const std::function<void (const ReplayTransition &)> &on_transition) const
+{
+    const int total_nodes = int(_tree.nodesCount());
+    for (size_t offset = begin; offset + ReplayLogFormat::RECORD_SIZE <= end;
+         offset += ReplayLogFormat::RECORD_SIZE)
+    {
+        ReplayTransition transition;
+        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &records[offset] );
+        const double t_usec = flatbuffers::ReadScalar<uint32_t>( &records[offset+4] );
+        transition.timestamp = t_sec + t_usec* 0.000001;
+
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&records[offset+8]);
+        const int index = _uid_to_index.find(uid);
+        if( index == UidLookupTable::INVALID_INDEX )
+        {
+            return false;
+        }
+        transition.index = index;
+        transition.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&records[offset+10] ));
+        transition.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&records[offset+11] ));
+
+        // same rule of SidepanelReplay::parseTransitions
+        transition.is_tree_restart = (transition.index == 1 &&
+                (transition.status == NodeStatus::RUNNING || transition.status == NodeStatus::IDLE) &&
+                state.idle_counter >= total_nodes - 1);
+        if( transition.is_tree_restart )
+        {
+            state.nearest_restart = state.parsed_count;
+        }
+
+        if(transition.prev_status != NodeStatus::IDLE && transition.status == NodeStatus::IDLE)
+            state.idle_counter++;
+        else if(transition.prev_status == NodeStatus::IDLE && transition.status != NodeStatus::IDLE)
+            state.idle_counter--;
+
+        transition.nearest_restart_transition_index = state.nearest_restart;
+        on_transition( transition );
+        state.parsed_count++;
+    }
+    return true;
+}
+
+bool ReplayLogReader::read(const std::function<void (const ReplayTransition &)> &on_transition,
+                           QString &error_message) const
+{
+    ReadState state;
+    state.idle_counter = int(_tree.nodesCount());
+    state.parsed_count = 0;
+    state.nearest_restart = 0;
+
+    bool valid = true;
+    if( _compressed )
+    {
+        for (const auto& block: _blocks)
+        {
+            const QByteArray records = ReplayLogFormat::decompressBlock( _buffer, _size, block );
+            valid = (!records.isEmpty() || block.records_count == 0) &&
+                    readRecords( records.constData(), 0, size_t(records.size()), state, on_transition );
+            if( !valid )
+            {
+                break;
+            }
+        }
+    }
+    else{
+        valid = readRecords( _buffer, _transitions_offset, _size, state, on_transition );
+    }
+
+    if( !valid )
+    {
+        error_message = "This Log file contains invalid transitions";
+    }
+    return valid;
+}
@@ -0,0 +1,55 @@
+#ifndef REPLAY_LOG_READER_H
+#define REPLAY_LOG_READER_H
+
+#include <functional>
+#include <vector>
+#include <QString>
+#include "bt_editor_base.h"
+#include "replay_log_format.h"
+#include "replay_transitions.h"
+
+// Reads a log (.fbl or .fblz) from memory without any widget, in the calling
+// thread: the header first, then the transitions streamed one at the time.
+// A compressed log is decompressed one block at the time. The restarts of
+// the tree are detected with the rule of SidepanelReplay.
+class ReplayLogReader
+{
+public:
+    ReplayLogReader();
+
+    // Check the header and build the tree. The buffer must stay valid while
+    // the transitions are read. Return false and set error_message if the
+    // log is not valid.
+    bool open(const char* buffer, size_t size, QString& error_message);
+
+    const AbsBehaviorTree& tree() const { return _tree; }
+
+    // as written in the header or in the index of the blocks
+    size_t transitionsCount() const;
+
+    // on_transition is called for each transition, in order. Return false and
+    // set error_message at the first one that is not valid
+    bool read(const std::function<void(const ReplayTransition&)>& on_transition,
+              QString& error_message) const;
+
+private:
+    struct ReadState
+    {
+        int idle_counter;
+        int parsed_count;
+        int nearest_restart;
+    };
+
+    bool readRecords(const char* records, size_t begin, size_t end, ReadState& state,
+                     const std::function<void(const ReplayTransition&)>& on_transition) const;
+
+    const char* _buffer;
+    size_t _size;
+    size_t _transitions_offset;
+    AbsBehaviorTree _tree;
+    UidLookupTable _uid_to_index;
+    bool _compressed;
+    std::vector<ReplayLogFormat::BlockInfo> _blocks;
+};
+
+#endif // REPLAY_LOG_READER_H
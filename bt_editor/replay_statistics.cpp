@@ -0,0 +1,121 @@
+#include "replay_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const int BUCKETS_PER_OCTAVE = 16;
+static const int HISTOGRAM_BUCKETS = 37 * BUCKETS_PER_OCTAVE;
+static const double MIN_DURATION = 1e-6;
+
+static int HistogramBucket(double duration)
+{
+    if( !(duration > MIN_DURATION) )
+    {
+        return 0;
+    }
+    const int bucket = static_cast<int>( std::log2( duration / MIN_DURATION ) * BUCKETS_PER_OCTAVE );
+    return std::min( bucket, HISTOGRAM_BUCKETS - 1 );
+}
+
+// the geometric middle of the bucket
+static double HistogramValue(int bucket)
+{
+    return MIN_DURATION * std::exp2( (bucket + 0.5) / BUCKETS_PER_OCTAVE );
+}
+
+void NodeTimingAccumulator::reset(size_t nodes_count)
+{
+    _nodes.clear();
+    _nodes.resize( nodes_count );
+}
+
+void NodeTimingAccumulator::add(int node_index, NodeStatus prev_status,
+                                NodeStatus status, double timestamp)
+{
+    if( node_index < 0 || node_index >= static_cast<int>(_nodes.size()) )
+    {
+        return;
+    }
+    NodeData& node = _nodes[node_index];
+
+    if( status == NodeStatus::SUCCESS )
+    {
+        node.success++;
+    }
+    else if( status == NodeStatus::FAILURE )
+    {
+        node.failure++;
+    }
+
+    if( prev_status == NodeStatus::RUNNING && node.running_since >= 0 )
+    {
+        const double duration = timestamp - node.running_since;
+        if( node.running_count == 0 )
+        {
+            node.running_min = duration;
+            node.running_max = duration;
+            node.histogram.assign( HISTOGRAM_BUCKETS, 0 );
+        }
+        node.running_min = std::min( node.running_min, duration );
+        node.running_max = std::max( node.running_max, duration );
+        node.running_sum += duration;
+        node.running_count++;
+        node.histogram[ HistogramBucket( duration ) ]++;
+    }
+    node.running_since = (status == NodeStatus::RUNNING) ? timestamp : -1;
+}
+
+void NodeTimingAccumulator::add(const ReplayTransitions &transitions,
+                                size_t first_row, size_t last_row)
+{
+    last_row = std::min( last_row, transitions.size() );
+    for (size_t row = first_row; row < last_row; row++)
+    {
+        add( transitions.index(row), transitions.prevStatus(row),
+             transitions.status(row), transitions.timestamp(row) );
+    }
+}
+
+std::vector<NodeTimingStatistics> NodeTimingAccumulator::statistics() const
+{
+    std::vector<NodeTimingStatistics> result( _nodes.size() );
+
+    for (size_t i=0; i < _nodes.size(); i++)
+    {
+        const NodeData& node = _nodes[i];
+        NodeTimingStatistics& stats = result[i];
+        stats.success = node.success;
+        stats.failure = node.failure;
+        stats.executions = node.success + node.failure;
+        stats.running_count = node.running_count;
+
+        if( node.running_count == 0 )
+        {
+            continue;
+        }
+        stats.running_min  = node.running_min;
+        stats.running_max  = node.running_max;
+        stats.running_mean = node.running_sum / node.running_count;
+
+        // nearest rank, within the exact range
+        auto percentile = [&node](double fraction) -> double
+        {
+            const uint64_t rank = std::max<uint64_t>( 1, static_cast<uint64_t>( std::ceil( fraction * node.running_count ) ) );
+            uint64_t count = 0;
+            int bucket = 0;
+            for (; bucket < HISTOGRAM_BUCKETS - 1; bucket++)
+            {
+                count += node.histogram[bucket];
+                if( count >= rank )
+                {
+                    break;
+                }
+            }
+            return std::min( node.running_max, std::max( node.running_min, HistogramValue( bucket ) ) );
+        };
+        stats.running_p50 = percentile( 0.50 );
+        stats.running_p90 = percentile( 0.90 );
+        stats.running_p99 = percentile( 0.99 );
+    }
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef REPLAY_STATISTICS_H
+#define REPLAY_STATISTICS_H
+
+#include <cstdint>
+#include <vector>
+#include "bt_editor_base.h"
+#include "replay_transitions.h"
+
+struct NodeTimingStatistics
+{
+    int executions = 0;   // transitions to SUCCESS or FAILURE
+    int success = 0;
+    int failure = 0;
+    int running_count = 0;  // number of completed RUNNING intervals
+    double running_min = 0;  // seconds
+    double running_mean = 0;
+    double running_p50 = 0;
+    double running_p90 = 0;
+    double running_p99 = 0;
+    double running_max = 0;
+};
+
+// Per-node statistics, accumulated transition by transition in a single pass.
+// The RUNNING duration is the time between the transition to RUNNING and the
+// following one of the same node.
+//
+// The memory doesn't depend on the number of transitions: the min, mean and
+// max of the durations are exact, the percentiles come from a histogram of
+// fixed size per node (16 logarithmic buckets per octave, from 1 usec to 38
+// hours), with a relative error below 2.2%.
+class NodeTimingAccumulator
+{
+public:
+    void reset(size_t nodes_count);
+
+    void add(int node_index, NodeStatus prev_status, NodeStatus status, double timestamp);
+
+    // add the rows [first_row, last_row) of transitions
+    void add(const ReplayTransitions& transitions, size_t first_row, size_t last_row);
+
+    std::vector<NodeTimingStatistics> statistics() const;
+
+private:
+    struct NodeData
+    {
+        int success = 0;
+        int failure = 0;
+        double running_since = -1;
+        int running_count = 0;
+        double running_min = 0;
+        double running_max = 0;
+        double running_sum = 0;
+        // allocated at the first duration
+        std::vector<uint32_t> histogram;
+    };
+    std::vector<NodeData> _nodes;
+};
+
+#endif // REPLAY_STATISTICS_H
@@ -0,0 +1,356 @@
+#include "replay_table_model.h"
+
+#include <algorithm>
+#include <QColor>
+#include <QFont>
+
+ReplayTableModel::ReplayTableModel(const AbsBehaviorTree &tree,
+                                   const ReplayTransitions &transitions,
+                                   const std::vector<std::pair<double, int> > &timepoints,
+                                   QObject *parent):
+    QAbstractTableModel(parent),
+    _tree(tree),
+    _transitions(transitions),
+    _timepoints(timepoints),
+    _current_row(-1)
+{
+}
+
+int ReplayTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(_transitions.size());
+}
+
+int ReplayTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 4;
+}
+
+static QString statusToString(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return "SUCCESS";
+    case NodeStatus::FAILURE: return "FAILURE";
+    case NodeStatus::RUNNING: return "RUNNING";
+    case NodeStatus::IDLE:    return "IDLE";
+    }
+    return QString();
+}
+
+static QColor statusToColor(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return QColor::fromRgb(22, 255, 22);
+    case NodeStatus::FAILURE: return QColor::fromRgb(255, 22, 22);
+    case NodeStatus::RUNNING: return QColor::fromRgb(250, 160, 20);
+    case NodeStatus::IDLE:    return QColor::fromRgb(222, 222, 222);
+    }
+    return QColor();
+}
+
+QVariant ReplayTableModel::data(const QModelIndex &index, int role) const
+{
+    if( !index.isValid() || index.row() >= static_cast<int>(_transitions.size()) )
+    {
+        return QVariant();
+    }
+
+    const int row    = index.row();
+    const int column = index.column();
+
+    switch( role )
+    {
+    case Qt::DisplayRole:
+    {
+        switch( column )
+        {
+        case 0: return QString::number( _transitions.timestamp(row) - _transitions.timestamp(0), 'f', 3 );
+        case 1: return nodeName( row );
+        case 2: return statusToString( _transitions.prevStatus(row) );
+        case 3: return statusToString( _transitions.status(row) );
+        }
+    } break;
+
+    case Qt::ToolTipRole:
+    {
+        if( column == 0 )
+        {
+            return QString("absolute time: %1").arg( _transitions.timestamp(row), 0, 'f', 3 );
+        }
+    } break;
+
+    case Qt::FontRole:
+    {
+        if( column == 0 && isTimepoint(row) )
+        {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+    } break;
+
+    case Qt::BackgroundRole:
+    {
+        switch( column )
+        {
+        case 0:
+        case 1: return (row <= _current_row) ? QColor::fromRgb(210, 210, 210) :
+                                               QColor::fromRgb(255, 255, 255);
+        case 2: return statusToColor( _transitions.prevStatus(row) );
+        case 3: return statusToColor( _transitions.status(row) );
+        }
+    } break;
+
+    case Qt::ForegroundRole:
+    {
+        if( column >= 2 )
+        {
+            return QColor::fromRgb(0, 0, 0);
+        }
+    } break;
+    }
+    return QVariant();
+}
+
+QVariant ReplayTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if( role != Qt::DisplayRole || orientation != Qt::Horizontal )
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch( section )
+    {
+    case 0: return "Time";
+    case 1: return "Node Name";
+    case 2: return "Previous";
+    case 3: return "Status";
+    }
+    return QVariant();
+}
+
+void ReplayTableModel::refresh()
+{
+    beginResetModel();
+    _current_row = -1;
+    endResetModel();
+}
+
+void ReplayTableModel::beginAppendRows(int count)
+{
+    const int first = static_cast<int>(_transitions.size());
+    beginInsertRows( QModelIndex(), first, first + count - 1 );
+}
+
+void ReplayTableModel::endAppendRows()
+{
+    endInsertRows();
+}
+
+void ReplayTableModel::setCurrentRow(int current_row)
+{
+    if( current_row == _current_row )
+    {
+        return;
+    }
+    // only the rows between the old and the new position change color
+    const int first = std::max(0, std::min(current_row, _current_row) + 1);
+    const int last  = std::min( std::max(current_row, _current_row),
+                                static_cast<int>(_transitions.size()) - 1 );
+    _current_row = current_row;
+
+    if( first <= last )
+    {
+        emit dataChanged( index(first, 0), index(last, 1), {Qt::BackgroundRole} );
+    }
+}
+
+QString ReplayTableModel::nodeName(int row) const
+{
+    const int node_index = _transitions.index(row);
+    if( node_index < 0 || node_index >= static_cast<int>(_tree.nodesCount()) )
+    {
+        return QString();
+    }
+    return _tree.node( node_index )->instance_name;
+}
+
+bool ReplayTableModel::isTimepoint(int row) const
+{
+    auto it = std::lower_bound( _timepoints.begin(), _timepoints.end(), row,
+                                []( const std::pair<double,int>& a, int val ) -> bool
+    {
+        return a.second < val;
+    } );
+    return it != _timepoints.end() && it->second == row;
+}
+
+//------------------------------------------------------------
+
+ReplayFilterModel::ReplayFilterModel(QObject *parent):
+    QAbstractProxyModel(parent),
+    _filtered(false)
+{
+}
+
+void ReplayFilterModel::setSourceModel(QAbstractItemModel *source)
+{
+    beginResetModel();
+    if( sourceModel() )
+    {
+        disconnect( sourceModel(), nullptr, this, nullptr );
+    }
+    QAbstractProxyModel::setSourceModel(source);
+
+    connect( source, &QAbstractItemModel::dataChanged,
+             this, &ReplayFilterModel::onSourceDataChanged );
+    connect( source, &QAbstractItemModel::rowsAboutToBeInserted,
+             this, &ReplayFilterModel::onSourceRowsAboutToBeInserted );
+    connect( source, &QAbstractItemModel::rowsInserted,
+             this, &ReplayFilterModel::onSourceRowsInserted );
+    connect( source, &QAbstractItemModel::modelAboutToBeReset,
+             this, &ReplayFilterModel::onSourceAboutToBeReset );
+    connect( source, &QAbstractItemModel::modelReset,
+             this, &ReplayFilterModel::onSourceReset );
+    endResetModel();
+}
+
+void ReplayFilterModel::setFilteredRows(std::vector<int> &&rows)
+{
+    beginResetModel();
+    _filtered = true;
+    _rows = std::move(rows);
+    endResetModel();
+}
+
+void ReplayFilterModel::appendFilteredRows(const std::vector<int> &rows)
+{
+    if( !_filtered || rows.empty() )
+    {
+        return;
+    }
+    const int first = static_cast<int>(_rows.size());
+    beginInsertRows( QModelIndex(), first, first + static_cast<int>(rows.size()) - 1 );
+    _rows.insert( _rows.end(), rows.begin(), rows.end() );
+    endInsertRows();
+}
+
+void ReplayFilterModel::clearFilter()
+{
+    if( !_filtered )
+    {
+        return;
+    }
+    beginResetModel();
+    _filtered = false;
+    _rows.clear();
+    endResetModel();
+}
+
+QModelIndex ReplayFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if( parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount() )
+    {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex ReplayFilterModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int ReplayFilterModel::rowCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return _filtered ? static_cast<int>(_rows.size()) : sourceModel()->rowCount();
+}
+
+int ReplayFilterModel::columnCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return sourceModel()->columnCount();
+}
+
+QModelIndex ReplayFilterModel::mapToSource(const QModelIndex &proxy_index) const
+{
+    if( !proxy_index.isValid() || !sourceModel() )
+    {
+        return QModelIndex();
+    }
+    const int row = _filtered ? _rows[ proxy_index.row() ] : proxy_index.row();
+    return sourceModel()->index( row, proxy_index.column() );
+}
+
+QModelIndex ReplayFilterModel::mapFromSource(const QModelIndex &source_index) const
+{
+    if( !source_index.isValid() )
+    {
+        return QModelIndex();
+    }
+    if( !_filtered )
+    {
+        return index( source_index.row(), source_index.column() );
+    }
+    auto it = std::lower_bound( _rows.begin(), _rows.end(), source_index.row() );
+    if( it == _rows.end() || *it != source_index.row() )
+    {
+        return QModelIndex();
+    }
+    return index( static_cast<int>(it - _rows.begin()), source_index.column() );
+}
+
+void ReplayFilterModel::onSourceDataChanged(const QModelIndex &top_left,
+                                            const QModelIndex &bottom_right,
+                                            const QVector<int> &roles)
+{
+    int first = top_left.row();
+    int last  = bottom_right.row();
+    if( _filtered )
+    {
+        first = static_cast<int>( std::lower_bound( _rows.begin(), _rows.end(), first ) - _rows.begin() );
+        last  = static_cast<int>( std::upper_bound( _rows.begin(), _rows.end(), last ) - _rows.begin() ) - 1;
+    }
+    if( first <= last )
+    {
+        emit dataChanged( index(first, top_left.column()),
+                          index(last, bottom_right.column()), roles );
+    }
+}
+
+void ReplayFilterModel::onSourceRowsAboutToBeInserted(const QModelIndex &, int first, int last)
+{
+    // when filtered, new rows are added explicitly with appendFilteredRows
+    if( !_filtered )
+    {
+        beginInsertRows( QModelIndex(), first, last );
+    }
+}
+
+void ReplayFilterModel::onSourceRowsInserted(const QModelIndex &, int, int)
+{
+    if( !_filtered )
+    {
+        endInsertRows();
+    }
+}
+
+void ReplayFilterModel::onSourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void ReplayFilterModel::onSourceReset()
+{
+    // the filter is still active, but it will include only the new rows
+    _rows.clear();
+    endResetModel();
+}
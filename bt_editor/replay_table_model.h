@@ -0,0 +1,110 @@
+#ifndef REPLAY_TABLE_MODEL_H
+#define REPLAY_TABLE_MODEL_H
+
+#include <vector>
+#include <QAbstractTableModel>
+#include <QAbstractProxyModel>
+#include "bt_editor_base.h"
+#include "replay_transitions.h"
+
+// Read-only view over the transitions of a replay log.
+// Cells are generated on demand in data(); nothing is stored per row.
+class ReplayTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    ReplayTableModel(const AbsBehaviorTree& tree,
+                     const ReplayTransitions& transitions,
+                     const std::vector<std::pair<double,int>>& timepoints,
+                     QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    // call this every time the underlying vectors are modified
+    void refresh();
+
+    // wrap the insertion of new transitions at the end of the vector
+    void beginAppendRows(int count);
+    void endAppendRows();
+
+    // rows up to current_row (included) are highlighted
+    void setCurrentRow(int current_row);
+
+    int currentRow() const { return _current_row; }
+
+    QString nodeName(int row) const;
+
+private:
+
+    bool isTimepoint(int row) const;
+
+    const AbsBehaviorTree& _tree;
+    const ReplayTransitions& _transitions;
+    const std::vector<std::pair<double,int>>& _timepoints;
+
+    int _current_row;
+};
+
+// Shows only a given, sorted, list of rows of the source model.
+// The list is provided by the owner (usually derived from per-node indices),
+// so that filtering never iterates over all the rows of the source.
+class ReplayFilterModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *source) override;
+
+    // rows must be sorted
+    void setFilteredRows(std::vector<int>&& rows);
+
+    // rows must be sorted and greater than the ones already added
+    void appendFilteredRows(const std::vector<int>& rows);
+
+    void clearFilter();
+
+    bool isFiltered() const { return _filtered; }
+
+    const std::vector<int>& filteredRows() const { return _rows; }
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex mapToSource(const QModelIndex &proxy_index) const override;
+
+    QModelIndex mapFromSource(const QModelIndex &source_index) const override;
+
+private slots:
+
+    void onSourceDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right,
+                             const QVector<int> &roles);
+
+    void onSourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+
+    void onSourceAboutToBeReset();
+
+    void onSourceReset();
+
+private:
+    bool _filtered;
+    std::vector<int> _rows;
+};
+
+#endif // REPLAY_TABLE_MODEL_H
@@ -0,0 +1,265 @@
+#include "replay_timeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+constexpr double ReplayTimelineData::BASE_BUCKET;
+constexpr double ReplayTimelineData::MAX_GAP;
+
+ReplayTimelineData::ReplayTimelineData():
+    _first_dirty_bucket(0),
+    _skipped_transitions(0)
+{
+    clear();
+}
+
+void ReplayTimelineData::clear()
+{
+    _levels.clear();
+    _levels.resize(1);
+    _first_dirty_bucket = 0;
+    _skipped_transitions = 0;
+}
+
+void ReplayTimelineData::addTransition(double relative_time, bool is_failure)
+{
+    auto& base = _levels.front();
+    const double time = std::max( 0.0, relative_time );
+    if( !std::isfinite( time ) || time > base.size() * BASE_BUCKET + MAX_GAP )
+    {
+        _skipped_transitions++;
+        return;
+    }
+    const size_t bucket_index = static_cast<size_t>( time / BASE_BUCKET );
+    if( bucket_index >= base.size() )
+    {
+        base.resize( bucket_index + 1 );
+    }
+    base[bucket_index].transitions++;
+    if( is_failure )
+    {
+        base[bucket_index].failures++;
+    }
+    _first_dirty_bucket = std::min( _first_dirty_bucket, bucket_index );
+}
+
+void ReplayTimelineData::updatePyramid()
+{
+    size_t dirty = _first_dirty_bucket;
+    for (size_t level = 1; _levels[level-1].size() > 1; level++)
+    {
+        if( level >= _levels.size() )
+        {
+            _levels.resize( level + 1 );
+        }
+        const auto& lower = _levels[level-1];
+        auto& upper = _levels[level];
+        dirty /= 2;
+        upper.resize( (lower.size() + 1) / 2 );
+
+        for (size_t i = dirty; i < upper.size(); i++)
+        {
+            Bucket merged = lower[2*i];
+            if( 2*i + 1 < lower.size() )
+            {
+                merged.transitions += lower[2*i + 1].transitions;
+                merged.failures    += lower[2*i + 1].failures;
+            }
+            upper[i] = merged;
+        }
+    }
+    _first_dirty_bucket = _levels.front().size();
+}
+
+double ReplayTimelineData::duration() const
+{
+    return _levels.front().size() * BASE_BUCKET;
+}
+
+ReplayTimeline::ReplayTimeline(QWidget *parent) :
+    QWidget(parent),
+    _view_start(0),
+    _view_span(0),
+    _current_time(-1)
+{
+    setMinimumHeight(24);
+    setSizePolicy( QSizePolicy::Expanding, QSizePolicy::Fixed );
+    setToolTip("Transitions (gray) and failures (red) over time.\n"
+               "Click to jump, mouse wheel to zoom, double click to reset the zoom.");
+    clear();
+}
+
+void ReplayTimeline::clear()
+{
+    _data.clear();
+    _view_start = 0;
+    _view_span = 0;
+    _current_time = -1;
+    _bookmarks.clear();
+    update();
+}
+
+void ReplayTimeline::setData(ReplayTimelineData data)
+{
+    _data = std::move( data );
+    update();
+}
+
+void ReplayTimeline::setCurrentTime(double relative_time)
+{
+    if( _current_time != relative_time )
+    {
+        _current_time = relative_time;
+        update();
+    }
+}
+
+void ReplayTimeline::setBookmarks(std::vector<double> relative_times)
+{
+    _bookmarks = std::move( relative_times );
+    update();
+}
+
+QSize ReplayTimeline::sizeHint() const
+{
+    return QSize(200, 32);
+}
+
+double ReplayTimeline::viewSpan() const
+{
+    return (_view_span > 0) ? _view_span : std::max( duration(), ReplayTimelineData::BASE_BUCKET );
+}
+
+double ReplayTimeline::xToTime(double x) const
+{
+    return _view_start + viewSpan() * x / std::max(1, width());
+}
+
+double ReplayTimeline::timeToX(double time) const
+{
+    return (time - _view_start) * width() / viewSpan();
+}
+
+void ReplayTimeline::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect( rect(), QColor::fromRgb(255, 255, 255) );
+
+    const int W = width();
+    const int H = height();
+    const auto& levels = _data.levels();
+    if( levels.front().empty() || W <= 0 )
+    {
+        return;
+    }
+
+    // the coarsest level whose buckets are still smaller than a pixel
+    const double seconds_per_pixel = viewSpan() / W;
+    size_t level = 0;
+    while( level + 1 < levels.size() &&
+           ReplayTimelineData::BASE_BUCKET * std::pow(2.0, level + 1) <= seconds_per_pixel )
+    {
+        level++;
+    }
+    const auto& buckets = levels[level];
+    const double bucket_width = ReplayTimelineData::BASE_BUCKET * std::pow(2.0, level);
+
+    std::vector<Bucket> columns( W );
+    uint32_t max_count = 1;
+    for (int x = 0; x < W; x++)
+    {
+        const double t_start = xToTime(x);
+        const double t_end   = xToTime(x + 1);
+        size_t first = static_cast<size_t>( std::max(0.0, t_start) / bucket_width );
+        size_t last  = static_cast<size_t>( std::max(0.0, t_end) / bucket_width );
+        last = std::min( last, buckets.size() );
+        if( t_end <= 0 )
+        {
+            continue;
+        }
+        for (size_t i = first; i < last || (i == first && i < buckets.size()); i++)
+        {
+            columns[x].transitions += buckets[i].transitions;
+            columns[x].failures    += buckets[i].failures;
+        }
+        max_count = std::max( max_count, columns[x].transitions );
+    }
+
+    // logarithmic scale: bursts should not hide the rest of the log
+    const double scale = (H - 4) / std::log( 1.0 + max_count );
+    const QColor density_color = QColor::fromRgb(120, 120, 120);
+    const QColor failure_color = QColor::fromRgb(255, 22, 22);
+
+    for (int x = 0; x < W; x++)
+    {
+        const Bucket& column = columns[x];
+        if( column.transitions > 0 )
+        {
+            const int h = std::max(1, int( std::log(1.0 + column.transitions) * scale ));
+            painter.fillRect( x, H - h, 1, h, density_color );
+        }
+        if( column.failures > 0 )
+        {
+            painter.fillRect( x, 0, 1, 4, failure_color );
+        }
+    }
+
+    const QColor bookmark_color = QColor::fromRgb(40, 110, 220);
+    for (double time: _bookmarks)
+    {
+        const int x = static_cast<int>( timeToX(time) );
+        if( x >= 0 && x < W )
+        {
+            painter.fillRect( x - 1, 0, 3, H, bookmark_color );
+        }
+    }
+
+    if( _current_time >= 0 )
+    {
+        const int x = static_cast<int>( timeToX(_current_time) );
+        painter.setPen( QColor::fromRgb(250, 160, 20) );
+        painter.drawLine( x, 0, x, H );
+    }
+}
+
+void ReplayTimeline::mousePressEvent(QMouseEvent *event)
+{
+    if( event->button() == Qt::LeftButton && !_data.levels().front().empty() )
+    {
+        emit timeSelected( std::max(0.0, xToTime( event->pos().x() )) );
+    }
+}
+
+void ReplayTimeline::mouseMoveEvent(QMouseEvent *event)
+{
+    if( (event->buttons() & Qt::LeftButton) && !_data.levels().front().empty() )
+    {
+        emit timeSelected( std::max(0.0, xToTime( event->pos().x() )) );
+    }
+}
+
+void ReplayTimeline::mouseDoubleClickEvent(QMouseEvent *)
+{
+    _view_start = 0;
+    _view_span = 0;
+    update();
+}
+
+void ReplayTimeline::wheelEvent(QWheelEvent *event)
+{
+    // zoom around the mouse position
+    const double factor = (event->angleDelta().y() > 0) ? 0.8 : 1.25;
+    const double pivot = xToTime( event->pos().x() );
+    const double min_span = ReplayTimelineData::BASE_BUCKET * 10;
+    const double new_span = std::min( std::max( viewSpan() * factor, min_span ),
+                                      std::max( duration(), min_span ) );
+
+    _view_start = pivot - (pivot - _view_start) * new_span / viewSpan();
+    _view_start = std::max( 0.0, std::min( _view_start, duration() - new_span ) );
+    _view_span = (new_span >= duration()) ? 0 : new_span;
+    update();
+    event->accept();
+}
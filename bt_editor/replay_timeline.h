@@ -0,0 +1,113 @@
+#ifndef REPLAY_TIMELINE_H
+#define REPLAY_TIMELINE_H
+
+#include <cstdint>
+#include <vector>
+#include <QWidget>
+
+// Density of the transitions and of the FAILURE events of a replay log over time.
+//
+// Transitions are aggregated into buckets of BASE_BUCKET seconds as they are
+// parsed; coarser levels (each one merging two buckets of the previous one)
+// form a pyramid, so that painting and zooming never access the transitions.
+// It is not a QObject: the parse worker builds it, then hands a copy to
+// the ReplayTimeline in the GUI thread.
+//
+// A transition more than MAX_GAP seconds after the last bucket is skipped:
+// a corrupted timestamp would allocate the buckets up to it.
+class ReplayTimelineData
+{
+public:
+    struct Bucket
+    {
+        uint32_t transitions = 0;
+        uint32_t failures = 0;
+    };
+
+    static constexpr double BASE_BUCKET = 0.1;
+    static constexpr double MAX_GAP = 24 * 3600;
+
+    ReplayTimelineData();
+
+    void clear();
+
+    // relative_time is the time since the first transition, in seconds
+    void addTransition(double relative_time, bool is_failure);
+
+    // by addTransition(), since clear()
+    size_t skippedTransitions() const { return _skipped_transitions; }
+
+    // call this after a batch of addTransition() to refresh the coarser levels
+    void updatePyramid();
+
+    double duration() const;
+
+    // level 0 has buckets of BASE_BUCKET seconds, each level doubles it
+    const std::vector<std::vector<Bucket>>& levels() const { return _levels; }
+
+private:
+
+    std::vector<std::vector<Bucket>> _levels;
+    size_t _first_dirty_bucket;
+    size_t _skipped_transitions;
+};
+
+// Strip that shows a ReplayTimelineData and the bookmarks of a replay log.
+class ReplayTimeline : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayTimeline(QWidget *parent = nullptr);
+
+    void clear();
+
+    // replace the buckets, keeping the zoom
+    void setData(ReplayTimelineData data);
+
+    // highlight the current position
+    void setCurrentTime(double relative_time);
+
+    // marks at the bookmarked times, since the first transition
+    void setBookmarks(std::vector<double> relative_times);
+
+    double duration() const { return _data.duration(); }
+
+    QSize sizeHint() const override;
+
+signals:
+
+    void timeSelected(double relative_time);
+
+protected:
+
+    void paintEvent(QPaintEvent *event) override;
+
+    void mousePressEvent(QMouseEvent *event) override;
+
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+
+    typedef ReplayTimelineData::Bucket Bucket;
+
+    double xToTime(double x) const;
+
+    double timeToX(double time) const;
+
+    // the view is [_view_start, _view_start + _view_span]
+    double viewSpan() const;
+
+    ReplayTimelineData _data;
+
+    double _view_start;
+    double _view_span; // 0 means "the entire log"
+    double _current_time;
+    std::vector<double> _bookmarks;
+};
+
+#endif // REPLAY_TIMELINE_H
@@ -0,0 +1,153 @@
+#include "replay_transitions.h"
+
+#include <algorithm>
+#include <cmath>
+
+ReplayTransitions::ReplayTransitions()
+{
+}
+
+void ReplayTransitions::clear()
+{
+    // release the memory too: a log may have millions of transitions
+    std::vector<int64_t>().swap( _block_base );
+    std::vector<uint32_t>().swap( _time_offset );
+    _time_overflow.clear();
+    std::vector<uint16_t>().swap( _node_index );
+    std::vector<uint8_t>().swap( _status );
+    std::vector<int>().swap( _restarts );
+}
+
+void ReplayTransitions::reserve(size_t count)
+{
+    _block_base.reserve( count / BLOCK_SIZE + 1 );
+    _time_offset.reserve( count );
+    _node_index.reserve( count );
+    _status.reserve( count / 2 + 1 );
+}
+
+void ReplayTransitions::push_back(const ReplayTransition &transition)
+{
+    const size_t row = size();
+    const int64_t usec = std::llround( transition.timestamp * 1000000.0 );
+
+    if( row % BLOCK_SIZE == 0 )
+    {
+        _block_base.push_back( usec );
+    }
+    const int64_t offset = usec - _block_base.back();
+    if( offset >= 0 && offset < OVERFLOW_OFFSET )
+    {
+        _time_offset.push_back( static_cast<uint32_t>(offset) );
+    }
+    else{
+        _time_offset.push_back( OVERFLOW_OFFSET );
+        _time_overflow[row] = usec;
+    }
+
+    _node_index.push_back( static_cast<uint16_t>(transition.index) );
+
+    const uint8_t value = (static_cast<uint8_t>(transition.prev_status) << 2) |
+                           static_cast<uint8_t>(transition.status);
+    if( row & 1 )
+    {
+        _status.back() |= (value << 4);
+    }
+    else{
+        _status.push_back( value );
+    }
+
+    if( transition.is_tree_restart )
+    {
+        _restarts.push_back( static_cast<int>(row) );
+    }
+}
+
+void ReplayTransitions::append(const std::vector<ReplayTransition> &transitions)
+{
+    for (const auto& transition: transitions )
+    {
+        push_back( transition );
+    }
+}
+
+ReplayTransition ReplayTransitions::operator[](size_t row) const
+{
+    ReplayTransition transition;
+    transition.index = static_cast<int16_t>( index(row) );
+    transition.timestamp = timestamp(row);
+    transition.prev_status = prevStatus(row);
+    transition.status = status(row);
+    transition.is_tree_restart = isTreeRestart(row);
+    transition.nearest_restart_transition_index = nearestRestart(row);
+    return transition;
+}
+
+int64_t ReplayTransitions::timestampUsec(size_t row) const
+{
+    const uint32_t offset = _time_offset[row];
+    if( offset == OVERFLOW_OFFSET )
+    {
+        return _time_overflow.at(row);
+    }
+    return _block_base[row / BLOCK_SIZE] + offset;
+}
+
+bool ReplayTransitions::isTreeRestart(size_t row) const
+{
+    return std::binary_search( _restarts.begin(), _restarts.end(), static_cast<int>(row) );
+}
+
+int ReplayTransitions::nearestRestart(size_t row) const
+{
+    auto it = std::upper_bound( _restarts.begin(), _restarts.end(), static_cast<int>(row) );
+    return ( it == _restarts.begin() ) ? 0 : *(it - 1);
+}
+
+size_t ReplayTransitions::lowerBound(double timestamp) const
+{
+    size_t first = 0;
+    size_t count = size();
+    while( count > 0 )
+    {
+        const size_t step = count / 2;
+        if( this->timestamp(first + step) < timestamp )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else{
+            count = step;
+        }
+    }
+    return first;
+}
+
+size_t ReplayTransitions::upperBound(double timestamp) const
+{
+    size_t first = 0;
+    size_t count = size();
+    while( count > 0 )
+    {
+        const size_t step = count / 2;
+        if( !(timestamp < this->timestamp(first + step)) )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else{
+            count = step;
+        }
+    }
+    return first;
+}
+
+size_t ReplayTransitions::memoryUsage() const
+{
+    return _block_base.capacity()  * sizeof(int64_t) +
+           _time_offset.capacity() * sizeof(uint32_t) +
+           _time_overflow.size()   * (sizeof(size_t) + sizeof(int64_t)) +
+           _node_index.capacity()  * sizeof(uint16_t) +
+           _status.capacity()      * sizeof(uint8_t) +
+           _restarts.capacity()    * sizeof(int);
+}
@@ -0,0 +1,95 @@
+#ifndef REPLAY_TRANSITIONS_H
+#define REPLAY_TRANSITIONS_H
+
+#include <vector>
+#include <unordered_map>
+#include "bt_editor_base.h"
+
+struct ReplayTransition
+{
+    int16_t index;
+    double timestamp;
+    NodeStatus prev_status;
+    NodeStatus status;
+    bool is_tree_restart;
+    int nearest_restart_transition_index;
+};
+
+// Columnar, compact storage of the transitions of a replay log.
+//
+//  - timestamps are integer microseconds, stored as a 32 bits offset from the
+//    first timestamp of their block (BLOCK_SIZE transitions).
+//  - prev_status and status use 2 bits each, two transitions per byte.
+//  - restarts of the tree are a sorted, sparse list of rows.
+//
+// About 6.5 bytes per transition, with O(1) random access.
+class ReplayTransitions
+{
+public:
+    ReplayTransitions();
+
+    size_t size() const { return _node_index.size(); }
+
+    bool empty() const { return _node_index.empty(); }
+
+    void clear();
+
+    void reserve(size_t count);
+
+    // nearest_restart_transition_index is ignored, it is computed from restarts()
+    void push_back(const ReplayTransition& transition);
+
+    void append(const std::vector<ReplayTransition>& transitions);
+
+    // decode a single transition. Prefer the accessors below in tight loops.
+    ReplayTransition operator[](size_t row) const;
+
+    ReplayTransition front() const { return (*this)[0]; }
+
+    ReplayTransition back() const { return (*this)[size()-1]; }
+
+    int64_t timestampUsec(size_t row) const;
+
+    double timestamp(size_t row) const { return timestampUsec(row) * 0.000001; }
+
+    int index(size_t row) const { return _node_index[row]; }
+
+    NodeStatus prevStatus(size_t row) const { return static_cast<NodeStatus>( (nibble(row) >> 2) & 0x3 ); }
+
+    NodeStatus status(size_t row) const { return static_cast<NodeStatus>( nibble(row) & 0x3 ); }
+
+    bool isTreeRestart(size_t row) const;
+
+    // row of the last restart of the tree before (or at) the given row
+    int nearestRestart(size_t row) const;
+
+    const std::vector<int>& restarts() const { return _restarts; }
+
+    // Binary search over the timestamps, that are assumed to be sorted.
+    // First row with timestamp >= (or >) the given one.
+    size_t lowerBound(double timestamp) const;
+    size_t upperBound(double timestamp) const;
+
+    size_t memoryUsage() const;
+
+private:
+
+    static const size_t BLOCK_SIZE = 1024;
+    static const uint32_t OVERFLOW_OFFSET = 0xFFFFFFFF;
+
+    uint8_t nibble(size_t row) const
+    {
+        return (row & 1) ? (_status[row >> 1] >> 4) : (_status[row >> 1] & 0x0F);
+    }
+
+    std::vector<int64_t> _block_base;
+    std::vector<uint32_t> _time_offset;
+    // timestamps that can't be represented as an offset (rare)
+    std::unordered_map<size_t, int64_t> _time_overflow;
+
+    std::vector<uint16_t> _node_index;
+    std::vector<uint8_t> _status;
+    std::vector<int> _restarts;
+};
+
+#endif // REPLAY_TRANSITIONS_H
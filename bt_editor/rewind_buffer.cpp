@@ -0,0 +1,114 @@
+#include "rewind_buffer.h"
+#include <algorithm>
+
+RewindBuffer::RewindBuffer():
+    _max_seconds(60.0),
+    _max_bytes(32 * 1024 * 1024),
+    _first_sequence(0)
+{
+}
+
+void RewindBuffer::setLimits(double max_seconds, size_t max_bytes)
+{
+    _max_seconds = max_seconds;
+    _max_bytes = max_bytes;
+    trim();
+}
+
+void RewindBuffer::reset(const std::vector<NodeStatus> &status)
+{
+    _entries.clear();
+    _checkpoints.clear();
+    _first_sequence = 0;
+    _first_status = status;
+    _last_status = status;
+}
+
+void RewindBuffer::push_back(int node_index, NodeStatus status, double timestamp)
+{
+    if( node_index < 0 || size_t(node_index) >= _last_status.size() )
+    {
+        return;
+    }
+
+    const size_t sequence = _first_sequence + _entries.size();
+    if( sequence % CHECKPOINT_PERIOD == 0 && sequence > _first_sequence )
+    {
+        _checkpoints.push_back( { sequence, _last_status } );
+    }
+
+    _entries.push_back( { timestamp, int16_t(node_index), status } );
+    _last_status[node_index] = status;
+    trim();
+}
+
+void RewindBuffer::trim()
+{
+    while( !_entries.empty() &&
+           ( _entries.back().timestamp - _entries.front().timestamp > _max_seconds ||
+             memoryUsage() > _max_bytes ) )
+    {
+        const Entry& entry = _entries.front();
+        _first_status[entry.index] = entry.status;
+        _entries.pop_front();
+        _first_sequence++;
+
+        if( !_checkpoints.empty() && _checkpoints.front().sequence <= _first_sequence )
+        {
+            // more recent than _first_status
+            if( _checkpoints.front().sequence == _first_sequence )
+            {
+                _first_status = std::move( _checkpoints.front().status );
+            }
+            _checkpoints.pop_front();
+        }
+    }
+}
+
+std::vector<NodeStatus> RewindBuffer::statusAt(size_t position) const
+{
+    if( _entries.empty() )
+    {
+        return _first_status;
+    }
+    position = std::min( position, _entries.size() - 1 );
+    const size_t sequence = _first_sequence + position;
+
+    // start from the closest checkpoint before the position, if any
+    std::vector<NodeStatus> status = _first_status;
+    size_t first = 0;
+
+    auto checkpoint_it = std::upper_bound( _checkpoints.begin(), _checkpoints.end(), sequence,
+                                           []( size_t val, const Checkpoint& cp ) -> bool
+    {
+        return val < cp.sequence;
+    } );
+    if( checkpoint_it != _checkpoints.begin() )
+    {
+        const Checkpoint& checkpoint = *(checkpoint_it - 1);
+        status = checkpoint.status;
+        first = checkpoint.sequence - _first_sequence;
+    }
+
+    for (size_t t = first; t <= position; t++)
+    {
+        status[ _entries[t].index ] = _entries[t].status;
+    }
+    return status;
+}
+
+size_t RewindBuffer::lowerBound(double timestamp) const
+{
+    auto it = std::lower_bound( _entries.begin(), _entries.end(), timestamp,
+                                []( const Entry& entry, double val ) -> bool
+    {
+        return entry.timestamp < val;
+    } );
+    return size_t( it - _entries.begin() );
+}
+
+size_t RewindBuffer::memoryUsage() const
+{
+    return _entries.size() * sizeof(Entry) +
+           _checkpoints.size() * ( sizeof(Checkpoint) + _last_status.size() * sizeof(NodeStatus) );
+}
@@ -0,0 +1,86 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <deque>
+#include <vector>
+#include "bt_editor_base.h"
+
+// Bounded history of the transitions of a monitored tree: the last
+// maxSeconds() or maxBytes(), whichever is reached first. The oldest
+// transitions are removed as new ones arrive.
+//
+// As in the replay logs, the full status of the tree is stored every
+// CHECKPOINT_PERIOD transitions, so that the status at any position is
+// computed without applying the whole buffer.
+class RewindBuffer
+{
+public:
+    static const size_t CHECKPOINT_PERIOD = 1024;
+
+    RewindBuffer();
+
+    void setLimits(double max_seconds, size_t max_bytes);
+
+    double maxSeconds() const { return _max_seconds; }
+
+    size_t maxBytes() const { return _max_bytes; }
+
+    // forget the history. status is the current status of the tree
+    void reset(const std::vector<NodeStatus>& status);
+
+    void clear() { reset( std::vector<NodeStatus>() ); }
+
+    // transitions must be added in chronological order
+    void push_back(int node_index, NodeStatus status, double timestamp);
+
+    size_t size() const { return _entries.size(); }
+
+    bool empty() const { return _entries.empty(); }
+
+    // position 0 is the oldest transition in the buffer
+    double timestamp(size_t position) const { return _entries[position].timestamp; }
+
+    int index(size_t position) const { return _entries[position].index; }
+
+    NodeStatus status(size_t position) const { return _entries[position].status; }
+
+    // status of all the nodes after the transition at position
+    std::vector<NodeStatus> statusAt(size_t position) const;
+
+    // first position with timestamp >= the given one
+    size_t lowerBound(double timestamp) const;
+
+    size_t memoryUsage() const;
+
+private:
+    struct Entry
+    {
+        double timestamp;
+        int16_t index;
+        NodeStatus status;
+    };
+
+    // status of the tree before the transition number sequence
+    struct Checkpoint
+    {
+        size_t sequence;
+        std::vector<NodeStatus> status;
+    };
+
+    void trim();
+
+    double _max_seconds;
+    size_t _max_bytes;
+
+    std::deque<Entry> _entries;
+    // sequence number of _entries.front(), counted since reset
+    size_t _first_sequence;
+
+    // status before _entries.front() and after _entries.back()
+    std::vector<NodeStatus> _first_status;
+    std::vector<NodeStatus> _last_status;
+
+    std::deque<Checkpoint> _checkpoints;
+};
+
+#endif // REWIND_BUFFER_H
@@ -0,0 +1,251 @@
+#include "scene_minimap.h"
+#include "trace_recorder.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <algorithm>
+
+#include <nodes/Node>
+#include <nodes/NodeDataModel>
+#include <nodes/NodeStyle>
+
+using namespace QtNodes;
+
+SceneMinimap::SceneMinimap(QWidget *parent) :
+    QWidget(parent),
+    _rendered_revision(0),
+    _rendered(false),
+    _scale(1.0)
+{
+    setMinimumSize( 100, 80 );
+    setCursor( Qt::PointingHandCursor );
+
+    // throttled: the first change starts the timer, the next ones wait for it
+    _structure_timer.setSingleShot( true );
+    _structure_timer.setInterval( STRUCTURE_INTERVAL );
+    connect( &_structure_timer, &QTimer::timeout, this, &SceneMinimap::refresh );
+
+    _status_timer.setSingleShot( true );
+    _status_timer.setInterval( STATUS_INTERVAL );
+    connect( &_status_timer, &QTimer::timeout, this, &SceneMinimap::repaintStatus );
+}
+
+void SceneMinimap::setView(FlowView *view)
+{
+    if( view == _view.data() )
+    {
+        return;
+    }
+    for (const auto& connection: _connections)
+    {
+        disconnect( connection );
+    }
+    _connections.clear();
+    _items.clear();
+    _rendered = false;
+
+    _view = view;
+    _scene = view ? dynamic_cast<FlowScene*>( view->scene() ) : nullptr;
+
+    if( _view )
+    {
+        // the view panned or zoomed: only its rect is painted again, the
+        // image is not drawn again
+        _connections.push_back( connect( _view.data(), &FlowView::painted,
+                                         this, [this]() { update(); } ) );
+    }
+    if( _scene )
+    {
+        auto changed = [this]() { scheduleRefresh(); };
+        _connections.push_back( connect( _scene.data(), &FlowScene::nodeCreated, this, changed ) );
+        _connections.push_back( connect( _scene.data(), &FlowScene::nodeDeleted, this, changed ) );
+        _connections.push_back( connect( _scene.data(), &FlowScene::nodeMoved, this, changed ) );
+        _connections.push_back( connect( _scene.data(), &FlowScene::structureChanged, this, changed ) );
+    }
+    refresh();
+}
+
+void SceneMinimap::statusChanged()
+{
+    if( !_status_timer.isActive() )
+    {
+        _status_timer.start();
+    }
+}
+
+void SceneMinimap::scheduleRefresh()
+{
+    if( !_structure_timer.isActive() )
+    {
+        _structure_timer.start();
+    }
+}
+
+void SceneMinimap::refresh()
+{
+    _structure_timer.stop();
+    if( !isVisible() )
+    {
+        // drawn once shown
+        _rendered = false;
+        return;
+    }
+    if( !_scene )
+    {
+        _items.clear();
+        _image = QImage();
+        update();
+        return;
+    }
+    // the changes done with the signals of the scene blocked are found here
+    if( !_rendered || _rendered_revision != _scene->revision() || _image.size() != size() )
+    {
+        render();
+    }
+    update();
+}
+
+void SceneMinimap::render()
+{
+    TraceScope trace( "scene", "renderMinimap" );
+
+    _items.clear();
+    _items.reserve( _scene->nodes().size() );
+
+    QRectF bounds;
+    for (const auto& it: _scene->nodes())
+    {
+        const Node* node = it.second.get();
+        const QRectF rect( _scene->getNodePosition( *node ), _scene->getNodeSize( *node ) );
+        bounds = bounds.isNull() ? rect : bounds.united( rect );
+        _items.push_back( { node, rect, 0 } );
+    }
+    trace.setArgument( "nodes", _items.size() );
+
+    _image = QImage( size(), QImage::Format_ARGB32_Premultiplied );
+    _image.fill( palette().color( QPalette::Base ) );
+
+    const double margin = 20;
+    bounds.adjust( -margin, -margin, margin, margin );
+    _scale = std::min( width() / bounds.width(), height() / bounds.height() );
+    _scene_origin = bounds.topLeft();
+    _offset = QPointF( (width() - bounds.width() * _scale) * 0.5,
+                       (height() - bounds.height() * _scale) * 0.5 );
+
+    QPainter painter( &_image );
+    for (Item& item: _items)
+    {
+        item.rect = QRectF( (item.rect.topLeft() - _scene_origin) * _scale + _offset,
+                            item.rect.size() * _scale );
+        drawItem( painter, item );
+    }
+    _rendered_revision = _scene->revision();
+    _rendered = true;
+}
+
+void SceneMinimap::repaintStatus()
+{
+    if( !_rendered || !_scene || _rendered_revision != _scene->revision() )
+    {
+        // the nodes of _items may not exist anymore: drawn again instead
+        refresh();
+        return;
+    }
+    QPainter painter( &_image );
+    for (Item& item: _items)
+    {
+        const QRgb color = item.node->nodeDataModel()->nodeStyle().NormalBoundaryColor.rgba();
+        if( color != item.color )
+        {
+            drawItem( painter, item );
+        }
+    }
+    update();
+}
+
+void SceneMinimap::drawItem(QPainter &painter, Item &item)
+{
+    const NodeStyle& style = item.node->nodeDataModel()->nodeStyle();
+    item.color = style.NormalBoundaryColor.rgba();
+
+    // too small for a border: the rect has the color of the status
+    if( item.rect.width() < 4 || item.rect.height() < 4 )
+    {
+        painter.fillRect( item.rect, style.NormalBoundaryColor );
+        return;
+    }
+    painter.fillRect( item.rect, style.GradientColor1 );
+    painter.setPen( QPen( style.NormalBoundaryColor, 1.5 ) );
+    painter.setBrush( Qt::NoBrush );
+    painter.drawRect( item.rect.adjusted( 0.5, 0.5, -0.5, -0.5 ) );
+}
+
+QPointF SceneMinimap::mapToScene(const QPoint &pos) const
+{
+    return ( QPointF(pos) - _offset ) / _scale + _scene_origin;
+}
+
+QSize SceneMinimap::sizeHint() const
+{
+    return QSize( 250, 180 );
+}
+
+void SceneMinimap::paintEvent(QPaintEvent *)
+{
+    QPainter painter( this );
+    if( _image.isNull() || !_view )
+    {
+        painter.fillRect( rect(), palette().color( QPalette::Base ) );
+        return;
+    }
+    painter.drawImage( 0, 0, _image );
+
+    const QRectF visible = _view->mapToScene( _view->viewport()->rect() ).boundingRect();
+    const QRectF visible_rect( ( visible.topLeft() - _scene_origin ) * _scale + _offset,
+                               visible.size() * _scale );
+    QColor highlight = palette().color( QPalette::Highlight );
+    painter.setPen( QPen( highlight, 1.5 ) );
+    highlight.setAlpha( 40 );
+    painter.setBrush( highlight );
+    painter.drawRect( visible_rect );
+}
+
+void SceneMinimap::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent( event );
+    scheduleRefresh();
+}
+
+void SceneMinimap::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent( event );
+    refresh();
+}
+
+void SceneMinimap::mousePressEvent(QMouseEvent *event)
+{
+    if( event->button() == Qt::LeftButton )
+    {
+        centerView( event->pos() );
+    }
+}
+
+void SceneMinimap::mouseMoveEvent(QMouseEvent *event)
+{
+    if( event->buttons() & Qt::LeftButton )
+    {
+        centerView( event->pos() );
+    }
+}
+
+void SceneMinimap::centerView(const QPoint &pos)
+{
+    if( _view && _rendered )
+    {
+        // as FlowView pans: its scroll bars are hidden, the scene rect moves
+        const QPointF center = _view->mapToScene( _view->viewport()->rect().center() );
+        const QPointF difference = mapToScene( pos ) - center;
+        _view->setSceneRect( _view->sceneRect().translated( difference.x(), difference.y() ) );
+        update();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef SCENE_MINIMAP_H
+#define SCENE_MINIMAP_H
+
+#include <vector>
+#include <QImage>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+
+#include <nodes/FlowScene>
+#include <nodes/FlowView>
+
+// Overview of the whole scene of a view, with the part that the view shows.
+// Clicking or dragging in it centers the view on that point.
+//
+// The nodes are drawn as rects into a cached image, painted as it is: the
+// scene items are never painted. The image is drawn again once the scene
+// revision changed, at most every STRUCTURE_INTERVAL ms; a change of the
+// status styles only repaints the nodes whose color changed, at most every
+// STATUS_INTERVAL ms.
+class SceneMinimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SceneMinimap(QWidget *parent = nullptr);
+
+    // nullptr to show nothing
+    void setView(QtNodes::FlowView* view);
+
+    // the status styles of the nodes changed
+    void statusChanged();
+
+    // draw the image again now, if the scene changed
+    void refresh();
+
+    // the nodes drawn in the image
+    size_t renderedNodes() const { return _items.size(); }
+
+    // in the coordinates of the scene
+    QPointF mapToScene(const QPoint& pos) const;
+
+    QSize sizeHint() const override;
+
+protected:
+
+    void paintEvent(QPaintEvent *event) override;
+
+    void resizeEvent(QResizeEvent *event) override;
+
+    void showEvent(QShowEvent *event) override;
+
+    void mousePressEvent(QMouseEvent *event) override;
+
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+
+    static const int STRUCTURE_INTERVAL = 100;
+    static const int STATUS_INTERVAL = 250;
+
+    struct Item
+    {
+        const QtNodes::Node* node;
+        QRectF rect; // in the image
+        QRgb color;
+    };
+
+    void scheduleRefresh();
+
+    void render();
+
+    void repaintStatus();
+
+    void drawItem(QPainter& painter, Item& item);
+
+    void centerView(const QPoint& pos);
+
+    QPointer<QtNodes::FlowView> _view;
+    QPointer<QtNodes::FlowScene> _scene;
+    std::vector<QMetaObject::Connection> _connections;
+
+    QImage _image;
+    std::vector<Item> _items;
+    // the revision of the scene and the size the image was drawn at
+    quint64 _rendered_revision;
+    bool _rendered;
+
+    // scene to image: image = (scene - _scene_origin) * _scale + _offset
+    QPointF _scene_origin;
+    double _scale;
+    QPointF _offset;
+
+    QTimer _structure_timer;
+    QTimer _status_timer;
+};
+
+#endif // SCENE_MINIMAP_H
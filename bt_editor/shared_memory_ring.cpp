@@ -0,0 +1,290 @@
+#include "shared_memory_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARED_MEMORY_RING_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char RING_MAGIC[8] = { 'G', 'R', 'O', 'O', 'T', 'S', 'H', 'M' };
+static const uint32_t RING_VERSION = 2;
+
+static size_t RoundUpPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while( result < value )
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+SharedMemoryRing::SharedMemoryRing():
+    _header(nullptr),
+    _ring(nullptr),
+    _tree(nullptr),
+    _mapped_size(0),
+    _read_offset(0)
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+    close();
+}
+
+std::string SharedMemoryRing::segmentName(const std::string &address)
+{
+    const std::string scheme = "shm://";
+    if( address.compare( 0, scheme.size(), scheme ) != 0 || address.size() == scheme.size() )
+    {
+        return std::string();
+    }
+    return "/" + address.substr( scheme.size() );
+}
+
+void SharedMemoryRing::close()
+{
+#ifdef SHARED_MEMORY_RING_POSIX
+    if( _header )
+    {
+        munmap( _header, _mapped_size );
+    }
+    if( !_created_name.empty() )
+    {
+        shm_unlink( _created_name.c_str() );
+    }
+#endif
+    _header = nullptr;
+    _ring = nullptr;
+    _tree = nullptr;
+    _mapped_size = 0;
+    _created_name.clear();
+}
+
+std::string SharedMemoryRing::open(const std::string &name)
+{
+    close();
+#ifdef SHARED_MEMORY_RING_POSIX
+    const int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+    if( fd < 0 )
+    {
+        return std::strerror( errno );
+    }
+    struct stat info;
+    if( fstat( fd, &info ) != 0 || size_t(info.st_size) < sizeof(Header) )
+    {
+        ::close( fd );
+        return "the segment is not a Groot ring";
+    }
+    void* mapped = mmap( nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if( mapped == MAP_FAILED )
+    {
+        return std::strerror( errno );
+    }
+    Header* header = static_cast<Header*>( mapped );
+    if( std::memcmp( header->magic, RING_MAGIC, sizeof(RING_MAGIC) ) != 0 ||
+        header->version != RING_VERSION ||
+        ( header->capacity & (header->capacity - 1) ) != 0 ||
+        sizeof(Header) + size_t(header->capacity) + header->tree_capacity > size_t(info.st_size) )
+    {
+        munmap( mapped, size_t(info.st_size) );
+        return "the segment is not a Groot ring";
+    }
+    _header = header;
+    _mapped_size = size_t(info.st_size);
+    _ring = static_cast<char*>( mapped ) + sizeof(Header);
+    _tree = _ring + _header->capacity;
+    _read_offset = _header->write_offset.load( std::memory_order_acquire );
+    return std::string();
+#else
+    (void)name;
+    return "shared memory is not supported on this platform";
+#endif
+}
+
+std::string SharedMemoryRing::create(const std::string &name, size_t capacity, size_t tree_capacity)
+{
+    close();
+#ifdef SHARED_MEMORY_RING_POSIX
+    capacity = RoundUpPowerOfTwo( capacity );
+    const size_t size = sizeof(Header) + capacity + tree_capacity;
+
+    shm_unlink( name.c_str() );
+    const int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if( fd < 0 )
+    {
+        return std::strerror( errno );
+    }
+    if( ftruncate( fd, off_t(size) ) != 0 )
+    {
+        const std::string error = std::strerror( errno );
+        ::close( fd );
+        shm_unlink( name.c_str() );
+        return error;
+    }
+    void* mapped = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if( mapped == MAP_FAILED )
+    {
+        shm_unlink( name.c_str() );
+        return std::strerror( errno );
+    }
+    // the new segment is filled with zeros
+    _header = new (mapped) Header();
+    std::memcpy( _header->magic, RING_MAGIC, sizeof(RING_MAGIC) );
+    _header->version = RING_VERSION;
+    _header->capacity = uint32_t(capacity);
+    _header->tree_capacity = uint32_t(tree_capacity);
+    _header->reserved = 0;
+    _header->write_offset.store( 0 );
+    _header->reserve_offset.store( 0 );
+    _header->tree_sequence.store( 0 );
+    _header->tree_size.store( 0 );
+
+    _mapped_size = size;
+    _ring = static_cast<char*>( mapped ) + sizeof(Header);
+    _tree = _ring + capacity;
+    _read_offset = 0;
+    _created_name = name;
+    return std::string();
+#else
+    (void)name;
+    (void)capacity;
+    (void)tree_capacity;
+    return "shared memory is not supported on this platform";
+#endif
+}
+
+void SharedMemoryRing::copyFromRing(uint64_t offset, char *destination, size_t size) const
+{
+    const size_t capacity = _header->capacity;
+    const size_t begin = size_t( offset & (capacity - 1) );
+    const size_t first = std::min( size, capacity - begin );
+    std::memcpy( destination, _ring + begin, first );
+    std::memcpy( destination + first, _ring, size - first );
+}
+
+void SharedMemoryRing::copyToRing(uint64_t offset, const char *source, size_t size)
+{
+    const size_t capacity = _header->capacity;
+    const size_t begin = size_t( offset & (capacity - 1) );
+    const size_t first = std::min( size, capacity - begin );
+    std::memcpy( _ring + begin, source, first );
+    std::memcpy( _ring, source + first, size - first );
+}
+
+bool SharedMemoryRing::read(std::vector<char> &message, size_t &overruns)
+{
+    if( !_header )
+    {
+        return false;
+    }
+    const uint64_t capacity = _header->capacity;
+    const uint64_t write_offset = _header->write_offset.load( std::memory_order_acquire );
+    if( _read_offset == write_offset )
+    {
+        return false;
+    }
+    if( write_offset - _read_offset > capacity || write_offset < _read_offset )
+    {
+        // overwritten, or the publisher was restarted: the next message
+        // starts at write_offset
+        overruns++;
+        _read_offset = write_offset;
+        return false;
+    }
+
+    uint32_t size = 0;
+    copyFromRing( _read_offset, reinterpret_cast<char*>(&size), sizeof(size) );
+    if( sizeof(size) + size > write_offset - _read_offset )
+    {
+        overruns++;
+        _read_offset = write_offset;
+        return false;
+    }
+    message.resize( size );
+    copyFromRing( _read_offset + sizeof(size), message.data(), size );
+
+    // the publisher may have started to overwrite it while it was copied:
+    // the bytes it may have changed end at reserve_offset
+    std::atomic_thread_fence( std::memory_order_acquire );
+    const uint64_t reserve_offset = _header->reserve_offset.load( std::memory_order_relaxed );
+    if( reserve_offset - _read_offset > capacity )
+    {
+        overruns++;
+        _read_offset = _header->write_offset.load( std::memory_order_acquire );
+        return false;
+    }
+    _read_offset += sizeof(size) + size;
+    return true;
+}
+
+bool SharedMemoryRing::write(const char *data, size_t size)
+{
+    if( !_header || sizeof(uint32_t) + size > _header->capacity )
+    {
+        return false;
+    }
+    const uint64_t offset = _header->write_offset.load( std::memory_order_relaxed );
+    const uint32_t size32 = uint32_t(size);
+    const uint64_t end = offset + sizeof(size32) + size;
+    // published before any byte of the ring is reused
+    _header->reserve_offset.store( end, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    copyToRing( offset, reinterpret_cast<const char*>(&size32), sizeof(size32) );
+    copyToRing( offset + sizeof(size32), data, size );
+    _header->write_offset.store( end, std::memory_order_release );
+    return true;
+}
+
+bool SharedMemoryRing::writeTree(const char *data, size_t size)
+{
+    if( !_header || size > _header->tree_capacity )
+    {
+        return false;
+    }
+    const uint64_t sequence = _header->tree_sequence.load( std::memory_order_relaxed );
+    _header->tree_sequence.store( sequence + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    std::memcpy( _tree, data, size );
+    _header->tree_size.store( uint32_t(size), std::memory_order_relaxed );
+    _header->tree_sequence.store( sequence + 2, std::memory_order_release );
+    return true;
+}
+
+std::vector<char> SharedMemoryRing::readTree() const
+{
+    std::vector<char> tree;
+    if( !_header )
+    {
+        return tree;
+    }
+    // a few attempts while the publisher writes it
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        const uint64_t sequence = _header->tree_sequence.load( std::memory_order_acquire );
+        if( sequence % 2 == 1 )
+        {
+            continue;
+        }
+        const size_t size = std::min<size_t>( _header->tree_size.load( std::memory_order_relaxed ),
+                                              _header->tree_capacity );
+        tree.assign( _tree, _tree + size );
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( _header->tree_sequence.load( std::memory_order_relaxed ) == sequence )
+        {
+            return tree;
+        }
+    }
+    tree.clear();
+    return tree;
+}
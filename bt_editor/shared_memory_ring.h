@@ -0,0 +1,97 @@
+#ifndef SHARED_MEMORY_RING_H
+#define SHARED_MEMORY_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Transport of the monitor messages between processes of the same host: a
+// POSIX shared memory segment "/<name>", written by the publisher and read
+// by Groot, without sockets nor copies in the kernel.
+//
+// The segment starts with a Header, then the ring of the messages, then the
+// area of the tree:
+//  - each message is a uint32 size followed by its bytes, the same encoding
+//    of the messages of BT::PublisherZMQ (or the compact protocol, see
+//    MonitorReceiver). write_offset counts the bytes written since the
+//    creation: the position in the ring is write_offset % capacity. It is
+//    incremented once the message is complete. reserve_offset is the end of
+//    the message being written: it is incremented before the first byte is
+//    copied;
+//  - the tree, as the reply of the server of BT::PublisherZMQ, is written in
+//    a seqlock: tree_sequence is odd while it is being changed.
+//
+// A reader that falls behind by more than the capacity skips the lost
+// messages: they are counted. A message is accepted only if, once copied,
+// reserve_offset shows that none of its bytes was reused by the publisher
+// in the meantime.
+class SharedMemoryRing
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;
+    static const size_t DEFAULT_TREE_CAPACITY = 1024 * 1024;
+
+    struct Header
+    {
+        char magic[8];      // "GROOTSHM"
+        uint32_t version;   // 2
+        uint32_t capacity;  // bytes of the ring, a power of two
+        uint32_t tree_capacity;
+        uint32_t reserved;
+        std::atomic<uint64_t> write_offset;
+        std::atomic<uint64_t> reserve_offset;
+        std::atomic<uint64_t> tree_sequence;
+        std::atomic<uint32_t> tree_size;
+    };
+
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    // The reader. Only the messages written from now on are read.
+    // Returns the error, or an empty string
+    std::string open(const std::string& name);
+
+    // The publisher: the segment is created, or replaced.
+    // Returns the error, or an empty string
+    std::string create(const std::string& name,
+                       size_t capacity = DEFAULT_CAPACITY,
+                       size_t tree_capacity = DEFAULT_TREE_CAPACITY);
+
+    bool isOpen() const { return _header != nullptr; }
+
+    // The next message. False if there is none. overruns is incremented
+    // when the messages not read yet were overwritten
+    bool read(std::vector<char>& message, size_t& overruns);
+
+    // False if the message is larger than the ring
+    bool write(const char* data, size_t size);
+
+    // False if the tree is larger than its area
+    bool writeTree(const char* data, size_t size);
+
+    // empty if the publisher didn't write a tree yet
+    std::vector<char> readTree() const;
+
+    // the segment "/<name>" of an address "shm://<name>", empty otherwise
+    static std::string segmentName(const std::string& address);
+
+private:
+    void close();
+
+    void copyFromRing(uint64_t offset, char* destination, size_t size) const;
+    void copyToRing(uint64_t offset, const char* source, size_t size);
+
+    Header* _header;
+    char* _ring;
+    char* _tree;
+    size_t _mapped_size;
+    uint64_t _read_offset;
+    // the publisher removes the segment when destroyed
+    std::string _created_name;
+};
+
+#endif // SHARED_MEMORY_RING_H
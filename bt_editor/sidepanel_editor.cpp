@@ -2,6 +2,7 @@
 #include "ui_sidepanel_editor.h"
 #include "custom_node_dialog.h"
 #include "utils.h"
+#include "palette_import.h"
 
 #include <QHeaderView>
 #include <QPushButton>
@@ -14,13 +15,57 @@
 #include <QJsonArray>
 #include <QSettings>
 
+namespace {
+
+// sorted by score while filtering, then by ID
+class PaletteItem: public QTreeWidgetItem
+{
+public:
+    PaletteItem(QTreeWidgetItem* parent, const QString& ID,
+                const SidepanelEditor::UsageFunction* usage):
+        QTreeWidgetItem(parent, {ID}),
+        score(0),
+        _usage(usage)
+    {}
+
+    QVariant data(int column, int role) const override
+    {
+        if( role == Qt::ToolTipRole && *_usage )
+        {
+            const int count = (*_usage)( QTreeWidgetItem::data(0, Qt::UserRole).toString() );
+            return ( count == 0 ) ? QObject::tr("Not used") :
+                                    QObject::tr("Used by %1 node(s)").arg( count );
+        }
+        return QTreeWidgetItem::data(column, role);
+    }
+
+    bool operator<(const QTreeWidgetItem& other) const override
+    {
+        const auto& other_item = static_cast<const PaletteItem&>(other);
+        if( score != other_item.score )
+        {
+            return score > other_item.score;
+        }
+        return text(0) < other.text(0);
+    }
+
+    int score;
+
+private:
+    const SidepanelEditor::UsageFunction* _usage;
+};
+
+}
+
 SidepanelEditor::SidepanelEditor(QtNodes::DataModelRegistry *registry,
                                  NodeModels &tree_nodes_model,
                                  QWidget *parent) :
     QFrame(parent),
     ui(new Ui::SidepanelEditor),
     _tree_nodes_model(tree_nodes_model),
-    _model_registry(registry)
+    _model_registry(registry),
+    _update_depth(0),
+    _update_pending(false)
 {
     ui->setupUi(this);   
     ui->paramsFrame->setHidden(true);
@@ -32,6 +77,10 @@ SidepanelEditor::SidepanelEditor(QtNodes::DataModelRegistry *registry,
     connect(ui->paletteTreeWidget, &QTreeWidget::itemDoubleClicked,
             this, &SidepanelEditor::onDoubleClick);
 
+    _filter_timer.setSingleShot(true);
+    _filter_timer.setInterval(150);
+    connect( &_filter_timer, &QTimer::timeout, this, &SidepanelEditor::applyFilter );
+
     auto table_header = ui->portsTableWidget->horizontalHeader();
 
     table_header->setSectionResizeMode(0, QHeaderView::ResizeToContents);
@@ -55,20 +104,46 @@ SidepanelEditor::~SidepanelEditor()
 
 void SidepanelEditor::updateTreeView()
 {
-    ui->paletteTreeWidget->clear();
-    _tree_view_category_items.clear();
+    if( _update_depth > 0 )
+    {
+        _update_pending = true;
+        return;
+    }
+    if( _tree_view_category_items.empty() )
+    {
+        for (const QString& category : {"Action", "Condition",
+                                        "Control", "Decorator", "SubTree" } )
+        {
+          auto item = new QTreeWidgetItem(ui->paletteTreeWidget, {category});
+          QFont font = item->font(0);
+          font.setBold(true);
+          font.setPointSize(11);
+          item->setFont(0, font);
+          item->setFlags( item->flags() ^ Qt::ItemIsDragEnabled );
+          item->setFlags( item->flags() ^ Qt::ItemIsSelectable );
+          _tree_view_category_items[ category ] = item;
+        }
+    }
 
-    for (const QString& category : {"Action", "Condition",
-                                    "Control", "Decorator", "SubTree" } )
+    auto categoryItem = [this](const NodeModel& model) -> QTreeWidgetItem*
     {
-      auto item = new QTreeWidgetItem(ui->paletteTreeWidget, {category});
-      QFont font = item->font(0);
-      font.setBold(true);
-      font.setPointSize(11);
-      item->setFont(0, font);
-      item->setFlags( item->flags() ^ Qt::ItemIsDragEnabled );
-      item->setFlags( item->flags() ^ Qt::ItemIsSelectable );
-      _tree_view_category_items[ category ] = item;
+        auto it = _tree_view_category_items.find( QString::fromStdString(toStr(model.type)) );
+        return ( it != _tree_view_category_items.end() ) ? it->second : nullptr;
+    };
+
+    // the items of the models removed, or moved to another category
+    for (auto it = _tree_view_model_items.begin(); it != _tree_view_model_items.end(); )
+    {
+        auto model_it = _tree_nodes_model.find( it->first );
+        if( model_it == _tree_nodes_model.end() ||
+            it->second->parent() != categoryItem( model_it->second ) )
+        {
+            delete it->second;
+            it = _tree_view_model_items.erase( it );
+        }
+        else{
+            it++;
+        }
     }
 
     for (const auto &it : _tree_nodes_model)
@@ -76,13 +151,17 @@ void SidepanelEditor::updateTreeView()
       const auto& ID = it.first;
       const NodeModel& model = it.second;
 
-      if( model.registration_ID == "Root")
+      auto parent = categoryItem( model );
+      if( model.registration_ID == "Root" || !parent )
       {
           continue;
       }
-      QString category = QString::fromStdString(toStr(model.type));
-      auto parent = _tree_view_category_items[category];
-      auto item = new QTreeWidgetItem(parent, {ID});
+      auto& item = _tree_view_model_items[ID];
+      if( !item )
+      {
+          item = new PaletteItem(parent, ID, &_model_usage);
+          item->setData(0, Qt::UserRole, ID);
+      }
       const bool is_builtin = BuiltinNodeModels().count( ID ) > 0;
       const bool is_editable = (!ui->buttonLock->isChecked() && !is_builtin);
 
@@ -90,17 +169,66 @@ void SidepanelEditor::updateTreeView()
       font.setItalic( is_builtin );
       font.setPointSize(11);
       item->setFont(0, font);
-      item->setData(0, Qt::UserRole, ID);
 
       if (is_editable)
       {
         item->setForeground(0, QBrush(QColor(70, 110, 154)));
       }
+      else{
+        item->setData(0, Qt::ForegroundRole, QVariant());
+      }
     }
 
+    _palette_index.build( _tree_nodes_model );
+    applyFilter();
+
     ui->paletteTreeWidget->expandAll();
 }
 
+void SidepanelEditor::beginUpdate()
+{
+    _update_depth++;
+}
+
+void SidepanelEditor::endUpdate()
+{
+    _update_depth--;
+    if( _update_depth == 0 && _update_pending )
+    {
+        _update_pending = false;
+        updateTreeView();
+    }
+}
+
+void SidepanelEditor::applyFilter()
+{
+    _filter_timer.stop();
+
+    const QString text = ui->lineEditFilter->text();
+    const bool filtering = !text.trimmed().isEmpty();
+
+    QHash<QString, int> scores;
+    for (const auto& match: _palette_index.search( text ))
+    {
+        scores.insert( match.ID, match.score );
+    }
+
+    for (const auto& it : _tree_view_model_items)
+    {
+        auto item = static_cast<PaletteItem*>( it.second );
+        item->score = scores.value( it.first, 0 );
+        const bool hidden = filtering && item->score == 0;
+        if( item->isHidden() != hidden )
+        {
+            item->setHidden( hidden );
+        }
+    }
+    for (auto& it : _tree_view_category_items)
+    {
+        it.second->sortChildren( 0, Qt::AscendingOrder );
+    }
+}
+
 void SidepanelEditor::clear()
 {
 
@@ -136,18 +264,9 @@ void SidepanelEditor::on_paletteTreeWidget_itemSelectionChanged()
 
 }
 
-void SidepanelEditor::on_lineEditFilter_textChanged(const QString &text)
+void SidepanelEditor::on_lineEditFilter_textChanged(const QString &)
 {
-  for (auto& it : _tree_view_category_items)
-  {
-    for (int i = 0; i < it.second->childCount(); ++i)
-    {
-      auto child = it.second->child(i);
-      auto modelName = child->data(0, Qt::UserRole).toString();
-      bool show = modelName.contains(text, Qt::CaseInsensitive);
-      child->setHidden( !show);
-    }
-  }
+    _filter_timer.start();
 }
 
 
@@ -313,35 +432,60 @@ void SidepanelEditor::on_buttonDownload_clicked()
     QString directory_path  = settings.value("SidepanelEditor.lastLoadDirectory",
                                              QDir::homePath() ).toString();
 
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Load TreenNodeModel from file"),
-                                                    directory_path,
-                                                    tr("BehaviorTree (*.xml *.skills.json)" ));
-    QFileInfo fileInfo(fileName);
-
-    if (!fileInfo.exists(fileName)){
+    const QStringList filenames = QFileDialog::getOpenFileNames(this, tr("Load TreenNodeModel from files"),
+                                                                directory_path,
+                                                                tr("BehaviorTree (*.xml *.skills.json)" ));
+    if (filenames.isEmpty()){
         return;
     }
 
-    QFile file(fileName);
-
-    if (!file.open(QIODevice::ReadOnly)){
-        return;
-    }
-
-    directory_path = QFileInfo(fileName).absolutePath();
+    directory_path = QFileInfo(filenames.front()).absolutePath();
     settings.setValue("SidepanelEditor.lastLoadDirectory", directory_path);
     settings.sync();
 
     //--------------------------------
     NodeModels imported_models;
-    if( fileInfo.suffix() == "xml" )
+    QStringList palette_files;
+    for (const QString& fileName: filenames)
     {
-        QFile file(fileName);
-        imported_models = importFromXML( &file );
+        QFileInfo fileInfo(fileName);
+        if( fileInfo.suffix() == "xml" )
+        {
+            palette_files.push_back( fileName );
+        }
+        else if( fileInfo.completeSuffix() == "skills.json" )
+        {
+            for (auto& it: importFromSkills( fileName ))
+            {
+                imported_models.insert( it );
+            }
+        }
     }
-    else if( fileInfo.completeSuffix() == "skills.json" )
+
+    if( !palette_files.isEmpty() )
     {
-        imported_models = importFromSkills( fileName );
+        // parsed in parallel, and kept for the next session
+        ImportedPalettes palettes = PaletteImport::importFiles( palette_files );
+
+        QStringList problems = palettes.errors;
+        for (const auto& conflict: palettes.conflicts)
+        {
+            problems.push_back( tr("[%1] is defined differently in %2 and %3: the first one is used")
+                                .arg( conflict.ID, conflict.kept_file, conflict.ignored_file ) );
+        }
+        if( !problems.isEmpty() )
+        {
+            QMessageBox::warning(this,"Error loading TreeNodeModel from files",
+                                 problems.join("\n") );
+        }
+        if( !palettes.files.empty() )
+        {
+            PaletteImport::writeCache( PaletteImport::cacheFilename(), palettes );
+        }
+        for (auto& it: palettes.models)
+        {
+            imported_models.insert( it );
+        }
     }
 
     if( imported_models.empty() )
@@ -351,68 +495,13 @@ void SidepanelEditor::on_buttonDownload_clicked()
 
     auto models_to_remove = GetModelsToRemove(this, _tree_nodes_model, imported_models );
 
+    const ScopedUpdate update( *this );
     for(QString model_name: models_to_remove)
     {
         emit modelRemoveRequested(model_name);
     }
 
-    for(auto& it: imported_models)
-    {
-        emit addNewModel( it.second );
-    }
-}
-
-NodeModels SidepanelEditor::importFromXML(QFile* file)
-{
-    QDomDocument doc;
-
-
-    if (!file->open(QIODevice::ReadOnly))
-    {
-        QMessageBox::warning(this,"Error loading TreeNodeModel from file",
-                             "The XML was not correctly loaded");
-        return {};
-    }
-
-    QString errorMsg;
-    int errorLine;
-    if( ! doc.setContent(file, &errorMsg, &errorLine ) )
-    {
-        auto error = tr("Error parsing XML (line %1): %2").arg(errorLine).arg(errorMsg);
-        QMessageBox::warning(this,"Error loading TreeNodeModel form file", error);
-        file->close();
-        return {};
-    }
-    file->close();
-
-    NodeModels custom_models;
-
-    QDomElement xml_root = doc.documentElement();
-    if ( xml_root.isNull() || xml_root.tagName() != "root")
-    {
-        QMessageBox::warning(this,"Error loading TreeNodeModel form file",
-                             "The XML must have a root node called <root>");
-        return custom_models;
-    }
-
-    auto manifest_root = xml_root.firstChildElement("TreeNodesModel");
-
-    if ( manifest_root.isNull() )
-    {
-        QMessageBox::warning(this,"Error loading TreeNodeModel form file",
-                             "Expecting <TreeNodesModel> under <root>");
-        return custom_models;
-    }
-
-    for( QDomElement model_element = manifest_root.firstChildElement();
-         !model_element.isNull();
-         model_element = model_element.nextSiblingElement() )
-    {
-        auto model = buildTreeNodeModelFromXML(model_element);
-        custom_models.insert( { model.registration_ID, model } );
-    }
-
-    return custom_models;
+    emit addNewModels( imported_models );
 }
 
 NodeModels SidepanelEditor::importFromSkills(const QString &fileName)
@@ -5,7 +5,10 @@
 #include <QFile>
 #include <QTreeWidgetItem>
 #include <QTableWidgetItem>
+#include <QTimer>
+#include <functional>
 #include "XML_utilities.hpp"
+#include "palette_index.h"
 
 namespace Ui {
 class SidepanelEditor;
@@ -23,8 +26,33 @@ public:
 
     void updateTreeView();
 
+    // Between beginUpdate() and endUpdate(), updateTreeView() only records
+    // that the palette changed: the outermost endUpdate() updates it once.
+    // Updates can be nested.
+    void beginUpdate();
+
+    void endUpdate();
+
+    // beginUpdate() for the lifetime of the object
+    class ScopedUpdate
+    {
+    public:
+        explicit ScopedUpdate(SidepanelEditor& editor) : _editor(editor) { _editor.beginUpdate(); }
+        ~ScopedUpdate() { _editor.endUpdate(); }
+        ScopedUpdate(ScopedUpdate const&) = delete;
+        ScopedUpdate& operator=(ScopedUpdate const&) = delete;
+    private:
+        SidepanelEditor& _editor;
+    };
+
     void clear();
 
+    // how many nodes use a model, shown in the tooltip of its palette item.
+    // Called only when the tooltip is shown
+    typedef std::function<int(const QString& ID)> UsageFunction;
+
+    void setModelUsageFunction(UsageFunction usage) { _model_usage = std::move(usage); }
+
 public slots:
     void onRemoveModel(QString selected_name);
 
@@ -49,10 +77,16 @@ private slots:
 
     void onDoubleClick(QTreeWidgetItem *item, int column);
 
+    // hides the models not matching the filter and ranks the others
+    void applyFilter();
+
 signals:
 
     void addNewModel(const NodeModel &new_model);
 
+    // registered in a single update of the palette
+    void addNewModels(const NodeModels &new_models);
+
     void modelRemoveRequested(QString ID);
 
     void nodeModelEdited(QString prev_ID, QString new_ID);
@@ -70,8 +104,18 @@ private:
     NodeModels &_tree_nodes_model;
     QtNodes::DataModelRegistry* _model_registry;
     std::map<QString, QTreeWidgetItem*> _tree_view_category_items;
+    // by registration ID; updateTreeView() only adds and removes the
+    // items of the models that changed
+    std::map<QString, QTreeWidgetItem*> _tree_view_model_items;
+
+    PaletteIndex _palette_index;
+    // the filter is applied once the typing pauses
+    QTimer _filter_timer;
+
+    int _update_depth;
+    bool _update_pending;
 
-    NodeModels importFromXML(QFile *file);
+    UsageFunction _model_usage;
 
     NodeModels importFromSkills(const QString& filename);
 
@@ -1,14 +1,49 @@
 #include "sidepanel_monitor.h"
 #include "ui_sidepanel_monitor.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <thread>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QMessageBox>
 #include <QTimer>
 #include <QLabel>
+#include <QComboBox>
+#include <QSignalBlocker>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
 
 #include "mainwindow.h"
 #include "utils.h"
+#include "replay_log_format.h"
+#include "trace_recorder.h"
+
+static int64_t TimestampUsec(double timestamp)
+{
+    return int64_t( std::llround( timestamp * 1e6 ) );
+}
+
+static std::vector<NodeStatus> TreeStatus(const AbsBehaviorTree& tree)
+{
+    std::vector<NodeStatus> status;
+    status.reserve( tree.nodesCount() );
+    for(const auto& node: tree.nodes())
+    {
+        status.push_back( node.status );
+    }
+    return status;
+}
 
 SidepanelMonitor::SidepanelMonitor(QWidget *parent,
                                    const QString &address,
@@ -17,9 +52,14 @@ SidepanelMonitor::SidepanelMonitor(QWidget *parent,
     QFrame(parent),
     ui(new Ui::SidepanelMonitor),
     _zmq_context(1),
-    _zmq_subscriber(_zmq_context, ZMQ_SUB),
-    _connected(false),
-    _msg_count(0),
+    _receiver(_zmq_context),
+    _current(nullptr),
+    _generation_counter(0),
+    _keep_transitions(false),
+    _queue_depth(0),
+    _queue_depth_max(0),
+    _rewind_max_seconds(60.0),
+    _rewind_max_bytes(32 * 1024 * 1024),
     _parent(parent)
 {
     ui->setupUi(this);
@@ -40,170 +80,1195 @@ SidepanelMonitor::SidepanelMonitor(QWidget *parent,
 
     _timer = new QTimer(this);
     connect( _timer, &QTimer::timeout, this, &SidepanelMonitor::on_timer );
+
+    _current = addSession();
+    updateSessionWidgets();
 }
 
 SidepanelMonitor::~SidepanelMonitor()
 {
+    _receiver.stop();
+    // the requests use _zmq_context
+    for(const auto& session: _sessions)
+    {
+        session->tree_watcher->waitForFinished();
+    }
     delete ui;
 }
 
+SidepanelMonitor::Session* SidepanelMonitor::addSession()
+{
+    // the first free name: the first session uses the default tab
+    QString bt_name;
+    for(int n = 1; bt_name.isEmpty(); n++)
+    {
+        const QString name = (n == 1) ? QString("BehaviorTree") : QString("BehaviorTree %1").arg(n);
+        bool used = false;
+        for(const auto& session: _sessions)
+        {
+            used = used || (session->bt_name == name);
+        }
+        if( !used ) bt_name = name;
+    }
+
+    std::unique_ptr<Session> new_session( new Session );
+    Session* session = new_session.get();
+    session->bt_name = bt_name;
+    // a new session starts from the fields of the current one
+    session->address        = ui->lineEdit_address->text();
+    session->publisher_port = ui->lineEdit_publisher->text();
+    session->server_port    = ui->lineEdit_server->text();
+    session->backpressure   = _current ? _current->backpressure : MonitorReceiver::Backpressure::LOSSLESS;
+    session->generation     = ++_generation_counter;
+    session->metrics.setPolicy( MonitorReceiver::toStr(session->backpressure) );
+    session->rewind.setLimits( _rewind_max_seconds, _rewind_max_bytes );
+
+    session->retry_timer = new QTimer(this);
+    session->retry_timer->setSingleShot(true);
+    connect( session->retry_timer, &QTimer::timeout,
+             this, [this, session]() { onRetryTimer(*session); } );
+
+    session->tree_watcher = new QFutureWatcher<QByteArray>(this);
+    connect( session->tree_watcher, &QFutureWatcher<QByteArray>::finished,
+             this, [this, session]() { onTreeReceived(*session); } );
+
+    _sessions.push_back( std::move(new_session) );
+    {
+        const QSignalBlocker blocker( ui->comboBoxSession );
+        ui->comboBoxSession->addItem( bt_name );
+    }
+    ui->pushButtonRemoveSession->setEnabled( _sessions.size() > 1 );
+    return session;
+}
+
+void SidepanelMonitor::removeSession(Session* session)
+{
+    disconnectFromServer( *session );
+    // the request uses _zmq_context
+    session->tree_watcher->waitForFinished();
+    delete session->tree_watcher;
+    delete session->retry_timer;
+
+    for (size_t i = 0; i < _sessions.size(); i++)
+    {
+        if( _sessions[i].get() == session )
+        {
+            const QSignalBlocker blocker( ui->comboBoxSession );
+            ui->comboBoxSession->removeItem( int(i) );
+            _sessions.erase( _sessions.begin() + i );
+            break;
+        }
+    }
+    ui->pushButtonRemoveSession->setEnabled( _sessions.size() > 1 );
+}
+
+SidepanelMonitor::Session* SidepanelMonitor::sessionBySubscriber(int subscriber_id)
+{
+    for(const auto& session: _sessions)
+    {
+        if( session->generation == subscriber_id )
+        {
+            return session.get();
+        }
+    }
+    // disconnected in the meantime
+    return nullptr;
+}
+
+bool SidepanelMonitor::isConnected(const Session &session) const
+{
+    return (session.state == ConnectionState::CONNECTED ||
+            session.state == ConnectionState::RELOADING ||
+            session.state == ConnectionState::WAITING_RETRY);
+}
+
 void SidepanelMonitor::clear()
 {
-    if( _connected ) this->on_Connect();
+    _current = _sessions.front().get();
+    while( _sessions.size() > 1 )
+    {
+        removeSession( _sessions.back().get() );
+    }
+    if( _current->state != ConnectionState::DISCONNECTED )
+    {
+        disconnectFromServer( *_current );
+    }
+    stopRecording( *_current );
+    _current->paused = false;
+    _current->rewind.clear();
+    _current->rewind_snapshot.clear();
+    // the tabs were closed, the remaining session uses the default one
+    _current->bt_name = "BehaviorTree";
+    ui->comboBoxSession->setItemText( 0, _current->bt_name );
+    // the scene may be changed: don't assume that it shows the last tree
+    _current->tree_hash.clear();
+    updateSessionWidgets();
 }
 
 void SidepanelMonitor::on_timer()
 {
-    if( !_connected ) return;
+    TraceScope trace( "monitor", "apply" );
+    // the receiver thread already decoded the messages, don't block here.
+    // All the messages of a session received in this frame are merged in a
+    // single update. The cost depends on the messages, not on the sessions.
+    for(const auto& session: _sessions)
+    {
+        session->frame_messages = 0;
+        session->frame_transitions.clear();
+        session->frame_decode_times.clear();
+    }
+    _queue_depth = _receiver.queueSize();
+    _queue_depth_max = std::max( _queue_depth_max, _queue_depth );
 
-    zmq::message_t msg;
-    try{
-        while(  _zmq_subscriber.recv(msg) )
+    MonitorReceiver::Batch batch;
+    while( _receiver.pop(batch) )
+    {
+        Session* session = sessionBySubscriber( batch.subscriber_id );
+        if( !session )
         {
-            _msg_count++;
-            ui->labelCount->setText( QString("Messages received: %1").arg(_msg_count) );
-
-            const char* buffer = reinterpret_cast<const char*>(msg.data());
+            continue;
+        }
+        session->metrics.addDropped( batch.dropped_before );
+        // waiting for the new tree: the last one stays displayed as it is
+        if( session->state != ConnectionState::CONNECTED )
+        {
+            session->metrics.addSkipped();
+            continue;
+        }
+        session->frame_messages++;
+        session->compact_protocol = batch.compact;
+        session->frame_decode_times.push_back( batch.decode_time );
+        session->metrics.addMessage( batch.bytes, batch.transitions.size(),
+                                     batch.transitions.empty() ? 0.0 :
+                                     batch.receive_time - batch.transitions.back().timestamp );
 
-            const uint32_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
-            const uint32_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
+        // the header is recorded only when it corrects the status of a node,
+        // for instance after a lost message
+        const bool recording = (session->recorder != nullptr);
+        const int record_mark = session->frame_records.size();
+        if( !batch.transitions.empty() )
+        {
+            session->last_timestamp = batch.transitions.front().timestamp;
+            session->last_timestamp_received = MonitorReceiver::steadyTime();
+        }
 
-            std::vector<std::pair<int, NodeStatus>> node_status;
-            // check uid in the index, if failed load tree from server
-            try{
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
+        // a single pass: an unknown uid means that the tree changed,
+        // the new one replaces whatever was applied of this message
+        bool unknown_uid = false;
+        for(const auto& it: batch.nodes_status)
+        {
+            const int index = session->uid_to_index.find(it.first);
+            if( index == UidLookupTable::INVALID_INDEX )
+            {
+                unknown_uid = true;
+                break;
+            }
+            auto node = session->tree.node( index );
+            if( node->status != it.second )
+            {
+                if( recording )
                 {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    _uid_to_index.at(uid);
+                    ReplayLogFormat::appendRecord( session->frame_records, TimestampUsec(session->last_timestamp),
+                                                   it.first, uint8_t(node->status), uint8_t(it.second) );
                 }
-
-                for(size_t t=0; t < num_transitions; t++)
+                session->rewind.push_back( index, it.second, session->last_timestamp );
+                if( !session->paused )
                 {
-                    size_t offset = 8 + header_size + 12*t;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    _uid_to_index.at(uid);
+                    session->status_delta.add( index, it.second );
                 }
+            }
+            node->status = it.second;
+        }
 
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
+        if( !unknown_uid )
+        {
+            for(const auto& transition: batch.transitions)
+            {
+                const int index = session->uid_to_index.find(transition.uid);
+                if( index == UidLookupTable::INVALID_INDEX )
                 {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    AbstractTreeNode* node = _loaded_tree.node( index );
-                    node->status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
+                    unknown_uid = true;
+                    break;
                 }
-
-                //qDebug() << "--------";
-                for(size_t t=0; t < num_transitions; t++)
+                session->tree.node(index)->status = transition.status;
+                session->last_timestamp = transition.timestamp;
+                session->timings.add( index, transition.prev_status, transition.status, transition.timestamp );
+                // while paused the scene shows the rewind buffer, see onRewind
+                if( !session->paused )
                 {
-                    size_t offset = 8 + header_size + 12*t;
+                    session->status_delta.add( index, transition.status );
+                }
+                session->rewind.push_back( index, transition.status, transition.timestamp );
+                if( recording )
+                {
+                    ReplayLogFormat::appendRecord( session->frame_records, TimestampUsec(transition.timestamp),
+                                                   transition.uid, uint8_t(transition.prev_status),
+                                                   uint8_t(transition.status) );
+                }
+            }
+        }
 
-                    // const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
-                    // const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
-                    // double timestamp = t_sec + t_usec* 0.000001;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    // NodeStatus prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[index+10] ));
-                    NodeStatus status  = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
+        if( unknown_uid )
+        {
+            // these records belong to the next tree: dropped
+            session->frame_records.truncate( record_mark );
+            qDebug() << "Reload tree from server" << session->address_req.c_str();
+            setState( *session, ConnectionState::RELOADING );
+            requestTree( *session );
+        }
+        else if( _keep_transitions )
+        {
+            session->frame_transitions.insert( session->frame_transitions.end(),
+                                               batch.transitions.begin(), batch.transitions.end() );
+        }
+    }
 
-                    _loaded_tree.node(index)->status = status;
-                    node_status.push_back( {index, status} );
+    bool updated = false;
+    bool metrics_changed = false;
+    for(const auto& session: _sessions)
+    {
+        metrics_changed |= session->metrics.update( MonitorReceiver::steadyTime() );
 
-                }
-            }
-            catch( std::out_of_range& err) {
-                qDebug() << "Reload tree from server";
-                if( !getTreeFromServer() ) {
-                    _connected = false;
-                    ui->lineEdit_address->setDisabled(false);
-                    _timer->stop();
-                    connectionUpdate(false);
-                    return;
-                }
+        if( session->recorder && !session->frame_records.isEmpty() )
+        {
+            // only a copy to the buffer of the writer thread
+            session->recorder->append( session->frame_records );
+            session->frame_records.clear();
+        }
+        // the clock of the robot goes on between the messages: the old
+        // completions leave the window of the badges without new transitions
+        if( !session->paused && !session->tree_hash.isEmpty() )
+        {
+            session->timings.setTime( session->last_timestamp +
+                                      MonitorReceiver::steadyTime() - session->last_timestamp_received );
+            if( session->frame_messages == 0 )
+            {
+                emitTimings( *session, false );
             }
+        }
+        if( session->frame_messages == 0 )
+        {
+            continue;
+        }
+        updated = true;
+        session->metrics.addMerged( size_t(session->frame_messages - 1) );
 
-            // update the graphic part
-            emit changeNodeStyle( "BehaviorTree", node_status );
+        // update the graphic part, only the nodes that changed
+        if( !session->paused )
+        {
+            const auto node_status = session->status_delta.takeDelta();
+            if( !node_status.empty() )
+            {
+                emit changeNodeStyle( session->bt_name, node_status );
+            }
+            emitTimings( *session, false );
+        }
+        if( _keep_transitions && !session->frame_transitions.empty() )
+        {
+            emit transitionsReceived( session->bt_name, session->frame_transitions );
+        }
 
-            // lock editing of nodes
-            auto main_win = dynamic_cast<MainWindow*>( _parent );
-            main_win->lockEditing(true);
+        // the styles are applied, the scene is painted at the next event
+        const double paint_time = MonitorReceiver::steadyTime();
+        for(const double decode_time: session->frame_decode_times)
+        {
+            session->metrics.addPaintLatency( paint_time - decode_time );
         }
     }
-    catch( zmq::error_t& err)
+
+    if( metrics_changed )
+    {
+        updateMetricsWidgets();
+    }
+    if( !updated )
     {
-        qDebug() << "ZMQ receive failed: " << err.what();
+        // nothing received: not worth an event at each timer
+        trace.discard();
+        return;
     }
+    updateLabelCount();
+    updateRecordWidgets();
+    updateRewindWidgets();
+
+    // lock editing of nodes
+    auto main_win = dynamic_cast<MainWindow*>( _parent );
+    main_win->lockEditing(true);
+}
+
+void SidepanelMonitor::updateLabelCount()
+{
+    const MonitorMetrics::Values& values = _current->metrics.values();
+    ui->labelCount->setText( QString("Messages received: %1 (merged: %2)")
+                             .arg(values.total_messages + values.skipped_messages)
+                             .arg(values.merged_messages) );
 }
 
-bool SidepanelMonitor::getTreeFromServer()
+void SidepanelMonitor::updateMetricsWidgets()
 {
+    ui->labelMetrics->setText( _current->metrics.toText() +
+                               QString("\nqueue: %1/%2 (max %3), invalid: %4")
+                               .arg( _queue_depth )
+                               .arg( MonitorReceiver::QUEUE_CAPACITY )
+                               .arg( _queue_depth_max )
+                               .arg( _receiver.invalidMessages() ) );
+}
+
+static QString StateName(int state)
+{
+    static const char* names[] = { "disconnected", "connecting", "connected",
+                                   "reloading", "waiting_retry" };
+    return names[state];
+}
+
+QJsonObject SidepanelMonitor::metricsJson() const
+{
+    QJsonArray sessions;
+    for(const auto& session: _sessions)
+    {
+        QJsonObject json = session->metrics.toJson();
+        json["name"]      = session->bt_name;
+        json["publisher"] = QString::fromStdString( session->address_pub );
+        json["state"]     = StateName( int(session->state) );
+        json["protocol"]  = session->compact_protocol ? "compact" : "legacy";
+        sessions.append( json );
+    }
+
+    QJsonObject receiver;
+    receiver["queue_depth"]      = double(_queue_depth);
+    receiver["queue_depth_max"]  = double(_queue_depth_max);
+    receiver["queue_capacity"]   = double(MonitorReceiver::QUEUE_CAPACITY);
+    receiver["invalid_messages"] = double(_receiver.invalidMessages());
+
+    QJsonObject json;
+    json["timestamp"] = MonitorReceiver::systemTime();
+    json["receiver"]  = receiver;
+    json["sessions"]  = sessions;
+    return json;
+}
+
+void SidepanelMonitor::on_comboBoxBackpressure_currentIndexChanged(int index)
+{
+    // used at the next connection
+    if( index >= 0 && _current->state == ConnectionState::DISCONNECTED )
+    {
+        _current->backpressure = static_cast<MonitorReceiver::Backpressure>(index);
+        _current->metrics.setPolicy( MonitorReceiver::toStr(_current->backpressure) );
+        updateMetricsWidgets();
+    }
+}
+
+void SidepanelMonitor::on_pushButtonSaveMetrics_clicked()
+{
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelMonitor.lastMetricsDirectory",
+                                             QDir::homePath() ).toString();
+
+    QString filename = QFileDialog::getSaveFileName(this, "Save the metrics of the monitor",
+                                                    directory_path, "JSON (*.json)");
+    if( filename.isEmpty() )
+    {
+        return;
+    }
+    if( !filename.endsWith(".json") )
+    {
+        filename.append(".json");
+    }
+    settings.setValue("SidepanelMonitor.lastMetricsDirectory",
+                      QFileInfo(filename).absolutePath() );
+
+    QFile file( filename );
+    if( !file.open(QIODevice::WriteOnly) )
+    {
+        QMessageBox::warning(this, tr("Metrics"),
+                             tr("Can't write the file [%1]").arg(filename),
+                             QMessageBox::Close);
+        return;
+    }
+    file.write( QJsonDocument( metricsJson() ).toJson() );
+}
+
+// The tree written by the publisher in the shared memory, once it is there
+static QByteArray FetchTreeFromSharedMemory(const std::string& segment, int timeout_ms)
+{
+    SharedMemoryRing ring;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeout_ms );
+    do{
+        if( ring.isOpen() || ring.open( segment ).empty() )
+        {
+            const std::vector<char> tree = ring.readTree();
+            if( !tree.empty() )
+            {
+                return QByteArray( tree.data(), int(tree.size()) );
+            }
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    } while( std::chrono::steady_clock::now() < deadline );
+    return QByteArray();
+}
+
+// Runs in a worker thread: only the (thread-safe) context is shared
+static QByteArray FetchTreeFromServer(zmq::context_t* context, std::string address, int timeout_ms)
+{
+    const std::string segment = SharedMemoryRing::segmentName( address );
+    if( !segment.empty() )
+    {
+        return FetchTreeFromSharedMemory( segment, timeout_ms );
+    }
     try{
-        zmq::message_t request(0);
+        // the servers that can't send the compact protocol ignore it
+        zmq::message_t request( MonitorReceiver::COMPACT_REQUEST,
+                                std::strlen( MonitorReceiver::COMPACT_REQUEST ) );
         zmq::message_t reply;
 
-        zmq::socket_t  zmq_client( _zmq_context, ZMQ_REQ );
-        zmq_client.connect( _connection_address_req.c_str() );
-
-        zmq_client.setsockopt(ZMQ_RCVTIMEO, &_load_tree_timeout_ms, sizeof(int) );
+        zmq::socket_t  zmq_client( *context, ZMQ_REQ );
+        int linger_ms = 0;
+        zmq_client.setsockopt(ZMQ_LINGER, &linger_ms, sizeof(int) );
+        zmq_client.setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(int) );
+        zmq_client.connect( address.c_str() );
 
         zmq_client.send(request, zmq::send_flags::none);
 
         auto bytes_received  = zmq_client.recv(reply, zmq::recv_flags::none);
         if( !bytes_received || *bytes_received == 0 )
         {
-            return false;
+            return QByteArray();
         }
+        return QByteArray( reinterpret_cast<const char*>(reply.data()), int(reply.size()) );
+    }
+    catch( zmq::error_t& err)
+    {
+        qDebug() << "ZMQ client receive failed: " << err.what();
+    }
+    return QByteArray();
+}
 
-        const char* buffer = reinterpret_cast<const char*>(reply.data());
-        auto fb_behavior_tree = Serialization::GetBehaviorTree( buffer );
+void SidepanelMonitor::requestTree(Session& session)
+{
+    if( session.tree_watcher->isRunning() )
+    {
+        // wait for the current request, then start again
+        session.request_pending = true;
+        return;
+    }
+    session.request_pending = false;
+    session.request_generation = session.generation;
+    session.tree_watcher->setFuture( QtConcurrent::run( FetchTreeFromServer, &_zmq_context,
+                                                        session.address_req, _load_tree_timeout_ms ) );
+}
 
-        auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+void SidepanelMonitor::onTreeReceived(Session& session)
+{
+    const QByteArray reply = session.tree_watcher->result();
 
-        _loaded_tree  = std::move( res_pair.first );
-        _uid_to_index = std::move( res_pair.second );
+    // the connection changed while we were waiting: this tree is obsolete
+    if( session.request_pending || session.request_generation != session.generation )
+    {
+        if( session.state != ConnectionState::DISCONNECTED )
+        {
+            requestTree( session );
+        }
+        return;
+    }
+    if( session.state == ConnectionState::DISCONNECTED || session.state == ConnectionState::CONNECTED )
+    {
+        return;
+    }
 
-        // add new models to registry
-        for(const auto& tree_node: _loaded_tree.nodes())
+    if( !reply.isEmpty() && loadTree(session, reply) )
+    {
+        const bool first_tree = (session.state == ConnectionState::CONNECTING);
+        session.retry_delay_ms = _retry_min_delay_ms;
+        setState( session, ConnectionState::CONNECTED );
+        updateRecording( session );
+        if( first_tree )
         {
-            const auto& registration_ID = tree_node.model.registration_ID;
-            if( BuiltinNodeModels().count(registration_ID) == 0)
+            if( !_timer->isActive() )
             {
-                addNewModel( tree_node.model );
+                _timer->start(_timer_period_ms);
             }
+            if( &session == _current )
+            {
+                updateSessionWidgets();
+            }
+        }
+        return;
+    }
+
+    if( session.state == ConnectionState::CONNECTING )
+    {
+        disconnectFromServer( session );
+        QMessageBox::warning(this,
+                             tr("ZeroMQ connection"),
+                             tr("Was not able to connect to [%1]\n").arg(session.address_pub.c_str()),
+                             QMessageBox::Close);
+        return;
+    }
+
+    // keep the last tree displayed and try again later
+    setState( session, ConnectionState::WAITING_RETRY );
+    session.retry_timer->start( session.retry_delay_ms );
+    session.retry_delay_ms = std::min( session.retry_delay_ms * 2, int(_retry_max_delay_ms) );
+}
+
+void SidepanelMonitor::onRetryTimer(Session& session)
+{
+    if( session.state == ConnectionState::WAITING_RETRY )
+    {
+        setState( session, ConnectionState::RELOADING );
+        requestTree( session );
+    }
+}
+
+void SidepanelMonitor::setState(Session& session, ConnectionState state)
+{
+    session.state = state;
+    if( &session != _current )
+    {
+        return;
+    }
+    switch( state )
+    {
+    case ConnectionState::DISCONNECTED:
+        ui->labelState->setText( tr("Disconnected") ); break;
+    case ConnectionState::CONNECTING:
+        ui->labelState->setText( tr("Downloading the tree...") ); break;
+    case ConnectionState::CONNECTED:
+        ui->labelState->setText( tr("Connected") ); break;
+    case ConnectionState::RELOADING:
+        ui->labelState->setText( tr("The tree changed, downloading it...") ); break;
+    case ConnectionState::WAITING_RETRY:
+        ui->labelState->setText( tr("Tree not available, retry in %1 ms").arg(session.retry_delay_ms) ); break;
+    }
+}
+
+void SidepanelMonitor::updateSessionWidgets()
+{
+    const QSignalBlocker blocker( ui->comboBoxSession );
+    ui->comboBoxSession->setCurrentIndex( ui->comboBoxSession->findText(_current->bt_name) );
+
+    ui->lineEdit_address->setText( _current->address );
+    ui->lineEdit_publisher->setText( _current->publisher_port );
+    ui->lineEdit_server->setText( _current->server_port );
+
+    {
+        const QSignalBlocker blocker_policy( ui->comboBoxBackpressure );
+        ui->comboBoxBackpressure->setCurrentIndex( int(_current->backpressure) );
+    }
+
+    const bool disconnected = (_current->state == ConnectionState::DISCONNECTED);
+    ui->lineEdit_address->setDisabled( !disconnected );
+    ui->lineEdit_publisher->setDisabled( !disconnected );
+    ui->comboBoxBackpressure->setDisabled( !disconnected );
+
+    setState( *_current, _current->state );
+    updateLabelCount();
+    updateMetricsWidgets();
+    updateRecordWidgets();
+    updateRewindWidgets();
+    connectionUpdate( isConnected(*_current) );
+}
+
+void SidepanelMonitor::on_comboBoxSession_currentIndexChanged(int index)
+{
+    if( index < 0 || index >= int(_sessions.size()) )
+    {
+        return;
+    }
+    // keep what was typed for the previous session
+    _current->address        = ui->lineEdit_address->text();
+    _current->publisher_port = ui->lineEdit_publisher->text();
+    _current->server_port    = ui->lineEdit_server->text();
+
+    _current = _sessions[size_t(index)].get();
+    updateSessionWidgets();
+}
+
+void SidepanelMonitor::on_pushButtonAddSession_clicked()
+{
+    _current->address        = ui->lineEdit_address->text();
+    _current->publisher_port = ui->lineEdit_publisher->text();
+    _current->server_port    = ui->lineEdit_server->text();
+
+    _current = addSession();
+    updateSessionWidgets();
+}
+
+void SidepanelMonitor::on_pushButtonRemoveSession_clicked()
+{
+    if( _sessions.size() <= 1 )
+    {
+        return;
+    }
+    Session* session = _current;
+    // the tab of the session is left to the user
+    _current = (_sessions.front().get() != session) ? _sessions.front().get() : _sessions[1].get();
+    removeSession( session );
+    updateSessionWidgets();
+}
+
+void SidepanelMonitor::setRewindLimits(double max_seconds, size_t max_bytes)
+{
+    _rewind_max_seconds = max_seconds;
+    _rewind_max_bytes = max_bytes;
+    for(const auto& session: _sessions)
+    {
+        session->rewind.setLimits( max_seconds, max_bytes );
+    }
+}
+
+void SidepanelMonitor::updateRewindWidgets()
+{
+    const QSignalBlocker blocker_button( ui->pushButtonPause );
+    const QSignalBlocker blocker_slider( ui->sliderRewind );
+
+    ui->pushButtonPause->setChecked( _current->paused );
+    ui->pushButtonPause->setEnabled( _current->paused || !_current->rewind.empty() );
+    ui->sliderRewind->setEnabled( _current->paused );
+
+    if( !_current->paused )
+    {
+        ui->sliderRewind->setRange( 0, 0 );
+        ui->labelRewind->setText( tr("Live") );
+        return;
+    }
+
+    const RewindBuffer& buffer = _current->rewind_snapshot;
+    ui->sliderRewind->setRange( 0, std::max( int(buffer.size()) - 1, 0 ) );
+    ui->sliderRewind->setValue( int(_current->rewind_position) );
+    if( buffer.empty() )
+    {
+        ui->labelRewind->setText( tr("Paused") );
+        return;
+    }
+    const double time = buffer.timestamp(_current->rewind_position) - buffer.timestamp(buffer.size() - 1);
+    ui->labelRewind->setText( tr("Paused: %1 s (%2/%3)")
+                              .arg( time, 0, 'f', 3 )
+                              .arg( _current->rewind_position + 1 )
+                              .arg( buffer.size() ) );
+}
+
+void SidepanelMonitor::on_pushButtonPause_clicked(bool checked)
+{
+    if( checked )
+    {
+        pause( *_current );
+    }
+    else{
+        resume( *_current );
+    }
+}
+
+void SidepanelMonitor::on_sliderRewind_valueChanged(int value)
+{
+    if( _current->paused && value >= 0 )
+    {
+        onRewind( *_current, size_t(value) );
+    }
+}
+
+void SidepanelMonitor::pause(Session &session)
+{
+    // the reception goes on in session.rewind, this copy doesn't change
+    session.paused = true;
+    session.rewind_snapshot = session.rewind;
+    session.rewind_position = session.rewind_snapshot.empty() ? 0 : session.rewind_snapshot.size() - 1;
+    if( &session == _current )
+    {
+        updateRewindWidgets();
+    }
+}
+
+void SidepanelMonitor::resume(Session &session)
+{
+    session.paused = false;
+    session.rewind_snapshot.clear();
+
+    // back to the live status, the transitions received meanwhile included
+    if( !session.tree_hash.isEmpty() )
+    {
+        session.status_delta.set( TreeStatus(session.tree) );
+        const auto node_status = session.status_delta.takeDelta();
+        if( !node_status.empty() )
+        {
+            emit changeNodeStyle( session.bt_name, node_status );
         }
+        emitTimings( session, true );
+    }
+    if( &session == _current )
+    {
+        updateRewindWidgets();
+    }
+}
+
+void SidepanelMonitor::emitTimings(Session &session, bool all_nodes)
+{
+    const bool visible = ui->checkBoxTimings->isChecked();
+    std::vector<int> nodes = session.timings.takeChanged();
+    if( all_nodes )
+    {
+        nodes.resize( session.tree.nodesCount() );
+        std::iota( nodes.begin(), nodes.end(), 0 );
+    }
+    else if( !visible )
+    {
+        return;
+    }
 
-        try {
-            loadBehaviorTree( _loaded_tree, "BehaviorTree" );
+    std::vector<std::pair<int, QString>> labels;
+    labels.reserve( nodes.size() );
+    for (int index: nodes)
+    {
+        labels.push_back( { index, visible ? NodeTimings::toText( session.timings.values(index) ) : QString() } );
+    }
+    if( !labels.empty() )
+    {
+        emit changeNodeTimings( session.bt_name, labels );
+    }
+}
+
+void SidepanelMonitor::on_checkBoxTimings_toggled(bool)
+{
+    // the badges of every node are added, or removed
+    for(const auto& session: _sessions)
+    {
+        if( !session->tree_hash.isEmpty() && !session->paused )
+        {
+            emitTimings( *session, true );
         }
-        catch (std::exception& err) {
-            QMessageBox messageBox;
-            messageBox.critical(this,"Error Connecting to remote server", err.what() );
-            messageBox.show();
-            return false;
+    }
+}
+
+void SidepanelMonitor::onRewind(Session &session, size_t position)
+{
+    const RewindBuffer& buffer = session.rewind_snapshot;
+    if( buffer.empty() )
+    {
+        return;
+    }
+    position = std::min( position, buffer.size() - 1 );
+    const size_t prev_position = session.rewind_position;
+    session.rewind_position = position;
+
+    if( position > prev_position && position - prev_position <= RewindBuffer::CHECKPOINT_PERIOD )
+    {
+        // step forward: apply only the transitions in between
+        for (size_t t = prev_position + 1; t <= position; t++)
+        {
+            session.status_delta.add( buffer.index(t), buffer.status(t) );
         }
+    }
+    else if( position != prev_position ){
+        session.status_delta.set( buffer.statusAt(position) );
+    }
 
-        std::vector<std::pair<int, NodeStatus>> node_status;
-        node_status.reserve(_loaded_tree.nodesCount());
+    const auto node_status = session.status_delta.takeDelta();
+    if( !node_status.empty() )
+    {
+        emit changeNodeStyle( session.bt_name, node_status );
+    }
+    if( &session == _current )
+    {
+        updateRewindWidgets();
+    }
+}
 
-        //  qDebug() << "--------";
+void SidepanelMonitor::updateRecordWidgets()
+{
+    const QSignalBlocker blocker( ui->pushButtonRecord );
+    const LogRecorder* recorder = _current->recorder.get();
+    ui->pushButtonRecord->setChecked( !_current->record_filename.isEmpty() );
+
+    if( _current->record_filename.isEmpty() )
+    {
+        ui->labelRecord->setText( tr("Not recording") );
+    }
+    else if( !recorder )
+    {
+        ui->labelRecord->setText( tr("Recording: waiting for the tree") );
+    }
+    else if( recorder->failed() )
+    {
+        ui->labelRecord->setText( tr("Recording to %1 failed")
+                                  .arg( QFileInfo(recorder->filename()).fileName() ) );
+    }
+    else{
+        ui->labelRecord->setText( tr("Recording to %1 (%2 kB)")
+                                  .arg( QFileInfo(recorder->filename()).fileName() )
+                                  .arg( recorder->bytesWritten() / 1024 ) );
+    }
+}
 
-        for(size_t t=0; t < _loaded_tree.nodesCount(); t++)
+void SidepanelMonitor::on_pushButtonRecord_clicked(bool checked)
+{
+    if( !checked )
+    {
+        stopRecording( *_current );
+        updateRecordWidgets();
+        return;
+    }
+
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelMonitor.lastRecordDirectory",
+                                             QDir::homePath() ).toString();
+
+    QString filename = QFileDialog::getSaveFileName(this, "Record the tree to log file",
+                                                    directory_path, "Flatbuffers log (*.fbl)");
+    if( !filename.isEmpty() )
+    {
+        if( !filename.endsWith(".fbl") )
         {
-            node_status.push_back( { t, _loaded_tree.nodes()[t].status } );
+            filename.append(".fbl");
         }
-        emit changeNodeStyle( "BehaviorTree", node_status );
+        settings.setValue("SidepanelMonitor.lastRecordDirectory",
+                          QFileInfo(filename).absolutePath() );
+        startRecording( *_current, filename );
     }
-    catch( zmq::error_t& err)
+    updateRecordWidgets();
+}
+
+void SidepanelMonitor::startRecording(Session &session, const QString &filename)
+{
+    stopRecording( session );
+    session.record_filename = filename;
+    updateRecording( session );
+}
+
+void SidepanelMonitor::stopRecording(Session &session)
+{
+    session.recorder.reset();
+    session.record_filename.clear();
+    session.recorded_tree.clear();
+    session.frame_records.clear();
+    session.record_part = 0;
+}
+
+void SidepanelMonitor::updateRecording(Session &session)
+{
+    if( session.record_filename.isEmpty() || !isConnected(session) ||
+        session.tree_buffer.isEmpty() )
     {
-        qDebug() << "ZMQ client receive failed: " << err.what();
+        return;
+    }
+    if( session.recorder && session.recorded_tree == session.tree_buffer )
+    {
+        return;
+    }
+
+    // a .fbl contains a single tree: file.fbl, file_2.fbl, file_3.fbl...
+    session.record_part++;
+    QString filename = session.record_filename;
+    if( session.record_part > 1 )
+    {
+        const QFileInfo info( session.record_filename );
+        filename = info.path() + "/" + info.completeBaseName() +
+                   QString("_%1.").arg(session.record_part) + info.suffix();
+    }
+
+    std::unique_ptr<LogRecorder> recorder( new LogRecorder );
+    if( !recorder->open( filename, session.tree_buffer ) )
+    {
+        stopRecording( session );
+        QMessageBox::warning(this, tr("Recording"),
+                             tr("Can't write the file [%1]").arg(filename),
+                             QMessageBox::Close);
+        if( &session == _current ) updateRecordWidgets();
+        return;
+    }
+    session.recorder = std::move(recorder);
+    session.recorded_tree = session.tree_buffer;
+    session.frame_records.clear();
+
+    // the nodes that are not IDLE "become" active at the beginning of the file,
+    // as in the logs of BT::FileLogger
+    if( session.last_timestamp == 0 )
+    {
+        session.last_timestamp = QDateTime::currentMSecsSinceEpoch() * 0.001;
+    }
+    auto fb_behavior_tree = Serialization::GetBehaviorTree( session.tree_buffer.constData() );
+    QByteArray snapshot;
+    int index = 1;
+    for( const Serialization::TreeNode* fb_node: *(fb_behavior_tree->nodes()) )
+    {
+        const NodeStatus status = session.tree.node(index++)->status;
+        if( status != NodeStatus::IDLE )
+        {
+            ReplayLogFormat::appendRecord( snapshot, TimestampUsec(session.last_timestamp), fb_node->uid(),
+                                           uint8_t(NodeStatus::IDLE), uint8_t(status) );
+        }
+    }
+    session.recorder->append( snapshot );
+
+    if( &session == _current ) updateRecordWidgets();
+}
+
+bool SidepanelMonitor::loadTree(Session& session, const QByteArray& reply, bool from_disk_cache)
+{
+    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(reply.constData()),
+                                    size_t(reply.size()) );
+    if( !Serialization::VerifyBehaviorTreeBuffer(verifier) )
+    {
+        qDebug() << "Invalid tree received from the server";
         return false;
     }
+
+    auto fb_behavior_tree = Serialization::GetBehaviorTree( reply.constData() );
+    const QByteArray hash = TreeStructureHash( fb_behavior_tree );
+
+    if( !from_disk_cache )
+    {
+        storeTreeOnDisk( session, hash, reply );
+    }
+
+    auto updateStatus = [&session, fb_behavior_tree]()
+    {
+        // the indices are the same of BuildTreeFromFlatbuffers
+        int index = 1;
+        for( const Serialization::TreeNode* fb_node: *(fb_behavior_tree->nodes()) )
+        {
+            session.tree.node(index++)->status = convert( fb_node->status() );
+        }
+    };
+
+    if( !session.tree_hash.isEmpty() && hash == session.tree_hash )
+    {
+        // the scene already shows this tree, only the UIDs may be different
+        session.uid_to_index = UidToIndexFromFlatbuffers( fb_behavior_tree );
+        session.tree_buffer = reply;
+        const std::vector<NodeStatus> prev_status = TreeStatus( session.tree );
+        updateStatus();
+        // same indices: the history is still valid
+        for(size_t t=0; t < session.tree.nodesCount(); t++)
+        {
+            const NodeStatus status = session.tree.nodes()[t].status;
+            if( status != prev_status[t] )
+            {
+                session.rewind.push_back( int(t), status, session.last_timestamp );
+            }
+        }
+        if( session.paused )
+        {
+            return true;
+        }
+        for(size_t t=0; t < session.tree.nodesCount(); t++)
+        {
+            session.status_delta.add( int(t), session.tree.nodes()[t].status );
+        }
+        const auto node_status = session.status_delta.takeDelta();
+        if( !node_status.empty() )
+        {
+            emit changeNodeStyle( session.bt_name, node_status );
+        }
+        return true;
+    }
+
+    auto cached = _tree_cache.find( hash );
+    if( cached != _tree_cache.end() )
+    {
+        session.tree         = cached->second.toAbsTree();
+        session.uid_to_index = UidToIndexFromFlatbuffers( fb_behavior_tree );
+        updateStatus();
+    }
+    else{
+        auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+
+        session.tree         = std::move( res_pair.first );
+        session.uid_to_index = std::move( res_pair.second );
+
+        if( _tree_cache_order.size() >= TREE_CACHE_SIZE )
+        {
+            _tree_cache.erase( _tree_cache_order.front() );
+            _tree_cache_order.pop_front();
+        }
+        _tree_cache.insert( { hash, CompactTree( session.tree ) } );
+        _tree_cache_order.push_back( hash );
+    }
+
+    // add new models to registry, all at once
+    NodeModels new_models;
+    for(const auto& tree_node: session.tree.nodes())
+    {
+        const auto& registration_ID = tree_node.model.registration_ID;
+        if( BuiltinNodeModels().count(registration_ID) == 0)
+        {
+            new_models.insert( { registration_ID, tree_node.model } );
+        }
+    }
+    addNewModels( new_models );
+
+    try {
+        loadBehaviorTree( session.tree, session.bt_name );
+    }
+    catch (std::exception& err) {
+        QMessageBox messageBox;
+        messageBox.critical(this,"Error Connecting to remote server", err.what() );
+        messageBox.show();
+        session.tree_hash.clear();
+        return false;
+    }
+    session.tree_hash = hash;
+    session.tree_buffer = reply;
+
+    // a different tree: the history and the paused view are obsolete
+    session.rewind.reset( TreeStatus(session.tree) );
+    session.paused = false;
+    session.rewind_snapshot.clear();
+    if( &session == _current )
+    {
+        updateRewindWidgets();
+    }
+
+    // the scene was rebuilt: send the status of every node. Its badges
+    // were destroyed with the nodes
+    session.status_delta.reset( session.tree.nodesCount() );
+    session.timings.reset( session.tree.nodesCount() );
+    for(size_t t=0; t < session.tree.nodesCount(); t++)
+    {
+        session.status_delta.add( int(t), session.tree.nodes()[t].status );
+    }
+    emit changeNodeStyle( session.bt_name, session.status_delta.takeDelta() );
     return true;
 }
 
+static QString TreeCacheDirectory()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/monitor_trees";
+}
+
+static QString TreeCacheSettingsKey(const std::string& address)
+{
+    // the address contains characters that QSettings uses as separators
+    return "SidepanelMonitor/treeCache/" + QByteArray( address.c_str() ).toHex();
+}
+
+void SidepanelMonitor::storeTreeOnDisk(const Session& session, const QByteArray &hash, const QByteArray &reply)
+{
+    const QString directory = TreeCacheDirectory();
+    QDir().mkpath( directory );
+    QFile file( directory + "/" + hash + ".fbs" );
+    if( !file.exists() && file.open(QIODevice::WriteOnly) )
+    {
+        file.write( reply );
+    }
+
+    // the last tree of this server, displayed immediately at the next connection
+    QSettings settings;
+    settings.setValue( TreeCacheSettingsKey(session.address_req), QString(hash) );
+}
+
+bool SidepanelMonitor::loadTreeFromDisk(Session& session)
+{
+    QSettings settings;
+    const QString hash = settings.value( TreeCacheSettingsKey(session.address_req) ).toString();
+    if( hash.isEmpty() )
+    {
+        return false;
+    }
+    QFile file( TreeCacheDirectory() + "/" + hash + ".fbs" );
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+    return loadTree( session, file.readAll(), true );
+}
+
+void SidepanelMonitor::disconnectFromServer(Session& session)
+{
+    const bool was_connected = isConnected( session );
+    _receiver.removeSubscriber( session.generation );
+    // the messages and the trees still on their way are ignored
+    session.generation = ++_generation_counter;
+    session.retry_timer->stop();
+    setState( session, ConnectionState::DISCONNECTED );
+
+    bool any_connected = false;
+    for(const auto& other: _sessions)
+    {
+        any_connected = any_connected || (other->state != ConnectionState::DISCONNECTED);
+    }
+    if( !any_connected )
+    {
+        _timer->stop();
+    }
+
+    if( &session == _current )
+    {
+        ui->lineEdit_address->setDisabled(false);
+        ui->lineEdit_publisher->setDisabled(false);
+        ui->comboBoxBackpressure->setDisabled(false);
+        if( was_connected )
+        {
+            connectionUpdate(false);
+        }
+    }
+}
+
+// "localhost" -> "tcp://localhost:1666". An address with a transport is
+// kept: "ipc:///tmp/groot" -> "ipc:///tmp/groot:1666", while "shm://groot"
+// is the same segment for the messages and the tree
+static std::string Endpoint(const QString& address, const QString& port)
+{
+    const std::string text = address.toStdString();
+    if( !SharedMemoryRing::segmentName( text ).empty() )
+    {
+        return text;
+    }
+    if( address.contains("://") )
+    {
+        return text + ":" + port.toStdString();
+    }
+    return "tcp://" + text + ":" + port.toStdString();
+}
+
+void SidepanelMonitor::connectToServer(Session& session)
+{
+    bool failed = false;
+    if( !session.address.isEmpty() )
+    {
+        session.address_pub = Endpoint( session.address, session.publisher_port );
+        session.address_req = Endpoint( session.address, session.server_port );
+
+        try{
+            _receiver.addSubscriber( session.generation, session.address_pub, session.backpressure );
+        }
+        catch(std::exception& err)
+        {
+            qDebug() << "Connection failed: " << err.what();
+            failed = true;
+        }
+    }
+    else {
+        failed = true;
+    }
+
+    if( !failed )
+    {
+        // the tree is downloaded in background, see onTreeReceived
+        session.retry_delay_ms = _retry_min_delay_ms;
+        session.metrics.reset();
+        session.metrics.setPolicy( MonitorReceiver::toStr(session.backpressure) );
+        if( &session == _current )
+        {
+            ui->comboBoxBackpressure->setDisabled(true);
+        }
+        setState( session, ConnectionState::CONNECTING );
+        requestTree( session );
+        // show the last tree of this server while the new one is downloaded
+        loadTreeFromDisk( session );
+        // After we try get a tree on connect, reset to the default timeout.
+        // This is done so that we only use the increased autoconnect timeout once.
+        this->set_load_tree_timeout_ms(_load_tree_default_timeout_ms);
+    }
+    else{
+        QMessageBox::warning(this,
+                             tr("ZeroMQ connection"),
+                             tr("Was not able to connect to [%1]\n").arg(session.address_pub.c_str()),
+                             QMessageBox::Close);
+    }
+}
+
 void SidepanelMonitor::on_Connect()
 {
-    if( !_connected )
+    if( _current->state == ConnectionState::DISCONNECTED )
     {
         QString address = ui->lineEdit_address->text();
         if( address.isEmpty() )
@@ -222,62 +1287,100 @@ void SidepanelMonitor::on_Connect()
         QString server_port = ui->lineEdit_server->text();
         if( server_port.isEmpty() )
         {
-          publisher_port = ui->lineEdit_server->placeholderText();
-          ui->lineEdit_server->setText(publisher_port);
+          server_port = ui->lineEdit_server->placeholderText();
+          ui->lineEdit_server->setText(server_port);
         }
 
-        bool failed = false;
-        if( !address.isEmpty() )
-        {
-            _connection_address_pub = "tcp://" + address.toStdString() + ":" + publisher_port.toStdString();
-            _connection_address_req = "tcp://" + address.toStdString() + ":" + server_port.toStdString();
-
-            try{
-                _zmq_subscriber.connect( _connection_address_pub.c_str() );
-
-                int timeout_ms = 1;
-                _zmq_subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
-                _zmq_subscriber.setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(int) );
+        _current->address        = address;
+        _current->publisher_port = publisher_port;
+        _current->server_port    = server_port;
+        connectToServer( *_current );
+    }
+    else{
+        disconnectFromServer( *_current );
+    }
+}
 
-                if( !getTreeFromServer() )
+std::vector<MemoryUsage> SidepanelMonitor::memoryUsage()
+{
+    std::vector<MemoryUsage> usages;
+    for(const auto& session_ptr: _sessions)
+    {
+        Session* session = session_ptr.get();
+        MemoryUsage rewind;
+        rewind.category = tr("Monitor");
+        rewind.name = tr("%1: rewind history").arg( session->bt_name );
+        rewind.bytes = session->rewind.memoryUsage() + session->rewind_snapshot.memoryUsage();
+        rewind.details = tr("%1 transitions, limits %2 s / %3")
+                             .arg( session->rewind.size() )
+                             .arg( session->rewind.maxSeconds() )
+                             .arg( FormatBytes( session->rewind.maxBytes() ) );
+        if( session->paused )
+        {
+            rewind.details += tr(", paused");
+        }
+        else if( !session->rewind.empty() )
+        {
+            // while paused, the scene shows the snapshot
+            rewind.release_label = tr("Clear the history");
+            // the session may be removed, or reconnected, while the dialog is open
+            const int generation = session->generation;
+            rewind.release = [this, generation]()
+            {
+                Session* session = sessionBySubscriber( generation );
+                if( !session || session->paused )
                 {
-                    failed = true;
-                    _connected = false;
+                    return;
                 }
-                // After we try get a tree on connect, reset to the default timeout.
-                // This is done so that we only use the increased autoconnect timeout once.
-                this->set_load_tree_timeout_ms(_load_tree_default_timeout_ms);
-            }
-            catch(zmq::error_t& err)
-            {
-                failed = true;
-            }
-        }
-        else {
-            failed = true;
+                session->rewind.reset( TreeStatus(session->tree) );
+                session->rewind_snapshot.clear();
+                updateRewindWidgets();
+            };
         }
+        usages.push_back( rewind );
 
-        if( !failed )
-        {
-            _connected = true;
-            ui->lineEdit_address->setDisabled(true);
-            ui->lineEdit_publisher->setDisabled(true);
-            _timer->start(_timer_period_ms);
-            connectionUpdate(true);
-        }
-        else{
-            QMessageBox::warning(this,
-                                 tr("ZeroMQ connection"),
-                                 tr("Was not able to connect to [%1]\n").arg(_connection_address_pub.c_str()),
-                                 QMessageBox::Close);
-        }
+        MemoryUsage buffers;
+        buffers.category = tr("Monitor");
+        buffers.name = tr("%1: tree and buffers").arg( session->bt_name );
+        buffers.bytes = size_t(session->tree_buffer.capacity()) +
+                        size_t(session->recorded_tree.capacity()) +
+                        size_t(session->frame_records.capacity()) +
+                        session->frame_transitions.capacity() * sizeof(MonitorReceiver::Transition) +
+                        session->tree.nodesCount() * sizeof(AbstractTreeNode);
+        buffers.details = tr("%1 nodes, %2 received")
+                              .arg( session->tree.nodesCount() )
+                              .arg( FormatBytes( size_t(session->tree_buffer.size()) ) );
+        usages.push_back( buffers );
     }
-    else{
-        _connected = false;
-        ui->lineEdit_address->setDisabled(false);
-        ui->lineEdit_publisher->setDisabled(false);
-        _timer->stop();
 
-        connectionUpdate(false);
+    MemoryUsage cache;
+    cache.category = tr("Monitor");
+    cache.name = tr("Cache of the trees");
+    for(const auto& it: _tree_cache)
+    {
+        cache.bytes += size_t(it.first.capacity()) + it.second.memoryUsage();
     }
+    cache.details = tr("%1 of %2 trees").arg( _tree_cache.size() ).arg( TREE_CACHE_SIZE );
+    if( !_tree_cache.empty() )
+    {
+        // the trees are downloaded again, or read from the disk cache
+        cache.release_label = tr("Clear the cache");
+        cache.release = [this]()
+        {
+            _tree_cache.clear();
+            _tree_cache_order.clear();
+        };
+    }
+    usages.push_back( cache );
+
+    MemoryUsage queue;
+    queue.category = tr("Monitor");
+    queue.name = tr("Receiver queue");
+    queue.bytes = _receiver.queueSize() * sizeof(MonitorReceiver::Batch);
+    queue.details = tr("%1 of %2 batches, largest %3")
+                        .arg( _receiver.queueSize() )
+                        .arg( MonitorReceiver::QUEUE_CAPACITY )
+                        .arg( _queue_depth_max );
+    usages.push_back( queue );
+    return usages;
 }
@@ -2,9 +2,22 @@
 #define SIDEPANEL_MONITOR_H
 
 #include <QFrame>
+#include <QJsonObject>
+#include <QFutureWatcher>
+#include <deque>
+#include <map>
+#include <memory>
 #include <zmq.hpp>
 
 #include "bt_editor_base.h"
+#include "compact_tree.h"
+#include "status_delta.h"
+#include "monitor_receiver.h"
+#include "log_recorder.h"
+#include "rewind_buffer.h"
+#include "monitor_metrics.h"
+#include "node_timings.h"
+#include "memory_report.h"
 
 namespace Ui {
 class SidepanelMonitor;
@@ -15,12 +28,17 @@ class SidepanelMonitor : public QFrame
     Q_OBJECT
 
 public:
-    /// Timer period in milliseconds.
+    /// Timer period in milliseconds: the messages received in a period are
+    /// merged and displayed as a single update.
     static constexpr int _timer_period_ms = 20;
     /// Default timeout to get behavior tree, in milliseconds.
     static constexpr int _load_tree_default_timeout_ms = 1000;
     /// Timeout to get behavior tree during autoconnect, in milliseconds.
     static constexpr int _load_tree_autoconnect_timeout_ms = 10000;
+    /// Delay before downloading again a tree that was not available, doubled
+    /// at every failure, in milliseconds.
+    static constexpr int _retry_min_delay_ms = 250;
+    static constexpr int _retry_max_delay_ms = 5000;
 
     explicit SidepanelMonitor(QWidget *parent = nullptr,
                               const QString &address = "",
@@ -35,14 +53,50 @@ public:
         _load_tree_timeout_ms = timeout_ms;
     };
 
+    /// Size of the rewind buffer of each session: the last max_seconds or
+    /// max_bytes of transitions, whichever is reached first.
+    void setRewindLimits(double max_seconds, size_t max_bytes);
+
+    /// Emit transitionsReceived with all the transitions of each update.
+    void setKeepTransitions(bool keep) { _keep_transitions = keep; }
+
+    /// Messages of the current session that were displayed together with a previous one.
+    int mergedMessagesCount() const { return int(_current->metrics.values().merged_messages); }
+
+    /// Metrics of the receiver and of all the sessions, see MonitorMetrics.
+    QJsonObject metricsJson() const;
+
+    /// Rewind buffers and recording buffers of the sessions, cached trees and
+    /// queue of the receiver.
+    std::vector<MemoryUsage> memoryUsage();
+
 public slots:
 
+    /// Connect or disconnect the current session.
     void on_Connect();
 
 private slots:
 
     void on_timer();
 
+    void on_comboBoxSession_currentIndexChanged(int index);
+
+    void on_pushButtonAddSession_clicked();
+
+    void on_pushButtonRemoveSession_clicked();
+
+    void on_pushButtonRecord_clicked(bool checked);
+
+    void on_pushButtonPause_clicked(bool checked);
+
+    void on_sliderRewind_valueChanged(int value);
+
+    void on_pushButtonSaveMetrics_clicked();
+
+    void on_comboBoxBackpressure_currentIndexChanged(int index);
+
+    void on_checkBoxTimings_toggled(bool checked);
+
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString &bt_name );
 
@@ -51,26 +105,146 @@ signals:
     void changeNodeStyle(const QString& bt_name,
                          const std::vector<std::pair<int, NodeStatus>>& node_status);
 
-    void addNewModel(const NodeModel &new_model);
+    void addNewModels(const NodeModels &new_models);
+
+    void transitionsReceived(const QString& bt_name,
+                             const std::vector<MonitorReceiver::Transition>& transitions);
+
+    /// Text of the timing badges of the nodes, by index. An empty text
+    /// removes the badge. See NodeTimings.
+    void changeNodeTimings(const QString& bt_name,
+                           const std::vector<std::pair<int, QString>>& labels);
 
 private:
     Ui::SidepanelMonitor *ui;
 
+    // shared by all the sessions
     zmq::context_t _zmq_context;
-    zmq::socket_t  _zmq_subscriber;
+    MonitorReceiver _receiver;
 
     QTimer* _timer;
 
-    bool _connected;
-    std::string _connection_address_pub;
-    std::string _connection_address_req;
-    int _msg_count;
+    enum class ConnectionState{
+        DISCONNECTED,
+        CONNECTING,     // first download of the tree
+        CONNECTED,
+        RELOADING,      // the tree changed, downloading the new one
+        WAITING_RETRY   // the download failed, waiting for retry_timer
+    };
+
+    // A monitored robot, displayed in the tab bt_name.
+    struct Session
+    {
+        QString bt_name;
+        // content of the line edits
+        QString address;
+        QString publisher_port;
+        QString server_port;
+        MonitorReceiver::Backpressure backpressure = MonitorReceiver::Backpressure::LOSSLESS;
+
+        ConnectionState state = ConnectionState::DISCONNECTED;
+        std::string address_pub;
+        std::string address_req;
+        MonitorMetrics metrics;
+
+        // the last message was decoded with the compact protocol
+        bool compact_protocol = false;
+        // of the current frame of on_timer
+        int frame_messages = 0;
+        std::vector<double> frame_decode_times;
+        std::vector<MonitorReceiver::Transition> frame_transitions;
+
+        AbsBehaviorTree tree;
+        UidLookupTable uid_to_index;
+        QByteArray tree_hash;
+        // as received from the server
+        QByteArray tree_buffer;
+        // status of the nodes in the scene, to emit only what changed
+        NodeStatusDelta status_delta;
+        // from the timestamps of the transitions, shown by the badges
+        NodeTimings timings;
+
+        QFutureWatcher<QByteArray>* tree_watcher = nullptr;
+        QTimer* retry_timer = nullptr;
+        // unique among all the sessions, it is also the id of the subscriber
+        int generation = 0;
+        int request_generation = 0;
+        bool request_pending = false;
+        int retry_delay_ms = _retry_min_delay_ms;
+
+        // Recording to .fbl, empty record_filename if not recording. A new
+        // file (part) is started every time the tree changes.
+        QString record_filename;
+        int record_part = 0;
+        QByteArray recorded_tree;
+        std::unique_ptr<LogRecorder> recorder;
+        QByteArray frame_records;
+
+        // timestamp of the last transition received, and its steadyTime()
+        double last_timestamp = 0;
+        double last_timestamp_received = 0;
+
+        // the recent history. While paused, the scene shows rewind_snapshot
+        // at rewind_position, and the live updates are only stored here.
+        RewindBuffer rewind;
+        bool paused = false;
+        RewindBuffer rewind_snapshot;
+        size_t rewind_position = 0;
+    };
+    std::vector<std::unique_ptr<Session>> _sessions;
+    Session* _current;
+    int _generation_counter;
+
+    Session* addSession();
+    void removeSession(Session* session);
+    Session* sessionBySubscriber(int subscriber_id);
+    bool isConnected(const Session& session) const;
+
+    void setState(Session& session, ConnectionState state);
+    // show the current session in the widgets
+    void updateSessionWidgets();
+    void updateLabelCount();
+    void updateMetricsWidgets();
+    void updateRecordWidgets();
+    void updateRewindWidgets();
+
+    void pause(Session& session);
+    void resume(Session& session);
+    // show the paused session at a position of its rewind_snapshot
+    void onRewind(Session& session, size_t position);
+
+    // the badges of the nodes whose timings changed, or of all of them
+    void emitTimings(Session& session, bool all_nodes);
+
+    void startRecording(Session& session, const QString& filename);
+    void stopRecording(Session& session);
+    // start a new part if the tree is not the one in the current file
+    void updateRecording(Session& session);
+
+    bool _keep_transitions;
+    // sampled at every on_timer
+    size_t _queue_depth;
+    size_t _queue_depth_max;
+    double _rewind_max_seconds;
+    size_t _rewind_max_bytes;
 
     int _load_tree_timeout_ms;  // Timeout to get behavior tree.
-    AbsBehaviorTree _loaded_tree;
-    std::unordered_map<int, int> _uid_to_index;
 
-    bool getTreeFromServer();
+    // Trees already built, by TreeStructureHash, shared by all the sessions.
+    // The last tree of each server is also stored on disk.
+    static const size_t TREE_CACHE_SIZE = 8;
+    std::map<QByteArray, CompactTree> _tree_cache;
+    std::deque<QByteArray> _tree_cache_order;
+    void storeTreeOnDisk(const Session& session, const QByteArray& hash, const QByteArray& reply);
+    bool loadTreeFromDisk(Session& session);
+
+    // download the tree in background, the result goes to onTreeReceived
+    void requestTree(Session& session);
+    void onTreeReceived(Session& session);
+    void onRetryTimer(Session& session);
+    bool loadTree(Session& session, const QByteArray& reply, bool from_disk_cache = false);
+    void connectToServer(Session& session);
+    void disconnectFromServer(Session& session);
 
     QWidget *_parent;
 
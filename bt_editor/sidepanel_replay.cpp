@@ -5,146 +5,244 @@
 #include <QFile>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QFileInfo>
+#include <QDateTime>
 #include <QFileDialog>
 #include <QSettings>
 #include <QKeyEvent>
-#include <QStandardItem>
 #include <QModelIndex>
 #include <QTimer>
 #include <QMessageBox>
+#include <QMutexLocker>
+#include <QFileSystemWatcher>
+#include <QStandardItemModel>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QToolButton>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 #include "bt_editor_base.h"
 #include "mainwindow.h"
 #include "utils.h"
+#include "replay_log_format.h"
+#include "replay_comparison.h"
+#include "trace_recorder.h"
 
 
 SidepanelReplay::SidepanelReplay(QWidget *parent) :
     QFrame(parent),
     ui(new Ui::SidepanelReplay),
     _prev_row(-1),
-    _parent(parent)
+    _play_virtual_time(0),
+    _parent(parent),
+    _mapped_log(nullptr),
+    _log_buffer(nullptr),
+    _log_buffer_size(0),
+    _pending_timeline_changed(false),
+    _parse_cancel(false),
+    _parse_error(false),
+    _parse_progress(0),
+    _parse_total_transitions(0),
+    _last_timepoint_timestamp(0),
+    _use_index(false),
+    _parsed_end_offset(0),
+    _appending(false)
 {
     ui->setupUi(this);
 
-    _table_model = new QStandardItemModel(0,4, this);
+    _table_model = new ReplayTableModel(_loaded_tree, _transitions, _timepoint, this);
 
-    _table_model->setHeaderData(0,Qt::Horizontal, "Time");
-    _table_model->setHeaderData(1,Qt::Horizontal, "Node Name");
-    _table_model->setHeaderData(2,Qt::Horizontal, "Previous");
-    _table_model->setHeaderData(3,Qt::Horizontal, "Status");
+    _filter_model = new ReplayFilterModel(this);
+    _filter_model->setSourceModel(_table_model);
 
-    ui->tableView->setModel(_table_model);
+    ui->tableView->setModel(_filter_model);
+
+    _statistics_model = new QStandardItemModel(0, 6, this);
+    _statistics_model->setHorizontalHeaderLabels( {"Node Name", "Executions", "Success %",
+                                                   "Min [ms]", "Mean [ms]", "P99 [ms]"} );
+    ui->tableViewStatistics->setModel(_statistics_model);
+    ui->tableViewStatistics->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->tableViewStatistics->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
     ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
 
+    _comparison_model = new QStandardItemModel(0, 9, this);
+    _comparison_model->setHorizontalHeaderLabels( {"Node Name", "Ticks", "Result diff", "Timing diff",
+                                                   "Mean A [ms]", "Mean B [ms]", "Mean B-A [ms]",
+                                                   "Max |B-A| [ms]", "First tick"} );
+    ui->tableViewComparison->setModel(_comparison_model);
+    ui->tableViewComparison->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->tableViewComparison->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    _timeline = new ReplayTimeline(this);
+    ui->verticalLayout->insertWidget( ui->verticalLayout->indexOf(ui->timeSlider) + 1, _timeline );
+    connect( _timeline, &ReplayTimeline::timeSelected, this, &SidepanelReplay::onTimelineTimeSelected );
+
+    // go to a time, the failures and the bookmarks, below the timeline
+    _line_edit_time = new QLineEdit(this);
+    _line_edit_time->setPlaceholderText( tr("Go to time: 12.5, +3, @13:45:02, 2026-10-14 13:45:02") );
+    _line_edit_time->setToolTip( tr("Seconds since the start (12.5 or 1:02.5), relative to the current "
+                                    "transition (+3 or -0.5), a wall clock time on the day of the log "
+                                    "(@13:45:02.250), a date and time, or seconds since epoch") );
+    connect( _line_edit_time, &QLineEdit::returnPressed, this, &SidepanelReplay::onGoToTime );
+    connect( _line_edit_time, &QLineEdit::textEdited, this, [this]()
+    {
+        _line_edit_time->setStyleSheet( QString() );
+    });
+
+    auto addButton = [this](QHBoxLayout* layout, const QString& text, const QString& tooltip,
+                            std::function<int()> target)
+    {
+        QToolButton* button = new QToolButton(this);
+        button->setText( text );
+        button->setToolTip( tooltip );
+        layout->addWidget( button );
+        connect( button, &QToolButton::clicked, this, [this, target]()
+        {
+            jumpToRow( target() );
+        });
+        return button;
+    };
+    QHBoxLayout* navigation_layout = new QHBoxLayout();
+    navigation_layout->setContentsMargins( 0, 0, 0, 0 );
+    addButton( navigation_layout, tr("< Fail"), tr("Previous FAILURE (Shift+F3, Ctrl for the same node)"),
+               [this]() { return adjacentFailure( _prev_row, false, false ); } );
+    addButton( navigation_layout, tr("Fail >"), tr("Next FAILURE (F3, Ctrl for the same node)"),
+               [this]() { return adjacentFailure( _prev_row, true, false ); } );
+    navigation_layout->addStretch();
+    QToolButton* bookmark_button = new QToolButton(this);
+    bookmark_button->setText( tr("Bookmark") );
+    bookmark_button->setToolTip( tr("Bookmark the current transition, or remove it (Ctrl+B)") );
+    navigation_layout->addWidget( bookmark_button );
+    connect( bookmark_button, &QToolButton::clicked, this, [this]()
+    {
+        if( _prev_row >= 0 )
+        {
+            toggleBookmark( _prev_row );
+        }
+    });
+    addButton( navigation_layout, tr("< Mark"), tr("Previous bookmark (Shift+F2)"),
+               [this]() { return adjacentRow( _bookmarks, _prev_row, false ); } );
+    addButton( navigation_layout, tr("Mark >"), tr("Next bookmark (F2)"),
+               [this]() { return adjacentRow( _bookmarks, _prev_row, true ); } );
+
+    const int timeline_position = ui->verticalLayout->indexOf(_timeline);
+    ui->verticalLayout->insertWidget( timeline_position + 1, _line_edit_time );
+    ui->verticalLayout->insertLayout( timeline_position + 2, navigation_layout );
+
     _layout_update_timer = new QTimer(this);
     _layout_update_timer->setSingleShot(true);
     connect( _layout_update_timer, &QTimer::timeout, this, &SidepanelReplay::onTimerUpdate );
 
 
     _play_timer = new QTimer(this);
-    _play_timer->setSingleShot(true);
+    _play_timer->setInterval( 1000 / PLAY_FRAME_RATE );
+    _play_timer->setTimerType( Qt::PreciseTimer );
     connect( _play_timer, &QTimer::timeout, this, &SidepanelReplay::onPlayUpdate );
 
+    _follow_watcher = new QFileSystemWatcher(this);
+    connect( _follow_watcher, &QFileSystemWatcher::fileChanged, this, &SidepanelReplay::onFollowUpdate );
+
+    _follow_timer = new QTimer(this);
+    _follow_timer->setInterval(1000);
+    connect( _follow_timer, &QTimer::timeout, this, &SidepanelReplay::onFollowUpdate );
+
+    _parse_timer = new QTimer(this);
+    _parse_timer->setInterval(100);
+    connect( _parse_timer, &QTimer::timeout, this, &SidepanelReplay::onParseTimer );
+
+    ui->progressBar->setRange(0, 1000);
+    ui->progressBar->setVisible( false );
+    ui->pushButtonCancel->setVisible( false );
+
     ui->tableView->installEventFilter(this);
 }
 
 SidepanelReplay::~SidepanelReplay()
 {
+    stopParsing();
+    if( _mapped_log )
+    {
+        _log_file.unmap( _mapped_log );
+    }
     delete ui;
 }
 
 void SidepanelReplay::clear()
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
+    stopParsing();
+    _transitions.clear();
+    std::vector<Checkpoint>().swap( _checkpoints );
+    std::vector< std::pair<double,int>>().swap( _timepoint );
+    std::vector<std::vector<int>>().swap( _node_transitions );
+    std::vector<int>().swap( _failure_rows );
+    _bookmarks.clear();
+    _status_delta.reset(0);
+    _prev_row = -1;
+    _table_model->refresh();
+    _parser_state.statistics.reset(0);
+    _parser_state.timeline.clear();
+    _statistics.clear();
+    _statistics_model->setRowCount(0);
+    _timeline->clear();
+    clearComparison();
+
+    _log_filename.clear();
+    releaseLog();
+    ui->checkBoxFollow->setChecked(false);
+    ui->checkBoxFollow->setEnabled(false);
 }
 
-void SidepanelReplay::updateTableModel(const AbsBehaviorTree& locaded_tree)
+void SidepanelReplay::releaseLog()
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
-
-    const size_t transitions_count = _transitions.size();
-
-    auto createStatusItem = [](NodeStatus status) -> QStandardItem*
+    // the worker reads the buffer
+    stopParsing();
+    _log_buffer = nullptr;
+    _log_buffer_size = 0;
+    _log_header.clear();
+    _compressed_blocks.clear();
+    ui->pushButtonExport->setEnabled(false);
+
+    _log_content.clear();
+    if( _mapped_log )
     {
-        QStandardItem* item = nullptr;
-        switch (status)
-        {
-        case NodeStatus::SUCCESS:{
-            item = new QStandardItem("SUCCESS");
-            item->setBackground(QColor::fromRgb(22, 255, 22));
-        } break;
-        case NodeStatus::FAILURE:{
-            item = new QStandardItem("FAILURE");
-            item->setBackground(QColor::fromRgb(255, 22, 22));
-        } break;
-        case NodeStatus::RUNNING:{
-            item = new QStandardItem("RUNNING");
-            item->setBackground(QColor::fromRgb(250, 160, 20));
-        } break;
-        case NodeStatus::IDLE:{
-            item = new QStandardItem("IDLE");
-            item->setBackground(QColor::fromRgb(222, 222, 222));
-        } break;
-        }
-        item->setForeground(QColor::fromRgb(0, 0, 0));
-        return item;
-    };
+        _log_file.unmap( _mapped_log );
+        _mapped_log = nullptr;
+    }
+    _log_file.close();
+}
 
-    if(  transitions_count > 0)
+void SidepanelReplay::updateTableModel(const AbsBehaviorTree&)
+{
+    if( !_transitions.empty() )
     {
-        double previous_timestamp = 0;
-        const double first_timestamp = _transitions.front().timestamp;
-
-        for(size_t row=0; row < transitions_count; row++)
-        {
-            auto& trans = _transitions[row];
-            auto node  = locaded_tree.node( trans.index );
-
-            QString timestamp;
-            timestamp.sprintf("%.3f", trans.timestamp - first_timestamp);
-
-            auto timestamp_item = new QStandardItem( timestamp );
-            timestamp.sprintf("absolute time: %.3f", trans.timestamp);
-            timestamp_item->setToolTip( timestamp );
-
-            if(  (trans.timestamp - previous_timestamp) >= 0.001 || row == transitions_count-1)
-            {
-                _timepoint.push_back( {trans.timestamp, row}  );
-                previous_timestamp = trans.timestamp;
-
-                auto font = timestamp_item->font();
-                font.setBold(true);
-                timestamp_item->setFont(font);
-            }
-
-            QList<QStandardItem *> rowData;
-            rowData << timestamp_item;
-            rowData << new QStandardItem( node->instance_name );
-            rowData << createStatusItem( trans.prev_status );
-            rowData << createStatusItem( trans.status );
-            _table_model->appendRow(rowData);
-        }
-
-        emit _table_model->dataChanged( _table_model->index(0,0), _table_model->index( transitions_count-1, 3) );
-
         ui->tableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
         ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
         ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
         ui->tableView->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
-        ui->tableView->verticalHeader()->minimumSize();
     }
 
+    // this is called again every time a new chunk of the log is parsed.
+    // Don't move the current position, just enlarge the range.
+    QSignalBlocker block_spin( ui->spinBox );
+    QSignalBlocker block_Slider( ui->timeSlider );
+
     ui->label->setText( QString("of %1").arg( _timepoint.size() ) );
 
-    ui->spinBox->setValue(0);
+    const bool playing = ui->pushButtonPlay->isChecked();
     ui->spinBox->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->spinBox->setEnabled( !_timepoint.empty() );
-    ui->timeSlider->setValue( 0 );
+    ui->spinBox->setEnabled( !_timepoint.empty() && !playing );
     ui->timeSlider->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->timeSlider->setEnabled( !_timepoint.empty() );
+    ui->timeSlider->setEnabled( !_timepoint.empty() && !playing );
     ui->pushButtonPlay->setEnabled( !_timepoint.empty() );
+    ui->pushButtonExport->setEnabled( !_transitions.empty() );
+    // compare only complete logs
+    ui->pushButtonCompare->setEnabled( !_transitions.empty() && !_parse_timer->isActive() );
 }
 
 void SidepanelReplay::on_LoadLog()
@@ -155,38 +253,85 @@ void SidepanelReplay::on_LoadLog()
 
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open Flow Scene"), directory_path,
-                                                    tr("Flatbuffers log (*.fbl)"));
+                                                    tr("Flatbuffers log (*.fbl *.fblz)"));
 
     if (fileName.isEmpty() || !QFileInfo::exists(fileName))
     {
         return;
     }
-    QFile file(fileName);
-
-    if (!file.open(QIODevice::ReadOnly)){
-        return;
-    }
 
     directory_path = QFileInfo(fileName).absolutePath();
     settings.setValue("SidepanelReplay.lastLoadDirectory", directory_path);
     settings.sync();
 
-    QByteArray content = file.readAll();
-    loadLog( content );
+    loadLogFile( fileName );
+}
+
+bool SidepanelReplay::loadLogFile(const QString &filename)
+{
+    releaseLog();
+    _log_file.setFileName( filename );
+
+    if (!_log_file.open(QIODevice::ReadOnly)){
+        clear();
+        return false;
+    }
+
+    const qint64 file_size = _log_file.size();
+    if( file_size > 0 )
+    {
+        _mapped_log = _log_file.map( 0, file_size );
+    }
+
+    if( _mapped_log )
+    {
+        loadLog( reinterpret_cast<const char*>(_mapped_log), size_t(file_size), filename );
+    }
+    else
+    {
+        // mapping is not supported by this device, read it the old way
+        QByteArray content = _log_file.readAll();
+        _log_file.close();
+        loadLog( content, filename );
+    }
+    return true;
 }
 
-void SidepanelReplay::loadLog(const QByteArray &content)
+void SidepanelReplay::loadLog(const QByteArray &content, const QString& log_filename)
 {
-    const char* buffer = reinterpret_cast<const char*>(content.data());
+    // keep a (shallow) copy alive while the worker reads it. The previous
+    // log is released first: content might be a copy of it
+    const QByteArray new_content = content;
+    releaseLog();
+    _log_content = new_content;
+    loadLog( _log_content.constData(), size_t(_log_content.size()), log_filename );
+}
 
-    // how many bytes did we read off the disk (uoffset_t aka uint32_t)
-    const auto read_bytes = content.size();
+void SidepanelReplay::loadLog(const char* buffer, size_t read_bytes, const QString& log_filename)
+{
+    TraceScope trace( "replay", "loadLog" );
+    trace.setArgument( "bytes", read_bytes );
+
+    stopParsing();
+    // the previous log can't be exported anymore: buffer may replace it.
+    // The early returns clear() the transitions of the previous log too
+    _log_buffer = nullptr;
+    _log_buffer_size = 0;
+    _log_header.clear();
+    ui->pushButtonExport->setEnabled(false);
+    _log_filename = log_filename;
+    _use_index = false;
+
+    // follow mode is available only for files
+    ui->checkBoxFollow->setEnabled( !_log_filename.isEmpty() );
+    on_checkBoxFollow_toggled( ui->checkBoxFollow->isChecked() );
 
     // we need at least 4 bytes to read the bt_header_size
     if( read_bytes < 4 ) {
         QMessageBox::warning( this, "Log file is empty",
                              "Failed to load this file.\n"
                              "This Log file is empty");
+        clear();
         return;
     }
     
@@ -194,15 +339,18 @@ void SidepanelReplay::loadLog(const QByteArray &content)
     const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(buffer);
 
     // if the length of the header goes past the end of the file, it is invalid
-    if( (bt_header_size == 0) || (bt_header_size > read_bytes) ) {
+    if( (bt_header_size == 0) || (bt_header_size > read_bytes - 4) ) {
         QMessageBox::warning( this, "Log file is corrupt",
                              "Failed to load this file.\n"
                              "This Log file corrupted or truncated");
+        clear();
         return;
     }
 
+    // verify only the header section, in place. The transitions that follow
+    // it are read straight from the buffer below.
     flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(buffer+4),
-                                   size_t(content.size() -4));
+                                   bt_header_size );
 
     bool valid_tree = Serialization::VerifyBehaviorTreeBuffer(verifier);
     if( ! valid_tree )
@@ -210,37 +358,234 @@ void SidepanelReplay::loadLog(const QByteArray &content)
         QMessageBox::warning( this, "Flatbuffer verification failed",
                              "Failed to load this file.\n"
                              "Its format is not compatible with the current one");
+        clear();
         return;
     }
 
 
+    const size_t transitions_offset = 4 + bt_header_size;
+    size_t transitions_count = (read_bytes - transitions_offset) / 12;
+
+    // block-compressed logs (.fblz) have an index of blocks after the header
+    _compressed_blocks.clear();
+    if( ReplayLogFormat::isCompressed( buffer, read_bytes, transitions_offset ) )
+    {
+        if( !ReplayLogFormat::readBlockIndex( buffer, read_bytes, transitions_offset, _compressed_blocks ) )
+        {
+            QMessageBox::warning( this, "Log file is corrupt",
+                                 "Failed to load this file.\n"
+                                 "The index of the compressed blocks is corrupted or truncated");
+            clear();
+            return;
+        }
+        transitions_count = 0;
+        for (const auto& block: _compressed_blocks)
+        {
+            transitions_count += block.records_count;
+        }
+        // records can't be appended to a compressed log
+        ui->checkBoxFollow->setChecked( false );
+        ui->checkBoxFollow->setEnabled( false );
+    }
+    _parse_total_transitions = transitions_count;
+
     auto fb_behavior_tree = Serialization::GetBehaviorTree( &buffer[4] );
 
 
     auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
 
     _loaded_tree  = res_pair.first;
-    const auto& uid_to_index = res_pair.second;
+    _uid_to_index = res_pair.second;
+
+    // kept to export ranges of this log
+    _log_buffer = buffer;
+    _log_buffer_size = read_bytes;
+    _log_header = QByteArray( buffer, int(transitions_offset) );
+    _index_to_uid.assign( _loaded_tree.nodesCount(), 0 );
+    for (size_t uid = 0; uid < _uid_to_index.tableSize(); uid++)
+    {
+        const int index = _uid_to_index.find( uint16_t(uid) );
+        if( index != UidLookupTable::INVALID_INDEX )
+        {
+            _index_to_uid[ index ] = uint16_t( uid );
+        }
+    }
 
+    NodeModels new_models;
     for (const auto& tree_node: _loaded_tree.nodes() )
     {
         const QString& ID = tree_node.model.registration_ID;
         if( BuiltinNodeModels().count( ID ) == 0)
         {
-            emit addNewModel( tree_node.model );
+            new_models.insert( { ID, tree_node.model } );
         }
     }
+    emit addNewModels( new_models );
 
     emit loadBehaviorTree( _loaded_tree, "BehaviorTree" );
 
     _transitions.clear();
-    _transitions.reserve( (content.size() - 4 - bt_header_size) / 12 );
+    _checkpoints.clear();
+    _timepoint.clear();
+    _node_transitions.assign( _loaded_tree.nodesCount(), std::vector<int>() );
+    _failure_rows.clear();
+    _status_delta.reset( _loaded_tree.nodesCount() );
+    _statistics.clear();
+    _statistics_model->setRowCount(0);
+    _timeline->clear();
+    clearComparison();
+    loadBookmarks();
+    _last_timepoint_timestamp = 0;
+    _prev_row = -1;
+    _table_model->refresh();
+    // the node indices changed, apply the filter to the new tree
+    on_lineEditFilter_textChanged( ui->lineEditFilter->text() );
+    {
+        QSignalBlocker block_spin( ui->spinBox );
+        QSignalBlocker block_Slider( ui->timeSlider );
+        ui->spinBox->setValue(0);
+        ui->timeSlider->setValue(0);
+    }
+
+    _transitions.reserve( transitions_count );
+
+    if( !_log_filename.isEmpty() )
+    {
+        _use_index = loadIndexFile( transitions_count );
+    }
+    updateTableModel(_loaded_tree);
+
+    // We need to lock the nodes after they are loaded
+    auto main_win = dynamic_cast<MainWindow*>( _parent );
+    main_win->lockEditing(true);
+
+    _parse_cancel = false;
+    _parse_error = false;
+    _parse_progress = 0;
+    _transitions_offset = transitions_offset;
+
+    _parser_state.idle_counter = _loaded_tree.nodesCount();
+    _parser_state.nearest_restart_transition_index = 0;
+    _parser_state.parsed_count = 0;
+    _parser_state.current_status.assign( _loaded_tree.nodesCount(), NodeStatus::IDLE );
+    _parser_state.statistics.reset( _loaded_tree.nodesCount() );
+    _parser_state.first_timestamp = 0;
+    _parser_state.timeline.clear();
+
+    if( transitions_count < BACKGROUND_PARSE_THRESHOLD )
+    {
+        parseLog( buffer, transitions_offset, read_bytes );
+        onParseTimer();
+    }
+    else{
+        // large logs are parsed by a worker and published in chunks.
+        // onParseTimer appends them to the table while the user can already
+        // inspect the first part of the log.
+        ui->progressBar->setValue( 0 );
+        ui->progressBar->setVisible( true );
+        ui->pushButtonCancel->setVisible( true );
+
+        _parse_future = QtConcurrent::run( this, &SidepanelReplay::parseLog,
+                                           buffer, transitions_offset, read_bytes );
+        _parse_timer->start();
+    }
+}
+
+void SidepanelReplay::parseLog(const char *buffer, size_t begin, size_t end)
+{
+    if( _compressed_blocks.empty() )
+    {
+        parseTransitions( buffer, begin, end );
+        return;
+    }
+    // decompress one block at the time, only the compressed file stays in memory
+    for (const auto& block: _compressed_blocks)
+    {
+        if( _parse_cancel || _parse_error )
+        {
+            break;
+        }
+        const QByteArray records = ReplayLogFormat::decompressBlock( buffer, end, block );
+        if( records.isEmpty() && block.records_count > 0 )
+        {
+            _parse_error = true;
+            break;
+        }
+        parseTransitions( records.constData(), 0, size_t(records.size()) );
+    }
+}
+
+// move the rows to the end of destination, emptying rows
+static void AppendRows(std::vector<int>& destination, std::vector<int>& rows)
+{
+    if( destination.empty() )
+    {
+        destination.swap( rows );
+    }
+    else{
+        destination.insert( destination.end(), rows.begin(), rows.end() );
+    }
+    rows.clear();
+}
+
+void SidepanelReplay::parseTransitions(const char* buffer, size_t begin, size_t end)
+{
+    TraceScope trace( "replay", "parseTransitions" );
+    trace.setArgument( "bytes", end - begin );
+
+    // NOTE: this might run in a worker thread. Only the local variables, _parser_state,
+    // _uid_to_index and the _pending_* containers (under _parse_mutex) are accessed.
+    // The rows of each node and the timeline are built here too, the GUI
+    // thread only appends them.
+
+    // the state is preserved between calls, to parse the records
+    // appended to a log in follow mode
+    int& idle_counter = _parser_state.idle_counter;
+    int& nearest_restart_transition_index = _parser_state.nearest_restart_transition_index;
+    int& parsed_count = _parser_state.parsed_count;
+    std::vector<NodeStatus>& current_status = _parser_state.current_status;
+    NodeTimingAccumulator& statistics = _parser_state.statistics;
+    ReplayTimelineData& timeline = _parser_state.timeline;
+    const int total_nodes = current_status.size();
+
+    std::vector<Transition> chunk;
+    std::vector<Checkpoint> checkpoints;
+    std::vector<std::vector<int>> node_rows( total_nodes );
+    std::vector<int> failure_rows;
+    chunk.reserve( std::min( size_t(PARSE_CHUNK_SIZE), (end - begin) / 12 ) );
+
+    auto publish = [&]()
+    {
+        if( chunk.empty() )
+        {
+            return;
+        }
+        timeline.updatePyramid();
+        // outside the lock: the pyramid is proportional to the duration of the log
+        ReplayTimelineData timeline_copy = timeline;
+
+        QMutexLocker lock( &_parse_mutex );
+        _pending_transitions.insert( _pending_transitions.end(), chunk.begin(), chunk.end() );
+        _pending_checkpoints.insert( _pending_checkpoints.end(),
+                                     std::make_move_iterator(checkpoints.begin()),
+                                     std::make_move_iterator(checkpoints.end()) );
+        _pending_node_rows.resize( node_rows.size() );
+        for (size_t index = 0; index < node_rows.size(); index++)
+        {
+            AppendRows( _pending_node_rows[index], node_rows[index] );
+        }
+        AppendRows( _pending_failure_rows, failure_rows );
+        _pending_timeline = std::move( timeline_copy );
+        _pending_timeline_changed = true;
+        chunk.clear();
+        checkpoints.clear();
+    };
 
-    int idle_counter = _loaded_tree.nodes().size();
-    const int total_nodes = _loaded_tree.nodes().size();
-    int nearest_restart_transition_index = 0;
+    // with a valid index, restarts and checkpoints are already known
+    const bool use_index = _use_index;
+    auto next_restart = std::lower_bound( _indexed_restarts.begin(), _indexed_restarts.end(), parsed_count );
 
-    for (size_t offset = 4+bt_header_size; offset < content.size(); offset += 12)
+    for (size_t offset = begin; offset + 12 <= end; offset += 12)
     {
         Transition transition;
         const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
@@ -248,16 +593,34 @@ void SidepanelReplay::loadLog(const QByteArray &content)
         double timestamp = t_sec + t_usec* 0.000001;
         transition.timestamp = timestamp;
         const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-        transition.index = uid_to_index.at(uid);
+        const int index = _uid_to_index.find(uid);
+        if( index == UidLookupTable::INVALID_INDEX )
+        {
+            _parse_error = true;
+            break;
+        }
+        transition.index = index;
         transition.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+10] ));
         transition.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
         transition.is_tree_restart = false;
 
-        if(transition.index == 1 &&
+        if( use_index )
+        {
+            if( next_restart != _indexed_restarts.end() && *next_restart == parsed_count )
+            {
+                transition.is_tree_restart = true;
+                next_restart++;
+            }
+        }
+        else if(transition.index == 1 &&
                 (transition.status == NodeStatus::RUNNING || transition.status == NodeStatus::IDLE) &&
                 idle_counter >= total_nodes - 1){
             transition.is_tree_restart = true;
-            nearest_restart_transition_index = _transitions.size();
+        }
+
+        if( transition.is_tree_restart )
+        {
+            nearest_restart_transition_index = parsed_count;
         }
 
         if(transition.prev_status != NodeStatus::IDLE && transition.status == NodeStatus::IDLE)
@@ -267,115 +630,1002 @@ void SidepanelReplay::loadLog(const QByteArray &content)
 
         transition.nearest_restart_transition_index = nearest_restart_transition_index;
 
-        _transitions.push_back(transition);
-    }
+        // parsed_count is the row of this transition in _transitions
+        if( parsed_count == 0 )
+        {
+            _parser_state.first_timestamp = timestamp;
+        }
+        const bool failure = ( transition.status == NodeStatus::FAILURE );
+        timeline.addTransition( timestamp - _parser_state.first_timestamp, failure );
+        node_rows[ transition.index ].push_back( parsed_count );
+        if( failure )
+        {
+            failure_rows.push_back( parsed_count );
+        }
 
-    _timepoint.clear();
-    _prev_row = -1;
-    updateTableModel(_loaded_tree);
+        chunk.push_back(transition);
+        parsed_count++;
+        statistics.add( transition.index, transition.prev_status, transition.status, transition.timestamp );
 
+        // keep track of the status seen by onRowChanged at this row.
+        if( transition.is_tree_restart )
+        {
+            std::fill( current_status.begin(), current_status.end(), NodeStatus::IDLE );
+        }
+        current_status[ transition.index ] = transition.status;
 
-    // We need to lock the nodes after they are loaded
-    auto main_win = dynamic_cast<MainWindow*>( _parent );
-    main_win->lockEditing(true);
-}
+        // the checkpoints might come from the index file already
+        if( !use_index && parsed_count % CHECKPOINT_PERIOD == 0 )
+        {
+            checkpoints.push_back( { parsed_count - 1, current_status } );
+        }
 
+        if( chunk.size() >= PARSE_CHUNK_SIZE )
+        {
+            publish();
+            _parse_progress = parsed_count;
+            if( _parse_cancel )
+            {
+                break;
+            }
+        }
+    }
+    publish();
+    _parse_progress = parsed_count;
+}
 
-void SidepanelReplay::on_spinBox_valueChanged(int value)
+void SidepanelReplay::onParseTimer()
 {
-    if( ui->timeSlider->value() != value)
+    // check this first: the worker might publish its last chunk right now
+    const bool finished = !_parse_future.isRunning();
+
+    std::vector<Transition> new_transitions;
+    std::vector<Checkpoint> new_checkpoints;
+    std::vector<std::vector<int>> new_node_rows;
+    std::vector<int> new_failure_rows;
+    ReplayTimelineData new_timeline;
+    bool timeline_changed = false;
     {
-        ui->timeSlider->setValue( value );
+        QMutexLocker lock( &_parse_mutex );
+        new_transitions.swap( _pending_transitions );
+        new_checkpoints.swap( _pending_checkpoints );
+        new_node_rows.swap( _pending_node_rows );
+        new_failure_rows.swap( _pending_failure_rows );
+        if( _pending_timeline_changed )
+        {
+            new_timeline = std::move( _pending_timeline );
+            timeline_changed = true;
+            _pending_timeline_changed = false;
+        }
     }
 
-    int row = _timepoint[value].second;
+    if( !new_transitions.empty() )
+    {
+        _table_model->beginAppendRows( new_transitions.size() );
+        _transitions.append( new_transitions );
+        _table_model->endAppendRows();
 
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter  );
+        _checkpoints.insert( _checkpoints.end(),
+                             std::make_move_iterator(new_checkpoints.begin()),
+                             std::make_move_iterator(new_checkpoints.end()) );
 
-    onRowChanged( row );
-}
+        for (size_t index = 0; index < new_node_rows.size() && index < _node_transitions.size(); index++)
+        {
+            AppendRows( _node_transitions[index], new_node_rows[index] );
+        }
+        AppendRows( _failure_rows, new_failure_rows );
 
-void SidepanelReplay::on_timeSlider_valueChanged(int value)
-{
-    if( ui->spinBox->value() != value)
+        if( _filter_model->isFiltered() )
+        {
+            std::vector<int> new_filtered_rows;
+            for(size_t row = _transitions.size() - new_transitions.size(); row < _transitions.size(); row++)
+            {
+                if( _filtered_nodes[ _transitions.index(row) ] )
+                {
+                    new_filtered_rows.push_back( int(row) );
+                }
+            }
+            _filter_model->appendFilteredRows( new_filtered_rows );
+        }
+        if( timeline_changed )
+        {
+            _timeline->setData( std::move(new_timeline) );
+        }
+        updateTimelineBookmarks();
+
+        if( _use_index )
+        {
+            // reveal the timepoints of the rows loaded so far
+            while( _timepoint.size() < _indexed_timepoints.size() &&
+                   _indexed_timepoints[_timepoint.size()].second < int(_transitions.size()) )
+            {
+                _timepoint.push_back( _indexed_timepoints[_timepoint.size()] );
+            }
+        }
+        else
+        {
+            for(size_t row = _transitions.size() - new_transitions.size(); row < _transitions.size(); row++)
+            {
+                const double timestamp = _transitions.timestamp(row);
+                if( (timestamp - _last_timepoint_timestamp) >= 0.001 )
+                {
+                    _timepoint.push_back( {timestamp, row} );
+                    _last_timepoint_timestamp = timestamp;
+                }
+            }
+        }
+    }
+
+    if( finished )
     {
-        ui->spinBox->setValue( value );
+        _parse_timer->stop();
+        ui->progressBar->setVisible( false );
+        ui->pushButtonCancel->setVisible( false );
+
+        // the last transition is always a timepoint
+        const int last_row = int(_transitions.size()) - 1;
+        if( last_row >= 0 && (_timepoint.empty() || _timepoint.back().second != last_row) )
+        {
+            _timepoint.push_back( {_transitions.timestamp(last_row), last_row} );
+        }
+
+        _statistics = _parser_state.statistics.statistics();
+        updateStatisticsTable( _statistics );
+        const double duration = _transitions.empty() ? 0.0 :
+                                    _transitions.timestamp(last_row) - _transitions.timestamp(0);
+        ui->spinBoxStatisticsFrom->setRange( 0, duration );
+        ui->spinBoxStatisticsTo->setRange( 0, duration );
+        if( !_appending )
+        {
+            ui->spinBoxStatisticsFrom->setValue( 0 );
+        }
+        ui->spinBoxStatisticsTo->setValue( duration );
+
+        if( !_appending && !_use_index && !_parse_cancel && !_parse_error && !_log_filename.isEmpty() )
+        {
+            saveIndexFile();
+        }
+        // records appended later (follow mode) are not in the index
+        _use_index = false;
+        _indexed_restarts.clear();
+        _indexed_timepoints.clear();
+        if( !_timepoint.empty() )
+        {
+            _last_timepoint_timestamp = _timepoint.back().first;
+        }
+        _parsed_end_offset = _transitions_offset + 12 * _transitions.size();
+    }
+    else
+    {
+        const size_t total = std::max<size_t>( 1, _parse_total_transitions );
+        ui->progressBar->setValue( int( 1000 * _parse_progress / total ) );
     }
 
-    int row = _timepoint[value].second;
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter);
+    updateTableModel(_loaded_tree);
 
-    onRowChanged( row );
+    if( finished && _parse_error )
+    {
+        _parse_error = false;
+        ui->checkBoxFollow->setChecked( false );
+        QMessageBox::warning( this, "Log file is corrupt",
+                             "This Log file contains invalid transitions.\n"
+                             "Only the transitions before the first invalid one are shown");
+    }
 }
 
-void SidepanelReplay::onRowChanged(int current_row)
+// Layout of the index file (native endianness):
+//
+//   uint32  magic, uint32 version,
+//   int64   size of the log, int64 last modification of the log (msec since epoch),
+//   uint64  number of transitions, uint32  number of nodes,
+//   uint32  N restarts,    N x int32  transition index
+//   uint32  N timepoints,  N x (double timestamp, int32 row)
+//   uint32  N checkpoints, N x (int32 transition index, [number of nodes] x uint8 status)
+
+static const uint32_t INDEX_FILE_MAGIC   = 0x58444947; // "GIDX"
+static const uint32_t INDEX_FILE_VERSION = 1;
+
+template <typename T> static void writeValue(QFile& file, const T& value)
 {
-    current_row = std::min( current_row, _table_model->rowCount() -1 );
-    current_row = std::max( current_row, 0 );
+    file.write( reinterpret_cast<const char*>(&value), sizeof(T) );
+}
 
-    if( _prev_row == current_row)
+template <typename T> static bool readValue(QFile& file, T& value)
+{
+    return file.read( reinterpret_cast<char*>(&value), sizeof(T) ) == qint64(sizeof(T));
+}
+
+bool SidepanelReplay::loadIndexFile(size_t transitions_count)
+{
+    _indexed_restarts.clear();
+    _indexed_timepoints.clear();
+
+    const QFileInfo log_info( _log_filename );
+    QFile file( _log_filename + ".gidx" );
+    if( !file.open(QIODevice::ReadOnly) )
     {
-        // nothing to do
-        return;
+        return false;
     }
 
-    // disable section resize, otherwise it will be SUPER slow
-    // We will refresh this in the callback of _layout_update_timer -> onTimerUpdate
-    ui->tableView->horizontalHeader()->setSectionResizeMode (QHeaderView::Fixed);
-    ui->tableView->verticalHeader()->setSectionResizeMode (QHeaderView::Fixed);
+    uint32_t magic = 0, version = 0, nodes_count = 0, count = 0;
+    int64_t log_size = 0, log_mtime = 0;
+    uint64_t indexed_transitions = 0;
 
-    const auto selected_color   = QColor::fromRgb(210, 210, 210);
-    const auto unselected_color = QColor::fromRgb(255, 255, 255);
+    if( !readValue(file, magic) || magic != INDEX_FILE_MAGIC ||
+        !readValue(file, version) || version != INDEX_FILE_VERSION ||
+        !readValue(file, log_size) || log_size != log_info.size() ||
+        !readValue(file, log_mtime) || log_mtime != log_info.lastModified().toMSecsSinceEpoch() ||
+        !readValue(file, indexed_transitions) || indexed_transitions != transitions_count ||
+        !readValue(file, nodes_count) || nodes_count != _loaded_tree.nodesCount() )
+    {
+        return false;
+    }
 
-    for (int row = std::max(0,_prev_row); row <= current_row; row++)
+    std::vector<Checkpoint> checkpoints;
+    bool ok = readValue(file, count);
+    for (uint32_t i=0; ok && i<count; i++)
     {
-        _table_model->item(row, 0)->setBackground( selected_color );
-        _table_model->item(row, 1)->setBackground( selected_color );
+        int32_t row;
+        ok = readValue(file, row);
+        _indexed_restarts.push_back( row );
     }
-    for (int row = current_row+1; row <= _prev_row; row++)
+    ok = ok && readValue(file, count);
+    for (uint32_t i=0; ok && i<count; i++)
     {
-        _table_model->item(row, 0)->setBackground( unselected_color );
-        _table_model->item(row, 1)->setBackground( unselected_color );
+        double timestamp;
+        int32_t row;
+        ok = readValue(file, timestamp) && readValue(file, row);
+        _indexed_timepoints.push_back( {timestamp, row} );
     }
-
-    // cancel the refresh of the layout refresh
-    if( !_layout_update_timer->isActive() )
+    ok = ok && readValue(file, count);
+    std::vector<uint8_t> status( nodes_count );
+    for (uint32_t i=0; ok && i<count; i++)
     {
-        _layout_update_timer->stop();
+        Checkpoint checkpoint;
+        int32_t row;
+        ok = readValue(file, row) &&
+             file.read( reinterpret_cast<char*>(status.data()), nodes_count ) == qint64(nodes_count);
+        checkpoint.transition_index = row;
+        checkpoint.status.reserve( nodes_count );
+        for(uint8_t value: status)
+        {
+            checkpoint.status.push_back( static_cast<NodeStatus>(value) );
+        }
+        checkpoints.push_back( std::move(checkpoint) );
     }
-    _layout_update_timer->start(100);
 
-    const QString bt_name("BehaviorTree");
+    if( !ok )
+    {
+        _indexed_restarts.clear();
+        _indexed_timepoints.clear();
+        return false;
+    }
+    _checkpoints = std::move(checkpoints);
+    return true;
+}
 
-    std::vector<std::pair<int, NodeStatus>>  node_status;
-    for(size_t index = 0; index < _loaded_tree.nodes().size(); index++ )
+void SidepanelReplay::saveIndexFile() const
+{
+    const QFileInfo log_info( _log_filename );
+    QFile file( _log_filename + ".gidx" );
+    if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
     {
-        node_status.push_back( { index, NodeStatus::IDLE} );
+        // not a problem, the log might be in a read-only directory
+        return;
     }
 
-    for (int t = _transitions[current_row].nearest_restart_transition_index; t <= current_row; t++)
+    writeValue( file, INDEX_FILE_MAGIC );
+    writeValue( file, INDEX_FILE_VERSION );
+    writeValue( file, int64_t( log_info.size() ) );
+    writeValue( file, int64_t( log_info.lastModified().toMSecsSinceEpoch() ) );
+    writeValue( file, uint64_t( _transitions.size() ) );
+    writeValue( file, uint32_t( _loaded_tree.nodesCount() ) );
+
+    const auto& restarts = _transitions.restarts();
+    writeValue( file, uint32_t( restarts.size() ) );
+    for(int row: restarts)
     {
-        auto& trans = _transitions[t];
-        node_status.push_back( { trans.index, trans.status} );
+        writeValue( file, int32_t(row) );
     }
 
-    emit changeNodeStyle( bt_name, node_status );
+    writeValue( file, uint32_t( _timepoint.size() ) );
+    for(const auto& timepoint: _timepoint)
+    {
+        writeValue( file, timepoint.first );
+        writeValue( file, int32_t( timepoint.second ) );
+    }
 
-    _prev_row = current_row;
+    writeValue( file, uint32_t( _checkpoints.size() ) );
+    std::vector<uint8_t> status;
+    for(const auto& checkpoint: _checkpoints)
+    {
+        writeValue( file, int32_t( checkpoint.transition_index ) );
+        status.clear();
+        for(NodeStatus value: checkpoint.status)
+        {
+            status.push_back( static_cast<uint8_t>(value) );
+        }
+        file.write( reinterpret_cast<const char*>(status.data()), status.size() );
+    }
 }
 
-void SidepanelReplay::updatedSpinAndSlider(int row)
+void SidepanelReplay::updateStatisticsTable(const std::vector<NodeTimingStatistics> &statistics)
 {
-    auto it = std::upper_bound( _timepoint.begin(), _timepoint.end(), row,
-                                []( int val, const std::pair<double,int>& a ) -> bool
-    {
-        return val < a.second;
-    } );
+    // keep the current sorting of the view
+    ui->tableViewStatistics->setSortingEnabled(false);
+    _statistics_model->setRowCount(0);
 
-    QSignalBlocker block_spin( ui->spinBox );
-    QSignalBlocker block_Slider( ui->timeSlider );
+    auto numberItem = [](double value) -> QStandardItem*
+    {
+        // use numbers, not strings, to sort the columns properly
+        auto item = new QStandardItem();
+        item->setData( value, Qt::DisplayRole );
+        return item;
+    };
 
-    int index = (it - _timepoint.begin()) -1;
+    for (size_t index = 0; index < statistics.size() && index < _loaded_tree.nodesCount(); index++)
+    {
+        const NodeTimingStatistics& stats = statistics[index];
+        if( stats.executions == 0 && stats.running_count == 0 )
+        {
+            continue;
+        }
+        const double success_ratio = stats.executions > 0 ?
+                    (100.0 * stats.success) / stats.executions : 0.0;
+
+        QList<QStandardItem *> row;
+        row << new QStandardItem( _loaded_tree.node(index)->instance_name );
+        row << numberItem( stats.executions );
+        row << numberItem( std::round( success_ratio * 10.0 ) / 10.0 );
+        row << numberItem( std::round( stats.running_min  * 1e6 ) / 1e3 );
+        row << numberItem( std::round( stats.running_mean * 1e6 ) / 1e3 );
+        row << numberItem( std::round( stats.running_p99  * 1e6 ) / 1e3 );
+        _statistics_model->appendRow( row );
+    }
+    ui->tableViewStatistics->setSortingEnabled(true);
+}
+
+void SidepanelReplay::on_pushButtonStatistics_clicked()
+{
+    if( _transitions.empty() )
+    {
+        return;
+    }
+    const double first_timestamp = _transitions.timestamp(0);
+    const size_t first_row = _transitions.lowerBound( first_timestamp + ui->spinBoxStatisticsFrom->value() );
+    const size_t last_row  = _transitions.upperBound( first_timestamp + ui->spinBoxStatisticsTo->value() );
+
+    NodeTimingAccumulator accumulator;
+    accumulator.reset( _loaded_tree.nodesCount() );
+    accumulator.add( _transitions, first_row, last_row );
+    updateStatisticsTable( accumulator.statistics() );
+}
+
+void SidepanelReplay::on_pushButtonExport_clicked()
+{
+    if( _transitions.empty() )
+    {
+        return;
+    }
+    const double first_timestamp = _transitions.timestamp(0);
+    const double duration = _transitions.back().timestamp - first_timestamp;
+    const double current_time = (_prev_row >= 0 ) ?
+                _transitions.timestamp(_prev_row) - first_timestamp : 0.0;
+
+    QDialog dialog( this );
+    dialog.setWindowTitle( tr("Export range") );
+    QFormLayout* form = new QFormLayout( &dialog );
+
+    QDoubleSpinBox* spin_from = new QDoubleSpinBox( &dialog );
+    QDoubleSpinBox* spin_to   = new QDoubleSpinBox( &dialog );
+    for (QDoubleSpinBox* spin: {spin_from, spin_to} )
+    {
+        spin->setRange( 0, duration );
+        spin->setDecimals( 3 );
+        spin->setSuffix( " s" );
+    }
+    // by default, the 30 seconds around the current position
+    spin_from->setValue( std::max( 0.0, current_time - 15.0 ) );
+    spin_to->setValue( std::min( duration, current_time + 15.0 ) );
+
+    QCheckBox* check_snapshot = new QCheckBox( tr("Start from the status of the tree"), &dialog );
+    check_snapshot->setChecked( true );
+
+    QDialogButtonBox* buttons = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                                      Qt::Horizontal, &dialog );
+    connect( buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept );
+    connect( buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject );
+
+    form->addRow( tr("From:"), spin_from );
+    form->addRow( tr("To:"), spin_to );
+    form->addRow( check_snapshot );
+    form->addRow( buttons );
+
+    if( dialog.exec() != QDialog::Accepted )
+    {
+        return;
+    }
+
+    const size_t first_row = _transitions.lowerBound( first_timestamp + spin_from->value() );
+    const size_t last_row  = _transitions.upperBound( first_timestamp + spin_to->value() );
+    if( first_row >= last_row )
+    {
+        QMessageBox::warning( this, tr("Export range"),
+                             tr("There are no transitions in the selected range") );
+        return;
+    }
+
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelReplay.lastExportDirectory",
+                                             QDir::homePath() ).toString();
+
+    const QString compressed_filter = tr("Compressed flatbuffers log (*.fblz)");
+    QString selected_filter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export range"), directory_path,
+                                                    tr("Flatbuffers log (*.fbl)") + ";;" + compressed_filter,
+                                                    &selected_filter);
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+    if (!fileName.endsWith(".fbl") && !fileName.endsWith(".fblz"))
+    {
+        fileName += ( selected_filter == compressed_filter ) ? ".fblz" : ".fbl";
+    }
+
+    directory_path = QFileInfo(fileName).absolutePath();
+    settings.setValue("SidepanelReplay.lastExportDirectory", directory_path);
+    settings.sync();
+
+    if( !exportRange( fileName, int(first_row), int(last_row) - 1, check_snapshot->isChecked() ) )
+    {
+        QMessageBox::warning( this, tr("Export range"),
+                             tr("Failed to write the file %1").arg( fileName ) );
+    }
+}
+
+bool SidepanelReplay::exportRange(const QString &filename, int first_row, int last_row,
+                                  bool with_snapshot) const
+{
+    if( _log_header.isEmpty() || first_row < 0 || first_row > last_row ||
+        last_row >= int(_transitions.size()) )
+    {
+        return false;
+    }
+
+    QByteArray output = _log_header;
+
+    if( with_snapshot && first_row > 0 )
+    {
+        // every node that is not IDLE "becomes" active at the beginning of the range.
+        // Parents come before their children, as in the tree.
+        const int64_t timestamp = _transitions.timestampUsec(first_row);
+        const std::vector<NodeStatus> status = statusAt( first_row - 1 );
+        for (size_t index = 0; index < status.size(); index++)
+        {
+            if( status[index] != NodeStatus::IDLE )
+            {
+                ReplayLogFormat::appendRecord( output, timestamp, _index_to_uid[index],
+                                               uint8_t(NodeStatus::IDLE), uint8_t(status[index]) );
+            }
+        }
+    }
+
+    const size_t records_count = size_t(last_row - first_row + 1);
+    const size_t raw_begin = _transitions_offset + size_t(first_row) * ReplayLogFormat::RECORD_SIZE;
+    const size_t raw_end   = raw_begin + records_count * ReplayLogFormat::RECORD_SIZE;
+
+    if( _log_buffer && _compressed_blocks.empty() && raw_end <= _log_buffer_size )
+    {
+        // the records are still in the loaded buffer: copy them as they are
+        output.append( _log_buffer + raw_begin, int(raw_end - raw_begin) );
+    }
+    else
+    {
+        // compressed logs and records appended in follow mode
+        output.reserve( output.size() + int(records_count * ReplayLogFormat::RECORD_SIZE) );
+        for (int row = first_row; row <= last_row; row++)
+        {
+            ReplayLogFormat::appendRecord( output, _transitions.timestampUsec(row),
+                                           _index_to_uid[ _transitions.index(row) ],
+                                           uint8_t(_transitions.prevStatus(row)),
+                                           uint8_t(_transitions.status(row)) );
+        }
+    }
+
+    if( filename.endsWith(".fblz") )
+    {
+        output = ReplayLogFormat::compressLog( output.constData(), size_t(output.size()) );
+        if( output.isEmpty() )
+        {
+            return false;
+        }
+    }
+
+    QFile file( filename );
+    if( !file.open(QIODevice::WriteOnly) )
+    {
+        return false;
+    }
+    return file.write( output ) == output.size();
+}
+
+void SidepanelReplay::on_pushButtonCompare_clicked()
+{
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelReplay.lastLoadDirectory",
+                                             QDir::homePath() ).toString();
+
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Compare with"), directory_path,
+                                                    tr("Flatbuffers log (*.fbl *.fblz)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    QFile file( fileName );
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::warning( this, tr("Compare with"),
+                             tr("Failed to open the file %1").arg( fileName ) );
+        return;
+    }
+    const QByteArray content = file.readAll();
+    file.close();
+
+    AbsBehaviorTree tree;
+    QString error_message;
+    clearComparison();
+    if( !DecodeReplayLog( content.constData(), size_t(content.size()), tree,
+                          _compared_transitions, error_message) )
+    {
+        QMessageBox::warning( this, "Log file is corrupt",
+                             "Failed to load this file.\n" + error_message );
+        _compared_transitions.clear();
+        return;
+    }
+    if( !SameTreeStructure( _loaded_tree, tree ) )
+    {
+        QMessageBox::warning( this, tr("Compare with"),
+                             tr("The two logs were not recorded from the same tree") );
+        _compared_transitions.clear();
+        return;
+    }
+    _compared_filename = QFileInfo(fileName).fileName();
+
+    NodeTimingAccumulator accumulator;
+    accumulator.reset( tree.nodesCount() );
+    accumulator.add( _compared_transitions, 0, _compared_transitions.size() );
+    _compared_statistics = accumulator.statistics();
+
+    updateComparison();
+}
+
+void SidepanelReplay::on_spinBoxComparisonTolerance_valueChanged(double)
+{
+    if( !_compared_transitions.empty() )
+    {
+        updateComparison();
+    }
+}
+
+void SidepanelReplay::on_tableViewComparison_doubleClicked(const QModelIndex &index)
+{
+    // go to the first tick where the node diverges
+    const QModelIndex tick_index = _comparison_model->index( index.row(), 8 );
+    const int tick = _comparison_model->data( tick_index, Qt::UserRole ).toInt();
+    if( tick < 0 || size_t(tick) >= _comparison.ticksA().size() || ui->pushButtonPlay->isChecked() )
+    {
+        return;
+    }
+    const int row = int( _comparison.ticksA()[tick].first_row );
+    onRowChanged( row );
+    updatedSpinAndSlider( row );
+    scrollToRow( row, QAbstractItemView::PositionAtTop );
+}
+
+void SidepanelReplay::clearComparison()
+{
+    _compared_transitions.clear();
+    _compared_statistics.clear();
+    _compared_filename.clear();
+    _comparison_model->setRowCount(0);
+    ui->labelComparison->setText( tr("No log to compare") );
+}
+
+std::vector<MemoryUsage> SidepanelReplay::memoryUsage()
+{
+    std::vector<MemoryUsage> usages;
+    if( _transitions.empty() && _log_buffer_size == 0 && _compared_transitions.empty() )
+    {
+        return usages;
+    }
+
+    auto addUsage = [&usages](const QString& name, size_t bytes, const QString& details)
+    {
+        MemoryUsage usage;
+        usage.category = tr("Replay");
+        usage.name = name;
+        usage.bytes = bytes;
+        usage.details = details;
+        usages.push_back( usage );
+        return usages.size() - 1;
+    };
+
+    // a mapped file is paged in by the OS, a loaded one is a copy in RAM
+    const size_t log_index = addUsage( tr("Log"),
+                                       _mapped_log ? 0 : size_t(_log_content.capacity()) + size_t(_log_header.capacity()),
+                                       _mapped_log ? tr("%1 mapped from the file").arg( FormatBytes( _log_buffer_size ) )
+                                                   : tr("%1 loaded in memory").arg( FormatBytes( _log_buffer_size ) ) );
+    usages[log_index].release_label = tr("Close the log");
+    usages[log_index].release = [this]() { clear(); };
+
+    addUsage( tr("Transitions"), _transitions.memoryUsage(),
+              tr("%1 transitions").arg( _transitions.size() ) );
+
+    size_t checkpoints_bytes = _checkpoints.capacity() * sizeof(Checkpoint);
+    for (const auto& checkpoint: _checkpoints)
+    {
+        checkpoints_bytes += checkpoint.status.capacity() * sizeof(NodeStatus);
+    }
+    addUsage( tr("Checkpoints"), checkpoints_bytes,
+              tr("%1 checkpoints, one every %2 transitions").arg( _checkpoints.size() ).arg( CHECKPOINT_PERIOD ) );
+
+    size_t node_transitions_bytes = _node_transitions.capacity() * sizeof(std::vector<int>);
+    for (const auto& rows: _node_transitions)
+    {
+        node_transitions_bytes += rows.capacity() * sizeof(int);
+    }
+    node_transitions_bytes += _timepoint.capacity() * sizeof(std::pair<double,int>);
+    node_transitions_bytes += ( _failure_rows.capacity() + _bookmarks.capacity() ) * sizeof(int);
+    addUsage( tr("Index of the transitions"), node_transitions_bytes,
+              tr("rows of %1 nodes, %2 timepoints").arg( _node_transitions.size() ).arg( _timepoint.size() ) );
+
+    // the model reads _transitions, it doesn't copy them. The filter keeps
+    // the rows it shows
+    addUsage( tr("Table model"),
+              sizeof(ReplayTableModel) + sizeof(ReplayFilterModel) +
+              _filter_model->filteredRows().capacity() * sizeof(int),
+              _filter_model->isFiltered() ? tr("%1 rows, %2 filtered").arg( _table_model->rowCount() )
+                                                                      .arg( _filter_model->filteredRows().size() )
+                                          : tr("%1 rows, nothing stored per row").arg( _table_model->rowCount() ) );
+
+    if( !_compared_transitions.empty() )
+    {
+        const size_t compared_index = addUsage( tr("Compared log"), _compared_transitions.memoryUsage(),
+                                                tr("%1 transitions of %2").arg( _compared_transitions.size() )
+                                                                          .arg( _compared_filename ) );
+        usages[compared_index].release_label = tr("Close the compared log");
+        usages[compared_index].release = [this]() { clearComparison(); };
+    }
+    return usages;
+}
+
+void SidepanelReplay::updateComparison()
+{
+    const double tolerance = ui->spinBoxComparisonTolerance->value() * 0.001;
+    _comparison.compare( _transitions, _compared_transitions, _loaded_tree.nodesCount(), tolerance );
+
+    const std::vector<NodeTimingStatistics>& statistics = _statistics;
+
+    ui->tableViewComparison->setSortingEnabled(false);
+    _comparison_model->setRowCount(0);
+
+    auto numberItem = [](double value) -> QStandardItem*
+    {
+        auto item = new QStandardItem();
+        item->setData( value, Qt::DisplayRole );
+        return item;
+    };
+
+    int divergent_nodes = 0;
+    const auto& nodes = _comparison.nodes();
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        const NodeComparison& node = nodes[index];
+        if( node.ticks == 0 )
+        {
+            continue;
+        }
+        const double mean_a = index < statistics.size() ? statistics[index].running_mean : 0.0;
+        const double mean_b = index < _compared_statistics.size() ? _compared_statistics[index].running_mean : 0.0;
+
+        QList<QStandardItem *> row;
+        row << new QStandardItem( _loaded_tree.node(index)->instance_name );
+        row << numberItem( node.ticks );
+        row << numberItem( node.outcome_mismatches );
+        row << numberItem( node.timing_mismatches );
+        row << numberItem( std::round( mean_a * 1e6 ) / 1e3 );
+        row << numberItem( std::round( mean_b * 1e6 ) / 1e3 );
+        row << numberItem( std::round( node.mean_delta * 1e6 ) / 1e3 );
+        row << numberItem( std::round( node.max_delta * 1e6 ) / 1e3 );
+
+        QStandardItem* tick_item = new QStandardItem( node.first_divergent_tick >= 0 ?
+                                                          QString::number(node.first_divergent_tick) : QString("-") );
+        tick_item->setData( node.first_divergent_tick, Qt::UserRole );
+        row << tick_item;
+
+        if( node.diverges() )
+        {
+            divergent_nodes++;
+            for (QStandardItem* item: row)
+            {
+                item->setBackground( QColor(255, 210, 210) );
+            }
+        }
+        _comparison_model->appendRow( row );
+    }
+    ui->tableViewComparison->setSortingEnabled(true);
+
+    ui->labelComparison->setText(
+                tr("B: %1. Ticks aligned: %2 (A: %3, B: %4). Mean tick: A %5 ms, B %6 ms. Divergent nodes: %7")
+                .arg( _compared_filename )
+                .arg( _comparison.alignedTicks() )
+                .arg( _comparison.ticksA().size() )
+                .arg( _comparison.ticksB().size() )
+                .arg( _comparison.meanTickDurationA() * 1000, 0, 'f', 1 )
+                .arg( _comparison.meanTickDurationB() * 1000, 0, 'f', 1 )
+                .arg( divergent_nodes ) );
+}
+
+void SidepanelReplay::on_checkBoxFollow_toggled(bool checked)
+{
+    if( !_follow_watcher->files().isEmpty() )
+    {
+        _follow_watcher->removePaths( _follow_watcher->files() );
+    }
+    if( checked && !_log_filename.isEmpty() )
+    {
+        // the watcher is not reliable on every file system, poll too
+        _follow_watcher->addPath( _log_filename );
+        _follow_timer->start();
+        onFollowUpdate();
+    }
+    else{
+        _follow_timer->stop();
+    }
+}
+
+void SidepanelReplay::onFollowUpdate()
+{
+    // wait for the first parsing to be completed
+    if( !ui->checkBoxFollow->isChecked() || _log_filename.isEmpty() ||
+        _parse_future.isRunning() || _parse_timer->isActive() )
+    {
+        return;
+    }
+
+    QFile file( _log_filename );
+    if( !file.open(QIODevice::ReadOnly) || size_t(file.size()) <= _parsed_end_offset )
+    {
+        return;
+    }
+
+    // read only complete records; the last one might still be in the process of being written
+    const size_t available = std::min( size_t(file.size()) - _parsed_end_offset,
+                                       size_t(FOLLOW_MAX_RECORDS) * 12 );
+    const size_t records_bytes = (available / 12) * 12;
+    if( records_bytes == 0 || !file.seek( _parsed_end_offset ) )
+    {
+        return;
+    }
+    const QByteArray records = file.read( records_bytes );
+
+    const int prev_last_row = int(_transitions.size()) - 1;
+    const bool was_at_end = ( _prev_row == prev_last_row );
+
+    _appending = true;
+    _parse_cancel = false;
+    parseTransitions( records.constData(), 0, size_t(records.size()) );
+    onParseTimer();
+    _appending = false;
+
+    // keep showing the most recent status
+    const int last_row = int(_transitions.size()) - 1;
+    if( was_at_end && last_row > prev_last_row && !ui->pushButtonPlay->isChecked() )
+    {
+        onRowChanged( last_row );
+        updatedSpinAndSlider( last_row );
+        scrollToRow( last_row, QAbstractItemView::EnsureVisible );
+    }
+}
+
+void SidepanelReplay::stopParsing()
+{
+    _parse_cancel = true;
+    _parse_future.waitForFinished();
+    _parse_timer->stop();
+    {
+        QMutexLocker lock( &_parse_mutex );
+        _pending_transitions.clear();
+        _pending_checkpoints.clear();
+        _pending_node_rows.clear();
+        _pending_failure_rows.clear();
+        _pending_timeline.clear();
+        _pending_timeline_changed = false;
+    }
+    ui->progressBar->setVisible( false );
+    ui->pushButtonCancel->setVisible( false );
+}
+
+void SidepanelReplay::on_pushButtonCancel_clicked()
+{
+    // the transitions parsed so far are kept. onParseTimer will do the rest
+    _parse_cancel = true;
+}
+
+void SidepanelReplay::on_spinBox_valueChanged(int value)
+{
+    if( ui->timeSlider->value() != value)
+    {
+        ui->timeSlider->setValue( value );
+    }
+
+    int row = _timepoint[value].second;
+
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
+
+    onRowChanged( row );
+}
+
+void SidepanelReplay::seekTransition(int row)
+{
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
+    onRowChanged( row );
+    updatedSpinAndSlider( row );
+}
+
+bool SidepanelReplay::isParsing() const
+{
+    return _parse_timer->isActive();
+}
+
+void SidepanelReplay::refreshNodeStyles()
+{
+    if( _prev_row < 0 || _transitions.empty() )
+    {
+        return;
+    }
+    _status_delta.reset( _loaded_tree.nodesCount() );
+    _status_delta.set( statusAt( _prev_row ) );
+    const auto node_status = _status_delta.takeDelta();
+    if( !node_status.empty() )
+    {
+        emit changeNodeStyle( "BehaviorTree", node_status );
+    }
+}
+
+void SidepanelReplay::on_timeSlider_valueChanged(int value)
+{
+    if( ui->spinBox->value() != value)
+    {
+        ui->spinBox->setValue( value );
+    }
+
+    int row = _timepoint[value].second;
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
+
+    onRowChanged( row );
+}
+
+void SidepanelReplay::onRowChanged(int current_row)
+{
+    current_row = std::min( current_row, _table_model->rowCount() -1 );
+    current_row = std::max( current_row, 0 );
+
+    if( _prev_row == current_row)
+    {
+        // nothing to do
+        return;
+    }
+    TraceScope trace( "replay", "seek" );
+    trace.setArgument( "row", current_row );
+    trace.setArgument( "previous_row", _prev_row );
+
+    // disable section resize, otherwise it will be SUPER slow
+    // We will refresh this in the callback of _layout_update_timer -> onTimerUpdate
+    ui->tableView->horizontalHeader()->setSectionResizeMode (QHeaderView::Fixed);
+    ui->tableView->verticalHeader()->setSectionResizeMode (QHeaderView::Fixed);
+
+    // highlighting is a range check inside the model
+    _table_model->setCurrentRow( current_row );
+    _timeline->setCurrentTime( _transitions.timestamp(current_row) - _transitions.timestamp(0) );
+
+    // cancel the refresh of the layout refresh
+    if( !_layout_update_timer->isActive() )
+    {
+        _layout_update_timer->stop();
+    }
+    _layout_update_timer->start(100);
+
+    const QString bt_name("BehaviorTree");
+
+    const int restart_index = _transitions.nearestRestart(current_row);
+    const bool same_run = _prev_row >= 0 &&
+            _transitions.nearestRestart(_prev_row) == restart_index &&
+            std::abs( current_row - _prev_row ) <= CHECKPOINT_PERIOD;
+
+    if( same_run && current_row > _prev_row )
+    {
+        // step forward: apply only the transitions in between
+        for (int t = _prev_row + 1; t <= current_row; t++)
+        {
+            _status_delta.add( _transitions.index(t), _transitions.status(t) );
+        }
+    }
+    else if( same_run )
+    {
+        // step backward: the status of a node is the one of its previous transition
+        for (int t = _prev_row; t > current_row; t--)
+        {
+            const int index = _transitions.index(t);
+            const std::vector<int>& rows = _node_transitions[index];
+            auto it = std::lower_bound( rows.begin(), rows.end(), t );
+            NodeStatus status = NodeStatus::IDLE;
+            if( it != rows.begin() && *(it-1) >= restart_index )
+            {
+                status = _transitions.status( *(it-1) );
+            }
+            _status_delta.add( index, status );
+        }
+    }
+    else{
+        _status_delta.set( statusAt( current_row ) );
+    }
+
+    // only the nodes whose status changed since the last update
+    const auto node_status = _status_delta.takeDelta();
+    if( !node_status.empty() )
+    {
+        emit changeNodeStyle( bt_name, node_status );
+    }
+
+    _prev_row = current_row;
+}
+
+std::vector<NodeStatus> SidepanelReplay::statusAt(int current_row) const
+{
+    const int restart_index = _transitions.nearestRestart(current_row);
+
+    // start from the closest checkpoint after the last restart, if any
+    std::vector<NodeStatus> status( _loaded_tree.nodesCount(), NodeStatus::IDLE );
+    int first_transition = restart_index;
+
+    auto checkpoint_it = std::upper_bound( _checkpoints.begin(), _checkpoints.end(), current_row,
+                                           []( int val, const Checkpoint& cp ) -> bool
+    {
+        return val < cp.transition_index;
+    } );
+    if( checkpoint_it != _checkpoints.begin() )
+    {
+        const Checkpoint& checkpoint = *(checkpoint_it - 1);
+        if( checkpoint.transition_index >= restart_index )
+        {
+            status = checkpoint.status;
+            first_transition = checkpoint.transition_index + 1;
+        }
+    }
+
+    for (int t = first_transition; t <= current_row; t++)
+    {
+        status[ _transitions.index(t) ] = _transitions.status(t);
+    }
+    return status;
+}
+
+void SidepanelReplay::updatedSpinAndSlider(int row)
+{
+    auto it = std::upper_bound( _timepoint.begin(), _timepoint.end(), row,
+                                []( int val, const std::pair<double,int>& a ) -> bool
+    {
+        return val < a.second;
+    } );
+
+    QSignalBlocker block_spin( ui->spinBox );
+    QSignalBlocker block_Slider( ui->timeSlider );
+
+    int index = (it - _timepoint.begin()) -1;
     index = std::min( index, static_cast<int>(_timepoint.size()) -1 );
     index = std::max( index, 0 );
 
@@ -393,21 +1643,48 @@ bool SidepanelReplay::eventFilter(QObject *object, QEvent *event)
             QKeyEvent *key_event = static_cast<QKeyEvent *>(event);
 
             int next_row = -1;
-            if( key_event->key() ==  Qt::Key_Down)
+            const bool forward = ( key_event->key() == Qt::Key_Down );
+            const bool shift = ( key_event->modifiers() & Qt::ShiftModifier );
+            const bool control = ( key_event->modifiers() & Qt::ControlModifier );
+
+            if( key_event->key() == Qt::Key_F3 )
+            {
+                next_row = adjacentFailure( _prev_row, !shift, control );
+            }
+            else if( key_event->key() == Qt::Key_F2 )
             {
-                next_row = _prev_row +1;
+                next_row = adjacentRow( _bookmarks, _prev_row, !shift );
             }
-            else if( key_event->key() ==  Qt::Key_Up)
+            else if( key_event->key() == Qt::Key_B && control )
             {
-                next_row = _prev_row -1;
+                if( _prev_row >= 0 )
+                {
+                    toggleBookmark( _prev_row );
+                }
+            }
+            else if( key_event->key() == Qt::Key_Down || key_event->key() == Qt::Key_Up )
+            {
+                if( (key_event->modifiers() & Qt::ControlModifier) && _prev_row >= 0 )
+                {
+                    // jump to the next/previous transition of the same node
+                    const int node_index = _transitions.index(_prev_row);
+                    next_row = adjacentRow( _node_transitions[node_index], _prev_row, forward );
+                }
+                else if( _filter_model->isFiltered() )
+                {
+                    next_row = adjacentRow( _filter_model->filteredRows(), _prev_row, forward );
+                }
+                else
+                {
+                    next_row = forward ? _prev_row +1 : _prev_row -1;
+                }
             }
 
             if( next_row >= 0 && next_row < _table_model->rowCount() )
             {
                 onRowChanged( next_row);
                 updatedSpinAndSlider( next_row );
-                ui->tableView->scrollTo( _table_model->index(next_row,0),
-                                         QAbstractItemView::EnsureVisible);
+                scrollToRow( next_row, QAbstractItemView::EnsureVisible );
             }
             return true;
         }
@@ -420,9 +1697,284 @@ void SidepanelReplay::on_tableView_clicked(const QModelIndex &index)
     // disable during play
     if( !ui->pushButtonPlay->isChecked())
     {
-        onRowChanged( index.row() );
-        updatedSpinAndSlider( index.row() );
+        const int row = _filter_model->mapToSource( index ).row();
+        onRowChanged( row );
+        updatedSpinAndSlider( row );
+    }
+}
+
+void SidepanelReplay::onTimelineTimeSelected(double relative_time)
+{
+    // disable during play
+    if( ui->pushButtonPlay->isChecked() || _transitions.empty() )
+    {
+        return;
+    }
+    const size_t row = std::min( _transitions.lowerBound( _transitions.timestamp(0) + relative_time ),
+                                 _transitions.size() - 1 );
+    onRowChanged( int(row) );
+    updatedSpinAndSlider( int(row) );
+    scrollToRow( int(row), QAbstractItemView::PositionAtCenter );
+}
+
+void SidepanelReplay::onGoToTime()
+{
+    // disable during play
+    if( ui->pushButtonPlay->isChecked() || _transitions.empty() )
+    {
+        return;
+    }
+    const double current_timestamp = _transitions.timestamp( std::max( 0, _prev_row ) );
+    double timestamp = 0;
+    if( !parseTime( _line_edit_time->text(), _transitions.timestamp(0), current_timestamp, &timestamp ) )
+    {
+        _line_edit_time->setStyleSheet( "color: rgb(210, 30, 30)" );
+        return;
+    }
+    _line_edit_time->setStyleSheet( QString() );
+    seekTime( timestamp );
+}
+
+void SidepanelReplay::seekTime(double timestamp)
+{
+    if( _transitions.empty() )
+    {
+        return;
+    }
+    // the rows are searched by timestamp, the status comes from the nearest checkpoint
+    const size_t upper = _transitions.upperBound( timestamp );
+    seekTransition( upper == 0 ? 0 : int(upper) - 1 );
+}
+
+// seconds, "m:s" or "h:m:s", with decimals. -1 if invalid
+static double ParseDuration(const QString& text)
+{
+    const QStringList parts = text.split(':');
+    if( parts.size() > 3 )
+    {
+        return -1;
+    }
+    double seconds = 0;
+    for (int i = 0; i < parts.size(); i++)
+    {
+        bool ok = false;
+        const double value = parts[i].trimmed().toDouble( &ok );
+        // only the seconds have decimals
+        if( !ok || value < 0 || ( i + 1 < parts.size() && value != std::floor(value) ) )
+        {
+            return -1;
+        }
+        seconds = seconds * 60 + value;
+    }
+    return seconds;
+}
+
+bool SidepanelReplay::parseTime(const QString &input, double first_timestamp,
+                                double current_timestamp, double *timestamp)
+{
+    QString text = input.trimmed();
+    if( text.endsWith('s') )
+    {
+        text.chop(1);
+        text = text.trimmed();
     }
+    if( text.isEmpty() )
+    {
+        return false;
+    }
+
+    if( text.indexOf('-') > 0 )
+    {
+        // a date, in local time
+        text.replace('T', ' ');
+        for (const char* format: { "yyyy-MM-dd hh:mm:ss.zzz", "yyyy-MM-dd hh:mm:ss", "yyyy-MM-dd hh:mm" })
+        {
+            const QDateTime date_time = QDateTime::fromString( text, format );
+            if( date_time.isValid() )
+            {
+                *timestamp = date_time.toMSecsSinceEpoch() * 0.001;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if( text.startsWith('@') )
+    {
+        // a log that crosses midnight needs the date
+        text = text.mid(1).trimmed();
+        for (const char* format: { "h:mm:ss.zzz", "h:mm:ss", "h:mm" })
+        {
+            const QTime time = QTime::fromString( text, format );
+            if( time.isValid() )
+            {
+                const QDateTime start = QDateTime::fromMSecsSinceEpoch( qint64( first_timestamp * 1000 ) );
+                *timestamp = QDateTime( start.date(), time ).toMSecsSinceEpoch() * 0.001;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if( text.startsWith('+') || text.startsWith('-') )
+    {
+        const double offset = ParseDuration( text.mid(1) );
+        if( offset < 0 )
+        {
+            return false;
+        }
+        *timestamp = current_timestamp + ( text.startsWith('-') ? -offset : offset );
+        return true;
+    }
+
+    const double seconds = ParseDuration( text );
+    if( seconds < 0 )
+    {
+        return false;
+    }
+    // no log lasts 3 years: a larger number is a time since epoch
+    const double EPOCH_THRESHOLD = 1e8;
+    *timestamp = ( seconds > EPOCH_THRESHOLD ) ? seconds : first_timestamp + seconds;
+    return true;
+}
+
+void SidepanelReplay::toggleBookmark(int row)
+{
+    if( row < 0 || size_t(row) >= _transitions.size() )
+    {
+        return;
+    }
+    auto it = std::lower_bound( _bookmarks.begin(), _bookmarks.end(), row );
+    if( it != _bookmarks.end() && *it == row )
+    {
+        _bookmarks.erase( it );
+    }
+    else{
+        _bookmarks.insert( it, row );
+    }
+    saveBookmarks();
+    updateTimelineBookmarks();
+}
+
+int SidepanelReplay::adjacentFailure(int row, bool forward, bool same_node) const
+{
+    if( !same_node || row < 0 || size_t(row) >= _transitions.size() )
+    {
+        return adjacentRow( _failure_rows, row, forward );
+    }
+    // the transitions of the node, not those of the whole log
+    const std::vector<int>& rows = _node_transitions[ _transitions.index(row) ];
+    if( forward )
+    {
+        for (auto it = std::upper_bound( rows.begin(), rows.end(), row ); it != rows.end(); it++)
+        {
+            if( _transitions.status(*it) == NodeStatus::FAILURE )
+            {
+                return *it;
+            }
+        }
+        return -1;
+    }
+    auto it = std::lower_bound( rows.begin(), rows.end(), row );
+    while( it != rows.begin() )
+    {
+        it--;
+        if( _transitions.status(*it) == NodeStatus::FAILURE )
+        {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+void SidepanelReplay::jumpToRow(int row)
+{
+    // disable during play
+    if( ui->pushButtonPlay->isChecked() || row < 0 || row >= _table_model->rowCount() )
+    {
+        return;
+    }
+    onRowChanged( row );
+    updatedSpinAndSlider( row );
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
+}
+
+// the bookmarks of all the logs, by absolute path of the file
+static const char* BOOKMARKS_KEY = "SidepanelReplay.bookmarks";
+
+void SidepanelReplay::loadBookmarks()
+{
+    _bookmarks.clear();
+    if( _log_filename.isEmpty() )
+    {
+        return;
+    }
+    QSettings settings;
+    const QVariantMap all_bookmarks = settings.value( BOOKMARKS_KEY ).toMap();
+    for (const QVariant& row: all_bookmarks.value( QFileInfo(_log_filename).absoluteFilePath() ).toList())
+    {
+        _bookmarks.push_back( row.toInt() );
+    }
+    std::sort( _bookmarks.begin(), _bookmarks.end() );
+}
+
+void SidepanelReplay::saveBookmarks() const
+{
+    if( _log_filename.isEmpty() )
+    {
+        return;
+    }
+    QSettings settings;
+    QVariantMap all_bookmarks = settings.value( BOOKMARKS_KEY ).toMap();
+    const QString key = QFileInfo(_log_filename).absoluteFilePath();
+    if( _bookmarks.empty() )
+    {
+        all_bookmarks.remove( key );
+    }
+    else{
+        QVariantList rows;
+        for (int row: _bookmarks)
+        {
+            rows.push_back( row );
+        }
+        all_bookmarks.insert( key, rows );
+    }
+    settings.setValue( BOOKMARKS_KEY, all_bookmarks );
+}
+
+void SidepanelReplay::updateTimelineBookmarks()
+{
+    std::vector<double> times;
+    for (int row: _bookmarks)
+    {
+        // the bookmarks of the rows not parsed yet appear later
+        if( size_t(row) < _transitions.size() )
+        {
+            times.push_back( _transitions.timestamp(row) - _transitions.timestamp(0) );
+        }
+    }
+    _timeline->setBookmarks( std::move(times) );
+}
+
+void SidepanelReplay::scrollToRow(int row, QAbstractItemView::ScrollHint hint)
+{
+    // rows hidden by the filter are ignored
+    QModelIndex index = _filter_model->mapFromSource( _table_model->index(row,0) );
+    if( index.isValid() )
+    {
+        ui->tableView->scrollTo( index, hint );
+    }
+}
+
+int SidepanelReplay::adjacentRow(const std::vector<int>& rows, int row, bool forward)
+{
+    if( forward )
+    {
+        auto it = std::upper_bound( rows.begin(), rows.end(), row );
+        return ( it == rows.end() ) ? -1 : *it;
+    }
+    auto it = std::lower_bound( rows.begin(), rows.end(), row );
+    return ( it == rows.begin() ) ? -1 : *(it - 1);
 }
 
 void SidepanelReplay::onTimerUpdate()
@@ -441,11 +1993,17 @@ void SidepanelReplay::on_pushButtonPlay_toggled(bool checked)
     if(checked)
     {
         _next_row = std::max(0, _prev_row);
+        if( !_transitions.empty() )
+        {
+            _play_virtual_time = _transitions.timestamp( std::min<int>(_next_row, _transitions.size()-1) );
+        }
+        _play_elapsed.start();
+        _play_timer->start();
         onPlayUpdate();
     }
     else{
-        ui->tableView->scrollTo( _table_model->index( _prev_row,0),
-                                 QAbstractItemView::PositionAtCenter);
+        _play_timer->stop();
+        scrollToRow( _prev_row, QAbstractItemView::PositionAtCenter );
     }
 }
 
@@ -453,55 +2011,62 @@ void SidepanelReplay::onPlayUpdate()
 {
     if( !ui->pushButtonPlay->isChecked() || _transitions.empty() )
     {
+        _play_timer->stop();
         return;
-    }  
+    }
 
-    using namespace std::chrono;
     const int LAST_ROW = _transitions.size()-1;
 
+    // advance the virtual clock by the real time elapsed since the last frame,
+    // scaled by the chosen speed. All the transitions within the frame are
+    // applied at once by onRowChanged.
+    const double elapsed = _play_elapsed.restart() * 0.001;
+    _play_virtual_time += elapsed * ui->spinBoxSpeed->value();
+
     _next_row = std::max(0, _next_row);
     _next_row = std::min(LAST_ROW, _next_row);
 
-    const double TIME_DIFFERENCE_THRESHOLD = 0.01;
-
-    // move forward as long as timestamp difference is small.
-    while( _next_row < LAST_ROW -1 &&
-           (_transitions[_next_row+1].timestamp - _transitions[_next_row].timestamp) < TIME_DIFFERENCE_THRESHOLD )
+    while( _next_row < LAST_ROW && _transitions.timestamp(_next_row+1) <= _play_virtual_time )
     {
         _next_row++;
     }
 
-    onRowChanged( _next_row );
-    updatedSpinAndSlider( _next_row );
-    ui->tableView->scrollTo( _table_model->index(_next_row,0), QAbstractItemView::EnsureVisible  );
+    if( _next_row != _prev_row )
+    {
+        onRowChanged( _next_row );
+        updatedSpinAndSlider( _next_row );
+        scrollToRow( _next_row, QAbstractItemView::EnsureVisible );
+    }
 
     if( _next_row == LAST_ROW)
     {
         ui->pushButtonPlay->setChecked(false);
-        return;
     }
-
-    const double prev_time = _transitions[_next_row].timestamp;
-    const double next_time = _transitions[_next_row+1].timestamp;
-    int delay_relative = (next_time - prev_time) * 1000;
-
-    _next_row++;
-    //qDebug() << "delay_relative " << delay_relative << " next_row " << _next_row << "\n";
-
-    _play_timer->start(delay_relative);
 }
 
 void SidepanelReplay::on_lineEditFilter_textChanged(const QString &filter_text)
 {
-    for (int row=0; row < _table_model->rowCount(); row++ )
+    if( filter_text.isEmpty() )
     {
-        bool show = _table_model->item(row,1)->text().contains(filter_text, Qt::CaseInsensitive);
+        _filtered_nodes.clear();
+        _filter_model->clearFilter();
+        return;
+    }
 
-        if( show ){
-            ui->tableView->showRow(row);
-        }
-        else{
-            ui->tableView->hideRow(row);
+    // compare the names once per node, then merge the transitions of the matching nodes
+    _filtered_nodes.assign( _loaded_tree.nodesCount(), false );
+    std::vector<int> rows;
+    for (size_t index = 0; index < _loaded_tree.nodesCount(); index++ )
+    {
+        const auto& name = _loaded_tree.node(index)->instance_name;
+        if( index < _node_transitions.size() && name.contains(filter_text, Qt::CaseInsensitive) )
+        {
+            _filtered_nodes[index] = true;
+            const auto& node_rows = _node_transitions[index];
+            const size_t middle = rows.size();
+            rows.insert( rows.end(), node_rows.begin(), node_rows.end() );
+            std::inplace_merge( rows.begin(), rows.begin() + middle, rows.end() );
         }
     }
+    _filter_model->setFilteredRows( std::move(rows) );
 }
@@ -1,11 +1,26 @@
 #ifndef SIDEPANEL_REPLAY_H
 #define SIDEPANEL_REPLAY_H
 
+#include <atomic>
 #include <chrono>
+#include <QFile>
 #include <QFrame>
-#include <QTableWidgetItem>
-#include <QStandardItemModel>
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QAbstractItemView>
+#include <QMutex>
 #include "bt_editor_base.h"
+#include "replay_table_model.h"
+#include "replay_statistics.h"
+#include "replay_timeline.h"
+#include "replay_log_format.h"
+#include "status_delta.h"
+#include "replay_comparison.h"
+#include "memory_report.h"
+
+class QStandardItemModel;
+class QLineEdit;
+class QFileSystemWatcher;
 
 
 namespace Ui {
@@ -22,10 +37,72 @@ public:
 
     void clear();
 
-    void loadLog(const QByteArray& content);
+    // log_filename is optional. If given, the index file "<log_filename>.gidx"
+    // is used to speed up the loading, or created if it doesn't exist.
+    void loadLog(const QByteArray& content, const QString& log_filename = QString());
+
+    // Parse a log directly from a memory region. Large logs are parsed in the
+    // background: the region must stay valid until the parsing is completed
+    // (see stopParsing).
+    void loadLog(const char* buffer, size_t size, const QString& log_filename = QString());
+
+    // Memory-map the file and parse it in place, without copying it into RAM.
+    // Falls back to a full read when the file can not be mapped.
+    bool loadLogFile(const QString& filename);
 
     size_t transitionsCount() const { return _transitions.size(); }
 
+    const ReplayTransitions& transitions() const { return _transitions; }
+
+    // a large log is still being parsed in the background
+    bool isParsing() const;
+
+    // Show the status of the tree at a time, in seconds since epoch as the
+    // timestamps of the transitions: the one after the last transition
+    // before (or at) it
+    void seekTime(double timestamp);
+
+    // the row of the transition shown, -1 before the first seek
+    int currentRow() const { return _prev_row; }
+
+    // A time typed in the "go to" field:
+    //  "12.5", "1:02.5"       seconds since the first transition
+    //  "+3", "-0.5"           relative to the current transition
+    //  "@13:45:02.250"        wall clock, on the day of the first transition
+    //  "2026-10-14 13:45:02"  date and wall clock, in local time
+    //  "1760446502.25"        seconds since epoch
+    // False if the text is none of them
+    static bool parseTime(const QString& text, double first_timestamp,
+                          double current_timestamp, double* timestamp);
+
+    // sorted rows, kept for each log file
+    const std::vector<int>& bookmarks() const { return _bookmarks; }
+
+    void toggleBookmark(int row);
+
+    // The next (or previous) FAILURE after row, -1 if there is none. With
+    // same_node, only those of the node of the transition at row
+    int adjacentFailure(int row, bool forward, bool same_node) const;
+
+    // emit the status of all the nodes at the current transition again,
+    // after the styles of the scene were reset
+    void refreshNodeStyles();
+
+    // show the status of the tree after the transition at row, as a click
+    // on the table does
+    void seekTransition(int row);
+
+    // the loaded log, its transitions and the structures built from them.
+    // The release actions close the log or the compared one
+    std::vector<MemoryUsage> memoryUsage();
+
+    // Write the transitions [first_row, last_row] to a new .fbl file, with the
+    // same tree header. If with_snapshot is true, it starts with synthetic
+    // transitions from IDLE to the status of the tree before first_row.
+    // The file is block-compressed (see ReplayLogFormat) if its name ends
+    // with ".fblz".
+    bool exportRange(const QString& filename, int first_row, int last_row, bool with_snapshot) const;
+
 public slots:
 
     void on_LoadLog();
@@ -46,13 +123,36 @@ private slots:
 
     void on_lineEditFilter_textChanged(const QString &filter_text);
 
+    void on_pushButtonCancel_clicked();
+
+    void on_pushButtonStatistics_clicked();
+
+    void on_pushButtonExport_clicked();
+
+    void on_pushButtonCompare_clicked();
+
+    void on_spinBoxComparisonTolerance_valueChanged(double);
+
+    void on_tableViewComparison_doubleClicked(const QModelIndex &index);
+
+    void onParseTimer();
+
+    void onTimelineTimeSelected(double relative_time);
+
+    void on_checkBoxFollow_toggled(bool checked);
+
+    // parse the records appended to the log file since the last call
+    void onFollowUpdate();
+
+    void onGoToTime();
+
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString& name );
 
     void changeNodeStyle(const QString& bt_name,
                          const std::vector<std::pair<int, NodeStatus>>& node_status);
 
-    void addNewModel(const NodeModel &new_model);
+    void addNewModels(const NodeModels &new_models);
 
 private:
 
@@ -62,35 +162,167 @@ private:
 
     void onRowChanged(int value);
 
+    // status of all the nodes after the transition at row
+    std::vector<NodeStatus> statusAt(int row) const;
+
+    // scroll to a row of _table_model, if it is visible
+    void scrollToRow(int row, QAbstractItemView::ScrollHint hint);
+
+    // select the row, as a click on the table, and center it
+    void jumpToRow(int row);
+
+    void loadBookmarks();
+    void saveBookmarks() const;
+    void updateTimelineBookmarks();
+
+    // next (or previous) element of a sorted list of rows, -1 if there is none
+    static int adjacentRow(const std::vector<int>& rows, int row, bool forward);
+
+    // parse the transitions of the log, either raw or block-compressed
+    void parseLog(const char* buffer, size_t begin, size_t end);
+
+    void parseTransitions(const char* buffer, size_t begin, size_t end);
+
+    // cancel the background parsing (if any) and wait for the worker
+    void stopParsing();
+
+    // forget the buffer of the loaded log, then unmap or free it
+    void releaseLog();
+
+    // The index file caches restarts, timepoints and checkpoints of a log.
+    // It is valid only if size and modification time of the log didn't change.
+    bool loadIndexFile(size_t transitions_count);
+    void saveIndexFile() const;
+
+    void updateStatisticsTable(const std::vector<NodeTimingStatistics>& statistics);
+
+    void clearComparison();
+    void updateComparison();
+
     Ui::SidepanelReplay *ui;
 
-    struct Transition{
-        int16_t index;
-        double timestamp;
-        NodeStatus prev_status;
-        NodeStatus status;
-        bool is_tree_restart;
-        int nearest_restart_transition_index;
+    using Transition = ReplayTransition;
+    ReplayTransitions _transitions;
+
+    // Full status of the tree after the transition at transition_index.
+    // Recorded every CHECKPOINT_PERIOD transitions, used to seek quickly.
+    struct Checkpoint{
+        int transition_index;
+        std::vector<NodeStatus> status;
     };
-    std::vector<Transition> _transitions;
+    std::vector<Checkpoint> _checkpoints;
+    static const int CHECKPOINT_PERIOD = 1024;
     std::vector< std::pair<double,int>> _timepoint;
 
     int _prev_row;
+    // status of the nodes in the scene, to emit only what changed
+    NodeStatusDelta _status_delta;
     int _next_row;
 
     void updatedSpinAndSlider(int row);
 
-    QStandardItemModel* _table_model;
+    ReplayTableModel* _table_model;
+
+    ReplayFilterModel* _filter_model;
+
+    // for each node, the sorted list of its transitions (rows)
+    std::vector<std::vector<int>> _node_transitions;
+
+    // the transitions to FAILURE, of any node
+    std::vector<int> _failure_rows;
+
+    std::vector<int> _bookmarks;
+    QLineEdit* _line_edit_time;
+
+    // nodes matching the text of lineEditFilter
+    std::vector<bool> _filtered_nodes;
+
+    // of the whole log, taken from _parser_state once it is parsed
+    std::vector<NodeTimingStatistics> _statistics;
+    QStandardItemModel* _statistics_model;
+
+    ReplayTimeline* _timeline;
+
+    // the log compared with this one (B)
+    ReplayTransitions _compared_transitions;
+    std::vector<NodeTimingStatistics> _compared_statistics;
+    QString _compared_filename;
+    ReplayComparison _comparison;
+    QStandardItemModel* _comparison_model;
 
     QTimer *_layout_update_timer;
 
     QTimer *_play_timer;
 
+    // playback: a virtual clock (timestamp of the log) advanced at every frame
+    static const int PLAY_FRAME_RATE = 30;
+    double _play_virtual_time;
+    QElapsedTimer _play_elapsed;
+
     AbsBehaviorTree _loaded_tree;
 
     void updateTableModel(const AbsBehaviorTree &tree);
 
     QWidget *_parent;
+
+    // keeps the mapping of the last loaded log alive
+    QFile _log_file;
+    uchar* _mapped_log;
+    QByteArray _log_content;
+
+    // the loaded log, its flatbuffers header and the uid of each node
+    const char* _log_buffer;
+    size_t _log_buffer_size;
+    QByteArray _log_header;
+    std::vector<uint16_t> _index_to_uid;
+
+    // logs shorter than this are parsed synchronously
+    static const size_t BACKGROUND_PARSE_THRESHOLD = 200000;
+    static const size_t PARSE_CHUNK_SIZE = 50000;
+
+    UidLookupTable _uid_to_index;
+
+    struct ParserState{
+        int idle_counter;
+        int nearest_restart_transition_index;
+        int parsed_count;
+        std::vector<NodeStatus> current_status;
+        // accumulated by the parse pass, in the worker
+        NodeTimingAccumulator statistics;
+        double first_timestamp;
+        ReplayTimelineData timeline;
+    };
+    ParserState _parser_state;
+    size_t _transitions_offset;
+    std::vector<ReplayLogFormat::BlockInfo> _compressed_blocks;
+    QFuture<void> _parse_future;
+    QTimer* _parse_timer;
+    QMutex _parse_mutex;
+    std::vector<Transition> _pending_transitions;
+    std::vector<Checkpoint> _pending_checkpoints;
+    // rows of _pending_transitions, for _node_transitions and _failure_rows
+    std::vector<std::vector<int>> _pending_node_rows;
+    std::vector<int> _pending_failure_rows;
+    // a copy of _parser_state.timeline, if it changed
+    ReplayTimelineData _pending_timeline;
+    bool _pending_timeline_changed;
+    std::atomic<bool> _parse_cancel;
+    std::atomic<bool> _parse_error;
+    std::atomic<size_t> _parse_progress;
+    size_t _parse_total_transitions;
+    double _last_timepoint_timestamp;
+
+    QString _log_filename;
+    bool _use_index;
+    std::vector<int> _indexed_restarts;
+    std::vector< std::pair<double,int>> _indexed_timepoints;
+
+    // follow mode
+    static const size_t FOLLOW_MAX_RECORDS = 200000;
+    QFileSystemWatcher* _follow_watcher;
+    QTimer* _follow_timer;
+    size_t _parsed_end_offset;
+    bool _appending;
 };
 
 #endif // SIDEPANEL_REPLAY_H
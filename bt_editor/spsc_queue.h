@@ -0,0 +1,74 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Bounded, lock-free queue with a single producer and a single consumer.
+// push() must be called only by the producer thread, pop() only by the consumer.
+template <typename T>
+class SpscQueue
+{
+public:
+    // the capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity):
+        _slots( roundUp(capacity) ),
+        _mask( _slots.size() - 1 ),
+        _head(0),
+        _tail(0)
+    {}
+
+    // false if the queue is full: value is left untouched
+    bool push(T&& value)
+    {
+        const size_t tail = _tail.load( std::memory_order_relaxed );
+        if( tail - _head.load( std::memory_order_acquire ) >= _slots.size() )
+        {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(value);
+        _tail.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    // false if the queue is empty
+    bool pop(T& value)
+    {
+        const size_t head = _head.load( std::memory_order_relaxed );
+        if( head == _tail.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        value = std::move( _slots[head & _mask] );
+        _head.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    // approximated, if called while the other thread is running
+    size_t size() const
+    {
+        return _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire );
+    }
+
+    size_t capacity() const { return _slots.size(); }
+
+private:
+    static size_t roundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while( size < capacity )
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    std::vector<T> _slots;
+    const size_t _mask;
+    // on different cache lines, to avoid false sharing between the threads
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,88 @@
+#include "startup_timing.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <QElapsedTimer>
+#include "trace_recorder.h"
+
+bool StartupTiming::_active = false;
+
+namespace {
+
+struct Milestone
+{
+    const char* name;
+    double msecs;
+};
+
+struct Timing
+{
+    QElapsedTimer timer;
+    // steady_clock of TraceRecorder, at start()
+    int64_t start_usec = 0;
+    bool print = false;
+    std::vector<Milestone> milestones;
+};
+
+Timing& Data()
+{
+    static Timing timing;
+    return timing;
+}
+
+}
+
+void StartupTiming::start()
+{
+    Timing& timing = Data();
+    timing.timer.start();
+    timing.start_usec = TraceRecorder::nowUsec();
+    timing.milestones.clear();
+    _active = true;
+}
+
+void StartupTiming::setPrintEnabled(bool enabled)
+{
+    Data().print = enabled;
+}
+
+void StartupTiming::mark(const char *milestone)
+{
+    if( !_active )
+    {
+        return;
+    }
+    Timing& timing = Data();
+    for (const auto& reached: timing.milestones)
+    {
+        if( std::strcmp( reached.name, milestone ) == 0 )
+        {
+            return;
+        }
+    }
+    const double msecs = double( timing.timer.nsecsElapsed() ) * 1e-6;
+    timing.milestones.push_back( { milestone, msecs } );
+
+    if( TraceRecorder::enabled() )
+    {
+        // from the beginning, the milestones are nested in the trace
+        TraceRecorder::Event event;
+        event.category = "startup";
+        event.name = milestone;
+        event.start_usec = timing.start_usec;
+        event.duration_usec = int64_t( msecs * 1000.0 );
+        event.thread_id = TraceRecorder::currentThreadId();
+        TraceRecorder::record( std::move(event) );
+    }
+    if( timing.print )
+    {
+        std::cout << "startup: " << milestone << " " << msecs << " ms" << std::endl;
+    }
+}
+
+void StartupTiming::finish(const char *milestone)
+{
+    mark( milestone );
+    _active = false;
+}
@@ -0,0 +1,29 @@
+#ifndef STARTUP_TIMING_H
+#define STARTUP_TIMING_H
+
+// Milestones of the startup of Groot, in milliseconds since the beginning
+// of main(): application, style, main window, event loop, and the first
+// tree or status shown. With --startup-timing they are printed as they are
+// reached; when a trace is recorded they are trace events too.
+class StartupTiming
+{
+public:
+    // at the beginning of main()
+    static void start();
+
+    static void setPrintEnabled(bool enabled);
+
+    // Only the first time a milestone is reached is recorded
+    static void mark(const char* milestone);
+
+    // the last milestone. The ones after it are ignored
+    static void finish(const char* milestone);
+
+    // false once finished: the callers in the hot paths check it first
+    static bool active() { return _active; }
+
+private:
+    static bool _active;
+};
+
+#endif // STARTUP_TIMING_H
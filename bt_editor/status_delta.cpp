@@ -0,0 +1,115 @@
+#include "status_delta.h"
+#include <algorithm>
+
+void NodeStatusDelta::reset(size_t nodes_count)
+{
+    _status.assign( nodes_count, NodeStatus::IDLE );
+    _prev_status.assign( nodes_count, NodeStatus::IDLE );
+    _touched.assign( nodes_count, 0 );
+    _touched_nodes.clear();
+    _emitted.assign( nodes_count, {NodeStatus::IDLE, NodeStatus::IDLE, false} );
+
+    // nothing was emitted yet: all of them must be sent
+    for (size_t index = 0; index < nodes_count; index++)
+    {
+        _touched[index] = 1;
+        _touched_nodes.push_back( int(index) );
+    }
+}
+
+void NodeStatusDelta::add(int node_index, NodeStatus status)
+{
+    if( node_index < 0 || size_t(node_index) >= _status.size() )
+    {
+        return;
+    }
+    if( !_touched[node_index] )
+    {
+        _touched[node_index] = 1;
+        _touched_nodes.push_back( node_index );
+        _prev_status[node_index] = NodeStatus::IDLE;
+    }
+    else{
+        _prev_status[node_index] = _status[node_index];
+    }
+    _status[node_index] = status;
+}
+
+void NodeStatusDelta::set(const std::vector<NodeStatus> &status)
+{
+    const size_t count = std::min( status.size(), _status.size() );
+    for (size_t index = 0; index < count; index++)
+    {
+        // a single change: IDLE nodes are not faded
+        if( !_touched[index] )
+        {
+            _touched[index] = 1;
+            _touched_nodes.push_back( int(index) );
+        }
+        _prev_status[index] = NodeStatus::IDLE;
+        _status[index] = status[index];
+    }
+}
+
+void NodeStatusDelta::append(int node_index, const Style &style,
+                             std::vector<std::pair<int, NodeStatus> > &delta)
+{
+    if( style.faded != NodeStatus::IDLE )
+    {
+        delta.push_back( {node_index, style.faded} );
+    }
+    delta.push_back( {node_index, style.status} );
+    _emitted[node_index] = style;
+}
+
+std::vector<std::pair<int, NodeStatus>> NodeStatusDelta::takeDelta()
+{
+    std::vector<std::pair<int, NodeStatus>> delta;
+
+    auto pendingStyle = [this](int index) -> Style
+    {
+        const NodeStatus status = _status[index];
+        const NodeStatus faded = (status == NodeStatus::IDLE) ? _prev_status[index] : NodeStatus::IDLE;
+        return {status, faded, true};
+    };
+
+    // the first child of the root becoming RUNNING resets the style of the tree
+    const int first_child = 1;
+    if( first_child < int(_status.size()) && _touched[first_child] )
+    {
+        const Style style = pendingStyle( first_child );
+        const bool running = (style.status == NodeStatus::RUNNING || style.faded == NodeStatus::RUNNING);
+        if( running && style != _emitted[first_child] )
+        {
+            append( first_child, style, delta );
+
+            const Style default_style = {NodeStatus::IDLE, NodeStatus::IDLE, true};
+            for (size_t index = 0; index < _emitted.size(); index++)
+            {
+                if( int(index) != first_child && _emitted[index].valid )
+                {
+                    _emitted[index] = default_style;
+                }
+                // untouched nodes keep their last status, without the faded one
+                if( !_touched[index] && _status[index] != NodeStatus::IDLE )
+                {
+                    _prev_status[index] = NodeStatus::IDLE;
+                    _touched[index] = 1;
+                    _touched_nodes.push_back( int(index) );
+                }
+            }
+        }
+    }
+
+    for (int index: _touched_nodes)
+    {
+        const Style style = pendingStyle( index );
+        if( style != _emitted[index] )
+        {
+            append( index, style, delta );
+        }
+        _touched[index] = 0;
+    }
+    _touched_nodes.clear();
+    return delta;
+}
@@ -0,0 +1,55 @@
+#ifndef STATUS_DELTA_H
+#define STATUS_DELTA_H
+
+#include <vector>
+#include "bt_editor_base.h"
+
+// Collects the status changes of the nodes between two updates of the scene
+// and returns only the nodes whose style must change, in the format of the
+// changeNodeStyle signals.
+//
+// The style of a node depends on its final status and, if it is IDLE, on the
+// status it had before in the same update (see getStyleFromStatus). When the
+// first child of the root becomes RUNNING, MainWindow resets the style of the
+// whole tree: the nodes that are not IDLE are sent again after it.
+class NodeStatusDelta
+{
+public:
+    // forget what was emitted: the next delta contains every node
+    void reset(size_t nodes_count);
+
+    // changes must be added in chronological order
+    void add(int node_index, NodeStatus status);
+
+    // add the full status of the tree, as a sequence of changes
+    void set(const std::vector<NodeStatus>& status);
+
+    // the changes since the last call. Empty if nothing changed.
+    std::vector<std::pair<int, NodeStatus>> takeDelta();
+
+private:
+    struct Style
+    {
+        NodeStatus status;
+        NodeStatus faded;  // previous status of an IDLE node, if any
+        bool valid;
+
+        bool operator==(const Style& other) const
+        {
+            return valid == other.valid && status == other.status && faded == other.faded;
+        }
+        bool operator!=(const Style& other) const { return !(*this == other); }
+    };
+
+    void append(int node_index, const Style& style, std::vector<std::pair<int, NodeStatus>>& delta);
+
+    // last status added to each node, and the one before it in the current update
+    std::vector<NodeStatus> _status;
+    std::vector<NodeStatus> _prev_status;
+    std::vector<char> _touched;
+    std::vector<int> _touched_nodes;
+
+    std::vector<Style> _emitted;
+};
+
+#endif // STATUS_DELTA_H
@@ -0,0 +1,171 @@
+#include "tab_snapshot.h"
+#include <QDataStream>
+#include <QHash>
+#include <QJsonObject>
+#include "compact_tree.h"
+
+namespace {
+
+class NodesBuilder
+{
+public:
+    NodesBuilder(const QString& tab_name, std::vector<SnapshotNode>& nodes):
+        _tab_name(tab_name),
+        _nodes(nodes)
+    {}
+
+    int add(const QUuid& id, int index,
+            const QString& registration_ID, const QString& instance_name)
+    {
+        SnapshotNode node;
+        node.location.tab_name = _tab_name;
+        node.location.node_id = id;
+        node.location.node_index = index;
+        node.location.occurrence = _occurrences[ qMakePair(registration_ID, instance_name) ]++;
+        node.location.registration_ID = registration_ID;
+        node.location.instance_name = instance_name;
+        _nodes.push_back( std::move(node) );
+        return int( _nodes.size() ) - 1;
+    }
+
+    void connect(int parent, int child)
+    {
+        _nodes[parent].children.push_back( child );
+        _nodes[child].parent = parent;
+    }
+
+    SnapshotNode& operator[](int node) { return _nodes[node]; }
+
+private:
+    const QString& _tab_name;
+    std::vector<SnapshotNode>& _nodes;
+    QHash<QPair<QString,QString>, int> _occurrences;
+};
+
+void AddTreeNodes(const TabSnapshot& snapshot, NodesBuilder& builder)
+{
+    const AbsBehaviorTree& tree = *snapshot.tree;
+    const size_t nodes_count = tree.nodesCount();
+    const bool has_ids = ( snapshot.node_ids.size() == nodes_count );
+
+    // the parents come first. The nodes of a collapsed branch are shown by
+    // the node collapsed
+    std::vector<int> added( nodes_count, -1 );
+    std::vector<char> skipped( nodes_count, 0 );
+    std::vector<QUuid> shown_ids( nodes_count );
+    for (const auto& abs_node: tree.nodes())
+    {
+        const int index = abs_node.index;
+        const bool subtree = ( abs_node.model.type == NodeType::SUBTREE );
+        if( has_ids && !snapshot.node_ids[index].isNull() )
+        {
+            shown_ids[index] = snapshot.node_ids[index];
+        }
+        for (int child: abs_node.children_index)
+        {
+            skipped[child] = skipped[index] || subtree;
+            if( has_ids )
+            {
+                const QUuid& id = snapshot.node_ids[child];
+                shown_ids[child] = id.isNull() ? shown_ids[index] : id;
+            }
+        }
+        if( skipped[index] )
+        {
+            continue;
+        }
+
+        added[index] = builder.add( shown_ids[index], index,
+                                    abs_node.model.registration_ID, abs_node.instance_name );
+        builder[ added[index] ].ports_mapping = abs_node.ports_mapping;
+    }
+
+    for (const auto& abs_node: tree.nodes())
+    {
+        if( added[abs_node.index] < 0 || abs_node.model.type == NodeType::SUBTREE )
+        {
+            continue;
+        }
+        for (int child: abs_node.children_index)
+        {
+            builder.connect( added[abs_node.index], added[child] );
+        }
+    }
+}
+
+void AddSceneStateNodes(const SceneState& state, NodesBuilder& builder)
+{
+    QHash<QUuid, int> added;
+    for (const auto& it: state.nodes)
+    {
+        const QJsonObject model = it.second["model"].toObject();
+        const int node = builder.add( it.first, -1, model["name"].toString(),
+                                      model["alias"].toString() );
+        added.insert( it.first, node );
+
+        for (auto port_it = model.begin(); port_it != model.end(); port_it++)
+        {
+            const QString& key = port_it.key();
+            if( key != "name" && key != "alias" && key != "expanded" && key != "collapsed_branch" )
+            {
+                builder[node].ports_mapping.insert( { key, port_it.value().toString() } );
+            }
+        }
+        if( !model.contains("collapsed_branch") )
+        {
+            continue;
+        }
+
+        QByteArray data = QByteArray::fromBase64( model["collapsed_branch"].toString().toLatin1() );
+        QDataStream stream( data );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        const CompactTree branch = ReadCompactTreeFromStream( stream );
+
+        // the first node of the branch is the one collapsed
+        std::vector<int> branch_nodes( branch.nodesCount(), node );
+        for (size_t index = 1; index < branch.nodesCount(); index++)
+        {
+            branch_nodes[index] = builder.add( it.first, -1, branch.model(index).registration_ID,
+                                               branch.instanceName(index) );
+            for (size_t i = 0; i < branch.portsCount(index); i++)
+            {
+                builder[ branch_nodes[index] ].ports_mapping.insert(
+                            { branch.portName(index, i), branch.portValue(index, i) } );
+            }
+        }
+        for (size_t index = 0; index < branch.nodesCount(); index++)
+        {
+            for (size_t i = 0; i < branch.childrenCount(index); i++)
+            {
+                builder.connect( branch_nodes[index], branch_nodes[ branch.child(index, i) ] );
+            }
+        }
+    }
+
+    for (const auto& it: state.connections)
+    {
+        auto parent = added.find( QUuid( it.second["out_id"].toString() ) );
+        auto child  = added.find( QUuid( it.second["in_id"].toString() ) );
+        if( parent != added.end() && child != added.end() )
+        {
+            builder.connect( *parent, *child );
+        }
+    }
+}
+
+}
+
+std::vector<SnapshotNode> SnapshotNodes(const TabSnapshot &snapshot)
+{
+    std::vector<SnapshotNode> nodes;
+    NodesBuilder builder( snapshot.tab_name, nodes );
+    if( snapshot.tree )
+    {
+        AddTreeNodes( snapshot, builder );
+    }
+    else if( snapshot.scene_state )
+    {
+        AddSceneStateNodes( *snapshot.scene_state, builder );
+    }
+    return nodes;
+}
@@ -0,0 +1,70 @@
+#ifndef TAB_SNAPSHOT_H
+#define TAB_SNAPSHOT_H
+
+#include <memory>
+#include <vector>
+#include <QString>
+#include <QUuid>
+#include "bt_editor_base.h"
+#include "undo_history.h"
+
+// What a tab keeps, read without building its scene: the tree of its scene,
+// the tree of a tab never shown or the saved state of an evicted tab. The
+// trees and the states are never modified: the same pointer means the same
+// content, and they can be read by another thread.
+struct TabSnapshot
+{
+    TabSnapshot(): disconnected_nodes(0) {}
+
+    QString tab_name;
+    // the tree of a built scene or of a tab never shown...
+    std::shared_ptr<const AbsBehaviorTree> tree;
+    // ...or the saved state of an evicted tab
+    std::shared_ptr<const SceneState> scene_state;
+    // for the tree of a built scene: the ids of its nodes by index, null in
+    // the collapsed branches
+    std::vector<QUuid> node_ids;
+    // the nodes of a built scene not connected to its root: they are not
+    // in its tree
+    size_t disconnected_nodes;
+
+    bool sameContent(const TabSnapshot& other) const
+    {
+        return tree == other.tree && scene_state == other.scene_state &&
+               disconnected_nodes == other.disconnected_nodes;
+    }
+};
+
+// A node of a snapshot, to be found again once its tab is shown
+struct NodeLocation
+{
+    NodeLocation(): node_index(-1), occurrence(0) {}
+
+    QString tab_name;
+    // the node in the scene (for a node of a collapsed branch, the node
+    // collapsed) or, for a tab never shown, null...
+    QUuid node_id;
+    // ...and the index of the node in the tree of the tab, and how many
+    // nodes with the same model and name come before it
+    int node_index;
+    int occurrence;
+    QString registration_ID;
+    QString instance_name;
+};
+
+struct SnapshotNode
+{
+    SnapshotNode(): parent(-1) {}
+
+    NodeLocation location;
+    PortsMapping ports_mapping;
+    // indices in the vector of SnapshotNodes()
+    std::vector<int> children;
+    int parent;
+};
+
+// The nodes of the tab, with the collapsed branches. The nodes of an
+// expanded subtree are left out: they belong to the tab of the subtree.
+std::vector<SnapshotNode> SnapshotNodes(const TabSnapshot& snapshot);
+
+#endif // TAB_SNAPSHOT_H
@@ -0,0 +1,175 @@
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QThread>
+
+std::atomic<bool> TraceRecorder::_enabled( false );
+
+namespace {
+
+struct RingBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceRecorder::Event> events;
+    size_t capacity = TraceRecorder::DEFAULT_CAPACITY;
+    // the oldest event, once the buffer is full
+    size_t next = 0;
+    uint64_t gui_thread_id = 0;
+};
+
+RingBuffer& Buffer()
+{
+    static RingBuffer buffer;
+    return buffer;
+}
+
+}
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    RingBuffer& buffer = Buffer();
+    {
+        std::lock_guard<std::mutex> lock( buffer.mutex );
+        if( enabled )
+        {
+            buffer.gui_thread_id = currentThreadId();
+        }
+    }
+    _enabled.store( enabled, std::memory_order_relaxed );
+}
+
+void TraceRecorder::setCapacity(size_t capacity)
+{
+    RingBuffer& buffer = Buffer();
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    buffer.capacity = std::max( capacity, size_t(1) );
+    buffer.events.clear();
+    buffer.next = 0;
+}
+
+void TraceRecorder::clear()
+{
+    RingBuffer& buffer = Buffer();
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    buffer.events.clear();
+    buffer.next = 0;
+}
+
+size_t TraceRecorder::eventsCount()
+{
+    RingBuffer& buffer = Buffer();
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    return buffer.events.size();
+}
+
+int64_t TraceRecorder::nowUsec()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+uint64_t TraceRecorder::currentThreadId()
+{
+    return uint64_t( reinterpret_cast<quintptr>( QThread::currentThreadId() ) );
+}
+
+void TraceRecorder::record(Event &&event)
+{
+    RingBuffer& buffer = Buffer();
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    if( buffer.events.size() < buffer.capacity )
+    {
+        buffer.events.push_back( std::move(event) );
+    }
+    else{
+        buffer.events[ buffer.next ] = std::move(event);
+        buffer.next = ( buffer.next + 1 ) % buffer.capacity;
+    }
+}
+
+QByteArray TraceRecorder::toChromeTraceJson()
+{
+    std::vector<Event> events;
+    uint64_t gui_thread_id = 0;
+    {
+        RingBuffer& buffer = Buffer();
+        std::lock_guard<std::mutex> lock( buffer.mutex );
+        events.reserve( buffer.events.size() );
+        for (size_t i = 0; i < buffer.events.size(); i++)
+        {
+            events.push_back( buffer.events[ ( buffer.next + i ) % buffer.events.size() ] );
+        }
+        gui_thread_id = buffer.gui_thread_id;
+    }
+
+    const double pid = double( QCoreApplication::applicationPid() );
+    // the timestamps start at the first event. They are recorded when they
+    // end: an enclosing scope is after the nested ones
+    int64_t origin = events.empty() ? 0 : events.front().start_usec;
+    for (const auto& event: events)
+    {
+        origin = std::min( origin, event.start_usec );
+    }
+
+    QJsonArray trace_events;
+    QJsonObject process_name;
+    process_name["name"] = "process_name";
+    process_name["ph"] = "M";
+    process_name["pid"] = pid;
+    process_name["args"] = QJsonObject{ { "name", "Groot" } };
+    trace_events.append( process_name );
+    if( gui_thread_id != 0 )
+    {
+        QJsonObject thread_name;
+        thread_name["name"] = "thread_name";
+        thread_name["ph"] = "M";
+        thread_name["pid"] = pid;
+        thread_name["tid"] = double( gui_thread_id );
+        thread_name["args"] = QJsonObject{ { "name", "GUI" } };
+        trace_events.append( thread_name );
+    }
+
+    for (const auto& event: events)
+    {
+        QJsonObject object;
+        object["name"] = QLatin1String( event.name );
+        object["cat"] = QLatin1String( event.category );
+        object["ph"] = "X";
+        object["ts"] = double( event.start_usec - origin );
+        object["dur"] = double( event.duration_usec );
+        object["pid"] = pid;
+        object["tid"] = double( event.thread_id );
+        if( !event.args.isEmpty() )
+        {
+            object["args"] = event.args;
+        }
+        trace_events.append( object );
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = trace_events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument( root ).toJson( QJsonDocument::Compact );
+}
+
+QString TraceRecorder::writeChromeTrace(const QString &filename)
+{
+    QSaveFile file( filename );
+    if( !file.open( QIODevice::WriteOnly ) )
+    {
+        return file.errorString();
+    }
+    const QByteArray json = toChromeTraceJson();
+    if( file.write( json ) != json.size() || !file.commit() )
+    {
+        return file.errorString();
+    }
+    return QString();
+}
@@ -0,0 +1,113 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+// Scoped events of the internal operations of Groot (XML parsing, scene
+// building, layout, undo, replay, monitor, painting), kept in a ring buffer
+// and dumped in the Chrome trace format: open it in chrome://tracing or in
+// https://ui.perfetto.dev.
+//
+// Any thread can record. When disabled, a TraceScope costs the load of an
+// atomic boolean.
+class TraceRecorder
+{
+public:
+    struct Event
+    {
+        const char* category = nullptr;
+        const char* name = nullptr;
+        // std::chrono::steady_clock
+        int64_t start_usec = 0;
+        int64_t duration_usec = 0;
+        uint64_t thread_id = 0;
+        QJsonObject args;
+    };
+
+    static const size_t DEFAULT_CAPACITY = 200000;
+
+    // The recorded events are kept. The thread that enables the recording
+    // is named "GUI" in the trace
+    static void setEnabled(bool enabled);
+
+    static bool enabled() { return _enabled.load( std::memory_order_relaxed ); }
+
+    // the oldest events are dropped beyond this number
+    static void setCapacity(size_t capacity);
+
+    static void clear();
+
+    static size_t eventsCount();
+
+    static int64_t nowUsec();
+
+    static uint64_t currentThreadId();
+
+    static void record(Event&& event);
+
+    static QByteArray toChromeTraceJson();
+
+    // Returns the error, or an empty string
+    static QString writeChromeTrace(const QString& filename);
+
+private:
+    static std::atomic<bool> _enabled;
+};
+
+// Records the time between its construction and its destruction
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name):
+        _active( TraceRecorder::enabled() )
+    {
+        if( _active )
+        {
+            _event.category = category;
+            _event.name = name;
+            _event.start_usec = TraceRecorder::nowUsec();
+        }
+    }
+
+    ~TraceScope()
+    {
+        if( _active )
+        {
+            _event.duration_usec = TraceRecorder::nowUsec() - _event.start_usec;
+            _event.thread_id = TraceRecorder::currentThreadId();
+            TraceRecorder::record( std::move(_event) );
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    // nothing is recorded
+    void discard() { _active = false; }
+
+    void setArgument(const char* key, const QString& value)
+    {
+        if( _active )
+        {
+            _event.args[ QLatin1String(key) ] = value;
+        }
+    }
+
+    void setArgument(const char* key, double value)
+    {
+        if( _active )
+        {
+            _event.args[ QLatin1String(key) ] = value;
+        }
+    }
+
+private:
+    bool _active;
+    TraceRecorder::Event _event;
+};
+
+#endif // TRACE_RECORDER_H
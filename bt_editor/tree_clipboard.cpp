@@ -0,0 +1,170 @@
+#include "tree_clipboard.h"
+#include "compact_tree.h"
+#include <algorithm>
+#include <QApplication>
+#include <QClipboard>
+#include <QDataStream>
+#include <QMimeData>
+
+const char* CLIPBOARD_NODES_MIME = "application/x-groot-nodes";
+
+namespace
+{
+const quint32 CLIPBOARD_MAGIC   = 0x47434c50; // GCLP
+const quint32 CLIPBOARD_VERSION = 1;
+
+std::vector<int> ParentIndices(const AbsBehaviorTree& forest)
+{
+    std::vector<int> parents( forest.nodesCount(), -1 );
+    for (const auto& node: forest.nodes())
+    {
+        for (int child: node.children_index)
+        {
+            parents[size_t(child)] = node.index;
+        }
+    }
+    return parents;
+}
+}
+
+std::vector<int> ClipboardNodes::roots() const
+{
+    const std::vector<int> parents = ParentIndices( forest );
+    std::vector<int> roots;
+    for (size_t index = 0; index < parents.size(); index++)
+    {
+        if( parents[index] < 0 )
+        {
+            roots.push_back( int(index) );
+        }
+    }
+    return roots;
+}
+
+bool ClipboardNodes::isCollapsed(int index) const
+{
+    return std::binary_search( collapsed.begin(), collapsed.end(), index );
+}
+
+AbsBehaviorTree ClipboardNodes::branch(int index) const
+{
+    AbsBehaviorTree tree;
+    auto& nodes = tree.nodes();
+    // depth first: the parents before their children, as in the scene
+    std::vector<std::pair<int,int>> stack = { {index, -1} };
+    while( !stack.empty() )
+    {
+        const int source = stack.back().first;
+        const int parent = stack.back().second;
+        stack.pop_back();
+
+        AbstractTreeNode node = *forest.node( size_t(source) );
+        node.index = int(nodes.size());
+        node.children_index.clear();
+        node.graphic_node = nullptr;
+        if( parent >= 0 )
+        {
+            nodes[size_t(parent)].children_index.push_back( node.index );
+        }
+        const auto& children = forest.node( size_t(source) )->children_index;
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+        {
+            stack.push_back( { *it, node.index } );
+        }
+        nodes.push_back( std::move(node) );
+    }
+    return tree;
+}
+
+QByteArray EncodeClipboardNodes(const ClipboardNodes &nodes)
+{
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream << CLIPBOARD_MAGIC << CLIPBOARD_VERSION;
+    WriteCompactTreeToStream( stream, CompactTree( nodes.forest ) );
+    stream << quint32( nodes.collapsed.size() );
+    for (int index: nodes.collapsed)
+    {
+        stream << qint32(index);
+    }
+    return data;
+}
+
+bool DecodeClipboardNodes(const QByteArray &data, ClipboardNodes *nodes)
+{
+    QDataStream stream( data );
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if( magic != CLIPBOARD_MAGIC || version != CLIPBOARD_VERSION )
+    {
+        return false;
+    }
+    const CompactTree tree = ReadCompactTreeFromStream( stream );
+    if( tree.empty() )
+    {
+        return false;
+    }
+    ClipboardNodes result;
+    result.forest = tree.toAbsTree();
+    const size_t nodes_count = result.forest.nodesCount();
+
+    quint32 collapsed_count = 0;
+    stream >> collapsed_count;
+    for (quint32 i = 0; i < collapsed_count && stream.status() == QDataStream::Ok; i++)
+    {
+        qint32 index;
+        stream >> index;
+        if( index < 0 || size_t(index) >= nodes_count ||
+            ( !result.collapsed.empty() && index <= result.collapsed.back() ) )
+        {
+            return false;
+        }
+        result.collapsed.push_back( index );
+    }
+    if( stream.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+
+    // a forest: a single parent for each node, all of them under a root
+    std::vector<int> parents_count( nodes_count, 0 );
+    for (const auto& node: result.forest.nodes())
+    {
+        for (int child: node.children_index)
+        {
+            if( ++parents_count[size_t(child)] > 1 )
+            {
+                return false;
+            }
+        }
+    }
+    size_t reached = 0;
+    for (int root: result.roots())
+    {
+        reached += result.branch( root ).nodesCount();
+    }
+    if( reached != nodes_count )
+    {
+        return false;
+    }
+    *nodes = std::move(result);
+    return true;
+}
+
+void WriteClipboardNodes(const ClipboardNodes &nodes)
+{
+    auto mime_data = new QMimeData;
+    mime_data->setData( CLIPBOARD_NODES_MIME, EncodeClipboardNodes( nodes ) );
+    QApplication::clipboard()->setMimeData( mime_data );
+}
+
+ClipboardNodes ReadClipboardNodes()
+{
+    ClipboardNodes nodes;
+    const QMimeData* mime_data = QApplication::clipboard()->mimeData();
+    if( mime_data && mime_data->hasFormat( CLIPBOARD_NODES_MIME ) )
+    {
+        DecodeClipboardNodes( mime_data->data( CLIPBOARD_NODES_MIME ), &nodes );
+    }
+    return nodes;
+}
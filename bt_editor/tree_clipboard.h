@@ -0,0 +1,43 @@
+#ifndef TREE_CLIPBOARD_H
+#define TREE_CLIPBOARD_H
+
+#include <vector>
+#include <QByteArray>
+#include "bt_editor_base.h"
+
+// Nodes copied from a scene, to be pasted in any tab of any Groot window.
+//
+// The nodes are a forest: the roots are the nodes that are not the child of
+// another one. The positions are relative to the top left corner of the
+// copied nodes. The descendants of a collapsed node are kept as they were,
+// they form its collapsed branch again once pasted.
+struct ClipboardNodes
+{
+    AbsBehaviorTree forest;
+    std::vector<int> collapsed; // indices in forest, in increasing order
+
+    bool empty() const { return forest.nodesCount() == 0; }
+
+    std::vector<int> roots() const;
+
+    bool isCollapsed(int index) const;
+
+    // the node and its descendants, the node being the root (index 0)
+    AbsBehaviorTree branch(int index) const;
+};
+
+// MIME type of the data in the system clipboard
+extern const char* CLIPBOARD_NODES_MIME;
+
+// A CompactTree (the models written once) and the collapsed nodes
+QByteArray EncodeClipboardNodes(const ClipboardNodes& nodes);
+
+// false if the data is not (or no longer) in the format
+bool DecodeClipboardNodes(const QByteArray& data, ClipboardNodes* nodes);
+
+void WriteClipboardNodes(const ClipboardNodes& nodes);
+
+// empty if the system clipboard contains no nodes
+ClipboardNodes ReadClipboardNodes();
+
+#endif // TREE_CLIPBOARD_H
@@ -0,0 +1,543 @@
+#include "tree_diff.h"
+#include <algorithm>
+#include <map>
+#include <QHash>
+#include <QStringList>
+
+namespace {
+
+// the same as the ones of AbsBehaviorTree::hash()
+quint64 HashCombine(quint64 seed, quint64 value)
+{
+    return seed ^ ( value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2) );
+}
+
+quint64 HashString(const QString& str)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    const ushort* data = str.utf16();
+    for (int i = 0; i < str.size(); i++)
+    {
+        hash = ( hash ^ data[i] ) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+QString NodeName(const NodeLocation& node)
+{
+    return node.instance_name.isEmpty() ? node.registration_ID : node.instance_name;
+}
+
+// One version of a tree. The index -1 is the parent of the roots: the Root
+// node of a scene is left out, a tree read from a file has none
+struct Side
+{
+    explicit Side(const std::vector<SnapshotNode>& tree_nodes);
+
+    const std::vector<int>& children(int node) const
+    {
+        return node < 0 ? roots : nodes[node].children;
+    }
+
+    const std::vector<SnapshotNode>& nodes;
+    std::vector<int> roots;
+    std::vector<int> parent;
+    // the parents first: the nodes not reached from a root are left out
+    std::vector<int> preorder;
+    // its position among the children of its parent
+    std::vector<int> position;
+    // of the model, of the model and the name, of the whole subtree
+    std::vector<quint64> model;
+    std::vector<quint64> label;
+    std::vector<quint64> content;
+    std::vector<int> subtree_size;
+    // the node of the other version, or -1
+    std::vector<int> match;
+};
+
+Side::Side(const std::vector<SnapshotNode> &tree_nodes):
+    nodes(tree_nodes),
+    parent( tree_nodes.size(), -1 ),
+    position( tree_nodes.size(), 0 ),
+    model( tree_nodes.size(), 0 ),
+    label( tree_nodes.size(), 0 ),
+    content( tree_nodes.size(), 0 ),
+    subtree_size( tree_nodes.size(), 1 ),
+    match( tree_nodes.size(), -1 )
+{
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        const SnapshotNode& node = nodes[index];
+        if( node.parent >= 0 )
+        {
+            const bool root_parent = nodes[node.parent].parent < 0 &&
+                                     nodes[node.parent].location.registration_ID == "Root";
+            parent[index] = root_parent ? -1 : node.parent;
+        }
+        else if( node.location.registration_ID == "Root" )
+        {
+            roots.insert( roots.end(), node.children.begin(), node.children.end() );
+        }
+        else{
+            roots.push_back( int(index) );
+        }
+    }
+
+    preorder.reserve( nodes.size() );
+    std::vector<int> stack( roots.rbegin(), roots.rend() );
+    for (size_t i = 0; i < roots.size(); i++)
+    {
+        position[ roots[i] ] = int(i);
+    }
+    while( !stack.empty() )
+    {
+        const int node = stack.back();
+        stack.pop_back();
+        preorder.push_back( node );
+        const auto& node_children = nodes[node].children;
+        for (size_t i = 0; i < node_children.size(); i++)
+        {
+            position[ node_children[i] ] = int(i);
+        }
+        stack.insert( stack.end(), node_children.rbegin(), node_children.rend() );
+    }
+
+    // the children before their parent
+    for (auto it = preorder.rbegin(); it != preorder.rend(); it++)
+    {
+        const SnapshotNode& node = nodes[*it];
+        model[*it] = HashString( node.location.registration_ID );
+        label[*it] = HashCombine( model[*it], HashString( node.location.instance_name ) );
+
+        quint64 hash = label[*it];
+        for (const auto& port_it: node.ports_mapping)
+        {
+            hash = HashCombine( hash, HashString( port_it.first ) );
+            hash = HashCombine( hash, HashString( port_it.second ) );
+        }
+        hash = HashCombine( hash, node.children.size() );
+        for (int child: node.children)
+        {
+            hash = HashCombine( hash, content[child] );
+            subtree_size[*it] += subtree_size[child];
+        }
+        content[*it] = hash;
+    }
+}
+
+// flags the elements of the longest increasing subsequence
+std::vector<char> LongestIncreasing(const std::vector<int>& sequence)
+{
+    // the last element of the best subsequence of each length
+    std::vector<int> tails;
+    std::vector<int> previous( sequence.size(), -1 );
+    for (size_t i = 0; i < sequence.size(); i++)
+    {
+        auto it = std::lower_bound( tails.begin(), tails.end(), sequence[i],
+                                    [&sequence](int tail, int value)
+        {
+            return sequence[tail] < value;
+        });
+        if( it != tails.begin() )
+        {
+            previous[i] = *(it - 1);
+        }
+        if( it == tails.end() )
+        {
+            tails.push_back( int(i) );
+        }
+        else{
+            *it = int(i);
+        }
+    }
+
+    std::vector<char> kept( sequence.size(), 0 );
+    for (int i = tails.empty() ? -1 : tails.back(); i >= 0; i = previous[i])
+    {
+        kept[i] = 1;
+    }
+    return kept;
+}
+
+class Matcher
+{
+public:
+    Matcher(Side& before, Side& after):
+        _before(before),
+        _after(after)
+    {}
+
+    void run();
+
+private:
+    void matchPair(int after_node, int before_node)
+    {
+        _after.match[after_node] = before_node;
+        _before.match[before_node] = after_node;
+    }
+
+    // the two subtrees have the same content, hence the same shape
+    void matchSubtree(int after_node, int before_node);
+
+    // the children left of two nodes matched, in their order
+    void alignChildren(int after_parent, int before_parent);
+
+    void alignBy(const std::vector<int>& after_children,
+                 const std::vector<int>& before_children,
+                 const std::vector<quint64>& after_keys,
+                 const std::vector<quint64>& before_keys,
+                 bool whole_subtree);
+
+    Side& _before;
+    Side& _after;
+};
+
+void Matcher::matchSubtree(int after_node, int before_node)
+{
+    std::vector<std::pair<int,int>> stack = { { after_node, before_node } };
+    while( !stack.empty() )
+    {
+        const auto pair = stack.back();
+        stack.pop_back();
+        matchPair( pair.first, pair.second );
+        const auto& after_children = _after.nodes[pair.first].children;
+        const auto& before_children = _before.nodes[pair.second].children;
+        for (size_t i = 0; i < after_children.size() && i < before_children.size(); i++)
+        {
+            stack.push_back( { after_children[i], before_children[i] } );
+        }
+    }
+}
+
+void Matcher::alignBy(const std::vector<int> &after_children,
+                      const std::vector<int> &before_children,
+                      const std::vector<quint64> &after_keys,
+                      const std::vector<quint64> &before_keys,
+                      bool whole_subtree)
+{
+    // the first candidate of each key is the last one
+    QHash<quint64, std::vector<int>> candidates;
+    for (auto it = before_children.rbegin(); it != before_children.rend(); it++)
+    {
+        if( _before.match[*it] < 0 )
+        {
+            candidates[ before_keys[*it] ].push_back( *it );
+        }
+    }
+    if( candidates.isEmpty() )
+    {
+        return;
+    }
+    for (int after_node: after_children)
+    {
+        if( _after.match[after_node] >= 0 )
+        {
+            continue;
+        }
+        auto it = candidates.find( after_keys[after_node] );
+        if( it == candidates.end() || it->empty() )
+        {
+            continue;
+        }
+        const int before_node = it->back();
+        it->pop_back();
+        if( whole_subtree )
+        {
+            matchSubtree( after_node, before_node );
+        }
+        else{
+            matchPair( after_node, before_node );
+        }
+    }
+}
+
+void Matcher::alignChildren(int after_parent, int before_parent)
+{
+    const auto& after_children = _after.children( after_parent );
+    const auto& before_children = _before.children( before_parent );
+    if( after_children.empty() || before_children.empty() )
+    {
+        return;
+    }
+    alignBy( after_children, before_children, _after.content, _before.content, true );
+    alignBy( after_children, before_children, _after.label, _before.label, false );
+    alignBy( after_children, before_children, _after.model, _before.model, false );
+}
+
+void Matcher::run()
+{
+    // the subtrees of the version before by content, the first one last
+    QHash<quint64, std::vector<int>> subtrees;
+    for (auto it = _before.preorder.rbegin(); it != _before.preorder.rend(); it++)
+    {
+        subtrees[ _before.content[*it] ].push_back( *it );
+    }
+    QHash<quint64, int> after_subtrees;
+    for (int node: _after.preorder)
+    {
+        after_subtrees[ _after.content[node] ]++;
+    }
+
+    alignChildren( -1, -1 );
+    for (int node: _after.preorder)
+    {
+        // a subtree moved elsewhere. A single node only if it is unique
+        // in both versions: otherwise it is rather one added and one removed
+        if( _after.match[node] < 0 )
+        {
+            auto it = subtrees.find( _after.content[node] );
+            const bool unique = it != subtrees.end() && it->size() == 1 &&
+                                after_subtrees.value( _after.content[node] ) == 1;
+            while( it != subtrees.end() && !it->empty() &&
+                   _before.match[ it->back() ] >= 0 )
+            {
+                it->pop_back();
+            }
+            if( it != subtrees.end() && !it->empty() &&
+                ( _after.subtree_size[node] > 1 || unique ) )
+            {
+                matchSubtree( node, it->back() );
+                it->pop_back();
+            }
+        }
+        if( _after.match[node] >= 0 )
+        {
+            alignChildren( node, _after.match[node] );
+        }
+    }
+
+    // the nodes left with a model and a name unique in both versions
+    QHash<quint64, int> after_labels;
+    QHash<quint64, int> before_labels;
+    QHash<quint64, int> before_nodes;
+    for (int node: _after.preorder)
+    {
+        if( _after.match[node] < 0 )
+        {
+            after_labels[ _after.label[node] ]++;
+        }
+    }
+    for (int node: _before.preorder)
+    {
+        if( _before.match[node] < 0 )
+        {
+            before_labels[ _before.label[node] ]++;
+            before_nodes[ _before.label[node] ] = node;
+        }
+    }
+    bool matched = false;
+    for (int node: _after.preorder)
+    {
+        const quint64 label = _after.label[node];
+        if( _after.match[node] < 0 && after_labels.value( label ) == 1 &&
+            before_labels.value( label ) == 1 )
+        {
+            matchPair( node, before_nodes.value( label ) );
+            matched = true;
+        }
+    }
+    if( matched )
+    {
+        for (int node: _after.preorder)
+        {
+            if( _after.match[node] >= 0 )
+            {
+                alignChildren( node, _after.match[node] );
+            }
+        }
+    }
+}
+
+QString PortsDetails(const PortsMapping& before, const PortsMapping& after)
+{
+    QStringList details;
+    auto before_it = before.begin();
+    auto after_it = after.begin();
+    while( before_it != before.end() || after_it != after.end() )
+    {
+        if( after_it == after.end() ||
+            ( before_it != before.end() && before_it->first < after_it->first ) )
+        {
+            details.push_back( QString("%1: \"%2\" removed").arg( before_it->first, before_it->second ) );
+            before_it++;
+        }
+        else if( before_it == before.end() || after_it->first < before_it->first )
+        {
+            details.push_back( QString("%1: \"%2\" added").arg( after_it->first, after_it->second ) );
+            after_it++;
+        }
+        else{
+            if( before_it->second != after_it->second )
+            {
+                details.push_back( QString("%1: \"%2\" -> \"%3\"")
+                                   .arg( after_it->first, before_it->second, after_it->second ) );
+            }
+            before_it++;
+            after_it++;
+        }
+    }
+    return details.join(", ");
+}
+
+NodeLocation TabLocation(const QString& tab_name)
+{
+    NodeLocation location;
+    location.tab_name = tab_name;
+    return location;
+}
+
+}
+
+std::vector<TreeDiff::Change> TreeDiff::compare(const std::vector<SnapshotNode> &before,
+                                                const std::vector<SnapshotNode> &after)
+{
+    Side before_side( before );
+    Side after_side( after );
+    Matcher( before_side, after_side ).run();
+
+    // by parent of the version after, the position in the version before
+    // of the children kept under the same parent
+    auto sameParent = [&](int node) -> bool
+    {
+        const int parent = after_side.parent[node];
+        const int before_parent = before_side.parent[ after_side.match[node] ];
+        return parent < 0 ? before_parent < 0 :
+                            ( before_parent >= 0 && after_side.match[parent] == before_parent );
+    };
+    std::vector<char> reordered( after.size(), 0 );
+    auto checkOrder = [&](int parent)
+    {
+        std::vector<int> kept_children;
+        std::vector<int> positions;
+        for (int child: after_side.children( parent ))
+        {
+            if( after_side.match[child] >= 0 && sameParent( child ) )
+            {
+                kept_children.push_back( child );
+                positions.push_back( before_side.position[ after_side.match[child] ] );
+            }
+        }
+        const std::vector<char> in_order = LongestIncreasing( positions );
+        for (size_t i = 0; i < kept_children.size(); i++)
+        {
+            reordered[ kept_children[i] ] = !in_order[i];
+        }
+    };
+    checkOrder( -1 );
+    for (int node: after_side.preorder)
+    {
+        checkOrder( node );
+    }
+
+    std::vector<Change> changes;
+    auto addChange = [&changes](Change::Type type, const NodeLocation& node,
+                                const NodeLocation& shown, const QString& details)
+    {
+        changes.push_back( { type, node, shown, details } );
+    };
+
+    for (int node: after_side.preorder)
+    {
+        const NodeLocation& location = after[node].location;
+        const int before_node = after_side.match[node];
+        if( before_node < 0 )
+        {
+            addChange( Change::ADDED, location, location, QString() );
+            continue;
+        }
+        const SnapshotNode& old_node = before[before_node];
+
+        if( !sameParent( node ) )
+        {
+            const int parent = after_side.parent[node];
+            const int old_parent = before_side.parent[before_node];
+            addChange( Change::MOVED, location, location,
+                       QString("from %1 to %2")
+                       .arg( old_parent < 0 ? QString("the top") : NodeName( before[old_parent].location ),
+                             parent < 0 ? QString("the top") : NodeName( after[parent].location ) ) );
+        }
+        else if( reordered[node] )
+        {
+            addChange( Change::MOVED, location, location,
+                       QString("from position %1 to %2")
+                       .arg( before_side.position[before_node] + 1 )
+                       .arg( after_side.position[node] + 1 ) );
+        }
+
+        QStringList details;
+        if( old_node.location.instance_name != location.instance_name )
+        {
+            details.push_back( QString("name: \"%1\" -> \"%2\"")
+                               .arg( old_node.location.instance_name, location.instance_name ) );
+        }
+        if( old_node.location.registration_ID != location.registration_ID )
+        {
+            details.push_back( QString("model: %1 -> %2")
+                               .arg( old_node.location.registration_ID, location.registration_ID ) );
+        }
+        if( old_node.ports_mapping != after[node].ports_mapping )
+        {
+            details.push_back( PortsDetails( old_node.ports_mapping, after[node].ports_mapping ) );
+        }
+        if( !details.isEmpty() )
+        {
+            addChange( Change::MODIFIED, location, location, details.join(", ") );
+        }
+    }
+
+    for (int node: before_side.preorder)
+    {
+        if( before_side.match[node] >= 0 )
+        {
+            continue;
+        }
+        // shown where it was: its closest parent kept
+        NodeLocation shown = TabLocation( before[node].location.tab_name );
+        for (int parent = before_side.parent[node]; parent >= 0; parent = before_side.parent[parent])
+        {
+            if( before_side.match[parent] >= 0 )
+            {
+                shown = after[ before_side.match[parent] ].location;
+                break;
+            }
+        }
+        addChange( Change::REMOVED, before[node].location, shown, QString() );
+    }
+    return changes;
+}
+
+std::vector<TreeDiff::Change> TreeDiff::compareProjects(const std::vector<TabSnapshot> &before,
+                                                        const std::vector<TabSnapshot> &after)
+{
+    std::map<QString, const TabSnapshot*> before_tabs;
+    for (const auto& tab: before)
+    {
+        before_tabs.insert( { tab.tab_name, &tab } );
+    }
+
+    std::vector<Change> changes;
+    for (const auto& tab: after)
+    {
+        auto it = before_tabs.find( tab.tab_name );
+        if( it == before_tabs.end() )
+        {
+            const NodeLocation location = TabLocation( tab.tab_name );
+            changes.push_back( { Change::ADDED, location, location, "the tree was added" } );
+            continue;
+        }
+        const TabSnapshot& old_tab = *it->second;
+        before_tabs.erase( it );
+        if( old_tab.sameContent( tab ) )
+        {
+            continue;
+        }
+        auto tab_changes = compare( SnapshotNodes( old_tab ), SnapshotNodes( tab ) );
+        changes.insert( changes.end(), tab_changes.begin(), tab_changes.end() );
+    }
+    for (const auto& it: before_tabs)
+    {
+        const NodeLocation location = TabLocation( it.first );
+        changes.push_back( { Change::REMOVED, location, location, "the tree was removed" } );
+    }
+    return changes;
+}
@@ -0,0 +1,46 @@
+#ifndef TREE_DIFF_H
+#define TREE_DIFF_H
+
+#include <vector>
+#include <QString>
+#include "tab_snapshot.h"
+
+// The differences between two versions of the trees of a project.
+//
+// The nodes are matched by structure: first the subtrees with the same
+// content (model, name, ports and children, whatever their position),
+// preferring those under the same parent; then, in order, the remaining
+// children of two nodes matched, with the same model and name or only the
+// same model; last, the nodes whose model and name are unique among those
+// left. A node matched is moved if its parent changed, or if it left the
+// longest sequence of its siblings kept in order; it is modified if its
+// name or its ports changed. The nodes left are added or removed.
+//
+// Every step uses hash tables: the time is about linear in the number of
+// nodes. The diff only reads the snapshots: it can run in another thread.
+class TreeDiff
+{
+public:
+    struct Change
+    {
+        enum Type { ADDED, REMOVED, MOVED, MODIFIED };
+
+        Type type;
+        // the node, in the version after but, if removed, in the version
+        // before. For a tab added or removed only the tab
+        NodeLocation node;
+        // where to show the change in the version after: the node or, if
+        // removed, its closest parent kept
+        NodeLocation shown;
+        QString details;
+    };
+
+    static std::vector<Change> compare(const std::vector<SnapshotNode>& before,
+                                       const std::vector<SnapshotNode>& after);
+
+    // the tabs are paired by name
+    static std::vector<Change> compareProjects(const std::vector<TabSnapshot>& before,
+                                               const std::vector<TabSnapshot>& after);
+};
+
+#endif // TREE_DIFF_H
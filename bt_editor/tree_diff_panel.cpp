@@ -0,0 +1,143 @@
+#include "tree_diff_panel.h"
+
+#include <QColor>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
+
+TreeDiffPanel::TreeDiffPanel(QWidget *parent) :
+    QFrame(parent),
+    _tabs_pending(false)
+{
+    _changes_tree = new QTreeWidget( this );
+    _changes_tree->setColumnCount( 4 );
+    _changes_tree->setHeaderLabels( { tr("Tree"), tr("Node"), tr("Change"), tr("Details") } );
+    _changes_tree->setRootIsDecorated( false );
+    _changes_tree->setUniformRowHeights( true );
+    _changes_tree->header()->setSectionResizeMode( 0, QHeaderView::ResizeToContents );
+    _changes_tree->header()->setSectionResizeMode( 1, QHeaderView::Interactive );
+    _changes_tree->header()->setSectionResizeMode( 2, QHeaderView::ResizeToContents );
+    _changes_tree->header()->setStretchLastSection( true );
+
+    _label_status = new QLabel( tr("Nothing to compare"), this );
+    _button_refresh = new QPushButton( tr("Refresh"), this );
+    _button_refresh->setEnabled( false );
+
+    auto status_layout = new QHBoxLayout();
+    status_layout->addWidget( _label_status, 1 );
+    status_layout->addWidget( _button_refresh );
+
+    auto layout = new QVBoxLayout( this );
+    layout->setContentsMargins( 2, 2, 2, 2 );
+    layout->addWidget( _changes_tree, 1 );
+    layout->addLayout( status_layout );
+
+    connect( _changes_tree, &QTreeWidget::itemActivated,
+             this, &TreeDiffPanel::onItemActivated );
+
+    connect( _button_refresh, &QPushButton::clicked,
+             this, &TreeDiffPanel::tabsRequested );
+
+    connect( &_diff_watcher, &QFutureWatcher<std::vector<TreeDiff::Change>>::finished,
+             this, &TreeDiffPanel::onCompared );
+}
+
+TreeDiffPanel::~TreeDiffPanel()
+{
+    _diff_watcher.waitForFinished();
+}
+
+void TreeDiffPanel::setBefore(std::vector<TabSnapshot> tabs, const QString &name)
+{
+    _before = std::move(tabs);
+    _before_name = name;
+    _button_refresh->setEnabled( true );
+}
+
+void TreeDiffPanel::compare(std::vector<TabSnapshot> tabs)
+{
+    _pending_tabs = std::move(tabs);
+    _tabs_pending = true;
+    _label_status->setText( tr("Comparing with %1...").arg( _before_name ) );
+    if( !_diff_watcher.isRunning() )
+    {
+        startDiff();
+    }
+}
+
+void TreeDiffPanel::startDiff()
+{
+    _tabs_pending = false;
+    std::vector<TabSnapshot> tabs;
+    std::swap( tabs, _pending_tabs );
+
+    const std::vector<TabSnapshot> before = _before;
+    _diff_watcher.setFuture( QtConcurrent::run( [before, tabs]()
+    {
+        return TreeDiff::compareProjects( before, tabs );
+    }));
+}
+
+void TreeDiffPanel::onCompared()
+{
+    if( _tabs_pending )
+    {
+        startDiff();
+        return;
+    }
+    _changes = _diff_watcher.result();
+
+    _changes_tree->setUpdatesEnabled( false );
+    _changes_tree->clear();
+
+    int counts[4] = { 0, 0, 0, 0 };
+    QList<QTreeWidgetItem*> items;
+    items.reserve( int(_changes.size()) );
+    for (size_t row = 0; row < _changes.size(); row++)
+    {
+        const auto& change = _changes[row];
+        QString node_text = change.node.instance_name;
+        if( change.node.instance_name != change.node.registration_ID )
+        {
+            node_text += QString(" (%1)").arg( change.node.registration_ID );
+        }
+        QString type_text;
+        QColor color;
+        switch( change.type )
+        {
+        case TreeDiff::Change::ADDED:    type_text = tr("Added");    color = Qt::darkGreen;  break;
+        case TreeDiff::Change::REMOVED:  type_text = tr("Removed");  color = Qt::red;        break;
+        case TreeDiff::Change::MOVED:    type_text = tr("Moved");    color = Qt::blue;       break;
+        case TreeDiff::Change::MODIFIED: type_text = tr("Modified"); color = QColor(200, 120, 0); break;
+        }
+        counts[change.type]++;
+
+        auto item = new QTreeWidgetItem( { change.node.tab_name,
+                                           change.node.registration_ID.isEmpty() ? QString() : node_text,
+                                           type_text, change.details } );
+        item->setForeground( 2, color );
+        item->setData( 0, Qt::UserRole, int(row) );
+        items.push_back( item );
+    }
+    _changes_tree->addTopLevelItems( items );
+    _changes_tree->setUpdatesEnabled( true );
+
+    _label_status->setText( tr("Compared with %1: %2 added, %3 removed, %4 moved, %5 modified")
+                            .arg( _before_name )
+                            .arg( counts[TreeDiff::Change::ADDED] )
+                            .arg( counts[TreeDiff::Change::REMOVED] )
+                            .arg( counts[TreeDiff::Change::MOVED] )
+                            .arg( counts[TreeDiff::Change::MODIFIED] ) );
+}
+
+void TreeDiffPanel::onItemActivated(QTreeWidgetItem *item, int)
+{
+    const int row = item->data( 0, Qt::UserRole ).toInt();
+    if( row >= 0 && row < int(_changes.size()) )
+    {
+        // the changes may be shown again while the node is
+        const NodeLocation node = _changes[row].shown;
+        emit changeActivated( node );
+    }
+}
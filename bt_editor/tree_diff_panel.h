@@ -0,0 +1,61 @@
+#ifndef TREE_DIFF_PANEL_H
+#define TREE_DIFF_PANEL_H
+
+#include <QFrame>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include "tree_diff.h"
+
+// The differences between a version of the project, usually read from a
+// file, and the trees of the tabs, see TreeDiff.
+//
+// The diff runs in the thread pool; "Refresh" emits tabsRequested, to
+// compare the same version with the tabs as they are now. Activating a
+// change emits changeActivated, with the node to show.
+class TreeDiffPanel : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit TreeDiffPanel(QWidget *parent = nullptr);
+
+    ~TreeDiffPanel() override;
+
+    // the version the tabs are compared with
+    void setBefore(std::vector<TabSnapshot> tabs, const QString& name);
+
+    void compare(std::vector<TabSnapshot> tabs);
+
+signals:
+
+    void tabsRequested();
+
+    void changeActivated(const NodeLocation& node);
+
+private slots:
+
+    void onItemActivated(QTreeWidgetItem* item, int column);
+
+private:
+
+    void startDiff();
+
+    void onCompared();
+
+    QTreeWidget* _changes_tree;
+    QLabel* _label_status;
+    QPushButton* _button_refresh;
+
+    QString _before_name;
+    std::vector<TabSnapshot> _before;
+    QFutureWatcher<std::vector<TreeDiff::Change>> _diff_watcher;
+    // received while the diff ran
+    std::vector<TabSnapshot> _pending_tabs;
+    bool _tabs_pending;
+
+    std::vector<TreeDiff::Change> _changes;
+};
+
+#endif // TREE_DIFF_PANEL_H
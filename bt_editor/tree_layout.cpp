@@ -0,0 +1,266 @@
+#include "tree_layout.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+using QtNodes::PortLayout;
+
+const qreal TreeLayout::LEVEL_SPACING = 80;
+const qreal TreeLayout::NODE_SPACING  = 40;
+
+TreeLayout::TreeLayout():
+    _port_layout( PortLayout::Vertical ),
+    _pass(0)
+{
+}
+
+void TreeLayout::clear()
+{
+    _shapes.clear();
+}
+
+TreeLayout::Contour TreeLayout::shifted(const Contour &contour, qreal offset)
+{
+    return std::make_shared<const ContourNode>( ContourNode{ contour->delta + offset, contour->next } );
+}
+
+TreeLayout::Contour TreeLayout::spliced(const Contour &head, const Contour &tail, int count)
+{
+    // the first node of tail that is kept, and its position
+    const ContourNode* tail_node = tail.get();
+    qreal tail_pos = 0;
+    for (int level = 0; level < count && tail_node; level++)
+    {
+        tail_pos += tail_node->delta;
+        tail_node = tail_node->next.get();
+    }
+    if( !tail_node )
+    {
+        return head;
+    }
+    tail_pos += tail_node->delta;
+
+    std::vector<qreal> head_pos;
+    head_pos.reserve( count );
+    qreal pos = 0;
+    for (const ContourNode* node = head.get(); node && int(head_pos.size()) < count; node = node->next.get())
+    {
+        pos += node->delta;
+        head_pos.push_back( pos );
+    }
+
+    Contour result = std::make_shared<const ContourNode>(
+                ContourNode{ tail_pos - head_pos.back(), tail_node->next } );
+    for (int level = int(head_pos.size()) - 1; level >= 0; level--)
+    {
+        const qreal delta = head_pos[level] - ( level > 0 ? head_pos[level-1] : 0 );
+        result = std::make_shared<const ContourNode>( ContourNode{ delta, result } );
+    }
+    return result;
+}
+
+void TreeLayout::computeShape(Shape &shape, const std::vector<const Shape *> &children) const
+{
+    const qreal half = shape.breadth * 0.5;
+    shape.offsets.clear();
+
+    if( children.empty() )
+    {
+        shape.left  = std::make_shared<const ContourNode>( ContourNode{ -half, nullptr } );
+        shape.right = std::make_shared<const ContourNode>( ContourNode{  half, nullptr } );
+        shape.height = 1;
+        return;
+    }
+
+    // the children are placed from left to right, the center of the first
+    // one at zero. acc_left and acc_right are the contours of those placed.
+    std::vector<qreal> positions( children.size(), 0 );
+    Contour acc_left  = children.front()->left;
+    Contour acc_right = children.front()->right;
+    int acc_height = children.front()->height;
+
+    for (size_t i = 1; i < children.size(); i++)
+    {
+        const Shape* child = children[i];
+
+        // the closest position that keeps NODE_SPACING on every common level
+        qreal gap = -std::numeric_limits<qreal>::max();
+        qreal right_pos = 0;
+        qreal left_pos  = 0;
+        const ContourNode* right = acc_right.get();
+        const ContourNode* left  = child->left.get();
+        while( right && left )
+        {
+            right_pos += right->delta;
+            left_pos  += left->delta;
+            gap = std::max( gap, right_pos - left_pos );
+            right = right->next.get();
+            left  = left->next.get();
+        }
+        positions[i] = gap + NODE_SPACING;
+
+        const Contour child_left  = shifted( child->left,  positions[i] );
+        const Contour child_right = shifted( child->right, positions[i] );
+        if( child->height >= acc_height )
+        {
+            acc_left  = spliced( acc_left, child_left, acc_height );
+            acc_right = child_right;
+            acc_height = child->height;
+        }
+        else{
+            acc_right = spliced( child_right, acc_right, child->height );
+        }
+    }
+
+    // the node is centered above its first and last child
+    const qreal middle = positions.back() * 0.5;
+    shape.offsets.reserve( children.size() );
+    for (qreal position: positions)
+    {
+        shape.offsets.push_back( position - middle );
+    }
+
+    auto children_left  = std::make_shared<const ContourNode>(
+                ContourNode{ acc_left->delta - middle + half, acc_left->next } );
+    auto children_right = std::make_shared<const ContourNode>(
+                ContourNode{ acc_right->delta - middle - half, acc_right->next } );
+
+    shape.left  = std::make_shared<const ContourNode>( ContourNode{ -half, children_left } );
+    shape.right = std::make_shared<const ContourNode>( ContourNode{  half, children_right } );
+    shape.height = acc_height + 1;
+}
+
+void TreeLayout::layout(AbsBehaviorTree &tree, PortLayout port_layout)
+{
+    const size_t nodes_count = tree.nodesCount();
+    if( nodes_count == 0 )
+    {
+        return;
+    }
+    if( port_layout != _port_layout )
+    {
+        clear();
+        _port_layout = port_layout;
+    }
+    _pass++;
+
+    const bool vertical = ( port_layout == PortLayout::Vertical );
+
+    // pre-order: the parents before their children
+    std::vector<AbstractTreeNode*> order;
+    order.reserve( nodes_count );
+    std::vector<int> levels( nodes_count, 0 );
+    std::vector<AbstractTreeNode*> stack( 1, tree.rootNode() );
+    while( !stack.empty() )
+    {
+        AbstractTreeNode* node = stack.back();
+        stack.pop_back();
+        order.push_back( node );
+        for (auto it = node->children_index.rbegin(); it != node->children_index.rend(); it++)
+        {
+            levels[*it] = levels[node->index] + 1;
+            stack.push_back( tree.node(*it) );
+        }
+    }
+
+    // the shapes, from the leaves up. A subtree laid out is kept as it was,
+    // unless the size of one of its nodes or their children changed
+    std::vector<Shape*> shapes( nodes_count, nullptr );
+    std::vector<char> changed( nodes_count, 0 );
+    std::deque<Shape> uncached_shapes;
+    std::vector<const Shape*> children_shapes;
+
+    for (auto it = order.rbegin(); it != order.rend(); it++)
+    {
+        AbstractTreeNode* node = *it;
+        const qreal breadth = vertical ? node->size.width()  : node->size.height();
+        const qreal depth   = vertical ? node->size.height() : node->size.width();
+
+        Shape* shape = nullptr;
+        if( node->graphic_node )
+        {
+            shape = &_shapes[ node->graphic_node ];
+        }
+        else{
+            uncached_shapes.push_back( Shape() );
+            shape = &uncached_shapes.back();
+        }
+        shapes[node->index] = shape;
+
+        bool unchanged = shape->pass != 0 && shape->breadth == breadth && shape->depth == depth &&
+                         shape->children.size() == node->children_index.size();
+        for (size_t i = 0; unchanged && i < node->children_index.size(); i++)
+        {
+            const AbstractTreeNode* child = tree.node( node->children_index[i] );
+            unchanged = child->graphic_node && shape->children[i] == child->graphic_node &&
+                        !changed[child->index];
+        }
+        shape->pass = _pass;
+        if( unchanged )
+        {
+            continue;
+        }
+        changed[node->index] = 1;
+
+        shape->breadth = breadth;
+        shape->depth = depth;
+        shape->children.clear();
+        children_shapes.clear();
+        for (int index: node->children_index)
+        {
+            shape->children.push_back( tree.node(index)->graphic_node );
+            children_shapes.push_back( shapes[index] );
+        }
+        computeShape( *shape, children_shapes );
+    }
+
+    // the nodes of a level share the same row
+    std::vector<qreal> level_depth;
+    for (const AbstractTreeNode* node: order)
+    {
+        const size_t level = size_t( levels[node->index] );
+        if( level >= level_depth.size() )
+        {
+            level_depth.resize( level + 1, 0 );
+        }
+        level_depth[level] = std::max( level_depth[level], shapes[node->index]->depth );
+    }
+    std::vector<qreal> level_pos( level_depth.size(), 0 );
+    level_pos[0] = -level_depth[0] * 0.5;
+    for (size_t level = 1; level < level_pos.size(); level++)
+    {
+        level_pos[level] = ( level == 1 ) ? level_depth[0] + LEVEL_SPACING :
+                                            level_pos[level-1] + level_depth[level-1] + LEVEL_SPACING;
+    }
+
+    std::vector<qreal> centers( nodes_count, 0 );
+    for (AbstractTreeNode* node: order)
+    {
+        const Shape* shape = shapes[node->index];
+        const qreal center = centers[node->index];
+        for (size_t i = 0; i < node->children_index.size(); i++)
+        {
+            centers[ node->children_index[i] ] = center + shape->offsets[i];
+        }
+
+        const qreal breadth_pos = center - shape->breadth * 0.5;
+        const qreal depth_pos   = level_pos[ levels[node->index] ];
+        node->pos = vertical ? QPointF( breadth_pos, depth_pos ) :
+                               QPointF( depth_pos, breadth_pos );
+    }
+
+    // forget the nodes that are not in the tree anymore
+    if( _shapes.size() > nodes_count )
+    {
+        for (auto it = _shapes.begin(); it != _shapes.end(); )
+        {
+            if( it->second.pass != _pass )
+            {
+                it = _shapes.erase( it );
+            }
+            else{
+                it++;
+            }
+        }
+    }
+}
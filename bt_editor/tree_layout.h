@@ -0,0 +1,73 @@
+#ifndef TREE_LAYOUT_H
+#define TREE_LAYOUT_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <nodes/Node>
+#include "bt_editor_base.h"
+
+// Tidy layout of a tree (Reingold-Tilford, with the contours of Walker and
+// Buchheim): every subtree is placed as close as possible to its left
+// sibling, the parents are centered above their children, and the nodes of
+// the same level share the same row (column in the horizontal layout).
+//
+// The contour of a subtree is the list, level by level, of its left (right)
+// edges. The contours are immutable lists that share their tails: merging
+// two siblings costs the depth of the lower one, and the whole tree is laid
+// out in linear time.
+//
+// The shape of each subtree is kept, by graphic node: in the next layout, a
+// subtree whose nodes have the same size and the same children is not
+// computed again, only moved with its siblings. Only the edited subtrees and
+// their ancestors are laid out again.
+class TreeLayout
+{
+public:
+    TreeLayout();
+
+    // Set the position (top left corner) of all the nodes of the tree
+    void layout(AbsBehaviorTree& tree, QtNodes::PortLayout port_layout);
+
+    void clear();
+
+    static const qreal LEVEL_SPACING;
+    static const qreal NODE_SPACING;
+
+private:
+
+    struct ContourNode
+    {
+        // from the previous level; the first one from the center of the root
+        qreal delta;
+        std::shared_ptr<const ContourNode> next;
+    };
+    typedef std::shared_ptr<const ContourNode> Contour;
+
+    struct Shape
+    {
+        // along the levels (breadth) and across them (depth)
+        qreal breadth;
+        qreal depth;
+        std::vector<const QtNodes::Node*> children;
+        // of the centers of the children, from the center of the node
+        std::vector<qreal> offsets;
+        Contour left;
+        Contour right;
+        int height;
+        unsigned pass;
+    };
+
+    static Contour shifted(const Contour& contour, qreal offset);
+
+    // the first "count" levels of "head", then the levels of "tail" below them
+    static Contour spliced(const Contour& head, const Contour& tail, int count);
+
+    void computeShape(Shape& shape, const std::vector<const Shape*>& children) const;
+
+    std::unordered_map<const QtNodes::Node*, Shape> _shapes;
+    QtNodes::PortLayout _port_layout;
+    unsigned _pass;
+};
+
+#endif // TREE_LAYOUT_H
@@ -0,0 +1,144 @@
+#include "undo_history.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+
+QByteArray SceneState::toMemory(const QString &layout,
+                                QtNodes::FlowScene::SceneFormat format) const
+{
+    QJsonObject scene_json;
+    scene_json["layout"] = layout;
+
+    QJsonArray nodes_json;
+    for (const auto& it: nodes)
+    {
+        nodes_json.append( it.second );
+    }
+    scene_json["nodes"] = nodes_json;
+
+    QJsonArray connections_json;
+    for (const auto& it: connections)
+    {
+        connections_json.append( it.second );
+    }
+    scene_json["connections"] = connections_json;
+
+    return QtNodes::FlowScene::encodeScene( scene_json, format );
+}
+
+SceneState SceneState::fromMemory(const QByteArray &data, QString *layout)
+{
+    SceneState state;
+    const QJsonObject scene_json = QtNodes::FlowScene::decodeScene( data );
+    if( layout )
+    {
+        *layout = scene_json["layout"].toString();
+    }
+
+    for (const auto& node: scene_json["nodes"].toArray())
+    {
+        const QJsonObject node_json = node.toObject();
+        state.nodes.insert( { QUuid( node_json["id"].toString() ), node_json } );
+    }
+    for (const auto& connection: scene_json["connections"].toArray())
+    {
+        const QJsonObject connection_json = connection.toObject();
+        state.connections.insert( { connectionKey(connection_json), connection_json } );
+    }
+    return state;
+}
+
+QString SceneState::connectionKey(const QJsonObject &connection)
+{
+    return QString("%1:%2>%3:%4")
+        .arg( connection["out_id"].toString() )
+        .arg( connection["out_index"].toInt() )
+        .arg( connection["in_id"].toString() )
+        .arg( connection["in_index"].toInt() );
+}
+
+static size_t JsonSize(const QJsonObject& object)
+{
+    return object.isEmpty() ? 0 : QJsonDocument(object).toJson(QJsonDocument::Compact).size();
+}
+
+size_t SceneState::memoryUsage() const
+{
+    size_t bytes = sizeof(SceneState);
+    for (const auto& it: nodes)
+    {
+        bytes += sizeof(it) + JsonSize( it.second );
+    }
+    for (const auto& it: connections)
+    {
+        bytes += sizeof(it) + it.first.size() * sizeof(QChar) + JsonSize( it.second );
+    }
+    return bytes;
+}
+
+size_t SceneCommand::memoryUsage() const
+{
+    size_t bytes = sizeof(SceneCommand) + tab_name.size() * sizeof(QChar);
+    for (const auto& edit: nodes)
+    {
+        bytes += sizeof(NodeEdit) + JsonSize( edit.before ) + JsonSize( edit.after );
+    }
+    for (const auto& connection: removed_connections)
+    {
+        bytes += JsonSize( connection );
+    }
+    for (const auto& connection: added_connections)
+    {
+        bytes += JsonSize( connection );
+    }
+    return bytes;
+}
+
+SceneCommand SceneCommand::difference(const QString &tab_name,
+                                      const SceneState &before,
+                                      const SceneState &after)
+{
+    SceneCommand command;
+    command.tab_name = tab_name;
+
+    // both maps are sorted by id: merge them
+    auto it_before = before.nodes.begin();
+    auto it_after  = after.nodes.begin();
+    while( it_before != before.nodes.end() || it_after != after.nodes.end() )
+    {
+        if( it_after == after.nodes.end() ||
+            (it_before != before.nodes.end() && it_before->first < it_after->first) )
+        {
+            command.nodes.push_back( { it_before->first, it_before->second, QJsonObject() } );
+            it_before++;
+        }
+        else if( it_before == before.nodes.end() || it_after->first < it_before->first )
+        {
+            command.nodes.push_back( { it_after->first, QJsonObject(), it_after->second } );
+            it_after++;
+        }
+        else{
+            if( it_before->second != it_after->second )
+            {
+                command.nodes.push_back( { it_after->first, it_before->second, it_after->second } );
+            }
+            it_before++;
+            it_after++;
+        }
+    }
+
+    for (const auto& it: before.connections)
+    {
+        if( after.connections.count( it.first ) == 0 )
+        {
+            command.removed_connections.push_back( it.second );
+        }
+    }
+    for (const auto& it: after.connections)
+    {
+        if( before.connections.count( it.first ) == 0 )
+        {
+            command.added_connections.push_back( it.second );
+        }
+    }
+    return command;
+}
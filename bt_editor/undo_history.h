@@ -0,0 +1,76 @@
+#ifndef UNDO_HISTORY_H
+#define UNDO_HISTORY_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QUuid>
+#include <nodes/FlowScene>
+#include "bt_editor_base.h"
+
+// What the undo history knows about a scene: the saved nodes, by id, and the
+// saved connections, by connectionKey(). It is compared with the previous
+// state of the same scene, without serializing it to text.
+//
+// The scene of a tab that was never shown is not built: its state is then
+// only the tree it will show (lazy_tree), and nodes/connections are empty.
+struct SceneState
+{
+    std::map<QUuid, QJsonObject> nodes;
+    std::map<QString, QJsonObject> connections;
+    std::shared_ptr<const AbsBehaviorTree> lazy_tree;
+
+    // same formats as QtNodes::FlowScene::saveToMemory()
+    QByteArray toMemory(const QString& layout,
+                        QtNodes::FlowScene::SceneFormat format = QtNodes::FlowScene::SceneFormat::Binary) const;
+
+    // layout, if not null, is the "layout" of the scene
+    static SceneState fromMemory(const QByteArray& data, QString* layout = nullptr);
+
+    static QString connectionKey(const QJsonObject& connection);
+
+    // approximate, in bytes. The lazy tree is not counted: it is shared
+    size_t memoryUsage() const;
+
+    bool operator ==(const SceneState& other) const
+    {
+        return lazy_tree == other.lazy_tree &&
+               nodes == other.nodes && connections == other.connections;
+    }
+    bool operator !=(const SceneState& other) const { return !( *this == other); }
+};
+
+// Incremental edit of a single scene. A node with an empty "before" was
+// added, one with an empty "after" was removed; otherwise it was moved or
+// its ports were edited. Undo applies "before", redo applies "after".
+struct SceneCommand
+{
+    struct NodeEdit
+    {
+        QUuid id;
+        QJsonObject before;
+        QJsonObject after;
+    };
+
+    QString tab_name;
+    std::vector<NodeEdit> nodes;
+    std::vector<QJsonObject> removed_connections;
+    std::vector<QJsonObject> added_connections;
+
+    bool empty() const
+    {
+        return nodes.empty() && removed_connections.empty() && added_connections.empty();
+    }
+
+    // approximate, in bytes
+    size_t memoryUsage() const;
+
+    static SceneCommand difference(const QString& tab_name,
+                                   const SceneState& before,
+                                   const SceneState& after);
+};
+
+#endif // UNDO_HISTORY_H
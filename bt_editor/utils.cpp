@@ -1,13 +1,18 @@
 #include "utils.h"
 #include <set>
+#include <map>
 #include <QDebug>
 #include <QDomDocument>
 #include <QMessageBox>
+#include <QCryptographicHash>
 #include "nodes/Node"
 #include "nodes/DataModelRegistry"
+#include "nodes/PaintProfiler"
 #include "nodes/internal/memory.hpp"
 #include "models/SubtreeNodeModel.hpp"
 #include "models/RootNodeModel.hpp"
+#include "tree_layout.h"
+#include "trace_recorder.h"
 
 using QtNodes::PortLayout;
 using QtNodes::DataModelRegistry;
@@ -39,13 +44,18 @@ std::vector<Node*> getChildren(const QtNodes::FlowScene &scene,
                                const Node& parent_node,
                                bool ordered)
 {
-    std::vector<Node*> children;
-
     if( parent_node.nodeDataModel()->nPorts(PortType::Out) == 0)
     {
-        return children;
+        return std::vector<Node*>();
+    }
+
+    // the scene keeps the children sorted by position
+    if( ordered )
+    {
+        return scene.orderedChildren( parent_node );
     }
 
+    std::vector<Node*> children;
     const auto& conn_out = parent_node.nodeState().connections(PortType::Out, 0);
     children.reserve( conn_out.size() );
 
@@ -57,187 +67,17 @@ std::vector<Node*> getChildren(const QtNodes::FlowScene &scene,
             children.push_back( child_node );
         }
     }
-
-    if( ordered && children.size() > 1)
-    {
-        if( scene.layout() == PortLayout::Vertical)
-        {
-            std::sort(children.begin(), children.end(),
-                      [&](const Node* a, const Node* b)
-            {
-                double pos_a = scene.getNodePosition( *a ).x() + scene.getNodeSize( *a ).width()*0.5;
-                double pos_b = scene.getNodePosition( *b ).x() + scene.getNodeSize( *b ).width()*0.5;
-                return pos_a < pos_b;
-            } );
-        }
-        else{
-            std::sort(children.begin(), children.end(),
-                      [&](const Node* a, const Node* b)
-            {
-                double pos_a = scene.getNodePosition( *a ).y() + scene.getNodeSize( *a ).height()*0.5;
-                double pos_b = scene.getNodePosition( *b ).y() + scene.getNodeSize( *b ).height()*0.5;
-                return pos_a < pos_b;
-            } );
-        }
-    }
     return children;
 }
 
 
 //---------------------------------------------------
 
-void RecursiveNodeReorder(AbsBehaviorTree& tree, PortLayout layout)
-{
-    std::function<void(unsigned, AbstractTreeNode*)> recursiveStep;
-
-    std::vector<QPointF> layer_cursor;
-    std::vector< std::vector<AbstractTreeNode*> > nodes_by_level(1);
-
-    const qreal LEVEL_SPACING = 80;
-    const qreal NODE_SPACING  = 40;
-
-    recursiveStep = [&](unsigned current_layer, AbstractTreeNode* node)
-    {
-        node->pos = layer_cursor[current_layer];
-        nodes_by_level[current_layer].push_back( node );
-
-        //------------------------------------
-        if( node->children_index.size() == 0 )
-        {
-            return;
-        }
-        qreal recommended_pos = NODE_SPACING * 0.5;
-
-        current_layer++;
-
-        if( layout == PortLayout::Vertical)
-        {
-            recommended_pos += (node->pos.x() + node->size.width()*0.5)  ;
-            for(int index: node->children_index)
-            {
-                const auto& child_node = tree.nodes()[index];
-                recommended_pos -=  (child_node.size.width() + NODE_SPACING) * 0.5;
-            }
-
-            if( current_layer >= layer_cursor.size())
-            {
-                QPointF new_cursor( recommended_pos,
-                                    node->pos.y() + LEVEL_SPACING );
-                layer_cursor.push_back( new_cursor );
-                nodes_by_level.push_back( std::vector<AbstractTreeNode*>() );
-            }
-            else{
-                recommended_pos = std::max( recommended_pos, layer_cursor[current_layer].x() );
-                layer_cursor[current_layer].setX(recommended_pos);
-            }
-        }//------------------------------------
-        else
-        {
-            recommended_pos += node->pos.y() + node->size.height()*0.5;
-            for(int index: node->children_index)
-            {
-                const auto& child_node = tree.nodes()[index];
-                recommended_pos -=  (child_node.size.height() + NODE_SPACING) * 0.5;
-            }
-
-            if( current_layer >= layer_cursor.size())
-            {
-                QPointF new_cursor( node->pos.x() + LEVEL_SPACING,
-                                    recommended_pos);
-                layer_cursor.push_back( new_cursor );
-                nodes_by_level.push_back( std::vector<AbstractTreeNode*>() );
-            }
-            else{
-                recommended_pos = std::max( recommended_pos, layer_cursor[current_layer].y() );
-                layer_cursor[current_layer].setY(recommended_pos);
-            }
-        }
-        //------------------------------------
-
-        auto initial_pos = layer_cursor[current_layer];
-
-        for(int index: node->children_index)
-        {
-            AbstractTreeNode* child_node = tree.node(index);
-
-            recursiveStep(current_layer, child_node);
-            if( layout == PortLayout::Vertical)
-            {
-                layer_cursor[current_layer]+= QPointF( child_node->size.width() + NODE_SPACING, 0 );
-            }
-            else{
-                layer_cursor[current_layer]+= QPointF( 0, child_node->size.height() + NODE_SPACING );
-            }
-        }
-
-        auto final_pos = layer_cursor[current_layer];
-
-        if( node->children_index.size() > 0)
-        {
-            auto first_child = tree.node( node->children_index.front() );
-            auto last_child = tree.node( node->children_index.back() );
-
-            initial_pos = QPointF( first_child->pos.x() + first_child->size.width()*0.5,
-                                   first_child->pos.y() + first_child->size.height()*0.5);
-
-            final_pos   = QPointF( last_child->pos.x() + last_child->size.width()*0.5,
-                                   last_child->pos.y() + last_child->size.height()*0.5);
-        }
-
-        // rebalance father
-        QPointF pos_offset(0,0);
-        if( layout == PortLayout::Vertical)
-        {
-            double new_x = (final_pos.x() + initial_pos.x()) * 0.5 - node->size.width()*0.5;
-            double diff = node->pos.x() - new_x;
-            pos_offset = QPointF( - diff, 0 );
-        }
-        else{
-            double new_y = (final_pos.y() + initial_pos.y()) * 0.5 - node->size.height()*0.5;
-            double diff = node->pos.y() - new_y;
-            pos_offset = QPointF( 0, - diff );
-        }
-
-        node->pos += pos_offset;
-        layer_cursor[current_layer -1 ] += pos_offset;
-    };
-
-    auto root_node = tree.rootNode();
-    layer_cursor.push_back(QPointF( -root_node->size.width()*0.5,
-                                    -root_node->size.height()*0.5));
-    recursiveStep(0, root_node);
-
-    if( layout == PortLayout::Vertical)
-    {
-        qreal offset = root_node->size.height() + LEVEL_SPACING;
-        for(unsigned i=1; i< nodes_by_level.size(); i++ )
-        {
-            qreal max_height = 0;
-            for(auto node: nodes_by_level[i])
-            {
-                max_height = std::max( max_height, node->size.height() );
-                node->pos.setY( offset );
-            }
-            offset += max_height + LEVEL_SPACING;
-        }
-    }
-    else{
-        qreal offset = root_node->size.width() + LEVEL_SPACING;
-        for(unsigned i=1; i< nodes_by_level.size(); i++ )
-        {
-            qreal max_width = 0;
-            for(auto node: nodes_by_level[i])
-            {
-                max_width = std::max( max_width, node->size.width() );
-                node->pos.setX( offset );
-            }
-            offset += max_width + LEVEL_SPACING;
-        }
-    }
-}
-
-void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree & tree)
+void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree & tree, TreeLayout* tree_layout)
 {
+    QtNodes::PaintProfiler::Scope profile( QtNodes::PaintProfiler::Layout );
+    TraceScope trace( "layout", "NodeReorder" );
+    trace.setArgument( "nodes", tree.nodesCount() );
 
     for (const auto& abs_node: tree.nodes())
     {
@@ -253,19 +93,31 @@ void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree & tree)
         return;
     }
 
-    RecursiveNodeReorder(tree, scene.layout() );
+    if( tree_layout )
+    {
+        tree_layout->layout( tree, scene.layout() );
+    }
+    else{
+        TreeLayout().layout( tree, scene.layout() );
+    }
 
+    // the nodes that did not move are not updated
     for (const auto& abs_node: tree.nodes())
     {
         Node* node =  abs_node.graphic_node;
-        scene.setNodePosition( *node, abs_node.pos );
+        if( scene.getNodePosition( *node ) != abs_node.pos )
+        {
+            scene.setNodePosition( *node, abs_node.pos );
+        }
     }
 }
 
 
 AbsBehaviorTree BuildTreeFromScene(const QtNodes::FlowScene *scene,
-                                   QtNodes::Node* root_node)
+                                   QtNodes::Node* root_node,
+                                   bool with_collapsed)
 {
+    TraceScope trace( "scene", "BuildTreeFromScene" );
     if(!root_node )
     {
         root_node = findRoot( *scene );
@@ -281,6 +133,20 @@ AbsBehaviorTree BuildTreeFromScene(const QtNodes::FlowScene *scene,
 
     AbsBehaviorTree tree;
 
+    std::function<void(AbstractTreeNode*, const CompactTree&, size_t)> pushBranch;
+
+    pushBranch = [&](AbstractTreeNode* parent, const CompactTree& branch, size_t index)
+    {
+        AbstractTreeNode abs_node = branch.node(index);
+        abs_node.children_index.clear();
+
+        auto added_node = tree.addNode( parent, std::move(abs_node) );
+        for (size_t i = 0; i < branch.childrenCount(index); i++)
+        {
+            pushBranch( added_node, branch, size_t( branch.child(index, i) ) );
+        }
+    };
+
     std::function<void(AbstractTreeNode*, QtNodes::Node*)> pushRecursively;
 
     pushRecursively = [&](AbstractTreeNode* parent, QtNodes::Node* node)
@@ -298,6 +164,16 @@ AbsBehaviorTree BuildTreeFromScene(const QtNodes::FlowScene *scene,
 
         auto added_node = tree.addNode( parent, std::move(abs_node) );
 
+        const CompactTree& branch = bt_model->collapsedBranch();
+        if( !branch.empty() && with_collapsed )
+        {
+            // the root of the branch is this node
+            for (size_t i = 0; i < branch.childrenCount(0); i++)
+            {
+                pushBranch( added_node, branch, size_t( branch.child(0, i) ) );
+            }
+        }
+
         auto children = getChildren( *scene, *node, true );
 
         for(auto& child_node: children )
@@ -342,7 +218,7 @@ AbsBehaviorTree BuildTreeFromXML(const QDomElement& bt_root, const NodeModels& m
 
         if( xml_node.hasAttribute("name") )
         {
-            tree_node.instance_name = ( xml_node.attribute("name") );
+            tree_node.instance_name = InternString( xml_node.attribute("name") );
         }
         else{
             tree_node.instance_name = modelID;
@@ -354,7 +230,7 @@ AbsBehaviorTree BuildTreeFromXML(const QDomElement& bt_root, const NodeModels& m
             auto attribute = attributes.item(attr).toAttr();
             if( attribute.name() != "ID" && attribute.name() != "name")
             {
-                tree_node.ports_mapping.insert( { attribute.name(), attribute.value() } );
+                tree_node.ports_mapping.insert( { InternString( attribute.name() ), attribute.value() } );
             }
         }
 
@@ -385,11 +261,11 @@ AbsBehaviorTree BuildTreeFromXML(const QDomElement& bt_root, const NodeModels& m
 }
 
 
-std::pair<AbsBehaviorTree, std::unordered_map<int, int>>
+std::pair<AbsBehaviorTree, UidLookupTable>
 BuildTreeFromFlatbuffers(const Serialization::BehaviorTree *fb_behavior_tree)
 {
     AbsBehaviorTree tree;
-    std::unordered_map<int, int> uid_to_index;
+    UidLookupTable uid_to_index;
 
     AbstractTreeNode abs_root;
     abs_root.instance_name = "Root";
@@ -405,15 +281,15 @@ BuildTreeFromFlatbuffers(const Serialization::BehaviorTree *fb_behavior_tree)
     for( const Serialization::NodeModel* model_node: *(fb_behavior_tree->node_models()) )
     {
         NodeModel model;
-        model.registration_ID = model_node->registration_name()->c_str();
+        model.registration_ID = InternString( model_node->registration_name()->c_str() );
         model.type = convert( model_node->type() );
 
         for( const Serialization::PortModel* port: *(model_node->ports()) )
         {
             PortModel port_model;
-            QString port_name = port->port_name()->c_str();
+            QString port_name = InternString( port->port_name()->c_str() );
             port_model.direction = convert( port->direction() );
-            port_model.type_name = port->type_info()->c_str();
+            port_model.type_name = InternString( port->type_info()->c_str() );
             port_model.description = port->description()->c_str();
 
             model.ports.insert( { port_name, std::move(port_model) } );
@@ -426,20 +302,20 @@ BuildTreeFromFlatbuffers(const Serialization::BehaviorTree *fb_behavior_tree)
     for( const Serialization::TreeNode* fb_node: *(fb_behavior_tree->nodes()) )
     {
         AbstractTreeNode abs_node;
-        abs_node.instance_name = fb_node->instance_name()->c_str();
+        abs_node.instance_name = InternString( fb_node->instance_name()->c_str() );
         const char* registration_ID = fb_node->registration_name()->c_str();
         abs_node.status = convert( fb_node->status() );
         abs_node.model = (models.at(registration_ID));
 
         for( const Serialization::PortConfig* pair: *(fb_node->port_remaps()) )
         {
-            abs_node.ports_mapping.insert( { QString(pair->port_name()->c_str()),
+            abs_node.ports_mapping.insert( { InternString( pair->port_name()->c_str() ),
                                              QString(pair->remap()->c_str()) } );
         }
         int index = tree.nodesCount();
         abs_node.index = index;
         tree.nodes().push_back( std::move(abs_node) );
-        uid_to_index.insert( { fb_node->uid(), index} );
+        uid_to_index.insert( fb_node->uid(), index );
     }
 
     for(size_t index = 0; index < fb_behavior_tree->nodes()->size(); index++ )
@@ -448,15 +324,103 @@ BuildTreeFromFlatbuffers(const Serialization::BehaviorTree *fb_behavior_tree)
         AbstractTreeNode* abs_node = tree.node( index + 1);
         for( const auto child_uid: *(fb_node->children_uid()) )
         {
-            int child_index = uid_to_index[ child_uid ];
-            abs_node->children_index.push_back(child_index);
+            const int child_index = uid_to_index.find( child_uid );
+            if( child_index != UidLookupTable::INVALID_INDEX )
+            {
+                abs_node->children_index.push_back(child_index);
+            }
         }
     }
     return { tree, uid_to_index };
 }
 
-std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>
-getStyleFromStatus(NodeStatus status, NodeStatus prev_status)
+UidLookupTable
+UidToIndexFromFlatbuffers(const Serialization::BehaviorTree *fb_behavior_tree)
+{
+    // same indices of BuildTreeFromFlatbuffers: 0 is the Root
+    UidLookupTable uid_to_index;
+    int index = 1;
+    for( const Serialization::TreeNode* fb_node: *(fb_behavior_tree->nodes()) )
+    {
+        uid_to_index.insert( fb_node->uid(), index++ );
+    }
+    return uid_to_index;
+}
+
+QByteArray TreeStructureHash(const Serialization::BehaviorTree *fb_behavior_tree)
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+    auto addString = [&hash](const flatbuffers::String* str)
+    {
+        const QByteArray data = str ? QByteArray( str->c_str(), int(str->size()) ) : QByteArray();
+        const uint32_t size = uint32_t( data.size() );
+        hash.addData( reinterpret_cast<const char*>(&size), sizeof(size) );
+        hash.addData( data );
+    };
+    auto addInt = [&hash](int32_t value)
+    {
+        hash.addData( reinterpret_cast<const char*>(&value), sizeof(value) );
+    };
+
+    // the order of models and ports depends on the hash maps of the robot:
+    // sort them, to get the same hash for the same tree
+    std::map<std::string, const Serialization::NodeModel*> models;
+    for( const Serialization::NodeModel* model_node: *(fb_behavior_tree->node_models()) )
+    {
+        models.insert( { model_node->registration_name()->str(), model_node } );
+    }
+
+    const auto uid_to_index = UidToIndexFromFlatbuffers( fb_behavior_tree );
+
+    for( const Serialization::TreeNode* fb_node: *(fb_behavior_tree->nodes()) )
+    {
+        addString( fb_node->registration_name() );
+        addString( fb_node->instance_name() );
+
+        auto model_it = models.find( fb_node->registration_name()->str() );
+        if( model_it != models.end() )
+        {
+            const Serialization::NodeModel* model_node = model_it->second;
+            addInt( int32_t(model_node->type()) );
+
+            std::map<std::string, const Serialization::PortModel*> ports;
+            for( const Serialization::PortModel* port: *(model_node->ports()) )
+            {
+                ports.insert( { port->port_name()->str(), port } );
+            }
+            for( const auto& port: ports )
+            {
+                addString( port.second->port_name() );
+                addInt( int32_t(port.second->direction()) );
+                addString( port.second->type_info() );
+                addString( port.second->description() );
+            }
+        }
+
+        std::map<std::string, const Serialization::PortConfig*> remaps;
+        for( const Serialization::PortConfig* pair: *(fb_node->port_remaps()) )
+        {
+            remaps.insert( { pair->port_name()->str(), pair } );
+        }
+        for( const auto& remap: remaps )
+        {
+            addString( remap.second->port_name() );
+            addString( remap.second->remap() );
+        }
+
+        // children by index, not by uid
+        addInt( int32_t(fb_node->children_uid()->size()) );
+        for( const auto child_uid: *(fb_node->children_uid()) )
+        {
+            addInt( uid_to_index.find( child_uid ) );
+        }
+    }
+    return hash.result().toHex();
+}
+
+static std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>
+ComputeStyleFromStatus(NodeStatus status, NodeStatus prev_status)
 {
     QtNodes::NodeStyle  node_style;
     QtNodes::ConnectionStyle conn_style;
@@ -522,6 +486,46 @@ getStyleFromStatus(NodeStatus status, NodeStatus prev_status)
     return {node_style, conn_style};
 }
 
+const std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>&
+getStyleFromStatus(NodeStatus status, NodeStatus prev_status)
+{
+    // IDLE, RUNNING, SUCCESS and FAILURE
+    static const int STATUS_COUNT = 4;
+    static const std::vector<std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>> table = []()
+    {
+        std::vector<std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>> styles;
+        for (int s = 0; s < STATUS_COUNT; s++)
+        {
+            for (int p = 0; p < STATUS_COUNT; p++)
+            {
+                styles.push_back( ComputeStyleFromStatus( static_cast<NodeStatus>(s),
+                                                          static_cast<NodeStatus>(p) ) );
+            }
+        }
+        return styles;
+    }();
+
+    const int s = int(status);
+    const int p = int(prev_status);
+    if( s < 0 || s >= STATUS_COUNT || p < 0 || p >= STATUS_COUNT )
+    {
+        return table.front();
+    }
+    return table[ s * STATUS_COUNT + p ];
+}
+
+const QtNodes::NodeStyle &DefaultNodeStyle()
+{
+    static const QtNodes::NodeStyle style;
+    return style;
+}
+
+const QtNodes::ConnectionStyle &DefaultConnectionStyle()
+{
+    static const QtNodes::ConnectionStyle style;
+    return style;
+}
+
 QtNodes::Node *GetParentNode(QtNodes::Node *node)
 {
     using namespace QtNodes;
@@ -16,19 +16,42 @@ std::vector<QtNodes::Node *> getChildren(const QtNodes::FlowScene &scene,
                                          const QtNodes::Node &parent_node,
                                          bool ordered);
 
+// with_collapsed: the collapsed branches (see BehaviorTreeDataModel::collapsedBranch)
+// are part of the tree, with a null graphic_node. Otherwise only the nodes
+// of the scene are.
 AbsBehaviorTree BuildTreeFromScene(const QtNodes::FlowScene *scene,
-                                   QtNodes::Node *root_node = nullptr);
+                                   QtNodes::Node *root_node = nullptr,
+                                   bool with_collapsed = false);
 
-std::pair<AbsBehaviorTree, std::unordered_map<int, int> >
+std::pair<AbsBehaviorTree, UidLookupTable>
 BuildTreeFromFlatbuffers(const Serialization::BehaviorTree* bt );
 
+// the indices used by BuildTreeFromFlatbuffers, without building the tree
+UidLookupTable
+UidToIndexFromFlatbuffers(const Serialization::BehaviorTree* bt );
+
+// Hash of the structure of the tree (nodes, models, ports and children).
+// The UIDs are not included: the same tree has the same hash in every run.
+QByteArray TreeStructureHash(const Serialization::BehaviorTree* bt );
+
 AbsBehaviorTree BuildTreeFromXML(const QDomElement &bt_root, const NodeModels &models);
 
-void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree &abstract_tree );
+class TreeLayout;
 
-std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>
+// tree_layout, if not null, keeps the shapes of the subtrees from the
+// previous layout of the same scene: only what changed is laid out again
+void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree &abstract_tree,
+                 TreeLayout* tree_layout = nullptr );
+
+// The styles of all the combinations of status and previous status are
+// computed once: the result is shared, no style is constructed per call.
+const std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>&
 getStyleFromStatus(NodeStatus status, NodeStatus prev_status);
 
+// Shared default styles, loading them from JSON is expensive.
+const QtNodes::NodeStyle& DefaultNodeStyle();
+const QtNodes::ConnectionStyle& DefaultConnectionStyle();
+
 QtNodes::Node* GetParentNode(QtNodes::Node* node);
 
 std::set<QString> GetModelsToRemove(QWidget* parent,
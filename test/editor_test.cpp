@@ -1,7 +1,11 @@
 #include "groot_test_base.h"
 #include "bt_editor/sidepanel_editor.h"
+#include "bt_editor/palette_import.h"
+#include "bt_editor/model_database.h"
+#include "bt_editor/scene_minimap.h"
 #include <QAction>
 #include <QLineEdit>
+#include <QTemporaryDir>
 
 class EditorTest : public GrootTestBase
 {
@@ -23,10 +27,16 @@ private slots:
     void modifyCustomModel();
     void multipleSubtrees();
     void editText();
+    void editPortValue();
     void loadModelLess();
     void longNames();
     void clearModels();
     void undoWithSubtreeExpanded();
+    void copyPasteNodes();
+    void modelUsage();
+    void importPalettes();
+    void sceneMinimap();
+    void sharedModelDatabase();
 };
 
 
@@ -533,6 +543,71 @@ void EditorTest::editText()
     sleepAndRefresh( 500 );
 }
 
+void EditorTest::editPortValue()
+{
+    QString file_xml = readFile("://show_all.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+    sleepAndRefresh( 200 );
+
+    const auto abs_tree = getAbstractTree();
+
+    // the first node with a port, edited in its first row
+    size_t node_index = 0;
+    PortFieldsWidget* fields = nullptr;
+    for (size_t index = 0; index < abs_tree.nodesCount() && !fields; index++)
+    {
+        auto bt_model = dynamic_cast<BehaviorTreeDataModel*>(
+                    abs_tree.node( index )->graphic_node->nodeDataModel() );
+        auto widget = bt_model ? qobject_cast<PortFieldsWidget*>( bt_model->parametersWidget() ) : nullptr;
+        if( widget && !widget->values().empty() && widget->isVisible() )
+        {
+            node_index = index;
+            fields = widget;
+        }
+    }
+    QVERIFY2( fields, "No node with ports in show_all.xml" );
+    const PortsMapping values_before = fields->values();
+    QCOMPARE( abs_tree.node( node_index )->ports_mapping, values_before );
+
+    // a line edit is created on the value only while it is edited
+    QVERIFY( fields->findChildren<QLineEdit*>().isEmpty() );
+    const QPoint first_value( fields->width() - 3, 3 );
+    QTest::mouseDClick( fields, Qt::LeftButton, Qt::NoModifier, first_value );
+    sleepAndRefresh( 50 );
+    auto editors = fields->findChildren<QLineEdit*>();
+    QCOMPARE( editors.size(), 1 );
+    QLineEdit* editor = editors.front();
+    QVERIFY( !editor->isReadOnly() );
+
+    editor->selectAll();
+    QTest::keyClick( editor, Qt::Key_Delete, Qt::NoModifier );
+    QTest::keyClicks( editor, "was_here" );
+    QTest::keyClick( editor, Qt::Key_Return, Qt::NoModifier );
+    sleepAndRefresh( 50 );
+
+    // only the edited port changed, in the tree too
+    const PortsMapping values_after = fields->values();
+    QCOMPARE( values_after.size(), values_before.size() );
+    int changed_ports = 0;
+    for (const auto& it: values_after)
+    {
+        if( it.second != values_before.at( it.first ) )
+        {
+            changed_ports++;
+            QCOMPARE( it.second, QString("was_here") );
+        }
+    }
+    QCOMPARE( changed_ports, 1 );
+    const auto edited_tree = getAbstractTree();
+    QCOMPARE( edited_tree.node( node_index )->ports_mapping, values_after );
+
+    // a single undo step restores the value
+    main_win->onUndoInvoked();
+    sleepAndRefresh( 200 );
+    QCOMPARE( getAbstractTree(), abs_tree );
+}
+
 void EditorTest::loadModelLess()
 {
     QString file_xml = readFile("://simple_without_model.xml");
@@ -633,6 +708,213 @@ void EditorTest::undoWithSubtreeExpanded()
      sleepAndRefresh( 500 );
 }
 
+void EditorTest::copyPasteNodes()
+{
+    QString file_xml = readFile(":/show_all.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->currentTabInfo();
+    auto scene = container->scene();
+    AbsBehaviorTree abs_tree = getAbstractTree();
+    const size_t nodes_count = scene->nodes().size();
+
+    auto branch_root = abs_tree.findFirstNode( "DoSequenceStar" );
+    QVERIFY( branch_root );
+    const size_t branch_size = container->getSubtreeNodesRecursively( *branch_root->graphic_node ).size();
+
+    const ClipboardNodes copy = container->copyNodes( { branch_root->graphic_node }, true );
+    QCOMPARE( copy.forest.nodesCount(), branch_size );
+    QCOMPARE( copy.roots(), std::vector<int>{0} );
+
+    // the compact format keeps everything
+    ClipboardNodes decoded;
+    QVERIFY( DecodeClipboardNodes( EncodeClipboardNodes( copy ), &decoded ) );
+    QCOMPARE( decoded.forest, copy.forest );
+    QVERIFY( !DecodeClipboardNodes( QByteArray("not nodes"), &decoded ) );
+
+    // only the copied node, without its children
+    const ClipboardNodes single = container->copyNodes( { branch_root->graphic_node }, false );
+    QCOMPARE( single.forest.nodesCount(), size_t(1) );
+
+    const auto pasted = container->pasteNodes( decoded, QPointF(1000, 1000) );
+    QCOMPARE( pasted.size(), branch_size );
+    QCOMPARE( scene->nodes().size(), nodes_count + branch_size );
+    QCOMPARE( scene->selectedNodes().size(), branch_size );
+    sleepAndRefresh( 500 );
+
+    // a single undo step
+    main_win->onUndoInvoked();
+    sleepAndRefresh( 500 );
+    QCOMPARE( main_win->currentTabInfo()->scene()->nodes().size(), nodes_count );
+    QCOMPARE( getAbstractTree(), abs_tree );
+}
+
+void EditorTest::modelUsage()
+{
+    QString file_xml = readFile(":/show_all.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->currentTabInfo();
+    AbsBehaviorTree abs_tree = getAbstractTree();
+    std::map<QString, int> expected;
+    for (const auto& abs_node: abs_tree.nodes())
+    {
+        expected[ abs_node.model.registration_ID ]++;
+    }
+    auto compareUsage = [&]()
+    {
+        for (const auto& it: expected)
+        {
+            QCOMPARE( container->modelUsage( it.first ), it.second );
+        }
+        QCOMPARE( container->modelUsage( "NoSuchModel" ), 0 );
+    };
+    compareUsage();
+    const QString ID = abs_tree.node(1)->model.registration_ID;
+    QCOMPARE( main_win->modelUsage( ID ), expected[ID] );
+    QCOMPARE( main_win->modelUsers( ID ).size(), size_t(1) );
+    QCOMPARE( int( container->nodesUsingModel( ID ).size() ), expected[ID] );
+
+    // the nodes of a collapsed branch are still used
+    auto branch_root = abs_tree.findFirstNode( "DoSequenceStar" );
+    QVERIFY( branch_root );
+    QVERIFY( container->canCollapseBranch( *branch_root->graphic_node ) );
+    container->collapseBranch( *branch_root->graphic_node );
+    compareUsage();
+
+    // counted from the saved scene, which is not built again
+    QVERIFY( container->evict() );
+    compareUsage();
+    QVERIFY( !container->isMaterialized() );
+
+    container->materialize();
+    compareUsage();
+}
+
+void EditorTest::importPalettes()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    auto writeFile = [&directory](const QString& name, const QByteArray& content)
+    {
+        QFile file( directory.filePath(name) );
+        file.open( QIODevice::WriteOnly );
+        file.write( content );
+        return directory.filePath(name);
+    };
+    const QString first = writeFile( "first.xml",
+        "<root><TreeNodesModel>"
+        "<Action ID=\"OpenDoor\"/>"
+        "<Action ID=\"SaySomething\"><input_port name=\"message\"/></Action>"
+        "</TreeNodesModel></root>" );
+    const QString second = writeFile( "second.xml",
+        "<root><TreeNodesModel>"
+        "<Action ID=\"OpenDoor\"/>"
+        "<Condition ID=\"SaySomething\"/>"
+        "<Condition ID=\"IsDoorOpen\"/>"
+        "</TreeNodesModel></root>" );
+    const QString broken = writeFile( "broken.xml", "<root><TreeNodesModel>" );
+
+    ImportedPalettes palettes = PaletteImport::importFiles( { first, second, broken } );
+    QCOMPARE( palettes.files.size(), size_t(2) );
+    QCOMPARE( palettes.errors.size(), 1 );
+    QCOMPARE( palettes.models.size(), size_t(3) );
+    // the same model twice is not a conflict, a different one is
+    QCOMPARE( palettes.conflicts.size(), size_t(1) );
+    QCOMPARE( palettes.conflicts.front().ID, QString("SaySomething") );
+    QCOMPARE( palettes.models.at("SaySomething").type, NodeType::ACTION );
+
+    const QString cache_file = directory.filePath( "palettes.cache" );
+    QVERIFY( PaletteImport::writeCache( cache_file, palettes ) );
+    ImportedPalettes cached;
+    QVERIFY( PaletteImport::readCache( cache_file, &cached ) );
+    QVERIFY( PaletteImport::upToDate( cached ) );
+    QCOMPARE( cached.models, palettes.models );
+
+    // an edited file is imported again
+    writeFile( "second.xml",
+        "<root><TreeNodesModel>"
+        "<Condition ID=\"IsWindowOpen\"/>"
+        "</TreeNodesModel></root>" );
+    QVERIFY( !PaletteImport::upToDate( cached ) );
+    const ImportedPalettes restored = PaletteImport::restore( cache_file );
+    QCOMPARE( restored.models.size(), size_t(3) );
+    QVERIFY( restored.models.count("IsWindowOpen") );
+    QVERIFY( restored.conflicts.empty() );
+}
+
+void EditorTest::sceneMinimap()
+{
+    QString file_xml = readFile(":/show_all.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+    auto container = main_win->currentTabInfo();
+    auto scene = container->scene();
+
+    SceneMinimap minimap;
+    minimap.resize( 300, 200 );
+    minimap.show();
+    minimap.setView( container->view() );
+    QCOMPARE( minimap.renderedNodes(), scene->nodes().size() );
+
+    // cached: drawn again only once the scene changed
+    AbsBehaviorTree abs_tree = getAbstractTree();
+    auto branch_root = abs_tree.findFirstNode( "DoSequenceStar" );
+    QVERIFY( branch_root );
+    const size_t branch_size = container->getSubtreeNodesRecursively( *branch_root->graphic_node ).size();
+    container->deleteSubTreeRecursively( *branch_root->graphic_node );
+    QCOMPARE( minimap.renderedNodes(), scene->nodes().size() + branch_size );
+    minimap.refresh();
+    QCOMPARE( minimap.renderedNodes(), scene->nodes().size() );
+
+    // a click centers the view on that point of the scene
+    const QPoint center( 150, 100 );
+    QTest::mouseClick( &minimap, Qt::LeftButton, Qt::NoModifier, center );
+    auto view = container->view();
+    const QPointF view_center = view->mapToScene( view->viewport()->rect().center() );
+    const QPointF expected = minimap.mapToScene( center );
+    QVERIFY( std::abs( view_center.x() - expected.x() ) < 5 );
+    QVERIFY( std::abs( view_center.y() - expected.y() ) < 5 );
+}
+
+void EditorTest::sharedModelDatabase()
+{
+    const ModelDatabase::Ptr database = ModelDatabase::builtin();
+    QCOMPARE( ModelDatabase::builtin().get(), database.get() );
+    QCOMPARE( database->models().size(), BuiltinNodeModels().size() );
+
+    // the creators of the database make the nodes of their model
+    QtNodes::DataModelRegistry registry;
+    database->registerModels( registry );
+    for (const auto& it: BuiltinNodeModels())
+    {
+        QVERIFY( registry.isRegistered( it.first ) );
+    }
+    auto sequence = registry.create( "Sequence" );
+    QVERIFY( sequence );
+    QCOMPARE( sequence->name(), QString("Sequence") );
+
+    // the models of the project of a window don't reach the other windows
+    main_win->on_actionClear_triggered();
+    QVERIFY( main_win->loadFromXML( readFile(":/show_all.xml") ) );
+    QVERIFY( main_win->registeredModels().count( "Pippo" ) );
+
+    MainWindow other_win( GraphicMode::EDITOR );
+    for (const auto& it: BuiltinNodeModels())
+    {
+        QVERIFY( other_win.registeredModels().count( it.first ) );
+    }
+    QVERIFY( other_win.registeredModels().count( "Pippo" ) == 0 );
+
+    // and the other way around
+    QVERIFY( other_win.loadFromXML( readFile(":/crossdoor_with_subtree.xml") ) );
+    QVERIFY( other_win.registeredModels().count( "IsDoorOpen" ) );
+    QVERIFY( main_win->registeredModels().count( "IsDoorOpen" ) == 0 );
+    QVERIFY( main_win->registeredModels().count( "Pippo" ) );
+}
+
 QTEST_MAIN(EditorTest)
 
 #include "editor_test.moc"
@@ -0,0 +1,343 @@
+#include "groot_test_base.h"
+#include "groot_generators.h"
+#include "bt_editor/sidepanel_replay.h"
+#include <QtEndian>
+#include <QBuffer>
+#include <QElapsedTimer>
+
+#ifdef ZMQ_FOUND
+#include "bt_editor/monitor_receiver.h"
+#endif
+
+// The hot paths of Groot, measured with QBENCHMARK. Not run by ctest.
+//
+// Without an option of format, the results are printed as CSV (-csv): one
+// line per benchmark and data tag, stable across the runs, to be compared
+// by the scripts that track the regressions.
+class GrootBenchmarks : public GrootTestBase
+{
+    Q_OBJECT
+
+public:
+    GrootBenchmarks(): replay_win(nullptr) {}
+    ~GrootBenchmarks() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void loadLargeProject();
+    void buildTreeFromScene();
+    void nodeReorder();
+    void sceneSaveToMemory_data();
+    void sceneSaveToMemory();
+    void sceneLoadFromMemory_data();
+    void sceneLoadFromMemory();
+    void pushUndo();
+    void changeNodesStatus();
+    void replayLoadLog();
+    void replaySeek();
+#ifdef ZMQ_FOUND
+    void monitorDecode();
+    void monitorDecodeCompact();
+    void monitorSharedMemoryRing();
+#endif
+
+private:
+    // a chain of trees of nested Sequence and Fallback, with 4 children each
+    static QString largeProjectXML();
+
+    // the ticks of a tree of 170 nodes
+    static QByteArray largeLog();
+
+    // parse it completely, in the background if it is large
+    void loadLogAndWait(SidepanelReplay* sidepanel, const QByteArray& log, size_t transitions_count);
+
+    QtNodes::FlowScene* largeScene();
+
+    MainWindow* replay_win;
+};
+
+static const int TREES_COUNT = 20;
+static const int TREE_DEPTH = 5;
+static const size_t LOG_TRANSITIONS = 1000000;
+
+QString GrootBenchmarks::largeProjectXML()
+{
+    ProjectParameters parameters;
+    parameters.depth = TREE_DEPTH;
+    parameters.subtrees = TREES_COUNT - 1;
+    return GenerateProjectXML( parameters );
+}
+
+QByteArray GrootBenchmarks::largeLog()
+{
+    ProjectParameters project;
+    project.depth = 3;
+    project.subtrees = 1;
+    LogParameters parameters;
+    parameters.transitions = LOG_TRANSITIONS;
+
+    QBuffer output;
+    output.open( QIODevice::WriteOnly );
+    const QString error = GenerateLog( GenerateProjectXML( project ), parameters, output );
+    if( !error.isEmpty() )
+    {
+        qWarning() << error;
+    }
+    return output.data();
+}
+
+void GrootBenchmarks::loadLogAndWait(SidepanelReplay *sidepanel, const QByteArray &log,
+                                     size_t transitions_count)
+{
+    sidepanel->loadLog( log );
+    QElapsedTimer timer;
+    timer.start();
+    while( sidepanel->transitionsCount() < transitions_count && timer.elapsed() < 60000 )
+    {
+        QApplication::processEvents();
+    }
+}
+
+QtNodes::FlowScene *GrootBenchmarks::largeScene()
+{
+    return main_win->getTabByName("MainTree")->scene();
+}
+
+void GrootBenchmarks::initTestCase()
+{
+    main_win = new MainWindow(GraphicMode::EDITOR, nullptr);
+    main_win->resize(1200, 800);
+    main_win->show();
+    QVERIFY( main_win->loadFromXML( largeProjectXML() ) );
+
+    replay_win = new MainWindow(GraphicMode::REPLAY, nullptr);
+    replay_win->resize(1200, 800);
+    replay_win->show();
+}
+
+void GrootBenchmarks::cleanupTestCase()
+{
+    QApplication::processEvents();
+    main_win->on_actionClear_triggered();
+    main_win->close();
+    replay_win->on_actionClear_triggered();
+    replay_win->close();
+}
+
+void GrootBenchmarks::loadLargeProject()
+{
+    const QString xml = largeProjectXML();
+    QBENCHMARK {
+        QVERIFY( main_win->loadFromXML( xml ) );
+    }
+}
+
+void GrootBenchmarks::buildTreeFromScene()
+{
+    auto scene = largeScene();
+    QBENCHMARK {
+        BuildTreeFromScene( scene );
+    }
+}
+
+void GrootBenchmarks::nodeReorder()
+{
+    auto scene = largeScene();
+    QBENCHMARK {
+        AbsBehaviorTree tree = BuildTreeFromScene( scene );
+        NodeReorder( *scene, tree );
+    }
+}
+
+void GrootBenchmarks::sceneSaveToMemory_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::newRow("Json")        << int(QtNodes::FlowScene::SceneFormat::Json);
+    QTest::newRow("CompactJson") << int(QtNodes::FlowScene::SceneFormat::CompactJson);
+    QTest::newRow("Binary")      << int(QtNodes::FlowScene::SceneFormat::Binary);
+}
+
+void GrootBenchmarks::sceneSaveToMemory()
+{
+    QFETCH(int, format);
+    auto scene = largeScene();
+    QBENCHMARK {
+        scene->saveToMemory( QtNodes::FlowScene::SceneFormat(format) );
+    }
+}
+
+void GrootBenchmarks::sceneLoadFromMemory_data()
+{
+    sceneSaveToMemory_data();
+}
+
+void GrootBenchmarks::sceneLoadFromMemory()
+{
+    QFETCH(int, format);
+    auto scene = largeScene();
+    const QByteArray data = scene->saveToMemory( QtNodes::FlowScene::SceneFormat(format) );
+    QBENCHMARK {
+        scene->loadFromMemory( data );
+    }
+}
+
+void GrootBenchmarks::pushUndo()
+{
+    largeScene();
+    QBENCHMARK {
+        main_win->onPushUndo();
+    }
+}
+
+void GrootBenchmarks::changeNodesStatus()
+{
+    const size_t nodes_count = main_win->getTabByName("MainTree")->nodesByIndex().size();
+    std::vector<std::pair<int, NodeStatus>> running;
+    std::vector<std::pair<int, NodeStatus>> success;
+    for (size_t index = 0; index < nodes_count; index++)
+    {
+        running.push_back( { int(index), NodeStatus::RUNNING } );
+        success.push_back( { int(index), NodeStatus::SUCCESS } );
+    }
+    bool toggle = false;
+    QBENCHMARK {
+        main_win->onChangeNodesStatus( "MainTree", toggle ? running : success );
+        toggle = !toggle;
+    }
+}
+
+void GrootBenchmarks::replayLoadLog()
+{
+    auto sidepanel = replay_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel, "Can't get pointer to SidepanelReplay" );
+
+    const QByteArray log = largeLog();
+    QBENCHMARK {
+        loadLogAndWait( sidepanel, log, LOG_TRANSITIONS );
+    }
+    QCOMPARE( sidepanel->transitionsCount(), LOG_TRANSITIONS );
+}
+
+void GrootBenchmarks::replaySeek()
+{
+    auto sidepanel = replay_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel, "Can't get pointer to SidepanelReplay" );
+    QVERIFY( sidepanel->transitionsCount() > 0 );
+
+    // far jumps, in both directions
+    const int rows = int( sidepanel->transitionsCount() );
+    int step = 0;
+    QBENCHMARK {
+        sidepanel->seekTransition( int( (qint64(step) * 7919) % rows ) );
+        step++;
+    }
+}
+
+#ifdef ZMQ_FOUND
+void GrootBenchmarks::monitorDecode()
+{
+    // the status of 200 nodes, then 1000 transitions
+    const int nodes_count = 200;
+    const int transitions_count = 1000;
+    QByteArray message( 8 + nodes_count * 3 + transitions_count * 12, 0 );
+    uchar* data = reinterpret_cast<uchar*>( message.data() );
+    qToLittleEndian<quint32>( nodes_count * 3, data );
+    for (int node = 0; node < nodes_count; node++)
+    {
+        qToLittleEndian<quint16>( quint16(node), data + 4 + node * 3 );
+    }
+    uchar* transitions = data + 4 + nodes_count * 3;
+    qToLittleEndian<quint32>( transitions_count, transitions );
+    for (int t = 0; t < transitions_count; t++)
+    {
+        uchar* record = transitions + 4 + t * 12;
+        qToLittleEndian<quint32>( quint32(t / 100), record );
+        qToLittleEndian<quint32>( quint32(t % 100) * 1000, record + 4 );
+        qToLittleEndian<quint16>( quint16(t % nodes_count), record + 8 );
+        record[10] = uchar(NodeStatus::IDLE);
+        record[11] = uchar(NodeStatus::RUNNING);
+    }
+
+    MonitorReceiver::Batch batch;
+    QBENCHMARK {
+        QVERIFY( MonitorReceiver::decode( message.constData(), size_t(message.size()), batch ) );
+    }
+    QCOMPARE( int(batch.transitions.size()), transitions_count );
+}
+
+void GrootBenchmarks::monitorDecodeCompact()
+{
+    // the same message of monitorDecode, as a keyframe of the compact protocol
+    const int nodes_count = 200;
+    const int transitions_count = 1000;
+    std::vector<std::pair<uint16_t, NodeStatus>> nodes_status;
+    for (int node = 0; node < nodes_count; node++)
+    {
+        nodes_status.push_back( { uint16_t(node), NodeStatus::IDLE } );
+    }
+    std::vector<MonitorReceiver::Transition> transitions;
+    for (int t = 0; t < transitions_count; t++)
+    {
+        MonitorReceiver::Transition transition;
+        transition.timestamp = double(t / 100) + double(t % 100) * 0.001;
+        transition.uid = uint16_t(t % nodes_count);
+        transition.prev_status = NodeStatus::IDLE;
+        transition.status = NodeStatus::RUNNING;
+        transitions.push_back( transition );
+    }
+    const std::string message = MonitorReceiver::encodeCompact( 1, true, nodes_status, transitions );
+
+    MonitorReceiver::CompactState state;
+    MonitorReceiver::Batch batch;
+    QBENCHMARK {
+        QVERIFY( MonitorReceiver::decodeCompact( message.data(), message.size(), state, batch ) );
+    }
+    QCOMPARE( int(batch.transitions.size()), transitions_count );
+    QCOMPARE( int(batch.nodes_status.size()), nodes_count );
+}
+
+void GrootBenchmarks::monitorSharedMemoryRing()
+{
+    // a message of 1000 transitions written by the publisher and read by Groot
+    const std::vector<char> message( 8 + 200 * 3 + 4 + 1000 * 12, 'x' );
+    const std::string segment = "/groot_benchmark_" + std::to_string( QCoreApplication::applicationPid() );
+
+    SharedMemoryRing publisher;
+    QVERIFY( publisher.create( segment ).empty() );
+    SharedMemoryRing reader;
+    QVERIFY( reader.open( segment ).empty() );
+
+    std::vector<char> received;
+    size_t overruns = 0;
+    QBENCHMARK {
+        QVERIFY( publisher.write( message.data(), message.size() ) );
+        QVERIFY( reader.read( received, overruns ) );
+    }
+    QCOMPARE( received.size(), message.size() );
+    QCOMPARE( int(overruns), 0 );
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QStringList arguments = app.arguments();
+    const QStringList formats = { "-txt", "-csv", "-xml", "-lightxml", "-xunitxml", "-teamcity", "-tap" };
+    bool format_found = false;
+    for (const auto& argument: arguments)
+    {
+        format_found |= formats.contains( argument ) || argument.startsWith( "-o" );
+    }
+    if( !format_found )
+    {
+        arguments << "-csv";
+    }
+
+    GrootBenchmarks benchmarks;
+    return QTest::qExec( &benchmarks, arguments );
+}
+
+#include "groot_benchmarks.moc"
@@ -0,0 +1,157 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <iostream>
+
+#include "groot_generators.h"
+
+// groot_generator project [options] --output project.xml
+// groot_generator log --project project.xml [options] --output log.fbl
+
+static bool ReadCount(const QCommandLineParser& parser, const QCommandLineOption& option,
+                      qulonglong& value)
+{
+    if( !parser.isSet(option) )
+    {
+        return true;
+    }
+    bool ok = false;
+    value = parser.value(option).toULongLong( &ok );
+    if( !ok )
+    {
+        std::cerr << "wrong value passed to --" << option.names().front().toStdString()
+                  << ": " << parser.value(option).toStdString() << std::endl;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("groot_generator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Synthetic projects and logs for the benchmarks of Groot");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "One of these commands: [project,log]", "command");
+
+    QCommandLineOption output_option(QStringList() << "o" << "output", "The file to write", "file");
+    parser.addOption(output_option);
+    QCommandLineOption seed_option(QStringList() << "seed", "The seed of the random numbers", "seed");
+    parser.addOption(seed_option);
+
+    QCommandLineOption depth_option(QStringList() << "depth",
+                                    "project: levels of control nodes of each tree", "depth");
+    parser.addOption(depth_option);
+    QCommandLineOption fanout_option(QStringList() << "fanout",
+                                     "project: children of each control node", "fanout");
+    parser.addOption(fanout_option);
+    QCommandLineOption subtrees_option(QStringList() << "subtrees",
+                                       "project: trees besides the main one", "subtrees");
+    parser.addOption(subtrees_option);
+    QCommandLineOption ports_option(QStringList() << "ports",
+                                    "project: input ports of each action", "ports");
+    parser.addOption(ports_option);
+    QCommandLineOption models_option(QStringList() << "models",
+                                     "project: custom actions", "models");
+    parser.addOption(models_option);
+
+    QCommandLineOption project_option(QStringList() << "project",
+                                      "log: the project whose main tree is ticked", "file");
+    parser.addOption(project_option);
+    QCommandLineOption transitions_option(QStringList() << "transitions",
+                                          "log: the number of transitions", "count");
+    parser.addOption(transitions_option);
+
+    parser.process( app );
+
+    const QStringList positional = parser.positionalArguments();
+    const QString command = positional.isEmpty() ? QString() : positional.front();
+    if( command != "project" && command != "log" )
+    {
+        std::cerr << "wrong command. Use one of these: project / log" << std::endl;
+        return 1;
+    }
+    if( !parser.isSet(output_option) )
+    {
+        std::cerr << "no file passed to --output" << std::endl;
+        return 1;
+    }
+
+    qulonglong seed = 42;
+    if( !ReadCount( parser, seed_option, seed ) )
+    {
+        return 1;
+    }
+
+    QFile output( parser.value(output_option) );
+    if( !output.open(QIODevice::WriteOnly) )
+    {
+        std::cerr << "can not write " << output.fileName().toStdString() << ": "
+                  << output.errorString().toStdString() << std::endl;
+        return 1;
+    }
+
+    if( command == "project" )
+    {
+        ProjectParameters parameters;
+        qulonglong depth = qulonglong(parameters.depth);
+        qulonglong fanout = qulonglong(parameters.fanout);
+        qulonglong subtrees = qulonglong(parameters.subtrees);
+        qulonglong ports = qulonglong(parameters.ports);
+        qulonglong models = qulonglong(parameters.models);
+        if( !ReadCount( parser, depth_option, depth ) ||
+            !ReadCount( parser, fanout_option, fanout ) ||
+            !ReadCount( parser, subtrees_option, subtrees ) ||
+            !ReadCount( parser, ports_option, ports ) ||
+            !ReadCount( parser, models_option, models ) )
+        {
+            return 1;
+        }
+        if( fanout == 0 || models == 0 )
+        {
+            std::cerr << "--fanout and --models must be positive" << std::endl;
+            return 1;
+        }
+        parameters.depth = int(depth);
+        parameters.fanout = int(fanout);
+        parameters.subtrees = int(subtrees);
+        parameters.ports = int(ports);
+        parameters.models = int(models);
+        parameters.seed = unsigned(seed);
+
+        const QByteArray xml = GenerateProjectXML( parameters ).toUtf8();
+        if( output.write( xml ) != xml.size() )
+        {
+            std::cerr << "can not write " << output.fileName().toStdString() << ": "
+                      << output.errorString().toStdString() << std::endl;
+            return 1;
+        }
+        std::cout << ProjectNodesCount( parameters ) << " nodes" << std::endl;
+        return 0;
+    }
+
+    QFile project( parser.value(project_option) );
+    if( !parser.isSet(project_option) || !project.open(QIODevice::ReadOnly) )
+    {
+        std::cerr << "can not read the project passed to --project" << std::endl;
+        return 1;
+    }
+    LogParameters parameters;
+    qulonglong transitions = qulonglong(parameters.transitions);
+    if( !ReadCount( parser, transitions_option, transitions ) )
+    {
+        return 1;
+    }
+    parameters.transitions = size_t(transitions);
+    parameters.seed = unsigned(seed);
+
+    const QString error = GenerateLog( QString::fromUtf8( project.readAll() ), parameters, output );
+    if( !error.isEmpty() )
+    {
+        std::cerr << "error: " << error.toStdString() << std::endl;
+        return 1;
+    }
+    std::cout << parameters.transitions << " transitions" << std::endl;
+    return 0;
+}
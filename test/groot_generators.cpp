@@ -0,0 +1,351 @@
+#include "groot_generators.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <QXmlStreamWriter>
+#include <QtEndian>
+#include "bt_editor/XML_utilities.hpp"
+#include "bt_editor/replay_log_format.h"
+#include "bt_editor/utils.h"
+
+namespace {
+
+class Random
+{
+public:
+    explicit Random(unsigned seed): _engine(seed) {}
+
+    // in [0, count)
+    int index(int count) { return int( _engine() % std::uint32_t(count) ); }
+
+    // in [0, 1)
+    double real() { return double( _engine() ) / 4294967296.0; }
+
+    // in [min, max)
+    int64_t between(int64_t min, int64_t max) { return min + int64_t( real() * double(max - min) ); }
+
+private:
+    std::mt19937 _engine;
+};
+
+QString TreeName(int tree)
+{
+    return tree == 0 ? QString("MainTree") : QString("SubTree_%1").arg( tree );
+}
+
+QString ActionID(int model)
+{
+    return QString("Action_%1").arg( model );
+}
+
+class TickSimulator
+{
+public:
+    TickSimulator(const LogParameters& parameters, QIODevice& output):
+        _parameters(parameters),
+        _output(output),
+        _random(parameters.seed),
+        _status( 65536, BT::NodeStatus::IDLE ),
+        _time_usec( int64_t(1600000000) * 1000000 ),
+        _count(0),
+        _write_error(false)
+    {}
+
+    // Returns false if the output could not be written
+    bool run(const BT::TreeNode* root)
+    {
+        const int64_t period_usec = int64_t( _parameters.tick_period * 1000000 );
+        while( !done() )
+        {
+            const int64_t tick_start = _time_usec;
+            tick( root );
+            _time_usec = std::max( _time_usec, tick_start + period_usec );
+        }
+        flush();
+        return !_write_error;
+    }
+
+private:
+    bool done() const { return _count >= _parameters.transitions || _write_error; }
+
+    void transition(const BT::TreeNode* node, BT::NodeStatus status)
+    {
+        if( done() )
+        {
+            return;
+        }
+        BT::NodeStatus& current = _status[ node->UID() ];
+        ReplayLogFormat::appendRecord( _buffer, _time_usec, node->UID(),
+                                       uint8_t(current), uint8_t(status) );
+        current = status;
+        _count++;
+        if( _buffer.size() >= (1 << 20) )
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if( !_buffer.isEmpty() && _output.write( _buffer ) != _buffer.size() )
+        {
+            _write_error = true;
+        }
+        _buffer.clear();
+    }
+
+    // the children first, as BT::TreeNode::halt()
+    void halt(const BT::TreeNode* node)
+    {
+        if( _status[ node->UID() ] == BT::NodeStatus::IDLE )
+        {
+            return;
+        }
+        if( auto control = dynamic_cast<const BT::ControlNode*>(node) )
+        {
+            for (const BT::TreeNode* child: control->children())
+            {
+                halt( child );
+            }
+        }
+        else if( auto decorator = dynamic_cast<const BT::DecoratorNode*>(node) )
+        {
+            halt( decorator->child() );
+        }
+        transition( node, BT::NodeStatus::IDLE );
+    }
+
+    BT::NodeStatus tick(const BT::TreeNode* node)
+    {
+        if( auto control = dynamic_cast<const BT::ControlNode*>(node) )
+        {
+            transition( node, BT::NodeStatus::RUNNING );
+            // a Fallback stops at the first success, the others at the first failure
+            const bool fallback = node->registrationName().find("Fallback") != std::string::npos;
+            const BT::NodeStatus stop = fallback ? BT::NodeStatus::SUCCESS : BT::NodeStatus::FAILURE;
+            BT::NodeStatus result = fallback ? BT::NodeStatus::FAILURE : BT::NodeStatus::SUCCESS;
+            for (const BT::TreeNode* child: control->children())
+            {
+                if( done() )
+                {
+                    return result;
+                }
+                if( tick( child ) == stop )
+                {
+                    result = stop;
+                    break;
+                }
+            }
+            for (const BT::TreeNode* child: control->children())
+            {
+                halt( child );
+            }
+            transition( node, result );
+            return result;
+        }
+        if( auto decorator = dynamic_cast<const BT::DecoratorNode*>(node) )
+        {
+            transition( node, BT::NodeStatus::RUNNING );
+            const BT::NodeStatus result = tick( decorator->child() );
+            halt( decorator->child() );
+            transition( node, result );
+            return result;
+        }
+
+        // an action may run for a while, a condition answers at once
+        if( node->type() == BT::NodeType::ACTION && _random.real() < _parameters.running_rate )
+        {
+            transition( node, BT::NodeStatus::RUNNING );
+            _time_usec += _random.between( 1000, 50000 );
+        }
+        else{
+            _time_usec += _random.between( 50, 2000 );
+        }
+        const BT::NodeStatus result = _random.real() < _parameters.failure_rate ?
+                    BT::NodeStatus::FAILURE : BT::NodeStatus::SUCCESS;
+        transition( node, result );
+        return result;
+    }
+
+    const LogParameters& _parameters;
+    QIODevice& _output;
+    Random _random;
+    // by UID
+    std::vector<BT::NodeStatus> _status;
+    int64_t _time_usec;
+    size_t _count;
+    QByteArray _buffer;
+    bool _write_error;
+};
+
+}
+
+int ProjectNodesCount(const ProjectParameters &parameters)
+{
+    int tree_nodes = 0;
+    int level_nodes = 1;
+    for (int level = 0; level <= parameters.depth; level++)
+    {
+        tree_nodes += level_nodes;
+        level_nodes *= parameters.fanout;
+    }
+    return tree_nodes * ( parameters.subtrees + 1 );
+}
+
+QString GenerateProjectXML(const ProjectParameters &parameters)
+{
+    Random random( parameters.seed );
+
+    QString xml;
+    QXmlStreamWriter stream( &xml );
+    stream.setAutoFormatting( true );
+    stream.setAutoFormattingIndent( 4 );
+    stream.writeStartDocument();
+    stream.writeStartElement( "root" );
+    stream.writeAttribute( "main_tree_to_execute", TreeName(0) );
+
+    int counter = 0;
+    for (int tree = 0; tree <= parameters.subtrees; tree++)
+    {
+        // the first action is replaced by the next tree
+        bool subtree_written = ( tree == parameters.subtrees );
+
+        std::function<void(int)> writeNode = [&](int level)
+        {
+            if( level < parameters.depth )
+            {
+                stream.writeStartElement( random.index(2) ? "Fallback" : "Sequence" );
+                stream.writeAttribute( "name", QString("control_%1").arg( counter++ ) );
+                for (int i = 0; i < parameters.fanout; i++)
+                {
+                    writeNode( level + 1 );
+                }
+                stream.writeEndElement();
+            }
+            else if( !subtree_written )
+            {
+                subtree_written = true;
+                stream.writeStartElement( "SubTree" );
+                stream.writeAttribute( "ID", TreeName( tree + 1 ) );
+                stream.writeEndElement();
+            }
+            else{
+                stream.writeStartElement( "Action" );
+                stream.writeAttribute( "ID", ActionID( random.index( parameters.models ) ) );
+                stream.writeAttribute( "name", QString("action_%1").arg( counter++ ) );
+                for (int port = 0; port < parameters.ports; port++)
+                {
+                    // about half of the values come from the blackboard
+                    const int value = random.index( 100 );
+                    stream.writeAttribute( QString("in_%1").arg( port ),
+                                           value < 50 ? QString("{key_%1}").arg( value ) :
+                                                        QString::number( value ) );
+                }
+                stream.writeEndElement();
+            }
+        };
+
+        stream.writeStartElement( "BehaviorTree" );
+        stream.writeAttribute( "ID", TreeName( tree ) );
+        writeNode( 0 );
+        stream.writeEndElement();
+    }
+
+    stream.writeStartElement( "TreeNodesModel" );
+    for (int model = 0; model < parameters.models; model++)
+    {
+        stream.writeStartElement( "Action" );
+        stream.writeAttribute( "ID", ActionID( model ) );
+        for (int port = 0; port < parameters.ports; port++)
+        {
+            stream.writeStartElement( "input_port" );
+            stream.writeAttribute( "name", QString("in_%1").arg( port ) );
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+    }
+    for (int tree = 1; tree <= parameters.subtrees; tree++)
+    {
+        stream.writeStartElement( "SubTree" );
+        stream.writeAttribute( "ID", TreeName( tree ) );
+        stream.writeEndElement();
+    }
+    stream.writeEndElement();
+
+    stream.writeEndElement();
+    stream.writeEndDocument();
+    return xml;
+}
+
+QString GenerateLog(const QString &project_xml, const LogParameters &parameters, QIODevice &output)
+{
+    XMLProject project;
+    try{
+        project = ReadProjectFromXML( project_xml );
+    }
+    catch( std::runtime_error& err)
+    {
+        return err.what();
+    }
+
+    // the custom nodes do nothing: their results are simulated
+    BT::BehaviorTreeFactory factory;
+    for (const auto& it: project.custom_models)
+    {
+        const NodeModel& model = it.second;
+        if( BuiltinNodeModels().count( it.first ) != 0 || model.type == NodeType::SUBTREE )
+        {
+            continue;
+        }
+        BT::PortsList ports;
+        for (const auto& port_it: model.ports)
+        {
+            const std::string name = port_it.first.toStdString();
+            switch( port_it.second.direction )
+            {
+            case PortDirection::INPUT:  ports.insert( BT::InputPort<std::string>( name ) ); break;
+            case PortDirection::OUTPUT: ports.insert( BT::OutputPort<std::string>( name ) ); break;
+            default:                    ports.insert( BT::BidirectionalPort<std::string>( name ) ); break;
+            }
+        }
+        auto tick = [](BT::TreeNode&) { return BT::NodeStatus::SUCCESS; };
+        if( model.type == NodeType::ACTION )
+        {
+            factory.registerSimpleAction( it.first.toStdString(), tick, ports );
+        }
+        else if( model.type == NodeType::CONDITION )
+        {
+            factory.registerSimpleCondition( it.first.toStdString(), tick, ports );
+        }
+        else{
+            return QString("The custom node %1 can not be simulated").arg( it.first );
+        }
+    }
+
+    try{
+        BT::Tree tree = factory.createTreeFromText( project_xml.toStdString() );
+
+        flatbuffers::FlatBufferBuilder builder( 1024 );
+        BT::CreateFlatbuffersBehaviorTree( builder, tree );
+
+        QByteArray header( 4, 0 );
+        qToLittleEndian<quint32>( builder.GetSize(), reinterpret_cast<uchar*>( header.data() ) );
+        header.append( reinterpret_cast<const char*>( builder.GetBufferPointer() ), int( builder.GetSize() ) );
+        if( output.write( header ) != header.size() )
+        {
+            return output.errorString();
+        }
+
+        TickSimulator simulator( parameters, output );
+        if( !simulator.run( tree.rootNode() ) )
+        {
+            return output.errorString();
+        }
+    }
+    catch( std::exception& err)
+    {
+        return err.what();
+    }
+    return QString();
+}
@@ -0,0 +1,53 @@
+#ifndef GROOT_GENERATORS_H
+#define GROOT_GENERATORS_H
+
+#include <QIODevice>
+#include <QString>
+
+// Synthetic projects and logs, to measure Groot on large inputs. With the
+// same parameters and seed the output is the same, on every platform: the
+// random numbers come from std::mt19937 only, without the distributions of
+// the standard library.
+
+struct ProjectParameters
+{
+    // levels of control nodes above the actions of a tree
+    int depth = 5;
+    // children of each control node
+    int fanout = 4;
+    // trees besides the main one. Each tree includes the next one with a
+    // SubTree, in place of its first action
+    int subtrees = 0;
+    // input ports of each custom action
+    int ports = 2;
+    // custom actions declared in <TreeNodesModel>
+    int models = 8;
+    unsigned seed = 42;
+};
+
+// the nodes of the trees, with the SubTrees expanded
+int ProjectNodesCount(const ProjectParameters& parameters);
+
+QString GenerateProjectXML(const ProjectParameters& parameters);
+
+struct LogParameters
+{
+    size_t transitions = 1000000;
+    // a tick starts at least this long after the previous one, seconds
+    double tick_period = 0.01;
+    // the probability of an action to fail, and to be RUNNING before its result
+    double failure_rate = 0.2;
+    double running_rate = 0.3;
+    unsigned seed = 42;
+};
+
+// A .fbl log of the main tree of the project, as written by BT::FileLogger:
+// the header of BT::CreateFlatbuffersBehaviorTree, then the transitions of
+// simulated ticks of the tree. A Sequence stops at the first failure and a
+// Fallback at the first success; at the end of each tick the nodes return to
+// IDLE, so Groot sees a restart of the tree at the next one.
+// Returns the error, or an empty string.
+QString GenerateLog(const QString& project_xml, const LogParameters& parameters,
+                    QIODevice& output);
+
+#endif // GROOT_GENERATORS_H
@@ -0,0 +1,465 @@
+#include "groot_test_base.h"
+#include "groot_generators.h"
+#include "bt_editor/sidepanel_replay.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <nodes/PaintProfiler>
+#include <nodes/Connection>
+#include <algorithm>
+#include <map>
+
+// Budgets of the hot paths, run by ctest like the functional tests.
+//
+// The budgets are generous, to pass on slow CI machines and debug builds:
+// they catch the obvious regressions, not the small ones (see
+// groot_benchmarks for those). Every path is measured on two sizes too:
+// an O(n^2) algorithm, or a full rebuild where a single node changes,
+// grows much faster than the size of the input.
+//
+// The environment variable GROOT_PERF_BUDGET_SCALE multiplies the absolute
+// budgets, e.g. 4 on a machine known to be slow.
+class PerformanceTest : public GrootTestBase
+{
+    Q_OBJECT
+
+public:
+    PerformanceTest(): replay_win(nullptr) {}
+    ~PerformanceTest() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void loadLargeProject();
+    void buildTreeScaling();
+    void dependentOrderScaling();
+    void undoLatency();
+    void statusUpdatePerNode();
+    void replaySeekLatency();
+    void copyPasteBranch();
+    void backgroundPerFrame();
+
+private:
+    // a single tree of nested Sequence and Fallback, 4 children each
+    static QString projectXML(int depth, int subtrees = 0);
+
+    static QByteArray generateLog(size_t transitions);
+
+    // median of the runs, in milliseconds
+    static double medianMsecs(int runs, const std::function<void()>& callable);
+
+    static double budgetScale();
+
+    // large_msecs must grow at most as the size, with some tolerance. The
+    // times below MIN_MSECS are mostly noise, not compared
+    static bool isScalable(double small_msecs, double large_msecs, double size_ratio);
+
+    bool loadLogAndWait(SidepanelReplay* sidepanel, const QByteArray& log, size_t transitions_count);
+
+    size_t mainTreeNodesCount();
+
+    MainWindow* replay_win;
+};
+
+static const int RUNS = 5;
+static const double MIN_MSECS = 1.0;
+static const double SCALING_TOLERANCE = 2.5;
+
+// 341 and 1365 nodes
+static const int SMALL_DEPTH = 4;
+static const int LARGE_DEPTH = 5;
+
+QString PerformanceTest::projectXML(int depth, int subtrees)
+{
+    ProjectParameters parameters;
+    parameters.depth = depth;
+    parameters.subtrees = subtrees;
+    return GenerateProjectXML( parameters );
+}
+
+QByteArray PerformanceTest::generateLog(size_t transitions)
+{
+    ProjectParameters project;
+    project.depth = 3;
+    project.subtrees = 1;
+    LogParameters parameters;
+    parameters.transitions = transitions;
+
+    QBuffer output;
+    output.open( QIODevice::WriteOnly );
+    const QString error = GenerateLog( GenerateProjectXML( project ), parameters, output );
+    if( !error.isEmpty() )
+    {
+        qWarning() << error;
+    }
+    return output.data();
+}
+
+double PerformanceTest::medianMsecs(int runs, const std::function<void()> &callable)
+{
+    std::vector<double> msecs;
+    QElapsedTimer timer;
+    for (int i = 0; i < runs; i++)
+    {
+        timer.start();
+        callable();
+        msecs.push_back( double( timer.nsecsElapsed() ) * 1e-6 );
+    }
+    std::sort( msecs.begin(), msecs.end() );
+    return msecs[ msecs.size() / 2 ];
+}
+
+double PerformanceTest::budgetScale()
+{
+    bool ok = false;
+    const double scale = qgetenv( "GROOT_PERF_BUDGET_SCALE" ).toDouble( &ok );
+    return ( ok && scale > 0 ) ? scale : 1.0;
+}
+
+bool PerformanceTest::isScalable(double small_msecs, double large_msecs, double size_ratio)
+{
+    qDebug() << "  small:" << small_msecs << "ms, large:" << large_msecs
+             << "ms, size ratio:" << size_ratio;
+    return large_msecs <= std::max( small_msecs, MIN_MSECS ) * size_ratio * SCALING_TOLERANCE;
+}
+
+bool PerformanceTest::loadLogAndWait(SidepanelReplay *sidepanel, const QByteArray &log,
+                                     size_t transitions_count)
+{
+    sidepanel->loadLog( log );
+    QElapsedTimer timer;
+    timer.start();
+    while( sidepanel->transitionsCount() < transitions_count && timer.elapsed() < 60000 )
+    {
+        QApplication::processEvents();
+    }
+    return sidepanel->transitionsCount() == transitions_count;
+}
+
+size_t PerformanceTest::mainTreeNodesCount()
+{
+    return main_win->getTabByName("MainTree")->nodesByIndex().size();
+}
+
+void PerformanceTest::initTestCase()
+{
+    main_win = new MainWindow(GraphicMode::EDITOR, nullptr);
+    main_win->resize(1200, 800);
+    main_win->show();
+
+    replay_win = new MainWindow(GraphicMode::REPLAY, nullptr);
+    replay_win->resize(1200, 800);
+    replay_win->show();
+}
+
+void PerformanceTest::cleanupTestCase()
+{
+    QApplication::processEvents();
+    main_win->on_actionClear_triggered();
+    main_win->close();
+    replay_win->on_actionClear_triggered();
+    replay_win->close();
+}
+
+void PerformanceTest::loadLargeProject()
+{
+    // 20 trees of 1365 nodes
+    const QString large_xml = projectXML( LARGE_DEPTH, 19 );
+    const double large_msecs = medianMsecs( 3, [&]()
+    {
+        QVERIFY( main_win->loadFromXML( large_xml ) );
+    });
+    QVERIFY2( large_msecs < 10000 * budgetScale(), "loadFromXML of 20 trees is too slow" );
+
+    const QString small_xml = projectXML( SMALL_DEPTH );
+    const double small_msecs = medianMsecs( RUNS, [&]()
+    {
+        QVERIFY( main_win->loadFromXML( small_xml ) );
+    });
+    const size_t small_nodes = mainTreeNodesCount();
+
+    const QString medium_xml = projectXML( LARGE_DEPTH );
+    const double medium_msecs = medianMsecs( RUNS, [&]()
+    {
+        QVERIFY( main_win->loadFromXML( medium_xml ) );
+    });
+    const size_t medium_nodes = mainTreeNodesCount();
+
+    QVERIFY2( isScalable( small_msecs, medium_msecs, double(medium_nodes) / double(small_nodes) ),
+              "loadFromXML grows faster than the number of nodes" );
+}
+
+void PerformanceTest::buildTreeScaling()
+{
+    QVERIFY( main_win->loadFromXML( projectXML( SMALL_DEPTH ) ) );
+    const size_t small_nodes = mainTreeNodesCount();
+    auto small_scene = main_win->getTabByName("MainTree")->scene();
+    const double small_msecs = medianMsecs( RUNS, [&]()
+    {
+        BuildTreeFromScene( small_scene );
+    });
+
+    QVERIFY( main_win->loadFromXML( projectXML( LARGE_DEPTH ) ) );
+    const size_t large_nodes = mainTreeNodesCount();
+    auto large_scene = main_win->getTabByName("MainTree")->scene();
+    const double large_msecs = medianMsecs( RUNS, [&]()
+    {
+        BuildTreeFromScene( large_scene );
+    });
+
+    QVERIFY2( large_msecs < 1000 * budgetScale(), "BuildTreeFromScene is too slow" );
+    QVERIFY2( isScalable( small_msecs, large_msecs, double(large_nodes) / double(small_nodes) ),
+              "BuildTreeFromScene grows faster than the number of nodes" );
+}
+
+void PerformanceTest::dependentOrderScaling()
+{
+    auto measure = [this](int depth, double* msecs, size_t* nodes_count)
+    {
+        QVERIFY( main_win->loadFromXML( projectXML( depth ) ) );
+        auto scene = main_win->getTabByName("MainTree")->scene();
+        *nodes_count = scene->nodes().size();
+        QtNodes::Node* root = scene->nodes().begin()->second.get();
+
+        // computed again at each run: the ports of a node changed
+        *msecs = medianMsecs( RUNS, [&]()
+        {
+            scene->invalidateNodePorts( *root );
+            scene->dependentOrder();
+        });
+
+        // every node after its parent
+        const auto& order = scene->dependentOrder();
+        QCOMPARE( order.size(), *nodes_count );
+        std::map<const QtNodes::Node*, size_t> position;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            position[ order[i] ] = i;
+        }
+        for (const QtNodes::Node* node: order)
+        {
+            for (const auto& connections: node->nodeState().getEntries( QtNodes::PortType::In ))
+            {
+                for (const auto& it: connections)
+                {
+                    QVERIFY( position.at( it.second->getNode( QtNodes::PortType::Out ) ) < position.at( node ) );
+                }
+            }
+        }
+    };
+
+    double small_msecs, large_msecs;
+    size_t small_nodes, large_nodes;
+    measure( SMALL_DEPTH, &small_msecs, &small_nodes );
+    measure( LARGE_DEPTH, &large_msecs, &large_nodes );
+    if( QTest::currentTestFailed() )
+    {
+        return;
+    }
+    QVERIFY2( large_msecs < 100 * budgetScale(), "dependentOrder is too slow" );
+    QVERIFY2( isScalable( small_msecs, large_msecs, double(large_nodes) / double(small_nodes) ),
+              "dependentOrder grows faster than the number of nodes" );
+}
+
+void PerformanceTest::undoLatency()
+{
+    // the time to push, undo and redo the move of a single node
+    auto measure = [this](int depth, double* push_msecs, double* undo_msecs, double* redo_msecs)
+    {
+        QVERIFY( main_win->loadFromXML( projectXML( depth ) ) );
+        auto node = main_win->getTabByName("MainTree")->nodesByIndex().at(1);
+        auto& graphic_object = node->nodeGraphicsObject();
+
+        *push_msecs = medianMsecs( RUNS, [&]()
+        {
+            graphic_object.setPos( graphic_object.pos() + QPointF( 10, 0 ) );
+            main_win->onPushUndo();
+        });
+        *undo_msecs = medianMsecs( RUNS, [&]()
+        {
+            main_win->onUndoInvoked();
+        });
+        *redo_msecs = medianMsecs( RUNS, [&]()
+        {
+            main_win->onRedoInvoked();
+        });
+    };
+
+    double small_push, small_undo, small_redo;
+    measure( SMALL_DEPTH, &small_push, &small_undo, &small_redo );
+    const size_t small_nodes = mainTreeNodesCount();
+    double large_push, large_undo, large_redo;
+    measure( LARGE_DEPTH, &large_push, &large_undo, &large_redo );
+    if( QTest::currentTestFailed() )
+    {
+        return;
+    }
+    const double size_ratio = double( mainTreeNodesCount() ) / double( small_nodes );
+
+    QVERIFY2( large_push < 500 * budgetScale(), "onPushUndo is too slow" );
+    QVERIFY2( large_undo < 500 * budgetScale(), "onUndoInvoked is too slow" );
+    QVERIFY2( large_redo < 500 * budgetScale(), "onRedoInvoked is too slow" );
+    QVERIFY2( isScalable( small_push, large_push, size_ratio ),
+              "onPushUndo grows faster than the number of nodes" );
+    // the state of the tab is taken again after a command, linear in the nodes
+    QVERIFY2( isScalable( small_undo, large_undo, size_ratio ),
+              "onUndoInvoked grows faster than the number of nodes" );
+    QVERIFY2( isScalable( small_redo, large_redo, size_ratio ),
+              "onRedoInvoked grows faster than the number of nodes" );
+}
+
+void PerformanceTest::statusUpdatePerNode()
+{
+    // the cost of onChangeNodesStatus for all the nodes, and for one only
+    auto measure = [this](int depth, double* all_msecs, double* single_msecs)
+    {
+        QVERIFY( main_win->loadFromXML( projectXML( depth ) ) );
+        const size_t nodes_count = mainTreeNodesCount();
+        std::vector<std::pair<int, NodeStatus>> running;
+        std::vector<std::pair<int, NodeStatus>> success;
+        for (size_t index = 0; index < nodes_count; index++)
+        {
+            running.push_back( { int(index), NodeStatus::RUNNING } );
+            success.push_back( { int(index), NodeStatus::SUCCESS } );
+        }
+        bool toggle = false;
+        *all_msecs = medianMsecs( RUNS, [&]()
+        {
+            main_win->onChangeNodesStatus( "MainTree", toggle ? running : success );
+            toggle = !toggle;
+        });
+
+        const int last = int(nodes_count) - 1;
+        *single_msecs = medianMsecs( RUNS, [&]()
+        {
+            main_win->onChangeNodesStatus( "MainTree",
+                { { last, toggle ? NodeStatus::RUNNING : NodeStatus::FAILURE } } );
+            toggle = !toggle;
+        });
+        QApplication::processEvents();
+    };
+
+    double small_all, small_single;
+    measure( SMALL_DEPTH, &small_all, &small_single );
+    const size_t small_nodes = mainTreeNodesCount();
+    double large_all, large_single;
+    measure( LARGE_DEPTH, &large_all, &large_single );
+    if( QTest::currentTestFailed() )
+    {
+        return;
+    }
+    const size_t large_nodes = mainTreeNodesCount();
+
+    const double usecs_per_node = large_all * 1000.0 / double(large_nodes);
+    qDebug() << "  status update:" << usecs_per_node << "us per node";
+    QVERIFY2( usecs_per_node < 100 * budgetScale(), "onChangeNodesStatus is too slow per node" );
+    QVERIFY2( isScalable( small_all, large_all, double(large_nodes) / double(small_nodes) ),
+              "onChangeNodesStatus grows faster than the number of nodes" );
+    QVERIFY2( isScalable( small_single, large_single, 1.0 ),
+              "onChangeNodesStatus of a single node depends on the size of the tree" );
+}
+
+void PerformanceTest::replaySeekLatency()
+{
+    auto sidepanel = replay_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel, "Can't get pointer to SidepanelReplay" );
+
+    // far jumps, in both directions: the seek starts from the nearest checkpoint
+    auto measure = [&](size_t transitions) -> double
+    {
+        if( !loadLogAndWait( sidepanel, generateLog( transitions ), transitions ) )
+        {
+            return -1;
+        }
+        const int rows = int( sidepanel->transitionsCount() );
+        int step = 0;
+        return medianMsecs( 20, [&]()
+        {
+            sidepanel->seekTransition( int( (qint64(step) * 7919 * 13) % rows ) );
+            step++;
+        });
+    };
+
+    const size_t SMALL_LOG = 50000;
+    const size_t LARGE_LOG = 400000;
+    const double small_msecs = measure( SMALL_LOG );
+    QVERIFY2( small_msecs >= 0, "The small log was not loaded" );
+    const double large_msecs = measure( LARGE_LOG );
+    QVERIFY2( large_msecs >= 0, "The large log was not loaded" );
+
+    QVERIFY2( large_msecs < 100 * budgetScale(), "a seek in the replay is too slow" );
+    QVERIFY2( isScalable( small_msecs, large_msecs, 1.0 ),
+              "a seek in the replay depends on the length of the log" );
+}
+
+void PerformanceTest::copyPasteBranch()
+{
+    // the whole tree below Root, through the format of the clipboard
+    auto measure = [this](int depth, double* copy_msecs, double* paste_msecs, size_t* nodes_count)
+    {
+        QVERIFY( main_win->loadFromXML( projectXML( depth ) ) );
+        *nodes_count = mainTreeNodesCount();
+        auto container = main_win->getTabByName("MainTree");
+        QtNodes::Node* branch_root = container->nodesByIndex().at(1);
+
+        ClipboardNodes copy;
+        *copy_msecs = medianMsecs( RUNS, [&]()
+        {
+            QVERIFY( DecodeClipboardNodes(
+                         EncodeClipboardNodes( container->copyNodes( { branch_root }, true ) ), &copy ) );
+        });
+        QCOMPARE( copy.forest.nodesCount(), *nodes_count - 1 );
+
+        *paste_msecs = medianMsecs( RUNS, [&]()
+        {
+            container->pasteNodes( copy, QPointF( 0, 10000 ) );
+        });
+        QApplication::processEvents();
+    };
+
+    double small_copy, small_paste, large_copy, large_paste;
+    size_t small_nodes, large_nodes;
+    measure( SMALL_DEPTH, &small_copy, &small_paste, &small_nodes );
+    measure( LARGE_DEPTH, &large_copy, &large_paste, &large_nodes );
+    if( QTest::currentTestFailed() )
+    {
+        return;
+    }
+    const double size_ratio = double(large_nodes) / double(small_nodes);
+
+    QVERIFY2( large_copy < 500 * budgetScale(), "copyNodes is too slow" );
+    QVERIFY2( large_paste < 5000 * budgetScale(), "pasteNodes is too slow" );
+    QVERIFY2( isScalable( small_copy, large_copy, size_ratio ),
+              "copyNodes grows faster than the number of nodes" );
+    QVERIFY2( isScalable( small_paste, large_paste, size_ratio ),
+              "pasteNodes grows faster than the number of nodes" );
+}
+
+void PerformanceTest::backgroundPerFrame()
+{
+    // the background of the frames of a pan: each step moves the scene rect
+    QVERIFY( main_win->loadFromXML( projectXML( SMALL_DEPTH ) ) );
+    auto view = main_win->getTabByName("MainTree")->view();
+    sleepAndRefresh( 100 );
+
+    const int FRAMES = 20;
+    QtNodes::PaintProfiler::setEnabled( true );
+    QtNodes::PaintProfiler::take();
+    for (int i = 0; i < FRAMES; i++)
+    {
+        view->setSceneRect( view->sceneRect().translated( 10, 5 ) );
+        view->viewport()->repaint();
+    }
+    const QtNodes::PaintProfiler::Totals totals = QtNodes::PaintProfiler::take();
+    QtNodes::PaintProfiler::setEnabled( false );
+
+    const int background = QtNodes::PaintProfiler::Background;
+    QVERIFY( totals.count[background] >= FRAMES );
+    const double msecs_per_frame = double( totals.nsecs[background] ) * 1e-6 / FRAMES;
+    qDebug() << "  background:" << msecs_per_frame << "ms per frame";
+    QVERIFY2( msecs_per_frame < 2.0 * budgetScale(), "the background of a frame is too slow" );
+}
+
+QTEST_MAIN(PerformanceTest)
+
+#include "performance_test.moc"
@@ -1,6 +1,26 @@
 #include "groot_test_base.h"
 #include "bt_editor/sidepanel_replay.h"
+#include "bt_editor/replay_frame_export.h"
+#include "bt_editor/node_timings.h"
+#include "bt_editor/replay_timeline.h"
+#include "bt_editor/replay_statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <QAction>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QPushButton>
+#include <QtEndian>
+#include <QTemporaryDir>
+
+#ifdef ZMQ_FOUND
+#include "bt_editor/shared_memory_ring.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#endif
 
 class ReplyTest : public GrootTestBase
 {
@@ -14,6 +34,19 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void basicLoad();
+    void exportFrames();
+    void parseTime();
+    void nodeTimings();
+    void timelineOutliers();
+    void runningStatistics();
+    void seekTimeAndFailures();
+    void compressedLog();
+    void reloadFailed();
+    void readOnlyScene();
+#ifdef ZMQ_FOUND
+    void sharedMemoryRing();
+    void sharedMemoryRingConcurrent();
+#endif
 };
 
 
@@ -43,6 +76,509 @@ void ReplyTest::basicLoad()
     QCOMPARE( sidepanel_replay->transitionsCount(), size_t(27) );
 }
 
+void ReplyTest::exportFrames()
+{
+    auto sidepanel_replay = main_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel_replay, "Can't get pointer to SidepanelReplay" );
+    QVERIFY( sidepanel_replay->transitionsCount() > 0 );
+
+    const ReplayTransitions& transitions = sidepanel_replay->transitions();
+    const double duration = transitions.back().timestamp - transitions.timestamp(0);
+
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    FrameExportOptions options;
+    options.output = directory.path() + "/frames";
+    // a frame step exact in binary, at most the first second
+    options.fps = 16;
+    options.end = std::min( duration, 1.0 );
+    options.threads = 2;
+
+    int last_done = 0;
+    const QString error = main_win->exportReplayFrames( options, [&last_done](int done, int)
+    {
+        last_done = done;
+        return true;
+    });
+    QVERIFY2( error.isEmpty(), error.toStdString().c_str() );
+
+    const int expected = int( std::floor( options.end * options.fps ) ) + 1;
+    const QStringList frames = QDir( options.output ).entryList( QStringList() << "frame_*.png",
+                                                                 QDir::Files, QDir::Name );
+    QCOMPARE( frames.size(), expected );
+    QCOMPARE( last_done, expected );
+
+    const QImage first( QDir( options.output ).filePath( frames.front() ) );
+    QVERIFY( !first.isNull() );
+    QVERIFY( first.width() > 0 && first.height() > 0 );
+}
+
+void ReplyTest::parseTime()
+{
+    const double first = 1760446500.0;
+    const double current = first + 10.0;
+    double timestamp = 0;
+
+    QVERIFY( SidepanelReplay::parseTime( "12.5", first, current, &timestamp ) );
+    QCOMPARE( timestamp, first + 12.5 );
+    QVERIFY( SidepanelReplay::parseTime( "1:02.5 s", first, current, &timestamp ) );
+    QCOMPARE( timestamp, first + 62.5 );
+    QVERIFY( SidepanelReplay::parseTime( "+3", first, current, &timestamp ) );
+    QCOMPARE( timestamp, current + 3.0 );
+    QVERIFY( SidepanelReplay::parseTime( "-0.5", first, current, &timestamp ) );
+    QCOMPARE( timestamp, current - 0.5 );
+    QVERIFY( SidepanelReplay::parseTime( "1760446502.25", first, current, &timestamp ) );
+    QCOMPARE( timestamp, 1760446502.25 );
+
+    const QDateTime date_time( QDate(2026, 10, 14), QTime(13, 45, 2, 250) );
+    QVERIFY( SidepanelReplay::parseTime( "2026-10-14 13:45:02.250", first, current, &timestamp ) );
+    QCOMPARE( timestamp, date_time.toMSecsSinceEpoch() * 0.001 );
+
+    const double day_start = date_time.toMSecsSinceEpoch() * 0.001 - 60;
+    QVERIFY( SidepanelReplay::parseTime( "@13:45:02.250", day_start, day_start, &timestamp ) );
+    QCOMPARE( timestamp, date_time.toMSecsSinceEpoch() * 0.001 );
+
+    QVERIFY( !SidepanelReplay::parseTime( "", first, current, &timestamp ) );
+    QVERIFY( !SidepanelReplay::parseTime( "soon", first, current, &timestamp ) );
+    QVERIFY( !SidepanelReplay::parseTime( "1:2:3:4", first, current, &timestamp ) );
+    QVERIFY( !SidepanelReplay::parseTime( "@25:00", first, current, &timestamp ) );
+}
+
+void ReplyTest::nodeTimings()
+{
+    NodeTimings timings;
+    timings.reset( 3 );
+    QCOMPARE( NodeTimings::toText( timings.values(1) ), QString() );
+
+    // node 1 ticks every 0.1 s, RUNNING for 20 ms, one failure out of four
+    const double start = 1760446500.0;
+    for (int i = 0; i < 4; i++)
+    {
+        const double t = start + 0.1 * i;
+        timings.add( 1, NodeStatus::IDLE, NodeStatus::RUNNING, t );
+        timings.add( 1, NodeStatus::RUNNING, (i == 3) ? NodeStatus::FAILURE : NodeStatus::SUCCESS, t + 0.02 );
+        timings.add( 1, NodeStatus::SUCCESS, NodeStatus::IDLE, t + 0.05 );
+    }
+    QCOMPARE( timings.takeChanged(), std::vector<int>( {1} ) );
+    QVERIFY( timings.takeChanged().empty() );
+
+    NodeTimings::Values values = timings.values( 1 );
+    QCOMPARE( values.completions, 4 );
+    QVERIFY( std::abs( values.running_ms - 20.0 ) < 0.01 );
+    QVERIFY( std::abs( values.ticks_per_second - 10.0 ) < 0.01 );
+    QCOMPARE( values.failure_rate, 0.25 );
+    QCOMPARE( NodeTimings::toText( values ), QString("20.0 ms | 10.0/s | 25% fail") );
+
+    // the clock goes on without transitions: the badge changes when the
+    // oldest completions leave the window, until none is left
+    timings.setTime( start + 0.01 + NodeTimings::WINDOW_SECONDS );
+    QVERIFY( timings.takeChanged().empty() );
+    timings.setTime( start + 0.3 + NodeTimings::WINDOW_SECONDS );
+    QCOMPARE( timings.takeChanged(), std::vector<int>( {1} ) );
+    QCOMPARE( timings.values( 1 ).completions, 1 );
+    timings.setTime( start + 1 + NodeTimings::WINDOW_SECONDS );
+    QCOMPARE( timings.takeChanged(), std::vector<int>( {1} ) );
+    QCOMPARE( timings.values( 1 ).completions, 0 );
+    QVERIFY( timings.takeChanged().empty() );
+
+    // a transition of another node, later than the window: the old
+    // completions don't count anymore
+    timings.add( 2, NodeStatus::IDLE, NodeStatus::SUCCESS, start + 1 + NodeTimings::WINDOW_SECONDS );
+    values = timings.values( 1 );
+    QCOMPARE( values.completions, 0 );
+    QCOMPARE( values.ticks_per_second, 0.0 );
+    QVERIFY( std::abs( values.running_ms - 20.0 ) < 0.01 );
+
+    // the ring keeps the last HISTORY completions only
+    for (int i = 0; i < NodeTimings::HISTORY + 10; i++)
+    {
+        timings.add( 0, NodeStatus::IDLE, NodeStatus::FAILURE, start + 10 + 0.01 * i );
+    }
+    values = timings.values( 0 );
+    QCOMPARE( values.completions, int(NodeTimings::HISTORY) );
+    QCOMPARE( values.failure_rate, 1.0 );
+
+    // out of range: ignored
+    timings.add( 3, NodeStatus::IDLE, NodeStatus::SUCCESS, start + 11 );
+    QCOMPARE( timings.values( 3 ).completions, 0 );
+}
+
+void ReplyTest::timelineOutliers()
+{
+    ReplayTimelineData timeline;
+    timeline.addTransition( 0.0, false );
+    timeline.addTransition( 1.05, true );
+    // before the first transition: in the first bucket
+    timeline.addTransition( -3.0, false );
+    QCOMPARE( timeline.skippedTransitions(), size_t(0) );
+
+    // a corrupted timestamp, decades later, allocates nothing
+    timeline.addTransition( 1e9, false );
+    timeline.addTransition( std::numeric_limits<double>::infinity(), false );
+    QCOMPARE( timeline.skippedTransitions(), size_t(2) );
+    timeline.updatePyramid();
+    QVERIFY( std::abs( timeline.duration() - 1.1 ) < 1e-9 );
+
+    // a pause of the robot is kept
+    timeline.addTransition( 3600.0, false );
+    QCOMPARE( timeline.skippedTransitions(), size_t(2) );
+    QVERIFY( timeline.duration() > 3600.0 );
+
+    timeline.clear();
+    QCOMPARE( timeline.skippedTransitions(), size_t(0) );
+}
+
+void ReplyTest::runningStatistics()
+{
+    NodeTimingAccumulator accumulator;
+    accumulator.reset( 2 );
+
+    // node 0 is RUNNING for 1, 2, ... 100 ms, then succeeds
+    double t = 1760446500.0;
+    for (int i = 1; i <= 100; i++)
+    {
+        accumulator.add( 0, NodeStatus::IDLE, NodeStatus::RUNNING, t );
+        t += 0.001 * i;
+        accumulator.add( 0, NodeStatus::RUNNING, NodeStatus::SUCCESS, t );
+        accumulator.add( 0, NodeStatus::SUCCESS, NodeStatus::IDLE, t );
+    }
+    // node 1 only once
+    accumulator.add( 1, NodeStatus::IDLE, NodeStatus::RUNNING, t );
+    accumulator.add( 1, NodeStatus::RUNNING, NodeStatus::FAILURE, t + 0.25 );
+
+    const std::vector<NodeTimingStatistics> statistics = accumulator.statistics();
+    QCOMPARE( statistics.size(), size_t(2) );
+
+    const NodeTimingStatistics& node = statistics[0];
+    QCOMPARE( node.executions, 100 );
+    QCOMPARE( node.running_count, 100 );
+    // exact
+    QVERIFY( std::abs( node.running_min - 0.001 ) < 1e-6 );
+    QVERIFY( std::abs( node.running_max - 0.100 ) < 1e-6 );
+    QVERIFY( std::abs( node.running_mean - 0.0505 ) < 1e-6 );
+    // from the histogram
+    auto close = [](double value, double expected)
+    {
+        return std::abs( value - expected ) <= 0.022 * expected + 1e-6;
+    };
+    QVERIFY( close( node.running_p50, 0.050 ) );
+    QVERIFY( close( node.running_p90, 0.090 ) );
+    QVERIFY( close( node.running_p99, 0.099 ) );
+
+    // a single duration is exact
+    QCOMPARE( statistics[1].running_count, 1 );
+    QCOMPARE( statistics[1].failure, 1 );
+    QVERIFY( std::abs( statistics[1].running_p50 - 0.25 ) < 1e-6 );
+    QVERIFY( std::abs( statistics[1].running_p99 - 0.25 ) < 1e-6 );
+}
+
+void ReplyTest::seekTimeAndFailures()
+{
+    auto sidepanel_replay = main_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel_replay, "Can't get pointer to SidepanelReplay" );
+    const ReplayTransitions& transitions = sidepanel_replay->transitions();
+    QVERIFY( !transitions.empty() );
+
+    // the failures found by the index are those of a linear search
+    std::vector<int> failures;
+    for (size_t row = 0; row < transitions.size(); row++)
+    {
+        if( transitions.status(row) == NodeStatus::FAILURE )
+        {
+            failures.push_back( int(row) );
+        }
+    }
+    int row = -1;
+    for (int failure: failures)
+    {
+        row = sidepanel_replay->adjacentFailure( row, true, false );
+        QCOMPARE( row, failure );
+    }
+    QCOMPARE( sidepanel_replay->adjacentFailure( row, true, false ), -1 );
+    if( !failures.empty() )
+    {
+        // the previous failure of the same node is before it, or there is none
+        const int last = failures.back();
+        const int previous = sidepanel_replay->adjacentFailure( last, false, true );
+        QVERIFY( previous < last );
+        if( previous >= 0 )
+        {
+            QCOMPARE( transitions.index(previous), transitions.index(last) );
+        }
+    }
+
+    // the last transition at or before the time
+    auto expectedRow = [&transitions](double t)
+    {
+        const size_t upper = transitions.upperBound( t );
+        return upper == 0 ? 0 : int(upper) - 1;
+    };
+    const size_t middle = transitions.size() / 2;
+    sidepanel_replay->seekTime( transitions.timestamp(middle) );
+    QCOMPARE( sidepanel_replay->currentRow(), expectedRow( transitions.timestamp(middle) ) );
+    QVERIFY( sidepanel_replay->currentRow() >= int(middle) );
+
+    // before the first transition: the first one
+    sidepanel_replay->seekTime( transitions.timestamp(0) - 1.0 );
+    QCOMPARE( sidepanel_replay->currentRow(), 0 );
+
+    // between two transitions: the earlier one
+    size_t before_gap = 0;
+    while( before_gap + 1 < transitions.size() &&
+           transitions.timestamp(before_gap + 1) <= transitions.timestamp(before_gap) )
+    {
+        before_gap++;
+    }
+    QVERIFY( before_gap + 1 < transitions.size() );
+    const double between = 0.5 * ( transitions.timestamp(before_gap) + transitions.timestamp(before_gap + 1) );
+    sidepanel_replay->seekTime( between );
+    QCOMPARE( sidepanel_replay->currentRow(), expectedRow( between ) );
+    QCOMPARE( sidepanel_replay->currentRow(), int(before_gap) );
+
+    // after the last transition: the last one
+    sidepanel_replay->seekTime( transitions.back().timestamp + 1.0 );
+    QCOMPARE( sidepanel_replay->currentRow(), int(transitions.size()) - 1 );
+
+    sidepanel_replay->seekTime( transitions.timestamp(middle) );
+    QVERIFY( sidepanel_replay->bookmarks().empty() );
+    sidepanel_replay->toggleBookmark( int(middle) );
+    QCOMPARE( sidepanel_replay->bookmarks().size(), size_t(1) );
+    sidepanel_replay->toggleBookmark( int(middle) );
+    QVERIFY( sidepanel_replay->bookmarks().empty() );
+}
+
+void ReplyTest::compressedLog()
+{
+    auto sidepanel_replay = main_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel_replay, "Can't get pointer to SidepanelReplay" );
+
+    const QByteArray log = readFile("://crossdoor_trace.fbl");
+    sidepanel_replay->loadLog( log );
+    const ReplayTransitions& transitions = sidepanel_replay->transitions();
+    std::vector<double> timestamps;
+    std::vector<int> indices;
+    std::vector<NodeStatus> statuses;
+    for (size_t row = 0; row < transitions.size(); row++)
+    {
+        timestamps.push_back( transitions.timestamp(row) );
+        indices.push_back( transitions.index(row) );
+        statuses.push_back( transitions.status(row) );
+    }
+    QCOMPARE( timestamps.size(), size_t(27) );
+
+    // several blocks, the last one partial
+    const QByteArray compressed = ReplayLogFormat::compressLog( log.constData(), size_t(log.size()), 5 );
+    QVERIFY( !compressed.isEmpty() );
+    const size_t transitions_offset = 4 + qFromLittleEndian<quint32>( reinterpret_cast<const uchar*>(log.constData()) );
+    QVERIFY( ReplayLogFormat::isCompressed( compressed.constData(), size_t(compressed.size()), transitions_offset ) );
+    std::vector<ReplayLogFormat::BlockInfo> blocks;
+    QVERIFY( ReplayLogFormat::readBlockIndex( compressed.constData(), size_t(compressed.size()),
+                                              transitions_offset, blocks ) );
+    QCOMPARE( blocks.size(), size_t(6) );
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+        QCOMPARE( blocks[b].records_count, uint32_t( std::min<size_t>( 5, timestamps.size() - b * 5 ) ) );
+        QCOMPARE( blocks[b].first_timestamp, timestamps[b * 5] );
+        const QByteArray records = ReplayLogFormat::decompressBlock( compressed.constData(),
+                                                                     size_t(compressed.size()), blocks[b] );
+        QCOMPARE( records, log.mid( int(transitions_offset + b * 5 * ReplayLogFormat::RECORD_SIZE),
+                                    int(blocks[b].records_count * ReplayLogFormat::RECORD_SIZE) ) );
+    }
+
+    // a block that doesn't match its index is rejected
+    ReplayLogFormat::BlockInfo wrong_block = blocks[1];
+    wrong_block.first_timestamp += 1.0;
+    QVERIFY( ReplayLogFormat::decompressBlock( compressed.constData(), size_t(compressed.size()),
+                                               wrong_block ).isEmpty() );
+    std::vector<ReplayLogFormat::BlockInfo> truncated_blocks;
+    QVERIFY( !ReplayLogFormat::readBlockIndex( compressed.constData(), transitions_offset + 20,
+                                               transitions_offset, truncated_blocks ) );
+
+    // the compressed log is replayed as the original one
+    sidepanel_replay->loadLog( compressed );
+    QCOMPARE( transitions.size(), timestamps.size() );
+    for (size_t row = 0; row < transitions.size(); row++)
+    {
+        QCOMPARE( transitions.timestamp(row), timestamps[row] );
+        QCOMPARE( transitions.index(row), indices[row] );
+        QCOMPARE( transitions.status(row), statuses[row] );
+    }
+
+    // and written by the export of a range
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    const QString filename = directory.path() + "/range.fblz";
+    QVERIFY( sidepanel_replay->exportRange( filename, 0, int(transitions.size()) - 1, false ) );
+    QFile file( filename );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    const QByteArray exported = file.readAll();
+    QVERIFY( ReplayLogFormat::isCompressed( exported.constData(), size_t(exported.size()), transitions_offset ) );
+    sidepanel_replay->loadLog( exported );
+    QCOMPARE( transitions.size(), timestamps.size() );
+    QCOMPARE( transitions.timestamp( transitions.size() - 1 ), timestamps.back() );
+
+    sidepanel_replay->loadLog( log );
+}
+
+void ReplyTest::reloadFailed()
+{
+    auto sidepanel_replay = main_win->findChild<SidepanelReplay*>("SidepanelReplay");
+    QVERIFY2( sidepanel_replay, "Can't get pointer to SidepanelReplay" );
+    auto export_button = sidepanel_replay->findChild<QPushButton*>("pushButtonExport");
+    QVERIFY( export_button );
+
+    const QByteArray log = readFile("://crossdoor_trace.fbl");
+    sidepanel_replay->loadLog( log );
+    QVERIFY( sidepanel_replay->transitionsCount() > 0 );
+    QVERIFY( export_button->isEnabled() );
+
+    // the size of the header is larger than the file
+    const QByteArray truncated = log.left( 8 );
+    testMessageBox( 500, TEST_LOCATION(), [&]()
+    {
+        sidepanel_replay->loadLog( truncated );
+    });
+
+    // nothing is left of the previous log, it can't be exported
+    QCOMPARE( sidepanel_replay->transitionsCount(), size_t(0) );
+    QVERIFY( !export_button->isEnabled() );
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    QVERIFY( !sidepanel_replay->exportRange( directory.path() + "/range.fbl", 0, 0, false ) );
+
+    sidepanel_replay->loadLog( log );
+    QVERIFY( export_button->isEnabled() );
+}
+
+void ReplyTest::readOnlyScene()
+{
+    auto container = main_win->currentTabInfo();
+    QVERIFY2( container, "Can't get the current tab" );
+    auto scene = container->scene();
+    QVERIFY( scene->readOnly() );
+    QVERIFY( !scene->nodes().empty() );
+
+    // the nodes are not changed, they refuse the selection
+    for (const auto& it: scene->nodes())
+    {
+        auto& graphic_object = it.second->nodeGraphicsObject();
+        graphic_object.setSelected( true );
+        QVERIFY( !graphic_object.isSelected() );
+    }
+    QVERIFY( scene->selectedItems().empty() );
+
+    // the same scene becomes editable
+    container->lockEditing( false );
+    QVERIFY( !scene->readOnly() );
+    container->lockEditing( true );
+    QVERIFY( scene->readOnly() );
+}
+
+#ifdef ZMQ_FOUND
+void ReplyTest::sharedMemoryRing()
+{
+    const std::string segment = "/groot_test_ring_" + std::to_string( QCoreApplication::applicationPid() );
+    SharedMemoryRing publisher;
+    QVERIFY( publisher.create( segment, 1024, 1024 ).empty() );
+    SharedMemoryRing reader;
+    QVERIFY( reader.open( segment ).empty() );
+
+    std::vector<char> message;
+    size_t overruns = 0;
+    QVERIFY( !reader.read( message, overruns ) );
+
+    // the messages are read in order, across the end of the ring
+    for (int i = 0; i < 100; i++)
+    {
+        const std::vector<char> written( 10 + i % 50, char(i) );
+        QVERIFY( publisher.write( written.data(), written.size() ) );
+        QVERIFY( reader.read( message, overruns ) );
+        QVERIFY( message == written );
+    }
+    QVERIFY( !reader.read( message, overruns ) );
+    QCOMPARE( int(overruns), 0 );
+
+    // larger than the ring
+    const std::vector<char> too_large( 1024, 'x' );
+    QVERIFY( !publisher.write( too_large.data(), too_large.size() ) );
+
+    // the messages not read are overwritten: they are skipped and counted,
+    // then the reader continues with the next ones
+    const std::vector<char> half( 400, 'a' );
+    for (int i = 0; i < 3; i++)
+    {
+        QVERIFY( publisher.write( half.data(), half.size() ) );
+    }
+    QVERIFY( !reader.read( message, overruns ) );
+    QCOMPARE( int(overruns), 1 );
+    QVERIFY( !reader.read( message, overruns ) );
+
+    const std::vector<char> next( 20, 'b' );
+    QVERIFY( publisher.write( next.data(), next.size() ) );
+    QVERIFY( reader.read( message, overruns ) );
+    QVERIFY( message == next );
+    QCOMPARE( int(overruns), 1 );
+}
+
+void ReplyTest::sharedMemoryRingConcurrent()
+{
+    // a publisher much faster than the reader, in a ring of a few messages:
+    // every message accepted must be one that was written, never a mix
+    const std::string segment = "/groot_test_ring_concurrent_" + std::to_string( QCoreApplication::applicationPid() );
+    SharedMemoryRing publisher;
+    QVERIFY( publisher.create( segment, 1024, 1024 ).empty() );
+    SharedMemoryRing reader;
+    QVERIFY( reader.open( segment ).empty() );
+
+    // the index of the message, then bytes given by the index
+    const int messages_count = 200000;
+    std::atomic<bool> done( false );
+    std::thread writer( [&]()
+    {
+        for (int i = 0; i < messages_count; i++)
+        {
+            std::vector<char> written( sizeof(i) + 100 + i % 150, char(i) );
+            std::memcpy( written.data(), &i, sizeof(i) );
+            publisher.write( written.data(), written.size() );
+        }
+        done = true;
+    });
+
+    std::vector<char> message;
+    size_t overruns = 0;
+    int received = 0;
+    bool consistent = true;
+    while( true )
+    {
+        const bool finished = done;
+        if( !reader.read( message, overruns ) )
+        {
+            if( finished )
+            {
+                break;
+            }
+            continue;
+        }
+        received++;
+        int index = -1;
+        if( message.size() < sizeof(index) )
+        {
+            consistent = false;
+            continue;
+        }
+        std::memcpy( &index, message.data(), sizeof(index) );
+        consistent &= ( index >= 0 && index < messages_count &&
+                        message.size() == sizeof(index) + 100 + index % 150 );
+        consistent &= std::all_of( message.begin() + sizeof(index), message.end(),
+                                   [index](char byte) { return byte == char(index); } );
+    }
+    writer.join();
+
+    QVERIFY( consistent );
+    QVERIFY( received + int(overruns) > 0 );
+}
+#endif
+
 QTEST_MAIN(ReplyTest)
 
 #include "replay_test.moc"